@@ -0,0 +1,526 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/chrome_trace_exporter.h"
+
+#include "analysis/kernel_event.h"
+#include "analysis/report_utils.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::Timestamp;
+
+// The beginning and the end of the JSON document.
+const char kDocumentBegin[] = "{\"traceEvents\":[\n";
+const char kDocumentEnd[] = "\n]}\n";
+
+// The I/O operations of an event.
+struct IoOperation {
+  // The operation of the event.
+  const char* operation;
+  // The name of the slice of the I/O.
+  const char* name;
+};
+
+// The FileIO events starting an I/O. They all complete with an OperationEnd
+// event.
+const IoOperation kFileIoStarts[] = {
+  { "Create", "Create" },
+  { "Cleanup", "Cleanup" },
+  { "Close", "Close" },
+  { "Flush", "Flush" },
+  { "Read", "Read" },
+  { "Write", "Write" },
+  { "SetInfo", "SetInfo" },
+  { "Delete", "Delete" },
+  { "Rename", "Rename" },
+  { "QueryInfo", "QueryInfo" },
+  { "FSControl", "FSControl" },
+  { "DirEnum", "DirEnum" },
+  { "DirNotify", "DirNotify" },
+};
+
+const IoOperation kDiskIoStarts[] = {
+  { "ReadInit", "Read" },
+  { "WriteInit", "Write" },
+  { "FlushInit", "Flush" },
+};
+
+const IoOperation kDiskIoEnds[] = {
+  { "Read", "Read" },
+  { "Write", "Write" },
+  { "FlushBuffers", "Flush" },
+};
+
+// The category of the slices of each I/O category.
+const char* const kIoCategoryNames[] = { "FileIO", "DiskIO" };
+
+COMPILE_ASSERT(sizeof(kIoCategoryNames) / sizeof(kIoCategoryNames[0]) ==
+                   IO_CATEGORY_COUNT,
+               io_category_names_must_cover_io_categories);
+
+// @returns the name of the I/O slice of |operation|, or NULL if |operation|
+//     is not in |operations|.
+template <size_t N>
+const char* FindIoName(const IoOperation (&operations)[N],
+                       const std::string& operation) {
+  for (size_t i = 0; i < N; ++i) {
+    if (operation == operations[i].operation)
+      return operations[i].name;
+  }
+  return NULL;
+}
+
+// Appends the decimal representation of a value.
+void AppendDecimal(uint64 value, std::string* out) {
+  DCHECK(out != NULL);
+
+  char buffer[20];
+  char* end = buffer + sizeof(buffer);
+  char* begin = end;
+  do {
+    *--begin = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  out->append(begin, end);
+}
+
+// Appends a duration in microseconds, with 3 decimals when the timestamps are
+// finer than a microsecond.
+void AppendMicroseconds(uint64 value,
+                        uint64 timestamps_per_microsecond,
+                        std::string* out) {
+  DCHECK(out != NULL);
+
+  AppendDecimal(value / timestamps_per_microsecond, out);
+  if (timestamps_per_microsecond == 1)
+    return;
+
+  uint64 nanoseconds =
+      (value % timestamps_per_microsecond) * 1000 / timestamps_per_microsecond;
+  char decimals[4] = {
+    '.',
+    static_cast<char>('0' + nanoseconds / 100),
+    static_cast<char>('0' + nanoseconds / 10 % 10),
+    static_cast<char>('0' + nanoseconds % 10)
+  };
+  out->append(decimals, sizeof(decimals));
+}
+
+// Appends a JSON string literal.
+void AppendJsonString(const std::string& value, std::string* out) {
+  DCHECK(out != NULL);
+
+  const char kDigits[] = "0123456789abcdef";
+  out->push_back('"');
+  for (size_t i = 0; i < value.size(); ++i) {
+    unsigned char c = static_cast<unsigned char>(value[i]);
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(static_cast<char>(c));
+    } else if (c < 0x20) {
+      char escaped[6] = { '\\', 'u', '0', '0', kDigits[c >> 4],
+                          kDigits[c & 0xF] };
+      out->append(escaped, sizeof(escaped));
+    } else {
+      out->push_back(static_cast<char>(c));
+    }
+  }
+  out->push_back('"');
+}
+
+void ReceiveThread(const KernelEvent& event, ChromeTraceExporter* exporter) {
+  DCHECK(exporter != NULL);
+  const StructValue* content = event.content();
+
+  if (event.operation() == "CSwitch") {
+    uint32 new_thread_id = 0;
+    uint32 old_thread_id = 0;
+    if (content->GetFieldAsUInteger("NewThreadId", &new_thread_id) &&
+        content->GetFieldAsUInteger("OldThreadId", &old_thread_id)) {
+      exporter->OnContextSwitch(event.timestamp(), event.processor_number(),
+                                old_thread_id, new_thread_id);
+    }
+    return;
+  }
+
+  if (event.operation() != "Start" && event.operation() != "DCStart")
+    return;
+
+  uint32 process_id = 0;
+  uint32 thread_id = 0;
+  if (content->GetFieldAsUInteger("ProcessId", &process_id) &&
+      content->GetFieldAsUInteger("TThreadId", &thread_id)) {
+    exporter->OnThread(process_id, thread_id);
+  }
+}
+
+void ReceiveProcess(const KernelEvent& event, ChromeTraceExporter* exporter) {
+  DCHECK(exporter != NULL);
+  if (event.operation() != "Start" && event.operation() != "DCStart")
+    return;
+
+  uint32 process_id = 0;
+  std::string name;
+  if (event.content()->GetFieldAsUInteger("ProcessId", &process_id) &&
+      event.content()->GetFieldAsString("ImageFileName", &name)) {
+    exporter->OnProcessName(process_id, name);
+  }
+}
+
+void ReceiveFileIO(const KernelEvent& event, ChromeTraceExporter* exporter) {
+  DCHECK(exporter != NULL);
+  const StructValue* content = event.content();
+  uint32 process_id = static_cast<uint32>(event.process_id());
+  uint32 thread_id = static_cast<uint32>(event.thread_id());
+
+  uint64 irp = 0;
+  if (!content->GetFieldAsULong("IrpPtr", &irp))
+    return;
+
+  if (event.operation() == "OperationEnd") {
+    uint64 bytes = 0;
+    content->GetFieldAsULong("ExtraInfo", &bytes);
+    exporter->OnIoEnd(event.timestamp(), IO_FILE, "OperationEnd", process_id,
+                      thread_id, irp, bytes);
+    return;
+  }
+
+  const char* name = FindIoName(kFileIoStarts, event.operation());
+  if (name == NULL)
+    return;
+
+  // The issuing thread is a pointer-sized field in the version 2 events.
+  uint64 issuing_thread_id = 0;
+  if (content->GetFieldAsULong("TTID", &issuing_thread_id))
+    thread_id = static_cast<uint32>(issuing_thread_id);
+  exporter->OnIoStart(event.timestamp(), IO_FILE, name, process_id, thread_id,
+                      irp);
+}
+
+void ReceiveDiskIO(const KernelEvent& event, ChromeTraceExporter* exporter) {
+  DCHECK(exporter != NULL);
+  const StructValue* content = event.content();
+  uint32 process_id = static_cast<uint32>(event.process_id());
+  uint32 thread_id = static_cast<uint32>(event.thread_id());
+
+  uint64 irp = 0;
+  if (!content->GetFieldAsULong("Irp", &irp))
+    return;
+  content->GetFieldAsUInteger("IssuingThreadId", &thread_id);
+
+  const char* name = FindIoName(kDiskIoStarts, event.operation());
+  if (name != NULL) {
+    exporter->OnIoStart(event.timestamp(), IO_DISK, name, process_id,
+                        thread_id, irp);
+    return;
+  }
+
+  name = FindIoName(kDiskIoEnds, event.operation());
+  if (name != NULL) {
+    uint32 bytes = 0;
+    content->GetFieldAsUInteger("TransferSize", &bytes);
+    exporter->OnIoEnd(event.timestamp(), IO_DISK, name, process_id,
+                      thread_id, irp, bytes);
+  }
+}
+
+void ReceivePerfInfo(const KernelEvent& event,
+                     ChromeTraceExporter* exporter) {
+  DCHECK(exporter != NULL);
+  if (event.operation() != "SampleProf")
+    return;
+
+  uint64 instruction_pointer = 0;
+  uint32 thread_id = 0;
+  if (event.content()->GetFieldAsULong("InstructionPointer",
+                                       &instruction_pointer) &&
+      event.content()->GetFieldAsUInteger("ThreadId", &thread_id)) {
+    exporter->OnSample(event.timestamp(), thread_id, instruction_pointer);
+  }
+}
+
+void ReceivePerf(const KernelEvent& event, ChromeTraceExporter* exporter) {
+  DCHECK(exporter != NULL);
+  if (event.operation() != "Comm")
+    return;
+
+  uint32 process_id = 0;
+  uint32 thread_id = 0;
+  std::string name;
+  if (event.content()->GetFieldAsUInteger("pid", &process_id) &&
+      event.content()->GetFieldAsUInteger("tid", &thread_id) &&
+      event.content()->GetFieldAsString("comm", &name)) {
+    exporter->OnThread(process_id, thread_id);
+    exporter->OnThreadName(process_id, thread_id, name);
+    if (process_id == thread_id)
+      exporter->OnProcessName(process_id, name);
+  }
+}
+
+}  // namespace
+
+ChromeTraceExporter::ChromeTraceExporter(uint64 timestamps_per_microsecond,
+                                         std::ostream* out)
+    : timestamps_per_microsecond_(timestamps_per_microsecond),
+      out_(out),
+      buffer_size_(kDefaultBufferSize),
+      event_count_(0),
+      last_timestamp_(0) {
+  DCHECK_GT(timestamps_per_microsecond, 0U);
+  DCHECK(out != NULL);
+
+  buffer_.reserve(buffer_size_);
+  buffer_.append(kDocumentBegin);
+}
+
+void ChromeTraceExporter::set_buffer_size(size_t size) {
+  DCHECK_GT(size, 0U);
+  buffer_size_ = size;
+  buffer_.reserve(buffer_size_);
+}
+
+void ChromeTraceExporter::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event))
+    return;
+
+  AdvanceTime(kernel_event.timestamp());
+
+  const std::string& category = kernel_event.category();
+  if (category == "Thread")
+    ReceiveThread(kernel_event, this);
+  else if (category == "FileIO")
+    ReceiveFileIO(kernel_event, this);
+  else if (category == "DiskIO")
+    ReceiveDiskIO(kernel_event, this);
+  else if (category == "PerfInfo")
+    ReceivePerfInfo(kernel_event, this);
+  else if (category == "Process")
+    ReceiveProcess(kernel_event, this);
+  else if (category == "Perf")
+    ReceivePerf(kernel_event, this);
+}
+
+void ChromeTraceExporter::OnProcessName(uint32 process_id,
+                                        const std::string& name) {
+  AppendName("process_name", process_id, 0, name);
+}
+
+void ChromeTraceExporter::OnThreadName(uint32 process_id,
+                                       uint32 thread_id,
+                                       const std::string& name) {
+  AppendName("thread_name", process_id, thread_id, name);
+}
+
+void ChromeTraceExporter::OnThread(uint32 process_id, uint32 thread_id) {
+  *thread_processes_.FindOrInsert(thread_id) = process_id;
+}
+
+void ChromeTraceExporter::OnContextSwitch(Timestamp timestamp,
+                                          uint32 processor,
+                                          uint32 old_thread_id,
+                                          uint32 new_thread_id) {
+  AdvanceTime(timestamp);
+  Running* running = running_.FindOrInsert(processor);
+
+  // The first switch of a processor only tells which thread starts running:
+  // the slice of |old_thread_id| started before the trace.
+  if (running->thread_id != 0 && running->thread_id == old_thread_id &&
+      timestamp >= running->start) {
+    BeginEvent("Running", "CSwitch", 'X',
+               GetThreadProcess(old_thread_id, 0), old_thread_id);
+    AppendTimestamp(running->start);
+    buffer_.append(",\"dur\":");
+    AppendMicroseconds(timestamp - running->start,
+                       timestamps_per_microsecond_, &buffer_);
+    buffer_.append(",\"args\":{\"cpu\":");
+    AppendDecimal(processor, &buffer_);
+    buffer_.push_back('}');
+    EndEvent();
+  }
+
+  running->thread_id = new_thread_id;
+  running->start = timestamp;
+}
+
+void ChromeTraceExporter::OnIoStart(Timestamp timestamp,
+                                    IoCategory category,
+                                    const char* name,
+                                    uint32 process_id,
+                                    uint32 thread_id,
+                                    uint64 irp) {
+  DCHECK_LT(category, IO_CATEGORY_COUNT);
+  DCHECK(name != NULL);
+  AdvanceTime(timestamp);
+
+  PendingIos& pending_ios = pending_ios_[category];
+  if (pending_ios.size() >= kMaxPendingIos &&
+      pending_ios.find(irp) == pending_ios.end()) {
+    // Without a slot, the completion will be an instant event.
+    return;
+  }
+
+  // An IRP is reused once completed: a start replaces a lost completion.
+  PendingIo& pending = pending_ios[irp];
+  pending.name = name;
+  pending.process_id = GetThreadProcess(thread_id, process_id);
+  pending.thread_id = thread_id;
+
+  BeginEvent(name, kIoCategoryNames[category], 'b', pending.process_id,
+             thread_id);
+  AppendTimestamp(timestamp);
+  buffer_.append(",\"id\":\"");
+  AppendHex(irp, &buffer_);
+  buffer_.push_back('"');
+  EndEvent();
+}
+
+void ChromeTraceExporter::OnIoEnd(Timestamp timestamp,
+                                  IoCategory category,
+                                  const char* name,
+                                  uint32 process_id,
+                                  uint32 thread_id,
+                                  uint64 irp,
+                                  uint64 bytes) {
+  DCHECK_LT(category, IO_CATEGORY_COUNT);
+  DCHECK(name != NULL);
+  AdvanceTime(timestamp);
+
+  PendingIos& pending_ios = pending_ios_[category];
+  PendingIos::iterator it = pending_ios.find(irp);
+  if (it != pending_ios.end()) {
+    BeginEvent(it->second.name, kIoCategoryNames[category], 'e',
+               it->second.process_id, it->second.thread_id);
+    pending_ios.erase(it);
+  } else {
+    BeginEvent(name, kIoCategoryNames[category], 'n',
+               GetThreadProcess(thread_id, process_id), thread_id);
+  }
+  AppendTimestamp(timestamp);
+  buffer_.append(",\"id\":\"");
+  AppendHex(irp, &buffer_);
+  buffer_.append("\",\"args\":{\"bytes\":");
+  AppendDecimal(bytes, &buffer_);
+  buffer_.push_back('}');
+  EndEvent();
+}
+
+void ChromeTraceExporter::OnSample(Timestamp timestamp,
+                                   uint32 thread_id,
+                                   uint64 instruction_pointer) {
+  AdvanceTime(timestamp);
+  BeginEvent("SampleProf", "PerfInfo", 'P',
+             GetThreadProcess(thread_id, 0), thread_id);
+  AppendTimestamp(timestamp);
+  buffer_.append(",\"args\":{\"ip\":\"");
+  AppendHex(instruction_pointer, &buffer_);
+  buffer_.append("\"}");
+  EndEvent();
+}
+
+bool ChromeTraceExporter::Finish() {
+  for (IdMap<Running>::const_iterator it = running_.begin();
+       it != running_.end(); ++it) {
+    const Running& running = it->second;
+    if (running.thread_id != 0)
+      OnContextSwitch(last_timestamp_, it->first, running.thread_id, 0);
+  }
+
+  buffer_.append(kDocumentEnd);
+  Flush();
+  out_->flush();
+  return out_->good();
+}
+
+void ChromeTraceExporter::AdvanceTime(Timestamp timestamp) {
+  if (timestamp > last_timestamp_)
+    last_timestamp_ = timestamp;
+}
+
+uint32 ChromeTraceExporter::GetThreadProcess(uint32 thread_id,
+                                             uint32 process_id) const {
+  const uint32* thread_process = thread_processes_.Find(thread_id);
+  return thread_process != NULL ? *thread_process : process_id;
+}
+
+void ChromeTraceExporter::BeginEvent(const char* name,
+                                     const char* category,
+                                     char phase,
+                                     uint32 process_id,
+                                     uint32 thread_id) {
+  DCHECK(name != NULL);
+
+  if (event_count_ != 0)
+    buffer_.append(",\n");
+  ++event_count_;
+
+  buffer_.append("{\"name\":\"");
+  buffer_.append(name);
+  if (category != NULL) {
+    buffer_.append("\",\"cat\":\"");
+    buffer_.append(category);
+  }
+  buffer_.append("\",\"ph\":\"");
+  buffer_.push_back(phase);
+  buffer_.append("\",\"pid\":");
+  AppendDecimal(process_id, &buffer_);
+  buffer_.append(",\"tid\":");
+  AppendDecimal(thread_id, &buffer_);
+}
+
+void ChromeTraceExporter::AppendTimestamp(Timestamp timestamp) {
+  buffer_.append(",\"ts\":");
+  AppendMicroseconds(timestamp, timestamps_per_microsecond_, &buffer_);
+}
+
+void ChromeTraceExporter::EndEvent() {
+  buffer_.push_back('}');
+  if (buffer_.size() >= buffer_size_)
+    Flush();
+}
+
+void ChromeTraceExporter::AppendName(const char* metadata,
+                                     uint32 process_id,
+                                     uint32 thread_id,
+                                     const std::string& name) {
+  BeginEvent(metadata, NULL, 'M', process_id, thread_id);
+  buffer_.append(",\"args\":{\"name\":");
+  AppendJsonString(name, &buffer_);
+  buffer_.push_back('}');
+  EndEvent();
+}
+
+void ChromeTraceExporter::Flush() {
+  out_->write(buffer_.data(), buffer_.size());
+  // Keeps the capacity of the buffer.
+  buffer_.clear();
+}
+
+}  // namespace analysis
@@ -0,0 +1,251 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A Chrome trace exporter converts the events of the ETW parser to the JSON
+// trace event format read by chrome://tracing and Perfetto:
+//
+//   {"traceEvents":[
+//   {"name":"Running","cat":"CSwitch","ph":"X","ts":12.500,"pid":4,...},
+//   ...
+//   ]}
+//
+// The events are mapped as follows:
+//   - Thread/CSwitch: a "Running" complete slice ("X") on the thread that
+//     leaves the processor, lasting since it was switched in.
+//   - DiskIO and FileIO: an async slice ("b" then "e") per I/O request
+//     packet (IRP). A completion without a known start is an async instant
+//     ("n").
+//   - PerfInfo/SampleProf: a sample ("P") on the sampled thread.
+//   - Process/Start and Process/DCStart: a "process_name" metadata event.
+//   - Thread/Start and Thread/DCStart: the owning process of the thread, used
+//     as the "pid" of its slices. The perf Comm events also name threads.
+//
+// The exporter streams: an event is formatted as soon as it is received into
+// a reusable buffer, written to the output stream each time it fills up. The
+// memory used does not grow with the length of the trace, only with the
+// number of processors, threads and in-flight I/Os.
+//
+// Usage example:
+//   std::ofstream out("trace.json", std::ios::binary);
+//   ChromeTraceExporter exporter(10, &out);  // 100ns ETW timestamps.
+//   parser.Parse(base::MakeObserver(&exporter, &ChromeTraceExporter::Receive));
+//   exporter.Finish();
+
+#ifndef ANALYSIS_CHROME_TRACE_EXPORTER_H_
+#define ANALYSIS_CHROME_TRACE_EXPORTER_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "analysis/id_map.h"
+#include "base/base.h"
+#include "event/event.h"
+
+namespace analysis {
+
+enum IoCategory {
+  IO_FILE,
+  IO_DISK,
+  IO_CATEGORY_COUNT
+};
+
+class ChromeTraceExporter {
+ public:
+  // The default size of the output buffer.
+  static const size_t kDefaultBufferSize = 1 << 20;
+
+  // The maximal number of in-flight I/Os per category. Bounds the memory
+  // used when the completions are missing from the trace.
+  static const size_t kMaxPendingIos = 1 << 16;
+
+  // @param timestamps_per_microsecond the number of timestamp units in a
+  //     microsecond, the unit of the JSON format.
+  // @param out the stream to write to. Must outlive the exporter.
+  ChromeTraceExporter(uint64 timestamps_per_microsecond, std::ostream* out);
+
+  // @param size the number of bytes buffered before writing to the stream.
+  void set_buffer_size(size_t size);
+
+  // Consumes an event of the ETW parser. The Thread, Process, DiskIO,
+  // FileIO and PerfInfo events are used, the other events are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Names a process.
+  // @param process_id the process.
+  // @param name the name of the process.
+  void OnProcessName(uint32 process_id, const std::string& name);
+
+  // Names a thread.
+  // @param process_id the process owning |thread_id|.
+  // @param thread_id the thread.
+  // @param name the name of the thread.
+  void OnThreadName(uint32 process_id,
+                    uint32 thread_id,
+                    const std::string& name);
+
+  // Records the process of a thread.
+  // @param process_id the process owning |thread_id|.
+  // @param thread_id a thread.
+  void OnThread(uint32 process_id, uint32 thread_id);
+
+  // Records a context switch. Thread 0 is the idle thread: it has no slice.
+  // @param timestamp the time of the switch.
+  // @param processor the processor switching threads.
+  // @param old_thread_id the thread leaving |processor|.
+  // @param new_thread_id the thread entering |processor|.
+  void OnContextSwitch(event::Timestamp timestamp,
+                       uint32 processor,
+                       uint32 old_thread_id,
+                       uint32 new_thread_id);
+
+  // Records the start of an I/O.
+  // @param timestamp the time of the request.
+  // @param category the category of the I/O.
+  // @param name the name of the I/O operation. Must be a static string.
+  // @param process_id the process of the event, used when the process of
+  //     |thread_id| is unknown.
+  // @param thread_id the issuing thread.
+  // @param irp the address of the I/O request packet.
+  void OnIoStart(event::Timestamp timestamp,
+                 IoCategory category,
+                 const char* name,
+                 uint32 process_id,
+                 uint32 thread_id,
+                 uint64 irp);
+
+  // Records the completion of an I/O.
+  // @param timestamp the time of the completion.
+  // @param category the category of the I/O.
+  // @param name the name of the I/O operation, used when the start of the
+  //     I/O is unknown. Must be a static string.
+  // @param process_id the process of the event, used when the start of the
+  //     I/O is unknown.
+  // @param thread_id the thread of the event, used when the start of the
+  //     I/O is unknown.
+  // @param irp the address of the I/O request packet.
+  // @param bytes the number of bytes transferred.
+  void OnIoEnd(event::Timestamp timestamp,
+               IoCategory category,
+               const char* name,
+               uint32 process_id,
+               uint32 thread_id,
+               uint64 irp,
+               uint64 bytes);
+
+  // Records a sampled instruction.
+  // @param timestamp the time of the sample.
+  // @param thread_id the sampled thread.
+  // @param instruction_pointer the sampled instruction.
+  void OnSample(event::Timestamp timestamp,
+                uint32 thread_id,
+                uint64 instruction_pointer);
+
+  // Ends the slices of the threads still running, closes the JSON document
+  // and writes the buffered events. No event can be received afterwards.
+  // @returns true on success, false if the stream failed.
+  bool Finish();
+
+  // @returns the number of trace events written or buffered.
+  uint64 event_count() const { return event_count_; }
+
+ private:
+  // The thread running on a processor.
+  struct Running {
+    Running() : thread_id(0), start(0) {}
+
+    uint32 thread_id;
+    event::Timestamp start;
+  };
+
+  // An I/O waiting for its completion.
+  struct PendingIo {
+    const char* name;
+    uint32 process_id;
+    uint32 thread_id;
+  };
+
+  typedef std::map<uint64, PendingIo> PendingIos;
+
+  // Records the time of an event. Finish() ends the running slices at the
+  // last time.
+  void AdvanceTime(event::Timestamp timestamp);
+
+  // @returns the process owning |thread_id|, or |process_id| if unknown.
+  uint32 GetThreadProcess(uint32 thread_id, uint32 process_id) const;
+
+  // Appends the common fields of a trace event, leaving the object open.
+  // @param name the name of the event.
+  // @param category the category of the event.
+  // @param phase the phase of the event.
+  // @param process_id the process of the event.
+  // @param thread_id the thread of the event.
+  void BeginEvent(const char* name,
+                  const char* category,
+                  char phase,
+                  uint32 process_id,
+                  uint32 thread_id);
+
+  // Appends the timestamp of an event.
+  void AppendTimestamp(event::Timestamp timestamp);
+
+  // Closes the object of a trace event and writes the buffer when full.
+  void EndEvent();
+
+  // Appends a "thread_name" or a "process_name" metadata event.
+  void AppendName(const char* metadata,
+                  uint32 process_id,
+                  uint32 thread_id,
+                  const std::string& name);
+
+  // Writes the buffer to the stream.
+  void Flush();
+
+  uint64 timestamps_per_microsecond_;
+  std::ostream* out_;
+
+  // The formatted events not yet written.
+  std::string buffer_;
+  size_t buffer_size_;
+
+  uint64 event_count_;
+  event::Timestamp last_timestamp_;
+
+  // The process of each thread.
+  IdMap<uint32> thread_processes_;
+
+  // The thread running on each processor.
+  IdMap<Running> running_;
+
+  // The in-flight I/Os of each category, by IRP.
+  PendingIos pending_ios_[IO_CATEGORY_COUNT];
+
+  DISALLOW_COPY_AND_ASSIGN(ChromeTraceExporter);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_CHROME_TRACE_EXPORTER_H_
@@ -0,0 +1,83 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/chrome_trace_exporter.h"
+
+#include <sstream>
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+const size_t kSwitches = 2000000;
+const size_t kThreads = 500;
+const size_t kProcessors = 8;
+
+// Discards the written bytes, to measure the formatting alone.
+class NullBuffer : public std::streambuf {
+ protected:
+  virtual std::streamsize xsputn(const char* /* data */,
+                                 std::streamsize size) {
+    return size;
+  }
+  virtual int overflow(int c) { return c; }
+};
+
+}  // namespace
+
+TEST(ChromeTraceExporterPerfTest, OnContextSwitch) {
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  ChromeTraceExporter exporter(10, &out);
+  // The thread ids start at 4: thread 0 is the idle thread, without slices.
+  for (size_t i = 0; i < kThreads; ++i) {
+    exporter.OnThread(static_cast<uint32>(i % 50),
+                      static_cast<uint32>((i + 1) * 4));
+  }
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kSwitches; ++i) {
+    // The n-th switch of a processor switches from the thread of the previous
+    // switch to the next one.
+    size_t processor = i % kProcessors;
+    size_t switch_index = i / kProcessors;
+    uint32 old_thread_id = static_cast<uint32>(
+        (switch_index % kThreads + 1) * 4);
+    uint32 new_thread_id = static_cast<uint32>(
+        ((switch_index + 1) % kThreads + 1) * 4);
+    exporter.OnContextSwitch(i * 13, static_cast<uint32>(processor),
+                             old_thread_id, new_thread_id);
+  }
+  EXPECT_TRUE(exporter.Finish());
+  base::PrintPerfResult("OnContextSwitch", "time", timer.ElapsedNanoseconds(),
+                        kSwitches, "ns/switch");
+
+  EXPECT_EQ(kSwitches, exporter.event_count());
+}
+
+}  // namespace analysis
@@ -0,0 +1,290 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/chrome_trace_exporter.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StringValue;
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+
+// The timestamps of the tests are in 100ns units, like the ETW timestamps.
+const uint64 kTimestampsPerMicrosecond = 10;
+
+const uint32 kProcessId = 1234;
+const uint32 kThreadId = 4000;
+const uint32 kOtherThreadId = 4004;
+const uint64 kIrp = 0xFFFFFA8002000010ULL;
+
+const char kEmptyDocument[] = "{\"traceEvents\":[\n\n]}\n";
+
+std::string Document(const std::string& events) {
+  return "{\"traceEvents\":[\n" + events + "\n]}\n";
+}
+
+void SendThreadStart(ChromeTraceExporter* exporter,
+                     uint32 process_id,
+                     uint32 thread_id) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("ProcessId", process_id);
+  content->AddField<UIntValue>("TThreadId", thread_id);
+  exporter->Receive(*CreateKernelEvent(0, "Thread", "DCStart", 0, 0, 0,
+                                       content.Pass()).get());
+}
+
+void SendProcessStart(ChromeTraceExporter* exporter,
+                      uint32 process_id,
+                      const std::string& name) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("ProcessId", process_id);
+  content->AddField<UIntValue>("ParentId", 4);
+  content->AddField<StringValue>("ImageFileName", name);
+  exporter->Receive(*CreateKernelEvent(0, "Process", "Start", 0, 0, 0,
+                                       content.Pass()).get());
+}
+
+void SendContextSwitch(ChromeTraceExporter* exporter,
+                       event::Timestamp timestamp,
+                       uint32 processor,
+                       uint32 old_thread_id,
+                       uint32 new_thread_id) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("NewThreadId", new_thread_id);
+  content->AddField<UIntValue>("OldThreadId", old_thread_id);
+  exporter->Receive(*CreateKernelEvent(timestamp, "Thread", "CSwitch", 0, 0,
+                                       processor, content.Pass()).get());
+}
+
+void SendFileIO(ChromeTraceExporter* exporter,
+                event::Timestamp timestamp,
+                const char* operation,
+                uint64 irp,
+                uint64 extra_info) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("IrpPtr", irp);
+  if (std::string(operation) == "OperationEnd") {
+    content->AddField<ULongValue>("ExtraInfo", extra_info);
+    content->AddField<UIntValue>("NtStatus", 0);
+  } else {
+    content->AddField<ULongValue>("TTID", kThreadId);
+    content->AddField<ULongValue>("FileObject", 0xFFFFFA8001000040ULL);
+  }
+  exporter->Receive(*CreateKernelEvent(timestamp, "FileIO", operation, 0, 0,
+                                       0, content.Pass()).get());
+}
+
+void SendDiskIO(ChromeTraceExporter* exporter,
+                event::Timestamp timestamp,
+                const char* operation,
+                uint64 irp,
+                uint32 transfer_size) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("DiskNumber", 0);
+  content->AddField<UIntValue>("TransferSize", transfer_size);
+  content->AddField<ULongValue>("Irp", irp);
+  content->AddField<UIntValue>("IssuingThreadId", kThreadId);
+  exporter->Receive(*CreateKernelEvent(timestamp, "DiskIO", operation, 0, 0,
+                                       0, content.Pass()).get());
+}
+
+void SendSample(ChromeTraceExporter* exporter,
+                event::Timestamp timestamp,
+                uint32 thread_id,
+                uint64 instruction_pointer) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("InstructionPointer", instruction_pointer);
+  content->AddField<UIntValue>("ThreadId", thread_id);
+  exporter->Receive(*CreateKernelEvent(timestamp, "PerfInfo", "SampleProf",
+                                       0, 0, 0, content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(ChromeTraceExporterTest, EmptyTrace) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  EXPECT_TRUE(exporter.Finish());
+  EXPECT_EQ(kEmptyDocument, out.str());
+  EXPECT_EQ(0U, exporter.event_count());
+}
+
+TEST(ChromeTraceExporterTest, ProcessName) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  SendProcessStart(&exporter, kProcessId, "a\"b\\c\n.exe");
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1234,\"tid\":0,"
+      "\"args\":{\"name\":\"a\\\"b\\\\c\\u000a.exe\"}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, ContextSwitchSlices) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  SendThreadStart(&exporter, kProcessId, kThreadId);
+
+  // The first switch starts the slice of |kThreadId|. The idle thread has no
+  // slice.
+  SendContextSwitch(&exporter, 100, 1, 0, kThreadId);
+  SendContextSwitch(&exporter, 125, 1, kThreadId, 0);
+  SendContextSwitch(&exporter, 200, 1, 0, kOtherThreadId);
+  SendContextSwitch(&exporter, 205, 1, kOtherThreadId, 0);
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"Running\",\"cat\":\"CSwitch\",\"ph\":\"X\",\"pid\":1234,"
+      "\"tid\":4000,\"ts\":10.000,\"dur\":2.500,\"args\":{\"cpu\":1}},\n"
+      "{\"name\":\"Running\",\"cat\":\"CSwitch\",\"ph\":\"X\",\"pid\":0,"
+      "\"tid\":4004,\"ts\":20.000,\"dur\":0.500,\"args\":{\"cpu\":1}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, FinishEndsRunningSlices) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(1, &out);
+  SendContextSwitch(&exporter, 10, 0, 0, kThreadId);
+  SendContextSwitch(&exporter, 12, 3, 0, kOtherThreadId);
+  SendSample(&exporter, 30, kThreadId, 0x1000);
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"SampleProf\",\"cat\":\"PerfInfo\",\"ph\":\"P\",\"pid\":0,"
+      "\"tid\":4000,\"ts\":30,\"args\":{\"ip\":\"0x1000\"}},\n"
+      "{\"name\":\"Running\",\"cat\":\"CSwitch\",\"ph\":\"X\",\"pid\":0,"
+      "\"tid\":4000,\"ts\":10,\"dur\":20,\"args\":{\"cpu\":0}},\n"
+      "{\"name\":\"Running\",\"cat\":\"CSwitch\",\"ph\":\"X\",\"pid\":0,"
+      "\"tid\":4004,\"ts\":12,\"dur\":18,\"args\":{\"cpu\":3}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, FinishAfterDirectCalls) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(1, &out);
+  exporter.OnContextSwitch(10, 0, 0, kThreadId);
+  exporter.OnContextSwitch(15, 0, kThreadId, kOtherThreadId);
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"Running\",\"cat\":\"CSwitch\",\"ph\":\"X\",\"pid\":0,"
+      "\"tid\":4000,\"ts\":10,\"dur\":5,\"args\":{\"cpu\":0}},\n"
+      "{\"name\":\"Running\",\"cat\":\"CSwitch\",\"ph\":\"X\",\"pid\":0,"
+      "\"tid\":4004,\"ts\":15,\"dur\":0,\"args\":{\"cpu\":0}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, FileIOAsyncSlice) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  SendThreadStart(&exporter, kProcessId, kThreadId);
+  SendFileIO(&exporter, 10, "Read", kIrp, 0);
+  SendFileIO(&exporter, 35, "OperationEnd", kIrp, 4096);
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"Read\",\"cat\":\"FileIO\",\"ph\":\"b\",\"pid\":1234,"
+      "\"tid\":4000,\"ts\":1.000,\"id\":\"0xfffffa8002000010\"},\n"
+      "{\"name\":\"Read\",\"cat\":\"FileIO\",\"ph\":\"e\",\"pid\":1234,"
+      "\"tid\":4000,\"ts\":3.500,\"id\":\"0xfffffa8002000010\","
+      "\"args\":{\"bytes\":4096}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, DiskIOAsyncSlice) {
+  std::ostringstream out;
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  SendDiskIO(&exporter, 10, "WriteInit", kIrp, 0);
+  SendDiskIO(&exporter, 20, "Write", kIrp, 512);
+  // A completion without a start is an instant.
+  SendDiskIO(&exporter, 30, "Read", kIrp, 1024);
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"Write\",\"cat\":\"DiskIO\",\"ph\":\"b\",\"pid\":0,"
+      "\"tid\":4000,\"ts\":1.000,\"id\":\"0xfffffa8002000010\"},\n"
+      "{\"name\":\"Write\",\"cat\":\"DiskIO\",\"ph\":\"e\",\"pid\":0,"
+      "\"tid\":4000,\"ts\":2.000,\"id\":\"0xfffffa8002000010\","
+      "\"args\":{\"bytes\":512}},\n"
+      "{\"name\":\"Read\",\"cat\":\"DiskIO\",\"ph\":\"n\",\"pid\":0,"
+      "\"tid\":4000,\"ts\":3.000,\"id\":\"0xfffffa8002000010\","
+      "\"args\":{\"bytes\":1024}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, PerfCommNamesThreads) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("pid", kProcessId);
+  content->AddField<UIntValue>("tid", kProcessId);
+  content->AddField<StringValue>("comm", "bash");
+
+  std::ostringstream out;
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  exporter.Receive(*CreateKernelEvent(0, "Perf", "Comm", kProcessId,
+                                      kProcessId, 0, content.Pass()).get());
+  EXPECT_TRUE(exporter.Finish());
+
+  EXPECT_EQ(Document(
+      "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1234,\"tid\":1234,"
+      "\"args\":{\"name\":\"bash\"}},\n"
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1234,\"tid\":0,"
+      "\"args\":{\"name\":\"bash\"}}"),
+      out.str());
+}
+
+TEST(ChromeTraceExporterTest, SmallBufferWritesSameDocument) {
+  std::ostringstream expected;
+  std::ostringstream out;
+  ChromeTraceExporter reference(kTimestampsPerMicrosecond, &expected);
+  ChromeTraceExporter exporter(kTimestampsPerMicrosecond, &out);
+  exporter.set_buffer_size(16);
+
+  for (uint32 i = 0; i < 100; ++i) {
+    SendContextSwitch(&reference, i * 10, i % 4, kThreadId + i - 4,
+                      kThreadId + i);
+    SendContextSwitch(&exporter, i * 10, i % 4, kThreadId + i - 4,
+                      kThreadId + i);
+  }
+
+  // The buffer is written each time it fills up.
+  EXPECT_TRUE(expected.str().empty());
+  EXPECT_FALSE(out.str().empty());
+
+  EXPECT_TRUE(reference.Finish());
+  EXPECT_TRUE(exporter.Finish());
+  EXPECT_EQ(expected.str(), out.str());
+  EXPECT_EQ(100U, exporter.event_count());
+}
+
+}  // namespace analysis
@@ -0,0 +1,434 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "analysis/columnar_encoding.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "base/hash.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::Value;
+
+// The initial number of slots of the hash table of the dictionary.
+const size_t kInitialSlotCount = 1024;
+
+const uint64 kSignBit = static_cast<uint64>(1) << 63;
+
+uint64 LoadWord(const char* data, size_t index) {
+  uint64 word;
+  memcpy(&word, data + index * sizeof(word), sizeof(word));
+  return word;
+}
+
+void AppendWord(uint64 word, std::string* data) {
+  data->append(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+uint64 BitMask(uint8 bit_width) {
+  if (bit_width >= 64)
+    return std::numeric_limits<uint64>::max();
+  return (static_cast<uint64>(1) << bit_width) - 1;
+}
+
+// Unpacks values one at a time, from the 64-bit words holding them, and adds
+// |base| to each of them.
+template <uint8 kBitWidth>
+void UnpackWords(const char* data,
+                 size_t first,
+                 size_t count,
+                 uint64 base,
+                 uint64* values) {
+  const uint64 kMask = BitMask(kBitWidth);
+  uint64 bit = static_cast<uint64>(first) * kBitWidth;
+  for (size_t i = first; i < count; ++i, bit += kBitWidth) {
+    size_t index = static_cast<size_t>(bit / 64);
+    size_t shift = static_cast<size_t>(bit % 64);
+    uint64 value = LoadWord(data, index) >> shift;
+    if (shift != 0 && shift + kBitWidth > 64)
+      value |= LoadWord(data, index + 1) << (64 - shift);
+    values[i] = base + (value & kMask);
+  }
+}
+
+// Unpacks values of a width known at compile time, and adds |base| to each of
+// them. The words are little-endian: 8 values span exactly |kBitWidth| bytes,
+// and a value of up to 56 bits is read with a single unaligned load at its
+// first byte. Within a group of 8 values, the offsets and the shifts are
+// constants.
+template <uint8 kBitWidth>
+void UnpackFixedWidth(const char* data,
+                      size_t count,
+                      uint64 base,
+                      uint64* values) {
+  const uint64 kMask = BitMask(kBitWidth);
+  size_t i = 0;
+  if (kBitWidth <= 56) {
+    // The loads of a group read up to kBitWidth + 8 bytes from its start:
+    // the last groups are left to UnpackWords, to stay within the data.
+    size_t size = PackedColumnarSize(count, kBitWidth);
+    size_t group_count = 0;
+    if (size >= kBitWidth + sizeof(uint64)) {
+      group_count = std::min(
+          count / 8, (size - kBitWidth - sizeof(uint64)) / kBitWidth + 1);
+    }
+
+    const char* group = data;
+    for (size_t g = 0; g < group_count; ++g, group += kBitWidth, i += 8) {
+      for (size_t j = 0; j < 8; ++j) {
+        const size_t bit = j * kBitWidth;
+        uint64 word;
+        memcpy(&word, group + bit / 8, sizeof(word));
+        values[i + j] = base + ((word >> (bit % 8)) & kMask);
+      }
+    }
+  }
+  UnpackWords<kBitWidth>(data, i, count, base, values);
+}
+
+typedef void (*UnpackFunction)(const char* data,
+                               size_t count,
+                               uint64 base,
+                               uint64* values);
+
+#define UNPACK_WIDTHS_8(first) \
+    &UnpackFixedWidth<first>, &UnpackFixedWidth<first + 1>, \
+    &UnpackFixedWidth<first + 2>, &UnpackFixedWidth<first + 3>, \
+    &UnpackFixedWidth<first + 4>, &UnpackFixedWidth<first + 5>, \
+    &UnpackFixedWidth<first + 6>, &UnpackFixedWidth<first + 7>
+
+// The unpacking function of each width, from 1 to 64 bits.
+const UnpackFunction kUnpackFunctions[64] = {
+  UNPACK_WIDTHS_8(1), UNPACK_WIDTHS_8(9), UNPACK_WIDTHS_8(17),
+  UNPACK_WIDTHS_8(25), UNPACK_WIDTHS_8(33), UNPACK_WIDTHS_8(41),
+  UNPACK_WIDTHS_8(49), UNPACK_WIDTHS_8(57)
+};
+
+#undef UNPACK_WIDTHS_8
+
+void UnpackWithBase(const char* data,
+                    size_t count,
+                    uint8 bit_width,
+                    uint64 base,
+                    uint64* values) {
+  if (bit_width == 0) {
+    std::fill(values, values + count, base);
+    return;
+  }
+  kUnpackFunctions[bit_width - 1](data, count, base, values);
+}
+
+}  // namespace
+
+bool IsColumnarType(event::ValueType type) {
+  return type != event::VALUE_STRUCT && type != event::VALUE_ARRAY;
+}
+
+uint64 ColumnValueToKey(event::ValueType type, uint64 value) {
+  switch (type) {
+    case event::VALUE_CHAR:
+    case event::VALUE_SHORT:
+    case event::VALUE_INT:
+    case event::VALUE_LONG:
+      return value ^ kSignBit;
+    case event::VALUE_FLOAT:
+    case event::VALUE_DOUBLE:
+      if ((value & kSignBit) != 0)
+        return ~value;
+      return value | kSignBit;
+    default:
+      return value;
+  }
+}
+
+uint64 ColumnKeyToValue(event::ValueType type, uint64 key) {
+  switch (type) {
+    case event::VALUE_CHAR:
+    case event::VALUE_SHORT:
+    case event::VALUE_INT:
+    case event::VALUE_LONG:
+      return key ^ kSignBit;
+    case event::VALUE_FLOAT:
+    case event::VALUE_DOUBLE:
+      if ((key & kSignBit) != 0)
+        return key & ~kSignBit;
+      return ~key;
+    default:
+      return key;
+  }
+}
+
+uint64 GetColumnValue(const Value* value) {
+  DCHECK(value != NULL);
+
+  switch (value->GetType()) {
+    case event::VALUE_BOOL:
+      return event::BoolValue::GetValue(value) ? 1 : 0;
+    case event::VALUE_CHAR:
+      return static_cast<uint64>(static_cast<int64>(
+          event::CharValue::GetValue(value)));
+    case event::VALUE_UCHAR:
+      return event::UCharValue::GetValue(value);
+    case event::VALUE_SHORT:
+      return static_cast<uint64>(static_cast<int64>(
+          event::ShortValue::GetValue(value)));
+    case event::VALUE_USHORT:
+      return event::UShortValue::GetValue(value);
+    case event::VALUE_INT:
+      return static_cast<uint64>(static_cast<int64>(
+          event::IntValue::GetValue(value)));
+    case event::VALUE_UINT:
+      return event::UIntValue::GetValue(value);
+    case event::VALUE_LONG:
+      return static_cast<uint64>(event::LongValue::GetValue(value));
+    case event::VALUE_ULONG:
+      return event::ULongValue::GetValue(value);
+    case event::VALUE_FLOAT:
+      return DoubleToColumnValue(event::FloatValue::GetValue(value));
+    case event::VALUE_DOUBLE:
+      return DoubleToColumnValue(event::DoubleValue::GetValue(value));
+    default:
+      DCHECK(false) << "Not a columnar scalar.";
+      return 0;
+  }
+}
+
+uint64 DoubleToColumnValue(double value) {
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double ColumnValueToDouble(uint64 value) {
+  double result;
+  memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+uint8 ColumnarBitWidth(uint64 range) {
+  uint8 width = 0;
+  while (range != 0) {
+    range >>= 1;
+    ++width;
+  }
+  return width;
+}
+
+size_t PackedColumnarSize(size_t count, uint8 bit_width) {
+  uint64 bits = static_cast<uint64>(count) * bit_width;
+  return static_cast<size_t>((bits + 63) / 64 * 8);
+}
+
+void PackColumnarValues(const uint64* values,
+                        size_t count,
+                        uint8 bit_width,
+                        std::string* data) {
+  DCHECK(values != NULL || count == 0);
+  DCHECK_LE(bit_width, 64);
+  DCHECK(data != NULL);
+
+  if (bit_width == 0)
+    return;
+
+  data->reserve(data->size() + PackedColumnarSize(count, bit_width));
+  uint64 word = 0;
+  size_t shift = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint64 value = values[i];
+    DCHECK_EQ(0U, value & ~BitMask(bit_width));
+    word |= value << shift;
+    shift += bit_width;
+    if (shift >= 64) {
+      AppendWord(word, data);
+      shift -= 64;
+      // The bits of |value| that didn't fit in the full word.
+      word = shift == 0 ? 0 : value >> (bit_width - shift);
+    }
+  }
+  if (shift != 0)
+    AppendWord(word, data);
+}
+
+void UnpackColumnarValues(const char* data,
+                          size_t count,
+                          uint8 bit_width,
+                          uint64* values) {
+  DCHECK(data != NULL || count == 0 || bit_width == 0);
+  DCHECK(values != NULL || count == 0);
+  DCHECK_LE(bit_width, 64);
+
+  UnpackWithBase(data, count, bit_width, 0, values);
+}
+
+void EncodeColumnarBlock(const uint64* keys,
+                         size_t count,
+                         ColumnarBlockHeader* header,
+                         std::string* data) {
+  DCHECK(keys != NULL);
+  DCHECK_LT(0U, count);
+  DCHECK(header != NULL);
+  DCHECK(data != NULL);
+
+  uint64 min_key = keys[0];
+  uint64 max_key = keys[0];
+  int64 min_delta = 0;
+  int64 max_delta = 0;
+  for (size_t i = 1; i < count; ++i) {
+    uint64 key = keys[i];
+    if (key < min_key)
+      min_key = key;
+    if (key > max_key)
+      max_key = key;
+
+    int64 delta = static_cast<int64>(key - keys[i - 1]);
+    if (i == 1 || delta < min_delta)
+      min_delta = delta;
+    if (i == 1 || delta > max_delta)
+      max_delta = delta;
+  }
+
+  uint8 frame_width = ColumnarBitWidth(max_key - min_key);
+  uint8 delta_width = ColumnarBitWidth(
+      static_cast<uint64>(max_delta) - static_cast<uint64>(min_delta));
+
+  header->min_key = min_key;
+  header->max_key = max_key;
+  memset(header->reserved, 0, sizeof(header->reserved));
+
+  size_t start = data->size();
+  if (count > 1 && delta_width < frame_width) {
+    header->encoding = COLUMNAR_DELTA;
+    header->bit_width = delta_width;
+    header->base = keys[0];
+    header->reference = static_cast<uint64>(min_delta);
+
+    // The first key is the base: only the following differences are packed.
+    std::vector<uint64> deltas(count - 1);
+    for (size_t i = 1; i < count; ++i)
+      deltas[i - 1] = keys[i] - keys[i - 1] - header->reference;
+    PackColumnarValues(&deltas[0], deltas.size(), delta_width, data);
+  } else {
+    header->encoding = COLUMNAR_FRAME_OF_REFERENCE;
+    header->bit_width = frame_width;
+    header->base = min_key;
+    header->reference = 0;
+
+    if (frame_width != 0) {
+      std::vector<uint64> offsets(keys, keys + count);
+      for (size_t i = 0; i < count; ++i)
+        offsets[i] -= min_key;
+      PackColumnarValues(&offsets[0], count, frame_width, data);
+    }
+  }
+  header->size = static_cast<uint32>(data->size() - start);
+}
+
+bool DecodeColumnarBlock(const ColumnarBlockHeader& header,
+                         const char* data,
+                         size_t count,
+                         uint64* keys) {
+  DCHECK(keys != NULL || count == 0);
+
+  if (header.bit_width > 64 || count == 0)
+    return count == 0;
+
+  if (header.encoding == COLUMNAR_FRAME_OF_REFERENCE) {
+    if (header.size != PackedColumnarSize(count, header.bit_width))
+      return false;
+    UnpackWithBase(data, count, header.bit_width, header.base, keys);
+    return true;
+  }
+
+  if (header.encoding == COLUMNAR_DELTA) {
+    if (header.size != PackedColumnarSize(count - 1, header.bit_width))
+      return false;
+    // The differences are unpacked after the first key, then summed in place.
+    UnpackWithBase(data, count - 1, header.bit_width, 0, keys + 1);
+    uint64 key = header.base;
+    uint64 reference = header.reference;
+    keys[0] = key;
+    for (size_t i = 1; i < count; ++i) {
+      key += keys[i] + reference;
+      keys[i] = key;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+ColumnarDictionary::ColumnarDictionary()
+    : offsets_(1, 0), slots_(kInitialSlotCount, 0) {
+}
+
+uint32 ColumnarDictionary::Intern(const char* data, size_t size) {
+  DCHECK(data != NULL || size == 0);
+
+  uint64 hash = base::Hash64(data, size);
+  size_t mask = slots_.size() - 1;
+
+  size_t slot = static_cast<size_t>(hash) & mask;
+  for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+    uint32 id = slots_[slot] - 1;
+    if (hashes_[id] != hash)
+      continue;
+    size_t offset = static_cast<size_t>(offsets_[id]);
+    if (offsets_[id + 1] - offset == size &&
+        bytes_.compare(offset, size, data, size) == 0) {
+      return id;
+    }
+  }
+
+  uint32 id = static_cast<uint32>(hashes_.size());
+  bytes_.append(data, size);
+  offsets_.push_back(bytes_.size());
+  hashes_.push_back(hash);
+  slots_[slot] = id + 1;
+
+  // Keep the load factor of the hash table under one half.
+  if (2 * hashes_.size() > slots_.size())
+    Grow();
+
+  return id;
+}
+
+void ColumnarDictionary::Grow() {
+  std::vector<uint32> slots(2 * slots_.size(), 0);
+  size_t mask = slots.size() - 1;
+  for (size_t id = 0; id < hashes_.size(); ++id) {
+    size_t slot = static_cast<size_t>(hashes_[id]) & mask;
+    while (slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots[slot] = static_cast<uint32>(id + 1);
+  }
+  slots_.swap(slots);
+}
+
+}  // namespace analysis
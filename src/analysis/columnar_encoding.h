@@ -0,0 +1,224 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The encodings of the columnar trace store (see columnar_store.h). A column
+// holds one scalar per row. Its values are mapped to 64-bit keys, so that a
+// single set of encodings and of block statistics serves every value type:
+//   - unsigned integers and booleans are their own key,
+//   - signed integers have their sign bit flipped,
+//   - floating values have their sign bit flipped when positive, and all
+//     their bits flipped when negative,
+//   - strings are replaced by their identifier in a ColumnarDictionary.
+// The keys of numeric values sort in the same order as the values. The string
+// identifiers follow the order of first occurrence, not the order of the
+// strings: the statistics of a string column only support equality tests.
+//
+// The keys are cut into blocks of kColumnarBlockRows rows. Each block is
+// encoded on its own, with the smaller of:
+//   - COLUMNAR_FRAME_OF_REFERENCE: the offsets of the keys from the minimum
+//     of the block, packed on the bits needed by the largest offset,
+//   - COLUMNAR_DELTA: the differences between consecutive keys, packed the
+//     same way from the smallest difference. Timestamps and increasing
+//     identifiers need a few bits per row.
+// A block where every key is equal needs no data at all.
+//
+// Usage example:
+//   ColumnarBlockHeader header;
+//   std::string data;
+//   EncodeColumnarBlock(&keys[0], keys.size(), &header, &data);
+//   DecodeColumnarBlock(header, data.data(), keys.size(), &keys[0]);
+
+#ifndef ANALYSIS_COLUMNAR_ENCODING_H_
+#define ANALYSIS_COLUMNAR_ENCODING_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "event/value.h"
+
+namespace analysis {
+
+// The number of rows of a block. The last block of a column may be shorter.
+const size_t kColumnarBlockRows = 4096;
+
+enum ColumnarEncoding {
+  COLUMNAR_FRAME_OF_REFERENCE,
+  COLUMNAR_DELTA
+};
+
+#pragma pack(push, 1)
+
+// Describes an encoded block. Stored in the directory of a store file, apart
+// from the data, so that the statistics can be checked without touching it.
+struct ColumnarBlockHeader {
+  // The offset of the data in the file, in bytes.
+  uint64 offset;
+  // The smallest and the largest key of the block.
+  uint64 min_key;
+  uint64 max_key;
+  // COLUMNAR_FRAME_OF_REFERENCE: the key subtracted from every key.
+  // COLUMNAR_DELTA: the first key.
+  uint64 base;
+  // COLUMNAR_DELTA: the difference subtracted from every difference.
+  uint64 reference;
+  // The size of the data, in bytes.
+  uint32 size;
+  // A ColumnarEncoding.
+  uint8 encoding;
+  // The number of bits of a packed value.
+  uint8 bit_width;
+  uint8 reserved[2];
+};
+
+#pragma pack(pop)
+
+COMPILE_ASSERT(sizeof(ColumnarBlockHeader) == 48,
+               columnar_block_header_must_be_48_bytes);
+
+// @param type the type of a scalar value.
+// @returns true if values of type |type| can be stored in a column.
+bool IsColumnarType(event::ValueType type);
+
+// Maps a value to its key. The value of a column is an unsigned integer, the
+// bits of a signed integer, the bits of a double, or a string identifier.
+// @param type the type of the column.
+// @param value the value to map.
+// @returns the key of |value|.
+uint64 ColumnValueToKey(event::ValueType type, uint64 value);
+
+// Maps a key back to its value.
+// @param type the type of the column.
+// @param key the key to map.
+// @returns the value of |key|.
+uint64 ColumnKeyToValue(event::ValueType type, uint64 key);
+
+// Gets the value of a column from a scalar. Strings are not handled: they
+// must be replaced by their identifier.
+// @param value a scalar value, not a string.
+// @returns the value of |value| in a column of its type.
+uint64 GetColumnValue(const event::Value* value);
+
+// @returns the bits of |value|, the value of a floating column.
+uint64 DoubleToColumnValue(double value);
+
+// @returns the double whose bits are |value|.
+double ColumnValueToDouble(uint64 value);
+
+// @param range the largest value to pack.
+// @returns the number of bits needed to pack |range|.
+uint8 ColumnarBitWidth(uint64 range);
+
+// Packs values on |bit_width| bits each, in 64-bit little-endian words.
+// @param values the values to pack. Each must fit in |bit_width| bits.
+// @param count the number of values.
+// @param bit_width the number of bits of a value, up to 64.
+// @param data receives the words, appended.
+void PackColumnarValues(const uint64* values,
+                        size_t count,
+                        uint8 bit_width,
+                        std::string* data);
+
+// Unpacks the values packed by PackColumnarValues.
+// @param data the packed words. Must hold the words of |count| values.
+// @param count the number of values.
+// @param bit_width the number of bits of a value, up to 64.
+// @param values receives the |count| values.
+void UnpackColumnarValues(const char* data,
+                          size_t count,
+                          uint8 bit_width,
+                          uint64* values);
+
+// @returns the number of bytes of |count| values packed on |bit_width| bits.
+size_t PackedColumnarSize(size_t count, uint8 bit_width);
+
+// Encodes a block of keys.
+// @param keys the keys of the block.
+// @param count the number of keys, at least one.
+// @param header receives the encoding and the statistics of the block. Its
+//     offset is left unchanged.
+// @param data receives the encoded data, appended. Its size is a multiple of
+//     8 bytes.
+void EncodeColumnarBlock(const uint64* keys,
+                         size_t count,
+                         ColumnarBlockHeader* header,
+                         std::string* data);
+
+// Decodes a block of keys.
+// @param header the header of the block.
+// @param data the data of the block.
+// @param count the number of keys of the block.
+// @param keys receives the |count| keys.
+// @returns true on success, false if the header is invalid.
+bool DecodeColumnarBlock(const ColumnarBlockHeader& header,
+                         const char* data,
+                         size_t count,
+                         uint64* keys);
+
+// Interns strings into dense identifiers, in order of first occurrence.
+class ColumnarDictionary {
+ public:
+  ColumnarDictionary();
+
+  // Interns a string.
+  // @param data the bytes of the string.
+  // @param size the number of bytes.
+  // @returns the identifier of the string. Equal strings have the same
+  //     identifier.
+  uint32 Intern(const char* data, size_t size);
+
+  uint32 Intern(const std::string& str) {
+    return Intern(str.data(), str.size());
+  }
+
+  // @returns the number of distinct strings.
+  size_t size() const { return offsets_.size() - 1; }
+
+  // @returns the bytes of every string, concatenated in identifier order.
+  const std::string& bytes() const { return bytes_; }
+
+  // @returns the offset of each string in bytes(), followed by the size of
+  //     bytes().
+  const std::vector<uint64>& offsets() const { return offsets_; }
+
+ private:
+  // Doubles the number of slots of the hash table.
+  void Grow();
+
+  std::string bytes_;
+  std::vector<uint64> offsets_;
+
+  // The hash of each string, indexed by identifier.
+  std::vector<uint64> hashes_;
+
+  // Open addressing hash table of identifiers plus one. Zero is a free slot.
+  std::vector<uint32> slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnarDictionary);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_COLUMNAR_ENCODING_H_
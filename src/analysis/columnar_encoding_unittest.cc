@@ -0,0 +1,237 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "analysis/columnar_encoding.h"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+// Encodes and decodes a block, and checks that the keys are unchanged.
+void ExpectRoundTrip(const std::vector<uint64>& keys,
+                     ColumnarBlockHeader* header) {
+  std::string data;
+  EncodeColumnarBlock(&keys[0], keys.size(), header, &data);
+  EXPECT_EQ(data.size(), header->size);
+  EXPECT_EQ(0U, data.size() % 8);
+
+  std::vector<uint64> decoded(keys.size());
+  ASSERT_TRUE(DecodeColumnarBlock(*header, data.data(), keys.size(),
+                                  &decoded[0]));
+  EXPECT_EQ(keys, decoded);
+}
+
+}  // namespace
+
+TEST(ColumnarEncodingTest, KeysSortLikeValues) {
+  EXPECT_LT(ColumnValueToKey(event::VALUE_INT, static_cast<uint64>(-5)),
+            ColumnValueToKey(event::VALUE_INT, static_cast<uint64>(-1)));
+  EXPECT_LT(ColumnValueToKey(event::VALUE_INT, static_cast<uint64>(-1)),
+            ColumnValueToKey(event::VALUE_INT, 0));
+  EXPECT_LT(ColumnValueToKey(event::VALUE_INT, 0),
+            ColumnValueToKey(event::VALUE_INT, 7));
+
+  const double kDoubles[] = { -1e10, -2.5, -0.0, 0.0, 1e-10, 3.0, 1e10 };
+  for (size_t i = 1; i < sizeof(kDoubles) / sizeof(kDoubles[0]); ++i) {
+    EXPECT_LE(
+        ColumnValueToKey(event::VALUE_DOUBLE,
+                         DoubleToColumnValue(kDoubles[i - 1])),
+        ColumnValueToKey(event::VALUE_DOUBLE,
+                         DoubleToColumnValue(kDoubles[i])));
+  }
+
+  EXPECT_EQ(42U, ColumnValueToKey(event::VALUE_UINT, 42));
+  EXPECT_EQ(42U, ColumnValueToKey(event::VALUE_STRING, 42));
+}
+
+TEST(ColumnarEncodingTest, KeysRoundTrip) {
+  const event::ValueType kTypes[] = {
+    event::VALUE_CHAR, event::VALUE_LONG, event::VALUE_ULONG,
+    event::VALUE_DOUBLE
+  };
+  const uint64 kValues[] = {
+    0, 1, static_cast<uint64>(-1), DoubleToColumnValue(-3.5),
+    std::numeric_limits<uint64>::max() / 2
+  };
+  for (size_t i = 0; i < sizeof(kTypes) / sizeof(kTypes[0]); ++i) {
+    for (size_t j = 0; j < sizeof(kValues) / sizeof(kValues[0]); ++j) {
+      EXPECT_EQ(kValues[j],
+                ColumnKeyToValue(kTypes[i],
+                                 ColumnValueToKey(kTypes[i], kValues[j])));
+    }
+  }
+}
+
+TEST(ColumnarEncodingTest, GetColumnValue) {
+  event::IntValue negative(-3);
+  event::UCharValue small(200);
+  event::BoolValue flag(true);
+  event::FloatValue floating(1.5f);
+
+  EXPECT_EQ(static_cast<uint64>(-3), GetColumnValue(&negative));
+  EXPECT_EQ(200U, GetColumnValue(&small));
+  EXPECT_EQ(1U, GetColumnValue(&flag));
+  EXPECT_EQ(1.5, ColumnValueToDouble(GetColumnValue(&floating)));
+}
+
+TEST(ColumnarEncodingTest, BitWidth) {
+  EXPECT_EQ(0, ColumnarBitWidth(0));
+  EXPECT_EQ(1, ColumnarBitWidth(1));
+  EXPECT_EQ(8, ColumnarBitWidth(255));
+  EXPECT_EQ(9, ColumnarBitWidth(256));
+  EXPECT_EQ(64, ColumnarBitWidth(std::numeric_limits<uint64>::max()));
+}
+
+TEST(ColumnarEncodingTest, PackEveryWidth) {
+  const size_t kCount = 100;
+  for (uint8 width = 0; width <= 64; ++width) {
+    uint64 mask = width == 64 ? std::numeric_limits<uint64>::max() :
+        (static_cast<uint64>(1) << width) - 1;
+    std::vector<uint64> values(kCount);
+    for (size_t i = 0; i < kCount; ++i)
+      values[i] = (i * 0x9E3779B97F4A7C15ULL) & mask;
+
+    std::string data;
+    PackColumnarValues(&values[0], kCount, width, &data);
+    EXPECT_EQ(PackedColumnarSize(kCount, width), data.size());
+
+    std::vector<uint64> unpacked(kCount, 1);
+    UnpackColumnarValues(data.data(), kCount, width, &unpacked[0]);
+    EXPECT_EQ(values, unpacked) << "width " << static_cast<int>(width);
+  }
+}
+
+TEST(ColumnarEncodingTest, FrameOfReference) {
+  std::vector<uint64> keys;
+  for (size_t i = 0; i < 1000; ++i)
+    keys.push_back(1000000 + (i * 37) % 200);
+
+  ColumnarBlockHeader header = {};
+  ExpectRoundTrip(keys, &header);
+  EXPECT_EQ(COLUMNAR_FRAME_OF_REFERENCE, header.encoding);
+  EXPECT_EQ(8, header.bit_width);
+  EXPECT_EQ(1000000U, header.min_key);
+  EXPECT_EQ(1000199U, header.max_key);
+}
+
+TEST(ColumnarEncodingTest, Delta) {
+  // Increasing timestamps: the differences need fewer bits than the range.
+  std::vector<uint64> keys;
+  uint64 timestamp = 123456789;
+  for (size_t i = 0; i < 1000; ++i) {
+    timestamp += 100 + i % 4;
+    keys.push_back(timestamp);
+  }
+
+  ColumnarBlockHeader header = {};
+  ExpectRoundTrip(keys, &header);
+  EXPECT_EQ(COLUMNAR_DELTA, header.encoding);
+  EXPECT_EQ(2, header.bit_width);
+  EXPECT_EQ(keys.front(), header.min_key);
+  EXPECT_EQ(keys.back(), header.max_key);
+}
+
+TEST(ColumnarEncodingTest, DecreasingDelta) {
+  std::vector<uint64> keys;
+  for (size_t i = 0; i < 100; ++i)
+    keys.push_back((static_cast<uint64>(1) << 60) - i * 1000);
+
+  ColumnarBlockHeader header = {};
+  ExpectRoundTrip(keys, &header);
+}
+
+TEST(ColumnarEncodingTest, ConstantAndExtremes) {
+  std::vector<uint64> constant(10, 77);
+  ColumnarBlockHeader header = {};
+  ExpectRoundTrip(constant, &header);
+  EXPECT_EQ(0, header.bit_width);
+  EXPECT_EQ(0U, header.size);
+
+  std::vector<uint64> single(1, 5);
+  ExpectRoundTrip(single, &header);
+
+  std::vector<uint64> extremes;
+  extremes.push_back(0);
+  extremes.push_back(std::numeric_limits<uint64>::max());
+  extremes.push_back(1);
+  ExpectRoundTrip(extremes, &header);
+}
+
+TEST(ColumnarEncodingTest, DecodeInvalidHeader) {
+  std::vector<uint64> keys(10, 0);
+  keys[3] = 1000;
+  ColumnarBlockHeader header = {};
+  std::string data;
+  EncodeColumnarBlock(&keys[0], keys.size(), &header, &data);
+
+  std::vector<uint64> decoded(keys.size());
+  ColumnarBlockHeader wrong_size = header;
+  wrong_size.size += 8;
+  EXPECT_FALSE(DecodeColumnarBlock(wrong_size, data.data(), keys.size(),
+                                   &decoded[0]));
+  ColumnarBlockHeader wrong_encoding = header;
+  wrong_encoding.encoding = 7;
+  EXPECT_FALSE(DecodeColumnarBlock(wrong_encoding, data.data(), keys.size(),
+                                   &decoded[0]));
+}
+
+TEST(ColumnarDictionaryTest, Intern) {
+  ColumnarDictionary dictionary;
+  EXPECT_EQ(0U, dictionary.Intern("C:\\Windows\\notepad.exe"));
+  EXPECT_EQ(1U, dictionary.Intern(""));
+  EXPECT_EQ(2U, dictionary.Intern("ntoskrnl.exe"));
+  EXPECT_EQ(0U, dictionary.Intern("C:\\Windows\\notepad.exe"));
+  EXPECT_EQ(1U, dictionary.Intern(""));
+  EXPECT_EQ(3U, dictionary.size());
+
+  EXPECT_EQ("C:\\Windows\\notepad.exentoskrnl.exe", dictionary.bytes());
+  ASSERT_EQ(4U, dictionary.offsets().size());
+  EXPECT_EQ(22U, dictionary.offsets()[1]);
+  EXPECT_EQ(22U, dictionary.offsets()[2]);
+  EXPECT_EQ(34U, dictionary.offsets()[3]);
+}
+
+TEST(ColumnarDictionaryTest, Grow) {
+  ColumnarDictionary dictionary;
+  const size_t kStrings = 5000;
+  for (size_t i = 0; i < kStrings; ++i) {
+    std::string str(1, static_cast<char>('a' + i % 26));
+    str += std::string(i / 26, 'z');
+    EXPECT_EQ(i, dictionary.Intern(str));
+  }
+  for (size_t i = 0; i < kStrings; ++i) {
+    std::string str(1, static_cast<char>('a' + i % 26));
+    str += std::string(i / 26, 'z');
+    EXPECT_EQ(i, dictionary.Intern(str));
+  }
+  EXPECT_EQ(kStrings, dictionary.size());
+}
+
+}  // namespace analysis
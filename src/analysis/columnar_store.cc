@@ -0,0 +1,704 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "analysis/columnar_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StringValue;
+using event::StructValue;
+using event::Value;
+using event::WStringValue;
+
+// The columns of the header fields of the events, first in every section.
+const char* const kHeaderColumns[] = {
+  "timestamp", "process_id", "thread_id", "processor_number"
+};
+const event::ValueType kHeaderColumnTypes[] = {
+  event::VALUE_ULONG, event::VALUE_ULONG, event::VALUE_ULONG,
+  event::VALUE_UINT
+};
+const size_t kHeaderColumnCount =
+    sizeof(kHeaderColumns) / sizeof(kHeaderColumns[0]);
+
+// The prefix of the columns of the decoded payload.
+const char kContentPrefix[] = "content.";
+
+// The number of compressed blocks decompressed at once in the window over a
+// compressed store. The blocks of a column are interleaved with the other
+// columns of their section: a window serves the next blocks of a scan.
+const size_t kColumnarWindowBlocks = 4;
+
+const uint32 kMaxCodePoint = 0x10FFFF;
+const uint32 kReplacementCharacter = 0xFFFD;
+
+// Appends a wide string encoded in UTF-8. The 16-bit wide strings are
+// UTF-16: their surrogate pairs are combined.
+void AppendUtf8(const std::wstring& str, std::string* utf8) {
+  for (size_t i = 0; i < str.size(); ++i) {
+    uint32 c = static_cast<uint32>(str[i]);
+    if (sizeof(wchar_t) == 2) {
+      c &= 0xFFFF;
+      if (c >= 0xD800 && c <= 0xDBFF && i + 1 < str.size()) {
+        uint32 low = static_cast<uint32>(str[i + 1]) & 0xFFFF;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+          c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+          ++i;
+        }
+      }
+    }
+    if (c > kMaxCodePoint)
+      c = kReplacementCharacter;
+
+    if (c < 0x80) {
+      utf8->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+      utf8->push_back(static_cast<char>(0xC0 | (c >> 6)));
+      utf8->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+      utf8->push_back(static_cast<char>(0xE0 | (c >> 12)));
+      utf8->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+      utf8->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+      utf8->push_back(static_cast<char>(0xF0 | (c >> 18)));
+      utf8->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+      utf8->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+      utf8->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+  }
+}
+
+size_t PaddingSize(uint64 size) {
+  return static_cast<size_t>((8 - size % 8) % 8);
+}
+
+uint64 LoadUInt64(const char* data) {
+  uint64 value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// @returns true if the keys of a column differ from its values.
+bool NeedsKeyToValue(event::ValueType type) {
+  switch (type) {
+    case event::VALUE_CHAR:
+    case event::VALUE_SHORT:
+    case event::VALUE_INT:
+    case event::VALUE_LONG:
+    case event::VALUE_FLOAT:
+    case event::VALUE_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+ColumnarStoreWriter::ColumnarStoreWriter(std::ostream* out)
+    : out_(out),
+      offset_(0),
+      event_count_(0),
+      skipped_event_count_(0),
+      finished_(false) {
+  DCHECK(out != NULL);
+
+  ColumnarFileHeader header = {};
+  header.magic = kColumnarStoreMagic;
+  header.version = kColumnarStoreVersion;
+  Write(&header, sizeof(header));
+}
+
+ColumnarStoreWriter::~ColumnarStoreWriter() {
+  for (size_t i = 0; i < sections_.size(); ++i)
+    delete sections_[i];
+}
+
+void ColumnarStoreWriter::Receive(const event::Event& event) {
+  DCHECK(!finished_);
+
+  if (!kernel_event_.Parse(event)) {
+    ++skipped_event_count_;
+    return;
+  }
+
+  // Find the section of the event type with the fields of the event.
+  SectionList& candidates =
+      sections_by_type_[kernel_event_.category()][kernel_event_.operation()];
+  Section* section = NULL;
+  for (size_t i = candidates.size(); i > 0; --i) {
+    const std::vector<SchemaNode>& schema = candidates[i - 1]->schema;
+    size_t node = 0;
+    scalars_.clear();
+    if (MatchSchema(kernel_event_.content(), 0, schema, &node) &&
+        node == schema.size()) {
+      section = candidates[i - 1];
+      break;
+    }
+  }
+  if (section == NULL) {
+    scalars_.clear();
+    section = CreateSection(kernel_event_);
+    candidates.push_back(section);
+  }
+
+  std::vector<Column>& columns = section->columns;
+  columns[0].keys.push_back(kernel_event_.timestamp());
+  columns[1].keys.push_back(kernel_event_.process_id());
+  columns[2].keys.push_back(kernel_event_.thread_id());
+  columns[3].keys.push_back(kernel_event_.processor_number());
+  for (size_t i = 0; i < scalars_.size(); ++i)
+    columns[kHeaderColumnCount + i].keys.push_back(GetKey(scalars_[i]));
+
+  ++section->row_count;
+  ++event_count_;
+  if (columns[0].keys.size() == kColumnarBlockRows)
+    FlushBlock(section);
+}
+
+bool ColumnarStoreWriter::Finish() {
+  DCHECK(!finished_);
+  finished_ = true;
+
+  for (size_t i = 0; i < sections_.size(); ++i)
+    FlushBlock(sections_[i]);
+
+  // The dictionary.
+  ColumnarFileTrailer trailer = {};
+  trailer.dictionary_offset = offset_;
+  ColumnarDictionaryHeader dictionary_header = {};
+  dictionary_header.string_count = dictionary_.size();
+  Write(&dictionary_header, sizeof(dictionary_header));
+  const std::vector<uint64>& offsets = dictionary_.offsets();
+  Write(&offsets[0], offsets.size() * sizeof(offsets[0]));
+  const std::string& bytes = dictionary_.bytes();
+  Write(bytes.data(), bytes.size());
+  static const char kPadding[8] = {};
+  Write(kPadding, PaddingSize(bytes.size()));
+
+  // The directory.
+  trailer.directory_offset = offset_;
+  for (size_t i = 0; i < sections_.size(); ++i) {
+    const Section* section = sections_[i];
+    const std::vector<Column>& columns = section->columns;
+
+    ColumnarSectionHeader section_header = {};
+    section_header.category = section->category;
+    section_header.operation = section->operation;
+    section_header.column_count = static_cast<uint32>(columns.size());
+    section_header.block_count =
+        static_cast<uint32>(columns[0].blocks.size());
+    section_header.row_count = section->row_count;
+    Write(&section_header, sizeof(section_header));
+
+    for (size_t j = 0; j < columns.size(); ++j) {
+      ColumnarColumnHeader column_header = {};
+      column_header.name = columns[j].name;
+      column_header.type = static_cast<uint8>(columns[j].type);
+      Write(&column_header, sizeof(column_header));
+    }
+    for (size_t j = 0; j < columns.size(); ++j) {
+      const std::vector<ColumnarBlockHeader>& blocks = columns[j].blocks;
+      if (!blocks.empty())
+        Write(&blocks[0], blocks.size() * sizeof(blocks[0]));
+    }
+  }
+
+  trailer.section_count = static_cast<uint32>(sections_.size());
+  trailer.magic = kColumnarStoreMagic;
+  Write(&trailer, sizeof(trailer));
+
+  out_->flush();
+  return out_->good();
+}
+
+bool ColumnarStoreWriter::MatchSchema(const StructValue* content,
+                                      size_t depth,
+                                      const std::vector<SchemaNode>& schema,
+                                      size_t* node) {
+  DCHECK(content != NULL);
+  DCHECK(node != NULL);
+
+  StructValue::const_iterator it = content->fields_begin();
+  for (; it != content->fields_end(); ++it) {
+    if (*node == schema.size())
+      return false;
+    const SchemaNode& expected = schema[*node];
+    const Value* value = it->second;
+    if (expected.depth != depth ||
+        expected.type != value->GetType() ||
+        expected.name.size() != it->first.size() ||
+        expected.name.compare(0, expected.name.size(),
+                              it->first.data(), it->first.size()) != 0) {
+      return false;
+    }
+    ++*node;
+
+    if (StructValue::InstanceOf(value)) {
+      if (!MatchSchema(StructValue::Cast(value), depth + 1, schema, node))
+        return false;
+    } else if (value->IsScalar()) {
+      scalars_.push_back(value);
+    }
+  }
+
+  return true;
+}
+
+ColumnarStoreWriter::Section* ColumnarStoreWriter::CreateSection(
+    const KernelEvent& kernel_event) {
+  scoped_ptr<Section> section(new Section());
+  section->category = dictionary_.Intern(kernel_event.category());
+  section->operation = dictionary_.Intern(kernel_event.operation());
+  section->row_count = 0;
+
+  for (size_t i = 0; i < kHeaderColumnCount; ++i)
+    AddColumn(kHeaderColumns[i], kHeaderColumnTypes[i], section.get());
+  AddSchema(kernel_event.content(), kContentPrefix, 0, section.get());
+
+  sections_.push_back(section.release());
+  return sections_.back();
+}
+
+void ColumnarStoreWriter::AddSchema(const StructValue* content,
+                                    const std::string& prefix,
+                                    size_t depth,
+                                    Section* section) {
+  DCHECK(content != NULL);
+  DCHECK(section != NULL);
+
+  StructValue::const_iterator it = content->fields_begin();
+  for (; it != content->fields_end(); ++it) {
+    const Value* value = it->second;
+    SchemaNode node;
+    node.name.assign(it->first.data(), it->first.size());
+    node.type = value->GetType();
+    node.depth = depth;
+    section->schema.push_back(node);
+
+    std::string name = prefix + node.name;
+    if (StructValue::InstanceOf(value)) {
+      AddSchema(StructValue::Cast(value), name + ".", depth + 1, section);
+    } else if (value->IsScalar()) {
+      AddColumn(name, node.type, section);
+      scalars_.push_back(value);
+    }
+  }
+}
+
+void ColumnarStoreWriter::AddColumn(const std::string& name,
+                                    event::ValueType type,
+                                    Section* section) {
+  DCHECK(IsColumnarType(type));
+  DCHECK(section != NULL);
+
+  section->columns.push_back(Column());
+  Column& column = section->columns.back();
+  column.name = dictionary_.Intern(name);
+  column.type = type;
+  column.keys.reserve(kColumnarBlockRows);
+}
+
+uint64 ColumnarStoreWriter::GetKey(const Value* value) {
+  DCHECK(value != NULL);
+
+  if (StringValue::InstanceOf(value))
+    return dictionary_.Intern(StringValue::GetValue(value));
+
+  if (WStringValue::InstanceOf(value)) {
+    utf8_.clear();
+    AppendUtf8(WStringValue::GetValue(value), &utf8_);
+    return dictionary_.Intern(utf8_);
+  }
+
+  return ColumnValueToKey(value->GetType(), GetColumnValue(value));
+}
+
+void ColumnarStoreWriter::FlushBlock(Section* section) {
+  DCHECK(section != NULL);
+
+  std::vector<Column>& columns = section->columns;
+  size_t count = columns[0].keys.size();
+  if (count == 0)
+    return;
+
+  for (size_t i = 0; i < columns.size(); ++i) {
+    Column& column = columns[i];
+    DCHECK_EQ(count, column.keys.size());
+
+    ColumnarBlockHeader header = {};
+    data_.clear();
+    EncodeColumnarBlock(&column.keys[0], count, &header, &data_);
+    header.offset = offset_;
+    Write(data_.data(), data_.size());
+
+    column.blocks.push_back(header);
+    column.keys.clear();
+  }
+}
+
+void ColumnarStoreWriter::Write(const void* data, size_t size) {
+  if (size == 0)
+    return;
+  out_->write(static_cast<const char*>(data), size);
+  offset_ += size;
+}
+
+ColumnarStoreReader::ColumnarStoreReader()
+    : length_(0),
+      data_(NULL),
+      compressed_(false),
+      window_offset_(0),
+      string_count_(0),
+      string_offsets_(NULL),
+      string_bytes_(NULL),
+      string_bytes_size_(0) {
+}
+
+bool ColumnarStoreReader::Open(const std::string& path) {
+  sections_.clear();
+  string_count_ = 0;
+  string_offsets_ = NULL;
+  string_bytes_ = NULL;
+  string_bytes_size_ = 0;
+
+  length_ = 0;
+  data_ = NULL;
+  compressed_ = false;
+  directory_.clear();
+  window_.clear();
+  window_offset_ = 0;
+
+  if (!file_.Open(path))
+    return false;
+
+  if (base::IsCompressedFile(file_.data(), file_.length())) {
+    file_.Close();
+    if (!compressed_file_.Open(path))
+      return false;
+    compressed_ = true;
+    length_ = compressed_file_.length();
+  } else {
+    data_ = file_.data();
+    length_ = file_.length();
+  }
+  if (length_ < sizeof(ColumnarFileHeader) + sizeof(ColumnarFileTrailer))
+    return false;
+
+  ColumnarFileHeader header;
+  const char* bytes = GetRange(0, sizeof(header));
+  if (bytes == NULL)
+    return false;
+  memcpy(&header, bytes, sizeof(header));
+  if (header.magic != kColumnarStoreMagic ||
+      header.version != kColumnarStoreVersion) {
+    return false;
+  }
+
+  ColumnarFileTrailer trailer;
+  bytes = GetRange(length_ - sizeof(trailer), sizeof(trailer));
+  if (bytes == NULL)
+    return false;
+  memcpy(&trailer, bytes, sizeof(trailer));
+  if (trailer.magic != kColumnarStoreMagic)
+    return false;
+
+  // The dictionary and the directory of a compressed store are decompressed
+  // once: the strings and the block headers point into them.
+  const char* data = data_;
+  uint64 data_offset = 0;
+  if (compressed_) {
+    uint64 dictionary_offset = trailer.dictionary_offset;
+    if (dictionary_offset < sizeof(ColumnarFileHeader) ||
+        dictionary_offset > length_ - sizeof(trailer) ||
+        length_ - dictionary_offset >
+            static_cast<uint64>(static_cast<size_t>(-1)) ||
+        !compressed_file_.ReadBlocks(
+            dictionary_offset,
+            static_cast<size_t>(length_ - dictionary_offset), &directory_,
+            &data_offset) ||
+        data_offset + directory_.size() != length_) {
+      return false;
+    }
+    data = directory_.data();
+  }
+
+  if (!ReadDirectory(data, data_offset, trailer.dictionary_offset,
+                     trailer.directory_offset, trailer.section_count)) {
+    sections_.clear();
+    string_count_ = 0;
+    string_offsets_ = NULL;
+    string_bytes_ = NULL;
+    string_bytes_size_ = 0;
+    return false;
+  }
+
+  return true;
+}
+
+bool ColumnarStoreReader::FindColumn(size_t section,
+                                     const std::string& name,
+                                     size_t* column) const {
+  DCHECK_LT(section, sections_.size());
+  DCHECK(column != NULL);
+
+  const std::vector<Column>& columns = sections_[section].columns;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (columns[i].name == name) {
+      *column = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ColumnarStoreReader::GetBlockHeader(size_t section,
+                                         size_t column,
+                                         size_t block,
+                                         ColumnarBlockHeader* header) const {
+  DCHECK_LT(section, sections_.size());
+  DCHECK_LT(column, sections_[section].columns.size());
+  DCHECK_LT(block, sections_[section].block_count);
+  DCHECK(header != NULL);
+
+  const Section& s = sections_[section];
+  size_t index = column * s.block_count + block;
+  memcpy(header, s.blocks + index * sizeof(*header), sizeof(*header));
+}
+
+size_t ColumnarStoreReader::GetBlockRowCount(size_t section,
+                                             size_t block) const {
+  DCHECK_LT(section, sections_.size());
+  DCHECK_LT(block, sections_[section].block_count);
+
+  const Section& s = sections_[section];
+  if (block + 1 < s.block_count)
+    return kColumnarBlockRows;
+  return static_cast<size_t>(
+      s.row_count - static_cast<uint64>(block) * kColumnarBlockRows);
+}
+
+bool ColumnarStoreReader::BlockMayContain(size_t section,
+                                          size_t column,
+                                          size_t block,
+                                          uint64 min_value,
+                                          uint64 max_value) const {
+  ColumnarBlockHeader header;
+  GetBlockHeader(section, column, block, &header);
+
+  event::ValueType type = sections_[section].columns[column].type;
+  return header.max_key >= ColumnValueToKey(type, min_value) &&
+         header.min_key <= ColumnValueToKey(type, max_value);
+}
+
+bool ColumnarStoreReader::ReadBlock(size_t section,
+                                    size_t column,
+                                    size_t block,
+                                    uint64* values,
+                                    size_t* count) const {
+  DCHECK(values != NULL);
+  DCHECK(count != NULL);
+
+  ColumnarBlockHeader header;
+  GetBlockHeader(section, column, block, &header);
+  size_t row_count = GetBlockRowCount(section, block);
+
+  if (header.offset < sizeof(ColumnarFileHeader) ||
+      header.offset > length_ ||
+      header.size > length_ - header.offset) {
+    return false;
+  }
+  const char* data = GetRange(header.offset, header.size);
+  if (data == NULL || !DecodeColumnarBlock(header, data, row_count, values))
+    return false;
+
+  event::ValueType type = sections_[section].columns[column].type;
+  if (NeedsKeyToValue(type)) {
+    for (size_t i = 0; i < row_count; ++i)
+      values[i] = ColumnKeyToValue(type, values[i]);
+  }
+
+  *count = row_count;
+  return true;
+}
+
+bool ColumnarStoreReader::GetString(uint64 id, std::string* str) const {
+  DCHECK(str != NULL);
+
+  if (id >= string_count_)
+    return false;
+
+  size_t index = static_cast<size_t>(id);
+  uint64 begin = LoadUInt64(string_offsets_ + index * sizeof(uint64));
+  uint64 end = LoadUInt64(string_offsets_ + (index + 1) * sizeof(uint64));
+  if (begin > end || end > string_bytes_size_)
+    return false;
+
+  str->assign(string_bytes_ + begin, static_cast<size_t>(end - begin));
+  return true;
+}
+
+bool ColumnarStoreReader::FindString(const std::string& str,
+                                     uint64* id) const {
+  DCHECK(id != NULL);
+
+  uint64 begin = 0;
+  for (uint64 i = 0; i < string_count_; ++i) {
+    size_t index = static_cast<size_t>(i);
+    uint64 end = LoadUInt64(string_offsets_ + (index + 1) * sizeof(uint64));
+    if (begin <= end && end <= string_bytes_size_ &&
+        end - begin == str.size() &&
+        memcmp(string_bytes_ + begin, str.data(), str.size()) == 0) {
+      *id = i;
+      return true;
+    }
+    begin = end;
+  }
+  return false;
+}
+
+bool ColumnarStoreReader::ReadDirectory(const char* data,
+                                        uint64 data_offset,
+                                        uint64 dictionary_offset,
+                                        uint64 directory_offset,
+                                        uint32 section_count) {
+  DCHECK(data != NULL);
+  uint64 end = length_ - sizeof(ColumnarFileTrailer);
+
+  // The dictionary.
+  if (dictionary_offset < sizeof(ColumnarFileHeader) ||
+      dictionary_offset < data_offset ||
+      dictionary_offset > directory_offset || directory_offset > end ||
+      directory_offset - dictionary_offset <
+          sizeof(ColumnarDictionaryHeader)) {
+    return false;
+  }
+  ColumnarDictionaryHeader dictionary_header;
+  memcpy(&dictionary_header,
+         data + static_cast<size_t>(dictionary_offset - data_offset),
+         sizeof(dictionary_header));
+  uint64 position = dictionary_offset + sizeof(dictionary_header);
+  uint64 string_count = dictionary_header.string_count;
+  if (string_count >= (directory_offset - position) / sizeof(uint64))
+    return false;
+
+  string_count_ = string_count;
+  string_offsets_ = data + static_cast<size_t>(position - data_offset);
+  position += (string_count + 1) * sizeof(uint64);
+  string_bytes_ = data + static_cast<size_t>(position - data_offset);
+  string_bytes_size_ = LoadUInt64(
+      string_offsets_ + static_cast<size_t>(string_count) * sizeof(uint64));
+  if (string_bytes_size_ > directory_offset - position)
+    return false;
+
+  // The sections. Each one has at least a header: bound the count by the size
+  // of the directory before allocating the sections.
+  position = directory_offset;
+  if (section_count > (end - position) / sizeof(ColumnarSectionHeader))
+    return false;
+  sections_.resize(section_count);
+  for (size_t i = 0; i < section_count; ++i) {
+    Section& section = sections_[i];
+
+    ColumnarSectionHeader section_header;
+    if (end - position < sizeof(section_header))
+      return false;
+    memcpy(&section_header, data + static_cast<size_t>(position - data_offset),
+           sizeof(section_header));
+    position += sizeof(section_header);
+
+    if (!GetString(section_header.category, &section.category) ||
+        !GetString(section_header.operation, &section.operation)) {
+      return false;
+    }
+
+    // Each block but the last one is full.
+    uint64 block_count = section_header.block_count;
+    uint64 row_count = section_header.row_count;
+    uint64 max_rows = block_count * kColumnarBlockRows;
+    if (row_count > max_rows ||
+        (block_count != 0 && row_count <= max_rows - kColumnarBlockRows)) {
+      return false;
+    }
+    section.row_count = row_count;
+    section.block_count = static_cast<size_t>(block_count);
+
+    uint64 column_count = section_header.column_count;
+    if (column_count > (end - position) / sizeof(ColumnarColumnHeader))
+      return false;
+    section.columns.resize(static_cast<size_t>(column_count));
+    for (size_t j = 0; j < section.columns.size(); ++j) {
+      ColumnarColumnHeader column_header;
+      memcpy(&column_header,
+             data + static_cast<size_t>(position - data_offset),
+             sizeof(column_header));
+      position += sizeof(column_header);
+
+      Column& column = section.columns[j];
+      if (!GetString(column_header.name, &column.name) ||
+          column_header.type > event::VALUE_WSTRING) {
+        return false;
+      }
+      column.type = static_cast<event::ValueType>(column_header.type);
+    }
+
+    // Both counts are 32-bit: their product can't overflow.
+    uint64 header_count = column_count * block_count;
+    if (header_count > (end - position) / sizeof(ColumnarBlockHeader))
+      return false;
+    section.blocks = data + static_cast<size_t>(position - data_offset);
+    position += header_count * sizeof(ColumnarBlockHeader);
+  }
+
+  return true;
+}
+
+const char* ColumnarStoreReader::GetRange(uint64 offset, size_t length) const {
+  if (offset > length_ || length > length_ - offset)
+    return NULL;
+  if (!compressed_)
+    return data_ + static_cast<size_t>(offset);
+
+  if (window_.empty() || offset < window_offset_ ||
+      offset - window_offset_ > window_.size() ||
+      length > window_.size() - (offset - window_offset_)) {
+    size_t window_length = std::max(
+        length, kColumnarWindowBlocks * compressed_file_.block_size());
+    if (!compressed_file_.ReadBlocks(offset, window_length, &window_,
+                                     &window_offset_)) {
+      window_.clear();
+      return NULL;
+    }
+  }
+  return window_.data() + static_cast<size_t>(offset - window_offset_);
+}
+
+}  // namespace analysis
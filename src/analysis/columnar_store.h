@@ -0,0 +1,426 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A columnar trace store keeps the events of a trace in an on-disk format
+// suited to repeated analyses: each event type is a section, and each field
+// of the type is a column that can be scanned without reading the others.
+//
+// The events are received from the parser, with the layout of KernelEvent.
+// A section holds the events of a category and an operation whose decoded
+// payloads have the same fields: its schema is taken from the first event,
+// so it follows the kernel decoder schemas. The columns are named by their
+// path in the payload of an event:
+//
+//   timestamp, process_id, thread_id, processor_number,
+//   content.NewThreadId, content.OldThreadId, ...
+//
+// Nested structures are flattened. Arrays, such as stacks, are not stored.
+// The strings are replaced by identifiers in a dictionary shared by every
+// column, so that repeated file names, image names and registry keys are
+// stored once. The wide strings are stored in UTF-8.
+//
+// The columns are encoded in blocks of kColumnarBlockRows rows (see
+// columnar_encoding.h). The directory keeps the minimum and the maximum of
+// each block, so that a scan can skip the blocks that can't match a
+// predicate.
+//
+// File layout, all integers little-endian:
+//   ColumnarFileHeader
+//   The data of the blocks, each aligned on 8 bytes.
+//   The dictionary: a ColumnarDictionaryHeader, the offset of each string in
+//     the string bytes, followed by their total size, then the string bytes.
+//   The directory, for each section: a ColumnarSectionHeader, a
+//     ColumnarColumnHeader per column, then the ColumnarBlockHeader of each
+//     block, column by column.
+//   ColumnarFileTrailer
+//
+// Usage example:
+//   std::ofstream out("trace.ltcs", std::ios::binary);
+//   ColumnarStoreWriter writer(&out);
+//   parser.Parse(base::MakeObserver(&writer, &ColumnarStoreWriter::Receive));
+//   writer.Finish();
+//
+//   ColumnarStoreReader reader;
+//   reader.Open("trace.ltcs");
+//   size_t column = 0;
+//   if (reader.FindColumn(section, "content.NewThreadId", &column)) {
+//     std::vector<uint64> values(kColumnarBlockRows);
+//     for (size_t block = 0; block < reader.block_count(section); ++block) {
+//       size_t count = 0;
+//       reader.ReadBlock(section, column, block, &values[0], &count);
+//       ...
+//     }
+//   }
+
+#ifndef ANALYSIS_COLUMNAR_STORE_H_
+#define ANALYSIS_COLUMNAR_STORE_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "analysis/columnar_encoding.h"
+#include "analysis/kernel_event.h"
+#include "base/base.h"
+#include "base/compressed_file.h"
+#include "base/memory_mapped_file.h"
+#include "event/event.h"
+#include "event/value.h"
+
+namespace analysis {
+
+// The first bytes of a store file: "LTCS".
+const uint32 kColumnarStoreMagic = 0x5343544C;
+
+// The version of the format written by ColumnarStoreWriter.
+const uint32 kColumnarStoreVersion = 1;
+
+#pragma pack(push, 1)
+
+struct ColumnarFileHeader {
+  uint32 magic;
+  uint32 version;
+  uint64 reserved;
+};
+
+struct ColumnarDictionaryHeader {
+  uint64 string_count;
+};
+
+struct ColumnarSectionHeader {
+  // The dictionary identifiers of the category and the operation.
+  uint32 category;
+  uint32 operation;
+  uint32 column_count;
+  uint32 block_count;
+  uint64 row_count;
+};
+
+struct ColumnarColumnHeader {
+  // The dictionary identifier of the name of the column.
+  uint32 name;
+  // The event::ValueType of the values of the column.
+  uint8 type;
+  uint8 reserved[3];
+};
+
+struct ColumnarFileTrailer {
+  uint64 dictionary_offset;
+  uint64 directory_offset;
+  uint32 section_count;
+  uint32 magic;
+};
+
+#pragma pack(pop)
+
+COMPILE_ASSERT(sizeof(ColumnarFileHeader) == 16,
+               columnar_file_header_must_be_16_bytes);
+COMPILE_ASSERT(sizeof(ColumnarSectionHeader) == 24,
+               columnar_section_header_must_be_24_bytes);
+COMPILE_ASSERT(sizeof(ColumnarColumnHeader) == 8,
+               columnar_column_header_must_be_8_bytes);
+COMPILE_ASSERT(sizeof(ColumnarFileTrailer) == 24,
+               columnar_file_trailer_must_be_24_bytes);
+
+// Writes the events of a trace to a columnar store file. The rows of a block
+// are buffered until the block is full, then encoded and written: the memory
+// used grows with the number of sections and of blocks, not of events.
+class ColumnarStoreWriter {
+ public:
+  // Writes the file header.
+  // @param out the binary stream to write to. Must outlive the writer.
+  explicit ColumnarStoreWriter(std::ostream* out);
+  ~ColumnarStoreWriter();
+
+  // Stores an event of the parser. The events without the layout of
+  // KernelEvent are skipped.
+  // @param event the event to store.
+  void Receive(const event::Event& event);
+
+  // Writes the partial blocks, the dictionary and the directory. No event can
+  // be stored afterwards.
+  // @returns true on success, false if the stream failed.
+  bool Finish();
+
+  // @returns the number of events stored.
+  uint64 event_count() const { return event_count_; }
+
+  // @returns the number of events skipped.
+  uint64 skipped_event_count() const { return skipped_event_count_; }
+
+  // @returns the number of sections created.
+  size_t section_count() const { return sections_.size(); }
+
+ private:
+  // A node of the schema of a section: a field of the payload, in pre-order.
+  struct SchemaNode {
+    std::string name;
+    event::ValueType type;
+    size_t depth;
+  };
+
+  struct Column {
+    uint32 name;
+    event::ValueType type;
+    // The keys of the rows of the current block.
+    std::vector<uint64> keys;
+    std::vector<ColumnarBlockHeader> blocks;
+  };
+
+  struct Section {
+    uint32 category;
+    uint32 operation;
+    uint64 row_count;
+    std::vector<SchemaNode> schema;
+    std::vector<Column> columns;
+  };
+
+  typedef std::vector<Section*> SectionList;
+  typedef std::map<std::string, SectionList> OperationMap;
+  typedef std::map<std::string, OperationMap> CategoryMap;
+
+  // Walks the content of an event along the schema of a section, and
+  // gathers its scalars in |scalars_|.
+  // @returns true if the fields of |content| follow |schema| from |*node|.
+  bool MatchSchema(const event::StructValue* content,
+                   size_t depth,
+                   const std::vector<SchemaNode>& schema,
+                   size_t* node);
+
+  // Creates a section with the schema of |content|.
+  Section* CreateSection(const KernelEvent& kernel_event);
+
+  // Adds the nodes and the columns of the fields of |content|.
+  void AddSchema(const event::StructValue* content,
+                 const std::string& prefix,
+                 size_t depth,
+                 Section* section);
+
+  // Adds a column to a section.
+  void AddColumn(const std::string& name,
+                 event::ValueType type,
+                 Section* section);
+
+  // @returns the key of a scalar of the content of an event.
+  uint64 GetKey(const event::Value* value);
+
+  // Encodes and writes the current block of each column of a section.
+  void FlushBlock(Section* section);
+
+  void Write(const void* data, size_t size);
+
+  std::ostream* out_;
+  uint64 offset_;
+
+  std::vector<Section*> sections_;
+  CategoryMap sections_by_type_;
+  ColumnarDictionary dictionary_;
+
+  // Reused buffers.
+  KernelEvent kernel_event_;
+  std::vector<const event::Value*> scalars_;
+  std::string utf8_;
+  std::string data_;
+
+  uint64 event_count_;
+  uint64 skipped_event_count_;
+  bool finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnarStoreWriter);
+};
+
+// Reads a columnar store file. The file is mapped: the blocks of a column
+// are read on demand, and the other columns are not touched. The dictionary
+// and the directory of a compressed store (see base/compressed_file.h) are
+// decompressed when it is opened; its blocks are decompressed on demand,
+// through a window moved over the store.
+class ColumnarStoreReader {
+ public:
+  struct Column {
+    std::string name;
+    event::ValueType type;
+  };
+
+  ColumnarStoreReader();
+
+  // Opens and validates a store file.
+  // @param path the path of the file.
+  // @returns true on success, false if the file is missing or invalid.
+  bool Open(const std::string& path);
+
+  // @returns the number of sections of the store.
+  size_t section_count() const { return sections_.size(); }
+
+  // Accessors of a section.
+  // @param section the index of a section.
+  // @{
+  const std::string& category(size_t section) const {
+    return sections_[section].category;
+  }
+  const std::string& operation(size_t section) const {
+    return sections_[section].operation;
+  }
+  uint64 row_count(size_t section) const {
+    return sections_[section].row_count;
+  }
+  size_t block_count(size_t section) const {
+    return sections_[section].block_count;
+  }
+  const std::vector<Column>& columns(size_t section) const {
+    return sections_[section].columns;
+  }
+  // @}
+
+  // Finds a column by name.
+  // @param section the index of a section.
+  // @param name the name of the column.
+  // @param column receives the index of the column.
+  // @returns true if the section has a column named |name|.
+  bool FindColumn(size_t section,
+                  const std::string& name,
+                  size_t* column) const;
+
+  // Gets the header of a block, which holds its statistics.
+  // @param section the index of a section.
+  // @param column the index of a column of |section|.
+  // @param block the index of a block of |section|.
+  // @param header receives the header of the block.
+  void GetBlockHeader(size_t section,
+                      size_t column,
+                      size_t block,
+                      ColumnarBlockHeader* header) const;
+
+  // @param section the index of a section.
+  // @param block the index of a block of |section|.
+  // @returns the number of rows of the block.
+  size_t GetBlockRowCount(size_t section, size_t block) const;
+
+  // Checks the statistics of a block against a range of values. The string
+  // identifiers don't sort like their strings: for a string column, only pass
+  // the identifier of a single string as both bounds.
+  // @param section the index of a section.
+  // @param column the index of a column of |section|.
+  // @param block the index of a block of |section|.
+  // @param min_value the smallest value of the range.
+  // @param max_value the largest value of the range.
+  // @returns false if no row of the block has a value in the range.
+  bool BlockMayContain(size_t section,
+                       size_t column,
+                       size_t block,
+                       uint64 min_value,
+                       uint64 max_value) const;
+
+  // Decodes the values of a block of a column. The values of a column are
+  // unsigned integers, the bits of signed integers, the bits of doubles (see
+  // ColumnValueToDouble) or string identifiers (see GetString).
+  // @param section the index of a section.
+  // @param column the index of a column of |section|.
+  // @param block the index of a block of |section|.
+  // @param values receives the values. Must hold kColumnarBlockRows values.
+  // @param count receives the number of values.
+  // @returns true on success, false if the block is corrupted.
+  // @note The reads of a compressed store share its window: they must not
+  //     run concurrently.
+  bool ReadBlock(size_t section,
+                 size_t column,
+                 size_t block,
+                 uint64* values,
+                 size_t* count) const;
+
+  // @returns the number of strings of the dictionary.
+  size_t string_count() const { return string_count_; }
+
+  // Gets a string of the dictionary.
+  // @param id the identifier of the string.
+  // @param str receives the string.
+  // @returns true on success, false if |id| is unknown.
+  bool GetString(uint64 id, std::string* str) const;
+
+  // Finds the identifier of a string, e.g. to compare it with the values of a
+  // column. The dictionary is searched linearly.
+  // @param str the string to find.
+  // @param id receives the identifier of |str|.
+  // @returns true if the dictionary holds |str|.
+  bool FindString(const std::string& str, uint64* id) const;
+
+ private:
+  struct Section {
+    std::string category;
+    std::string operation;
+    uint64 row_count;
+    size_t block_count;
+    std::vector<Column> columns;
+    // The block headers, column by column, in the directory.
+    const char* blocks;
+  };
+
+  // Reads the dictionary and the directory.
+  // @param data the bytes of the store from |data_offset| to its end. The
+  //     strings and the block headers point into them.
+  // @param data_offset the offset of |data| in the store.
+  bool ReadDirectory(const char* data,
+                     uint64 data_offset,
+                     uint64 dictionary_offset,
+                     uint64 directory_offset,
+                     uint32 section_count);
+
+  // Gets a range of the store. The blocks of a compressed store are
+  // decompressed in the window, unless it holds the range already.
+  // @param offset the offset of the range.
+  // @param length the length of the range.
+  // @returns the bytes of the range, valid until the next call, or NULL if
+  //     they can't be read.
+  const char* GetRange(uint64 offset, size_t length) const;
+
+  // The length of the store, decompressed.
+  uint64 length_;
+
+  // The mapping of an uncompressed store.
+  base::MemoryMappedFile file_;
+  const char* data_;
+
+  // A compressed store: its dictionary and directory, decompressed in
+  // |directory_|, and the window over its blocks.
+  bool compressed_;
+  base::CompressedFileReader compressed_file_;
+  std::string directory_;
+  mutable std::string window_;
+  mutable uint64 window_offset_;
+
+  std::vector<Section> sections_;
+
+  uint64 string_count_;
+  // The offsets of the strings and their bytes, in the directory.
+  const char* string_offsets_;
+  const char* string_bytes_;
+  uint64 string_bytes_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColumnarStoreReader);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_COLUMNAR_STORE_H_
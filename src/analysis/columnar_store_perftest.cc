@@ -0,0 +1,106 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "analysis/columnar_store.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+
+const char kTempFile[] = "columnar_store_perftest.ltcs";
+
+const size_t kEvents = 2000000;
+const size_t kThreads = 500;
+const size_t kProcessors = 8;
+const size_t kScans = 20;
+
+}  // namespace
+
+TEST(ColumnarStorePerfTest, WriteAndScan) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    ColumnarStoreWriter writer(&out);
+
+    // The measure includes the creation of the events.
+    base::PerfTimer timer;
+    for (size_t i = 0; i < kEvents; ++i) {
+      scoped_ptr<StructValue> content(new StructValue());
+      content->AddField<UIntValue>("NewThreadId",
+                                   static_cast<uint32>((i % kThreads) * 4));
+      content->AddField<UIntValue>(
+          "OldThreadId", static_cast<uint32>(((i + 7) % kThreads) * 4));
+      writer.Receive(*CreateKernelEvent(
+          i * 13, "Thread", "CSwitch", 0, 0,
+          static_cast<uint32>(i % kProcessors), content.Pass()).get());
+    }
+    EXPECT_TRUE(writer.Finish());
+    base::PrintPerfResult("ColumnarStoreWriter", "time",
+                          timer.ElapsedNanoseconds(), kEvents, "ns/event");
+    EXPECT_EQ(kEvents, writer.event_count());
+  }
+
+  ColumnarStoreReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  ASSERT_EQ(1U, reader.section_count());
+  size_t column = 0;
+  ASSERT_TRUE(reader.FindColumn(0, "content.NewThreadId", &column));
+
+  std::vector<uint64> values(kColumnarBlockRows);
+  uint64 sum = 0;
+  base::PerfTimer timer;
+  for (size_t scan = 0; scan < kScans; ++scan) {
+    for (size_t block = 0; block < reader.block_count(0); ++block) {
+      size_t count = 0;
+      ASSERT_TRUE(reader.ReadBlock(0, column, block, &values[0], &count));
+      for (size_t i = 0; i < count; ++i)
+        sum += values[i];
+    }
+  }
+  uint64 elapsed = timer.ElapsedNanoseconds();
+  base::PrintPerfResult("ColumnarStoreScan", "time", elapsed,
+                        kEvents * kScans, "ns/row");
+  // The throughput in decoded 64-bit values.
+  uint64 bytes = kEvents * kScans * sizeof(uint64);
+  base::PrintPerfResult("ColumnarStoreScan", "throughput", bytes,
+                        static_cast<size_t>(elapsed), "GB/s");
+
+  uint64 expected = 0;
+  for (size_t i = 0; i < kEvents; ++i)
+    expected += (i % kThreads) * 4;
+  EXPECT_EQ(expected * kScans, sum);
+
+  std::remove(kTempFile);
+}
+
+}  // namespace analysis
@@ -0,0 +1,392 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "analysis/columnar_store.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "base/compressed_file.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::ArrayValue;
+using event::CharValue;
+using event::DoubleValue;
+using event::StringValue;
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::Value;
+using event::WStringValue;
+
+const char kTempFile[] = "columnar_store_unittest.ltcs";
+
+scoped_ptr<event::Event> CreateContextSwitch(event::Timestamp timestamp,
+                                             uint32 processor,
+                                             uint32 old_thread_id,
+                                             uint32 new_thread_id,
+                                             int8 wait_reason) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("NewThreadId", new_thread_id);
+  content->AddField<UIntValue>("OldThreadId", old_thread_id);
+  content->AddField<CharValue>("OldThreadWaitReason", wait_reason);
+  return CreateKernelEvent(timestamp, "Thread", "CSwitch", 0, old_thread_id,
+                           processor, content.Pass());
+}
+
+scoped_ptr<event::Event> CreateFileCreate(event::Timestamp timestamp,
+                                          uint64 file_object,
+                                          const std::wstring& file_name) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("FileObject", file_object);
+  content->AddField<WStringValue>("OpenPath", file_name);
+  return CreateKernelEvent(timestamp, "FileIO", "Create", 4, 8, 1,
+                           content.Pass());
+}
+
+class ColumnarStoreTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  // Writes |events_| to the temporary file, then opens it with |reader_|.
+  void WriteAndOpen() {
+    {
+      std::ofstream out(kTempFile, std::ios::binary);
+      ColumnarStoreWriter writer(&out);
+      for (size_t i = 0; i < events_.size(); ++i)
+        writer.Receive(*events_[i]);
+      EXPECT_TRUE(writer.Finish());
+      event_count_ = writer.event_count();
+      skipped_event_count_ = writer.skipped_event_count();
+    }
+    ASSERT_TRUE(reader_.Open(kTempFile));
+  }
+
+  // Reads every value of a column.
+  void ReadColumn(size_t section,
+                  const std::string& name,
+                  std::vector<uint64>* values) {
+    size_t column = 0;
+    ASSERT_TRUE(reader_.FindColumn(section, name, &column));
+    std::vector<uint64> block(kColumnarBlockRows);
+    values->clear();
+    for (size_t i = 0; i < reader_.block_count(section); ++i) {
+      size_t count = 0;
+      ASSERT_TRUE(reader_.ReadBlock(section, column, i, &block[0], &count));
+      values->insert(values->end(), block.begin(), block.begin() + count);
+    }
+  }
+
+  std::string GetString(uint64 id) {
+    std::string str;
+    EXPECT_TRUE(reader_.GetString(id, &str));
+    return str;
+  }
+
+  void AddEvent(scoped_ptr<event::Event> event) {
+    events_.push_back(event.release());
+  }
+
+  virtual ~ColumnarStoreTest() {
+    for (size_t i = 0; i < events_.size(); ++i)
+      delete events_[i];
+  }
+
+  std::vector<event::Event*> events_;
+  uint64 event_count_;
+  uint64 skipped_event_count_;
+  ColumnarStoreReader reader_;
+};
+
+}  // namespace
+
+TEST_F(ColumnarStoreTest, Empty) {
+  WriteAndOpen();
+  EXPECT_EQ(0U, reader_.section_count());
+  EXPECT_EQ(0U, reader_.string_count());
+  EXPECT_EQ(0U, event_count_);
+}
+
+TEST_F(ColumnarStoreTest, Columns) {
+  AddEvent(CreateContextSwitch(100, 2, 10, 20, -1));
+  AddEvent(CreateContextSwitch(250, 3, 20, 0, 5));
+  AddEvent(CreateFileCreate(300, 0xFFFFFA8000001000ULL,
+                            L"C:\\Windows\\notepad.exe"));
+  AddEvent(CreateFileCreate(400, 0xFFFFFA8000002000ULL,
+                            L"C:\\caf\x00E9.txt"));
+  AddEvent(CreateFileCreate(500, 0xFFFFFA8000003000ULL,
+                            L"C:\\Windows\\notepad.exe"));
+  WriteAndOpen();
+
+  EXPECT_EQ(5U, event_count_);
+  ASSERT_EQ(2U, reader_.section_count());
+
+  EXPECT_EQ("Thread", reader_.category(0));
+  EXPECT_EQ("CSwitch", reader_.operation(0));
+  EXPECT_EQ(2U, reader_.row_count(0));
+  EXPECT_EQ(1U, reader_.block_count(0));
+  const std::vector<ColumnarStoreReader::Column>& columns =
+      reader_.columns(0);
+  ASSERT_EQ(7U, columns.size());
+  EXPECT_EQ("timestamp", columns[0].name);
+  EXPECT_EQ("processor_number", columns[3].name);
+  EXPECT_EQ("content.NewThreadId", columns[4].name);
+  EXPECT_EQ(event::VALUE_UINT, columns[4].type);
+  EXPECT_EQ("content.OldThreadWaitReason", columns[6].name);
+  EXPECT_EQ(event::VALUE_CHAR, columns[6].type);
+
+  std::vector<uint64> values;
+  ReadColumn(0, "timestamp", &values);
+  ASSERT_EQ(2U, values.size());
+  EXPECT_EQ(100U, values[0]);
+  EXPECT_EQ(250U, values[1]);
+  ReadColumn(0, "processor_number", &values);
+  EXPECT_EQ(2U, values[0]);
+  EXPECT_EQ(3U, values[1]);
+  ReadColumn(0, "content.NewThreadId", &values);
+  EXPECT_EQ(20U, values[0]);
+  EXPECT_EQ(0U, values[1]);
+  ReadColumn(0, "content.OldThreadWaitReason", &values);
+  EXPECT_EQ(-1, static_cast<int64>(values[0]));
+  EXPECT_EQ(5, static_cast<int64>(values[1]));
+
+  EXPECT_EQ("FileIO", reader_.category(1));
+  EXPECT_EQ("Create", reader_.operation(1));
+  ReadColumn(1, "content.FileObject", &values);
+  ASSERT_EQ(3U, values.size());
+  EXPECT_EQ(0xFFFFFA8000002000ULL, values[1]);
+
+  // The strings are stored once, in UTF-8.
+  ReadColumn(1, "content.OpenPath", &values);
+  ASSERT_EQ(3U, values.size());
+  EXPECT_EQ(values[0], values[2]);
+  EXPECT_NE(values[0], values[1]);
+  EXPECT_EQ("C:\\Windows\\notepad.exe", GetString(values[0]));
+  EXPECT_EQ("C:\\caf\xC3\xA9.txt", GetString(values[1]));
+
+  uint64 id = 0;
+  EXPECT_TRUE(reader_.FindString("C:\\Windows\\notepad.exe", &id));
+  EXPECT_EQ(values[0], id);
+  EXPECT_FALSE(reader_.FindString("C:\\Windows", &id));
+
+  size_t column = 0;
+  EXPECT_FALSE(reader_.FindColumn(1, "content.NewThreadId", &column));
+}
+
+TEST_F(ColumnarStoreTest, NestedFieldsAndArrays) {
+  scoped_ptr<StructValue> content(new StructValue());
+  scoped_ptr<StructValue> sid(new StructValue());
+  sid->AddField<ULongValue>("PSid", 0x1234);
+  sid->AddField<UIntValue>("Attributes", 7);
+  scoped_ptr<ArrayValue> stack(new ArrayValue());
+  stack->Append<ULongValue>(0xFFFF0000);
+  content->AddField("UserSID", sid.PassAs<Value>());
+  content->AddField("Stack", stack.PassAs<Value>());
+  content->AddField<DoubleValue>("Ratio", -0.25);
+  AddEvent(CreateKernelEvent(10, "Process", "Start", 1, 2, 0,
+                             content.Pass()));
+  WriteAndOpen();
+
+  ASSERT_EQ(1U, reader_.section_count());
+  const std::vector<ColumnarStoreReader::Column>& columns =
+      reader_.columns(0);
+  ASSERT_EQ(7U, columns.size());
+  EXPECT_EQ("content.UserSID.PSid", columns[4].name);
+  EXPECT_EQ("content.UserSID.Attributes", columns[5].name);
+  EXPECT_EQ("content.Ratio", columns[6].name);
+
+  std::vector<uint64> values;
+  ReadColumn(0, "content.UserSID.Attributes", &values);
+  EXPECT_EQ(7U, values[0]);
+  ReadColumn(0, "content.Ratio", &values);
+  EXPECT_EQ(-0.25, ColumnValueToDouble(values[0]));
+}
+
+TEST_F(ColumnarStoreTest, SectionPerSchema) {
+  AddEvent(CreateContextSwitch(100, 0, 10, 20, 0));
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("NewThreadId", 30);
+  AddEvent(CreateKernelEvent(200, "Thread", "CSwitch", 0, 0, 0,
+                             content.Pass()));
+  AddEvent(CreateContextSwitch(300, 0, 30, 10, 0));
+  WriteAndOpen();
+
+  ASSERT_EQ(2U, reader_.section_count());
+  EXPECT_EQ(2U, reader_.row_count(0));
+  EXPECT_EQ(1U, reader_.row_count(1));
+  EXPECT_EQ(5U, reader_.columns(1).size());
+
+  std::vector<uint64> values;
+  ReadColumn(0, "timestamp", &values);
+  EXPECT_EQ(100U, values[0]);
+  EXPECT_EQ(300U, values[1]);
+}
+
+TEST_F(ColumnarStoreTest, SkipEvents) {
+  scoped_ptr<Value> payload(new StringValue("not a kernel event"));
+  AddEvent(scoped_ptr<event::Event>(
+      new event::Event(1, payload.PassAs<const Value>())));
+  AddEvent(CreateContextSwitch(100, 0, 10, 20, 0));
+  WriteAndOpen();
+
+  EXPECT_EQ(1U, event_count_);
+  EXPECT_EQ(1U, skipped_event_count_);
+  EXPECT_EQ(1U, reader_.section_count());
+}
+
+TEST_F(ColumnarStoreTest, BlockStatistics) {
+  const size_t kEvents = 2 * kColumnarBlockRows + 10;
+  for (size_t i = 0; i < kEvents; ++i) {
+    // The thread 1000 only runs in the second block.
+    uint32 thread_id = i / kColumnarBlockRows == 1 && i % 128 == 0 ?
+        1000 : static_cast<uint32>(i % 16);
+    AddEvent(CreateContextSwitch(i * 10, static_cast<uint32>(i % 4), 1,
+                                 thread_id, 0));
+  }
+  WriteAndOpen();
+
+  ASSERT_EQ(1U, reader_.section_count());
+  EXPECT_EQ(kEvents, reader_.row_count(0));
+  ASSERT_EQ(3U, reader_.block_count(0));
+  EXPECT_EQ(kColumnarBlockRows, reader_.GetBlockRowCount(0, 0));
+  EXPECT_EQ(10U, reader_.GetBlockRowCount(0, 2));
+
+  size_t column = 0;
+  ASSERT_TRUE(reader_.FindColumn(0, "content.NewThreadId", &column));
+  EXPECT_FALSE(reader_.BlockMayContain(0, column, 0, 1000, 1000));
+  EXPECT_TRUE(reader_.BlockMayContain(0, column, 1, 1000, 1000));
+  EXPECT_FALSE(reader_.BlockMayContain(0, column, 2, 1000, 1000));
+  EXPECT_TRUE(reader_.BlockMayContain(0, column, 2, 0, 3));
+
+  // The increasing timestamps are delta-encoded.
+  ColumnarBlockHeader header;
+  reader_.GetBlockHeader(0, 0, 1, &header);
+  EXPECT_EQ(COLUMNAR_DELTA, header.encoding);
+  EXPECT_EQ(0, header.bit_width);
+
+  std::vector<uint64> values;
+  ReadColumn(0, "timestamp", &values);
+  ASSERT_EQ(kEvents, values.size());
+  for (size_t i = 0; i < kEvents; ++i)
+    ASSERT_EQ(i * 10, values[i]);
+  ReadColumn(0, "content.NewThreadId", &values);
+  EXPECT_EQ(1000U, values[kColumnarBlockRows]);
+  EXPECT_EQ(1U, values[kColumnarBlockRows + 1]);
+}
+
+TEST_F(ColumnarStoreTest, Compressed) {
+  const size_t kEvents = 3 * kColumnarBlockRows + 10;
+  for (size_t i = 0; i < kEvents; ++i) {
+    AddEvent(CreateContextSwitch(i * 10, static_cast<uint32>(i % 4), 1,
+                                 static_cast<uint32>(i % 16), 0));
+  }
+  {
+    // Small blocks, so that the window over the store moves.
+    std::ofstream file(kTempFile, std::ios::binary);
+    base::CompressingStreamBuffer buffer(&file, 4096);
+    std::ostream out(&buffer);
+    ColumnarStoreWriter writer(&out);
+    for (size_t i = 0; i < events_.size(); ++i)
+      writer.Receive(*events_[i]);
+    EXPECT_TRUE(writer.Finish());
+    EXPECT_TRUE(buffer.Finish());
+  }
+  ASSERT_TRUE(reader_.Open(kTempFile));
+
+  ASSERT_EQ(1U, reader_.section_count());
+  EXPECT_EQ(kEvents, reader_.row_count(0));
+  std::vector<uint64> values;
+  ReadColumn(0, "timestamp", &values);
+  ASSERT_EQ(kEvents, values.size());
+  for (size_t i = 0; i < kEvents; ++i)
+    ASSERT_EQ(i * 10, values[i]);
+  ReadColumn(0, "content.NewThreadId", &values);
+  ASSERT_EQ(kEvents, values.size());
+  for (size_t i = 0; i < kEvents; ++i)
+    ASSERT_EQ(i % 16, values[i]);
+
+  // The window over the blocks also moves backward.
+  size_t column = 0;
+  ASSERT_TRUE(reader_.FindColumn(0, "timestamp", &column));
+  std::vector<uint64> block(kColumnarBlockRows);
+  for (size_t i = reader_.block_count(0); i-- > 0; ) {
+    size_t count = 0;
+    ASSERT_TRUE(reader_.ReadBlock(0, column, i, &block[0], &count));
+    ASSERT_EQ(reader_.GetBlockRowCount(0, i), count);
+    EXPECT_EQ(i * kColumnarBlockRows * 10, block[0]);
+  }
+}
+
+TEST_F(ColumnarStoreTest, OpenInvalidFile) {
+  ColumnarStoreReader reader;
+  EXPECT_FALSE(reader.Open("missing_columnar_store.ltcs"));
+
+  AddEvent(CreateContextSwitch(100, 0, 10, 20, 0));
+  WriteAndOpen();
+
+  std::string contents;
+  {
+    std::ifstream in(kTempFile, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+  }
+
+  // A truncated file misses its trailer.
+  {
+    std::ofstream out(kTempFile, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 1);
+  }
+  EXPECT_FALSE(reader.Open(kTempFile));
+
+  // The directory must be within the file.
+  std::string corrupted = contents;
+  corrupted[corrupted.size() - 9] = '\x7F';
+  {
+    std::ofstream out(kTempFile, std::ios::binary | std::ios::trunc);
+    out.write(corrupted.data(), corrupted.size());
+  }
+  EXPECT_FALSE(reader.Open(kTempFile));
+  EXPECT_EQ(0U, reader.section_count());
+
+  // The sections must fit in the directory.
+  corrupted = contents;
+  corrupted.replace(corrupted.size() - 8, 4, "\xFF\xFF\xFF\xFF", 4);
+  {
+    std::ofstream out(kTempFile, std::ios::binary | std::ios::trunc);
+    out.write(corrupted.data(), corrupted.size());
+  }
+  EXPECT_FALSE(reader.Open(kTempFile));
+  EXPECT_EQ(0U, reader.section_count());
+}
+
+}  // namespace analysis
@@ -0,0 +1,100 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/field_path.h"
+
+namespace analysis {
+
+using event::ArrayValue;
+using event::StructValue;
+using event::Value;
+
+FieldPath::FieldPath(const std::string& path) : valid_(true) {
+  size_t pos = 0;
+  while (pos < path.size()) {
+    Segment segment;
+    segment.index = 0;
+
+    if (path[pos] == '[') {
+      size_t end = path.find(']', pos);
+      if (end == std::string::npos || end == pos + 1) {
+        valid_ = false;
+        return;
+      }
+      for (size_t i = pos + 1; i < end; ++i) {
+        if (path[i] < '0' || path[i] > '9') {
+          valid_ = false;
+          return;
+        }
+        segment.index = segment.index * 10 + (path[i] - '0');
+      }
+      pos = end + 1;
+    } else {
+      if (path[pos] == '.') {
+        if (segments_.empty()) {
+          valid_ = false;
+          return;
+        }
+        ++pos;
+      }
+      size_t end = path.find_first_of(".[", pos);
+      if (end == std::string::npos)
+        end = path.size();
+      if (end == pos) {
+        valid_ = false;
+        return;
+      }
+      segment.name = path.substr(pos, end - pos);
+      pos = end;
+    }
+
+    segments_.push_back(segment);
+  }
+}
+
+const Value* FieldPath::Get(const Value* root) const {
+  if (!valid_)
+    return NULL;
+
+  const Value* value = root;
+  for (size_t i = 0; i < segments_.size() && value != NULL; ++i) {
+    const Segment& segment = segments_[i];
+    if (segment.name.empty()) {
+      if (!ArrayValue::InstanceOf(value))
+        return NULL;
+      const ArrayValue* array = ArrayValue::Cast(value);
+      if (segment.index >= array->Length())
+        return NULL;
+      value = array->at(segment.index);
+    } else {
+      if (!StructValue::InstanceOf(value))
+        return NULL;
+      value = StructValue::Cast(value)->GetField(segment.name);
+    }
+  }
+  return value;
+}
+
+}  // namespace analysis
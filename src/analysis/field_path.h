@@ -0,0 +1,71 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A field path designates a value nested in structures and arrays, relative
+// to the payload of an event. The names of the fields are separated by dots
+// and the indexes of array elements are written between brackets:
+//
+//   FieldPath path("content.Stack[0]");
+//   const event::Value* frame = path.Get(event.payload());
+//
+// The path is parsed once, so a lookup costs one field search per segment.
+
+#ifndef ANALYSIS_FIELD_PATH_H_
+#define ANALYSIS_FIELD_PATH_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "event/value.h"
+
+namespace analysis {
+
+class FieldPath {
+ public:
+  // @param path the textual path. An empty path designates the root.
+  explicit FieldPath(const std::string& path);
+
+  // @returns true if the textual path was well formed.
+  bool IsValid() const { return valid_; }
+
+  // @param root the value the path is relative to.
+  // @returns the value designated by the path, or NULL if it doesn't exist.
+  const event::Value* Get(const event::Value* root) const;
+
+ private:
+  // A field name, or an array index when |name| is empty.
+  struct Segment {
+    std::string name;
+    size_t index;
+  };
+
+  std::vector<Segment> segments_;
+  bool valid_;
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_FIELD_PATH_H_
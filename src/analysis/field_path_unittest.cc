@@ -0,0 +1,79 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/field_path.h"
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+using event::ArrayValue;
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::Value;
+
+TEST(FieldPathTest, Get) {
+  scoped_ptr<ArrayValue> stack(new ArrayValue());
+  stack->Append<ULongValue>(0x1000);
+  stack->Append<ULongValue>(0x2000);
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("StackThread", 8);
+  content->AddField("Stack", stack.PassAs<Value>());
+  StructValue root;
+  root.AddField("content", content.PassAs<Value>());
+
+  uint64 value = 0;
+  const Value* thread = FieldPath("content.StackThread").Get(&root);
+  ASSERT_TRUE(thread != NULL);
+  EXPECT_TRUE(thread->GetAsULong(&value));
+  EXPECT_EQ(8U, value);
+
+  const Value* frame = FieldPath("content.Stack[1]").Get(&root);
+  ASSERT_TRUE(frame != NULL);
+  EXPECT_TRUE(frame->GetAsULong(&value));
+  EXPECT_EQ(0x2000U, value);
+
+  EXPECT_EQ(&root, FieldPath("").Get(&root));
+  EXPECT_EQ(NULL, FieldPath("content.Stack[2]").Get(&root));
+  EXPECT_EQ(NULL, FieldPath("content.Missing").Get(&root));
+  EXPECT_EQ(NULL, FieldPath("content[0]").Get(&root));
+  EXPECT_EQ(NULL, FieldPath("content.StackThread.Field").Get(&root));
+}
+
+TEST(FieldPathTest, Invalid) {
+  EXPECT_TRUE(FieldPath("a.b[0].c").IsValid());
+  EXPECT_FALSE(FieldPath(".a").IsValid());
+  EXPECT_FALSE(FieldPath("a..b").IsValid());
+  EXPECT_FALSE(FieldPath("a[]").IsValid());
+  EXPECT_FALSE(FieldPath("a[1").IsValid());
+  EXPECT_FALSE(FieldPath("a[x]").IsValid());
+  EXPECT_FALSE(FieldPath("a.").IsValid());
+
+  StructValue root;
+  EXPECT_EQ(NULL, FieldPath("a[]").Get(&root));
+}
+
+}  // namespace analysis
@@ -0,0 +1,293 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/flow_aggregator.h"
+
+#include "analysis/kernel_event.h"
+#include "base/hash.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::Timestamp;
+
+// The initial number of slots of the hash table.
+const size_t kInitialSlotCount = 1024;
+
+// The maximal number of buckets of a throughput series. Bounds the memory
+// used when a timestamp is corrupted.
+const size_t kMaxBuckets = 1 << 20;
+
+// Writes an IPv4 address stored in network byte order.
+void WriteAddress(uint32 address, std::ostream* out) {
+  const uint8* bytes = reinterpret_cast<const uint8*>(&address);
+  *out << static_cast<uint32>(bytes[0]) << '.'
+       << static_cast<uint32>(bytes[1]) << '.'
+       << static_cast<uint32>(bytes[2]) << '.'
+       << static_cast<uint32>(bytes[3]);
+}
+
+// Converts a port stored in network byte order.
+uint32 PortToHost(uint16 port) {
+  const uint8* bytes = reinterpret_cast<const uint8*>(&port);
+  return (static_cast<uint32>(bytes[0]) << 8) | bytes[1];
+}
+
+void AddTraffic(const FlowAggregator::Packet& packet,
+                FlowAggregator::Traffic* traffic) {
+  switch (packet.operation) {
+    case FlowAggregator::OPERATION_SEND:
+      traffic->bytes_sent += packet.size;
+      ++traffic->packets_sent;
+      break;
+    case FlowAggregator::OPERATION_RECEIVE:
+      traffic->bytes_received += packet.size;
+      ++traffic->packets_received;
+      break;
+    case FlowAggregator::OPERATION_RETRANSMIT:
+      ++traffic->retransmits;
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace
+
+FlowAggregator::FlowAggregator(KeyMode key_mode, Timestamp bucket_duration)
+    : key_mode_(key_mode),
+      bucket_duration_(bucket_duration),
+      slots_(kInitialSlotCount, 0),
+      has_series_start_(false),
+      series_start_(0) {
+  DCHECK_GT(bucket_duration, 0U);
+}
+
+void FlowAggregator::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event) || kernel_event.category() != "Tcplp")
+    return;
+
+  Packet packet = {};
+  const std::string& operation = kernel_event.operation();
+  if (operation == "SendIPV4") {
+    packet.operation = OPERATION_SEND;
+  } else if (operation == "RecvIPV4") {
+    packet.operation = OPERATION_RECEIVE;
+  } else if (operation == "RetransmitIPV4") {
+    packet.operation = OPERATION_RETRANSMIT;
+  } else if (operation == "ConnectIPV4" || operation == "AcceptIPV4") {
+    packet.operation = OPERATION_CONNECT;
+  } else if (operation == "DisconnectIPV4") {
+    packet.operation = OPERATION_DISCONNECT;
+  } else {
+    return;
+  }
+
+  const StructValue* content = kernel_event.content();
+  uint32 local_port = 0;
+  uint32 remote_port = 0;
+  if (!content->GetFieldAsUInteger("PID", &packet.process_id) ||
+      !content->GetFieldAsUInteger("size", &packet.size) ||
+      !content->GetFieldAsUInteger("saddr", &packet.local_address) ||
+      !content->GetFieldAsUInteger("daddr", &packet.remote_address) ||
+      !content->GetFieldAsUInteger("sport", &local_port) ||
+      !content->GetFieldAsUInteger("dport", &remote_port) ||
+      !content->GetFieldAsULong("connid", &packet.connection_id)) {
+    return;
+  }
+  packet.local_port = static_cast<uint16>(local_port);
+  packet.remote_port = static_cast<uint16>(remote_port);
+  packet.timestamp = kernel_event.timestamp();
+
+  AddPacket(packet);
+}
+
+void FlowAggregator::AddPacket(const Packet& packet) {
+  Flow* flow = GetFlow(packet);
+  AddTraffic(packet, &flow->traffic);
+  if (packet.timestamp < flow->first_seen)
+    flow->first_seen = packet.timestamp;
+  if (packet.timestamp > flow->last_seen)
+    flow->last_seen = packet.timestamp;
+  if (packet.operation == OPERATION_CONNECT)
+    flow->connect_time = packet.timestamp;
+  else if (packet.operation == OPERATION_DISCONNECT)
+    flow->disconnect_time = packet.timestamp;
+
+  ProcessTotals* process = processes_.FindOrInsert(packet.process_id);
+  AddTraffic(packet, &process->traffic);
+
+  if (packet.operation != OPERATION_SEND &&
+      packet.operation != OPERATION_RECEIVE) {
+    return;
+  }
+
+  if (!has_series_start_) {
+    has_series_start_ = true;
+    series_start_ = packet.timestamp;
+  }
+  size_t bucket = 0;
+  if (packet.timestamp > series_start_)
+    bucket = (packet.timestamp - series_start_) / bucket_duration_;
+  if (bucket >= kMaxBuckets)
+    return;
+  AddToSeries(bucket, packet, &series_);
+  AddToSeries(bucket, packet, &process->series);
+}
+
+bool FlowAggregator::WriteReport(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  for (size_t i = 0; i < flows_.size(); ++i) {
+    const Flow& flow = flows_[i];
+    const Packet& packet = flow.first_packet;
+    Timestamp lifetime = 0;
+    if (flow.connect_time != 0 && flow.disconnect_time > flow.connect_time)
+      lifetime = flow.disconnect_time - flow.connect_time;
+
+    *out << "flow " << packet.process_id << ' ';
+    WriteAddress(packet.local_address, out);
+    *out << ':' << PortToHost(packet.local_port) << ' ';
+    WriteAddress(packet.remote_address, out);
+    *out << ':' << PortToHost(packet.remote_port) << ' '
+         << flow.traffic.bytes_sent << ' '
+         << flow.traffic.packets_sent << ' '
+         << flow.traffic.bytes_received << ' '
+         << flow.traffic.packets_received << ' '
+         << flow.traffic.retransmits << ' '
+         << lifetime << '\n';
+  }
+
+  for (IdMap<ProcessTotals>::const_iterator it = processes_.begin();
+       it != processes_.end(); ++it) {
+    const Traffic& traffic = it->second.traffic;
+    *out << "process " << it->first << ' '
+         << traffic.bytes_sent << ' '
+         << traffic.bytes_received << ' '
+         << traffic.retransmits << '\n';
+  }
+
+  for (size_t i = 0; i < series_.size(); ++i) {
+    *out << "bucket " << i << ' '
+         << series_[i].bytes_sent << ' '
+         << series_[i].bytes_received << '\n';
+  }
+
+  return out->good();
+}
+
+FlowAggregator::Key FlowAggregator::MakeKey(const Packet& packet) const {
+  Key key;
+  if (key_mode_ == KEY_CONNECTION) {
+    key.high = 0;
+    key.low = packet.connection_id;
+  } else {
+    key.high = (static_cast<uint64>(packet.local_address) << 32) |
+               packet.remote_address;
+    key.low = (static_cast<uint64>(packet.local_port) << 16) |
+              packet.remote_port;
+  }
+  return key;
+}
+
+size_t FlowAggregator::FindSlot(const Key& key, uint64 hash) const {
+  size_t mask = slots_.size() - 1;
+  size_t slot = static_cast<size_t>(hash) & mask;
+  while (slots_[slot] != 0) {
+    uint32 index = slots_[slot] - 1;
+    if (hashes_[index] == hash && keys_[index] == key)
+      break;
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+FlowAggregator::Flow* FlowAggregator::GetFlow(const Packet& packet) {
+  Key key = MakeKey(packet);
+  uint64 hash = base::Hash64(&key, sizeof(key));
+  size_t slot = FindSlot(key, hash);
+
+  if (slots_[slot] != 0) {
+    Flow* flow = &flows_[slots_[slot] - 1];
+    // A connection reusing the key of a closed one starts a new flow.
+    if (packet.operation != OPERATION_CONNECT || flow->disconnect_time == 0)
+      return flow;
+  }
+
+  bool is_new_slot = slots_[slot] == 0;
+
+  Flow flow = {};
+  flow.first_packet = packet;
+  flow.first_seen = packet.timestamp;
+  flow.last_seen = packet.timestamp;
+  flows_.push_back(flow);
+  keys_.push_back(key);
+  hashes_.push_back(hash);
+  slots_[slot] = static_cast<uint32>(flows_.size());
+
+  // Keep the load factor under one half. Replaced flows don't use a slot.
+  if (is_new_slot && 2 * flows_.size() > slots_.size())
+    Grow();
+
+  return &flows_.back();
+}
+
+void FlowAggregator::Grow() {
+  // Collect the current flows: the slots of the replaced flows were reused.
+  std::vector<uint32> current;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (slots_[i] != 0)
+      current.push_back(slots_[i]);
+  }
+
+  slots_.assign(2 * slots_.size(), 0);
+  size_t mask = slots_.size() - 1;
+  for (size_t i = 0; i < current.size(); ++i) {
+    size_t slot = static_cast<size_t>(hashes_[current[i] - 1]) & mask;
+    while (slots_[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots_[slot] = current[i];
+  }
+}
+
+void FlowAggregator::AddToSeries(size_t bucket,
+                                 const Packet& packet,
+                                 std::vector<ThroughputBucket>* series) {
+  DCHECK(series != NULL);
+  if (bucket >= series->size()) {
+    ThroughputBucket empty = {};
+    series->resize(bucket + 1, empty);
+  }
+  if (packet.operation == OPERATION_SEND)
+    (*series)[bucket].bytes_sent += packet.size;
+  else
+    (*series)[bucket].bytes_received += packet.size;
+}
+
+}  // namespace analysis
@@ -0,0 +1,214 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A flow aggregator summarizes the TCP traffic reported by the Tcplp events.
+// The events of a connection are grouped into a flow, keyed either by the
+// connection 5-tuple packed in two integers, or by the connection identifier
+// of the kernel ("connid"). For each flow, it tracks the bytes and the
+// packets in each direction, the retransmits and the lifetime of the
+// connection. It also keeps the totals of each process, and throughput series
+// with a fixed bucket duration.
+//
+// The flows are stored in a flat array indexed by an open-addressing hash
+// table: after warming up, consuming an event allocates no memory.
+//
+// The addresses and the ports are kept as they appear in the payloads, in
+// network byte order.
+//
+// Usage example:
+//   FlowAggregator flows(FlowAggregator::KEY_TUPLE, kOneSecond);
+//   parser.Parse(base::MakeObserver(&flows, &FlowAggregator::Receive));
+//   flows.WriteReport(&std::cout);
+
+#ifndef ANALYSIS_FLOW_AGGREGATOR_H_
+#define ANALYSIS_FLOW_AGGREGATOR_H_
+
+#include <ostream>
+#include <vector>
+
+#include "analysis/id_map.h"
+#include "base/base.h"
+#include "event/event.h"
+
+namespace analysis {
+
+class FlowAggregator {
+ public:
+  // How the events are grouped into flows.
+  enum KeyMode {
+    // By local address and port, remote address and port.
+    KEY_TUPLE,
+    // By connection identifier.
+    KEY_CONNECTION
+  };
+
+  // The type of a Tcplp event.
+  enum Operation {
+    OPERATION_SEND,
+    OPERATION_RECEIVE,
+    OPERATION_RETRANSMIT,
+    OPERATION_CONNECT,
+    OPERATION_DISCONNECT
+  };
+
+  // The fields of a Tcplp event.
+  struct Packet {
+    Operation operation;
+    event::Timestamp timestamp;
+    uint32 process_id;
+    uint32 size;
+    uint32 local_address;
+    uint32 remote_address;
+    uint16 local_port;
+    uint16 remote_port;
+    uint64 connection_id;
+  };
+
+  // The traffic of a time bucket.
+  struct ThroughputBucket {
+    uint64 bytes_sent;
+    uint64 bytes_received;
+  };
+
+  // The traffic of a flow or of a process.
+  struct Traffic {
+    uint64 bytes_sent;
+    uint64 packets_sent;
+    uint64 bytes_received;
+    uint64 packets_received;
+    uint64 retransmits;
+  };
+
+  struct Flow {
+    // The first packet seen for the flow.
+    Packet first_packet;
+    Traffic traffic;
+    event::Timestamp first_seen;
+    event::Timestamp last_seen;
+    // The times of the connection and of the disconnection, or zero if not
+    // seen.
+    event::Timestamp connect_time;
+    event::Timestamp disconnect_time;
+  };
+
+  struct ProcessTotals {
+    Traffic traffic;
+    std::vector<ThroughputBucket> series;
+  };
+
+  // @param key_mode how the events are grouped into flows.
+  // @param bucket_duration the duration of the buckets of the throughput
+  //     series, in timestamp units.
+  FlowAggregator(KeyMode key_mode, event::Timestamp bucket_duration);
+
+  // Consumes an event of the ETW parser. Events other than the Tcplp events
+  // are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Adds a Tcplp event.
+  // @param packet the fields of the event.
+  void AddPacket(const Packet& packet);
+
+  // @returns the flows, in order of first appearance.
+  const std::vector<Flow>& flows() const { return flows_; }
+
+  // @param process_id a process.
+  // @returns the totals of |process_id|, or NULL if it has no traffic.
+  const ProcessTotals* GetProcessTotals(uint32 process_id) const {
+    return processes_.Find(process_id);
+  }
+
+  // @returns the throughput of all flows, per bucket. The first bucket
+  //     starts at the first event.
+  const std::vector<ThroughputBucket>& series() const { return series_; }
+
+  // @returns the start of the first bucket.
+  event::Timestamp series_start() const { return series_start_; }
+
+  // Writes the flows, the process totals and the throughput series:
+  //   "flow <pid> <local>:<port> <remote>:<port> <bytes sent>
+  //    <packets sent> <bytes received> <packets received> <retransmits>
+  //    <lifetime>"
+  //   "process <pid> <bytes sent> <bytes received> <retransmits>"
+  //   "bucket <index> <bytes sent> <bytes received>"
+  // The lifetime is zero when the connection or the disconnection was not
+  // seen.
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteReport(std::ostream* out) const;
+
+ private:
+  // A flow key packed in two integers.
+  struct Key {
+    uint64 high;
+    uint64 low;
+
+    bool operator==(const Key& other) const {
+      return high == other.high && low == other.low;
+    }
+  };
+
+  // @returns the key of the flow of |packet|.
+  Key MakeKey(const Packet& packet) const;
+
+  // @returns the slot of |key|, or the empty slot where it would be added.
+  size_t FindSlot(const Key& key, uint64 hash) const;
+
+  // @returns the flow of |packet|, created if needed.
+  Flow* GetFlow(const Packet& packet);
+
+  // Doubles the number of slots of the hash table.
+  void Grow();
+
+  // Adds bytes to a throughput series.
+  static void AddToSeries(size_t bucket,
+                          const Packet& packet,
+                          std::vector<ThroughputBucket>* series);
+
+  KeyMode key_mode_;
+  event::Timestamp bucket_duration_;
+
+  std::vector<Flow> flows_;
+  // The key and the hash of each flow.
+  std::vector<Key> keys_;
+  std::vector<uint64> hashes_;
+  // An open-addressing hash table of the current flows. A slot holds the
+  // index of a flow plus one, or zero when empty. The number of slots is a
+  // power of two.
+  std::vector<uint32> slots_;
+
+  IdMap<ProcessTotals> processes_;
+
+  bool has_series_start_;
+  event::Timestamp series_start_;
+  std::vector<ThroughputBucket> series_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlowAggregator);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_FLOW_AGGREGATOR_H_
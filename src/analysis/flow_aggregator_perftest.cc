@@ -0,0 +1,64 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/flow_aggregator.h"
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+const size_t kPackets = 2000000;
+const uint32 kFlows = 20000;
+
+}  // namespace
+
+TEST(FlowAggregatorPerfTest, AddPacket) {
+  FlowAggregator aggregator(FlowAggregator::KEY_TUPLE, 10000000);
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kPackets; ++i) {
+    uint32 flow = static_cast<uint32>((i * 7919) % kFlows);
+    FlowAggregator::Packet packet = {};
+    packet.operation = (i % 2 == 0) ? FlowAggregator::OPERATION_SEND
+                                    : FlowAggregator::OPERATION_RECEIVE;
+    packet.timestamp = i * 100;
+    packet.process_id = flow % 64;
+    packet.size = 1460;
+    packet.local_address = 0x0100000A;
+    packet.remote_address = flow;
+    packet.local_port = 0x5000;
+    packet.remote_port = static_cast<uint16>(flow);
+    aggregator.AddPacket(packet);
+  }
+  base::PrintPerfResult("AddPacket", "time", timer.ElapsedNanoseconds(),
+                        kPackets, "ns/packet");
+
+  EXPECT_EQ(kFlows, aggregator.flows().size());
+}
+
+}  // namespace analysis
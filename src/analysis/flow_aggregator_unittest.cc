@@ -0,0 +1,183 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/flow_aggregator.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::UShortValue;
+
+// 10.0.0.1 and 10.0.0.2, in network byte order on a little-endian host.
+const uint32 kLocalAddress = 0x0100000A;
+const uint32 kRemoteAddress = 0x0200000A;
+// Ports 1024 and 80, in network byte order on a little-endian host.
+const uint16 kLocalPort = 0x0004;
+const uint16 kRemotePort = 0x5000;
+
+FlowAggregator::Packet MakePacket(FlowAggregator::Operation operation,
+                                  event::Timestamp timestamp,
+                                  uint32 size) {
+  FlowAggregator::Packet packet = {};
+  packet.operation = operation;
+  packet.timestamp = timestamp;
+  packet.process_id = 1234;
+  packet.size = size;
+  packet.local_address = kLocalAddress;
+  packet.remote_address = kRemoteAddress;
+  packet.local_port = kLocalPort;
+  packet.remote_port = kRemotePort;
+  packet.connection_id = 0xC0;
+  return packet;
+}
+
+void SendEvent(FlowAggregator* aggregator,
+               const char* operation,
+               event::Timestamp timestamp,
+               uint32 size,
+               uint16 local_port) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("PID", 1234);
+  content->AddField<UIntValue>("size", size);
+  content->AddField<UIntValue>("daddr", kRemoteAddress);
+  content->AddField<UIntValue>("saddr", kLocalAddress);
+  content->AddField<UShortValue>("dport", kRemotePort);
+  content->AddField<UShortValue>("sport", local_port);
+  content->AddField<UIntValue>("seqnum", 0);
+  content->AddField<ULongValue>("connid", local_port);
+  aggregator->Receive(*CreateKernelEvent(timestamp, "Tcplp", operation, 4, 8,
+                                         0, content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(FlowAggregatorTest, AggregateFlows) {
+  FlowAggregator aggregator(FlowAggregator::KEY_TUPLE, 100);
+  SendEvent(&aggregator, "ConnectIPV4", 10, 0, kLocalPort);
+  SendEvent(&aggregator, "SendIPV4", 20, 500, kLocalPort);
+  SendEvent(&aggregator, "RecvIPV4", 30, 1500, kLocalPort);
+  SendEvent(&aggregator, "RecvIPV4", 130, 1500, kLocalPort);
+  SendEvent(&aggregator, "RetransmitIPV4", 140, 500, kLocalPort);
+  SendEvent(&aggregator, "DisconnectIPV4", 150, 0, kLocalPort);
+  SendEvent(&aggregator, "SendIPV4", 160, 100, kLocalPort + 1);
+
+  ASSERT_EQ(2U, aggregator.flows().size());
+  const FlowAggregator::Flow& flow = aggregator.flows()[0];
+  EXPECT_EQ(500U, flow.traffic.bytes_sent);
+  EXPECT_EQ(1U, flow.traffic.packets_sent);
+  EXPECT_EQ(3000U, flow.traffic.bytes_received);
+  EXPECT_EQ(2U, flow.traffic.packets_received);
+  EXPECT_EQ(1U, flow.traffic.retransmits);
+  EXPECT_EQ(10U, flow.connect_time);
+  EXPECT_EQ(150U, flow.disconnect_time);
+  EXPECT_EQ(10U, flow.first_seen);
+  EXPECT_EQ(150U, flow.last_seen);
+
+  const FlowAggregator::ProcessTotals* process =
+      aggregator.GetProcessTotals(1234);
+  ASSERT_TRUE(process != NULL);
+  EXPECT_EQ(600U, process->traffic.bytes_sent);
+  EXPECT_EQ(3000U, process->traffic.bytes_received);
+  EXPECT_EQ(NULL, aggregator.GetProcessTotals(4));
+
+  // The series start with the first send or receive.
+  EXPECT_EQ(20U, aggregator.series_start());
+  ASSERT_EQ(2U, aggregator.series().size());
+  EXPECT_EQ(500U, aggregator.series()[0].bytes_sent);
+  EXPECT_EQ(1500U, aggregator.series()[0].bytes_received);
+  EXPECT_EQ(100U, aggregator.series()[1].bytes_sent);
+  EXPECT_EQ(1500U, aggregator.series()[1].bytes_received);
+  EXPECT_EQ(2U, process->series.size());
+}
+
+TEST(FlowAggregatorTest, ReusedTupleStartsNewFlow) {
+  FlowAggregator aggregator(FlowAggregator::KEY_TUPLE, 100);
+  aggregator.AddPacket(MakePacket(FlowAggregator::OPERATION_CONNECT, 10, 0));
+  aggregator.AddPacket(MakePacket(FlowAggregator::OPERATION_SEND, 20, 10));
+  aggregator.AddPacket(
+      MakePacket(FlowAggregator::OPERATION_DISCONNECT, 30, 0));
+  aggregator.AddPacket(MakePacket(FlowAggregator::OPERATION_CONNECT, 40, 0));
+  aggregator.AddPacket(MakePacket(FlowAggregator::OPERATION_SEND, 50, 20));
+
+  ASSERT_EQ(2U, aggregator.flows().size());
+  EXPECT_EQ(10U, aggregator.flows()[0].traffic.bytes_sent);
+  EXPECT_EQ(20U, aggregator.flows()[1].traffic.bytes_sent);
+  EXPECT_EQ(40U, aggregator.flows()[1].connect_time);
+}
+
+TEST(FlowAggregatorTest, KeyByConnection) {
+  FlowAggregator aggregator(FlowAggregator::KEY_CONNECTION, 100);
+  FlowAggregator::Packet packet =
+      MakePacket(FlowAggregator::OPERATION_SEND, 10, 10);
+  aggregator.AddPacket(packet);
+  packet.local_port = 0;
+  aggregator.AddPacket(packet);
+  packet.connection_id = 0xD0;
+  aggregator.AddPacket(packet);
+
+  ASSERT_EQ(2U, aggregator.flows().size());
+  EXPECT_EQ(2U, aggregator.flows()[0].traffic.packets_sent);
+}
+
+TEST(FlowAggregatorTest, ManyFlows) {
+  FlowAggregator aggregator(FlowAggregator::KEY_TUPLE, 100);
+  for (uint32 round = 0; round < 2; ++round) {
+    for (uint32 i = 0; i < 10000; ++i) {
+      FlowAggregator::Packet packet =
+          MakePacket(FlowAggregator::OPERATION_RECEIVE, i, 1);
+      packet.remote_address = i;
+      aggregator.AddPacket(packet);
+    }
+  }
+
+  ASSERT_EQ(10000U, aggregator.flows().size());
+  for (size_t i = 0; i < aggregator.flows().size(); ++i)
+    EXPECT_EQ(2U, aggregator.flows()[i].traffic.packets_received);
+}
+
+TEST(FlowAggregatorTest, WriteReport) {
+  FlowAggregator aggregator(FlowAggregator::KEY_TUPLE, 100);
+  aggregator.AddPacket(MakePacket(FlowAggregator::OPERATION_CONNECT, 10, 0));
+  aggregator.AddPacket(MakePacket(FlowAggregator::OPERATION_SEND, 20, 10));
+  aggregator.AddPacket(
+      MakePacket(FlowAggregator::OPERATION_DISCONNECT, 30, 0));
+
+  std::ostringstream out;
+  EXPECT_TRUE(aggregator.WriteReport(&out));
+  EXPECT_EQ("flow 1234 10.0.0.1:1024 10.0.0.2:80 10 1 0 0 0 20\n"
+            "process 1234 10 0 0\n"
+            "bucket 0 10 0\n", out.str());
+}
+
+}  // namespace analysis
@@ -0,0 +1,191 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/heavy_hitters.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+// Orders the counters by decreasing count, then by key.
+bool HigherCount(const HeavyHitters::Counter& left,
+                 const HeavyHitters::Counter& right) {
+  if (left.count != right.count)
+    return left.count > right.count;
+  return left.key < right.key;
+}
+
+}  // namespace
+
+HeavyHitters::HeavyHitters(size_t capacity)
+    : capacity_(capacity),
+      total_(0) {
+  DCHECK_GT(capacity, 0U);
+}
+
+void HeavyHitters::Add(const std::string& key, uint64 weight) {
+  total_ += weight;
+
+  std::map<std::string, uint32>::iterator it = index_.lower_bound(key);
+  if (it != index_.end() && it->first == key) {
+    counters_[it->second].count += weight;
+    SiftDown(positions_[it->second]);
+    return;
+  }
+
+  if (counters_.size() < capacity_) {
+    uint32 id = static_cast<uint32>(counters_.size());
+    Counter counter = { key, weight, 0 };
+    counters_.push_back(counter);
+    index_.insert(it, std::make_pair(key, id));
+    heap_.push_back(id);
+    positions_.push_back(static_cast<uint32>(heap_.size() - 1));
+    SiftUp(heap_.size() - 1);
+    return;
+  }
+
+  // Replace the key with the smallest count.
+  uint32 id = heap_[0];
+  Counter& counter = counters_[id];
+  index_.erase(counter.key);
+  index_.insert(std::make_pair(key, id));
+  counter.key = key;
+  counter.error = counter.count;
+  counter.count += weight;
+  SiftDown(0);
+}
+
+void HeavyHitters::Merge(const HeavyHitters& other) {
+  DCHECK(&other != this);
+
+  // A key which is not monitored by a sketch has at most the minimal count
+  // of that sketch.
+  uint64 min_count = MinCount();
+  uint64 other_min_count = other.MinCount();
+
+  std::vector<Counter> merged;
+  merged.reserve(counters_.size() + other.counters_.size());
+
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    Counter counter = counters_[i];
+    std::map<std::string, uint32>::const_iterator it =
+        other.index_.find(counter.key);
+    if (it != other.index_.end()) {
+      counter.count += other.counters_[it->second].count;
+      counter.error += other.counters_[it->second].error;
+    } else {
+      counter.count += other_min_count;
+      counter.error += other_min_count;
+    }
+    merged.push_back(counter);
+  }
+
+  for (size_t i = 0; i < other.counters_.size(); ++i) {
+    if (index_.find(other.counters_[i].key) != index_.end())
+      continue;
+    Counter counter = other.counters_[i];
+    counter.count += min_count;
+    counter.error += min_count;
+    merged.push_back(counter);
+  }
+
+  if (merged.size() > capacity_) {
+    std::nth_element(merged.begin(), merged.begin() + capacity_,
+                     merged.end(), HigherCount);
+    merged.resize(capacity_);
+  }
+
+  counters_.swap(merged);
+  total_ += other.total_;
+  Rebuild();
+}
+
+void HeavyHitters::GetTop(size_t count, std::vector<Counter>* top) const {
+  DCHECK(top != NULL);
+
+  *top = counters_;
+  count = std::min(count, top->size());
+  std::partial_sort(top->begin(), top->begin() + count, top->end(),
+                    HigherCount);
+  top->resize(count);
+}
+
+uint64 HeavyHitters::MinCount() const {
+  if (counters_.size() < capacity_)
+    return 0;
+  return counters_[heap_[0]].count;
+}
+
+void HeavyHitters::SiftUp(size_t position) {
+  while (position > 0) {
+    size_t parent = (position - 1) / 2;
+    if (!Lower(heap_[position], heap_[parent]))
+      break;
+    SwapHeap(position, parent);
+    position = parent;
+  }
+}
+
+void HeavyHitters::SiftDown(size_t position) {
+  for (;;) {
+    size_t lowest = position;
+    size_t left = 2 * position + 1;
+    size_t right = left + 1;
+    if (left < heap_.size() && Lower(heap_[left], heap_[lowest]))
+      lowest = left;
+    if (right < heap_.size() && Lower(heap_[right], heap_[lowest]))
+      lowest = right;
+    if (lowest == position)
+      break;
+    SwapHeap(position, lowest);
+    position = lowest;
+  }
+}
+
+void HeavyHitters::SwapHeap(size_t left, size_t right) {
+  std::swap(heap_[left], heap_[right]);
+  positions_[heap_[left]] = static_cast<uint32>(left);
+  positions_[heap_[right]] = static_cast<uint32>(right);
+}
+
+void HeavyHitters::Rebuild() {
+  index_.clear();
+  heap_.clear();
+  positions_.clear();
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    uint32 id = static_cast<uint32>(i);
+    index_.insert(std::make_pair(counters_[i].key, id));
+    heap_.push_back(id);
+    positions_.push_back(id);
+  }
+  for (size_t i = heap_.size() / 2; i > 0; --i)
+    SiftDown(i - 1);
+}
+
+}  // namespace analysis
@@ -0,0 +1,127 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A heavy-hitters sketch finds the most frequent keys of a stream with a
+// bounded memory, using the Space-Saving algorithm: the sketch monitors at
+// most |capacity| keys. When a new key arrives and the sketch is full, it
+// replaces the key with the smallest count and inherits this count as its
+// error. The count of a monitored key overestimates its true count by at
+// most its error, and any key whose true count exceeds total / capacity is
+// monitored.
+//
+// Sketches built over parts of a stream can be merged: the merged sketch
+// has the same guarantees as a sketch built over the whole stream.
+//
+// Usage example:
+//   HeavyHitters sketch(1000);
+//   sketch.Add("HKLM\\Software", 1);
+//   ...
+//   std::vector<HeavyHitters::Counter> top;
+//   sketch.GetTop(100, &top);
+
+#ifndef ANALYSIS_HEAVY_HITTERS_H_
+#define ANALYSIS_HEAVY_HITTERS_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+
+namespace analysis {
+
+class HeavyHitters {
+ public:
+  struct Counter {
+    std::string key;
+    // An upper bound of the total weight of |key|.
+    uint64 count;
+    // The maximal overestimation of |count|.
+    uint64 error;
+  };
+
+  // @param capacity the maximal number of monitored keys.
+  explicit HeavyHitters(size_t capacity);
+
+  // Adds an occurrence of a key.
+  // @param key the key.
+  // @param weight the weight of the occurrence.
+  void Add(const std::string& key, uint64 weight);
+
+  // Adds the occurrences summarized by another sketch.
+  // @param other the sketch to merge into this one. Must not be this sketch.
+  void Merge(const HeavyHitters& other);
+
+  // @param count the number of keys to return.
+  // @param top receives the |count| monitored keys with the largest counts,
+  //     largest first.
+  void GetTop(size_t count, std::vector<Counter>* top) const;
+
+  // @returns the smallest count of a monitored key if the sketch is full,
+  //     zero otherwise. A key which is not monitored has at most this count.
+  uint64 MinCount() const;
+
+  // Accessors.
+  // @{
+  size_t capacity() const { return capacity_; }
+  size_t size() const { return counters_.size(); }
+  uint64 total() const { return total_; }
+  // @}
+
+ private:
+  // Moves the counter at |position| of the heap to restore the heap order.
+  // @{
+  void SiftUp(size_t position);
+  void SiftDown(size_t position);
+  // @}
+
+  // Swaps two positions of the heap.
+  void SwapHeap(size_t left, size_t right);
+
+  // @returns true if the counter |left| has a lower count than |right|.
+  bool Lower(uint32 left, uint32 right) const {
+    return counters_[left].count < counters_[right].count;
+  }
+
+  // Rebuilds the index and the heap from the counters.
+  void Rebuild();
+
+  size_t capacity_;
+  uint64 total_;
+
+  std::vector<Counter> counters_;
+
+  // The index of the counter of each monitored key.
+  std::map<std::string, uint32> index_;
+
+  // A min-heap of counter indexes, ordered by count, and the position of each
+  // counter in the heap.
+  std::vector<uint32> heap_;
+  std::vector<uint32> positions_;
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_HEAVY_HITTERS_H_
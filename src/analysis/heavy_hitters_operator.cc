@@ -0,0 +1,136 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/heavy_hitters_operator.h"
+
+#include <sstream>
+#include <vector>
+
+#include "analysis/kernel_event.h"
+#include "analysis/report_utils.h"
+#include "base/logging.h"
+#include "base/string_utils.h"
+
+namespace analysis {
+
+const HeavyHittersConfig kRegistryKeysConfig = {
+    "Registry", NULL, "content.KeyName", NULL };
+const HeavyHittersConfig kFileOpensConfig = {
+    "FileIO", "Create", "content.OpenPath", NULL };
+const HeavyHittersConfig kFileBytesReadConfig = {
+    "FileIO", "Read", "content.FileKey", "content.IoSize" };
+const HeavyHittersConfig kImageNamesConfig = {
+    "Image", "Load", "content.ImageFileName", NULL };
+const HeavyHittersConfig kSyscallAddressesConfig = {
+    "PerfInfo", "SysClEnter", "content.SysCallAddress", NULL };
+
+HeavyHittersOperator::HeavyHittersOperator(const HeavyHittersConfig& config,
+                                           size_t capacity)
+    : config_(config),
+      key_path_(config.key_path),
+      weight_path_(config.weight_path != NULL ? config.weight_path : ""),
+      sketch_(capacity) {
+  DCHECK(config.key_path != NULL);
+  DCHECK(key_path_.IsValid());
+  DCHECK(weight_path_.IsValid());
+}
+
+void HeavyHittersOperator::Receive(const event::Event& event) {
+  if (config_.category != NULL || config_.operation != NULL) {
+    KernelEvent kernel_event;
+    if (!kernel_event.Parse(event))
+      return;
+    if (config_.category != NULL &&
+        kernel_event.category().compare(config_.category) != 0) {
+      return;
+    }
+    if (config_.operation != NULL &&
+        kernel_event.operation().compare(config_.operation) != 0) {
+      return;
+    }
+  }
+
+  if (!ValueToKey(key_path_.Get(event.payload()), &key_))
+    return;
+
+  uint64 weight = 1;
+  if (config_.weight_path != NULL) {
+    const event::Value* value = weight_path_.Get(event.payload());
+    if (value == NULL || !value->GetAsULong(&weight))
+      return;
+  }
+
+  sketch_.Add(key_, weight);
+}
+
+bool HeavyHittersOperator::WriteReport(size_t count,
+                                       std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  std::vector<HeavyHitters::Counter> top;
+  sketch_.GetTop(count, &top);
+  for (size_t i = 0; i < top.size(); ++i)
+    *out << top[i].count << ' ' << top[i].error << ' ' << top[i].key << '\n';
+
+  return out->good();
+}
+
+bool ValueToKey(const event::Value* value, std::string* key) {
+  DCHECK(key != NULL);
+
+  if (value == NULL)
+    return false;
+
+  if (event::StringValue::InstanceOf(value)) {
+    *key = event::StringValue::GetValue(value);
+    return true;
+  }
+  if (event::WStringValue::InstanceOf(value)) {
+    *key = base::WStringToString(event::WStringValue::GetValue(value));
+    return true;
+  }
+
+  if (!value->IsInteger())
+    return false;
+
+  if (value->IsSigned()) {
+    int64 integer = 0;
+    if (!value->GetAsLong(&integer))
+      return false;
+    std::ostringstream out;
+    out << integer;
+    *key = out.str();
+    return true;
+  }
+
+  uint64 integer = 0;
+  if (!value->GetAsULong(&integer))
+    return false;
+  key->clear();
+  AppendHex(integer, key);
+  return true;
+}
+
+}  // namespace analysis
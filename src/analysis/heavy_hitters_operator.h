@@ -0,0 +1,124 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A heavy-hitters operator feeds a HeavyHitters sketch with a field of the
+// events of a stream. The field designated by the key path is the key; the
+// field designated by the weight path, if any, is the weight of the event.
+//
+// Usage example:
+//   HeavyHittersOperator registry_keys(kRegistryKeysConfig, 1000);
+//   parser.Parse(base::MakeObserver(&registry_keys,
+//                                   &HeavyHittersOperator::Receive));
+//   registry_keys.WriteReport(100, &std::cout);
+
+#ifndef ANALYSIS_HEAVY_HITTERS_OPERATOR_H_
+#define ANALYSIS_HEAVY_HITTERS_OPERATOR_H_
+
+#include <ostream>
+#include <string>
+
+#include "analysis/field_path.h"
+#include "analysis/heavy_hitters.h"
+#include "base/base.h"
+#include "event/event.h"
+
+namespace analysis {
+
+// Selects the events and the fields fed to a sketch. The paths are relative
+// to the payload of the events; the category and the operation are those of
+// the kernel events of the ETW parser.
+struct HeavyHittersConfig {
+  // The category of the selected events, or NULL for any category.
+  const char* category;
+  // The operation of the selected events, or NULL for any operation.
+  const char* operation;
+  // The path of the key.
+  const char* key_path;
+  // The path of the weight, or NULL to count the events.
+  const char* weight_path;
+};
+
+// Ready-made configurations.
+// @{
+// Registry keys by number of accesses.
+extern const HeavyHittersConfig kRegistryKeysConfig;
+// Files by number of opens.
+extern const HeavyHittersConfig kFileOpensConfig;
+// Files by bytes read. The FileIO/Read events identify the files by their
+// FileKey, which the FileIO/FileCreate and FileRundown events map to names.
+extern const HeavyHittersConfig kFileBytesReadConfig;
+// Images by number of loads.
+extern const HeavyHittersConfig kImageNamesConfig;
+// Syscalls by number of calls.
+extern const HeavyHittersConfig kSyscallAddressesConfig;
+// @}
+
+class HeavyHittersOperator {
+ public:
+  // @param config the selection of the events and fields. The strings must
+  //     outlive the operator.
+  // @param capacity the number of keys monitored by the sketch.
+  HeavyHittersOperator(const HeavyHittersConfig& config, size_t capacity);
+
+  // Consumes an event. The events not selected by the configuration, or
+  // missing the key or the weight, are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Writes a line per heavy hitter: "<count> <error> <key>".
+  // @param count the number of keys to write.
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteReport(size_t count, std::ostream* out) const;
+
+  // The sketch, which can be merged with the sketches of other operators.
+  // @{
+  const HeavyHitters& sketch() const { return sketch_; }
+  HeavyHitters* mutable_sketch() { return &sketch_; }
+  // @}
+
+ private:
+  HeavyHittersConfig config_;
+  FieldPath key_path_;
+  FieldPath weight_path_;
+
+  HeavyHitters sketch_;
+
+  // The key of the last event, reused across events.
+  std::string key_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeavyHittersOperator);
+};
+
+// Converts a scalar value to a sketch key. Strings are kept as is, and
+// integers are written in hexadecimal.
+// @param value the value to convert.
+// @param key receives the key.
+// @returns true on success, false if |value| has no key representation.
+bool ValueToKey(const event::Value* value, std::string* key);
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_HEAVY_HITTERS_OPERATOR_H_
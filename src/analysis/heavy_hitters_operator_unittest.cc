@@ -0,0 +1,129 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/heavy_hitters_operator.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::WStringValue;
+
+void SendRegistryEvent(HeavyHittersOperator* op,
+                       const char* operation,
+                       const std::wstring& key_name) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("Status", 0);
+  content->AddField<WStringValue>("KeyName", key_name);
+  op->Receive(*CreateKernelEvent(0, "Registry", operation, 4, 8, 0,
+                                 content.Pass()).get());
+}
+
+void SendFileRead(HeavyHittersOperator* op, uint64 file_key, uint32 size) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("FileKey", file_key);
+  content->AddField<UIntValue>("IoSize", size);
+  op->Receive(*CreateKernelEvent(0, "FileIO", "Read", 4, 8, 0,
+                                 content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(HeavyHittersOperatorTest, RegistryKeys) {
+  HeavyHittersOperator op(kRegistryKeysConfig, 100);
+  SendRegistryEvent(&op, "Open", L"\\Registry\\Machine\\Software");
+  SendRegistryEvent(&op, "QueryValue", L"\\Registry\\Machine\\Software");
+  SendRegistryEvent(&op, "Open", L"\\Registry\\User");
+
+  // Events of other categories are ignored.
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<WStringValue>("KeyName", L"\\Registry\\User");
+  op.Receive(*CreateKernelEvent(0, "FileIO", "Open", 4, 8, 0,
+                                content.Pass()).get());
+
+  std::ostringstream out;
+  EXPECT_TRUE(op.WriteReport(10, &out));
+  EXPECT_EQ("2 0 \\Registry\\Machine\\Software\n"
+            "1 0 \\Registry\\User\n", out.str());
+}
+
+TEST(HeavyHittersOperatorTest, FileBytesRead) {
+  HeavyHittersOperator op(kFileBytesReadConfig, 100);
+  SendFileRead(&op, 0xA0, 4096);
+  SendFileRead(&op, 0xB0, 100);
+  SendFileRead(&op, 0xA0, 4096);
+
+  std::vector<HeavyHitters::Counter> top;
+  op.sketch().GetTop(1, &top);
+  ASSERT_EQ(1U, top.size());
+  EXPECT_EQ("0xa0", top[0].key);
+  EXPECT_EQ(8192U, top[0].count);
+  EXPECT_EQ(8292U, op.sketch().total());
+}
+
+TEST(HeavyHittersOperatorTest, CustomConfig) {
+  const HeavyHittersConfig kConfig = { NULL, NULL, "content.Value", NULL };
+  HeavyHittersOperator op(kConfig, 10);
+
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<event::IntValue>("Value", -3);
+  scoped_ptr<StructValue> payload(new StructValue());
+  payload->AddField("content", content.PassAs<event::Value>());
+  event::Event event(0, payload.PassAs<const event::Value>());
+  op.Receive(event);
+  op.Receive(event);
+
+  std::vector<HeavyHitters::Counter> top;
+  op.sketch().GetTop(1, &top);
+  ASSERT_EQ(1U, top.size());
+  EXPECT_EQ("-3", top[0].key);
+  EXPECT_EQ(2U, top[0].count);
+}
+
+TEST(HeavyHittersOperatorTest, ValueToKey) {
+  std::string key;
+  event::StringValue string_value("name");
+  EXPECT_TRUE(ValueToKey(&string_value, &key));
+  EXPECT_EQ("name", key);
+  event::WStringValue wstring_value(L"wide");
+  EXPECT_TRUE(ValueToKey(&wstring_value, &key));
+  EXPECT_EQ("wide", key);
+  event::ULongValue address(0xFFFFF800);
+  EXPECT_TRUE(ValueToKey(&address, &key));
+  EXPECT_EQ("0xfffff800", key);
+  event::DoubleValue floating(1.5);
+  EXPECT_FALSE(ValueToKey(&floating, &key));
+  EXPECT_FALSE(ValueToKey(NULL, &key));
+}
+
+}  // namespace analysis
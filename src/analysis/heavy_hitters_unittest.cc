@@ -0,0 +1,139 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/heavy_hitters.h"
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+std::string MakeKey(size_t index) {
+  std::ostringstream key;
+  key << "key" << index;
+  return key.str();
+}
+
+}  // namespace
+
+TEST(HeavyHittersTest, Exact) {
+  HeavyHitters sketch(10);
+  sketch.Add("a", 1);
+  sketch.Add("b", 5);
+  sketch.Add("a", 2);
+  sketch.Add("c", 1);
+
+  EXPECT_EQ(3U, sketch.size());
+  EXPECT_EQ(9U, sketch.total());
+  EXPECT_EQ(0U, sketch.MinCount());
+
+  std::vector<HeavyHitters::Counter> top;
+  sketch.GetTop(2, &top);
+  ASSERT_EQ(2U, top.size());
+  EXPECT_EQ("b", top[0].key);
+  EXPECT_EQ(5U, top[0].count);
+  EXPECT_EQ("a", top[1].key);
+  EXPECT_EQ(3U, top[1].count);
+  EXPECT_EQ(0U, top[1].error);
+
+  sketch.GetTop(100, &top);
+  EXPECT_EQ(3U, top.size());
+}
+
+TEST(HeavyHittersTest, ReplaceSmallest) {
+  HeavyHitters sketch(2);
+  sketch.Add("a", 10);
+  sketch.Add("b", 2);
+  sketch.Add("c", 1);
+
+  // "c" replaces "b" and inherits its count as error.
+  EXPECT_EQ(2U, sketch.size());
+  std::vector<HeavyHitters::Counter> top;
+  sketch.GetTop(2, &top);
+  ASSERT_EQ(2U, top.size());
+  EXPECT_EQ("a", top[0].key);
+  EXPECT_EQ("c", top[1].key);
+  EXPECT_EQ(3U, top[1].count);
+  EXPECT_EQ(2U, top[1].error);
+  EXPECT_EQ(3U, sketch.MinCount());
+}
+
+TEST(HeavyHittersTest, FindsFrequentKeys) {
+  // 3 frequent keys among a long tail of rare keys.
+  HeavyHitters sketch(50);
+  for (size_t i = 0; i < 10000; ++i) {
+    sketch.Add(MakeKey(i % 3), 1);
+    sketch.Add(MakeKey(1000 + i), 1);
+  }
+
+  std::vector<HeavyHitters::Counter> top;
+  sketch.GetTop(3, &top);
+  ASSERT_EQ(3U, top.size());
+  for (size_t i = 0; i < top.size(); ++i) {
+    EXPECT_TRUE(top[i].key == "key0" || top[i].key == "key1" ||
+                top[i].key == "key2");
+    EXPECT_LE(3333U, top[i].count);
+    EXPECT_GE(top[i].count - top[i].error, 3333U);
+  }
+  EXPECT_EQ(50U, sketch.size());
+}
+
+TEST(HeavyHittersTest, Merge) {
+  HeavyHitters first(3);
+  first.Add("a", 10);
+  first.Add("b", 5);
+  first.Add("c", 1);
+  HeavyHitters second(3);
+  second.Add("a", 4);
+  second.Add("d", 8);
+
+  first.Merge(second);
+  EXPECT_EQ(28U, first.total());
+  EXPECT_EQ(3U, first.size());
+
+  std::vector<HeavyHitters::Counter> top;
+  first.GetTop(3, &top);
+  ASSERT_EQ(3U, top.size());
+  EXPECT_EQ("a", top[0].key);
+  EXPECT_EQ(14U, top[0].count);
+  EXPECT_EQ(0U, top[0].error);
+  // "d" was not monitored by the full first sketch: it may have had up to
+  // its minimal count.
+  EXPECT_EQ("d", top[1].key);
+  EXPECT_EQ(9U, top[1].count);
+  EXPECT_EQ(1U, top[1].error);
+  EXPECT_EQ("b", top[2].key);
+  EXPECT_EQ(5U, top[2].count);
+
+  // The merged sketch keeps working.
+  first.Add("e", 1);
+  EXPECT_EQ(3U, first.size());
+  EXPECT_EQ(29U, first.total());
+}
+
+}  // namespace analysis
@@ -0,0 +1,135 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/histogram.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+// log2(Histogram::kSubBuckets).
+const size_t kSubBucketBits = 3;
+
+COMPILE_ASSERT(Histogram::kSubBuckets == 1 << kSubBucketBits,
+               sub_bucket_bits_matches_sub_buckets);
+
+// @returns the index of the most significant bit of |value|, which must not
+//     be zero.
+size_t HighestBit(uint64 value) {
+  DCHECK_NE(0U, value);
+  size_t bit = 0;
+  for (size_t shift = 32; shift != 0; shift /= 2) {
+    if ((value >> shift) != 0) {
+      value >>= shift;
+      bit += shift;
+    }
+  }
+  return bit;
+}
+
+}  // namespace
+
+const size_t Histogram::kSubBuckets;
+const size_t Histogram::kBucketCount;
+
+Histogram::Histogram()
+    : count_(0),
+      sum_(0),
+      min_(0),
+      max_(0) {
+}
+
+void Histogram::Add(uint64 value) {
+  if (buckets_.empty())
+    buckets_.resize(kBucketCount, 0);
+  ++buckets_[BucketIndex(value)];
+
+  if (count_ == 0 || value < min_)
+    min_ = value;
+  if (value > max_)
+    max_ = value;
+  ++count_;
+  sum_ += value;
+}
+
+void Histogram::Merge(const Histogram& other) {
+  DCHECK(&other != this);
+  if (other.count_ == 0)
+    return;
+  if (buckets_.empty())
+    buckets_.resize(kBucketCount, 0);
+  for (size_t i = 0; i < kBucketCount; ++i)
+    buckets_[i] += other.buckets_[i];
+
+  if (count_ == 0 || other.min_ < min_)
+    min_ = other.min_;
+  max_ = std::max(max_, other.max_);
+  count_ += other.count_;
+  sum_ += other.sum_;
+}
+
+uint64 Histogram::Percentile(double percentile) const {
+  if (count_ == 0)
+    return 0;
+
+  double rank = percentile / 100.0 * static_cast<double>(count_);
+  uint64 target = static_cast<uint64>(rank);
+  if (static_cast<double>(target) < rank)
+    ++target;
+  target = std::max<uint64>(1, std::min(target, count_));
+
+  uint64 seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= target)
+      return std::min(BucketUpperBound(i), max_);
+  }
+  return max_;
+}
+
+size_t Histogram::BucketIndex(uint64 value) {
+  if (value < 2 * kSubBuckets)
+    return static_cast<size_t>(value);
+  size_t bit = HighestBit(value);
+  size_t sub = static_cast<size_t>(value >> (bit - kSubBucketBits)) &
+               (kSubBuckets - 1);
+  return 2 * kSubBuckets + (bit - kSubBucketBits - 1) * kSubBuckets + sub;
+}
+
+uint64 Histogram::BucketUpperBound(size_t index) {
+  DCHECK_LT(index, kBucketCount);
+  if (index < 2 * kSubBuckets)
+    return index;
+  size_t bit = (index - 2 * kSubBuckets) / kSubBuckets + kSubBucketBits + 1;
+  uint64 sub = (index - 2 * kSubBuckets) % kSubBuckets;
+  uint64 lower = (kSubBuckets + sub) << (bit - kSubBucketBits);
+  return lower + ((static_cast<uint64>(1) << (bit - kSubBucketBits)) - 1);
+}
+
+}  // namespace analysis
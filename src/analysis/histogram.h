@@ -0,0 +1,103 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A histogram of durations with a bounded relative error. Small values have
+// a bucket each; larger values are split by powers of two, and each power of
+// two is split into kSubBuckets linear buckets. The error of a percentile is
+// below 1 / kSubBuckets of its value, and a histogram has a fixed size
+// whatever the number and the range of its values.
+//
+// Usage example:
+//   Histogram histogram;
+//   histogram.Add(duration);
+//   ...
+//   uint64 p99 = histogram.Percentile(99.0);
+
+#ifndef ANALYSIS_HISTOGRAM_H_
+#define ANALYSIS_HISTOGRAM_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "base/base.h"
+
+namespace analysis {
+
+class Histogram {
+ public:
+  // The number of linear buckets per power of two.
+  static const size_t kSubBuckets = 8;
+
+  // The total number of buckets.
+  static const size_t kBucketCount = 2 * kSubBuckets + 60 * kSubBuckets;
+
+  Histogram();
+
+  // Adds a value.
+  // @param value the value to add.
+  void Add(uint64 value);
+
+  // Adds the values of another histogram.
+  // @param other the histogram to merge into this one. Must not be this
+  //     histogram.
+  void Merge(const Histogram& other);
+
+  // @param percentile the percentile, between 0 and 100.
+  // @returns an upper bound of the value at |percentile|, or 0 if the
+  //     histogram is empty.
+  uint64 Percentile(double percentile) const;
+
+  // @returns the average of the values, or 0 if the histogram is empty.
+  uint64 Mean() const { return count_ == 0 ? 0 : sum_ / count_; }
+
+  // Accessors.
+  // @{
+  uint64 count() const { return count_; }
+  uint64 sum() const { return sum_; }
+  uint64 min() const { return min_; }
+  uint64 max() const { return max_; }
+  // @}
+
+  // @param value a value.
+  // @returns the index of the bucket holding |value|.
+  static size_t BucketIndex(uint64 value);
+
+  // @param index the index of a bucket.
+  // @returns the largest value of the bucket |index|.
+  static uint64 BucketUpperBound(size_t index);
+
+ private:
+  // The number of values in each bucket. Allocated on the first value.
+  std::vector<uint64> buckets_;
+
+  uint64 count_;
+  uint64 sum_;
+  uint64 min_;
+  uint64 max_;
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_HISTOGRAM_H_
@@ -0,0 +1,104 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/histogram.h"
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+TEST(HistogramTest, Empty) {
+  Histogram histogram;
+  EXPECT_EQ(0U, histogram.count());
+  EXPECT_EQ(0U, histogram.Mean());
+  EXPECT_EQ(0U, histogram.Percentile(50.0));
+}
+
+TEST(HistogramTest, SmallValuesAreExact) {
+  Histogram histogram;
+  for (uint64 i = 1; i <= 10; ++i)
+    histogram.Add(i);
+
+  EXPECT_EQ(10U, histogram.count());
+  EXPECT_EQ(55U, histogram.sum());
+  EXPECT_EQ(1U, histogram.min());
+  EXPECT_EQ(10U, histogram.max());
+  EXPECT_EQ(5U, histogram.Mean());
+  EXPECT_EQ(5U, histogram.Percentile(50.0));
+  EXPECT_EQ(9U, histogram.Percentile(90.0));
+  EXPECT_EQ(10U, histogram.Percentile(100.0));
+  EXPECT_EQ(1U, histogram.Percentile(0.0));
+}
+
+TEST(HistogramTest, RelativeError) {
+  Histogram histogram;
+  for (uint64 i = 1; i <= 100000; ++i)
+    histogram.Add(i * 10);
+
+  uint64 p50 = histogram.Percentile(50.0);
+  EXPECT_LE(500000U, p50);
+  EXPECT_GE(500000U + 500000U / Histogram::kSubBuckets, p50);
+  uint64 p99 = histogram.Percentile(99.0);
+  EXPECT_LE(990000U, p99);
+  EXPECT_GE(990000U + 990000U / Histogram::kSubBuckets, p99);
+  EXPECT_EQ(1000000U, histogram.Percentile(100.0));
+}
+
+TEST(HistogramTest, Buckets) {
+  uint64 previous = 0;
+  for (size_t i = 0; i < Histogram::kBucketCount; ++i) {
+    uint64 lower = (i == 0) ? 0 : previous + 1;
+    uint64 upper = Histogram::BucketUpperBound(i);
+    EXPECT_LE(lower, upper);
+    EXPECT_EQ(i, Histogram::BucketIndex(lower));
+    EXPECT_EQ(i, Histogram::BucketIndex(upper));
+    previous = upper;
+  }
+  EXPECT_EQ(~static_cast<uint64>(0), previous);
+}
+
+TEST(HistogramTest, Merge) {
+  Histogram histogram;
+  histogram.Add(10);
+  Histogram other;
+  other.Add(2);
+  other.Add(1000);
+
+  histogram.Merge(other);
+  EXPECT_EQ(3U, histogram.count());
+  EXPECT_EQ(1012U, histogram.sum());
+  EXPECT_EQ(2U, histogram.min());
+  EXPECT_EQ(1000U, histogram.max());
+  EXPECT_EQ(10U, histogram.Percentile(50.0));
+
+  Histogram empty;
+  histogram.Merge(empty);
+  EXPECT_EQ(3U, histogram.count());
+  empty.Merge(histogram);
+  EXPECT_EQ(3U, empty.count());
+  EXPECT_EQ(2U, empty.min());
+}
+
+}  // namespace analysis
@@ -0,0 +1,148 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A map from 32-bit identifiers (thread, process or processor identifiers) to
+// values, with constant-time lookups. Identifiers are never removed: the size
+// of the map is bounded by the number of distinct identifiers of a trace, not
+// by its number of events. Kernel object addresses can be used as 64-bit
+// identifiers with IdMap<T, uint64>.
+//
+// Usage example:
+//   IdMap<ThreadState> threads;
+//   ThreadState* state = threads.FindOrInsert(thread_id);
+//   ...
+//   const ThreadState* other = threads.Find(other_thread_id);  // or NULL.
+
+#ifndef ANALYSIS_ID_MAP_H_
+#define ANALYSIS_ID_MAP_H_
+
+#include <utility>
+#include <vector>
+
+#include "base/base.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+template <typename T, typename Id = uint32>
+class IdMap {
+ public:
+  typedef std::pair<Id, T> Entry;
+  typedef typename std::vector<Entry>::iterator iterator;
+  typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+  IdMap() : slots_(kInitialSlotCount, 0) {}
+
+  // @param id an identifier.
+  // @returns the value of |id|, or NULL if |id| is not in the map.
+  T* Find(Id id) {
+    size_t slot = FindSlot(id);
+    if (slots_[slot] == 0)
+      return NULL;
+    return &entries_[slots_[slot] - 1].second;
+  }
+
+  const T* Find(Id id) const {
+    return const_cast<IdMap*>(this)->Find(id);
+  }
+
+  // @param id an identifier.
+  // @returns the value of |id|, default-constructed if |id| was not in the
+  //     map. The pointer is valid until the next insertion.
+  T* FindOrInsert(Id id) {
+    size_t slot = FindSlot(id);
+    if (slots_[slot] != 0)
+      return &entries_[slots_[slot] - 1].second;
+
+    entries_.push_back(Entry(id, T()));
+    slots_[slot] = static_cast<uint32>(entries_.size());
+
+    // Keep the load factor under one half.
+    if (2 * entries_.size() > slots_.size())
+      Grow();
+
+    return &entries_.back().second;
+  }
+
+  // @returns the number of identifiers in the map.
+  size_t size() const { return entries_.size(); }
+
+  // Iterates over the entries, in insertion order.
+  // @{
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+  // @}
+
+ private:
+  static const size_t kInitialSlotCount = 256;
+
+  // @returns the slot of |id|, or the empty slot where it would be inserted.
+  size_t FindSlot(Id id) const {
+    size_t mask = slots_.size() - 1;
+    size_t slot = Scramble(id) & mask;
+    while (slots_[slot] != 0 && entries_[slots_[slot] - 1].first != id)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  // Thread and process identifiers are multiples of 4, and kernel addresses
+  // are aligned: spread their bits before masking them.
+  // @{
+  static size_t Scramble(uint32 id) {
+    return static_cast<size_t>(id * 0x9E3779B1U) >> 8;
+  }
+  static size_t Scramble(uint64 id) {
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 24);
+  }
+  // @}
+
+  // Doubles the number of slots.
+  void Grow() {
+    slots_.assign(2 * slots_.size(), 0);
+    size_t mask = slots_.size() - 1;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      size_t slot = Scramble(entries_[i].first) & mask;
+      while (slots_[slot] != 0)
+        slot = (slot + 1) & mask;
+      slots_[slot] = static_cast<uint32>(i + 1);
+    }
+  }
+
+  // The entries, in insertion order.
+  std::vector<Entry> entries_;
+
+  // An open-addressing hash table of the entries. A slot holds the index of
+  // an entry plus one, or zero when empty. The number of slots is a power of
+  // two.
+  std::vector<uint32> slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(IdMap);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_ID_MAP_H_
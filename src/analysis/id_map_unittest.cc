@@ -0,0 +1,96 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/id_map.h"
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+TEST(IdMapTest, FindOrInsert) {
+  IdMap<int> map;
+  EXPECT_EQ(NULL, map.Find(4));
+
+  *map.FindOrInsert(4) = 42;
+  *map.FindOrInsert(8) = 43;
+  EXPECT_EQ(2U, map.size());
+  ASSERT_TRUE(map.Find(4) != NULL);
+  EXPECT_EQ(42, *map.Find(4));
+  EXPECT_EQ(43, *map.FindOrInsert(8));
+  EXPECT_EQ(2U, map.size());
+  EXPECT_EQ(NULL, map.Find(12));
+}
+
+TEST(IdMapTest, Grow) {
+  const uint32 kCount = 10000;
+  IdMap<uint32> map;
+  for (uint32 i = 0; i < kCount; ++i)
+    *map.FindOrInsert(i * 4) = i;
+  EXPECT_EQ(kCount, map.size());
+
+  for (uint32 i = 0; i < kCount; ++i) {
+    const IdMap<uint32>& const_map = map;
+    const uint32* value = const_map.Find(i * 4);
+    ASSERT_TRUE(value != NULL);
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_EQ(NULL, map.Find(2));
+}
+
+TEST(IdMapTest, Iterate) {
+  IdMap<int> map;
+  *map.FindOrInsert(8) = 1;
+  *map.FindOrInsert(4) = 2;
+
+  IdMap<int>::const_iterator it = map.begin();
+  ASSERT_TRUE(it != map.end());
+  EXPECT_EQ(8U, it->first);
+  EXPECT_EQ(1, it->second);
+  ++it;
+  ASSERT_TRUE(it != map.end());
+  EXPECT_EQ(4U, it->first);
+  EXPECT_EQ(2, it->second);
+  ++it;
+  EXPECT_TRUE(it == map.end());
+}
+
+TEST(IdMapTest, LongIds) {
+  const uint64 kBase = 0xFFFFFA8001000000ULL;
+  const uint32 kCount = 1000;
+  IdMap<uint32, uint64> map;
+  for (uint32 i = 0; i < kCount; ++i)
+    *map.FindOrInsert(kBase + i * 0x40) = i;
+  EXPECT_EQ(kCount, map.size());
+
+  for (uint32 i = 0; i < kCount; ++i) {
+    const uint32* value = map.Find(kBase + i * 0x40);
+    ASSERT_TRUE(value != NULL);
+    EXPECT_EQ(i, *value);
+  }
+  EXPECT_EQ(NULL, map.Find(kBase + 0x20));
+  EXPECT_EQ(NULL, map.Find(kBase & 0xFFFFFFFFULL));
+}
+
+}  // namespace analysis
@@ -0,0 +1,286 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/interrupt_analyzer.h"
+
+#include <algorithm>
+
+#include "analysis/kernel_event.h"
+#include "analysis/report_utils.h"
+#include "base/logging.h"
+#include "base/string_utils.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::Timestamp;
+
+const char kUnknownModuleName[] = "<unknown>";
+
+const char* const kInterruptTypeNames[INTERRUPT_TYPE_COUNT] = { "ISR", "DPC" };
+
+// @returns the file name of |path|, without its directory.
+std::string GetBaseName(const std::string& path) {
+  size_t separator = path.find_last_of("\\/");
+  if (separator == std::string::npos)
+    return path;
+  return path.substr(separator + 1);
+}
+
+}  // namespace
+
+const char InterruptAnalyzer::kKernelModuleName[] = "<kernel>";
+
+InterruptAnalyzer::InterruptAnalyzer(size_t top_count)
+    : kernel_base_(0),
+      kernel_slot_(0),
+      top_count_(top_count),
+      invalid_routines_(0) {
+  slot_names_.push_back(kUnknownModuleName);
+}
+
+void InterruptAnalyzer::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event))
+    return;
+  const StructValue* content = kernel_event.content();
+  const std::string& operation = kernel_event.operation();
+
+  if (kernel_event.category() == "PerfInfo") {
+    InterruptType type;
+    if (operation == "ISR" || operation == "ISR-MSI") {
+      type = INTERRUPT_ISR;
+    } else if (operation == "DPC" || operation == "ThreadedDPC" ||
+               operation == "TimerDPC") {
+      type = INTERRUPT_DPC;
+    } else {
+      return;
+    }
+
+    uint64 initial_time = 0;
+    uint64 routine = 0;
+    if (!content->GetFieldAsULong("InitialTime", &initial_time) ||
+        !content->GetFieldAsULong("Routine", &routine)) {
+      return;
+    }
+    AddRoutine(type, kernel_event.timestamp(),
+               kernel_event.processor_number(), initial_time, routine);
+    return;
+  }
+
+  if (kernel_event.category() != "Image")
+    return;
+
+  uint64 base = 0;
+  if (!content->GetFieldAsULong("BaseAddress", &base))
+    return;
+
+  if (operation == "KernelBase") {
+    SetKernelBase(base);
+    return;
+  }
+
+  if (operation != "Load" && operation != "DCStart")
+    return;
+
+  // Only the modules of the System process hold interrupt routines. The
+  // version 0 of the event has no process.
+  uint32 process_id = 0;
+  if (content->GetField("ProcessId") != NULL &&
+      (!content->GetFieldAsUInteger("ProcessId", &process_id) ||
+       process_id != 0)) {
+    return;
+  }
+
+  uint64 size = 0;
+  std::wstring name;
+  if (!content->GetFieldAsULong("ModuleSize", &size) ||
+      !content->GetFieldAsWString("ImageFileName", &name)) {
+    return;
+  }
+  AddModule(base, size, GetBaseName(base::WStringToString(name)));
+}
+
+void InterruptAnalyzer::AddModule(uint64 base,
+                                  uint64 size,
+                                  const std::string& name) {
+  // The slots are indexed by the identifiers of the module index.
+  uint32 id = modules_.AddModule(base, size, name);
+  if (id >= module_slots_.size())
+    module_slots_.resize(id + 1);
+  module_slots_[id] = GetModuleSlot(name);
+}
+
+void InterruptAnalyzer::SetKernelBase(uint64 base) {
+  kernel_base_ = base;
+  kernel_slot_ = GetModuleSlot(kKernelModuleName);
+}
+
+void InterruptAnalyzer::AddRoutine(InterruptType type,
+                                   Timestamp timestamp,
+                                   uint32 processor,
+                                   Timestamp initial_time,
+                                   uint64 routine) {
+  DCHECK_LT(type, INTERRUPT_TYPE_COUNT);
+
+  if (timestamp < initial_time) {
+    ++invalid_routines_;
+    return;
+  }
+  uint64 duration = timestamp - initial_time;
+
+  GetHistogram(&module_durations_[type], LookupModuleSlot(routine))->Add(
+      duration);
+  GetHistogram(&processor_durations_[type], processor)->Add(duration);
+
+  if (top_count_ == 0)
+    return;
+  if (top_offenders_.size() == top_count_) {
+    if (duration <= top_offenders_.front().duration)
+      return;
+    std::pop_heap(top_offenders_.begin(), top_offenders_.end(),
+                  LongerOffender());
+    top_offenders_.pop_back();
+  }
+  Offender offender = { type, timestamp, duration, routine, processor };
+  top_offenders_.push_back(offender);
+  std::push_heap(top_offenders_.begin(), top_offenders_.end(),
+                 LongerOffender());
+}
+
+const Histogram* InterruptAnalyzer::GetModuleDurations(
+    InterruptType type, const std::string& module_name) const {
+  DCHECK_LT(type, INTERRUPT_TYPE_COUNT);
+
+  uint32 slot = 0;
+  if (module_name != kUnknownModuleName) {
+    std::map<std::string, uint32>::const_iterator it =
+        slots_by_name_.find(module_name);
+    if (it == slots_by_name_.end())
+      return NULL;
+    slot = it->second;
+  }
+
+  const std::vector<Histogram>& durations = module_durations_[type];
+  if (slot >= durations.size() || durations[slot].count() == 0)
+    return NULL;
+  return &durations[slot];
+}
+
+const Histogram* InterruptAnalyzer::GetProcessorDurations(
+    InterruptType type, uint32 processor) const {
+  DCHECK_LT(type, INTERRUPT_TYPE_COUNT);
+
+  const std::vector<Histogram>& durations = processor_durations_[type];
+  if (processor >= durations.size() || durations[processor].count() == 0)
+    return NULL;
+  return &durations[processor];
+}
+
+std::vector<InterruptAnalyzer::Offender>
+InterruptAnalyzer::GetTopOffenders() const {
+  std::vector<Offender> offenders(top_offenders_);
+  std::sort(offenders.begin(), offenders.end(), LongerOffender());
+  return offenders;
+}
+
+std::string InterruptAnalyzer::GetModuleName(uint64 address) const {
+  uint32 slot = LookupModuleSlot(address);
+  if (slot == 0)
+    return std::string();
+  return slot_names_[slot];
+}
+
+bool InterruptAnalyzer::WriteReport(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  for (int type = 0; type < INTERRUPT_TYPE_COUNT; ++type) {
+    const std::vector<Histogram>& durations = module_durations_[type];
+    for (size_t slot = 0; slot < durations.size(); ++slot) {
+      if (durations[slot].count() == 0)
+        continue;
+      *out << kInterruptTypeNames[type] << " module " << slot_names_[slot]
+           << ' ';
+      WriteHistogramSummary(durations[slot], out);
+      out->put('\n');
+    }
+  }
+
+  for (int type = 0; type < INTERRUPT_TYPE_COUNT; ++type) {
+    const std::vector<Histogram>& durations = processor_durations_[type];
+    for (size_t processor = 0; processor < durations.size(); ++processor) {
+      if (durations[processor].count() == 0)
+        continue;
+      *out << kInterruptTypeNames[type] << " cpu " << processor << ' ';
+      WriteHistogramSummary(durations[processor], out);
+      out->put('\n');
+    }
+  }
+
+  std::vector<Offender> offenders(GetTopOffenders());
+  for (size_t i = 0; i < offenders.size(); ++i) {
+    const Offender& offender = offenders[i];
+    *out << kInterruptTypeNames[offender.type] << " top "
+         << offender.duration << ' ';
+    WriteHex(offender.routine, out);
+    *out << ' ' << slot_names_[LookupModuleSlot(offender.routine)]
+         << ' ' << offender.processor
+         << ' ' << offender.timestamp << '\n';
+  }
+
+  return out->good();
+}
+
+uint32 InterruptAnalyzer::LookupModuleSlot(uint64 address) const {
+  uint32 id = modules_.Lookup(address);
+  if (id != ModuleIndex::kUnknownModule)
+    return module_slots_[id];
+  if (kernel_base_ != 0 && address >= kernel_base_)
+    return kernel_slot_;
+  return 0;
+}
+
+uint32 InterruptAnalyzer::GetModuleSlot(const std::string& name) {
+  std::map<std::string, uint32>::iterator it = slots_by_name_.find(name);
+  if (it != slots_by_name_.end())
+    return it->second;
+
+  uint32 slot = static_cast<uint32>(slot_names_.size());
+  slot_names_.push_back(name);
+  slots_by_name_[name] = slot;
+  return slot;
+}
+
+Histogram* InterruptAnalyzer::GetHistogram(std::vector<Histogram>* histograms,
+                                           size_t index) {
+  DCHECK(histograms != NULL);
+  if (index >= histograms->size())
+    histograms->resize(index + 1);
+  return &(*histograms)[index];
+}
+
+}  // namespace analysis
@@ -0,0 +1,189 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An interrupt analyzer computes how long the interrupt service routines
+// (ISR) and the deferred procedure calls (DPC) ran. The PerfInfo events of
+// an ISR or a DPC are emitted when the routine returns, and carry the time
+// it started as "InitialTime": the duration is the difference between the
+// timestamp of the event and this time.
+//
+// The routines are attributed to the kernel modules reported by the Image
+// events of the System process, using a ModuleIndex. The addresses outside
+// of these modules but above the address given by the Image/KernelBase event
+// are attributed to the kernel.
+//
+// Usage example:
+//   InterruptAnalyzer analyzer(20);
+//   parser.Parse(base::MakeObserver(&analyzer, &InterruptAnalyzer::Receive));
+//   analyzer.WriteReport(&std::cout);
+
+#ifndef ANALYSIS_INTERRUPT_ANALYZER_H_
+#define ANALYSIS_INTERRUPT_ANALYZER_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "analysis/histogram.h"
+#include "analysis/module_index.h"
+#include "base/base.h"
+#include "event/event.h"
+
+namespace analysis {
+
+enum InterruptType {
+  INTERRUPT_ISR,
+  INTERRUPT_DPC,
+  INTERRUPT_TYPE_COUNT
+};
+
+class InterruptAnalyzer {
+ public:
+  // The name of the module holding the addresses above the kernel base.
+  static const char kKernelModuleName[];
+
+  // A long-running routine.
+  struct Offender {
+    InterruptType type;
+    event::Timestamp timestamp;
+    uint64 duration;
+    uint64 routine;
+    uint32 processor;
+  };
+
+  // @param top_count the number of longest routines to keep.
+  explicit InterruptAnalyzer(size_t top_count);
+
+  // Consumes an event of the ETW parser. Events other than the ISR, the DPC
+  // and the kernel Image events are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Adds a kernel module.
+  // @param base the base address of the module.
+  // @param size the size of the module, in bytes.
+  // @param name the name of the module.
+  void AddModule(uint64 base, uint64 size, const std::string& name);
+
+  // Sets the base address of the kernel.
+  // @param base the base address reported by the Image/KernelBase event.
+  void SetKernelBase(uint64 base);
+
+  // Adds the execution of a routine.
+  // @param type the type of the routine.
+  // @param timestamp the time the routine returned.
+  // @param processor the processor that ran the routine.
+  // @param initial_time the time the routine started.
+  // @param routine the address of the routine.
+  void AddRoutine(InterruptType type,
+                  event::Timestamp timestamp,
+                  uint32 processor,
+                  event::Timestamp initial_time,
+                  uint64 routine);
+
+  // @param type the type of routines.
+  // @param module_name the name of a module.
+  // @returns the durations of the routines of type |type| in |module_name|,
+  //     or NULL if there is none.
+  const Histogram* GetModuleDurations(InterruptType type,
+                                      const std::string& module_name) const;
+
+  // @param type the type of routines.
+  // @param processor a processor.
+  // @returns the durations of the routines of type |type| that ran on
+  //     |processor|, or NULL if there is none.
+  const Histogram* GetProcessorDurations(InterruptType type,
+                                         uint32 processor) const;
+
+  // @returns the longest routines, longest first.
+  std::vector<Offender> GetTopOffenders() const;
+
+  // @param address an address.
+  // @returns the name of the module containing |address|, or an empty
+  //     string if unknown.
+  std::string GetModuleName(uint64 address) const;
+
+  // Writes the durations per module and per processor, then the longest
+  // routines:
+  //   "<ISR|DPC> module <name> <count> <mean> <p50> <p90> <p99> <max>"
+  //   "<ISR|DPC> cpu <processor> <count> <mean> <p50> <p90> <p99> <max>"
+  //   "<ISR|DPC> top <duration> <routine> <module> <processor> <timestamp>"
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteReport(std::ostream* out) const;
+
+  // @returns the number of routines with an initial time after their end.
+  uint64 invalid_routines() const { return invalid_routines_; }
+
+ private:
+  // Orders the offenders so that the shortest one is at the top of a heap.
+  struct LongerOffender {
+    bool operator()(const Offender& left, const Offender& right) const {
+      return left.duration > right.duration;
+    }
+  };
+
+  // @returns the slot of the module containing |address|.
+  uint32 LookupModuleSlot(uint64 address) const;
+
+  // @returns the slot of the module named |name|, created if needed.
+  uint32 GetModuleSlot(const std::string& name);
+
+  // @returns the histogram at |index| of |histograms|, created if needed.
+  static Histogram* GetHistogram(std::vector<Histogram>* histograms,
+                                 size_t index);
+
+  ModuleIndex modules_;
+
+  // The base address of the kernel, or zero if unknown.
+  uint64 kernel_base_;
+
+  // The modules with the same name share a slot. The slot 0 holds the
+  // routines of unknown modules.
+  std::map<std::string, uint32> slots_by_name_;
+  std::vector<std::string> slot_names_;
+  // The slot of each module, indexed by module identifier.
+  std::vector<uint32> module_slots_;
+  uint32 kernel_slot_;
+
+  // The durations per module slot.
+  std::vector<Histogram> module_durations_[INTERRUPT_TYPE_COUNT];
+
+  // The durations per processor.
+  std::vector<Histogram> processor_durations_[INTERRUPT_TYPE_COUNT];
+
+  // A min-heap of the longest routines.
+  size_t top_count_;
+  std::vector<Offender> top_offenders_;
+
+  uint64 invalid_routines_;
+
+  DISALLOW_COPY_AND_ASSIGN(InterruptAnalyzer);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_INTERRUPT_ANALYZER_H_
@@ -0,0 +1,62 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/interrupt_analyzer.h"
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+const size_t kRoutines = 1000000;
+const size_t kModules = 300;
+const uint64 kModuleSize = 0x100000;
+const uint64 kFirstModule = 0xFFFFF88000000000ULL;
+
+}  // namespace
+
+TEST(InterruptAnalyzerPerfTest, AddRoutine) {
+  InterruptAnalyzer analyzer(100);
+  for (size_t i = 0; i < kModules; ++i) {
+    analyzer.AddModule(kFirstModule + i * kModuleSize, kModuleSize,
+                       "driver.sys");
+  }
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kRoutines; ++i) {
+    uint64 routine = kFirstModule + ((i * 7919) % kModules) * kModuleSize;
+    analyzer.AddRoutine(INTERRUPT_DPC, i * 100 + i % 97, i % 64, i * 100,
+                        routine + 0x100);
+  }
+  base::PrintPerfResult("AddRoutine", "time", timer.ElapsedNanoseconds(),
+                        kRoutines, "ns/routine");
+
+  EXPECT_EQ(kRoutines,
+            analyzer.GetModuleDurations(INTERRUPT_DPC, "driver.sys")->count());
+}
+
+}  // namespace analysis
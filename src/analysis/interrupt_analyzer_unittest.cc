@@ -0,0 +1,166 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/interrupt_analyzer.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::WStringValue;
+
+const uint64 kKernelBase = 0xFFFFF80000000000ULL;
+const uint64 kNdisBase = 0xFFFFF88000100000ULL;
+const uint64 kStorportBase = 0xFFFFF88000200000ULL;
+
+void SendModule(InterruptAnalyzer* analyzer,
+                const char* operation,
+                uint32 process_id,
+                uint64 base,
+                uint64 size,
+                const std::wstring& name) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("BaseAddress", base);
+  content->AddField<ULongValue>("ModuleSize", size);
+  content->AddField<UIntValue>("ProcessId", process_id);
+  content->AddField<WStringValue>("ImageFileName", name);
+  analyzer->Receive(*CreateKernelEvent(0, "Image", operation, 0, 0, 0,
+                                       content.Pass()).get());
+}
+
+void SendRoutine(InterruptAnalyzer* analyzer,
+                 const char* operation,
+                 event::Timestamp timestamp,
+                 uint32 processor,
+                 event::Timestamp initial_time,
+                 uint64 routine) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("InitialTime", initial_time);
+  content->AddField<ULongValue>("Routine", routine);
+  analyzer->Receive(*CreateKernelEvent(timestamp, "PerfInfo", operation, 0, 0,
+                                       processor, content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(InterruptAnalyzerTest, DurationsPerModule) {
+  InterruptAnalyzer analyzer(10);
+  SendModule(&analyzer, "DCStart", 0, kNdisBase, 0x10000,
+             L"\\SystemRoot\\system32\\drivers\\ndis.sys");
+  SendModule(&analyzer, "Load", 0, kStorportBase, 0x10000,
+             L"\\SystemRoot\\System32\\drivers\\storport.sys");
+  // User-mode modules are ignored.
+  SendModule(&analyzer, "Load", 1234, kNdisBase, 0x10000, L"user.dll");
+
+  SendRoutine(&analyzer, "ISR", 110, 0, 100, kNdisBase + 0x100);
+  SendRoutine(&analyzer, "ISR-MSI", 230, 1, 200, kNdisBase + 0x200);
+  SendRoutine(&analyzer, "DPC", 350, 0, 300, kStorportBase + 0x100);
+  SendRoutine(&analyzer, "ThreadedDPC", 420, 1, 400, kStorportBase + 0x10);
+  SendRoutine(&analyzer, "TimerDPC", 505, 1, 500, 0x1000);
+
+  const Histogram* ndis = analyzer.GetModuleDurations(INTERRUPT_ISR,
+                                                      "ndis.sys");
+  ASSERT_TRUE(ndis != NULL);
+  EXPECT_EQ(2U, ndis->count());
+  EXPECT_EQ(10U, ndis->min());
+  EXPECT_EQ(30U, ndis->max());
+  EXPECT_EQ(NULL, analyzer.GetModuleDurations(INTERRUPT_DPC, "ndis.sys"));
+  EXPECT_EQ(NULL, analyzer.GetModuleDurations(INTERRUPT_ISR, "user.dll"));
+
+  const Histogram* storport =
+      analyzer.GetModuleDurations(INTERRUPT_DPC, "storport.sys");
+  ASSERT_TRUE(storport != NULL);
+  EXPECT_EQ(2U, storport->count());
+  EXPECT_EQ(70U, storport->sum());
+
+  const Histogram* unknown =
+      analyzer.GetModuleDurations(INTERRUPT_DPC, "<unknown>");
+  ASSERT_TRUE(unknown != NULL);
+  EXPECT_EQ(5U, unknown->max());
+
+  const Histogram* cpu1 = analyzer.GetProcessorDurations(INTERRUPT_DPC, 1);
+  ASSERT_TRUE(cpu1 != NULL);
+  EXPECT_EQ(2U, cpu1->count());
+  EXPECT_EQ(25U, cpu1->sum());
+  EXPECT_EQ(NULL, analyzer.GetProcessorDurations(INTERRUPT_DPC, 2));
+}
+
+TEST(InterruptAnalyzerTest, KernelBase) {
+  InterruptAnalyzer analyzer(10);
+  analyzer.AddModule(kNdisBase, 0x10000, "ndis.sys");
+  EXPECT_EQ("", analyzer.GetModuleName(kKernelBase + 0x100));
+
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("BaseAddress", kKernelBase);
+  analyzer.Receive(*CreateKernelEvent(0, "Image", "KernelBase", 0, 0, 0,
+                                      content.Pass()).get());
+
+  EXPECT_EQ(InterruptAnalyzer::kKernelModuleName,
+            analyzer.GetModuleName(kKernelBase + 0x100));
+  EXPECT_EQ("ndis.sys", analyzer.GetModuleName(kNdisBase + 0x100));
+  EXPECT_EQ("", analyzer.GetModuleName(0x1000));
+}
+
+TEST(InterruptAnalyzerTest, TopOffenders) {
+  InterruptAnalyzer analyzer(3);
+  analyzer.AddModule(kNdisBase, 0x10000, "ndis.sys");
+  const uint64 kDurations[] = { 5, 50, 7, 40, 1, 60, 30 };
+  for (size_t i = 0; i < sizeof(kDurations) / sizeof(uint64); ++i) {
+    analyzer.AddRoutine(INTERRUPT_DPC, 1000 * i + kDurations[i], 0,
+                        1000 * i, kNdisBase + i);
+  }
+  analyzer.AddRoutine(INTERRUPT_DPC, 10, 0, 20, kNdisBase);
+  EXPECT_EQ(1U, analyzer.invalid_routines());
+
+  std::vector<InterruptAnalyzer::Offender> offenders =
+      analyzer.GetTopOffenders();
+  ASSERT_EQ(3U, offenders.size());
+  EXPECT_EQ(60U, offenders[0].duration);
+  EXPECT_EQ(kNdisBase + 5, offenders[0].routine);
+  EXPECT_EQ(50U, offenders[1].duration);
+  EXPECT_EQ(40U, offenders[2].duration);
+}
+
+TEST(InterruptAnalyzerTest, WriteReport) {
+  InterruptAnalyzer analyzer(1);
+  analyzer.AddModule(0x1000, 0x1000, "ndis.sys");
+  analyzer.AddRoutine(INTERRUPT_ISR, 15, 2, 10, 0x1010);
+
+  std::ostringstream out;
+  EXPECT_TRUE(analyzer.WriteReport(&out));
+  EXPECT_EQ("ISR module ndis.sys 1 5 5 5 5 5\n"
+            "ISR cpu 2 1 5 5 5 5 5\n"
+            "ISR top 5 0x1010 ndis.sys 2 15\n", out.str());
+}
+
+}  // namespace analysis
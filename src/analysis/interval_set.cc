@@ -0,0 +1,119 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/interval_set.h"
+
+#include <algorithm>
+
+namespace analysis {
+
+IntervalSet::IntervalSet() : size_(0) {
+}
+
+uint64 IntervalSet::Add(uint64 begin, uint64 end) {
+  if (begin >= end)
+    return 0;
+
+  uint64 previous_size = size_;
+
+  // Merge with a range ending at or after |begin|.
+  Ranges::iterator it = ranges_.upper_bound(begin);
+  if (it != ranges_.begin()) {
+    Ranges::iterator previous = it;
+    --previous;
+    if (previous->second >= begin) {
+      if (previous->second >= end)
+        return 0;
+      begin = previous->first;
+      it = previous;
+    }
+  }
+
+  // Absorb the ranges starting before or at |end|.
+  while (it != ranges_.end() && it->first <= end) {
+    end = std::max(end, it->second);
+    size_ -= it->second - it->first;
+    ranges_.erase(it++);
+  }
+
+  ranges_.insert(it, std::make_pair(begin, end));
+  size_ += end - begin;
+  return size_ - previous_size;
+}
+
+uint64 IntervalSet::Remove(uint64 begin, uint64 end) {
+  if (begin >= end)
+    return 0;
+
+  uint64 previous_size = size_;
+
+  // Split a range starting before |begin| and overlapping it.
+  Ranges::iterator it = ranges_.upper_bound(begin);
+  if (it != ranges_.begin()) {
+    Ranges::iterator previous = it;
+    --previous;
+    if (previous->first == begin) {
+      it = previous;
+    } else if (previous->second > begin) {
+      uint64 previous_end = previous->second;
+      previous->second = begin;
+      size_ -= previous_end - begin;
+      if (previous_end > end) {
+        ranges_.insert(it, std::make_pair(end, previous_end));
+        size_ += previous_end - end;
+        return previous_size - size_;
+      }
+    }
+  }
+
+  // Remove the ranges starting in [begin, end), keeping their part past end.
+  while (it != ranges_.end() && it->first < end) {
+    uint64 range_begin = it->first;
+    uint64 range_end = it->second;
+    ranges_.erase(it++);
+    if (range_end > end) {
+      size_ -= end - range_begin;
+      ranges_.insert(it, std::make_pair(end, range_end));
+      break;
+    }
+    size_ -= range_end - range_begin;
+  }
+
+  return previous_size - size_;
+}
+
+bool IntervalSet::Find(uint64 address, uint64* begin, uint64* end) const {
+  Ranges::const_iterator it = ranges_.upper_bound(address);
+  if (it == ranges_.begin())
+    return false;
+  --it;
+  if (address >= it->second)
+    return false;
+  *begin = it->first;
+  *end = it->second;
+  return true;
+}
+
+}  // namespace analysis
@@ -0,0 +1,100 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// An interval set holds disjoint half-open address ranges [begin, end).
+// Adjacent and overlapping ranges are merged on insertion, and a removal
+// splits the ranges it partially covers. Both operations take O(log n) plus
+// the number of ranges they merge or remove.
+//
+// Usage example:
+//   IntervalSet committed;
+//   committed.Add(0x10000, 0x20000);
+//   committed.Remove(0x14000, 0x15000);  // Splits the range in two.
+//   assert(committed.size() == 0xF000);
+
+#ifndef ANALYSIS_INTERVAL_SET_H_
+#define ANALYSIS_INTERVAL_SET_H_
+
+#include <cstddef>
+#include <map>
+
+#include "base/base.h"
+
+namespace analysis {
+
+class IntervalSet {
+ public:
+  // The ranges, keyed by begin address, mapped to their end address.
+  typedef std::map<uint64, uint64> Ranges;
+  typedef Ranges::const_iterator const_iterator;
+
+  IntervalSet();
+
+  // Adds a range.
+  // @param begin the first address of the range.
+  // @param end the address past the range.
+  // @returns the number of addresses that were not already in the set.
+  uint64 Add(uint64 begin, uint64 end);
+
+  // Removes a range.
+  // @param begin the first address of the range.
+  // @param end the address past the range.
+  // @returns the number of addresses that were in the set.
+  uint64 Remove(uint64 begin, uint64 end);
+
+  // @param address an address.
+  // @param begin receives the beginning of the range holding |address|.
+  // @param end receives the end of the range holding |address|.
+  // @returns true if |address| is in the set, false otherwise.
+  bool Find(uint64 address, uint64* begin, uint64* end) const;
+
+  // @param address an address.
+  // @returns true if |address| is in the set.
+  bool Contains(uint64 address) const {
+    uint64 begin = 0;
+    uint64 end = 0;
+    return Find(address, &begin, &end);
+  }
+
+  // @returns the number of addresses in the set.
+  uint64 size() const { return size_; }
+
+  // @returns the number of disjoint ranges.
+  size_t range_count() const { return ranges_.size(); }
+
+  // Iterates over the ranges, by increasing address.
+  // @{
+  const_iterator begin() const { return ranges_.begin(); }
+  const_iterator end() const { return ranges_.end(); }
+  // @}
+
+ private:
+  Ranges ranges_;
+  uint64 size_;
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_INTERVAL_SET_H_
@@ -0,0 +1,131 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/interval_set.h"
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+TEST(IntervalSetTest, AddDisjoint) {
+  IntervalSet set;
+  EXPECT_EQ(0x10U, set.Add(0x100, 0x110));
+  EXPECT_EQ(0x20U, set.Add(0x200, 0x220));
+  EXPECT_EQ(0x30U, set.size());
+  EXPECT_EQ(2U, set.range_count());
+  EXPECT_TRUE(set.Contains(0x100));
+  EXPECT_TRUE(set.Contains(0x10F));
+  EXPECT_FALSE(set.Contains(0x110));
+  EXPECT_FALSE(set.Contains(0xFF));
+}
+
+TEST(IntervalSetTest, AddMergesOverlaps) {
+  IntervalSet set;
+  set.Add(0x100, 0x200);
+  set.Add(0x300, 0x400);
+  EXPECT_EQ(0x100U, set.Add(0x180, 0x380));
+  EXPECT_EQ(0x300U, set.size());
+  EXPECT_EQ(1U, set.range_count());
+
+  uint64 begin = 0;
+  uint64 end = 0;
+  EXPECT_TRUE(set.Find(0x250, &begin, &end));
+  EXPECT_EQ(0x100U, begin);
+  EXPECT_EQ(0x400U, end);
+}
+
+TEST(IntervalSetTest, AddMergesAdjacent) {
+  IntervalSet set;
+  set.Add(0x100, 0x200);
+  EXPECT_EQ(0x100U, set.Add(0x200, 0x300));
+  EXPECT_EQ(1U, set.range_count());
+  EXPECT_EQ(0U, set.Add(0x180, 0x280));
+  EXPECT_EQ(0x200U, set.size());
+}
+
+TEST(IntervalSetTest, AddEmpty) {
+  IntervalSet set;
+  EXPECT_EQ(0U, set.Add(0x100, 0x100));
+  EXPECT_EQ(0U, set.range_count());
+}
+
+TEST(IntervalSetTest, RemoveSplits) {
+  IntervalSet set;
+  set.Add(0x10000, 0x20000);
+  EXPECT_EQ(0x1000U, set.Remove(0x14000, 0x15000));
+  EXPECT_EQ(0xF000U, set.size());
+  EXPECT_EQ(2U, set.range_count());
+  EXPECT_TRUE(set.Contains(0x13FFF));
+  EXPECT_FALSE(set.Contains(0x14000));
+  EXPECT_FALSE(set.Contains(0x14FFF));
+  EXPECT_TRUE(set.Contains(0x15000));
+}
+
+TEST(IntervalSetTest, RemoveSpanningRanges) {
+  IntervalSet set;
+  set.Add(0x100, 0x200);
+  set.Add(0x300, 0x400);
+  set.Add(0x500, 0x600);
+  EXPECT_EQ(0x200U, set.Remove(0x180, 0x580));
+  EXPECT_EQ(0x100U, set.size());
+  EXPECT_EQ(2U, set.range_count());
+  EXPECT_TRUE(set.Contains(0x17F));
+  EXPECT_TRUE(set.Contains(0x580));
+}
+
+TEST(IntervalSetTest, RemoveWholeRange) {
+  IntervalSet set;
+  set.Add(0x100, 0x200);
+  EXPECT_EQ(0x100U, set.Remove(0x100, 0x200));
+  EXPECT_EQ(0U, set.size());
+  EXPECT_EQ(0U, set.range_count());
+  EXPECT_EQ(0U, set.Remove(0x100, 0x200));
+}
+
+TEST(IntervalSetTest, RemovePrefix) {
+  IntervalSet set;
+  set.Add(0x100, 0x200);
+  EXPECT_EQ(0x80U, set.Remove(0x100, 0x180));
+  EXPECT_EQ(1U, set.range_count());
+  EXPECT_FALSE(set.Contains(0x17F));
+  EXPECT_TRUE(set.Contains(0x180));
+}
+
+TEST(IntervalSetTest, Iterate) {
+  IntervalSet set;
+  set.Add(0x300, 0x400);
+  set.Add(0x100, 0x200);
+  IntervalSet::const_iterator it = set.begin();
+  ASSERT_TRUE(it != set.end());
+  EXPECT_EQ(0x100U, it->first);
+  EXPECT_EQ(0x200U, it->second);
+  ++it;
+  ASSERT_TRUE(it != set.end());
+  EXPECT_EQ(0x300U, it->first);
+  ++it;
+  EXPECT_TRUE(it == set.end());
+}
+
+}  // namespace analysis
@@ -0,0 +1,107 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/kernel_event.h"
+
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StringValue;
+using event::StructValue;
+using event::UCharValue;
+using event::ULongValue;
+using event::Value;
+
+}  // namespace
+
+KernelEvent::KernelEvent()
+    : timestamp_(0),
+      category_(NULL),
+      operation_(NULL),
+      process_id_(0),
+      thread_id_(0),
+      processor_number_(0),
+      content_(NULL) {
+}
+
+bool KernelEvent::Parse(const event::Event& event) {
+  const event::Value* payload = event.payload();
+  if (payload == NULL || !StructValue::InstanceOf(payload))
+    return false;
+  const StructValue* fields = StructValue::Cast(payload);
+
+  const StringValue* category = NULL;
+  const StringValue* operation = NULL;
+  const StructValue* content = NULL;
+  uint64 process_id = 0;
+  uint64 thread_id = 0;
+  uint32 processor_number = 0;
+  if (!fields->GetFieldAs<StringValue>("category", &category) ||
+      !fields->GetFieldAs<StringValue>("operation", &operation) ||
+      !fields->GetFieldAs<StructValue>("content", &content) ||
+      !fields->GetFieldAsULong("process_id", &process_id) ||
+      !fields->GetFieldAsULong("thread_id", &thread_id) ||
+      !fields->GetFieldAsUInteger("processor_number", &processor_number)) {
+    return false;
+  }
+
+  timestamp_ = event.timestamp();
+  category_ = &category->GetValue();
+  operation_ = &operation->GetValue();
+  process_id_ = process_id;
+  thread_id_ = thread_id;
+  processor_number_ = processor_number;
+  content_ = content;
+  return true;
+}
+
+scoped_ptr<event::Event> CreateKernelEvent(
+    event::Timestamp timestamp,
+    const char* category,
+    const char* operation,
+    uint32 process_id,
+    uint32 thread_id,
+    uint32 processor_number,
+    scoped_ptr<StructValue> content) {
+  DCHECK(category != NULL);
+  DCHECK(operation != NULL);
+
+  scoped_ptr<StructValue> fields(new StructValue());
+  fields->AddField<StringValue>("operation", operation);
+  fields->AddField<StringValue>("category", category);
+  fields->AddField<ULongValue>("process_id", process_id);
+  fields->AddField<ULongValue>("thread_id", thread_id);
+  fields->AddField<UCharValue>("processor_number",
+                               static_cast<uint8>(processor_number));
+  fields->AddField("content", content.PassAs<Value>());
+
+  return scoped_ptr<event::Event>(
+      new event::Event(timestamp, fields.PassAs<const Value>()));
+}
+
+}  // namespace analysis
@@ -0,0 +1,117 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A view over the fields that the ETW parser adds to each kernel event:
+//
+//   {
+//     operation = "CSwitch"
+//     category = "Thread"
+//     process_id = 4
+//     thread_id = 8
+//     processor_number = 1
+//     content = { ... decoded payload ... }
+//   }
+//
+// Usage example:
+//   KernelEvent kernel_event;
+//   if (kernel_event.Parse(event) && kernel_event.Is("Thread", "CSwitch"))
+//     UseContent(kernel_event.content());
+
+#ifndef ANALYSIS_KERNEL_EVENT_H_
+#define ANALYSIS_KERNEL_EVENT_H_
+
+#include <string>
+
+#include "base/base.h"
+#include "base/scoped_ptr.h"
+#include "event/event.h"
+#include "event/value.h"
+
+namespace analysis {
+
+class KernelEvent {
+ public:
+  KernelEvent();
+
+  // Extracts the header fields of |event|. The view refers to the payload of
+  // |event|, which must outlive it.
+  // @param event the event to parse.
+  // @returns true if |event| has the fields of a kernel event, false
+  //     otherwise.
+  bool Parse(const event::Event& event);
+
+  // @param category the expected category.
+  // @param operation the expected operation.
+  // @returns true if the event has the category |category| and the operation
+  //     |operation|.
+  bool Is(const char* category, const char* operation) const {
+    return category_->compare(category) == 0 &&
+           operation_->compare(operation) == 0;
+  }
+
+  // Accessors, valid after a successful Parse().
+  // @{
+  event::Timestamp timestamp() const { return timestamp_; }
+  const std::string& category() const { return *category_; }
+  const std::string& operation() const { return *operation_; }
+  uint64 process_id() const { return process_id_; }
+  uint64 thread_id() const { return thread_id_; }
+  uint32 processor_number() const { return processor_number_; }
+  const event::StructValue* content() const { return content_; }
+  // @}
+
+ private:
+  event::Timestamp timestamp_;
+  const std::string* category_;
+  const std::string* operation_;
+  uint64 process_id_;
+  uint64 thread_id_;
+  uint32 processor_number_;
+  const event::StructValue* content_;
+
+  DISALLOW_COPY_AND_ASSIGN(KernelEvent);
+};
+
+// Creates an event with the layout of the kernel events of the ETW parser.
+// @param timestamp the timestamp of the event.
+// @param category the category of the event.
+// @param operation the operation of the event.
+// @param process_id the process that emitted the event.
+// @param thread_id the thread that emitted the event.
+// @param processor_number the processor that emitted the event.
+// @param content the decoded payload of the event.
+// @returns the created event.
+scoped_ptr<event::Event> CreateKernelEvent(
+    event::Timestamp timestamp,
+    const char* category,
+    const char* operation,
+    uint32 process_id,
+    uint32 thread_id,
+    uint32 processor_number,
+    scoped_ptr<event::StructValue> content);
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_KERNEL_EVENT_H_
@@ -0,0 +1,74 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/kernel_event.h"
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+using event::StructValue;
+using event::UIntValue;
+
+TEST(KernelEventTest, Parse) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("NewThreadId", 12);
+  scoped_ptr<event::Event> event(
+      CreateKernelEvent(42, "Thread", "CSwitch", 4, 8, 2, content.Pass()));
+
+  KernelEvent kernel_event;
+  ASSERT_TRUE(kernel_event.Parse(*event.get()));
+  EXPECT_EQ(42U, kernel_event.timestamp());
+  EXPECT_EQ("Thread", kernel_event.category());
+  EXPECT_EQ("CSwitch", kernel_event.operation());
+  EXPECT_EQ(4U, kernel_event.process_id());
+  EXPECT_EQ(8U, kernel_event.thread_id());
+  EXPECT_EQ(2U, kernel_event.processor_number());
+  EXPECT_TRUE(kernel_event.Is("Thread", "CSwitch"));
+  EXPECT_FALSE(kernel_event.Is("Thread", "ReadyThread"));
+  EXPECT_FALSE(kernel_event.Is("PerfInfo", "CSwitch"));
+
+  uint32 new_thread_id = 0;
+  ASSERT_TRUE(kernel_event.content() != NULL);
+  EXPECT_TRUE(
+      kernel_event.content()->GetFieldAsUInteger("NewThreadId",
+                                                 &new_thread_id));
+  EXPECT_EQ(12U, new_thread_id);
+}
+
+TEST(KernelEventTest, ParseInvalid) {
+  KernelEvent kernel_event;
+
+  scoped_ptr<const event::Value> scalar(new UIntValue(12));
+  event::Event scalar_event(42, scalar.Pass());
+  EXPECT_FALSE(kernel_event.Parse(scalar_event));
+
+  scoped_ptr<StructValue> fields(new StructValue());
+  fields->AddField<event::StringValue>("operation", "CSwitch");
+  event::Event partial_event(42, fields.PassAs<const event::Value>());
+  EXPECT_FALSE(kernel_event.Parse(partial_event));
+}
+
+}  // namespace analysis
@@ -0,0 +1,271 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/memory_tracker.h"
+
+#include <algorithm>
+
+#include "analysis/kernel_event.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::Timestamp;
+
+bool StartsAfter(Timestamp timestamp, const MemoryTracker::TimelinePoint& p) {
+  return timestamp < p.start;
+}
+
+}  // namespace
+
+const uint32 MemoryTracker::kMemCommit;
+const uint32 MemoryTracker::kMemReserve;
+const uint32 MemoryTracker::kMemDecommit;
+const uint32 MemoryTracker::kMemRelease;
+
+MemoryTracker::MemoryTracker(Timestamp resolution)
+    : resolution_(resolution) {
+  DCHECK_GT(resolution, 0U);
+}
+
+MemoryTracker::~MemoryTracker() {
+  for (IdMap<ProcessMemory*>::iterator it = processes_.begin();
+       it != processes_.end(); ++it) {
+    delete it->second;
+  }
+  for (size_t i = 0; i < ended_processes_.size(); ++i)
+    delete ended_processes_[i].second;
+}
+
+void MemoryTracker::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event))
+    return;
+
+  const std::string& operation = kernel_event.operation();
+  if (kernel_event.category() == "Process") {
+    uint32 process_id = 0;
+    if ((operation == "End" || operation == "DCEnd") &&
+        kernel_event.content()->GetFieldAsUInteger("ProcessId",
+                                                   &process_id)) {
+      OnProcessEnd(process_id);
+    }
+    return;
+  }
+  if (kernel_event.category() != "PageFault")
+    return;
+
+  bool is_alloc = operation == "VirtualAlloc" ||
+                  operation == "VirtualAllocDCStart";
+  if (!is_alloc && operation != "VirtualFree")
+    return;
+
+  const StructValue* content = kernel_event.content();
+  uint64 base = 0;
+  uint64 size = 0;
+  uint32 process_id = 0;
+  uint32 flags = 0;
+  if (!content->GetFieldAsULong("BaseAddress", &base) ||
+      !content->GetFieldAsULong("RegionSize", &size) ||
+      !content->GetFieldAsUInteger("ProcessId", &process_id) ||
+      !content->GetFieldAsUInteger("Flags", &flags)) {
+    return;
+  }
+
+  if (is_alloc)
+    OnVirtualAlloc(kernel_event.timestamp(), process_id, base, size, flags);
+  else
+    OnVirtualFree(kernel_event.timestamp(), process_id, base, size, flags);
+}
+
+void MemoryTracker::OnVirtualAlloc(Timestamp timestamp,
+                                   uint32 process_id,
+                                   uint64 base,
+                                   uint64 size,
+                                   uint32 flags) {
+  ProcessMemory* process = GetProcess(process_id);
+
+  // A committed region is also reserved.
+  if ((flags & (kMemReserve | kMemCommit)) != 0)
+    process->reserved.Add(base, base + size);
+  if ((flags & kMemCommit) != 0)
+    process->committed.Add(base, base + size);
+
+  Record(timestamp, process);
+}
+
+void MemoryTracker::OnVirtualFree(Timestamp timestamp,
+                                  uint32 process_id,
+                                  uint64 base,
+                                  uint64 size,
+                                  uint32 flags) {
+  ProcessMemory* process = GetProcess(process_id);
+
+  uint64 end = base + size;
+  if (size == 0 && (flags & kMemRelease) != 0) {
+    uint64 begin = 0;
+    if (!process->reserved.Find(base, &begin, &end))
+      return;
+  }
+
+  if ((flags & (kMemDecommit | kMemRelease)) != 0)
+    process->committed.Remove(base, end);
+  if ((flags & kMemRelease) != 0)
+    process->reserved.Remove(base, end);
+
+  Record(timestamp, process);
+}
+
+void MemoryTracker::OnProcessEnd(uint32 process_id) {
+  ProcessMemory** process = processes_.Find(process_id);
+  if (process != NULL)
+    (*process)->ended = true;
+}
+
+uint64 MemoryTracker::GetCommittedBytes(uint32 process_id) const {
+  const ProcessMemory* process = FindProcess(process_id);
+  if (process == NULL)
+    return 0;
+  return process->committed.size();
+}
+
+uint64 MemoryTracker::GetReservedBytes(uint32 process_id) const {
+  const ProcessMemory* process = FindProcess(process_id);
+  if (process == NULL)
+    return 0;
+  return process->reserved.size();
+}
+
+bool MemoryTracker::IsCommitted(uint32 process_id, uint64 address) const {
+  const ProcessMemory* process = FindProcess(process_id);
+  if (process == NULL)
+    return false;
+  return process->committed.Contains(address);
+}
+
+bool MemoryTracker::GetCommittedBytesAt(uint32 process_id,
+                                        Timestamp timestamp,
+                                        uint64* bytes) const {
+  DCHECK(bytes != NULL);
+
+  const Timeline* timeline = GetTimeline(process_id);
+  if (timeline == NULL)
+    return false;
+
+  // Find the last period starting at or before |timestamp|.
+  Timeline::const_iterator it = std::upper_bound(
+      timeline->begin(), timeline->end(), timestamp, StartsAfter);
+  if (it == timeline->begin())
+    return false;
+  --it;
+  *bytes = it->last;
+  return true;
+}
+
+const MemoryTracker::Timeline* MemoryTracker::GetTimeline(
+    uint32 process_id) const {
+  const ProcessMemory* process = FindProcess(process_id);
+  if (process == NULL)
+    return NULL;
+  return &process->timeline;
+}
+
+bool MemoryTracker::WriteTimeline(uint32 process_id,
+                                  std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  const Timeline* timeline = GetTimeline(process_id);
+  if (timeline == NULL)
+    return out->good();
+
+  for (Timeline::const_iterator it = timeline->begin();
+       it != timeline->end(); ++it) {
+    *out << it->start << ' ' << it->min << ' ' << it->max << ' '
+         << it->last << '\n';
+  }
+  return out->good();
+}
+
+bool MemoryTracker::WriteReport(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  std::vector<EndedProcess> processes(ended_processes_);
+  processes.insert(processes.end(), processes_.begin(), processes_.end());
+  for (size_t i = 0; i < processes.size(); ++i) {
+    const ProcessMemory& process = *processes[i].second;
+    *out << "process " << processes[i].first << ' '
+         << process.committed.size() << ' '
+         << process.reserved.size() << ' '
+         << process.committed.range_count() << ' '
+         << process.peak_committed << '\n';
+  }
+  return out->good();
+}
+
+MemoryTracker::ProcessMemory* MemoryTracker::GetProcess(uint32 process_id) {
+  ProcessMemory** process = processes_.FindOrInsert(process_id);
+  if (*process != NULL && (*process)->ended) {
+    // The identifier was reused by a new process.
+    ended_processes_.push_back(EndedProcess(process_id, *process));
+    *process = NULL;
+  }
+  if (*process == NULL)
+    *process = new ProcessMemory();
+  return *process;
+}
+
+const MemoryTracker::ProcessMemory* MemoryTracker::FindProcess(
+    uint32 process_id) const {
+  ProcessMemory* const* process = processes_.Find(process_id);
+  if (process == NULL)
+    return NULL;
+  return *process;
+}
+
+void MemoryTracker::Record(Timestamp timestamp, ProcessMemory* process) {
+  DCHECK(process != NULL);
+
+  uint64 committed = process->committed.size();
+  process->peak_committed = std::max(process->peak_committed, committed);
+
+  Timeline& timeline = process->timeline;
+  Timestamp start = timestamp - timestamp % resolution_;
+  if (timeline.empty() || start > timeline.back().start) {
+    TimelinePoint point = { start, committed, committed, committed };
+    timeline.push_back(point);
+    return;
+  }
+
+  // Events slightly out of order are added to the last period.
+  TimelinePoint& point = timeline.back();
+  point.min = std::min(point.min, committed);
+  point.max = std::max(point.max, committed);
+  point.last = committed;
+}
+
+}  // namespace analysis
@@ -0,0 +1,200 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A memory tracker follows the virtual memory of each process from the
+// PageFault/VirtualAlloc and PageFault/VirtualFree events. It keeps the
+// reserved and the committed regions of each process in interval sets, and
+// a timeline of the committed bytes downsampled to a fixed resolution: each
+// point of the timeline holds the minimum, the maximum and the last value of
+// the committed bytes during a period of |resolution| timestamp units. The
+// periods without changes have no point.
+//
+// The PageFault/VirtualAllocDCStart events enumerate the regions committed
+// before the trace started.
+//
+// The Process/End and Process/DCEnd events end a process. Its memory can
+// still be queried until its identifier is reused: a new process with the
+// same identifier starts with no regions, and the ended one is only kept
+// for the report.
+//
+// Usage example:
+//   MemoryTracker tracker(kOneSecond);
+//   parser.Parse(base::MakeObserver(&tracker, &MemoryTracker::Receive));
+//   tracker.WriteTimeline(process_id, &std::cout);
+
+#ifndef ANALYSIS_MEMORY_TRACKER_H_
+#define ANALYSIS_MEMORY_TRACKER_H_
+
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "analysis/id_map.h"
+#include "analysis/interval_set.h"
+#include "base/base.h"
+#include "event/event.h"
+
+namespace analysis {
+
+class MemoryTracker {
+ public:
+  // The flags of the VirtualAlloc and VirtualFree events.
+  // @{
+  static const uint32 kMemCommit = 0x1000;
+  static const uint32 kMemReserve = 0x2000;
+  static const uint32 kMemDecommit = 0x4000;
+  static const uint32 kMemRelease = 0x8000;
+  // @}
+
+  // The committed bytes of a process during a period.
+  struct TimelinePoint {
+    event::Timestamp start;
+    uint64 min;
+    uint64 max;
+    uint64 last;
+  };
+  typedef std::vector<TimelinePoint> Timeline;
+
+  // @param resolution the duration of the periods of the timelines, in
+  //     timestamp units.
+  explicit MemoryTracker(event::Timestamp resolution);
+  ~MemoryTracker();
+
+  // Consumes an event of the ETW parser. Events other than the virtual
+  // memory and the process end events are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Records the allocation of a region.
+  // @param timestamp the time of the allocation.
+  // @param process_id the process owning the region.
+  // @param base the base address of the region.
+  // @param size the size of the region, in bytes.
+  // @param flags kMemCommit and/or kMemReserve.
+  void OnVirtualAlloc(event::Timestamp timestamp,
+                      uint32 process_id,
+                      uint64 base,
+                      uint64 size,
+                      uint32 flags);
+
+  // Records the release of a region.
+  // @param timestamp the time of the release.
+  // @param process_id the process owning the region.
+  // @param base the base address of the region.
+  // @param size the size of the region, in bytes. Zero releases the whole
+  //     reservation holding |base|.
+  // @param flags kMemDecommit or kMemRelease.
+  void OnVirtualFree(event::Timestamp timestamp,
+                     uint32 process_id,
+                     uint64 base,
+                     uint64 size,
+                     uint32 flags);
+
+  // Records the end of a process. The next region allocated or released
+  // with the same identifier belongs to a new process.
+  // @param process_id the process that ended.
+  void OnProcessEnd(uint32 process_id);
+
+  // @param process_id a process.
+  // @returns the bytes currently committed by |process_id|.
+  uint64 GetCommittedBytes(uint32 process_id) const;
+
+  // @param process_id a process.
+  // @returns the bytes currently reserved by |process_id|.
+  uint64 GetReservedBytes(uint32 process_id) const;
+
+  // @param process_id a process.
+  // @param address an address.
+  // @returns true if |address| is currently committed by |process_id|.
+  bool IsCommitted(uint32 process_id, uint64 address) const;
+
+  // Retrieves the bytes committed by a process at a given time. The value is
+  // exact when no change occurred in the period holding |timestamp|, and is
+  // the value at the end of that period otherwise.
+  // @param process_id a process.
+  // @param timestamp the time of the query.
+  // @param bytes receives the committed bytes.
+  // @returns true on success, false if nothing is known about |process_id|
+  //     at |timestamp|.
+  bool GetCommittedBytesAt(uint32 process_id,
+                           event::Timestamp timestamp,
+                           uint64* bytes) const;
+
+  // @param process_id a process.
+  // @returns the timeline of the committed bytes of |process_id|, or NULL if
+  //     unknown.
+  const Timeline* GetTimeline(uint32 process_id) const;
+
+  // Writes the timeline of a process, one line per point:
+  //   "<start> <min> <max> <last>"
+  // @param process_id a process.
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteTimeline(uint32 process_id, std::ostream* out) const;
+
+  // Writes a line per process, the processes whose identifier was reused
+  // first:
+  //   "process <pid> <committed> <reserved> <committed regions> <peak>"
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteReport(std::ostream* out) const;
+
+ private:
+  struct ProcessMemory {
+    ProcessMemory() : peak_committed(0), ended(false) {}
+
+    IntervalSet committed;
+    IntervalSet reserved;
+    Timeline timeline;
+    uint64 peak_committed;
+    bool ended;
+  };
+  typedef std::pair<uint32, ProcessMemory*> EndedProcess;
+
+  // @returns the memory of |process_id|, created if needed, or replaced if
+  //     the process ended.
+  ProcessMemory* GetProcess(uint32 process_id);
+
+  // @returns the memory of |process_id|, or NULL if unknown.
+  const ProcessMemory* FindProcess(uint32 process_id) const;
+
+  // Appends the committed bytes of a process to its timeline.
+  void Record(event::Timestamp timestamp, ProcessMemory* process);
+
+  event::Timestamp resolution_;
+
+  // The memory of each process. Owned.
+  IdMap<ProcessMemory*> processes_;
+
+  // The ended processes whose identifier was reused, in the order of reuse.
+  // Owned.
+  std::vector<EndedProcess> ended_processes_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryTracker);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_MEMORY_TRACKER_H_
@@ -0,0 +1,232 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/memory_tracker.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+
+const uint32 kProcessId = 1234;
+const uint32 kOtherProcessId = 5678;
+
+void SendVirtualMemory(MemoryTracker* tracker,
+                       const char* operation,
+                       event::Timestamp timestamp,
+                       uint32 process_id,
+                       uint64 base,
+                       uint64 size,
+                       uint32 flags) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("BaseAddress", base);
+  content->AddField<ULongValue>("RegionSize", size);
+  content->AddField<UIntValue>("ProcessId", process_id);
+  content->AddField<UIntValue>("Flags", flags);
+  tracker->Receive(*CreateKernelEvent(timestamp, "PageFault", operation,
+                                      process_id, 0, 0,
+                                      content.Pass()).get());
+}
+
+void SendProcessEnd(MemoryTracker* tracker,
+                    const char* operation,
+                    event::Timestamp timestamp,
+                    uint32 process_id) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("ProcessId", process_id);
+  tracker->Receive(*CreateKernelEvent(timestamp, "Process", operation,
+                                      process_id, 0, 0,
+                                      content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(MemoryTrackerTest, CommitAndRelease) {
+  MemoryTracker tracker(100);
+  SendVirtualMemory(&tracker, "VirtualAlloc", 10, kProcessId,
+                    0x10000, 0x10000, MemoryTracker::kMemReserve);
+  EXPECT_EQ(0x10000U, tracker.GetReservedBytes(kProcessId));
+  EXPECT_EQ(0U, tracker.GetCommittedBytes(kProcessId));
+
+  SendVirtualMemory(&tracker, "VirtualAlloc", 20, kProcessId,
+                    0x10000, 0x4000, MemoryTracker::kMemCommit);
+  EXPECT_EQ(0x10000U, tracker.GetReservedBytes(kProcessId));
+  EXPECT_EQ(0x4000U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_TRUE(tracker.IsCommitted(kProcessId, 0x13FFF));
+  EXPECT_FALSE(tracker.IsCommitted(kProcessId, 0x14000));
+
+  SendVirtualMemory(&tracker, "VirtualFree", 30, kProcessId,
+                    0x11000, 0x1000, MemoryTracker::kMemDecommit);
+  EXPECT_EQ(0x3000U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_FALSE(tracker.IsCommitted(kProcessId, 0x11000));
+
+  SendVirtualMemory(&tracker, "VirtualFree", 40, kProcessId,
+                    0x10000, 0x10000, MemoryTracker::kMemRelease);
+  EXPECT_EQ(0U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_EQ(0U, tracker.GetReservedBytes(kProcessId));
+}
+
+TEST(MemoryTrackerTest, CommitImpliesReserve) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(0, kProcessId, 0x10000, 0x2000,
+                         MemoryTracker::kMemCommit);
+  EXPECT_EQ(0x2000U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_EQ(0x2000U, tracker.GetReservedBytes(kProcessId));
+}
+
+TEST(MemoryTrackerTest, ReleaseWholeReservation) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(0, kProcessId, 0x10000, 0x8000,
+                         MemoryTracker::kMemReserve |
+                             MemoryTracker::kMemCommit);
+  tracker.OnVirtualFree(1, kProcessId, 0x10000, 0,
+                        MemoryTracker::kMemRelease);
+  EXPECT_EQ(0U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_EQ(0U, tracker.GetReservedBytes(kProcessId));
+}
+
+TEST(MemoryTrackerTest, RecommitIsNotCountedTwice) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(0, kProcessId, 0x10000, 0x2000,
+                         MemoryTracker::kMemCommit);
+  tracker.OnVirtualAlloc(1, kProcessId, 0x11000, 0x2000,
+                         MemoryTracker::kMemCommit);
+  EXPECT_EQ(0x3000U, tracker.GetCommittedBytes(kProcessId));
+}
+
+TEST(MemoryTrackerTest, RundownEnumeratesRegions) {
+  MemoryTracker tracker(100);
+  SendVirtualMemory(&tracker, "VirtualAllocDCStart", 0, kProcessId,
+                    0x10000, 0x1000,
+                    MemoryTracker::kMemReserve | MemoryTracker::kMemCommit);
+  EXPECT_EQ(0x1000U, tracker.GetCommittedBytes(kProcessId));
+}
+
+TEST(MemoryTrackerTest, ProcessesAreSeparate) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(0, kProcessId, 0x10000, 0x1000,
+                         MemoryTracker::kMemCommit);
+  tracker.OnVirtualAlloc(0, kOtherProcessId, 0x10000, 0x2000,
+                         MemoryTracker::kMemCommit);
+  EXPECT_EQ(0x1000U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_EQ(0x2000U, tracker.GetCommittedBytes(kOtherProcessId));
+  EXPECT_FALSE(tracker.IsCommitted(42, 0x10000));
+}
+
+TEST(MemoryTrackerTest, ReusedProcessId) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(0, kProcessId, 0x10000, 0x3000,
+                         MemoryTracker::kMemCommit);
+  SendProcessEnd(&tracker, "End", 10, kProcessId);
+
+  // The memory of the ended process can still be queried.
+  EXPECT_EQ(0x3000U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_TRUE(tracker.IsCommitted(kProcessId, 0x10000));
+
+  // A new process with the same identifier starts with no regions.
+  tracker.OnVirtualAlloc(120, kProcessId, 0x20000, 0x1000,
+                         MemoryTracker::kMemCommit);
+  EXPECT_EQ(0x1000U, tracker.GetCommittedBytes(kProcessId));
+  EXPECT_EQ(0x1000U, tracker.GetReservedBytes(kProcessId));
+  EXPECT_FALSE(tracker.IsCommitted(kProcessId, 0x10000));
+  const MemoryTracker::Timeline* timeline = tracker.GetTimeline(kProcessId);
+  ASSERT_TRUE(timeline != NULL);
+  ASSERT_EQ(1U, timeline->size());
+  EXPECT_EQ(100U, (*timeline)[0].start);
+
+  // The rundown ends the new process too.
+  SendProcessEnd(&tracker, "DCEnd", 200, kProcessId);
+  tracker.OnVirtualFree(300, kProcessId, 0x10000, 0x1000,
+                        MemoryTracker::kMemDecommit);
+  EXPECT_EQ(0U, tracker.GetCommittedBytes(kProcessId));
+
+  std::ostringstream out;
+  EXPECT_TRUE(tracker.WriteReport(&out));
+  EXPECT_EQ("process 1234 12288 12288 1 12288\n"
+            "process 1234 4096 4096 1 4096\n"
+            "process 1234 0 0 0 0\n",
+            out.str());
+}
+
+TEST(MemoryTrackerTest, IgnoresOtherEvents) {
+  MemoryTracker tracker(100);
+  SendVirtualMemory(&tracker, "HardFault", 0, kProcessId,
+                    0x10000, 0x1000, MemoryTracker::kMemCommit);
+  EXPECT_EQ(NULL, tracker.GetTimeline(kProcessId));
+}
+
+TEST(MemoryTrackerTest, Timeline) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(110, kProcessId, 0x10000, 0x3000,
+                         MemoryTracker::kMemCommit);
+  tracker.OnVirtualFree(150, kProcessId, 0x10000, 0x2000,
+                        MemoryTracker::kMemDecommit);
+  tracker.OnVirtualAlloc(420, kProcessId, 0x20000, 0x1000,
+                         MemoryTracker::kMemCommit);
+
+  const MemoryTracker::Timeline* timeline = tracker.GetTimeline(kProcessId);
+  ASSERT_TRUE(timeline != NULL);
+  ASSERT_EQ(2U, timeline->size());
+  EXPECT_EQ(100U, (*timeline)[0].start);
+  EXPECT_EQ(0x1000U, (*timeline)[0].min);
+  EXPECT_EQ(0x3000U, (*timeline)[0].max);
+  EXPECT_EQ(0x1000U, (*timeline)[0].last);
+  EXPECT_EQ(400U, (*timeline)[1].start);
+  EXPECT_EQ(0x2000U, (*timeline)[1].last);
+
+  uint64 bytes = 0;
+  EXPECT_FALSE(tracker.GetCommittedBytesAt(kProcessId, 50, &bytes));
+  EXPECT_TRUE(tracker.GetCommittedBytesAt(kProcessId, 300, &bytes));
+  EXPECT_EQ(0x1000U, bytes);
+  EXPECT_TRUE(tracker.GetCommittedBytesAt(kProcessId, 1000, &bytes));
+  EXPECT_EQ(0x2000U, bytes);
+  EXPECT_FALSE(tracker.GetCommittedBytesAt(kOtherProcessId, 1000, &bytes));
+
+  std::ostringstream out;
+  EXPECT_TRUE(tracker.WriteTimeline(kProcessId, &out));
+  EXPECT_EQ("100 4096 12288 4096\n400 8192 8192 8192\n", out.str());
+}
+
+TEST(MemoryTrackerTest, WriteReport) {
+  MemoryTracker tracker(100);
+  tracker.OnVirtualAlloc(0, kProcessId, 0x10000, 0x3000,
+                         MemoryTracker::kMemCommit);
+  tracker.OnVirtualFree(1, kProcessId, 0x11000, 0x1000,
+                        MemoryTracker::kMemDecommit);
+
+  std::ostringstream out;
+  EXPECT_TRUE(tracker.WriteReport(&out));
+  EXPECT_EQ("process 1234 8192 12288 2 12288\n", out.str());
+}
+
+}  // namespace analysis
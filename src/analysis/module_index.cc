@@ -0,0 +1,88 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/module_index.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace analysis {
+
+const uint32 ModuleIndex::kUnknownModule;
+
+ModuleIndex::ModuleIndex() : sorted_(true) {
+}
+
+uint32 ModuleIndex::AddModule(uint64 base,
+                              uint64 size,
+                              const std::string& name) {
+  uint32 id = static_cast<uint32>(modules_.size());
+  Module module = { base, size, name };
+  modules_.push_back(module);
+
+  Range range = { base, base + size, id };
+  if (!ranges_.empty() && !(ranges_.back() < range))
+    sorted_ = false;
+  ranges_.push_back(range);
+
+  return id;
+}
+
+uint32 ModuleIndex::Lookup(uint64 address) const {
+  if (!sorted_)
+    Sort();
+
+  // Find the last range starting at or before |address|.
+  Range key = { address, address, 0 };
+  std::vector<Range>::const_iterator it =
+      std::upper_bound(ranges_.begin(), ranges_.end(), key);
+  if (it == ranges_.begin())
+    return kUnknownModule;
+  --it;
+  if (address >= it->end)
+    return kUnknownModule;
+  return it->id;
+}
+
+void ModuleIndex::Sort() const {
+  // The stable sort keeps the ranges with the same base in the order of
+  // their addition: the last one is the current module.
+  std::stable_sort(ranges_.begin(), ranges_.end());
+
+  std::vector<Range>::iterator out = ranges_.begin();
+  for (std::vector<Range>::iterator it = ranges_.begin();
+       it != ranges_.end(); ++it) {
+    if (out != ranges_.begin() && (out - 1)->base == it->base)
+      *(out - 1) = *it;
+    else
+      *out++ = *it;
+  }
+  ranges_.erase(out, ranges_.end());
+
+  sorted_ = true;
+}
+
+}  // namespace analysis
@@ -0,0 +1,106 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A module index maps addresses to the modules loaded at these addresses.
+// The address ranges are kept in a flat array sorted by base address, so a
+// lookup is a binary search. The array is sorted again on the first lookup
+// following the addition of modules.
+//
+// Usage example:
+//   ModuleIndex index;
+//   index.AddModule(0xFFFFF80000000000, 0x100000, "ntoskrnl.exe");
+//   uint32 id = index.Lookup(routine);
+//   if (id != ModuleIndex::kUnknownModule)
+//     std::cout << index.module(id).name;
+
+#ifndef ANALYSIS_MODULE_INDEX_H_
+#define ANALYSIS_MODULE_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+
+namespace analysis {
+
+class ModuleIndex {
+ public:
+  struct Module {
+    uint64 base;
+    uint64 size;
+    std::string name;
+  };
+
+  // Returned by Lookup for addresses outside of all modules.
+  static const uint32 kUnknownModule = 0xFFFFFFFF;
+
+  ModuleIndex();
+
+  // Adds a module. A module loaded at the same base address as a previous
+  // module replaces it in the lookups.
+  // @param base the base address of the module.
+  // @param size the size of the module, in bytes.
+  // @param name the name of the module.
+  // @returns the identifier of the module.
+  uint32 AddModule(uint64 base, uint64 size, const std::string& name);
+
+  // @param address an address.
+  // @returns the identifier of the module containing |address|, or
+  //     kUnknownModule.
+  uint32 Lookup(uint64 address) const;
+
+  // @param id the identifier of a module.
+  // @returns the module |id|.
+  const Module& module(uint32 id) const { return modules_[id]; }
+
+  // @returns the number of modules added.
+  size_t module_count() const { return modules_.size(); }
+
+ private:
+  // An address range, sorted by base address.
+  struct Range {
+    uint64 base;
+    uint64 end;
+    uint32 id;
+
+    bool operator<(const Range& other) const { return base < other.base; }
+  };
+
+  // Sorts the ranges and removes the replaced ones.
+  void Sort() const;
+
+  // The modules, indexed by identifier.
+  std::vector<Module> modules_;
+
+  // The address ranges of the modules, and whether they are sorted.
+  mutable std::vector<Range> ranges_;
+  mutable bool sorted_;
+
+  DISALLOW_COPY_AND_ASSIGN(ModuleIndex);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_MODULE_INDEX_H_
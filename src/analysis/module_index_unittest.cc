@@ -0,0 +1,73 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/module_index.h"
+
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+TEST(ModuleIndexTest, Lookup) {
+  ModuleIndex index;
+  EXPECT_EQ(ModuleIndex::kUnknownModule, index.Lookup(0x1000));
+
+  uint32 second = index.AddModule(0x3000, 0x1000, "second.sys");
+  uint32 first = index.AddModule(0x1000, 0x800, "first.sys");
+  EXPECT_EQ(2U, index.module_count());
+  EXPECT_EQ("first.sys", index.module(first).name);
+
+  EXPECT_EQ(ModuleIndex::kUnknownModule, index.Lookup(0xFFF));
+  EXPECT_EQ(first, index.Lookup(0x1000));
+  EXPECT_EQ(first, index.Lookup(0x17FF));
+  EXPECT_EQ(ModuleIndex::kUnknownModule, index.Lookup(0x1800));
+  EXPECT_EQ(second, index.Lookup(0x3000));
+  EXPECT_EQ(second, index.Lookup(0x3FFF));
+  EXPECT_EQ(ModuleIndex::kUnknownModule, index.Lookup(0x4000));
+}
+
+TEST(ModuleIndexTest, AddAfterLookup) {
+  ModuleIndex index;
+  uint32 first = index.AddModule(0x1000, 0x1000, "first.sys");
+  EXPECT_EQ(first, index.Lookup(0x1800));
+
+  uint32 second = index.AddModule(0x5000, 0x1000, "second.sys");
+  uint32 third = index.AddModule(0x3000, 0x1000, "third.sys");
+  EXPECT_EQ(first, index.Lookup(0x1800));
+  EXPECT_EQ(second, index.Lookup(0x5800));
+  EXPECT_EQ(third, index.Lookup(0x3800));
+}
+
+TEST(ModuleIndexTest, ReplaceModule) {
+  ModuleIndex index;
+  index.AddModule(0x1000, 0x1000, "old.sys");
+  index.AddModule(0x4000, 0x1000, "other.sys");
+  uint32 replacement = index.AddModule(0x1000, 0x2000, "new.sys");
+
+  EXPECT_EQ(replacement, index.Lookup(0x1000));
+  EXPECT_EQ(replacement, index.Lookup(0x2800));
+  EXPECT_EQ("other.sys", index.module(index.Lookup(0x4000)).name);
+}
+
+}  // namespace analysis
@@ -0,0 +1,296 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/page_fault_analyzer.h"
+
+#include "analysis/kernel_event.h"
+#include "analysis/report_utils.h"
+#include "base/logging.h"
+#include "base/string_utils.h"
+#include "flyweight/internals/flyweight_tree_map_impl.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::Timestamp;
+
+// The maximal number of buckets of the series. Bounds the memory used when a
+// timestamp is corrupted.
+const size_t kMaxBuckets = 1 << 20;
+
+struct FaultOperation {
+  const char* operation;
+  FaultType type;
+};
+
+const FaultOperation kFaultOperations[] = {
+  { "TransitionFault", FAULT_TRANSITION },
+  { "DemandZeroFault", FAULT_DEMAND_ZERO },
+  { "CopyOnWrite", FAULT_COPY_ON_WRITE },
+  { "GuardPageFault", FAULT_GUARD_PAGE },
+  { "HardPageFault", FAULT_HARD_PAGE },
+  { "AccessViolation", FAULT_ACCESS_VIOLATION },
+};
+
+COMPILE_ASSERT(sizeof(kFaultOperations) / sizeof(FaultOperation) ==
+                   FAULT_TYPE_COUNT,
+               fault_operations_must_cover_fault_types);
+
+void ReceivePageFault(const KernelEvent& event, PageFaultAnalyzer* analyzer) {
+  DCHECK(analyzer != NULL);
+  const StructValue* content = event.content();
+
+  if (event.operation() == "HardFault") {
+    uint64 initial_time = 0;
+    uint64 file_object = 0;
+    uint32 thread_id = 0;
+    uint32 bytes = 0;
+    if (content->GetFieldAsULong("InitialTime", &initial_time) &&
+        content->GetFieldAsULong("FileObject", &file_object) &&
+        content->GetFieldAsUInteger("TThreadId", &thread_id) &&
+        content->GetFieldAsUInteger("ByteCount", &bytes)) {
+      analyzer->OnHardFault(event.timestamp(), initial_time,
+                            event.process_id(), thread_id, file_object,
+                            bytes);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < FAULT_TYPE_COUNT; ++i) {
+    if (event.operation() == kFaultOperations[i].operation) {
+      analyzer->OnFault(event.timestamp(), event.process_id(),
+                        kFaultOperations[i].type);
+      return;
+    }
+  }
+}
+
+void ReceiveFileIO(const KernelEvent& event, PageFaultAnalyzer* analyzer) {
+  DCHECK(analyzer != NULL);
+  const std::string& operation = event.operation();
+
+  // The name events report a FileName, the Create event an OpenPath.
+  const char* name_field = NULL;
+  if (operation == "FileCreate" || operation == "FileRundown")
+    name_field = "FileName";
+  else if (operation == "Create")
+    name_field = "OpenPath";
+  else
+    return;
+
+  uint64 file_object = 0;
+  std::wstring wide_name;
+  if (!event.content()->GetFieldAsULong("FileObject", &file_object) ||
+      !event.content()->GetFieldAsWString(name_field, &wide_name)) {
+    return;
+  }
+  analyzer->OnFileName(file_object, base::WStringToString(wide_name));
+}
+
+void ReceiveThread(const KernelEvent& event, PageFaultAnalyzer* analyzer) {
+  DCHECK(analyzer != NULL);
+  if (event.operation() != "Start" && event.operation() != "DCStart")
+    return;
+
+  uint32 process_id = 0;
+  uint32 thread_id = 0;
+  if (event.content()->GetFieldAsUInteger("ProcessId", &process_id) &&
+      event.content()->GetFieldAsUInteger("TThreadId", &thread_id)) {
+    analyzer->OnThread(process_id, thread_id);
+  }
+}
+
+void AddHardFault(Timestamp latency,
+                  uint32 bytes,
+                  PageFaultAnalyzer::HardFaults* faults) {
+  DCHECK(faults != NULL);
+  ++faults->count;
+  faults->bytes += bytes;
+  faults->latency.Add(latency);
+}
+
+}  // namespace
+
+const char PageFaultAnalyzer::kUnknownFileName[] = "<unknown>";
+
+PageFaultAnalyzer::ProcessFaults::ProcessFaults() {
+  for (size_t i = 0; i < FAULT_TYPE_COUNT; ++i)
+    faults[i] = 0;
+}
+
+PageFaultAnalyzer::PageFaultAnalyzer(Timestamp bucket_duration)
+    : bucket_duration_(bucket_duration),
+      file_names_(scoped_ptr<FileNames::Impl>(
+          new flyweight::internals::FlyweightTreeMapImpl<
+              std::string, FileNameTag>())),
+      has_series_start_(false),
+      series_start_(0) {
+  DCHECK_GT(bucket_duration, 0U);
+
+  size_t unknown_key = file_names_.Insert(kUnknownFileName).key_value();
+  DCHECK_EQ(0U, unknown_key);
+  file_faults_.resize(unknown_key + 1);
+}
+
+void PageFaultAnalyzer::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event))
+    return;
+
+  const std::string& category = kernel_event.category();
+  if (category == "PageFault")
+    ReceivePageFault(kernel_event, this);
+  else if (category == "FileIO")
+    ReceiveFileIO(kernel_event, this);
+  else if (category == "Thread")
+    ReceiveThread(kernel_event, this);
+}
+
+void PageFaultAnalyzer::OnThread(uint32 process_id, uint32 thread_id) {
+  *thread_processes_.FindOrInsert(thread_id) = process_id;
+}
+
+void PageFaultAnalyzer::OnFileName(uint64 file_object,
+                                   const std::string& name) {
+  size_t key = file_names_.Insert(name).key_value();
+  if (key >= file_faults_.size())
+    file_faults_.resize(key + 1);
+
+  // A file object address is reused once the object is closed: the last
+  // name wins.
+  *file_object_names_.FindOrInsert(file_object) = key;
+}
+
+void PageFaultAnalyzer::OnFault(Timestamp timestamp,
+                                uint32 process_id,
+                                FaultType type) {
+  DCHECK_LT(type, FAULT_TYPE_COUNT);
+
+  ++process_faults_.FindOrInsert(process_id)->faults[type];
+
+  FaultBucket* bucket = GetBucket(timestamp);
+  if (bucket != NULL)
+    ++bucket->faults;
+}
+
+void PageFaultAnalyzer::OnHardFault(Timestamp timestamp,
+                                    Timestamp initial_time,
+                                    uint32 process_id,
+                                    uint32 thread_id,
+                                    uint64 file_object,
+                                    uint32 bytes) {
+  Timestamp latency = 0;
+  if (timestamp > initial_time)
+    latency = timestamp - initial_time;
+
+  const size_t* key = file_object_names_.Find(file_object);
+  AddHardFault(latency, bytes, &file_faults_[key != NULL ? *key : 0]);
+
+  const uint32* thread_process = thread_processes_.Find(thread_id);
+  if (thread_process != NULL)
+    process_id = *thread_process;
+  AddHardFault(latency, bytes,
+               &process_faults_.FindOrInsert(process_id)->hard_faults);
+
+  FaultBucket* bucket = GetBucket(timestamp);
+  if (bucket != NULL) {
+    ++bucket->hard_faults;
+    bucket->bytes += bytes;
+  }
+}
+
+const PageFaultAnalyzer::HardFaults* PageFaultAnalyzer::GetFileFaults(
+    const std::string& name) const {
+  // A linear scan avoids inserting |name| in the flyweight. This is a query,
+  // not a per-event operation.
+  for (size_t key = 0; key < file_faults_.size(); ++key) {
+    if (file_faults_[key].count != 0 &&
+        file_names_.ValueOf(FileNames::Key(key)) == name) {
+      return &file_faults_[key];
+    }
+  }
+  return NULL;
+}
+
+const PageFaultAnalyzer::ProcessFaults* PageFaultAnalyzer::GetProcessFaults(
+    uint32 process_id) const {
+  return process_faults_.Find(process_id);
+}
+
+bool PageFaultAnalyzer::WriteReport(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  for (size_t key = 0; key < file_faults_.size(); ++key) {
+    const HardFaults& faults = file_faults_[key];
+    if (faults.count == 0)
+      continue;
+    *out << "file " << faults.count << ' ' << faults.bytes << ' ';
+    WriteHistogramSummary(faults.latency, out);
+    *out << ' ' << file_names_.ValueOf(FileNames::Key(key)) << '\n';
+  }
+
+  for (IdMap<ProcessFaults>::const_iterator it = process_faults_.begin();
+       it != process_faults_.end(); ++it) {
+    const ProcessFaults& faults = it->second;
+    *out << "process " << it->first;
+    for (size_t i = 0; i < FAULT_TYPE_COUNT; ++i)
+      *out << ' ' << faults.faults[i];
+    *out << ' ' << faults.hard_faults.count << ' '
+         << faults.hard_faults.bytes << ' ';
+    WriteHistogramSummary(faults.hard_faults.latency, out);
+    *out << '\n';
+  }
+
+  for (size_t i = 0; i < series_.size(); ++i) {
+    *out << "bucket " << i << ' ' << series_[i].faults << ' '
+         << series_[i].hard_faults << ' ' << series_[i].bytes << '\n';
+  }
+
+  return out->good();
+}
+
+PageFaultAnalyzer::FaultBucket* PageFaultAnalyzer::GetBucket(
+    Timestamp timestamp) {
+  if (!has_series_start_) {
+    has_series_start_ = true;
+    series_start_ = timestamp;
+  }
+
+  size_t bucket = 0;
+  if (timestamp > series_start_)
+    bucket = (timestamp - series_start_) / bucket_duration_;
+  if (bucket >= kMaxBuckets)
+    return NULL;
+
+  if (bucket >= series_.size()) {
+    FaultBucket empty = {};
+    series_.resize(bucket + 1, empty);
+  }
+  return &series_[bucket];
+}
+
+}  // namespace analysis
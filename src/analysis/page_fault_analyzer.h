@@ -0,0 +1,201 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// A page fault analyzer summarizes the PageFault events instead of dumping
+// them: on a host under memory pressure, a trace holds millions of faults.
+//
+// The faults are counted per process and per type. The hard faults, which
+// read a page from a file, are also attributed to their file: the FileObject
+// of a HardFault event is joined with the names reported by the FileIO
+// events. For each file and each process, the analyzer keeps the number of
+// hard faults, the bytes read and a histogram of the fault I/O latencies.
+// Finally, the faults are counted per time bucket.
+//
+// File names are interned: a name shared by many file objects is stored
+// once, and the statistics are indexed by the key of the name.
+//
+// Usage example:
+//   PageFaultAnalyzer analyzer(kOneSecond);
+//   parser.Parse(base::MakeObserver(&analyzer, &PageFaultAnalyzer::Receive));
+//   analyzer.WriteReport(&std::cout);
+
+#ifndef ANALYSIS_PAGE_FAULT_ANALYZER_H_
+#define ANALYSIS_PAGE_FAULT_ANALYZER_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "analysis/histogram.h"
+#include "analysis/id_map.h"
+#include "base/base.h"
+#include "event/event.h"
+#include "flyweight/flyweight.h"
+
+namespace analysis {
+
+enum FaultType {
+  FAULT_TRANSITION,
+  FAULT_DEMAND_ZERO,
+  FAULT_COPY_ON_WRITE,
+  FAULT_GUARD_PAGE,
+  FAULT_HARD_PAGE,
+  FAULT_ACCESS_VIOLATION,
+  FAULT_TYPE_COUNT
+};
+
+class PageFaultAnalyzer {
+ public:
+  // The name of the file of the hard faults whose file object has no name.
+  static const char kUnknownFileName[];
+
+  // The hard faults of a file or a process.
+  struct HardFaults {
+    HardFaults() : count(0), bytes(0) {}
+
+    uint64 count;
+    uint64 bytes;
+    // The durations of the fault I/Os, in timestamp units.
+    Histogram latency;
+  };
+
+  // The faults of a process.
+  struct ProcessFaults {
+    ProcessFaults();
+
+    uint64 faults[FAULT_TYPE_COUNT];
+    HardFaults hard_faults;
+  };
+
+  // The faults of a time bucket.
+  struct FaultBucket {
+    uint64 faults;
+    uint64 hard_faults;
+    uint64 bytes;
+  };
+
+  // @param bucket_duration the duration of the time buckets, in timestamp
+  //     units.
+  explicit PageFaultAnalyzer(event::Timestamp bucket_duration);
+
+  // Consumes an event of the ETW parser. The PageFault, FileIO and Thread
+  // events are used, the other events are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Records the process of a thread.
+  // @param process_id the process owning |thread_id|.
+  // @param thread_id a thread.
+  void OnThread(uint32 process_id, uint32 thread_id);
+
+  // Records the name of a file object.
+  // @param file_object the address of the file object.
+  // @param name the name of the file.
+  void OnFileName(uint64 file_object, const std::string& name);
+
+  // Records a page fault.
+  // @param timestamp the time of the fault.
+  // @param process_id the faulting process.
+  // @param type the type of the fault.
+  void OnFault(event::Timestamp timestamp, uint32 process_id, FaultType type);
+
+  // Records a hard fault.
+  // @param timestamp the completion time of the fault I/O.
+  // @param initial_time the start time of the fault I/O.
+  // @param process_id the process of the event, used when the process of
+  //     |thread_id| is unknown.
+  // @param thread_id the faulting thread.
+  // @param file_object the file read by the fault.
+  // @param bytes the number of bytes read.
+  void OnHardFault(event::Timestamp timestamp,
+                   event::Timestamp initial_time,
+                   uint32 process_id,
+                   uint32 thread_id,
+                   uint64 file_object,
+                   uint32 bytes);
+
+  // @param name the name of a file.
+  // @returns the hard faults of |name|, or NULL if it has none.
+  const HardFaults* GetFileFaults(const std::string& name) const;
+
+  // @param process_id a process.
+  // @returns the faults of |process_id|, or NULL if it has none.
+  const ProcessFaults* GetProcessFaults(uint32 process_id) const;
+
+  // @returns the faults per bucket. The first bucket starts at
+  //     series_start().
+  const std::vector<FaultBucket>& series() const { return series_; }
+
+  // @returns the start of the first bucket.
+  event::Timestamp series_start() const { return series_start_; }
+
+  // Writes the faults per file, per process and per bucket:
+  //   "file <hard faults> <bytes> <latency summary> <name>"
+  //   "process <pid> <faults per type> <hard faults> <bytes>
+  //        <latency summary>"
+  //   "bucket <index> <faults> <hard faults> <bytes>"
+  // The latency summary is written by WriteHistogramSummary. The file name
+  // comes last since it may contain spaces.
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteReport(std::ostream* out) const;
+
+ private:
+  struct FileNameTag {};
+  typedef flyweight::Flyweight<std::string, FileNameTag> FileNames;
+
+  // @returns the bucket of |timestamp|, or NULL if it is past the last
+  //     bucket.
+  FaultBucket* GetBucket(event::Timestamp timestamp);
+
+  event::Timestamp bucket_duration_;
+
+  // The interned file names. The keys are dense, starting at zero with
+  // kUnknownFileName.
+  FileNames file_names_;
+
+  // The key value of the name of each file object.
+  IdMap<size_t, uint64> file_object_names_;
+
+  // The hard faults per file, indexed by name key value.
+  std::vector<HardFaults> file_faults_;
+
+  // The process of each thread.
+  IdMap<uint32> thread_processes_;
+
+  // The faults of each process.
+  IdMap<ProcessFaults> process_faults_;
+
+  bool has_series_start_;
+  event::Timestamp series_start_;
+  std::vector<FaultBucket> series_;
+
+  DISALLOW_COPY_AND_ASSIGN(PageFaultAnalyzer);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_PAGE_FAULT_ANALYZER_H_
@@ -0,0 +1,65 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/page_fault_analyzer.h"
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+const size_t kFaults = 1000000;
+const size_t kFiles = 2000;
+const size_t kThreads = 500;
+const uint64 kFirstFileObject = 0xFFFFFA8001000000ULL;
+
+}  // namespace
+
+TEST(PageFaultAnalyzerPerfTest, OnHardFault) {
+  PageFaultAnalyzer analyzer(1000000);
+  for (size_t i = 0; i < kThreads; ++i)
+    analyzer.OnThread(static_cast<uint32>(i % 50), static_cast<uint32>(i * 4));
+  for (size_t i = 0; i < kFiles; ++i) {
+    analyzer.OnFileName(kFirstFileObject + i * 0x40,
+                        i % 2 == 0 ? "C:\\even.dll" : "C:\\odd.dll");
+  }
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kFaults; ++i) {
+    event::Timestamp timestamp = i * 100;
+    analyzer.OnHardFault(timestamp + 50 + i % 97, timestamp, 0,
+                         static_cast<uint32>((i % kThreads) * 4),
+                         kFirstFileObject + ((i * 7919) % kFiles) * 0x40,
+                         4096);
+  }
+  base::PrintPerfResult("OnHardFault", "time", timer.ElapsedNanoseconds(),
+                        kFaults, "ns/fault");
+
+  EXPECT_EQ(kFaults / 2, analyzer.GetFileFaults("C:\\even.dll")->count);
+}
+
+}  // namespace analysis
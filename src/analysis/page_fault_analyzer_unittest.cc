@@ -0,0 +1,219 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/page_fault_analyzer.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::WStringValue;
+
+const uint32 kProcessId = 1234;
+const uint32 kOtherProcessId = 5678;
+const uint32 kThreadId = 4000;
+const uint64 kFileObject = 0xFFFFFA8001000040ULL;
+const uint64 kOtherFileObject = 0xFFFFFA8001000080ULL;
+
+void SendThreadStart(PageFaultAnalyzer* analyzer,
+                     uint32 process_id,
+                     uint32 thread_id) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("ProcessId", process_id);
+  content->AddField<UIntValue>("TThreadId", thread_id);
+  analyzer->Receive(*CreateKernelEvent(0, "Thread", "DCStart", 0, 0, 0,
+                                       content.Pass()).get());
+}
+
+void SendFileName(PageFaultAnalyzer* analyzer,
+                  const char* operation,
+                  uint64 file_object,
+                  const wchar_t* name) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("FileObject", file_object);
+  content->AddField<WStringValue>("FileName", name);
+  analyzer->Receive(*CreateKernelEvent(0, "FileIO", operation, 0, 0, 0,
+                                       content.Pass()).get());
+}
+
+void SendHardFault(PageFaultAnalyzer* analyzer,
+                   event::Timestamp timestamp,
+                   event::Timestamp initial_time,
+                   uint32 thread_id,
+                   uint64 file_object,
+                   uint32 bytes) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("InitialTime", initial_time);
+  content->AddField<ULongValue>("ReadOffset", 0);
+  content->AddField<ULongValue>("VirtualAddress", 0x10000);
+  content->AddField<ULongValue>("FileObject", file_object);
+  content->AddField<UIntValue>("TThreadId", thread_id);
+  content->AddField<UIntValue>("ByteCount", bytes);
+  analyzer->Receive(*CreateKernelEvent(timestamp, "PageFault", "HardFault",
+                                       0, thread_id, 0,
+                                       content.Pass()).get());
+}
+
+void SendFault(PageFaultAnalyzer* analyzer,
+               event::Timestamp timestamp,
+               uint32 process_id,
+               const char* operation) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("VirtualAddress", 0x10000);
+  content->AddField<ULongValue>("ProgramCounter", 0x20000);
+  analyzer->Receive(*CreateKernelEvent(timestamp, "PageFault", operation,
+                                       process_id, 0, 0,
+                                       content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(PageFaultAnalyzerTest, CountFaultsPerType) {
+  PageFaultAnalyzer analyzer(100);
+  SendFault(&analyzer, 0, kProcessId, "TransitionFault");
+  SendFault(&analyzer, 1, kProcessId, "DemandZeroFault");
+  SendFault(&analyzer, 2, kProcessId, "DemandZeroFault");
+  SendFault(&analyzer, 3, kProcessId, "AccessViolation");
+  SendFault(&analyzer, 4, kOtherProcessId, "CopyOnWrite");
+
+  const PageFaultAnalyzer::ProcessFaults* faults =
+      analyzer.GetProcessFaults(kProcessId);
+  ASSERT_TRUE(faults != NULL);
+  EXPECT_EQ(1U, faults->faults[FAULT_TRANSITION]);
+  EXPECT_EQ(2U, faults->faults[FAULT_DEMAND_ZERO]);
+  EXPECT_EQ(0U, faults->faults[FAULT_COPY_ON_WRITE]);
+  EXPECT_EQ(1U, faults->faults[FAULT_ACCESS_VIOLATION]);
+  EXPECT_EQ(0U, faults->hard_faults.count);
+
+  faults = analyzer.GetProcessFaults(kOtherProcessId);
+  ASSERT_TRUE(faults != NULL);
+  EXPECT_EQ(1U, faults->faults[FAULT_COPY_ON_WRITE]);
+  EXPECT_EQ(NULL, analyzer.GetProcessFaults(42));
+}
+
+TEST(PageFaultAnalyzerTest, AttributeHardFaults) {
+  PageFaultAnalyzer analyzer(100);
+  SendThreadStart(&analyzer, kProcessId, kThreadId);
+  SendFileName(&analyzer, "FileRundown", kFileObject, L"C:\\a.dll");
+  SendHardFault(&analyzer, 110, 100, kThreadId, kFileObject, 4096);
+  SendHardFault(&analyzer, 150, 120, kThreadId, kFileObject, 8192);
+
+  const PageFaultAnalyzer::HardFaults* file_faults =
+      analyzer.GetFileFaults("C:\\a.dll");
+  ASSERT_TRUE(file_faults != NULL);
+  EXPECT_EQ(2U, file_faults->count);
+  EXPECT_EQ(12288U, file_faults->bytes);
+  EXPECT_EQ(10U, file_faults->latency.min());
+  EXPECT_EQ(30U, file_faults->latency.max());
+
+  const PageFaultAnalyzer::ProcessFaults* process_faults =
+      analyzer.GetProcessFaults(kProcessId);
+  ASSERT_TRUE(process_faults != NULL);
+  EXPECT_EQ(2U, process_faults->hard_faults.count);
+  EXPECT_EQ(12288U, process_faults->hard_faults.bytes);
+}
+
+TEST(PageFaultAnalyzerTest, InternFileNames) {
+  PageFaultAnalyzer analyzer(100);
+  SendFileName(&analyzer, "FileCreate", kFileObject, L"C:\\a.dll");
+  SendFileName(&analyzer, "FileCreate", kOtherFileObject, L"C:\\a.dll");
+  SendHardFault(&analyzer, 10, 0, kThreadId, kFileObject, 4096);
+  SendHardFault(&analyzer, 20, 10, kThreadId, kOtherFileObject, 4096);
+
+  const PageFaultAnalyzer::HardFaults* file_faults =
+      analyzer.GetFileFaults("C:\\a.dll");
+  ASSERT_TRUE(file_faults != NULL);
+  EXPECT_EQ(2U, file_faults->count);
+}
+
+TEST(PageFaultAnalyzerTest, UnknownFileAndThread) {
+  PageFaultAnalyzer analyzer(100);
+  SendHardFault(&analyzer, 10, 0, kThreadId, kFileObject, 4096);
+
+  const PageFaultAnalyzer::HardFaults* file_faults =
+      analyzer.GetFileFaults(PageFaultAnalyzer::kUnknownFileName);
+  ASSERT_TRUE(file_faults != NULL);
+  EXPECT_EQ(1U, file_faults->count);
+  EXPECT_EQ(NULL, analyzer.GetFileFaults("C:\\a.dll"));
+
+  // The fault is attributed to the process of the event.
+  const PageFaultAnalyzer::ProcessFaults* process_faults =
+      analyzer.GetProcessFaults(0);
+  ASSERT_TRUE(process_faults != NULL);
+  EXPECT_EQ(1U, process_faults->hard_faults.count);
+}
+
+TEST(PageFaultAnalyzerTest, ReusedFileObject) {
+  PageFaultAnalyzer analyzer(100);
+  SendFileName(&analyzer, "FileCreate", kFileObject, L"C:\\a.dll");
+  SendHardFault(&analyzer, 10, 0, kThreadId, kFileObject, 4096);
+  SendFileName(&analyzer, "FileCreate", kFileObject, L"C:\\b.dll");
+  SendHardFault(&analyzer, 20, 10, kThreadId, kFileObject, 4096);
+
+  EXPECT_EQ(1U, analyzer.GetFileFaults("C:\\a.dll")->count);
+  EXPECT_EQ(1U, analyzer.GetFileFaults("C:\\b.dll")->count);
+}
+
+TEST(PageFaultAnalyzerTest, Series) {
+  PageFaultAnalyzer analyzer(100);
+  SendFault(&analyzer, 1000, kProcessId, "TransitionFault");
+  SendFault(&analyzer, 1050, kProcessId, "TransitionFault");
+  SendHardFault(&analyzer, 1250, 1200, kThreadId, kFileObject, 4096);
+
+  EXPECT_EQ(1000U, analyzer.series_start());
+  const std::vector<PageFaultAnalyzer::FaultBucket>& series =
+      analyzer.series();
+  ASSERT_EQ(3U, series.size());
+  EXPECT_EQ(2U, series[0].faults);
+  EXPECT_EQ(0U, series[0].hard_faults);
+  EXPECT_EQ(0U, series[1].faults);
+  EXPECT_EQ(1U, series[2].hard_faults);
+  EXPECT_EQ(4096U, series[2].bytes);
+}
+
+TEST(PageFaultAnalyzerTest, WriteReport) {
+  PageFaultAnalyzer analyzer(100);
+  SendThreadStart(&analyzer, kProcessId, kThreadId);
+  SendFileName(&analyzer, "FileRundown", kFileObject, L"C:\\my file.dll");
+  SendFault(&analyzer, 0, kProcessId, "DemandZeroFault");
+  SendHardFault(&analyzer, 10, 0, kThreadId, kFileObject, 4096);
+
+  std::ostringstream out;
+  EXPECT_TRUE(analyzer.WriteReport(&out));
+  EXPECT_EQ("file 1 4096 1 10 10 10 10 10 C:\\my file.dll\n"
+            "process 1234 0 1 0 0 0 0 1 4096 1 10 10 10 10 10\n"
+            "bucket 0 1 1 4096\n",
+            out.str());
+}
+
+}  // namespace analysis
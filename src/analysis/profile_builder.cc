@@ -0,0 +1,299 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/profile_builder.h"
+
+#include <iterator>
+
+#include "analysis/kernel_event.h"
+#include "analysis/report_utils.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+using event::ArrayValue;
+using event::StackId;
+using event::StackTable;
+using event::StructValue;
+using event::Timestamp;
+
+template <typename T>
+void WriteRaw(const T& value, std::ostream* out) {
+  out->write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+const uint32 ProfileBuilder::kBinaryMagic;
+const uint32 ProfileBuilder::kBinaryVersion;
+
+ProfileBuilder::ProfileBuilder(Timestamp reorder_window)
+    : reorder_window_(reorder_window),
+      stack_table_(NULL),
+      last_process_id_(0),
+      last_profile_(NULL),
+      matched_samples_(0),
+      unmatched_samples_(0),
+      dropped_stacks_(0) {
+}
+
+ProfileBuilder::~ProfileBuilder() {
+  for (Profiles::iterator it = profiles_.begin(); it != profiles_.end(); ++it)
+    delete it->second;
+}
+
+void ProfileBuilder::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event))
+    return;
+  const StructValue* content = kernel_event.content();
+
+  if (kernel_event.Is("PerfInfo", "SampleProf")) {
+    uint64 instruction_pointer = 0;
+    uint32 thread_id = 0;
+    if (!content->GetFieldAsULong("InstructionPointer",
+                                  &instruction_pointer) ||
+        !content->GetFieldAsUInteger("ThreadId", &thread_id)) {
+      return;
+    }
+    AddSample(kernel_event.timestamp(),
+              static_cast<uint32>(kernel_event.process_id()),
+              thread_id,
+              instruction_pointer);
+    return;
+  }
+
+  if (!kernel_event.Is("StackWalk", "Stack"))
+    return;
+
+  uint64 timestamp = 0;
+  uint32 process_id = 0;
+  uint32 thread_id = 0;
+  if (!content->GetFieldAsULong("EventTimeStamp", &timestamp) ||
+      !content->GetFieldAsUInteger("StackProcess", &process_id) ||
+      !content->GetFieldAsUInteger("StackThread", &thread_id)) {
+    return;
+  }
+
+  const ArrayValue* frames = NULL;
+  uint32 stack_id = 0;
+  if (content->GetFieldAs<ArrayValue>("Stack", &frames)) {
+    scratch_stack_.resize(frames->Length());
+    for (size_t i = 0; i < frames->Length(); ++i) {
+      if (!frames->GetElementAsULong(i, &scratch_stack_[i]))
+        return;
+    }
+  } else if (content->GetFieldAsUInteger("StackId", &stack_id)) {
+    if (stack_table_ == NULL || stack_id >= stack_table_->stack_count()) {
+      LOG(ERROR) << "Unknown stack identifier: " << stack_id;
+      return;
+    }
+    stack_table_->GetStack(StackId(stack_id), &scratch_stack_);
+  } else {
+    return;
+  }
+
+  if (scratch_stack_.empty())
+    return;
+  AddStack(timestamp, process_id, thread_id,
+           &scratch_stack_[0], scratch_stack_.size());
+}
+
+void ProfileBuilder::AddSample(Timestamp timestamp,
+                               uint32 process_id,
+                               uint32 thread_id,
+                               uint64 instruction_pointer) {
+  PendingKey key(timestamp, thread_id);
+
+  PendingStacks::iterator stack = pending_stacks_.find(key);
+  if (stack != pending_stacks_.end()) {
+    ++matched_samples_;
+    const event::Stack& frames = stack->second.frames;
+    Count(stack->second.process_id, &frames[0], frames.size());
+    pending_stacks_.erase(stack);
+  } else {
+    PendingSample& sample = pending_samples_[key];
+    sample.process_id = process_id;
+    sample.instruction_pointer = instruction_pointer;
+  }
+
+  Expire(timestamp);
+}
+
+void ProfileBuilder::AddStack(Timestamp timestamp,
+                              uint32 process_id,
+                              uint32 thread_id,
+                              const uint64* frames,
+                              size_t count) {
+  DCHECK(frames != NULL);
+  DCHECK_GT(count, 0U);
+
+  PendingKey key(timestamp, thread_id);
+
+  PendingSamples::iterator sample = pending_samples_.find(key);
+  if (sample != pending_samples_.end()) {
+    ++matched_samples_;
+    Count(process_id, frames, count);
+    pending_samples_.erase(sample);
+  } else {
+    PendingStack& stack = pending_stacks_[key];
+    stack.process_id = process_id;
+    stack.frames.assign(frames, frames + count);
+  }
+
+  Expire(timestamp);
+}
+
+void ProfileBuilder::Flush() {
+  ExpireSamples(pending_samples_.end());
+  ExpireStacks(pending_stacks_.end());
+}
+
+bool ProfileBuilder::WriteFolded(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  event::Stack stack;
+  for (Profiles::const_iterator it = profiles_.begin();
+       it != profiles_.end(); ++it) {
+    const ProcessProfile& profile = *it->second;
+    for (size_t id = 0; id < profile.counts.size(); ++id) {
+      if (profile.counts[id] == 0)
+        continue;
+      profile.stacks.GetStack(StackId(id), &stack);
+      *out << it->first;
+      for (size_t i = stack.size(); i > 0; --i) {
+        out->put(';');
+        WriteHex(stack[i - 1], out);
+      }
+      *out << ' ' << profile.counts[id] << '\n';
+    }
+  }
+
+  return out->good();
+}
+
+bool ProfileBuilder::WriteBinary(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  WriteRaw(kBinaryMagic, out);
+  WriteRaw(kBinaryVersion, out);
+  WriteRaw(static_cast<uint32>(profiles_.size()), out);
+
+  for (Profiles::const_iterator it = profiles_.begin();
+       it != profiles_.end(); ++it) {
+    const ProcessProfile& profile = *it->second;
+    const StackTable& stacks = profile.stacks;
+
+    WriteRaw(it->first, out);
+    WriteRaw(static_cast<uint32>(stacks.node_count()), out);
+    for (uint32 i = 0; i < stacks.node_count(); ++i) {
+      WriteRaw(stacks.node(i).frame, out);
+      WriteRaw(stacks.node(i).parent, out);
+    }
+
+    uint32 stack_count = 0;
+    for (size_t id = 0; id < profile.counts.size(); ++id) {
+      if (profile.counts[id] != 0)
+        ++stack_count;
+    }
+    WriteRaw(stack_count, out);
+    for (size_t id = 0; id < profile.counts.size(); ++id) {
+      if (profile.counts[id] == 0)
+        continue;
+      WriteRaw(stacks.GetNode(StackId(id)), out);
+      WriteRaw(profile.counts[id], out);
+    }
+  }
+
+  return out->good();
+}
+
+uint64 ProfileBuilder::GetCount(uint32 process_id,
+                                const event::Stack& stack) const {
+  Profiles::const_iterator it = profiles_.find(process_id);
+  if (it == profiles_.end())
+    return 0;
+
+  const ProcessProfile& profile = *it->second;
+  event::Stack candidate;
+  for (size_t id = 0; id < profile.counts.size(); ++id) {
+    profile.stacks.GetStack(StackId(id), &candidate);
+    if (candidate == stack)
+      return profile.counts[id];
+  }
+  return 0;
+}
+
+void ProfileBuilder::Count(uint32 process_id,
+                           const uint64* frames,
+                           size_t count) {
+  ProcessProfile* profile = GetProfile(process_id);
+  size_t id = profile->stacks.Insert(frames, count).key_value();
+  if (id >= profile->counts.size())
+    profile->counts.resize(id + 1, 0);
+  ++profile->counts[id];
+}
+
+void ProfileBuilder::Expire(Timestamp timestamp) {
+  if (timestamp < reorder_window_)
+    return;
+  PendingKey limit(timestamp - reorder_window_, 0);
+  if (!pending_samples_.empty() && pending_samples_.begin()->first < limit)
+    ExpireSamples(pending_samples_.lower_bound(limit));
+  if (!pending_stacks_.empty() && pending_stacks_.begin()->first < limit)
+    ExpireStacks(pending_stacks_.lower_bound(limit));
+}
+
+void ProfileBuilder::ExpireSamples(PendingSamples::iterator end) {
+  for (PendingSamples::iterator it = pending_samples_.begin();
+       it != end; ++it) {
+    ++unmatched_samples_;
+    Count(it->second.process_id, &it->second.instruction_pointer, 1);
+  }
+  pending_samples_.erase(pending_samples_.begin(), end);
+}
+
+void ProfileBuilder::ExpireStacks(PendingStacks::iterator end) {
+  dropped_stacks_ += std::distance(pending_stacks_.begin(), end);
+  pending_stacks_.erase(pending_stacks_.begin(), end);
+}
+
+ProfileBuilder::ProcessProfile* ProfileBuilder::GetProfile(
+    uint32 process_id) {
+  if (last_profile_ != NULL && last_process_id_ == process_id)
+    return last_profile_;
+
+  ProcessProfile*& profile = profiles_[process_id];
+  if (profile == NULL)
+    profile = new ProcessProfile();
+
+  last_process_id_ = process_id;
+  last_profile_ = profile;
+  return profile;
+}
+
+}  // namespace analysis
@@ -0,0 +1,203 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A profile builder aggregates the samples of a sampling profile into folded
+// stacks. Each PerfInfo/SampleProf event is joined with the StackWalk/Stack
+// event captured for the same thread at the same timestamp:
+//
+//   SampleProf  { InstructionPointer, ThreadId, ... }     at timestamp T
+//   Stack       { EventTimeStamp = T, StackProcess, StackThread, Stack }
+//
+// Both events are usually adjacent in the stream, but the buffers of the
+// processors are not strictly ordered. A sample and its stack are paired when
+// they arrive within a reorder window of each other; past the window, a
+// sample is counted with its instruction pointer alone and a stack is
+// dropped.
+//
+// The stacks are interned in a StackTable per process, so the memory used by
+// a profile grows with the number of distinct stacks, not with the number of
+// samples.
+//
+// Usage example:
+//   ProfileBuilder builder(kReorderWindow);
+//   parser.Parse(base::MakeObserver(&builder, &ProfileBuilder::Receive));
+//   builder.Flush();
+//   builder.WriteFolded(&std::cout);
+
+#ifndef ANALYSIS_PROFILE_BUILDER_H_
+#define ANALYSIS_PROFILE_BUILDER_H_
+
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "base/base.h"
+#include "event/event.h"
+#include "event/stack_table.h"
+
+namespace analysis {
+
+class ProfileBuilder {
+ public:
+  // The magic number and the version of the binary profile format.
+  static const uint32 kBinaryMagic = 0x4650544C;  // "LTPF" in little endian.
+  static const uint32 kBinaryVersion = 1;
+
+  // @param reorder_window the maximal distance between the timestamps of the
+  //     events received for a sample and its stack.
+  explicit ProfileBuilder(event::Timestamp reorder_window);
+  ~ProfileBuilder();
+
+  // Sets the table holding the stacks of the StackWalk events that carry a
+  // "StackId" instead of their frames. Not owned.
+  void set_stack_table(const event::StackTable* stack_table) {
+    stack_table_ = stack_table;
+  }
+
+  // Consumes an event of the ETW parser. Events other than the samples and
+  // the stacks are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Adds a sample of the instruction pointer of a thread.
+  // @param timestamp the time of the sample.
+  // @param process_id the process of the thread, used if the sample is never
+  //     joined with a stack.
+  // @param thread_id the sampled thread.
+  // @param instruction_pointer the sampled instruction pointer.
+  void AddSample(event::Timestamp timestamp,
+                 uint32 process_id,
+                 uint32 thread_id,
+                 uint64 instruction_pointer);
+
+  // Adds the stack of a thread.
+  // @param timestamp the time of the event the stack was captured for.
+  // @param process_id the process of the thread.
+  // @param thread_id the thread.
+  // @param frames the frames of the stack, innermost first.
+  // @param count the number of frames.
+  void AddStack(event::Timestamp timestamp,
+                uint32 process_id,
+                uint32 thread_id,
+                const uint64* frames,
+                size_t count);
+
+  // Resolves the pending samples and stacks. Call at the end of the stream.
+  void Flush();
+
+  // Writes the profile in the folded stack format, one line per distinct
+  // stack: "<process id>;<outermost frame>;...;<innermost frame> <count>".
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteFolded(std::ostream* out) const;
+
+  // Writes the profile in a compact binary format, in host byte order:
+  //   uint32 magic, uint32 version, uint32 process count, then per process:
+  //   uint32 process id, uint32 node count, node count x (uint64 frame,
+  //   uint32 parent), uint32 stack count, stack count x (uint32 innermost
+  //   node, uint64 count).
+  // The node 0 is the root of the calling context tree of the process.
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteBinary(std::ostream* out) const;
+
+  // @param process_id the process of the stack.
+  // @param stack the frames of the stack, innermost first.
+  // @returns the number of samples counted for |stack|.
+  uint64 GetCount(uint32 process_id, const event::Stack& stack) const;
+
+  // Statistics.
+  // @{
+  uint64 matched_samples() const { return matched_samples_; }
+  uint64 unmatched_samples() const { return unmatched_samples_; }
+  uint64 dropped_stacks() const { return dropped_stacks_; }
+  // @}
+
+ private:
+  // The stacks and their counts for a process.
+  struct ProcessProfile {
+    event::StackTable stacks;
+    // The number of samples, indexed by StackId.
+    std::vector<uint64> counts;
+  };
+
+  // Pending events are keyed by timestamp first so that the expired ones are
+  // at the beginning of the maps.
+  typedef std::pair<event::Timestamp, uint32> PendingKey;
+
+  struct PendingSample {
+    uint32 process_id;
+    uint64 instruction_pointer;
+  };
+
+  struct PendingStack {
+    uint32 process_id;
+    event::Stack frames;
+  };
+
+  typedef std::map<PendingKey, PendingSample> PendingSamples;
+  typedef std::map<PendingKey, PendingStack> PendingStacks;
+  typedef std::map<uint32, ProcessProfile*> Profiles;
+
+  // Counts a sample for a stack.
+  void Count(uint32 process_id, const uint64* frames, size_t count);
+
+  // Resolves the pending events older than |timestamp| minus the window.
+  void Expire(event::Timestamp timestamp);
+
+  // Resolves the pending events before |end|.
+  void ExpireSamples(PendingSamples::iterator end);
+  void ExpireStacks(PendingStacks::iterator end);
+
+  // @returns the profile of a process, created if needed.
+  ProcessProfile* GetProfile(uint32 process_id);
+
+  event::Timestamp reorder_window_;
+  const event::StackTable* stack_table_;
+
+  PendingSamples pending_samples_;
+  PendingStacks pending_stacks_;
+
+  Profiles profiles_;
+
+  // The last profile returned by GetProfile. Consecutive samples often belong
+  // to the same process.
+  uint32 last_process_id_;
+  ProcessProfile* last_profile_;
+
+  // A buffer for the frames of the stacks received as a "StackId".
+  event::Stack scratch_stack_;
+
+  uint64 matched_samples_;
+  uint64 unmatched_samples_;
+  uint64 dropped_stacks_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProfileBuilder);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_PROFILE_BUILDER_H_
@@ -0,0 +1,67 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/profile_builder.h"
+
+#include <vector>
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+const size_t kSamples = 200000;
+const size_t kThreads = 64;
+const size_t kDistinctStacks = 512;
+const size_t kStackDepth = 24;
+
+}  // namespace
+
+TEST(ProfileBuilderPerfTest, AddSampleAndStack) {
+  // The samples of 64 processors, 10 kHz each, with a stack of 24 frames.
+  std::vector<uint64> frames(kStackDepth);
+  ProfileBuilder builder(1000000);
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kSamples; ++i) {
+    event::Timestamp timestamp = (i / kThreads) * 100000 + i % kThreads;
+    uint32 thread_id = static_cast<uint32>(i % kThreads);
+    size_t stack = (i * 7919) % kDistinctStacks;
+    for (size_t j = 0; j < kStackDepth; ++j)
+      frames[j] = 0x10000 + (stack >> (j / 4)) * 0x10 + j;
+
+    builder.AddSample(timestamp, 4, thread_id, frames[0]);
+    builder.AddStack(timestamp, 4, thread_id, &frames[0], kStackDepth);
+  }
+  builder.Flush();
+  base::PrintPerfResult("AddSampleAndStack", "time",
+                        timer.ElapsedNanoseconds(), kSamples, "ns/sample");
+
+  EXPECT_EQ(kSamples, builder.matched_samples());
+}
+
+}  // namespace analysis
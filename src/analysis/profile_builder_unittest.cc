@@ -0,0 +1,249 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/profile_builder.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::ArrayValue;
+using event::Stack;
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+
+const event::Timestamp kWindow = 100;
+
+scoped_ptr<event::Event> CreateSample(event::Timestamp timestamp,
+                                      uint32 process_id,
+                                      uint32 thread_id,
+                                      uint64 instruction_pointer) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("InstructionPointer", instruction_pointer);
+  content->AddField<UIntValue>("ThreadId", thread_id);
+  return CreateKernelEvent(timestamp, "PerfInfo", "SampleProf", process_id,
+                           thread_id, 0, content.Pass());
+}
+
+scoped_ptr<StructValue> CreateStackContent(event::Timestamp timestamp,
+                                           uint32 process_id,
+                                           uint32 thread_id) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("EventTimeStamp", timestamp);
+  content->AddField<UIntValue>("StackProcess", process_id);
+  content->AddField<UIntValue>("StackThread", thread_id);
+  return content.Pass();
+}
+
+scoped_ptr<event::Event> CreateStack(event::Timestamp timestamp,
+                                     uint32 process_id,
+                                     uint32 thread_id,
+                                     const Stack& stack) {
+  scoped_ptr<StructValue> content(
+      CreateStackContent(timestamp, process_id, thread_id));
+  scoped_ptr<ArrayValue> frames(new ArrayValue());
+  for (size_t i = 0; i < stack.size(); ++i)
+    frames->Append<ULongValue>(stack[i]);
+  content->AddField("Stack", frames.PassAs<event::Value>());
+  return CreateKernelEvent(timestamp + 1, "StackWalk", "Stack", process_id,
+                           thread_id, 0, content.Pass());
+}
+
+Stack MakeStack(uint64 inner, uint64 middle, uint64 outer) {
+  Stack stack;
+  stack.push_back(inner);
+  stack.push_back(middle);
+  stack.push_back(outer);
+  return stack;
+}
+
+}  // namespace
+
+TEST(ProfileBuilderTest, JoinSamplesWithStacks) {
+  const Stack kStack = MakeStack(0x1000, 0x2000, 0x3000);
+  const Stack kOtherStack = MakeStack(0x1100, 0x2000, 0x3000);
+
+  ProfileBuilder builder(kWindow);
+  builder.Receive(*CreateSample(10, 4, 8, 0x1000).get());
+  builder.Receive(*CreateStack(10, 4, 8, kStack).get());
+  builder.Receive(*CreateSample(20, 4, 8, 0x1000).get());
+  builder.Receive(*CreateStack(20, 4, 8, kStack).get());
+  builder.Receive(*CreateSample(30, 4, 9, 0x1100).get());
+  builder.Receive(*CreateStack(30, 4, 9, kOtherStack).get());
+  builder.Flush();
+
+  EXPECT_EQ(3U, builder.matched_samples());
+  EXPECT_EQ(0U, builder.unmatched_samples());
+  EXPECT_EQ(0U, builder.dropped_stacks());
+  EXPECT_EQ(2U, builder.GetCount(4, kStack));
+  EXPECT_EQ(1U, builder.GetCount(4, kOtherStack));
+  EXPECT_EQ(0U, builder.GetCount(5, kStack));
+}
+
+TEST(ProfileBuilderTest, JoinOutOfOrder) {
+  const Stack kStack = MakeStack(0x1000, 0x2000, 0x3000);
+
+  ProfileBuilder builder(kWindow);
+  // The stack of the first sample arrives after a sample of another thread,
+  // and the second stack arrives before its sample.
+  builder.AddSample(10, 4, 8, 0x1000);
+  builder.AddSample(12, 4, 9, 0x1000);
+  builder.AddStack(10, 4, 8, &kStack[0], kStack.size());
+  builder.AddStack(12, 4, 9, &kStack[0], kStack.size());
+  builder.Flush();
+
+  EXPECT_EQ(2U, builder.matched_samples());
+  EXPECT_EQ(2U, builder.GetCount(4, kStack));
+}
+
+TEST(ProfileBuilderTest, ExpireUnmatched) {
+  const Stack kStack = MakeStack(0x1000, 0x2000, 0x3000);
+
+  ProfileBuilder builder(kWindow);
+  builder.AddSample(10, 4, 8, 0x1000);
+  builder.AddStack(20, 4, 9, &kStack[0], kStack.size());
+
+  // Both events are out of the window: the sample is counted with its
+  // instruction pointer and the stack is dropped.
+  builder.AddSample(500, 4, 8, 0x4000);
+  EXPECT_EQ(1U, builder.unmatched_samples());
+  EXPECT_EQ(1U, builder.dropped_stacks());
+  EXPECT_EQ(1U, builder.GetCount(4, Stack(1, 0x1000)));
+
+  // The stack arrives too late to be joined.
+  builder.AddStack(10, 4, 8, &kStack[0], kStack.size());
+  builder.Flush();
+  EXPECT_EQ(0U, builder.matched_samples());
+  EXPECT_EQ(2U, builder.unmatched_samples());
+  EXPECT_EQ(2U, builder.dropped_stacks());
+  EXPECT_EQ(1U, builder.GetCount(4, Stack(1, 0x4000)));
+  EXPECT_EQ(0U, builder.GetCount(4, kStack));
+}
+
+TEST(ProfileBuilderTest, StackIdentifiers) {
+  const Stack kStack = MakeStack(0x1000, 0x2000, 0x3000);
+  event::StackTable stack_table;
+  uint32 id = static_cast<uint32>(stack_table.Insert(kStack).key_value());
+
+  ProfileBuilder builder(kWindow);
+  builder.set_stack_table(&stack_table);
+
+  scoped_ptr<StructValue> content(CreateStackContent(10, 4, 8));
+  content->AddField<UIntValue>("StackId", id);
+  builder.Receive(*CreateSample(10, 4, 8, 0x1000).get());
+  builder.Receive(*CreateKernelEvent(11, "StackWalk", "Stack", 4, 8, 0,
+                                     content.Pass()).get());
+
+  // An unknown identifier is ignored.
+  content = CreateStackContent(20, 4, 8);
+  content->AddField<UIntValue>("StackId", id + 1);
+  builder.Receive(*CreateKernelEvent(21, "StackWalk", "Stack", 4, 8, 0,
+                                     content.Pass()).get());
+  builder.Flush();
+
+  EXPECT_EQ(1U, builder.matched_samples());
+  EXPECT_EQ(0U, builder.dropped_stacks());
+  EXPECT_EQ(1U, builder.GetCount(4, kStack));
+}
+
+TEST(ProfileBuilderTest, IgnoreOtherEvents) {
+  ProfileBuilder builder(kWindow);
+  scoped_ptr<StructValue> content(new StructValue());
+  builder.Receive(*CreateKernelEvent(10, "Thread", "CSwitch", 4, 8, 0,
+                                     content.Pass()).get());
+  builder.Flush();
+  EXPECT_EQ(0U, builder.matched_samples());
+  EXPECT_EQ(0U, builder.unmatched_samples());
+}
+
+TEST(ProfileBuilderTest, WriteFolded) {
+  const Stack kStack = MakeStack(0x1000, 0x2000, 0x3000);
+  const Stack kOtherStack = MakeStack(0x1100, 0x2000, 0x3000);
+
+  ProfileBuilder builder(kWindow);
+  builder.AddSample(10, 4, 8, 0x1000);
+  builder.AddStack(10, 4, 8, &kStack[0], kStack.size());
+  builder.AddSample(20, 4, 8, 0x1000);
+  builder.AddStack(20, 4, 8, &kStack[0], kStack.size());
+  builder.AddSample(30, 7, 9, 0x1100);
+  builder.AddStack(30, 7, 9, &kOtherStack[0], kOtherStack.size());
+  builder.Flush();
+
+  std::ostringstream out;
+  EXPECT_TRUE(builder.WriteFolded(&out));
+  EXPECT_EQ("4;0x3000;0x2000;0x1000 2\n"
+            "7;0x3000;0x2000;0x1100 1\n", out.str());
+}
+
+TEST(ProfileBuilderTest, WriteBinary) {
+  const Stack kStack = MakeStack(0x1000, 0x2000, 0x3000);
+
+  ProfileBuilder builder(kWindow);
+  builder.AddSample(10, 4, 8, 0x1000);
+  builder.AddStack(10, 4, 8, &kStack[0], kStack.size());
+  builder.Flush();
+
+  std::ostringstream out;
+  EXPECT_TRUE(builder.WriteBinary(&out));
+  std::string bytes = out.str();
+
+  // Header, process, 4 nodes and a stack.
+  ASSERT_EQ(3 * 4 + 2 * 4 + 4 * 12 + 4 + 12U, bytes.size());
+  const char* ptr = bytes.data();
+  uint32 value = 0;
+  memcpy(&value, ptr, sizeof(value));
+  EXPECT_EQ(ProfileBuilder::kBinaryMagic, value);
+  memcpy(&value, ptr + 4, sizeof(value));
+  EXPECT_EQ(ProfileBuilder::kBinaryVersion, value);
+  memcpy(&value, ptr + 8, sizeof(value));
+  EXPECT_EQ(1U, value);
+  memcpy(&value, ptr + 12, sizeof(value));
+  EXPECT_EQ(4U, value);
+  memcpy(&value, ptr + 16, sizeof(value));
+  EXPECT_EQ(4U, value);
+
+  // The innermost node of the stack has the frame 0x1000.
+  const char* stacks = ptr + 20 + 4 * 12;
+  memcpy(&value, stacks, sizeof(value));
+  EXPECT_EQ(1U, value);
+  uint32 node = 0;
+  memcpy(&node, stacks + 4, sizeof(node));
+  uint64 frame = 0;
+  memcpy(&frame, ptr + 20 + node * 12, sizeof(frame));
+  EXPECT_EQ(0x1000U, frame);
+  uint64 count = 0;
+  memcpy(&count, stacks + 8, sizeof(count));
+  EXPECT_EQ(1U, count);
+}
+
+}  // namespace analysis
@@ -0,0 +1,85 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/report_utils.h"
+
+#include "analysis/histogram.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+namespace {
+
+// The size of the longest hexadecimal representation of a 64-bit value.
+const size_t kMaxHexLength = 2 + 2 * sizeof(uint64);
+
+// Formats a value in hexadecimal at the end of a buffer.
+// @param value the value to format.
+// @param end the end of a buffer of at least kMaxHexLength characters.
+// @returns the beginning of the formatted value.
+char* FormatHex(uint64 value, char* end) {
+  const char kDigits[] = "0123456789abcdef";
+  char* begin = end;
+  do {
+    *--begin = kDigits[value & 0xF];
+    value >>= 4;
+  } while (value != 0);
+  *--begin = 'x';
+  *--begin = '0';
+  return begin;
+}
+
+}  // namespace
+
+void WriteHex(uint64 value, std::ostream* out) {
+  DCHECK(out != NULL);
+
+  char buffer[kMaxHexLength];
+  char* end = buffer + kMaxHexLength;
+  char* begin = FormatHex(value, end);
+  out->write(begin, end - begin);
+}
+
+void AppendHex(uint64 value, std::string* out) {
+  DCHECK(out != NULL);
+
+  char buffer[kMaxHexLength];
+  char* end = buffer + kMaxHexLength;
+  char* begin = FormatHex(value, end);
+  out->append(begin, end);
+}
+
+void WriteHistogramSummary(const Histogram& histogram, std::ostream* out) {
+  DCHECK(out != NULL);
+
+  *out << histogram.count() << ' '
+       << histogram.Mean() << ' '
+       << histogram.Percentile(50.0) << ' '
+       << histogram.Percentile(90.0) << ' '
+       << histogram.Percentile(99.0) << ' '
+       << histogram.max();
+}
+
+}  // namespace analysis
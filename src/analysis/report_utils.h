@@ -0,0 +1,58 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Helpers to write the text reports of the analyses.
+
+#ifndef ANALYSIS_REPORT_UTILS_H_
+#define ANALYSIS_REPORT_UTILS_H_
+
+#include <ostream>
+#include <string>
+
+#include "base/base.h"
+
+namespace analysis {
+
+class Histogram;
+
+// Writes a value as "0x" followed by its lowercase hexadecimal digits.
+// @param value the value to write.
+// @param out the stream to write to.
+void WriteHex(uint64 value, std::ostream* out);
+
+// Appends a value as "0x" followed by its lowercase hexadecimal digits.
+// @param value the value to append.
+// @param out the string to append to.
+void AppendHex(uint64 value, std::string* out);
+
+// Writes the summary of a histogram:
+//   "<count> <mean> <p50> <p90> <p99> <max>"
+// @param histogram the histogram to summarize.
+// @param out the stream to write to.
+void WriteHistogramSummary(const Histogram& histogram, std::ostream* out);
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_REPORT_UTILS_H_
@@ -0,0 +1,61 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/report_utils.h"
+
+#include <sstream>
+
+#include "analysis/histogram.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+TEST(ReportUtilsTest, WriteHex) {
+  std::ostringstream out;
+  WriteHex(0, &out);
+  out << ' ';
+  WriteHex(0x1234abcd, &out);
+  out << ' ';
+  WriteHex(~static_cast<uint64>(0), &out);
+  EXPECT_EQ("0x0 0x1234abcd 0xffffffffffffffff", out.str());
+}
+
+TEST(ReportUtilsTest, AppendHex) {
+  std::string out("frame ");
+  AppendHex(0xfff, &out);
+  EXPECT_EQ("frame 0xfff", out);
+}
+
+TEST(ReportUtilsTest, WriteHistogramSummary) {
+  Histogram histogram;
+  for (uint64 i = 1; i <= 10; ++i)
+    histogram.Add(i);
+
+  std::ostringstream out;
+  WriteHistogramSummary(histogram, &out);
+  EXPECT_EQ("10 5 5 9 10 10", out.str());
+}
+
+}  // namespace analysis
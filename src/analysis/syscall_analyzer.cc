@@ -0,0 +1,143 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/syscall_analyzer.h"
+
+#include "analysis/kernel_event.h"
+#include "analysis/report_utils.h"
+#include "base/logging.h"
+
+namespace analysis {
+
+using event::StructValue;
+using event::Timestamp;
+
+const uint64 SyscallAnalyzer::kDefaultMaxLatency;
+const uint32 SyscallAnalyzer::kUnknownThread;
+
+SyscallAnalyzer::SyscallAnalyzer(Timestamp max_latency)
+    : max_latency_(max_latency),
+      completed_calls_(0),
+      lost_exits_(0),
+      unmatched_exits_(0) {
+}
+
+void SyscallAnalyzer::Receive(const event::Event& event) {
+  KernelEvent kernel_event;
+  if (!kernel_event.Parse(event))
+    return;
+  const StructValue* content = kernel_event.content();
+  uint32 processor = kernel_event.processor_number();
+  uint32 thread_id = static_cast<uint32>(kernel_event.thread_id());
+
+  if (kernel_event.Is("PerfInfo", "SysClEnter")) {
+    uint64 address = 0;
+    if (content->GetFieldAsULong("SysCallAddress", &address))
+      OnEnter(kernel_event.timestamp(), processor, thread_id, address);
+  } else if (kernel_event.Is("PerfInfo", "SysClExit")) {
+    OnExit(kernel_event.timestamp(), processor, thread_id);
+  } else if (kernel_event.Is("Thread", "CSwitch")) {
+    uint32 new_thread_id = 0;
+    if (content->GetFieldAsUInteger("NewThreadId", &new_thread_id))
+      OnContextSwitch(processor, new_thread_id);
+  }
+}
+
+void SyscallAnalyzer::OnContextSwitch(uint32 processor, uint32 thread_id) {
+  if (processor >= running_threads_.size())
+    running_threads_.resize(processor + 1, kUnknownThread);
+  running_threads_[processor] = thread_id;
+}
+
+void SyscallAnalyzer::OnEnter(Timestamp timestamp,
+                              uint32 processor,
+                              uint32 thread_id,
+                              uint64 address) {
+  ThreadState* thread =
+      threads_.FindOrInsert(RunningThread(processor, thread_id));
+
+  // A thread makes one call at a time: the exit of the open call was lost.
+  if (thread->is_open)
+    ++lost_exits_;
+
+  thread->call.timestamp = timestamp;
+  thread->call.address = address;
+  thread->is_open = true;
+}
+
+void SyscallAnalyzer::OnExit(Timestamp timestamp,
+                             uint32 processor,
+                             uint32 thread_id) {
+  ThreadState* thread = threads_.Find(RunningThread(processor, thread_id));
+  if (thread == NULL || !thread->is_open) {
+    ++unmatched_exits_;
+    return;
+  }
+
+  // An exit too late for the open call belongs to a call whose entry was
+  // lost.
+  const OpenCall& call = thread->call;
+  thread->is_open = false;
+  if (timestamp < call.timestamp ||
+      timestamp - call.timestamp > max_latency_) {
+    ++unmatched_exits_;
+    return;
+  }
+
+  ++completed_calls_;
+  latencies_[call.address].Add(timestamp - call.timestamp);
+}
+
+const Histogram* SyscallAnalyzer::GetLatency(uint64 address) const {
+  Latencies::const_iterator it = latencies_.find(address);
+  if (it == latencies_.end())
+    return NULL;
+  return &it->second;
+}
+
+bool SyscallAnalyzer::WriteReport(std::ostream* out) const {
+  DCHECK(out != NULL);
+
+  for (Latencies::const_iterator it = latencies_.begin();
+       it != latencies_.end(); ++it) {
+    WriteHex(it->first, out);
+    out->put(' ');
+    WriteHistogramSummary(it->second, out);
+    out->put('\n');
+  }
+
+  return out->good();
+}
+
+uint32 SyscallAnalyzer::RunningThread(uint32 processor,
+                                      uint32 thread_id) const {
+  if (processor < running_threads_.size() &&
+      running_threads_[processor] != kUnknownThread) {
+    return running_threads_[processor];
+  }
+  return thread_id;
+}
+
+}  // namespace analysis
@@ -0,0 +1,160 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A syscall analyzer pairs the PerfInfo/SysClEnter and PerfInfo/SysClExit
+// events of each thread and aggregates the latency of the calls per syscall
+// address.
+//
+// The syscall events are attributed to the thread running on their processor,
+// as reported by the last Thread/CSwitch event of that processor. A call can
+// block, move to another processor and return there: the open call is kept
+// per thread. A thread has at most one open call. An entry while a call is
+// open replaces it, and the replaced call counts as a lost exit. An exit
+// without an open call, or more than |max_latency| after the entry of the
+// open call, counts as an unmatched exit: once an exit was lost, a later
+// unrelated exit would otherwise report a bogus latency. The memory used by
+// the analyzer is therefore bounded by the number of threads and of syscall
+// addresses.
+//
+// Usage example:
+//   SyscallAnalyzer analyzer;
+//   parser.Parse(base::MakeObserver(&analyzer, &SyscallAnalyzer::Receive));
+//   analyzer.WriteReport(&std::cout);
+
+#ifndef ANALYSIS_SYSCALL_ANALYZER_H_
+#define ANALYSIS_SYSCALL_ANALYZER_H_
+
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "analysis/histogram.h"
+#include "analysis/id_map.h"
+#include "base/base.h"
+#include "event/event.h"
+
+namespace analysis {
+
+class SyscallAnalyzer {
+ public:
+  // The default bound of the latency of a call, in timestamp units: 10 seconds
+  // in 100 ns units.
+  static const uint64 kDefaultMaxLatency = 100000000ULL;
+
+  // Marks an unknown thread.
+  static const uint32 kUnknownThread = 0xFFFFFFFF;
+
+  // The latency histograms, keyed by syscall address.
+  typedef std::map<uint64, Histogram> Latencies;
+
+  // @param max_latency the latency, in timestamp units, beyond which an exit
+  //     isn't paired with the open call of its thread.
+  explicit SyscallAnalyzer(event::Timestamp max_latency = kDefaultMaxLatency);
+
+  // Consumes an event of the ETW parser. Events other than the syscalls and
+  // the context switches are ignored.
+  // @param event the event to consume.
+  void Receive(const event::Event& event);
+
+  // Records that a thread starts running on a processor.
+  // @param processor the processor.
+  // @param thread_id the thread switched in.
+  void OnContextSwitch(uint32 processor, uint32 thread_id);
+
+  // Records the entry of a syscall.
+  // @param timestamp the time of the entry.
+  // @param processor the processor executing the call.
+  // @param thread_id the thread reported by the event, used when no context
+  //     switch was seen on |processor|.
+  // @param address the address of the syscall.
+  void OnEnter(event::Timestamp timestamp,
+               uint32 processor,
+               uint32 thread_id,
+               uint64 address);
+
+  // Records the exit of a syscall.
+  // @param timestamp the time of the exit.
+  // @param processor the processor executing the call.
+  // @param thread_id the thread reported by the event, used when no context
+  //     switch was seen on |processor|.
+  void OnExit(event::Timestamp timestamp, uint32 processor, uint32 thread_id);
+
+  // @param address the address of a syscall.
+  // @returns the latencies of the calls to |address|, or NULL if none
+  //     completed.
+  const Histogram* GetLatency(uint64 address) const;
+
+  // @returns the latencies of the completed calls, per syscall address.
+  const Latencies& latencies() const { return latencies_; }
+
+  // Writes a line per syscall address:
+  //   "<address> <count> <mean> <p50> <p90> <p99> <max>"
+  // with the latencies in timestamp units.
+  // @param out the stream to write to.
+  // @returns true on success, false if the stream failed.
+  bool WriteReport(std::ostream* out) const;
+
+  // Statistics.
+  // @{
+  uint64 completed_calls() const { return completed_calls_; }
+  uint64 lost_exits() const { return lost_exits_; }
+  uint64 unmatched_exits() const { return unmatched_exits_; }
+  // @}
+
+ private:
+  struct OpenCall {
+    event::Timestamp timestamp;
+    uint64 address;
+  };
+
+  // The open call of a thread.
+  struct ThreadState {
+    ThreadState() : is_open(false) {}
+    OpenCall call;
+    bool is_open;
+  };
+
+  // @returns the thread running on |processor|, or |thread_id| if unknown.
+  uint32 RunningThread(uint32 processor, uint32 thread_id) const;
+
+  // The thread running on each processor, or kUnknownThread.
+  std::vector<uint32> running_threads_;
+
+  IdMap<ThreadState> threads_;
+
+  Latencies latencies_;
+
+  event::Timestamp max_latency_;
+
+  uint64 completed_calls_;
+  uint64 lost_exits_;
+  uint64 unmatched_exits_;
+
+  DISALLOW_COPY_AND_ASSIGN(SyscallAnalyzer);
+};
+
+}  // namespace analysis
+
+#endif  // ANALYSIS_SYSCALL_ANALYZER_H_
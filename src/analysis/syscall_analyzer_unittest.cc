@@ -0,0 +1,188 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "analysis/syscall_analyzer.h"
+
+#include <sstream>
+
+#include "analysis/kernel_event.h"
+#include "gtest/gtest.h"
+
+namespace analysis {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+
+const uint64 kNtReadFile = 0xFFFFF80001000000ULL;
+const uint64 kNtWaitForSingleObject = 0xFFFFF80002000000ULL;
+
+void SendEnter(SyscallAnalyzer* analyzer,
+               event::Timestamp timestamp,
+               uint32 processor,
+               uint64 address) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<ULongValue>("SysCallAddress", address);
+  analyzer->Receive(*CreateKernelEvent(timestamp, "PerfInfo", "SysClEnter",
+                                       0, 0, processor, content.Pass()).get());
+}
+
+void SendExit(SyscallAnalyzer* analyzer,
+              event::Timestamp timestamp,
+              uint32 processor) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("SysCallNtStatus", 0);
+  analyzer->Receive(*CreateKernelEvent(timestamp, "PerfInfo", "SysClExit",
+                                       0, 0, processor, content.Pass()).get());
+}
+
+void SendContextSwitch(SyscallAnalyzer* analyzer,
+                       event::Timestamp timestamp,
+                       uint32 processor,
+                       uint32 new_thread_id) {
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("NewThreadId", new_thread_id);
+  content->AddField<UIntValue>("OldThreadId", 0);
+  analyzer->Receive(*CreateKernelEvent(timestamp, "Thread", "CSwitch",
+                                       0, 0, processor, content.Pass()).get());
+}
+
+}  // namespace
+
+TEST(SyscallAnalyzerTest, PairCalls) {
+  SyscallAnalyzer analyzer;
+  SendContextSwitch(&analyzer, 0, 0, 100);
+  SendEnter(&analyzer, 10, 0, kNtReadFile);
+  SendExit(&analyzer, 15, 0);
+  SendEnter(&analyzer, 20, 0, kNtReadFile);
+  SendExit(&analyzer, 27, 0);
+
+  EXPECT_EQ(2U, analyzer.completed_calls());
+  const Histogram* latency = analyzer.GetLatency(kNtReadFile);
+  ASSERT_TRUE(latency != NULL);
+  EXPECT_EQ(2U, latency->count());
+  EXPECT_EQ(5U, latency->min());
+  EXPECT_EQ(7U, latency->max());
+  EXPECT_EQ(NULL, analyzer.GetLatency(kNtWaitForSingleObject));
+}
+
+TEST(SyscallAnalyzerTest, BlockingCallMovesToAnotherProcessor) {
+  SyscallAnalyzer analyzer;
+  SendContextSwitch(&analyzer, 0, 0, 100);
+  SendContextSwitch(&analyzer, 0, 1, 200);
+
+  // Thread 100 blocks in a wait, thread 200 runs a call on processor 0, then
+  // thread 100 resumes on processor 1.
+  SendEnter(&analyzer, 10, 0, kNtWaitForSingleObject);
+  SendContextSwitch(&analyzer, 11, 0, 200);
+  SendContextSwitch(&analyzer, 11, 1, 300);
+  SendEnter(&analyzer, 12, 0, kNtReadFile);
+  SendExit(&analyzer, 14, 0);
+  SendContextSwitch(&analyzer, 50, 1, 100);
+  SendExit(&analyzer, 60, 1);
+
+  EXPECT_EQ(2U, analyzer.completed_calls());
+  EXPECT_EQ(0U, analyzer.unmatched_exits());
+  ASSERT_TRUE(analyzer.GetLatency(kNtReadFile) != NULL);
+  EXPECT_EQ(2U, analyzer.GetLatency(kNtReadFile)->max());
+  ASSERT_TRUE(analyzer.GetLatency(kNtWaitForSingleObject) != NULL);
+  EXPECT_EQ(50U, analyzer.GetLatency(kNtWaitForSingleObject)->max());
+}
+
+TEST(SyscallAnalyzerTest, UnknownProcessorUsesEventThread) {
+  SyscallAnalyzer analyzer;
+  analyzer.OnEnter(10, 3, 100, kNtReadFile);
+  analyzer.OnEnter(11, 3, 200, kNtReadFile);
+  analyzer.OnExit(13, 3, 200);
+  analyzer.OnExit(20, 3, 100);
+
+  const Histogram* latency = analyzer.GetLatency(kNtReadFile);
+  ASSERT_TRUE(latency != NULL);
+  EXPECT_EQ(2U, latency->min());
+  EXPECT_EQ(10U, latency->max());
+}
+
+TEST(SyscallAnalyzerTest, EntryReplacesOpenCall) {
+  SyscallAnalyzer analyzer;
+  analyzer.OnEnter(10, 0, 100, kNtReadFile);
+  analyzer.OnEnter(12, 0, 100, kNtWaitForSingleObject);
+  analyzer.OnExit(15, 0, 100);
+  analyzer.OnExit(20, 0, 100);
+
+  // The exit of the first call was lost, the last exit has no open call.
+  EXPECT_EQ(1U, analyzer.completed_calls());
+  EXPECT_EQ(1U, analyzer.lost_exits());
+  EXPECT_EQ(1U, analyzer.unmatched_exits());
+  EXPECT_EQ(NULL, analyzer.GetLatency(kNtReadFile));
+  EXPECT_EQ(3U, analyzer.GetLatency(kNtWaitForSingleObject)->max());
+}
+
+TEST(SyscallAnalyzerTest, LostAndUnmatchedExits) {
+  SyscallAnalyzer analyzer;
+  analyzer.OnExit(5, 0, 100);
+  EXPECT_EQ(1U, analyzer.unmatched_exits());
+
+  // The exits of all these calls but the last are lost: the thread state
+  // stays bounded.
+  for (size_t i = 0; i < 1000; ++i)
+    analyzer.OnEnter(10 + i, 0, 100, kNtReadFile);
+  EXPECT_EQ(999U, analyzer.lost_exits());
+
+  analyzer.OnExit(2000, 0, 100);
+  EXPECT_EQ(1U, analyzer.completed_calls());
+  EXPECT_EQ(991U, analyzer.GetLatency(kNtReadFile)->max());
+}
+
+TEST(SyscallAnalyzerTest, LateExitIsUnmatched) {
+  SyscallAnalyzer analyzer(100);
+  analyzer.OnEnter(10, 0, 100, kNtReadFile);
+  analyzer.OnExit(500, 0, 100);
+  EXPECT_EQ(0U, analyzer.completed_calls());
+  EXPECT_EQ(1U, analyzer.unmatched_exits());
+  EXPECT_EQ(NULL, analyzer.GetLatency(kNtReadFile));
+
+  // The late exit closed the call.
+  analyzer.OnExit(510, 0, 100);
+  EXPECT_EQ(2U, analyzer.unmatched_exits());
+
+  analyzer.OnEnter(600, 0, 100, kNtReadFile);
+  analyzer.OnExit(700, 0, 100);
+  EXPECT_EQ(1U, analyzer.completed_calls());
+  EXPECT_EQ(100U, analyzer.GetLatency(kNtReadFile)->max());
+}
+
+TEST(SyscallAnalyzerTest, WriteReport) {
+  SyscallAnalyzer analyzer;
+  analyzer.OnEnter(10, 0, 100, 0x1000);
+  analyzer.OnExit(15, 0, 100);
+
+  std::ostringstream out;
+  EXPECT_TRUE(analyzer.WriteReport(&out));
+  EXPECT_EQ("0x1000 1 5 5 5 5 5\n", out.str());
+}
+
+}  // namespace analysis
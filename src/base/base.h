@@ -58,4 +58,14 @@ typedef unsigned long long uint64;
 #define OVERRIDE
 #endif
 
+// Compile-time assertion. The message must be a valid identifier.
+// Sample use:
+//     COMPILE_ASSERT(sizeof(Header) == 16, header_must_be_16_bytes);
+template <bool>
+struct CompileAssert {
+};
+
+#define COMPILE_ASSERT(expr, msg) \
+    typedef CompileAssert<(bool(expr))> msg[bool(expr) ? 1 : -1]
+
 #endif  // BASE_BASE_H_
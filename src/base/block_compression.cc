@@ -0,0 +1,318 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "base/block_compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// The shortest match.
+const size_t kMinMatch = 4;
+
+// The last bytes of a block are literals, and no match starts in the last
+// kMatchFindLimit bytes.
+const size_t kLastLiterals = 5;
+const size_t kMatchFindLimit = 12;
+
+// The farthest match.
+const size_t kMaxOffset = 65535;
+
+// The lengths of the token, extended by bytes of 255 when they are at their
+// maximum.
+const size_t kMaxTokenLength = 15;
+
+// The literal runs copied with a fixed-size copy, when the buffers allow it.
+const size_t kShortCopy = 16;
+
+// The number of bits of the hash of a 4-byte sequence.
+const int kHashBits = 14;
+const size_t kHashTableSize = 1 << kHashBits;
+
+// The number of unsuccessful match searches after which the search steps
+// over more bytes: incompressible data is skipped quickly.
+const size_t kSkipTrigger = 6;
+
+uint32 Read32(const uint8* data) {
+  uint32 value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint64 Read64(const uint8* data) {
+  uint64 value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32 Hash(uint32 sequence) {
+  return (sequence * 2654435761U) >> (32 - kHashBits);
+}
+
+// @param diff the exclusive or of two little-endian words. Must not be zero.
+// @returns the number of equal bytes at the beginning of the words.
+size_t CountEqualBytes(uint64 diff) {
+  DCHECK_NE(0U, diff);
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, diff);
+  return index / 8;
+#elif defined(_MSC_VER)
+  size_t count = 0;
+  while ((diff & 0xFF) == 0) {
+    diff >>= 8;
+    ++count;
+  }
+  return count;
+#else
+  return static_cast<size_t>(__builtin_ctzll(diff)) / 8;
+#endif
+}
+
+// Writes the part of a length that doesn't fit in the token.
+// @returns the end of the written bytes.
+uint8* WriteLength(size_t length, uint8* output) {
+  DCHECK_GE(length, kMaxTokenLength);
+  length -= kMaxTokenLength;
+  for (; length >= 255; length -= 255)
+    *output++ = 255;
+  *output++ = static_cast<uint8>(length);
+  return output;
+}
+
+// Reads the part of a length that doesn't fit in the token.
+// @returns false if the input ends before the length.
+bool ReadLength(const uint8** input, const uint8* end, size_t* length) {
+  uint8 byte = 0;
+  do {
+    if (*input == end)
+      return false;
+    byte = *(*input)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+// Writes the literals of a command, and its token.
+// @returns the end of the written bytes.
+uint8* WriteLiterals(const uint8* literals,
+                     size_t length,
+                     uint8* token,
+                     uint8* output) {
+  if (length >= kMaxTokenLength) {
+    *token = static_cast<uint8>(kMaxTokenLength << 4);
+    output = WriteLength(length, output);
+  } else {
+    *token = static_cast<uint8>(length << 4);
+  }
+  memcpy(output, literals, length);
+  return output + length;
+}
+
+}  // namespace
+
+size_t MaxCompressedBlockSize(size_t size) {
+  return size + size / 255 + 16;
+}
+
+BlockCompressor::BlockCompressor() : table_(kHashTableSize, 0) {
+}
+
+size_t BlockCompressor::Compress(const char* input, size_t size,
+                                 char* output) {
+  DCHECK(input != NULL || size == 0);
+  DCHECK(output != NULL);
+
+  const uint8* begin = reinterpret_cast<const uint8*>(input);
+  const uint8* end = begin + size;
+  const uint8* anchor = begin;
+  uint8* op = reinterpret_cast<uint8*>(output);
+
+  if (size > kMatchFindLimit) {
+    const uint8* match_find_limit = end - kMatchFindLimit;
+    const uint8* match_limit = end - kLastLiterals;
+    std::fill(table_.begin(), table_.end(), 0);
+
+    const uint8* ip = begin + 1;
+    while (ip <= match_find_limit) {
+      // Find a match, stepping faster as the searches fail.
+      const uint8* match = NULL;
+      size_t attempts = 1 << kSkipTrigger;
+      while (ip <= match_find_limit) {
+        uint32 sequence = Read32(ip);
+        uint32 hash = Hash(sequence);
+        const uint8* candidate = begin + table_[hash];
+        table_[hash] = static_cast<uint32>(ip - begin);
+        if (static_cast<size_t>(ip - candidate) <= kMaxOffset &&
+            Read32(candidate) == sequence) {
+          match = candidate;
+          break;
+        }
+        ip += attempts++ >> kSkipTrigger;
+      }
+      if (match == NULL)
+        break;
+
+      // Extend the match backward over the pending literals.
+      while (ip > anchor && match > begin && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+
+      uint8* token = op++;
+      op = WriteLiterals(anchor, static_cast<size_t>(ip - anchor), token, op);
+      size_t offset = static_cast<size_t>(ip - match);
+      *op++ = static_cast<uint8>(offset);
+      *op++ = static_cast<uint8>(offset >> 8);
+
+      // Extend the match forward, 8 bytes at a time.
+      ip += kMinMatch;
+      match += kMinMatch;
+      const uint8* match_start = ip;
+      while (ip < match_limit) {
+        if (match_limit - ip >= 8) {
+          uint64 diff = Read64(ip) ^ Read64(match);
+          if (diff == 0) {
+            ip += 8;
+            match += 8;
+            continue;
+          }
+          ip += CountEqualBytes(diff);
+          break;
+        }
+        if (*ip != *match)
+          break;
+        ++ip;
+        ++match;
+      }
+
+      size_t match_length = static_cast<size_t>(ip - match_start);
+      if (match_length >= kMaxTokenLength) {
+        *token |= static_cast<uint8>(kMaxTokenLength);
+        op = WriteLength(match_length, op);
+      } else {
+        *token |= static_cast<uint8>(match_length);
+      }
+      anchor = ip;
+
+      // Index a position inside the match: the next data often repeats it.
+      if (ip <= match_find_limit) {
+        table_[Hash(Read32(ip - 2))] =
+            static_cast<uint32>(ip - 2 - begin);
+      }
+    }
+  }
+
+  // The last literals.
+  uint8* token = op++;
+  op = WriteLiterals(anchor, static_cast<size_t>(end - anchor), token, op);
+
+  size_t compressed_size = static_cast<size_t>(
+      op - reinterpret_cast<uint8*>(output));
+  DCHECK_LE(compressed_size, MaxCompressedBlockSize(size));
+  return compressed_size;
+}
+
+bool DecompressBlock(const char* input,
+                     size_t size,
+                     char* output,
+                     size_t output_size) {
+  DCHECK(input != NULL || size == 0);
+  DCHECK(output != NULL || output_size == 0);
+
+  const uint8* ip = reinterpret_cast<const uint8*>(input);
+  const uint8* input_end = ip + size;
+  uint8* op = reinterpret_cast<uint8*>(output);
+  uint8* const output_begin = op;
+  uint8* const output_end = op + output_size;
+
+  for (;;) {
+    if (ip == input_end)
+      return false;
+    size_t token = *ip++;
+
+    // The literals.
+    size_t length = token >> 4;
+    if (length == kMaxTokenLength && !ReadLength(&ip, input_end, &length))
+      return false;
+    if (length <= kShortCopy &&
+        static_cast<size_t>(input_end - ip) >= kShortCopy &&
+        static_cast<size_t>(output_end - op) >= kShortCopy) {
+      // Most literal runs are short: a fixed-size copy is faster, and the
+      // extra bytes are overwritten by the next command.
+      memcpy(op, ip, kShortCopy);
+    } else if (length > static_cast<size_t>(input_end - ip) ||
+               length > static_cast<size_t>(output_end - op)) {
+      return false;
+    } else {
+      memcpy(op, ip, length);
+    }
+    ip += length;
+    op += length;
+
+    // The last command has no match.
+    if (ip == input_end)
+      return op == output_end;
+
+    // The match.
+    if (input_end - ip < 2)
+      return false;
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - output_begin))
+      return false;
+
+    length = token & kMaxTokenLength;
+    if (length == kMaxTokenLength && !ReadLength(&ip, input_end, &length))
+      return false;
+    length += kMinMatch;
+    size_t available = static_cast<size_t>(output_end - op);
+    if (length > available)
+      return false;
+
+    const uint8* match = op - offset;
+    if (offset >= 8 && available - length >= 8) {
+      // The chunks never overlap the bytes they write. The last chunk may
+      // write past the match, within the output.
+      for (size_t i = 0; i < length; i += 8)
+        memcpy(op + i, match + i, 8);
+    } else {
+      // A short offset repeats a pattern: copy byte per byte.
+      for (size_t i = 0; i < length; ++i)
+        op[i] = match[i];
+    }
+    op += length;
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,210 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "base/block_compression.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Compresses and decompresses |input|.
+// @param compressed_size receives the size of the compressed block.
+// @returns true if the decompressed bytes are equal to |input|.
+bool RoundTrip(const std::string& input, size_t* compressed_size) {
+  BlockCompressor compressor;
+  std::vector<char> compressed(MaxCompressedBlockSize(input.size()));
+  *compressed_size = compressor.Compress(input.data(), input.size(),
+                                         &compressed[0]);
+  if (*compressed_size > compressed.size())
+    return false;
+
+  std::vector<char> output(input.size() + 1);
+  if (!DecompressBlock(&compressed[0], *compressed_size, &output[0],
+                       input.size())) {
+    return false;
+  }
+  return std::string(&output[0], input.size()) == input;
+}
+
+// @returns |size| pseudo-random bytes.
+std::string RandomBytes(size_t size, uint32 seed) {
+  std::string bytes(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    bytes[i] = static_cast<char>(seed >> 24);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST(BlockCompressionTest, Empty) {
+  size_t compressed_size = 0;
+  EXPECT_TRUE(RoundTrip("", &compressed_size));
+  EXPECT_EQ(1U, compressed_size);
+}
+
+TEST(BlockCompressionTest, ShortInputs) {
+  // The inputs too short for a match are stored as literals.
+  std::string input;
+  for (size_t size = 0; size < 32; ++size) {
+    size_t compressed_size = 0;
+    EXPECT_TRUE(RoundTrip(input, &compressed_size)) << size;
+    input.push_back('a');
+  }
+}
+
+TEST(BlockCompressionTest, Repetitive) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i)
+    input += "FileIo/Read C:\\Windows\\System32\\kernel32.dll ";
+
+  size_t compressed_size = 0;
+  EXPECT_TRUE(RoundTrip(input, &compressed_size));
+  EXPECT_LT(compressed_size, input.size() / 20);
+}
+
+TEST(BlockCompressionTest, RunOfOneByte) {
+  // A match overlapping its own output, at offset 1.
+  std::string input(100000, 'x');
+  size_t compressed_size = 0;
+  EXPECT_TRUE(RoundTrip(input, &compressed_size));
+  EXPECT_LT(compressed_size, 1000U);
+}
+
+TEST(BlockCompressionTest, ShortPeriods) {
+  // The offsets shorter than 8 bytes are copied byte per byte.
+  for (size_t period = 1; period <= 9; ++period) {
+    std::string pattern = RandomBytes(period, static_cast<uint32>(period));
+    std::string input;
+    for (int i = 0; i < 300; ++i)
+      input += pattern;
+    input += "end";
+    size_t compressed_size = 0;
+    EXPECT_TRUE(RoundTrip(input, &compressed_size)) << period;
+    EXPECT_LT(compressed_size, input.size() / 4) << period;
+  }
+}
+
+TEST(BlockCompressionTest, Incompressible) {
+  std::string input = RandomBytes(100000, 42);
+  size_t compressed_size = 0;
+  EXPECT_TRUE(RoundTrip(input, &compressed_size));
+  EXPECT_LE(compressed_size, MaxCompressedBlockSize(input.size()));
+}
+
+TEST(BlockCompressionTest, LongLiteralsAndMatches) {
+  // Lengths extended by many bytes of 255, and matches far away.
+  std::string head = RandomBytes(40000, 1);
+  std::string input = head + RandomBytes(1000, 2) + head + head.substr(0, 17);
+  size_t compressed_size = 0;
+  EXPECT_TRUE(RoundTrip(input, &compressed_size));
+  EXPECT_LT(compressed_size, 45000U);
+}
+
+TEST(BlockCompressionTest, MixedContent) {
+  std::string input;
+  for (uint32 i = 0; i < 2000; ++i) {
+    input += RandomBytes(i % 23, i);
+    input += "ProcessId=1234 ThreadId=";
+    input.push_back(static_cast<char>('0' + i % 10));
+  }
+  size_t compressed_size = 0;
+  EXPECT_TRUE(RoundTrip(input, &compressed_size));
+  EXPECT_LT(compressed_size, input.size());
+}
+
+TEST(BlockCompressionTest, CompressorIsReusable) {
+  BlockCompressor compressor;
+  std::string first(5000, 'a');
+  std::string second = RandomBytes(5000, 7) + std::string(5000, 'b');
+  std::vector<char> compressed(MaxCompressedBlockSize(second.size()));
+  std::vector<char> output(second.size());
+
+  size_t size = compressor.Compress(first.data(), first.size(),
+                                    &compressed[0]);
+  ASSERT_TRUE(DecompressBlock(&compressed[0], size, &output[0],
+                              first.size()));
+  EXPECT_EQ(first, std::string(&output[0], first.size()));
+
+  // No match refers to the previous block.
+  size = compressor.Compress(second.data(), second.size(), &compressed[0]);
+  ASSERT_TRUE(DecompressBlock(&compressed[0], size, &output[0],
+                              second.size()));
+  EXPECT_EQ(second, std::string(&output[0], second.size()));
+}
+
+TEST(BlockCompressionTest, WrongOutputSize) {
+  std::string input(1000, 'z');
+  BlockCompressor compressor;
+  std::vector<char> compressed(MaxCompressedBlockSize(input.size()));
+  size_t size = compressor.Compress(input.data(), input.size(),
+                                    &compressed[0]);
+
+  std::vector<char> output(2000);
+  EXPECT_FALSE(DecompressBlock(&compressed[0], size, &output[0], 999));
+  EXPECT_FALSE(DecompressBlock(&compressed[0], size, &output[0], 1001));
+  EXPECT_TRUE(DecompressBlock(&compressed[0], size, &output[0], 1000));
+}
+
+TEST(BlockCompressionTest, Corrupted) {
+  std::string input;
+  for (uint32 i = 0; i < 200; ++i)
+    input += RandomBytes(7, i % 5) + "abcdefgh";
+  BlockCompressor compressor;
+  std::vector<char> compressed(MaxCompressedBlockSize(input.size()));
+  size_t size = compressor.Compress(input.data(), input.size(),
+                                    &compressed[0]);
+  std::vector<char> output(input.size());
+
+  // Every truncation fails.
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_FALSE(DecompressBlock(&compressed[0], i, &output[0],
+                                 input.size())) << i;
+  }
+
+  // Flipped bytes fail or produce wrong bytes, always within the buffers.
+  for (size_t i = 0; i < size; ++i) {
+    std::vector<char> corrupted(compressed.begin(),
+                                compressed.begin() + size);
+    corrupted[i] ^= 0x5A;
+    DecompressBlock(&corrupted[0], size, &output[0], output.size());
+  }
+
+  // An offset before the beginning of the output.
+  const char kBadOffset[] = { 0x10, 'a', 0x05, 0x00, 0x00 };
+  EXPECT_FALSE(DecompressBlock(kBadOffset, sizeof(kBadOffset), &output[0],
+                               5));
+  // A zero offset.
+  const char kZeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+  EXPECT_FALSE(DecompressBlock(kZeroOffset, sizeof(kZeroOffset), &output[0],
+                               5));
+}
+
+}  // namespace base
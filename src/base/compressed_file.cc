@@ -0,0 +1,550 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "base/compressed_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "base/logging.h"
+#include "base/thread.h"
+
+namespace base {
+
+namespace {
+
+// Decompresses a block, or copies it if it is stored raw.
+// @returns true on success, false if the block is corrupted.
+bool DecompressOrCopyBlock(const char* input,
+                           const CompressedBlockHeader& header,
+                           char* output) {
+  if (header.compressed_size == header.raw_size) {
+    memcpy(output, input, header.raw_size);
+    return true;
+  }
+  return DecompressBlock(input, header.compressed_size, output,
+                         header.raw_size);
+}
+
+}  // namespace
+
+// Threads decompressing the blocks of the reads of a CompressedFileReader.
+// The threads wait for a read between two of them. The thread making a read
+// decompresses blocks too, so the reads progress even if no thread could be
+// started.
+class DecompressPool : public Thread::Delegate {
+ public:
+  // Starts the threads.
+  // @param thread_count the number of threads, including the reading one.
+  explicit DecompressPool(size_t thread_count);
+
+  // Stops the threads.
+  virtual ~DecompressPool();
+
+  // Decompresses blocks on all the threads. One read runs at a time.
+  // @param inputs the compressed bytes of the blocks.
+  // @param headers the headers of the blocks.
+  // @param outputs the buffers receiving the raw blocks.
+  // @returns true on success, false if a block is corrupted.
+  bool Decompress(const std::vector<const char*>& inputs,
+                  const std::vector<CompressedBlockHeader>& headers,
+                  const std::vector<char*>& outputs);
+
+  // Thread::Delegate implementation.
+  virtual void Run() OVERRIDE;
+
+ private:
+  // Decompresses the blocks of the current read until none is left to
+  // start. |lock_| must be held; it is released while decompressing.
+  void DecompressBlocks();
+
+  // Serializes the reads.
+  Lock read_lock_;
+
+  // Protects the state of the current read.
+  Lock lock_;
+  ConditionVariable blocks_available_;
+  ConditionVariable blocks_done_;
+
+  // The current read.
+  const std::vector<const char*>* inputs_;
+  const std::vector<CompressedBlockHeader>* headers_;
+  const std::vector<char*>* outputs_;
+  size_t next_block_;
+  size_t block_count_;
+  size_t pending_block_count_;
+  bool success_;
+
+  bool stopping_;
+  std::vector<Thread*> threads_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecompressPool);
+};
+
+DecompressPool::DecompressPool(size_t thread_count)
+    : blocks_available_(&lock_),
+      blocks_done_(&lock_),
+      inputs_(NULL),
+      headers_(NULL),
+      outputs_(NULL),
+      next_block_(0),
+      block_count_(0),
+      pending_block_count_(0),
+      success_(true),
+      stopping_(false) {
+  for (size_t i = 1; i < thread_count; ++i) {
+    Thread* thread = new Thread(this);
+    if (!thread->Start()) {
+      delete thread;
+      break;
+    }
+    threads_.push_back(thread);
+  }
+}
+
+DecompressPool::~DecompressPool() {
+  {
+    AutoLock auto_lock(lock_);
+    stopping_ = true;
+    blocks_available_.Broadcast();
+  }
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    threads_[i]->Join();
+    delete threads_[i];
+  }
+}
+
+bool DecompressPool::Decompress(
+    const std::vector<const char*>& inputs,
+    const std::vector<CompressedBlockHeader>& headers,
+    const std::vector<char*>& outputs) {
+  DCHECK_EQ(inputs.size(), headers.size());
+  DCHECK_EQ(inputs.size(), outputs.size());
+
+  AutoLock read_lock(read_lock_);
+  AutoLock auto_lock(lock_);
+  inputs_ = &inputs;
+  headers_ = &headers;
+  outputs_ = &outputs;
+  next_block_ = 0;
+  block_count_ = inputs.size();
+  pending_block_count_ = inputs.size();
+  success_ = true;
+  blocks_available_.Broadcast();
+
+  DecompressBlocks();
+  while (pending_block_count_ != 0)
+    blocks_done_.Wait();
+
+  inputs_ = NULL;
+  headers_ = NULL;
+  outputs_ = NULL;
+  return success_;
+}
+
+void DecompressPool::Run() {
+  AutoLock auto_lock(lock_);
+  for (;;) {
+    while (!stopping_ && next_block_ == block_count_)
+      blocks_available_.Wait();
+    if (stopping_)
+      return;
+    DecompressBlocks();
+  }
+}
+
+void DecompressPool::DecompressBlocks() {
+  while (next_block_ < block_count_) {
+    size_t block = next_block_++;
+
+    // Once a block failed, the others are only counted.
+    bool success = success_;
+    lock_.Release();
+    if (success) {
+      success = DecompressOrCopyBlock((*inputs_)[block], (*headers_)[block],
+                                      (*outputs_)[block]);
+    }
+    lock_.Acquire();
+
+    success_ = success_ && success;
+    if (--pending_block_count_ == 0)
+      blocks_done_.Signal();
+  }
+}
+
+bool IsCompressedFile(const char* data, size_t size) {
+  DCHECK(data != NULL || size == 0);
+  if (size < sizeof(uint32))
+    return false;
+  uint32 magic = 0;
+  memcpy(&magic, data, sizeof(magic));
+  return magic == kCompressedFileMagic;
+}
+
+CompressingStreamBuffer::CompressingStreamBuffer(std::ostream* out,
+                                                 size_t block_size)
+    : out_(out),
+      buffer_(std::max(static_cast<size_t>(1), block_size)),
+      compressed_(MaxCompressedBlockSize(buffer_.size())),
+      flushed_length_(0),
+      compressed_length_(0),
+      finished_(false) {
+  DCHECK(out != NULL);
+  DCHECK_GT(block_size, 0U);
+  DCHECK_LE(compressed_.size(), static_cast<size_t>(
+      std::numeric_limits<uint32>::max()));
+
+  setp(&buffer_[0], &buffer_[0] + buffer_.size());
+
+  CompressedFileHeader header = {};
+  header.magic = kCompressedFileMagic;
+  header.version = kCompressedFileVersion;
+  header.block_size = static_cast<uint32>(buffer_.size());
+  Write(&header, sizeof(header));
+}
+
+CompressingStreamBuffer::~CompressingStreamBuffer() {
+  if (!finished_)
+    Finish();
+}
+
+bool CompressingStreamBuffer::Finish() {
+  if (finished_)
+    return out_->good();
+
+  FlushBlock();
+  finished_ = true;
+  setp(NULL, NULL);
+
+  CompressedBlockHeader end = {};
+  Write(&end, sizeof(end));
+
+  CompressedFileTrailer trailer = {};
+  trailer.index_offset = compressed_length_;
+  trailer.block_count = index_.size();
+  trailer.raw_length = flushed_length_;
+  trailer.magic = kCompressedFileMagic;
+  if (!index_.empty())
+    Write(&index_[0], index_.size() * sizeof(index_[0]));
+  Write(&trailer, sizeof(trailer));
+
+  out_->flush();
+  return out_->good();
+}
+
+uint64 CompressingStreamBuffer::raw_length() const {
+  return flushed_length_ + static_cast<uint64>(pptr() - pbase());
+}
+
+CompressingStreamBuffer::int_type CompressingStreamBuffer::overflow(
+    int_type c) {
+  if (finished_ || !FlushBlock())
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+int CompressingStreamBuffer::sync() {
+  if (!finished_)
+    FlushBlock();
+  out_->flush();
+  return out_->good() ? 0 : -1;
+}
+
+CompressingStreamBuffer::pos_type CompressingStreamBuffer::seekoff(
+    off_type off,
+    std::ios_base::seekdir dir,
+    std::ios_base::openmode which) {
+  if (off != 0 || dir != std::ios_base::cur ||
+      (which & std::ios_base::out) == 0) {
+    return pos_type(off_type(-1));
+  }
+  return pos_type(static_cast<off_type>(raw_length()));
+}
+
+bool CompressingStreamBuffer::FlushBlock() {
+  size_t size = static_cast<size_t>(pptr() - pbase());
+  if (size == 0)
+    return out_->good();
+
+  CompressedBlockIndexEntry entry = {};
+  entry.offset = compressed_length_;
+  entry.raw_offset = flushed_length_;
+  index_.push_back(entry);
+
+  size_t compressed_size = compressor_.Compress(pbase(), size,
+                                                &compressed_[0]);
+  CompressedBlockHeader header = {};
+  header.raw_size = static_cast<uint32>(size);
+  if (compressed_size < size) {
+    header.compressed_size = static_cast<uint32>(compressed_size);
+    Write(&header, sizeof(header));
+    Write(&compressed_[0], compressed_size);
+  } else {
+    // The block doesn't shrink: store it raw.
+    header.compressed_size = header.raw_size;
+    Write(&header, sizeof(header));
+    Write(pbase(), size);
+  }
+
+  flushed_length_ += size;
+  setp(&buffer_[0], &buffer_[0] + buffer_.size());
+  return out_->good();
+}
+
+void CompressingStreamBuffer::Write(const void* data, size_t size) {
+  out_->write(static_cast<const char*>(data),
+              static_cast<std::streamsize>(size));
+  compressed_length_ += size;
+}
+
+CompressedFileReader::CompressedFileReader()
+    : block_size_(0),
+      length_(0),
+      truncated_(false),
+      thread_count_(Thread::NumberOfProcessors()) {
+  if (thread_count_ == 0)
+    thread_count_ = 1;
+}
+
+CompressedFileReader::~CompressedFileReader() {
+}
+
+bool CompressedFileReader::Open(const std::string& path) {
+  blocks_.clear();
+  block_size_ = 0;
+  length_ = 0;
+  truncated_ = false;
+
+  if (!file_.Open(path))
+    return false;
+  if (file_.length() < sizeof(CompressedFileHeader) ||
+      !IsCompressedFile(file_.data(), file_.length())) {
+    file_.Close();
+    return false;
+  }
+
+  CompressedFileHeader header;
+  memcpy(&header, file_.data(), sizeof(header));
+  if (header.version != kCompressedFileVersion || header.block_size == 0) {
+    file_.Close();
+    return false;
+  }
+  block_size_ = header.block_size;
+
+  if (ReadIndex())
+    return true;
+
+  // The index is missing or invalid: walk the blocks.
+  blocks_.clear();
+  length_ = 0;
+  truncated_ = true;
+  if (!WalkBlocks()) {
+    file_.Close();
+    blocks_.clear();
+    length_ = 0;
+    return false;
+  }
+  return true;
+}
+
+void CompressedFileReader::set_thread_count(size_t thread_count) {
+  AutoLock auto_lock(pool_lock_);
+  thread_count_ = std::max(static_cast<size_t>(1), thread_count);
+  pool_.reset(NULL);
+}
+
+bool CompressedFileReader::ReadBlocks(uint64 offset,
+                                      size_t length,
+                                      std::string* data,
+                                      uint64* data_offset) const {
+  DCHECK(data != NULL);
+  DCHECK(data_offset != NULL);
+
+  data->clear();
+  *data_offset = std::min(offset, length_);
+  if (offset >= length_ || length == 0)
+    return true;
+  uint64 end = length_ - offset < length ? length_ : offset + length;
+
+  // The block holding |offset|: the last one starting at or before it.
+  size_t low = 0;
+  size_t high = blocks_.size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (blocks_[middle].raw_offset <= offset)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  DCHECK_GT(low, 0U);
+  size_t first = low - 1;
+
+  // The first block past the range.
+  size_t last = first + 1;
+  while (last < blocks_.size() && blocks_[last].raw_offset < end)
+    ++last;
+
+  const Block& last_block = blocks_[last - 1];
+  *data_offset = blocks_[first].raw_offset;
+  data->resize(static_cast<size_t>(
+      last_block.raw_offset + last_block.raw_size - *data_offset));
+
+  size_t count = last - first;
+  std::vector<const char*> inputs(count);
+  std::vector<CompressedBlockHeader> headers(count);
+  std::vector<char*> outputs(count);
+  for (size_t i = 0; i < count; ++i) {
+    const Block& block = blocks_[first + i];
+    inputs[i] = block.data;
+    headers[i].compressed_size = block.compressed_size;
+    headers[i].raw_size = block.raw_size;
+    outputs[i] = &(*data)[static_cast<size_t>(block.raw_offset -
+                                              *data_offset)];
+  }
+
+  // A single block is decompressed by the calling thread.
+  bool success = true;
+  if (count == 1 || thread_count_ == 1) {
+    for (size_t i = 0; i < count && success; ++i)
+      success = DecompressOrCopyBlock(inputs[i], headers[i], outputs[i]);
+  } else {
+    success = GetPool()->Decompress(inputs, headers, outputs);
+  }
+
+  if (!success)
+    data->clear();
+  return success;
+}
+
+bool CompressedFileReader::ReadAll(std::string* data) const {
+  DCHECK(data != NULL);
+  uint64 data_offset = 0;
+  if (length_ > static_cast<uint64>(static_cast<size_t>(-1)))
+    return false;
+  return ReadBlocks(0, static_cast<size_t>(length_), data, &data_offset);
+}
+
+DecompressPool* CompressedFileReader::GetPool() const {
+  AutoLock auto_lock(pool_lock_);
+  if (pool_.get() == NULL)
+    pool_.reset(new DecompressPool(thread_count_));
+  return pool_.get();
+}
+
+bool CompressedFileReader::ReadIndex() {
+  uint64 file_length = file_.length();
+  if (file_length < sizeof(CompressedFileHeader) +
+                    sizeof(CompressedBlockHeader) +
+                    sizeof(CompressedFileTrailer)) {
+    return false;
+  }
+
+  CompressedFileTrailer trailer;
+  memcpy(&trailer,
+         file_.data() + file_length - sizeof(CompressedFileTrailer),
+         sizeof(trailer));
+  if (trailer.magic != kCompressedFileMagic)
+    return false;
+
+  // The index sits between the end marker and the trailer.
+  uint64 index_end = file_length - sizeof(CompressedFileTrailer);
+  if (trailer.index_offset < sizeof(CompressedFileHeader) +
+                             sizeof(CompressedBlockHeader) ||
+      trailer.index_offset > index_end ||
+      trailer.block_count !=
+          (index_end - trailer.index_offset) /
+              sizeof(CompressedBlockIndexEntry) ||
+      (index_end - trailer.index_offset) %
+          sizeof(CompressedBlockIndexEntry) != 0) {
+    return false;
+  }
+
+  const char* index = file_.data() + trailer.index_offset;
+  blocks_.reserve(static_cast<size_t>(trailer.block_count));
+  for (uint64 i = 0; i < trailer.block_count; ++i) {
+    CompressedBlockIndexEntry entry;
+    memcpy(&entry, index + i * sizeof(entry), sizeof(entry));
+    if (!AddBlock(entry.offset, entry.raw_offset))
+      return false;
+  }
+  return length_ == trailer.raw_length;
+}
+
+bool CompressedFileReader::WalkBlocks() {
+  uint64 file_length = file_.length();
+  uint64 offset = sizeof(CompressedFileHeader);
+  for (;;) {
+    if (file_length - offset < sizeof(CompressedBlockHeader))
+      return true;
+
+    CompressedBlockHeader header;
+    memcpy(&header, file_.data() + offset, sizeof(header));
+    if (header.compressed_size == 0 && header.raw_size == 0)
+      return true;
+
+    // A block cut by the end of the file is dropped.
+    uint64 next = offset + sizeof(header) + header.compressed_size;
+    if (next > file_length)
+      return true;
+
+    if (!AddBlock(offset, length_))
+      return false;
+    offset = next;
+  }
+}
+
+bool CompressedFileReader::AddBlock(uint64 offset, uint64 raw_offset) {
+  uint64 file_length = file_.length();
+  if (offset < sizeof(CompressedFileHeader) || offset > file_length ||
+      file_length - offset < sizeof(CompressedBlockHeader)) {
+    return false;
+  }
+
+  CompressedBlockHeader header;
+  memcpy(&header, file_.data() + offset, sizeof(header));
+  uint64 data_offset = offset + sizeof(header);
+  if (header.raw_size == 0 || header.raw_size > block_size_ ||
+      header.compressed_size == 0 ||
+      header.compressed_size > header.raw_size ||
+      file_length - data_offset < header.compressed_size ||
+      raw_offset != length_) {
+    return false;
+  }
+
+  Block block = {};
+  block.data = file_.data() + data_offset;
+  block.compressed_size = header.compressed_size;
+  block.raw_size = header.raw_size;
+  block.raw_offset = raw_offset;
+  blocks_.push_back(block);
+  length_ += header.raw_size;
+  return true;
+}
+
+}  // namespace base
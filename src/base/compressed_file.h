@@ -0,0 +1,296 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A container of compressed blocks for the libtrace files. Any file written
+// through a std::ostream can be compressed by interposing a
+// CompressingStreamBuffer, and read back by block with a
+// CompressedFileReader. The blocks are independent: they are decompressed in
+// parallel, and a range of the raw file only decompresses the blocks it
+// overlaps.
+//
+// A file holds a CompressedFileHeader followed by blocks. A block is a
+// CompressedBlockHeader followed by its |compressed_size| bytes; a block that
+// doesn't shrink is stored raw, with |compressed_size| equal to |raw_size|.
+// An empty block header ends the blocks. It is followed by the index of the
+// blocks, one CompressedBlockIndexEntry per block, and by a
+// CompressedFileTrailer. All integers are little-endian.
+//
+// A file without its index, e.g. when the writer was interrupted, is still
+// readable: the reader walks the block headers instead.
+//
+// Usage example:
+//   std::ofstream file("trace.etwraw", std::ios::binary);
+//   CompressingStreamBuffer buffer(&file, kDefaultCompressedBlockSize);
+//   std::ostream out(&buffer);
+//   ETWRawRecordWriter writer(&out);
+//   ...
+//   buffer.Finish();
+//
+//   CompressedFileReader reader;
+//   std::string window;
+//   uint64 window_offset = 0;
+//   for (uint64 offset = 0; offset < reader.length();
+//        offset = window_offset + window.size()) {
+//     if (!reader.ReadBlocks(offset, kWindowSize, &window, &window_offset))
+//       break;
+//     Parse(window.data(), window.size());
+//   }
+
+#ifndef BASE_COMPRESSED_FILE_H_
+#define BASE_COMPRESSED_FILE_H_
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/block_compression.h"
+#include "base/lock.h"
+#include "base/memory_mapped_file.h"
+#include "base/scoped_ptr.h"
+
+namespace base {
+
+// The first bytes of a compressed file: "LTCZ".
+const uint32 kCompressedFileMagic = 0x5A43544C;
+
+// The version of the format written by CompressingStreamBuffer.
+const uint32 kCompressedFileVersion = 1;
+
+// The default size of the raw blocks, in bytes. Larger blocks compress
+// slightly better; smaller blocks decompress less data around a random
+// access, and spread better over the threads.
+const size_t kDefaultCompressedBlockSize = 256 * 1024;
+
+#pragma pack(push, 1)
+
+struct CompressedFileHeader {
+  uint32 magic;
+  uint32 version;
+  // The size of the raw blocks. Only the last block may be smaller.
+  uint32 block_size;
+  uint32 reserved;
+};
+
+struct CompressedBlockHeader {
+  uint32 compressed_size;
+  uint32 raw_size;
+};
+
+struct CompressedBlockIndexEntry {
+  // The offset of the block header in the compressed file.
+  uint64 offset;
+  // The offset of the block in the raw file.
+  uint64 raw_offset;
+};
+
+struct CompressedFileTrailer {
+  uint64 index_offset;
+  uint64 block_count;
+  uint64 raw_length;
+  uint32 reserved;
+  uint32 magic;
+};
+
+#pragma pack(pop)
+
+COMPILE_ASSERT(sizeof(CompressedFileHeader) == 16,
+               compressed_file_header_must_be_16_bytes);
+COMPILE_ASSERT(sizeof(CompressedBlockHeader) == 8,
+               compressed_block_header_must_be_8_bytes);
+COMPILE_ASSERT(sizeof(CompressedBlockIndexEntry) == 16,
+               compressed_block_index_entry_must_be_16_bytes);
+COMPILE_ASSERT(sizeof(CompressedFileTrailer) == 32,
+               compressed_file_trailer_must_be_32_bytes);
+
+// Checks whether the beginning of a file is a compressed file header.
+// @param data the first bytes of the file.
+// @param size the number of bytes available at |data|.
+// @returns true if |data| starts with a compressed file header.
+bool IsCompressedFile(const char* data, size_t size);
+
+// A stream buffer compressing everything written to it, by block, into
+// another stream.
+class CompressingStreamBuffer : public std::streambuf {
+ public:
+  // Writes the file header.
+  // @param out the binary stream receiving the compressed file. Must outlive
+  //     the buffer.
+  // @param block_size the size of the raw blocks, in bytes, e.g.
+  //     kDefaultCompressedBlockSize.
+  CompressingStreamBuffer(std::ostream* out, size_t block_size);
+
+  // Finishes the file if Finish was not called.
+  virtual ~CompressingStreamBuffer();
+
+  // Compresses the pending bytes, then writes the end of the file. Nothing
+  // can be written once the file is finished.
+  // @returns true on success, false if the stream failed.
+  bool Finish();
+
+  // @returns the number of raw bytes written.
+  uint64 raw_length() const;
+
+  // @returns the number of compressed bytes written, headers included.
+  uint64 compressed_length() const { return compressed_length_; }
+
+ protected:
+  // std::streambuf implementation.
+  // @{
+  virtual int_type overflow(int_type c) OVERRIDE;
+  // Compresses the pending bytes in a smaller block and flushes |out|.
+  virtual int sync() OVERRIDE;
+  // Only reports the current position, for tellp.
+  virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                           std::ios_base::openmode which) OVERRIDE;
+  // @}
+
+ private:
+  // Compresses and writes the pending bytes.
+  // @returns true on success, false if the stream failed.
+  bool FlushBlock();
+
+  // Writes bytes to |out_|.
+  void Write(const void* data, size_t size);
+
+  std::ostream* out_;
+  BlockCompressor compressor_;
+
+  // The pending raw bytes, and the compressed block.
+  std::vector<char> buffer_;
+  std::vector<char> compressed_;
+
+  // The index of the written blocks.
+  std::vector<CompressedBlockIndexEntry> index_;
+
+  // The number of raw bytes compressed so far.
+  uint64 flushed_length_;
+  uint64 compressed_length_;
+  bool finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompressingStreamBuffer);
+};
+
+class DecompressPool;
+
+// Reads a compressed file by ranges of its raw bytes. The threads
+// decompressing the blocks are started by the first read, and kept until
+// the reader is destroyed.
+class CompressedFileReader {
+ public:
+  CompressedFileReader();
+  ~CompressedFileReader();
+
+  // Maps a compressed file and reads its index. A file already open is
+  // closed first.
+  // @param path the path of the file.
+  // @returns true on success, false if the file can't be mapped or is not a
+  //     compressed file.
+  bool Open(const std::string& path);
+
+  // Sets the number of threads decompressing the blocks. Defaults to the
+  // number of processors. Must not be called during a read.
+  // @param thread_count the number of threads, including the calling one.
+  void set_thread_count(size_t thread_count);
+
+  // @returns the length of the raw file, in bytes.
+  uint64 length() const { return length_; }
+
+  // @returns the number of blocks of the file.
+  size_t block_count() const { return blocks_.size(); }
+
+  // @returns the size of the raw blocks. Only the last block may be
+  //     smaller.
+  uint32 block_size() const { return block_size_; }
+
+  // @returns true if the file ends before its index: only the complete
+  //     blocks are readable.
+  bool truncated() const { return truncated_; }
+
+  // Decompresses the blocks overlapping a range of the raw file. The range
+  // is clamped to the end of the file.
+  // @param offset the offset of the range in the raw file.
+  // @param length the length of the range.
+  // @param data receives the decompressed blocks. The range starts at
+  //     |offset - *data_offset| in |data|.
+  // @param data_offset receives the offset of |data| in the raw file.
+  // @returns true on success, false if a block is corrupted.
+  bool ReadBlocks(uint64 offset,
+                  size_t length,
+                  std::string* data,
+                  uint64* data_offset) const;
+
+  // Decompresses the whole file. Prefer ReadBlocks over a window on large
+  // files: the whole raw file is held in memory.
+  // @param data receives the raw file.
+  // @returns true on success, false if a block is corrupted.
+  bool ReadAll(std::string* data) const;
+
+ private:
+  struct Block {
+    // The compressed bytes of the block.
+    const char* data;
+    uint32 compressed_size;
+    uint32 raw_size;
+    uint64 raw_offset;
+  };
+
+  // Reads the block index from the trailer.
+  // @returns false if the trailer or the index are missing or invalid.
+  bool ReadIndex();
+
+  // Walks the block headers.
+  // @returns false if a block is invalid.
+  bool WalkBlocks();
+
+  // Adds a block after checking its bounds.
+  // @param offset the offset of the block header in the file.
+  // @param raw_offset the offset of the block in the raw file.
+  // @returns false if the block is invalid.
+  bool AddBlock(uint64 offset, uint64 raw_offset);
+
+  // @returns the threads decompressing the blocks, started on the first
+  //     call.
+  DecompressPool* GetPool() const;
+
+  MemoryMappedFile file_;
+  std::vector<Block> blocks_;
+  uint32 block_size_;
+  uint64 length_;
+  bool truncated_;
+  size_t thread_count_;
+
+  // The decompression threads, shared by the reads.
+  mutable Lock pool_lock_;
+  mutable scoped_ptr<DecompressPool> pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompressedFileReader);
+};
+
+}  // namespace base
+
+#endif  // BASE_COMPRESSED_FILE_H_
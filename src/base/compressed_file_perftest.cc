@@ -0,0 +1,105 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "base/compressed_file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "base/perf_test.h"
+#include "base/thread.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const char kTempFile[] = "compressed_file_perftest.tmp";
+const size_t kContentSize = 64 << 20;
+
+// @returns a content resembling raw trace records: fixed headers with
+// slowly changing fields, followed by file paths.
+std::string MakeTraceContent(size_t size) {
+  std::string content;
+  content.reserve(size + 256);
+  uint32 seed = 1;
+  char buffer[256];
+  for (uint32 i = 0; content.size() < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    int length = snprintf(
+        buffer, sizeof(buffer),
+        "%c%c%c%c%c%c%c%cC:\\Windows\\System32\\drivers\\module%u.sys",
+        static_cast<char>(i), static_cast<char>(i >> 8),
+        static_cast<char>(i >> 16), 0, static_cast<char>(seed >> 24),
+        static_cast<char>(i % 8), 0x24, 0x02,
+        static_cast<unsigned>(seed >> 22));
+    content.append(buffer, length + 1);
+  }
+  content.resize(size);
+  return content;
+}
+
+}  // namespace
+
+TEST(CompressedFilePerfTest, CompressAndDecompress) {
+  std::string content = MakeTraceContent(kContentSize);
+  size_t kilobytes = content.size() >> 10;
+
+  {
+    std::ofstream file(kTempFile, std::ios::binary);
+    CompressingStreamBuffer buffer(&file, kDefaultCompressedBlockSize);
+    std::ostream out(&buffer);
+    PerfTimer timer;
+    out.write(content.data(), content.size());
+    ASSERT_TRUE(buffer.Finish());
+    PrintPerfResult("Compress", "time", timer.ElapsedNanoseconds(), kilobytes,
+                    "ns/KB");
+    PrintPerfResult("Compress", "ratio",
+                    buffer.compressed_length() * 100 / buffer.raw_length(), 1,
+                    "%");
+  }
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  std::string data;
+
+  reader.set_thread_count(1);
+  PerfTimer timer;
+  ASSERT_TRUE(reader.ReadAll(&data));
+  PrintPerfResult("DecompressOneThread", "time", timer.ElapsedNanoseconds(),
+                  kilobytes, "ns/KB");
+  EXPECT_TRUE(data == content);
+
+  reader.set_thread_count(Thread::NumberOfProcessors());
+  timer.Reset();
+  ASSERT_TRUE(reader.ReadAll(&data));
+  PrintPerfResult("DecompressAllThreads", "time", timer.ElapsedNanoseconds(),
+                  kilobytes, "ns/KB");
+  EXPECT_TRUE(data == content);
+
+  std::remove(kTempFile);
+}
+
+}  // namespace base
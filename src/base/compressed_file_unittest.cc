@@ -0,0 +1,300 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "base/compressed_file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const char kTempFile[] = "compressed_file_unittest.tmp";
+
+class CompressedFileTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  // Compresses |content| into the temporary file.
+  // @returns the compressed file.
+  std::string WriteCompressedFile(const std::string& content,
+                                  size_t block_size) {
+    std::ostringstream file;
+    CompressingStreamBuffer buffer(&file, block_size);
+    std::ostream out(&buffer);
+    out.write(content.data(), content.size());
+    EXPECT_EQ(content.size(), buffer.raw_length());
+    EXPECT_TRUE(buffer.Finish());
+    EXPECT_EQ(file.str().size(), buffer.compressed_length());
+    WriteTempFile(file.str());
+    return file.str();
+  }
+
+  void WriteTempFile(const std::string& content) {
+    FILE* file = std::fopen(kTempFile, "wb");
+    ASSERT_TRUE(file != NULL);
+    if (!content.empty())
+      std::fwrite(content.data(), 1, content.size(), file);
+    std::fclose(file);
+  }
+};
+
+// @returns a trace-like content of |size| bytes, partly compressible.
+std::string MakeContent(size_t size) {
+  std::string content;
+  uint32 seed = 1;
+  while (content.size() < size) {
+    seed = seed * 1103515245 + 12345;
+    content += "Thread ";
+    content.push_back(static_cast<char>('0' + (seed >> 28)));
+    content.push_back(static_cast<char>(seed >> 16));
+    content += " read C:\\trace.etl\n";
+  }
+  content.resize(size);
+  return content;
+}
+
+}  // namespace
+
+TEST_F(CompressedFileTest, IsCompressedFile) {
+  const char kMagic[] = "LTCZ....";
+  EXPECT_TRUE(IsCompressedFile(kMagic, 8));
+  EXPECT_FALSE(IsCompressedFile(kMagic, 3));
+  EXPECT_FALSE(IsCompressedFile("LTRR....", 8));
+  EXPECT_FALSE(IsCompressedFile(NULL, 0));
+}
+
+TEST_F(CompressedFileTest, RoundTrip) {
+  std::string content = MakeContent(100000);
+  std::string file = WriteCompressedFile(content, 4096);
+  EXPECT_TRUE(IsCompressedFile(file.data(), file.size()));
+  EXPECT_LT(file.size(), content.size() / 2);
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  EXPECT_FALSE(reader.truncated());
+  EXPECT_EQ(content.size(), reader.length());
+  EXPECT_EQ(25U, reader.block_count());
+
+  std::string data;
+  ASSERT_TRUE(reader.ReadAll(&data));
+  EXPECT_EQ(content, data);
+}
+
+TEST_F(CompressedFileTest, Empty) {
+  WriteCompressedFile("", 4096);
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  EXPECT_EQ(0U, reader.length());
+  EXPECT_EQ(0U, reader.block_count());
+
+  std::string data("x");
+  ASSERT_TRUE(reader.ReadAll(&data));
+  EXPECT_TRUE(data.empty());
+}
+
+TEST_F(CompressedFileTest, IncompressibleBlocksAreStoredRaw) {
+  std::string content;
+  uint32 seed = 3;
+  for (size_t i = 0; i < 10000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    content.push_back(static_cast<char>(seed >> 24));
+  }
+  std::string file = WriteCompressedFile(content, 1000);
+  EXPECT_LE(file.size(), content.size() + 10 * sizeof(CompressedBlockHeader) +
+                         10 * sizeof(CompressedBlockIndexEntry) + 64);
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  std::string data;
+  ASSERT_TRUE(reader.ReadAll(&data));
+  EXPECT_EQ(content, data);
+}
+
+TEST_F(CompressedFileTest, ReadBlocks) {
+  std::string content = MakeContent(10000);
+  WriteCompressedFile(content, 1000);
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  ASSERT_EQ(10U, reader.block_count());
+
+  std::string data;
+  uint64 data_offset = 0;
+  ASSERT_TRUE(reader.ReadBlocks(2500, 1000, &data, &data_offset));
+  EXPECT_EQ(2000U, data_offset);
+  EXPECT_EQ(content.substr(2000, 2000), data);
+
+  ASSERT_TRUE(reader.ReadBlocks(3000, 1, &data, &data_offset));
+  EXPECT_EQ(3000U, data_offset);
+  EXPECT_EQ(content.substr(3000, 1000), data);
+
+  // The range is clamped to the end of the file.
+  ASSERT_TRUE(reader.ReadBlocks(9999, 1000, &data, &data_offset));
+  EXPECT_EQ(9000U, data_offset);
+  EXPECT_EQ(content.substr(9000), data);
+
+  ASSERT_TRUE(reader.ReadBlocks(10000, 1000, &data, &data_offset));
+  EXPECT_EQ(10000U, data_offset);
+  EXPECT_TRUE(data.empty());
+}
+
+TEST_F(CompressedFileTest, ThreadCounts) {
+  std::string content = MakeContent(100000);
+  WriteCompressedFile(content, 1024);
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  for (size_t thread_count = 1; thread_count <= 8; ++thread_count) {
+    reader.set_thread_count(thread_count);
+    std::string data;
+    ASSERT_TRUE(reader.ReadAll(&data));
+    EXPECT_EQ(content, data) << thread_count;
+
+    uint64 data_offset = 0;
+    ASSERT_TRUE(reader.ReadBlocks(5000, 3000, &data, &data_offset));
+    EXPECT_EQ(content.substr(4096, 4096), data);
+  }
+}
+
+TEST_F(CompressedFileTest, SlidingWindow) {
+  std::string content = MakeContent(100000);
+  WriteCompressedFile(content, 1000);
+
+  // The reads of the window share the threads of the reader, also after the
+  // file is opened again.
+  CompressedFileReader reader;
+  reader.set_thread_count(4);
+  for (int pass = 0; pass < 2; ++pass) {
+    ASSERT_TRUE(reader.Open(kTempFile));
+    std::string window;
+    uint64 window_offset = 0;
+    std::string data;
+    for (uint64 offset = 0; offset < reader.length();
+         offset = window_offset + window.size()) {
+      ASSERT_TRUE(reader.ReadBlocks(offset, 3500, &window, &window_offset));
+      EXPECT_EQ(offset, window_offset);
+      EXPECT_EQ(4000U, window.size());
+      data.append(window);
+    }
+    EXPECT_EQ(content, data);
+  }
+}
+
+TEST_F(CompressedFileTest, SyncFlushesSmallerBlocks) {
+  std::ostringstream file;
+  CompressingStreamBuffer buffer(&file, 1000);
+  std::ostream out(&buffer);
+  out << "first part" << std::flush;
+  EXPECT_EQ(10, static_cast<int>(out.tellp()));
+  out << "second part";
+  ASSERT_TRUE(buffer.Finish());
+  WriteTempFile(file.str());
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  EXPECT_EQ(2U, reader.block_count());
+  std::string data;
+  ASSERT_TRUE(reader.ReadAll(&data));
+  EXPECT_EQ("first partsecond part", data);
+}
+
+TEST_F(CompressedFileTest, DestructorFinishes) {
+  std::string content = MakeContent(5000);
+  std::ostringstream file;
+  {
+    CompressingStreamBuffer buffer(&file, 1000);
+    std::ostream out(&buffer);
+    out << content;
+  }
+  WriteTempFile(file.str());
+
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  EXPECT_FALSE(reader.truncated());
+  std::string data;
+  ASSERT_TRUE(reader.ReadAll(&data));
+  EXPECT_EQ(content, data);
+}
+
+TEST_F(CompressedFileTest, Truncated) {
+  std::string content = MakeContent(10000);
+  std::string file = WriteCompressedFile(content, 1000);
+
+  // Without its index, the complete blocks are still readable.
+  for (size_t size = file.size() - 1; size > 0; size -= 37) {
+    WriteTempFile(file.substr(0, size));
+    CompressedFileReader reader;
+    if (size < sizeof(CompressedFileHeader)) {
+      EXPECT_FALSE(reader.Open(kTempFile));
+      break;
+    }
+    ASSERT_TRUE(reader.Open(kTempFile)) << size;
+    EXPECT_TRUE(reader.truncated());
+    EXPECT_EQ(reader.block_count() * 1000, reader.length());
+    std::string data;
+    ASSERT_TRUE(reader.ReadAll(&data));
+    EXPECT_EQ(content.substr(0, data.size()), data);
+    if (size < 37)
+      break;
+  }
+}
+
+TEST_F(CompressedFileTest, Corrupted) {
+  std::string content = MakeContent(10000);
+  std::string file = WriteCompressedFile(content, 1000);
+
+  // A corrupted block is detected by the decompression.
+  std::string corrupted = file;
+  corrupted[sizeof(CompressedFileHeader) + sizeof(CompressedBlockHeader) +
+            20] ^= 0x7F;
+  WriteTempFile(corrupted);
+  CompressedFileReader reader;
+  ASSERT_TRUE(reader.Open(kTempFile));
+  std::string data;
+  if (!reader.ReadAll(&data))
+    EXPECT_TRUE(data.empty());
+  else
+    EXPECT_NE(content, data);
+
+  // A block header larger than the blocks.
+  corrupted = file;
+  corrupted[sizeof(CompressedFileHeader) + 5] = 0x7F;
+  WriteTempFile(corrupted);
+  EXPECT_FALSE(reader.Open(kTempFile));
+
+  // Not a compressed file.
+  WriteTempFile(content);
+  EXPECT_FALSE(reader.Open(kTempFile));
+}
+
+}  // namespace base
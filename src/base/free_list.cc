@@ -0,0 +1,116 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/free_list.h"
+
+#include "base/thread_local.h"
+
+namespace base {
+
+namespace {
+
+// Leaked: the slot must outlive the threads, which delete their free list on
+// exit.
+ThreadLocalOwnedPointer<FreeList>* CurrentFreeListSlot() {
+  static ThreadLocalOwnedPointer<FreeList>* slot =
+      new ThreadLocalOwnedPointer<FreeList>;
+  return slot;
+}
+
+}  // namespace
+
+const size_t FreeList::kGranularity;
+const size_t FreeList::kMaxBlockSize;
+const size_t FreeList::kMaxCachedBlocks;
+
+FreeList::FreeList() {
+  for (size_t i = 0; i < kSizeClasses; ++i) {
+    heads_[i] = NULL;
+    counts_[i] = 0;
+  }
+}
+
+FreeList::~FreeList() {
+  for (size_t i = 0; i < kSizeClasses; ++i) {
+    while (heads_[i] != NULL) {
+      Block* block = heads_[i];
+      heads_[i] = block->next;
+      ::operator delete(block);
+    }
+  }
+}
+
+void* FreeList::Allocate(size_t size) {
+  if (size == 0)
+    size = 1;
+  if (size > kMaxBlockSize)
+    return ::operator new(size);
+
+  size_t size_class = SizeClass(size);
+  Block* block = heads_[size_class];
+  if (block == NULL)
+    return ::operator new((size_class + 1) * kGranularity);
+
+  heads_[size_class] = block->next;
+  --counts_[size_class];
+  return block;
+}
+
+void FreeList::Free(void* block, size_t size) {
+  if (block == NULL)
+    return;
+  if (size == 0)
+    size = 1;
+
+  size_t size_class = SizeClass(size);
+  if (size > kMaxBlockSize || counts_[size_class] >= kMaxCachedBlocks) {
+    ::operator delete(block);
+    return;
+  }
+
+  Block* head = static_cast<Block*>(block);
+  head->next = heads_[size_class];
+  heads_[size_class] = head;
+  ++counts_[size_class];
+}
+
+size_t FreeList::CachedBlocks() const {
+  size_t count = 0;
+  for (size_t i = 0; i < kSizeClasses; ++i)
+    count += counts_[i];
+  return count;
+}
+
+FreeList* FreeList::Current() {
+  ThreadLocalOwnedPointer<FreeList>* slot = CurrentFreeListSlot();
+  FreeList* free_list = slot->Get();
+  if (free_list == NULL) {
+    free_list = new FreeList();
+    slot->Set(free_list);
+  }
+  return free_list;
+}
+
+}  // namespace base
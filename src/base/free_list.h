@@ -0,0 +1,161 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A cache of memory blocks, sorted by size class. Objects that are created and
+// destroyed at a high rate (e.g. the values of decoded events) recycle their
+// memory through the free list of their thread instead of going back to the
+// heap each time.
+//
+//   void* block = FreeList::Current()->Allocate(24);
+//   ...
+//   FreeList::Current()->Free(block, 24);
+//
+// The blocks are obtained from ::operator new: a block may be released with
+// ::operator delete, or with the free list of another thread.
+
+#ifndef BASE_FREE_LIST_H_
+#define BASE_FREE_LIST_H_
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#include "base/base.h"
+
+namespace base {
+
+class FreeList {
+ public:
+  // The blocks are rounded up to a multiple of this granularity.
+  static const size_t kGranularity = 16;
+
+  // Larger blocks are not cached.
+  static const size_t kMaxBlockSize = 1024;
+
+  // The maximal number of cached blocks for each size class.
+  static const size_t kMaxCachedBlocks = 512;
+
+  FreeList();
+  ~FreeList();
+
+  // Allocates a block of at least |size| bytes.
+  // @param size the size of the block.
+  // @returns the allocated block.
+  void* Allocate(size_t size);
+
+  // Releases a block. The block is cached for a later allocation of the same
+  // size class, or returned to the heap if the cache is full.
+  // @param block the block to release, may be NULL.
+  // @param size the size that was requested for the block.
+  void Free(void* block, size_t size);
+
+  // @returns the number of blocks currently cached.
+  size_t CachedBlocks() const;
+
+  // @returns the free list of the calling thread. It is created on first use
+  //     and deleted, with its cached blocks, when the thread exits.
+  static FreeList* Current();
+
+ private:
+  static const size_t kSizeClasses = kMaxBlockSize / kGranularity;
+
+  // A cached block is linked to the next cached block of its size class.
+  struct Block {
+    Block* next;
+  };
+
+  // Returns the index of the size class of |size|. |size| must not be larger
+  // than kMaxBlockSize.
+  static size_t SizeClass(size_t size) {
+    return (size + kGranularity - 1) / kGranularity - 1;
+  }
+
+  Block* heads_[kSizeClasses];
+  size_t counts_[kSizeClasses];
+
+  DISALLOW_COPY_AND_ASSIGN(FreeList);
+};
+
+// A STL allocator recycling its memory through the free list of the calling
+// thread.
+template <typename T>
+class FreeListAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef FreeListAllocator<U> other;
+  };
+
+  FreeListAllocator() { }
+
+  template <typename U>
+  FreeListAllocator(const FreeListAllocator<U>&) { }
+
+  pointer address(reference value) const { return &value; }
+  const_pointer address(const_reference value) const { return &value; }
+
+  pointer allocate(size_type count, const void* = 0) {
+    return static_cast<pointer>(
+        FreeList::Current()->Allocate(count * sizeof(T)));
+  }
+
+  void deallocate(pointer block, size_type count) {
+    FreeList::Current()->Free(block, count * sizeof(T));
+  }
+
+  size_type max_size() const {
+    return std::numeric_limits<size_type>::max() / sizeof(T);
+  }
+
+  void construct(pointer block, const T& value) {
+    new(static_cast<void*>(block)) T(value);
+  }
+
+  void destroy(pointer block) {
+    block->~T();
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const FreeListAllocator<T>&, const FreeListAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const FreeListAllocator<T>&, const FreeListAllocator<U>&) {
+  return false;
+}
+
+}  // namespace base
+
+#endif  // BASE_FREE_LIST_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/free_list.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(FreeListTest, RecycleBlock) {
+  FreeList free_list;
+  void* block = free_list.Allocate(24);
+  ASSERT_TRUE(block != NULL);
+  free_list.Free(block, 24);
+  EXPECT_EQ(1U, free_list.CachedBlocks());
+
+  // A block of the same size class is reused.
+  EXPECT_EQ(block, free_list.Allocate(20));
+  EXPECT_EQ(0U, free_list.CachedBlocks());
+  free_list.Free(block, 20);
+}
+
+TEST(FreeListTest, DistinctSizeClasses) {
+  FreeList free_list;
+  void* small = free_list.Allocate(8);
+  free_list.Free(small, 8);
+
+  void* large = free_list.Allocate(64);
+  EXPECT_NE(small, large);
+  EXPECT_EQ(1U, free_list.CachedBlocks());
+  free_list.Free(large, 64);
+  EXPECT_EQ(2U, free_list.CachedBlocks());
+}
+
+TEST(FreeListTest, LargeBlocksAreNotCached) {
+  FreeList free_list;
+  void* block = free_list.Allocate(FreeList::kMaxBlockSize + 1);
+  ASSERT_TRUE(block != NULL);
+  free_list.Free(block, FreeList::kMaxBlockSize + 1);
+  EXPECT_EQ(0U, free_list.CachedBlocks());
+}
+
+TEST(FreeListTest, CacheIsBounded) {
+  FreeList free_list;
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < FreeList::kMaxCachedBlocks + 10; ++i)
+    blocks.push_back(free_list.Allocate(32));
+  for (size_t i = 0; i < blocks.size(); ++i)
+    free_list.Free(blocks[i], 32);
+  EXPECT_EQ(FreeList::kMaxCachedBlocks, free_list.CachedBlocks());
+}
+
+TEST(FreeListTest, Allocator) {
+  std::vector<int, FreeListAllocator<int> > values;
+  for (int i = 0; i < 100; ++i)
+    values.push_back(i);
+  EXPECT_EQ(100U, values.size());
+  EXPECT_EQ(99, values.back());
+}
+
+}  // namespace base
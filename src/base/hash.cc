@@ -0,0 +1,70 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/hash.h"
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+const uint64 kMultiplier = 0x9E3779B97F4A7C15ULL;
+
+// The finalizer of MurmurHash3: every input bit affects every output bit.
+uint64 Mix(uint64 value) {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDULL;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+}  // namespace
+
+uint64 Hash64(const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  uint64 hash = static_cast<uint64>(size) * kMultiplier;
+
+  // Consume the bytes 8 at a time.
+  size_t offset = 0;
+  for (; offset + sizeof(uint64) <= size; offset += sizeof(uint64)) {
+    uint64 word;
+    memcpy(&word, bytes + offset, sizeof(word));
+    hash = (hash ^ Mix(word)) * kMultiplier;
+  }
+
+  // Consume the remaining bytes, if any.
+  if (offset < size) {
+    uint64 word = 0;
+    memcpy(&word, bytes + offset, size - offset);
+    hash = (hash ^ Mix(word)) * kMultiplier;
+  }
+
+  return Mix(hash);
+}
+
+}  // namespace base
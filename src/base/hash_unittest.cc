@@ -0,0 +1,63 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/hash.h"
+
+#include <set>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+TEST(HashTest, Deterministic) {
+  const uint64 kFrames[] = { 0xFFFFF80001234567ULL, 0x7FF712345678ULL };
+  EXPECT_EQ(Hash64(kFrames, sizeof(kFrames)),
+            Hash64(kFrames, sizeof(kFrames)));
+  EXPECT_EQ(Hash64(std::string("dummy")), Hash64("dummy", 5));
+}
+
+TEST(HashTest, DependsOnSizeAndContent) {
+  const uint64 kFrames[] = { 1, 2, 3 };
+  const uint64 kOtherFrames[] = { 1, 2, 4 };
+  EXPECT_NE(Hash64(kFrames, sizeof(kFrames)),
+            Hash64(kOtherFrames, sizeof(kOtherFrames)));
+  EXPECT_NE(Hash64(kFrames, sizeof(kFrames)),
+            Hash64(kFrames, 2 * sizeof(kFrames[0])));
+
+  // Trailing zero bytes are not ignored.
+  const char kBytes[] = { 'a', 0, 0 };
+  EXPECT_NE(Hash64(kBytes, 1), Hash64(kBytes, 2));
+  EXPECT_NE(Hash64(kBytes, 2), Hash64(kBytes, 3));
+  EXPECT_NE(Hash64(kBytes, 0), Hash64(kBytes, 1));
+}
+
+TEST(HashTest, FewCollisions) {
+  std::set<uint64> hashes;
+  for (uint64 i = 0; i < 10000; ++i)
+    hashes.insert(Hash64(&i, sizeof(i)));
+  EXPECT_EQ(10000U, hashes.size());
+}
+
+}  // namespace base
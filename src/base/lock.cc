@@ -0,0 +1,129 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/lock.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+#if defined(_WIN32)
+
+Lock::Lock() {
+  ::InitializeCriticalSection(&lock_);
+}
+
+Lock::~Lock() {
+  ::DeleteCriticalSection(&lock_);
+}
+
+void Lock::Acquire() {
+  ::EnterCriticalSection(&lock_);
+}
+
+void Lock::Release() {
+  ::LeaveCriticalSection(&lock_);
+}
+
+bool Lock::Try() {
+  return ::TryEnterCriticalSection(&lock_) != FALSE;
+}
+
+ConditionVariable::ConditionVariable(Lock* lock) : lock_(lock) {
+  DCHECK(lock != NULL);
+  ::InitializeConditionVariable(&condition_);
+}
+
+ConditionVariable::~ConditionVariable() {
+}
+
+void ConditionVariable::Wait() {
+  if (!::SleepConditionVariableCS(&condition_, &lock_->lock_, INFINITE))
+    LOG(FATAL) << "Unable to wait on the condition variable.";
+}
+
+void ConditionVariable::Signal() {
+  ::WakeConditionVariable(&condition_);
+}
+
+void ConditionVariable::Broadcast() {
+  ::WakeAllConditionVariable(&condition_);
+}
+
+#else
+
+Lock::Lock() {
+  if (pthread_mutex_init(&lock_, NULL) != 0)
+    LOG(FATAL) << "Unable to initialize the mutex.";
+}
+
+Lock::~Lock() {
+  if (pthread_mutex_destroy(&lock_) != 0)
+    LOG(ERROR) << "Unable to destroy the mutex.";
+}
+
+void Lock::Acquire() {
+  if (pthread_mutex_lock(&lock_) != 0)
+    LOG(FATAL) << "Unable to acquire the mutex.";
+}
+
+void Lock::Release() {
+  if (pthread_mutex_unlock(&lock_) != 0)
+    LOG(FATAL) << "Unable to release the mutex.";
+}
+
+bool Lock::Try() {
+  return pthread_mutex_trylock(&lock_) == 0;
+}
+
+ConditionVariable::ConditionVariable(Lock* lock) : lock_(lock) {
+  DCHECK(lock != NULL);
+  if (pthread_cond_init(&condition_, NULL) != 0)
+    LOG(FATAL) << "Unable to initialize the condition variable.";
+}
+
+ConditionVariable::~ConditionVariable() {
+  if (pthread_cond_destroy(&condition_) != 0)
+    LOG(ERROR) << "Unable to destroy the condition variable.";
+}
+
+void ConditionVariable::Wait() {
+  if (pthread_cond_wait(&condition_, &lock_->lock_) != 0)
+    LOG(FATAL) << "Unable to wait on the condition variable.";
+}
+
+void ConditionVariable::Signal() {
+  if (pthread_cond_signal(&condition_) != 0)
+    LOG(FATAL) << "Unable to signal the condition variable.";
+}
+
+void ConditionVariable::Broadcast() {
+  if (pthread_cond_broadcast(&condition_) != 0)
+    LOG(FATAL) << "Unable to broadcast the condition variable.";
+}
+
+#endif
+
+}  // namespace base
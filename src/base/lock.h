@@ -0,0 +1,118 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BASE_LOCK_H_
+#define BASE_LOCK_H_
+
+#if defined(_WIN32)
+// Restrict the import to the windows basic includes.
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  // NOLINT
+#else
+#include <pthread.h>
+#endif
+
+#include "base/base.h"
+
+namespace base {
+
+// A non-recursive mutual exclusion lock.
+class Lock {
+ public:
+  Lock();
+  ~Lock();
+
+  // Blocks until the lock is acquired by the calling thread.
+  void Acquire();
+
+  // Releases a lock previously acquired by the calling thread.
+  void Release();
+
+  // Tries to acquire the lock without blocking.
+  // @returns true if the lock has been acquired, false otherwise.
+  bool Try();
+
+ private:
+#if defined(_WIN32)
+  CRITICAL_SECTION lock_;
+#else
+  pthread_mutex_t lock_;
+#endif
+
+  friend class ConditionVariable;
+
+  DISALLOW_COPY_AND_ASSIGN(Lock);
+};
+
+// Acquires a lock for the duration of the current scope.
+class AutoLock {
+ public:
+  explicit AutoLock(Lock& lock) : lock_(lock) {
+    lock_.Acquire();
+  }
+
+  ~AutoLock() {
+    lock_.Release();
+  }
+
+ private:
+  Lock& lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(AutoLock);
+};
+
+// Blocks threads until a condition, protected by a lock, changes. The waits
+// may end spuriously: they must be made in a loop checking the condition.
+class ConditionVariable {
+ public:
+  // @param lock the lock protecting the condition. Must outlive the
+  //     condition variable.
+  explicit ConditionVariable(Lock* lock);
+  ~ConditionVariable();
+
+  // Releases the lock, blocks until the condition variable is signaled, then
+  // acquires the lock again. The lock must be held by the calling thread.
+  void Wait();
+
+  // Wakes one of the waiting threads, if any.
+  void Signal();
+
+  // Wakes all the waiting threads.
+  void Broadcast();
+
+ private:
+  Lock* lock_;
+#if defined(_WIN32)
+  CONDITION_VARIABLE condition_;
+#else
+  pthread_cond_t condition_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(ConditionVariable);
+};
+
+}  // namespace base
+
+#endif  // BASE_LOCK_H_
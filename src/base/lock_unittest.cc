@@ -0,0 +1,130 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/lock.h"
+
+#include "base/thread.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class CounterIncrementer : public Thread::Delegate {
+ public:
+  CounterIncrementer(Lock* lock, int* counter)
+      : lock_(lock), counter_(counter) {
+  }
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < 10000; ++i) {
+      AutoLock auto_lock(*lock_);
+      ++*counter_;
+    }
+  }
+
+ private:
+  Lock* lock_;
+  int* counter_;
+};
+
+// Waits for a flag, then raises another one.
+class Waiter : public Thread::Delegate {
+ public:
+  Waiter(Lock* lock, ConditionVariable* condition, bool* go, bool* done)
+      : lock_(lock), condition_(condition), go_(go), done_(done) {
+  }
+
+  virtual void Run() OVERRIDE {
+    AutoLock auto_lock(*lock_);
+    while (!*go_)
+      condition_->Wait();
+    *done_ = true;
+    condition_->Broadcast();
+  }
+
+ private:
+  Lock* lock_;
+  ConditionVariable* condition_;
+  bool* go_;
+  bool* done_;
+};
+
+}  // namespace
+
+TEST(LockTest, AcquireRelease) {
+  Lock lock;
+  lock.Acquire();
+  EXPECT_FALSE(lock.Try());
+  lock.Release();
+  EXPECT_TRUE(lock.Try());
+  lock.Release();
+}
+
+TEST(LockTest, AutoLock) {
+  Lock lock;
+  {
+    AutoLock auto_lock(lock);
+    EXPECT_FALSE(lock.Try());
+  }
+  EXPECT_TRUE(lock.Try());
+  lock.Release();
+}
+
+TEST(LockTest, MutualExclusion) {
+  Lock lock;
+  int counter = 0;
+  CounterIncrementer incrementer(&lock, &counter);
+  Thread thread1(&incrementer);
+  Thread thread2(&incrementer);
+  EXPECT_TRUE(thread1.Start());
+  EXPECT_TRUE(thread2.Start());
+  thread1.Join();
+  thread2.Join();
+  EXPECT_EQ(20000, counter);
+}
+
+TEST(ConditionVariableTest, WaitAndBroadcast) {
+  Lock lock;
+  ConditionVariable condition(&lock);
+  bool go = false;
+  bool done = false;
+  Waiter waiter(&lock, &condition, &go, &done);
+  Thread thread(&waiter);
+  ASSERT_TRUE(thread.Start());
+
+  {
+    AutoLock auto_lock(lock);
+    EXPECT_FALSE(done);
+    go = true;
+    condition.Broadcast();
+    while (!done)
+      condition.Wait();
+  }
+  thread.Join();
+  EXPECT_TRUE(done);
+}
+
+}  // namespace base
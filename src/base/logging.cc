@@ -23,32 +23,378 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include "base/logging.h"
+
 #include <iostream>
+#include <vector>
 
-#include "base/logging.h"
+#include "base/lock.h"
+#include "base/thread.h"
 
 namespace base {
 
+namespace internal {
+
+subtle::Atomic32 g_min_log_level = LOG_INFO;
+
+}  // namespace internal
+
+namespace {
+
+// The delay of the writer thread when its queue is empty.
+const uint32 kAsyncIdleDelayMs = 1;
+
+// The longest wait of a FATAL message for the queued messages, then for the
+// lock of the sinks.
+const uint32 kFatalWaitDelayMs = 1000;
+
+// A wait without time limit.
+const uint32 kInfiniteDelayMs = static_cast<uint32>(-1);
+
+const char* const kSeverityNames[] = { "INFO", "WARNING", "ERROR", "FATAL" };
+
+// Writes INFO messages verbatim to the standard output and the other messages,
+// prefixed by their severity and location, to the error output. Each message
+// is written with a single stream operation.
+class DefaultLogSink : public LogSink {
+ public:
+  DefaultLogSink() { }
+
+  virtual void Send(LogSeverity severity, const char* file, int line,
+                    const std::string& message) OVERRIDE {
+    if (severity == LOG_INFO) {
+      std::cout << message;
+      return;
+    }
+
+    std::ostringstream formatted;
+    formatted << kSeverityNames[severity] << "(" << file << ":" << line
+              << "): " << message << '\n';
+    std::cerr << formatted.str();
+  }
+
+  virtual void Flush() OVERRIDE {
+    std::cout.flush();
+    std::cerr.flush();
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DefaultLogSink);
+};
+
+DefaultLogSink default_sink;
+
+// The current sink, or NULL for the default sink.
+void* volatile current_sink = NULL;
+
+// Serializes the calls to the sinks.
+Lock sink_lock;
+
+// Number of messages dropped by the asynchronous queue.
+subtle::Atomic32 dropped_messages = 0;
+
+LogSink* CurrentSink() {
+  void* sink = subtle::Acquire_LoadPointer(&current_sink);
+  if (sink == NULL)
+    return &default_sink;
+  return static_cast<LogSink*>(sink);
+}
+
+// A bounded multiple-producers queue of log messages. The producers never
+// block: a slot is reserved with a compare-and-swap and published by its
+// sequence number. The queue is drained by a single consumer.
+class AsyncLogQueue {
+ public:
+  struct Record {
+    LogSeverity severity;
+    const char* file;
+    int line;
+    std::string message;
+  };
+
+  explicit AsyncLogQueue(size_t capacity)
+      : enqueue_position_(0),
+        dequeue_position_(0) {
+    size_t size = 2;
+    while (size < capacity)
+      size <<= 1;
+    cells_.resize(size);
+    mask_ = static_cast<uint32>(size - 1);
+    for (uint32 i = 0; i < size; ++i)
+      subtle::NoBarrier_Store(&cells_[i].sequence, static_cast<int32>(i));
+  }
+
+  // Pushes a message. The content of @p message is swapped into the queue.
+  // @returns false if the queue is full.
+  bool Push(LogSeverity severity, const char* file, int line,
+            std::string* message) {
+    Cell* cell = NULL;
+    uint32 position = static_cast<uint32>(
+        subtle::NoBarrier_Load(&enqueue_position_));
+    for (;;) {
+      cell = &cells_[position & mask_];
+      uint32 sequence = static_cast<uint32>(
+          subtle::Acquire_Load(&cell->sequence));
+      int32 difference = static_cast<int32>(sequence - position);
+      if (difference == 0) {
+        uint32 previous = static_cast<uint32>(subtle::Acquire_CompareAndSwap(
+            &enqueue_position_, static_cast<int32>(position),
+            static_cast<int32>(position + 1)));
+        if (previous == position)
+          break;
+        position = previous;
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = static_cast<uint32>(
+            subtle::NoBarrier_Load(&enqueue_position_));
+      }
+    }
+
+    cell->record.severity = severity;
+    cell->record.file = file;
+    cell->record.line = line;
+    cell->record.message.swap(*message);
+    subtle::Release_Store(&cell->sequence, static_cast<int32>(position + 1));
+    return true;
+  }
+
+  // Pops the oldest message. Must only be called by the consumer.
+  // @returns false if the queue is empty.
+  bool Pop(Record* record) {
+    Cell* cell = &cells_[dequeue_position_ & mask_];
+    uint32 sequence = static_cast<uint32>(
+        subtle::Acquire_Load(&cell->sequence));
+    if (static_cast<int32>(sequence - (dequeue_position_ + 1)) < 0)
+      return false;
+
+    record->severity = cell->record.severity;
+    record->file = cell->record.file;
+    record->line = cell->record.line;
+    record->message.swap(cell->record.message);
+    cell->record.message.clear();
+    subtle::Release_Store(&cell->sequence,
+                          static_cast<int32>(dequeue_position_ + mask_ + 1));
+    ++dequeue_position_;
+    return true;
+  }
+
+  // @returns the number of messages pushed so far (modulo 2^32).
+  uint32 pushed() const {
+    return static_cast<uint32>(subtle::Acquire_Load(&enqueue_position_));
+  }
+
+ private:
+  struct Cell {
+    Cell() : sequence(0) { }
+    subtle::Atomic32 sequence;
+    Record record;
+  };
+
+  std::vector<Cell> cells_;
+  uint32 mask_;
+  subtle::Atomic32 enqueue_position_;
+  uint32 dequeue_position_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncLogQueue);
+};
+
+// The background thread writing the queued messages to the sink.
+class AsyncLogWriter : public Thread::Delegate {
+ public:
+  explicit AsyncLogWriter(size_t capacity)
+      : queue_(capacity),
+        written_(0),
+        reported_dropped_(static_cast<uint32>(
+            subtle::NoBarrier_Load(&dropped_messages))),
+        stop_(0) {
+  }
+
+  bool Push(LogSeverity severity, const char* file, int line,
+            std::string* message) {
+    return queue_.Push(severity, file, line, message);
+  }
+
+  void RequestStop() {
+    subtle::Release_Store(&stop_, 1);
+  }
+
+  // Waits until all the messages pushed before the call are written.
+  // @param timeout_ms the longest wait, or kInfiniteDelayMs.
+  // @returns true if the messages are written, false on timeout.
+  bool WaitUntilWritten(uint32 timeout_ms) {
+    uint32 target = queue_.pushed();
+    uint32 waited_ms = 0;
+    while (static_cast<int32>(
+               target - static_cast<uint32>(subtle::Acquire_Load(&written_)))
+           > 0) {
+      if (timeout_ms != kInfiniteDelayMs && waited_ms >= timeout_ms)
+        return false;
+      Thread::Sleep(kAsyncIdleDelayMs);
+      waited_ms += kAsyncIdleDelayMs;
+    }
+    return true;
+  }
+
+  virtual void Run() OVERRIDE {
+    AsyncLogQueue::Record record;
+    for (;;) {
+      // Write the pending messages by batch, under a single lock.
+      bool has_written = false;
+      {
+        AutoLock lock(sink_lock);
+        LogSink* sink = CurrentSink();
+        while (queue_.Pop(&record)) {
+          sink->Send(record.severity, record.file, record.line,
+                     record.message);
+          subtle::Release_Store(
+              &written_,
+              static_cast<int32>(
+                  static_cast<uint32>(subtle::NoBarrier_Load(&written_)) + 1));
+          has_written = true;
+        }
+        ReportDroppedMessages(sink);
+        if (has_written)
+          sink->Flush();
+      }
+
+      if (!has_written) {
+        if (subtle::Acquire_Load(&stop_) != 0)
+          return;
+        Thread::Sleep(kAsyncIdleDelayMs);
+      }
+    }
+  }
+
+ private:
+  void ReportDroppedMessages(LogSink* sink) {
+    uint32 dropped = static_cast<uint32>(
+        subtle::NoBarrier_Load(&dropped_messages));
+    if (dropped == reported_dropped_)
+      return;
+    std::ostringstream message;
+    message << (dropped - reported_dropped_) << " log messages dropped.";
+    sink->Send(LOG_WARNING, __FILE__, __LINE__, message.str());
+    reported_dropped_ = dropped;
+  }
+
+  AsyncLogQueue queue_;
+  subtle::Atomic32 written_;
+  uint32 reported_dropped_;
+  subtle::Atomic32 stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncLogWriter);
+};
+
+// The running asynchronous writer, or NULL.
+void* volatile async_writer = NULL;
+Thread* async_thread = NULL;
+
+AsyncLogWriter* CurrentAsyncWriter() {
+  return static_cast<AsyncLogWriter*>(
+      subtle::Acquire_LoadPointer(&async_writer));
+}
+
+}  // namespace
+
+LogSink* SetLogSink(LogSink* sink) {
+  AutoLock lock(sink_lock);
+  LogSink* previous =
+      static_cast<LogSink*>(subtle::Acquire_LoadPointer(&current_sink));
+  subtle::Release_StorePointer(&current_sink, sink);
+  return previous;
+}
+
+void SetMinLogLevel(LogSeverity severity) {
+  if (severity > LOG_FATAL)
+    severity = LOG_FATAL;
+  subtle::NoBarrier_Store(&internal::g_min_log_level, severity);
+}
+
+bool StartAsyncLogging(size_t queue_capacity) {
+  if (CurrentAsyncWriter() != NULL)
+    return false;
+
+  AsyncLogWriter* writer = new AsyncLogWriter(queue_capacity);
+  Thread* thread = new Thread(writer);
+  if (!thread->Start()) {
+    delete thread;
+    delete writer;
+    return false;
+  }
+
+  async_thread = thread;
+  subtle::Release_StorePointer(&async_writer, writer);
+  return true;
+}
+
+void StopAsyncLogging() {
+  AsyncLogWriter* writer = CurrentAsyncWriter();
+  if (writer == NULL)
+    return;
+
+  // New messages are written synchronously from now on.
+  subtle::Release_StorePointer(&async_writer, NULL);
+
+  writer->RequestStop();
+  async_thread->Join();
+  delete async_thread;
+  async_thread = NULL;
+  delete writer;
+}
+
+void FlushLogs() {
+  AsyncLogWriter* writer = CurrentAsyncWriter();
+  if (writer != NULL)
+    writer->WaitUntilWritten(kInfiniteDelayMs);
+
+  AutoLock lock(sink_lock);
+  CurrentSink()->Flush();
+}
+
+uint32 GetDroppedLogMessageCount() {
+  return static_cast<uint32>(subtle::NoBarrier_Load(&dropped_messages));
+}
+
 LogMessage::~LogMessage() {
-  // TODO(etienneb): Implements a clever logging dispatch.
-  switch (severity_) {
-    case LOG_INFO:
-      std::cout << stream_.str();
-      break;
-    case LOG_WARNING:
-      std::cerr << "WARNING(" << file_ << ":" << line_ << "): "
-                << stream_.str() << std::endl;
-      break;
-    case LOG_ERROR:
-      std::cerr << "ERROR(" << file_ << ":" << line_ << "): "
-                << stream_.str() << std::endl;
-      break;
-    case LOG_FATAL:
-      std::cerr << "FATAL(" << file_ << ":" << line_ << "): "
-                << stream_.str() << std::endl;
-      exit(-1);  // TODO(etienneb): Do we really want this?
-      break;
+  if (severity_ == LOG_FATAL) {
+    // Keep the order of the messages: wait for the queued ones to be written.
+    AsyncLogWriter* writer = CurrentAsyncWriter();
+    if (writer != NULL)
+      writer->WaitUntilWritten(kFatalWaitDelayMs);
+
+    // Take the lock of the sinks, so that this message is not written while
+    // the writer thread or another thread calls the sink. The lock is only
+    // tried, and the message is written without it after a delay: the
+    // failure may come from the lock itself, from a sink called under the
+    // lock on this thread, or from a thread stuck while holding it. The
+    // writer thread is not stopped: joining it would never return if the
+    // failure comes from the writer thread.
+    bool locked = sink_lock.Try();
+    for (uint32 waited_ms = 0; !locked && waited_ms < kFatalWaitDelayMs;
+         waited_ms += kAsyncIdleDelayMs) {
+      Thread::Sleep(kAsyncIdleDelayMs);
+      locked = sink_lock.Try();
+    }
+
+    LogSink* sink = CurrentSink();
+    sink->Send(severity_, file_, line_, stream_.str());
+    sink->Flush();
+    if (locked)
+      sink_lock.Release();
+    exit(-1);  // TODO(etienneb): Do we really want this?
   }
+
+  AsyncLogWriter* writer = CurrentAsyncWriter();
+  if (writer != NULL) {
+    std::string message(stream_.str());
+    if (!writer->Push(severity_, file_, line_, &message))
+      subtle::NoBarrier_AtomicIncrement(&dropped_messages, 1);
+    return;
+  }
+
+  AutoLock lock(sink_lock);
+  CurrentSink()->Send(severity_, file_, line_, stream_.str());
 }
 
 }  // namespace base
@@ -23,12 +23,34 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+//
+// Logging facilities.
+//
+//   LOG(WARNING) << "Unable to decode payload.";
+//   LOG_EVERY_N(WARNING, 1000) << "Skipped an unknown event.";
+//   LOG_FIRST_N(ERROR, 10) << "Unsupported event.";
+//
+// A message whose severity is below the minimum log level is discarded
+// before its arguments are evaluated. The minimum level is set at runtime by
+// SetMinLogLevel and can be raised at compile time by defining
+// LOGGING_MIN_SEVERITY (up to base::LOG_FATAL), in which case the filtered
+// statements are removed by the compiler.
+//
+// Messages are sent synchronously to the current LogSink, which writes to the
+// standard streams by default. StartAsyncLogging moves the formatting and the
+// writing of the messages to a background thread: the logging thread only
+// pushes the message into a bounded lock-free queue. Messages are dropped
+// (and counted) when the queue is full. FATAL messages are always written
+// synchronously, after the pending messages have been flushed.
+
 #ifndef BASE_LOGGING_H_
 #define BASE_LOGGING_H_
 
 #include <cstdlib>
 #include <sstream>
+#include <string>
 
+#include "base/atomicops.h"
 #include "base/base.h"
 
 namespace base {
@@ -40,6 +62,66 @@ enum LogSeverity {
   LOG_FATAL
 };
 
+#ifndef LOGGING_MIN_SEVERITY
+#define LOGGING_MIN_SEVERITY base::LOG_INFO
+#endif
+
+// Receives the log messages. A sink is called by a single thread at a time.
+class LogSink {
+ public:
+  virtual ~LogSink() { }
+
+  // Writes a message.
+  // @param severity the severity of the message.
+  // @param file the source file of the log statement.
+  // @param line the source line of the log statement.
+  // @param message the text of the message.
+  virtual void Send(LogSeverity severity, const char* file, int line,
+                    const std::string& message) = 0;
+
+  // Flushes the messages buffered by the sink, if any.
+  virtual void Flush() { }
+};
+
+// Sets the sink receiving the log messages.
+// @param sink the new sink, or NULL to restore the default sink. The sink is
+//     not owned and must outlive its use.
+// @returns the previous sink, or NULL if it was the default sink.
+LogSink* SetLogSink(LogSink* sink);
+
+namespace internal {
+extern subtle::Atomic32 g_min_log_level;
+}  // namespace internal
+
+// Sets the minimum severity of the messages to keep. FATAL messages are never
+// discarded.
+void SetMinLogLevel(LogSeverity severity);
+
+// @returns the minimum severity of the messages to keep.
+inline LogSeverity GetMinLogLevel() {
+  return static_cast<LogSeverity>(
+      subtle::NoBarrier_Load(&internal::g_min_log_level));
+}
+
+// Starts the background writer thread. Must not be called concurrently with
+// StopAsyncLogging.
+// @param queue_capacity the maximal number of pending messages, rounded up to
+//     a power of two.
+// @returns true on success, false if asynchronous logging was already started
+//     or the writer thread cannot be created.
+bool StartAsyncLogging(size_t queue_capacity);
+
+// Writes all the pending messages and stops the background writer thread.
+// Must not be called while other threads are logging.
+void StopAsyncLogging();
+
+// Waits until all pending messages have been written and flushes the sink.
+void FlushLogs();
+
+// @returns the number of messages dropped because the asynchronous queue was
+//     full.
+uint32 GetDroppedLogMessageCount();
+
 class LogMessage {
  public:
   LogMessage(LogSeverity severity, const char* file, int line)
@@ -59,9 +141,66 @@ class LogMessage {
   DISALLOW_COPY_AND_ASSIGN(LogMessage);
 };
 
-#define LOG(severity) \
+// Used to turn the stream expression of LOG into a void expression. The
+// operator & binds looser than << and tighter than ?:.
+class LogMessageVoidify {
+ public:
+  LogMessageVoidify() { }
+  void operator&(std::ostream&) { }
+};
+
+namespace internal {
+
+namespace {
+// Distinguishes the call sites of different translation units that are on the
+// same line.
+struct LogSiteTag {};
+}  // namespace
+
+// Per call site counters of the rate-limited macros. Each instantiation owns a
+// function-local counter, so the macros expand to a single expression.
+template <typename Tag, int line>
+bool ShouldLogEveryN(int32 n) {
+  static subtle::Atomic32 occurrences = 0;
+  uint32 count = static_cast<uint32>(
+      subtle::NoBarrier_AtomicIncrement(&occurrences, 1));
+  return n <= 1 || (count - 1) % static_cast<uint32>(n) == 0;
+}
+
+template <typename Tag, int line>
+bool ShouldLogFirstN(int32 n) {
+  static subtle::Atomic32 occurrences = 0;
+  if (subtle::NoBarrier_Load(&occurrences) >= n)
+    return false;
+  return subtle::NoBarrier_AtomicIncrement(&occurrences, 1) <= n;
+}
+
+}  // namespace internal
+
+#define LOG_IS_ON(severity) \
+    (base::LOG_ ## severity >= LOGGING_MIN_SEVERITY && \
+     base::LOG_ ## severity >= base::GetMinLogLevel())
+
+#define LOG_STREAM(severity) \
     base::LogMessage(base::LOG_ ## severity, __FILE__, __LINE__).stream()
 
+#define LAZY_STREAM(stream, condition) \
+    !(condition) ? (void) 0 : base::LogMessageVoidify() & (stream)
+
+#define LOG(severity) LAZY_STREAM(LOG_STREAM(severity), LOG_IS_ON(severity))
+
+// Logs the 1st, (n+1)th, (2n+1)th... occurrences of a statement.
+#define LOG_EVERY_N(severity, n) \
+    LAZY_STREAM(LOG_STREAM(severity), (LOG_IS_ON(severity) && \
+        base::internal::ShouldLogEveryN< \
+            base::internal::LogSiteTag, __LINE__>(n)))
+
+// Logs the n first occurrences of a statement.
+#define LOG_FIRST_N(severity, n) \
+    LAZY_STREAM(LOG_STREAM(severity), (LOG_IS_ON(severity) && \
+        base::internal::ShouldLogFirstN< \
+            base::internal::LogSiteTag, __LINE__>(n)))
+
 #ifndef NDEBUG
 #define DCHECK(cond) if (!(cond)) LOG(FATAL) << "'" << #cond << "' failed.\n"
 #else
@@ -24,11 +24,248 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "base/logging.h"
+
+#include <string>
+#include <vector>
+
+#include "base/lock.h"
+#include "base/thread.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace base {
 
-// TODO(etienneb): Implement unittest for logging.
+namespace {
+
+class RecordingLogSink : public LogSink {
+ public:
+  RecordingLogSink() : gate_(NULL), flushes_(0) { }
+
+  virtual void Send(LogSeverity severity, const char* file, int line,
+                    const std::string& message) OVERRIDE {
+    if (gate_ != NULL) {
+      gate_->Acquire();
+      gate_->Release();
+    }
+    AutoLock lock(lock_);
+    severities_.push_back(severity);
+    messages_.push_back(message);
+  }
+
+  virtual void Flush() OVERRIDE {
+    AutoLock lock(lock_);
+    ++flushes_;
+  }
+
+  // Blocks the calls to Send while @p gate is held.
+  void set_gate(Lock* gate) { gate_ = gate; }
+
+  size_t size() {
+    AutoLock lock(lock_);
+    return messages_.size();
+  }
+
+  std::string message(size_t index) {
+    AutoLock lock(lock_);
+    return messages_[index];
+  }
+
+  LogSeverity severity(size_t index) {
+    AutoLock lock(lock_);
+    return severities_[index];
+  }
+
+  int flushes() {
+    AutoLock lock(lock_);
+    return flushes_;
+  }
+
+ private:
+  Lock lock_;
+  Lock* gate_;
+  std::vector<LogSeverity> severities_;
+  std::vector<std::string> messages_;
+  int flushes_;
+};
+
+class LoggingTest : public testing::Test {
+ public:
+  virtual void SetUp() OVERRIDE {
+    SetLogSink(&sink_);
+  }
+
+  virtual void TearDown() OVERRIDE {
+    StopAsyncLogging();
+    SetMinLogLevel(LOG_INFO);
+    SetLogSink(NULL);
+  }
+
+ protected:
+  RecordingLogSink sink_;
+};
+
+int evaluations = 0;
+
+int CountEvaluation() {
+  return ++evaluations;
+}
+
+class LoggingWorker : public Thread::Delegate {
+ public:
+  explicit LoggingWorker(int messages) : messages_(messages) { }
+
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < messages_; ++i)
+      LOG(WARNING) << "message " << i;
+  }
+
+ private:
+  int messages_;
+};
+
+}  // namespace
+
+TEST_F(LoggingTest, SendToSink) {
+  LOG(WARNING) << "Hello " << 42;
+  LOG(ERROR) << "Error";
+
+  ASSERT_EQ(2U, sink_.size());
+  EXPECT_EQ(LOG_WARNING, sink_.severity(0));
+  EXPECT_EQ("Hello 42", sink_.message(0));
+  EXPECT_EQ(LOG_ERROR, sink_.severity(1));
+  EXPECT_EQ("Error", sink_.message(1));
+}
+
+TEST_F(LoggingTest, SetLogSink) {
+  RecordingLogSink other;
+  EXPECT_EQ(&sink_, SetLogSink(&other));
+  LOG(WARNING) << "other";
+  EXPECT_EQ(&other, SetLogSink(&sink_));
+
+  EXPECT_EQ(0U, sink_.size());
+  ASSERT_EQ(1U, other.size());
+  EXPECT_EQ("other", other.message(0));
+}
+
+TEST_F(LoggingTest, MinLogLevel) {
+  EXPECT_EQ(LOG_INFO, GetMinLogLevel());
+  SetMinLogLevel(LOG_ERROR);
+  EXPECT_EQ(LOG_ERROR, GetMinLogLevel());
+
+  evaluations = 0;
+  LOG(WARNING) << "filtered " << CountEvaluation();
+  EXPECT_EQ(0, evaluations);
+  EXPECT_EQ(0U, sink_.size());
+
+  LOG(ERROR) << "kept " << CountEvaluation();
+  EXPECT_EQ(1, evaluations);
+  ASSERT_EQ(1U, sink_.size());
+  EXPECT_EQ("kept 1", sink_.message(0));
+}
+
+TEST_F(LoggingTest, MinLogLevelNeverFiltersFatal) {
+  SetMinLogLevel(static_cast<LogSeverity>(LOG_FATAL + 1));
+  EXPECT_EQ(LOG_FATAL, GetMinLogLevel());
+}
+
+TEST_F(LoggingTest, LogEveryN) {
+  for (int i = 0; i < 10; ++i) {
+    LOG_EVERY_N(WARNING, 3) << i;
+  }
+
+  ASSERT_EQ(4U, sink_.size());
+  EXPECT_EQ("0", sink_.message(0));
+  EXPECT_EQ("3", sink_.message(1));
+  EXPECT_EQ("6", sink_.message(2));
+  EXPECT_EQ("9", sink_.message(3));
+}
+
+TEST_F(LoggingTest, LogFirstN) {
+  for (int i = 0; i < 10; ++i) {
+    LOG_FIRST_N(WARNING, 2) << i;
+  }
+
+  ASSERT_EQ(2U, sink_.size());
+  EXPECT_EQ("0", sink_.message(0));
+  EXPECT_EQ("1", sink_.message(1));
+}
+
+TEST_F(LoggingTest, RateLimitedMacrosAreSingleStatements) {
+  for (int i = 0; i < 4; ++i) {
+    if (i % 2 == 0)
+      LOG_EVERY_N(WARNING, 1) << "even " << i;
+    else
+      LOG_FIRST_N(WARNING, 1) << "odd " << i;
+  }
+
+  ASSERT_EQ(3U, sink_.size());
+  EXPECT_EQ("even 0", sink_.message(0));
+  EXPECT_EQ("odd 1", sink_.message(1));
+  EXPECT_EQ("even 2", sink_.message(2));
+}
+
+TEST_F(LoggingTest, AsyncLogging) {
+  EXPECT_TRUE(StartAsyncLogging(1024));
+  EXPECT_FALSE(StartAsyncLogging(1024));
+
+  const int kThreads = 4;
+  const int kMessages = 200;
+  LoggingWorker worker(kMessages);
+  std::vector<Thread*> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(new Thread(&worker));
+    EXPECT_TRUE(threads.back()->Start());
+  }
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  FlushLogs();
+  EXPECT_EQ(static_cast<size_t>(kThreads * kMessages), sink_.size());
+  EXPECT_LT(0, sink_.flushes());
+
+  StopAsyncLogging();
+  LOG(WARNING) << "synchronous";
+  EXPECT_EQ(static_cast<size_t>(kThreads * kMessages + 1), sink_.size());
+}
+
+TEST_F(LoggingTest, AsyncLoggingPreservesOrder) {
+  EXPECT_TRUE(StartAsyncLogging(16));
+  for (int i = 0; i < 100; ++i) {
+    LOG(WARNING) << i;
+    if (i % 8 == 0)
+      FlushLogs();
+  }
+  StopAsyncLogging();
+
+  ASSERT_EQ(100U, sink_.size());
+  EXPECT_EQ("0", sink_.message(0));
+  EXPECT_EQ("99", sink_.message(99));
+}
+
+TEST_F(LoggingTest, AsyncLoggingDropsWhenFull) {
+  uint32 dropped = GetDroppedLogMessageCount();
+
+  Lock gate;
+  sink_.set_gate(&gate);
+  gate.Acquire();
+
+  EXPECT_TRUE(StartAsyncLogging(2));
+  for (int i = 0; i < 100; ++i)
+    LOG(WARNING) << i;
+
+  gate.Release();
+  StopAsyncLogging();
+
+  dropped = GetDroppedLogMessageCount() - dropped;
+  EXPECT_LT(0U, dropped);
+
+  // The messages kept and a report of the dropped messages.
+  ASSERT_EQ(100 - dropped + 1, sink_.size());
+  EXPECT_EQ("0", sink_.message(0));
+  EXPECT_THAT(sink_.message(sink_.size() - 1),
+              testing::HasSubstr("log messages dropped."));
+}
 
 }  // namespace base
@@ -0,0 +1,209 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/memory_mapped_file.h"
+
+#include <limits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "base/string_utils.h"
+
+namespace base {
+
+namespace {
+
+// The address of the data of an empty file. Mapping zero bytes fails on most
+// systems, but an empty file is a valid file.
+const char kEmptyData[1] = { 0 };
+
+// Clamps a region to the end of a file.
+size_t ClampRegion(uint64 file_length, uint64 offset, size_t length) {
+  if (offset >= file_length)
+    return 0;
+  uint64 remaining = file_length - offset;
+  return remaining < length ? static_cast<size_t>(remaining) : length;
+}
+
+}  // namespace
+
+bool MemoryMappedFile::Open(const std::string& path) {
+  return OpenRegion(path, 0, std::numeric_limits<size_t>::max());
+}
+
+#if defined(_WIN32)
+
+MemoryMappedFile::MemoryMappedFile()
+    : data_(NULL),
+      length_(0),
+      file_length_(0),
+      view_(NULL),
+      view_length_(0),
+      file_(INVALID_HANDLE_VALUE),
+      mapping_(NULL) {
+}
+
+bool MemoryMappedFile::OpenRegion(const std::string& path,
+                                  uint64 offset,
+                                  size_t length) {
+  Close();
+
+  std::wstring wide_path = StringToWString(path);
+  file_ = ::CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file_ == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(file_, &size)) {
+    Close();
+    return false;
+  }
+
+  file_length_ = static_cast<uint64>(size.QuadPart);
+  length_ = ClampRegion(file_length_, offset, length);
+  if (length_ == 0) {
+    data_ = kEmptyData;
+    return true;
+  }
+
+  mapping_ = ::CreateFileMappingW(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping_ == NULL) {
+    Close();
+    return false;
+  }
+
+  // The offset of a view must be a multiple of the allocation granularity.
+  SYSTEM_INFO system_info;
+  ::GetSystemInfo(&system_info);
+  uint64 delta = offset % system_info.dwAllocationGranularity;
+  uint64 view_offset = offset - delta;
+  view_length_ = length_ + static_cast<size_t>(delta);
+  view_ = static_cast<const char*>(
+      ::MapViewOfFile(mapping_, FILE_MAP_READ,
+                      static_cast<DWORD>(view_offset >> 32),
+                      static_cast<DWORD>(view_offset),
+                      view_length_));
+  if (view_ == NULL) {
+    Close();
+    return false;
+  }
+
+  data_ = view_ + delta;
+  return true;
+}
+
+void MemoryMappedFile::Close() {
+  if (view_ != NULL)
+    ::UnmapViewOfFile(view_);
+  if (mapping_ != NULL)
+    ::CloseHandle(mapping_);
+  if (file_ != INVALID_HANDLE_VALUE)
+    ::CloseHandle(file_);
+
+  data_ = NULL;
+  length_ = 0;
+  file_length_ = 0;
+  view_ = NULL;
+  view_length_ = 0;
+  mapping_ = NULL;
+  file_ = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MemoryMappedFile::MemoryMappedFile()
+    : data_(NULL),
+      length_(0),
+      file_length_(0),
+      view_(NULL),
+      view_length_(0) {
+}
+
+bool MemoryMappedFile::OpenRegion(const std::string& path,
+                                  uint64 offset,
+                                  size_t length) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return false;
+  }
+
+  file_length_ = static_cast<uint64>(file_stat.st_size);
+  length_ = ClampRegion(file_length_, offset, length);
+  if (length_ == 0) {
+    close(fd);
+    data_ = kEmptyData;
+    return true;
+  }
+
+  // The offset of a mapping must be a multiple of the page size.
+  uint64 delta = offset % static_cast<uint64>(sysconf(_SC_PAGESIZE));
+  view_length_ = length_ + static_cast<size_t>(delta);
+
+  // The mapping stays valid once the descriptor is closed.
+  void* view = mmap(NULL, view_length_, PROT_READ, MAP_PRIVATE, fd,
+                    static_cast<off_t>(offset - delta));
+  close(fd);
+  if (view == MAP_FAILED) {
+    length_ = 0;
+    file_length_ = 0;
+    view_length_ = 0;
+    return false;
+  }
+
+  view_ = static_cast<const char*>(view);
+  data_ = view_ + delta;
+  return true;
+}
+
+void MemoryMappedFile::Close() {
+  if (view_ != NULL)
+    munmap(const_cast<char*>(view_), view_length_);
+  data_ = NULL;
+  length_ = 0;
+  file_length_ = 0;
+  view_ = NULL;
+  view_length_ = 0;
+}
+
+#endif
+
+MemoryMappedFile::~MemoryMappedFile() {
+  Close();
+}
+
+}  // namespace base
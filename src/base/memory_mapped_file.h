@@ -0,0 +1,110 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// A read-only memory mapping of a whole file. The pages are loaded on demand
+// by the OS, so a parser can walk a large file without copying it:
+//
+//   MemoryMappedFile file;
+//   if (!file.Open("trace.bin"))
+//     return false;
+//   Consume(file.data(), file.length());
+//
+// A file larger than the address space, or than the memory that should be
+// committed to it, is walked by mapping a window at a time:
+//
+//   file.OpenRegion("trace.bin", offset, kWindowSize);
+
+#ifndef BASE_MEMORY_MAPPED_FILE_H_
+#define BASE_MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+#if defined(_WIN32)
+// Restrict the import to the windows basic includes.
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  // NOLINT
+#endif
+
+#include "base/base.h"
+
+namespace base {
+
+class MemoryMappedFile {
+ public:
+  MemoryMappedFile();
+  ~MemoryMappedFile();
+
+  // Maps a file. A file already mapped is closed first.
+  // @param path the path of the file to map.
+  // @returns true on success, false otherwise.
+  bool Open(const std::string& path);
+
+  // Maps a region of a file. A file already mapped is closed first. The
+  // region is clamped to the end of the file, and is empty past its end.
+  // @param path the path of the file to map.
+  // @param offset the offset of the region in the file, in bytes.
+  // @param length the maximal length of the region, in bytes.
+  // @returns true on success, false otherwise.
+  bool OpenRegion(const std::string& path, uint64 offset, size_t length);
+
+  // Unmaps the file. Does nothing if no file is mapped.
+  void Close();
+
+  // @returns true if a file is mapped.
+  bool IsValid() const { return data_ != NULL; }
+
+  // @returns the first byte of the file, or NULL if no file is mapped. An
+  //     empty file is valid but has no data.
+  const char* data() const { return data_; }
+
+  // @returns the length of the mapped region, in bytes.
+  size_t length() const { return length_; }
+
+  // @returns the length of the whole file, in bytes.
+  uint64 file_length() const { return file_length_; }
+
+ private:
+  const char* data_;
+  size_t length_;
+  uint64 file_length_;
+
+  // The mapping starts at an offset aligned on the allocation granularity,
+  // at or before |data_|.
+  const char* view_;
+  size_t view_length_;
+
+#if defined(_WIN32)
+  HANDLE file_;
+  HANDLE mapping_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+};
+
+}  // namespace base
+
+#endif  // BASE_MEMORY_MAPPED_FILE_H_
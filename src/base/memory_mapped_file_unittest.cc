@@ -0,0 +1,119 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/memory_mapped_file.h"
+
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const char kTempFile[] = "memory_mapped_file_unittest.tmp";
+
+class MemoryMappedFileTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  void WriteTempFile(const std::string& content) {
+    FILE* file = std::fopen(kTempFile, "wb");
+    ASSERT_TRUE(file != NULL);
+    if (!content.empty())
+      std::fwrite(content.data(), 1, content.size(), file);
+    std::fclose(file);
+  }
+};
+
+}  // namespace
+
+TEST_F(MemoryMappedFileTest, Open) {
+  WriteTempFile("Hello, world!");
+
+  MemoryMappedFile file;
+  EXPECT_FALSE(file.IsValid());
+  ASSERT_TRUE(file.Open(kTempFile));
+  EXPECT_TRUE(file.IsValid());
+  ASSERT_EQ(13U, file.length());
+  EXPECT_EQ(13U, file.file_length());
+  EXPECT_EQ("Hello, world!", std::string(file.data(), file.length()));
+
+  file.Close();
+  EXPECT_FALSE(file.IsValid());
+  EXPECT_EQ(0U, file.length());
+}
+
+TEST_F(MemoryMappedFileTest, OpenEmpty) {
+  WriteTempFile("");
+
+  MemoryMappedFile file;
+  ASSERT_TRUE(file.Open(kTempFile));
+  EXPECT_TRUE(file.IsValid());
+  EXPECT_EQ(0U, file.length());
+}
+
+TEST_F(MemoryMappedFileTest, OpenMissing) {
+  MemoryMappedFile file;
+  EXPECT_FALSE(file.Open("memory_mapped_file_unittest.missing"));
+  EXPECT_FALSE(file.IsValid());
+}
+
+TEST_F(MemoryMappedFileTest, Reopen) {
+  WriteTempFile("abc");
+
+  MemoryMappedFile file;
+  ASSERT_TRUE(file.Open(kTempFile));
+  ASSERT_TRUE(file.Open(kTempFile));
+  EXPECT_EQ("abc", std::string(file.data(), file.length()));
+}
+
+TEST_F(MemoryMappedFileTest, OpenRegion) {
+  // A region crossing a page boundary, at an unaligned offset.
+  std::string content(10000, 'x');
+  content.replace(4090, 12, "Hello, world");
+  WriteTempFile(content);
+
+  MemoryMappedFile file;
+  ASSERT_TRUE(file.OpenRegion(kTempFile, 4090, 12));
+  EXPECT_EQ(12U, file.length());
+  EXPECT_EQ(10000U, file.file_length());
+  EXPECT_EQ("Hello, world", std::string(file.data(), file.length()));
+
+  // The region is clamped to the end of the file.
+  ASSERT_TRUE(file.OpenRegion(kTempFile, 9998, 100));
+  EXPECT_EQ("xx", std::string(file.data(), file.length()));
+
+  // A region past the end of the file is empty.
+  ASSERT_TRUE(file.OpenRegion(kTempFile, 20000, 100));
+  EXPECT_TRUE(file.IsValid());
+  EXPECT_EQ(0U, file.length());
+  EXPECT_EQ(10000U, file.file_length());
+}
+
+}  // namespace base
@@ -0,0 +1,88 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Helpers for the perftests. A perftest is a regular gtest test that measures
+// the duration of a loop and reports it on the standard output:
+//
+//   base::PerfTimer timer;
+//   for (size_t i = 0; i < kIterations; ++i)
+//     DoWork();
+//   base::PrintPerfResult("DoWork", "time", timer.ElapsedNanoseconds(),
+//                         kIterations, "ns/iteration");
+//
+// which prints:
+//
+//   *RESULT DoWork: time= 12.5 ns/iteration
+
+#ifndef BASE_PERF_TEST_H_
+#define BASE_PERF_TEST_H_
+
+#include <iostream>
+#include <string>
+
+#include "base/base.h"
+#include "base/time.h"
+
+namespace base {
+
+// Measures the wall time elapsed since its construction.
+class PerfTimer {
+ public:
+  PerfTimer() : start_(NowNanoseconds()) { }
+
+  // Restarts the measure.
+  void Reset() { start_ = NowNanoseconds(); }
+
+  // @returns the number of nanoseconds elapsed since the last reset.
+  uint64 ElapsedNanoseconds() const { return NowNanoseconds() - start_; }
+
+ private:
+  uint64 start_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfTimer);
+};
+
+// Prints a perftest result.
+// @param test the name of the measured operation.
+// @param measurement the name of the measure.
+// @param total the total measured for all the iterations.
+// @param iterations the number of iterations.
+// @param unit the unit of a single iteration.
+inline void PrintPerfResult(const std::string& test,
+                            const std::string& measurement,
+                            uint64 total,
+                            size_t iterations,
+                            const std::string& unit) {
+  double value = static_cast<double>(total);
+  if (iterations != 0)
+    value /= static_cast<double>(iterations);
+  std::cout << "*RESULT " << test << ": " << measurement << "= " << value
+            << " " << unit << std::endl;
+}
+
+}  // namespace base
+
+#endif  // BASE_PERF_TEST_H_
@@ -0,0 +1,121 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/thread.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+#if defined(_WIN32)
+DWORD WINAPI ThreadMain(LPVOID param) {
+  static_cast<Thread::Delegate*>(param)->Run();
+  return 0;
+}
+#else
+void* ThreadMain(void* param) {
+  static_cast<Thread::Delegate*>(param)->Run();
+  return NULL;
+}
+#endif
+
+}  // namespace
+
+Thread::Thread(Delegate* delegate)
+    : delegate_(delegate),
+      started_(false) {
+  DCHECK(delegate != NULL);
+}
+
+Thread::~Thread() {
+  DCHECK(!started_);
+}
+
+#if defined(_WIN32)
+
+bool Thread::Start() {
+  DCHECK(!started_);
+  handle_ = ::CreateThread(NULL, 0, &ThreadMain, delegate_, 0, NULL);
+  if (handle_ == NULL)
+    return false;
+  started_ = true;
+  return true;
+}
+
+void Thread::Join() {
+  if (!started_)
+    return;
+  ::WaitForSingleObject(handle_, INFINITE);
+  ::CloseHandle(handle_);
+  started_ = false;
+}
+
+size_t Thread::NumberOfProcessors() {
+  SYSTEM_INFO info;
+  ::GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+}
+
+void Thread::Sleep(uint32 milliseconds) {
+  ::Sleep(milliseconds);
+}
+
+#else
+
+bool Thread::Start() {
+  DCHECK(!started_);
+  if (pthread_create(&handle_, NULL, &ThreadMain, delegate_) != 0)
+    return false;
+  started_ = true;
+  return true;
+}
+
+void Thread::Join() {
+  if (!started_)
+    return;
+  pthread_join(handle_, NULL);
+  started_ = false;
+}
+
+size_t Thread::NumberOfProcessors() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (count < 1)
+    return 1;
+  return static_cast<size_t>(count);
+}
+
+void Thread::Sleep(uint32 milliseconds) {
+  usleep(static_cast<useconds_t>(milliseconds) * 1000);
+}
+
+#endif
+
+}  // namespace base
@@ -0,0 +1,102 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// A minimal portable thread. The work executed by the thread is provided by a
+// delegate, which must outlive the thread.
+//
+//   class Worker : public base::Thread::Delegate {
+//    public:
+//     virtual void Run() OVERRIDE { ... }
+//   };
+//
+//   Worker worker;
+//   base::Thread thread(&worker);
+//   thread.Start();
+//   ...
+//   thread.Join();
+
+#ifndef BASE_THREAD_H_
+#define BASE_THREAD_H_
+
+#if defined(_WIN32)
+// Restrict the import to the windows basic includes.
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  // NOLINT
+#else
+#include <pthread.h>
+#endif
+
+#include "base/base.h"
+
+namespace base {
+
+class Thread {
+ public:
+  // The work executed by a thread.
+  class Delegate {
+   public:
+    virtual ~Delegate() { }
+    virtual void Run() = 0;
+  };
+
+  // Constructor.
+  // @param delegate the work to execute. Must outlive the thread.
+  explicit Thread(Delegate* delegate);
+
+  // Destructor. The thread must have been joined.
+  ~Thread();
+
+  // Starts the execution of the delegate on a new thread.
+  // @returns true if the thread has been started, false otherwise.
+  bool Start();
+
+  // Waits until the delegate returns. Does nothing if the thread was not
+  // started.
+  void Join();
+
+  // @returns the number of logical processors of the machine.
+  static size_t NumberOfProcessors();
+
+  // Suspends the calling thread.
+  // @param milliseconds the minimal duration of the suspension.
+  static void Sleep(uint32 milliseconds);
+
+ private:
+  Delegate* delegate_;
+  bool started_;
+
+#if defined(_WIN32)
+  HANDLE handle_;
+#else
+  pthread_t handle_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(Thread);
+};
+
+}  // namespace base
+
+#endif  // BASE_THREAD_H_
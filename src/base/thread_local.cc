@@ -0,0 +1,73 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/thread_local.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+#if defined(_WIN32)
+
+ThreadLocalStorageSlot::ThreadLocalStorageSlot(Destructor destructor) {
+  slot_ = ::FlsAlloc(destructor);
+  if (slot_ == FLS_OUT_OF_INDEXES)
+    LOG(FATAL) << "Unable to allocate a thread local storage slot.";
+}
+
+ThreadLocalStorageSlot::~ThreadLocalStorageSlot() {
+  ::FlsFree(slot_);
+}
+
+void* ThreadLocalStorageSlot::Get() const {
+  return ::FlsGetValue(slot_);
+}
+
+void ThreadLocalStorageSlot::Set(void* value) {
+  ::FlsSetValue(slot_, value);
+}
+
+#else
+
+ThreadLocalStorageSlot::ThreadLocalStorageSlot(Destructor destructor) {
+  if (pthread_key_create(&slot_, destructor) != 0)
+    LOG(FATAL) << "Unable to allocate a thread local storage slot.";
+}
+
+ThreadLocalStorageSlot::~ThreadLocalStorageSlot() {
+  pthread_key_delete(slot_);
+}
+
+void* ThreadLocalStorageSlot::Get() const {
+  return pthread_getspecific(slot_);
+}
+
+void ThreadLocalStorageSlot::Set(void* value) {
+  pthread_setspecific(slot_, value);
+}
+
+#endif
+
+}  // namespace base
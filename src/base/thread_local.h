@@ -0,0 +1,137 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef BASE_THREAD_LOCAL_H_
+#define BASE_THREAD_LOCAL_H_
+
+#if defined(_WIN32)
+// Restrict the import to the windows basic includes.
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  // NOLINT
+#else
+#include <pthread.h>
+#endif
+
+#include "base/base.h"
+
+// The calling convention of the thread exit callbacks.
+#if defined(_WIN32)
+#define THREAD_LOCAL_CALLBACK WINAPI
+#else
+#define THREAD_LOCAL_CALLBACK
+#endif
+
+namespace base {
+
+// A slot of thread local storage. Each thread sees its own value, which is
+// initially NULL.
+class ThreadLocalStorageSlot {
+ public:
+  // Called on thread exit with the non-NULL value stored by the exiting thread.
+  typedef void (THREAD_LOCAL_CALLBACK *Destructor)(void* value);
+
+  // @param destructor releases the value of a thread on its exit. May be NULL,
+  //     in which case the slot never owns the stored values.
+  explicit ThreadLocalStorageSlot(Destructor destructor = NULL);
+  ~ThreadLocalStorageSlot();
+
+  // @returns the value stored by the calling thread.
+  void* Get() const;
+
+  // Stores a value for the calling thread.
+  // @param value the value to store.
+  void Set(void* value);
+
+ private:
+#if defined(_WIN32)
+  // A fiber local storage index. Unlike the TLS indexes, it accepts a
+  // callback invoked on thread exit.
+  DWORD slot_;
+#else
+  pthread_key_t slot_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadLocalStorageSlot);
+};
+
+// A typed pointer with a distinct value for each thread.
+template <typename T>
+class ThreadLocalPointer {
+ public:
+  ThreadLocalPointer() { }
+
+  // @returns the pointer stored by the calling thread.
+  T* Get() const {
+    return static_cast<T*>(slot_.Get());
+  }
+
+  // Stores a pointer for the calling thread.
+  // @param value the pointer to store.
+  void Set(T* value) {
+    slot_.Set(value);
+  }
+
+ private:
+  ThreadLocalStorageSlot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadLocalPointer<T>);
+};
+
+// A typed pointer with a distinct value for each thread. The value of a thread
+// is deleted when the thread exits. The pointer must outlive the threads that
+// set a value, which is why it is usually leaked:
+//
+//   static ThreadLocalOwnedPointer<Cache>* cache =
+//       new ThreadLocalOwnedPointer<Cache>;
+template <typename T>
+class ThreadLocalOwnedPointer {
+ public:
+  ThreadLocalOwnedPointer() : slot_(&Delete) { }
+
+  // @returns the pointer stored by the calling thread.
+  T* Get() const {
+    return static_cast<T*>(slot_.Get());
+  }
+
+  // Stores a pointer for the calling thread, which takes its ownership. The
+  // previous value of the thread is not deleted.
+  // @param value the pointer to store.
+  void Set(T* value) {
+    slot_.Set(value);
+  }
+
+ private:
+  static void THREAD_LOCAL_CALLBACK Delete(void* value) {
+    delete static_cast<T*>(value);
+  }
+
+  ThreadLocalStorageSlot slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadLocalOwnedPointer<T>);
+};
+
+}  // namespace base
+
+#endif  // BASE_THREAD_LOCAL_H_
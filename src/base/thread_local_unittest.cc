@@ -0,0 +1,126 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "base/thread_local.h"
+
+#include "base/thread.h"
+#include "gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+class ThreadLocalReader : public Thread::Delegate {
+ public:
+  explicit ThreadLocalReader(ThreadLocalPointer<int>* pointer)
+      : pointer_(pointer), initial_(NULL), value_(0), stored_(NULL) {
+  }
+
+  virtual void Run() OVERRIDE {
+    initial_ = pointer_->Get();
+    pointer_->Set(&value_);
+    stored_ = pointer_->Get();
+  }
+
+  int* initial() const { return initial_; }
+  int* stored() const { return stored_; }
+  int* value() { return &value_; }
+
+ private:
+  ThreadLocalPointer<int>* pointer_;
+  int* initial_;
+  int value_;
+  int* stored_;
+};
+
+// Counts its live instances.
+class Tracked {
+ public:
+  Tracked() { ++instances; }
+  ~Tracked() { --instances; }
+
+  static int instances;
+};
+
+int Tracked::instances = 0;
+
+class OwnedPointerSetter : public Thread::Delegate {
+ public:
+  explicit OwnedPointerSetter(ThreadLocalOwnedPointer<Tracked>* pointer)
+      : pointer_(pointer) {
+  }
+
+  virtual void Run() OVERRIDE {
+    pointer_->Set(new Tracked());
+  }
+
+ private:
+  ThreadLocalOwnedPointer<Tracked>* pointer_;
+};
+
+}  // namespace
+
+TEST(ThreadLocalTest, InitiallyNull) {
+  ThreadLocalPointer<int> pointer;
+  EXPECT_EQ(NULL, pointer.Get());
+}
+
+TEST(ThreadLocalTest, SetGet) {
+  ThreadLocalPointer<int> pointer;
+  int value = 42;
+  pointer.Set(&value);
+  EXPECT_EQ(&value, pointer.Get());
+  pointer.Set(NULL);
+  EXPECT_EQ(NULL, pointer.Get());
+}
+
+TEST(ThreadLocalTest, DistinctPerThread) {
+  ThreadLocalPointer<int> pointer;
+  int value = 42;
+  pointer.Set(&value);
+
+  ThreadLocalReader reader(&pointer);
+  Thread thread(&reader);
+  EXPECT_TRUE(thread.Start());
+  thread.Join();
+
+  EXPECT_EQ(NULL, reader.initial());
+  EXPECT_EQ(reader.value(), reader.stored());
+  EXPECT_EQ(&value, pointer.Get());
+}
+
+TEST(ThreadLocalTest, OwnedPointerDeletedOnThreadExit) {
+  ThreadLocalOwnedPointer<Tracked> pointer;
+  OwnedPointerSetter setter(&pointer);
+
+  Thread thread(&setter);
+  EXPECT_TRUE(thread.Start());
+  thread.Join();
+
+  EXPECT_EQ(0, Tracked::instances);
+  EXPECT_EQ(NULL, pointer.Get());
+}
+
+}  // namespace base
@@ -0,0 +1,376 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "event/serialization.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace event {
+
+namespace {
+
+// The tag of a NULL value. The other tags are the ValueType of the value.
+const unsigned char kNullTag = 0xFF;
+
+// Maps signed integers to unsigned ones so small magnitudes stay short.
+uint64 ZigZagEncode(int64 value) {
+  return (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63);
+}
+
+int64 ZigZagDecode(uint64 value) {
+  return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+}
+
+// Appends the binary form of the visited values.
+class SerializeVisitor : public ValueVisitor {
+ public:
+  explicit SerializeVisitor(std::string* buffer) : buffer_(buffer) {
+    DCHECK(buffer != NULL);
+  }
+
+  virtual void Visit(const BoolValue& value) OVERRIDE {
+    AppendTag(value);
+    buffer_->push_back(value.GetValue() ? 1 : 0);
+  }
+  virtual void Visit(const CharValue& value) OVERRIDE {
+    AppendSigned(value);
+  }
+  virtual void Visit(const UCharValue& value) OVERRIDE {
+    AppendUnsigned(value);
+  }
+  virtual void Visit(const ShortValue& value) OVERRIDE {
+    AppendSigned(value);
+  }
+  virtual void Visit(const UShortValue& value) OVERRIDE {
+    AppendUnsigned(value);
+  }
+  virtual void Visit(const IntValue& value) OVERRIDE {
+    AppendSigned(value);
+  }
+  virtual void Visit(const UIntValue& value) OVERRIDE {
+    AppendUnsigned(value);
+  }
+  virtual void Visit(const LongValue& value) OVERRIDE {
+    AppendSigned(value);
+  }
+  virtual void Visit(const ULongValue& value) OVERRIDE {
+    AppendUnsigned(value);
+  }
+  virtual void Visit(const FloatValue& value) OVERRIDE {
+    AppendRaw(value);
+  }
+  virtual void Visit(const DoubleValue& value) OVERRIDE {
+    AppendRaw(value);
+  }
+
+  virtual void Visit(const StringValue& value) OVERRIDE {
+    AppendTag(value);
+    const std::string& str = value.GetValue();
+    AppendVarint(str.size(), buffer_);
+    buffer_->append(str);
+  }
+
+  virtual void Visit(const WStringValue& value) OVERRIDE {
+    AppendTag(value);
+    const std::wstring& str = value.GetValue();
+    AppendVarint(str.size(), buffer_);
+    for (size_t i = 0; i < str.size(); ++i)
+      AppendVarint(static_cast<uint64>(str[i]), buffer_);
+  }
+
+  virtual void Visit(const ArrayValue& value) OVERRIDE {
+    AppendTag(value);
+    AppendVarint(value.Length(), buffer_);
+    ArrayValue::const_iterator it = value.values_begin();
+    for (; it != value.values_end(); ++it)
+      (*it)->Accept(this);
+  }
+
+  virtual void Visit(const StructValue& value) OVERRIDE {
+    AppendTag(value);
+    AppendVarint(value.fields_end() - value.fields_begin(), buffer_);
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end(); ++it) {
+      AppendVarint(it->first.size(), buffer_);
+      buffer_->append(it->first.data(), it->first.size());
+      it->second->Accept(this);
+    }
+  }
+
+ private:
+  void AppendTag(const Value& value) {
+    buffer_->push_back(static_cast<char>(value.GetType()));
+  }
+
+  template <class T>
+  void AppendSigned(const T& value) {
+    AppendTag(value);
+    AppendVarint(ZigZagEncode(value.GetValue()), buffer_);
+  }
+
+  template <class T>
+  void AppendUnsigned(const T& value) {
+    AppendTag(value);
+    AppendVarint(value.GetValue(), buffer_);
+  }
+
+  template <class T>
+  void AppendRaw(const T& value) {
+    AppendTag(value);
+    typename T::ScalarType raw = value.GetValue();
+    buffer_->append(reinterpret_cast<const char*>(&raw), sizeof(raw));
+  }
+
+  std::string* buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SerializeVisitor);
+};
+
+// Decodes values from a range of bytes.
+class Deserializer {
+ public:
+  Deserializer(const char* data, const char* end)
+      : data_(data), end_(end) {
+  }
+
+  const char* data() const { return data_; }
+
+  bool Decode(scoped_ptr<Value>* value) {
+    DCHECK(value != NULL);
+
+    if (data_ >= end_)
+      return false;
+    unsigned char tag = static_cast<unsigned char>(*data_++);
+
+    switch (tag) {
+      case kNullTag:
+        value->reset(NULL);
+        return true;
+      case VALUE_BOOL:
+        if (data_ >= end_ || static_cast<unsigned char>(*data_) > 1)
+          return false;
+        value->reset(new BoolValue(*data_++ != 0));
+        return true;
+      case VALUE_CHAR:
+        return DecodeSigned<CharValue>(value);
+      case VALUE_UCHAR:
+        return DecodeUnsigned<UCharValue>(value);
+      case VALUE_SHORT:
+        return DecodeSigned<ShortValue>(value);
+      case VALUE_USHORT:
+        return DecodeUnsigned<UShortValue>(value);
+      case VALUE_INT:
+        return DecodeSigned<IntValue>(value);
+      case VALUE_UINT:
+        return DecodeUnsigned<UIntValue>(value);
+      case VALUE_LONG:
+        return DecodeSigned<LongValue>(value);
+      case VALUE_ULONG:
+        return DecodeUnsigned<ULongValue>(value);
+      case VALUE_FLOAT:
+        return DecodeRaw<FloatValue>(value);
+      case VALUE_DOUBLE:
+        return DecodeRaw<DoubleValue>(value);
+      case VALUE_STRING:
+        return DecodeString(value);
+      case VALUE_WSTRING:
+        return DecodeWString(value);
+      case VALUE_STRUCT:
+        return DecodeStruct(value);
+      case VALUE_ARRAY:
+        return DecodeArray(value);
+    }
+    return false;
+  }
+
+ private:
+  bool ReadLength(uint64* length) {
+    // Every element takes at least one byte.
+    return ReadVarint(&data_, end_, length) &&
+        *length <= static_cast<uint64>(end_ - data_);
+  }
+
+  template <class T>
+  bool DecodeSigned(scoped_ptr<Value>* value) {
+    uint64 encoded = 0;
+    if (!ReadVarint(&data_, end_, &encoded))
+      return false;
+    value->reset(new T(
+        static_cast<typename T::ScalarType>(ZigZagDecode(encoded))));
+    return true;
+  }
+
+  template <class T>
+  bool DecodeUnsigned(scoped_ptr<Value>* value) {
+    uint64 encoded = 0;
+    if (!ReadVarint(&data_, end_, &encoded))
+      return false;
+    value->reset(new T(static_cast<typename T::ScalarType>(encoded)));
+    return true;
+  }
+
+  template <class T>
+  bool DecodeRaw(scoped_ptr<Value>* value) {
+    typename T::ScalarType raw;
+    if (static_cast<size_t>(end_ - data_) < sizeof(raw))
+      return false;
+    memcpy(&raw, data_, sizeof(raw));
+    data_ += sizeof(raw);
+    value->reset(new T(raw));
+    return true;
+  }
+
+  bool DecodeString(scoped_ptr<Value>* value) {
+    uint64 length = 0;
+    if (!ReadLength(&length))
+      return false;
+    value->reset(new StringValue(
+        std::string(data_, static_cast<size_t>(length))));
+    data_ += length;
+    return true;
+  }
+
+  bool DecodeWString(scoped_ptr<Value>* value) {
+    uint64 length = 0;
+    if (!ReadLength(&length))
+      return false;
+    std::wstring str(static_cast<size_t>(length), L'\0');
+    for (size_t i = 0; i < str.size(); ++i) {
+      uint64 c = 0;
+      if (!ReadVarint(&data_, end_, &c))
+        return false;
+      str[i] = static_cast<wchar_t>(c);
+    }
+    value->reset(new WStringValue(str));
+    return true;
+  }
+
+  bool DecodeArray(scoped_ptr<Value>* value) {
+    uint64 length = 0;
+    if (!ReadLength(&length))
+      return false;
+    scoped_ptr<ArrayValue> array(new ArrayValue());
+    for (uint64 i = 0; i < length; ++i) {
+      scoped_ptr<Value> element;
+      if (!Decode(&element) || element.get() == NULL)
+        return false;
+      array->Append(element.Pass());
+    }
+    value->reset(array.release());
+    return true;
+  }
+
+  bool DecodeStruct(scoped_ptr<Value>* value) {
+    uint64 length = 0;
+    if (!ReadLength(&length))
+      return false;
+    scoped_ptr<StructValue> fields(new StructValue());
+    std::string name;
+    for (uint64 i = 0; i < length; ++i) {
+      uint64 name_length = 0;
+      if (!ReadLength(&name_length))
+        return false;
+      name.assign(data_, static_cast<size_t>(name_length));
+      data_ += name_length;
+
+      scoped_ptr<Value> field;
+      if (!Decode(&field) || field.get() == NULL ||
+          !fields->AddField(name, field.Pass())) {
+        return false;
+      }
+    }
+    value->reset(fields.release());
+    return true;
+  }
+
+  const char* data_;
+  const char* end_;
+
+  DISALLOW_COPY_AND_ASSIGN(Deserializer);
+};
+
+}  // namespace
+
+void SerializeValue(const Value* value, std::string* buffer) {
+  DCHECK(buffer != NULL);
+
+  if (value == NULL) {
+    buffer->push_back(static_cast<char>(kNullTag));
+    return;
+  }
+
+  SerializeVisitor visitor(buffer);
+  value->Accept(&visitor);
+}
+
+bool DeserializeValue(const char** data,
+                      const char* end,
+                      scoped_ptr<Value>* value) {
+  DCHECK(data != NULL);
+  DCHECK(*data != NULL);
+  DCHECK(value != NULL);
+
+  Deserializer deserializer(*data, end);
+  scoped_ptr<Value> decoded;
+  if (!deserializer.Decode(&decoded))
+    return false;
+
+  *data = deserializer.data();
+  *value = decoded.Pass();
+  return true;
+}
+
+void AppendVarint(uint64 value, std::string* buffer) {
+  DCHECK(buffer != NULL);
+
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(const char** data, const char* end, uint64* value) {
+  DCHECK(data != NULL);
+  DCHECK(value != NULL);
+
+  const char* ptr = *data;
+  uint64 result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (ptr >= end)
+      return false;
+    uint64 byte = static_cast<unsigned char>(*ptr++);
+    result |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *data = ptr;
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace event
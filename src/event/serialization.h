@@ -0,0 +1,82 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A compact binary form of values, to keep events outside of memory. Each
+// value starts with its type; integers are stored as variable-length
+// integers, strings and aggregates are prefixed by their length.
+//
+//   std::string buffer;
+//   event::SerializeValue(value, &buffer);
+//   ...
+//   const char* data = buffer.data();
+//   scoped_ptr<event::Value> copy;
+//   event::DeserializeValue(&data, data + buffer.size(), &copy);
+//
+// The form is meant for temporary files read back by the same build: it is
+// not versioned.
+
+#ifndef EVENT_SERIALIZATION_H_
+#define EVENT_SERIALIZATION_H_
+
+#include <string>
+
+#include "base/base.h"
+#include "base/scoped_ptr.h"
+#include "event/value.h"
+
+namespace event {
+
+// Appends the binary form of a value to a buffer.
+// @param value the value to serialize. May be NULL.
+// @param buffer receives the binary form.
+void SerializeValue(const Value* value, std::string* buffer);
+
+// Decodes a value serialized by SerializeValue.
+// @param data the beginning of the binary form. On success, it is advanced
+//     past the decoded value.
+// @param end the end of the available bytes.
+// @param value receives the decoded value, NULL if a NULL value was
+//     serialized.
+// @returns true on success, false if the bytes are invalid or truncated.
+bool DeserializeValue(const char** data,
+                      const char* end,
+                      scoped_ptr<Value>* value);
+
+// Appends a variable-length unsigned integer to a buffer.
+// @param value the integer to append.
+// @param buffer receives the encoded integer.
+void AppendVarint(uint64 value, std::string* buffer);
+
+// Decodes a variable-length unsigned integer.
+// @param data the beginning of the encoded integer. On success, it is advanced
+//     past the integer.
+// @param end the end of the available bytes.
+// @param value receives the integer.
+// @returns true on success, false if the bytes are invalid or truncated.
+bool ReadVarint(const char** data, const char* end, uint64* value);
+
+}  // namespace event
+
+#endif  // EVENT_SERIALIZATION_H_
@@ -0,0 +1,160 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "event/serialization.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+// Serializes a value, decodes it back and checks that both are equal.
+void ExpectRoundTrip(const Value* value) {
+  std::string buffer;
+  SerializeValue(value, &buffer);
+
+  const char* data = buffer.data();
+  const char* end = data + buffer.size();
+  scoped_ptr<Value> decoded;
+  ASSERT_TRUE(DeserializeValue(&data, end, &decoded));
+  EXPECT_EQ(end, data);
+  if (value == NULL) {
+    EXPECT_TRUE(decoded.get() == NULL);
+  } else {
+    ASSERT_TRUE(decoded.get() != NULL);
+    EXPECT_TRUE(value->Equals(decoded.get()));
+  }
+}
+
+}  // namespace
+
+TEST(SerializationTest, Varint) {
+  const uint64 kValues[] = { 0, 1, 127, 128, 300, 0xFFFFFFFFULL,
+                             0xFFFFFFFFFFFFFFFFULL };
+  const size_t kCount = sizeof(kValues) / sizeof(kValues[0]);
+
+  std::string buffer;
+  for (size_t i = 0; i < kCount; ++i)
+    AppendVarint(kValues[i], &buffer);
+  EXPECT_EQ(1U + 1 + 1 + 2 + 2 + 5 + 10, buffer.size());
+
+  const char* data = buffer.data();
+  const char* end = data + buffer.size();
+  for (size_t i = 0; i < kCount; ++i) {
+    uint64 value = 0;
+    ASSERT_TRUE(ReadVarint(&data, end, &value));
+    EXPECT_EQ(kValues[i], value);
+  }
+  EXPECT_EQ(end, data);
+
+  uint64 value = 0;
+  EXPECT_FALSE(ReadVarint(&data, end, &value));
+}
+
+TEST(SerializationTest, Scalars) {
+  ExpectRoundTrip(NULL);
+  BoolValue bool_value(true);
+  ExpectRoundTrip(&bool_value);
+  CharValue char_value(-128);
+  ExpectRoundTrip(&char_value);
+  UCharValue uchar_value(255);
+  ExpectRoundTrip(&uchar_value);
+  ShortValue short_value(-300);
+  ExpectRoundTrip(&short_value);
+  UShortValue ushort_value(65535);
+  ExpectRoundTrip(&ushort_value);
+  IntValue int_value(-2147483647 - 1);
+  ExpectRoundTrip(&int_value);
+  UIntValue uint_value(0xFFFFFFFF);
+  ExpectRoundTrip(&uint_value);
+  LongValue long_value(-1234567890123LL);
+  ExpectRoundTrip(&long_value);
+  ULongValue ulong_value(0xFFFFFFFFFFFFFFFFULL);
+  ExpectRoundTrip(&ulong_value);
+  FloatValue float_value(1.5f);
+  ExpectRoundTrip(&float_value);
+  DoubleValue double_value(-0.25);
+  ExpectRoundTrip(&double_value);
+  StringValue string_value(std::string("with\0null", 9));
+  ExpectRoundTrip(&string_value);
+  WStringValue wstring_value(L"wide \x263A");
+  ExpectRoundTrip(&wstring_value);
+}
+
+TEST(SerializationTest, Aggregates) {
+  scoped_ptr<ArrayValue> array(new ArrayValue());
+  array->Append<IntValue>(1);
+  array->Append<StringValue>("two");
+  array->Append(scoped_ptr<Value>(new ArrayValue()));
+
+  StructValue struct_value;
+  struct_value.AddField<UIntValue>("pid", 4);
+  struct_value.AddField("values", array.PassAs<Value>());
+  struct_value.AddField("empty", scoped_ptr<Value>(new StructValue()));
+  ExpectRoundTrip(&struct_value);
+}
+
+TEST(SerializationTest, SmallIntegersAreCompact) {
+  std::string buffer;
+  IntValue small(-3);
+  SerializeValue(&small, &buffer);
+  EXPECT_EQ(2U, buffer.size());
+
+  buffer.clear();
+  ULongValue address(0x1000);
+  SerializeValue(&address, &buffer);
+  EXPECT_EQ(3U, buffer.size());
+}
+
+TEST(SerializationTest, Invalid) {
+  StructValue struct_value;
+  struct_value.AddField<StringValue>("name", "value");
+  struct_value.AddField<DoubleValue>("ratio", 0.5);
+  std::string buffer;
+  SerializeValue(&struct_value, &buffer);
+
+  // Every truncation is detected.
+  for (size_t length = 0; length < buffer.size(); ++length) {
+    const char* data = buffer.data();
+    scoped_ptr<Value> decoded;
+    EXPECT_FALSE(DeserializeValue(&data, data + length, &decoded));
+    EXPECT_EQ(buffer.data(), data);
+  }
+
+  const char kUnknownTag[] = { 0x40 };
+  const char* data = kUnknownTag;
+  scoped_ptr<Value> decoded;
+  EXPECT_FALSE(DeserializeValue(&data, data + sizeof(kUnknownTag), &decoded));
+
+  // A NULL field is rejected.
+  const char kNullField[] = { VALUE_STRUCT, 1, 1, 'a',
+                              static_cast<char>(0xFF) };
+  data = kNullField;
+  EXPECT_FALSE(DeserializeValue(&data, data + sizeof(kNullField), &decoded));
+}
+
+}  // namespace event
@@ -0,0 +1,145 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/stack_table.h"
+
+#include "base/hash.h"
+#include "base/logging.h"
+
+namespace event {
+
+namespace {
+
+// The initial number of slots of the hash table.
+const size_t kInitialSlotCount = 1024;
+
+}  // namespace
+
+const uint32 StackTable::kRootNode;
+const uint32 StackTable::kNoNode;
+
+StackTable::StackTable() : slots_(kInitialSlotCount, 0) {
+  Node root = { 0, kNoNode, kNoNode, kNoNode };
+  nodes_.push_back(root);
+}
+
+StackId StackTable::Insert(const uint64* frames, size_t count) {
+  DCHECK(frames != NULL || count == 0);
+
+  uint64 hash = base::Hash64(frames, count * sizeof(uint64));
+  size_t mask = slots_.size() - 1;
+
+  // Look for the stack, using the hash to skip most comparisons.
+  size_t slot = static_cast<size_t>(hash) & mask;
+  for (; slots_[slot] != 0; slot = (slot + 1) & mask) {
+    uint32 id = slots_[slot] - 1;
+    if (stack_hashes_[id] == hash &&
+        Matches(stack_nodes_[id], frames, count)) {
+      return StackId(id);
+    }
+  }
+
+  // Add the missing nodes to the calling context tree, outermost frame first.
+  uint32 index = kRootNode;
+  for (size_t i = count; i > 0; --i)
+    index = FindOrAddChild(index, frames[i - 1]);
+
+  uint32 id = static_cast<uint32>(stack_nodes_.size());
+  stack_nodes_.push_back(index);
+  stack_hashes_.push_back(hash);
+  slots_[slot] = id + 1;
+
+  // Keep the load factor of the hash table under one half.
+  if (2 * stack_nodes_.size() > slots_.size())
+    Grow();
+
+  return StackId(id);
+}
+
+StackId StackTable::Insert(const Stack& stack) {
+  if (stack.empty())
+    return Insert(NULL, 0);
+  return Insert(&stack[0], stack.size());
+}
+
+void StackTable::GetStack(const StackId& id, Stack* stack) const {
+  DCHECK(stack != NULL);
+  stack->clear();
+  for (uint32 index = GetNode(id); index != kRootNode;
+       index = nodes_[index].parent) {
+    stack->push_back(nodes_[index].frame);
+  }
+}
+
+uint32 StackTable::GetNode(const StackId& id) const {
+  DCHECK_LT(id.key_value(), stack_nodes_.size());
+  return stack_nodes_[id.key_value()];
+}
+
+size_t StackTable::MemoryUsage() const {
+  return nodes_.capacity() * sizeof(Node) +
+         stack_nodes_.capacity() * sizeof(uint32) +
+         stack_hashes_.capacity() * sizeof(uint64) +
+         slots_.capacity() * sizeof(uint32);
+}
+
+bool StackTable::Matches(uint32 index,
+                         const uint64* frames,
+                         size_t count) const {
+  for (size_t i = 0; i < count; ++i) {
+    if (index == kRootNode || nodes_[index].frame != frames[i])
+      return false;
+    index = nodes_[index].parent;
+  }
+  return index == kRootNode;
+}
+
+uint32 StackTable::FindOrAddChild(uint32 parent, uint64 frame) {
+  uint32 child = nodes_[parent].first_child;
+  for (; child != kNoNode; child = nodes_[child].next_sibling) {
+    if (nodes_[child].frame == frame)
+      return child;
+  }
+
+  Node node = { frame, parent, kNoNode, nodes_[parent].first_child };
+  child = static_cast<uint32>(nodes_.size());
+  nodes_.push_back(node);
+  nodes_[parent].first_child = child;
+  return child;
+}
+
+void StackTable::Grow() {
+  std::vector<uint32> slots(2 * slots_.size(), 0);
+  size_t mask = slots.size() - 1;
+  for (size_t id = 0; id < stack_hashes_.size(); ++id) {
+    size_t slot = static_cast<size_t>(stack_hashes_[id]) & mask;
+    while (slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots[slot] = static_cast<uint32>(id + 1);
+  }
+  slots_.swap(slots);
+}
+
+}  // namespace event
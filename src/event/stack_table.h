@@ -0,0 +1,152 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A stack table interns the call stacks of a trace. Sampling profiles repeat
+// the same few stacks many times: each distinct stack is stored once and is
+// referred to by a compact StackId.
+//
+// The stacks are stored as a calling context tree: the root is the caller of
+// every stack and each node adds a frame to the stack of its parent. Stacks
+// sharing their outermost frames share the nodes of these frames.
+//
+// Usage example:
+//   StackTable table;
+//   StackId id = table.Insert(&frames[0], frames.size());
+//   assert(id == table.Insert(&frames[0], frames.size()));
+//
+//   Stack stack;
+//   table.GetStack(id, &stack);  // stack == frames.
+//
+//   // Enumerate the children of the root.
+//   uint32 child = table.node(StackTable::kRootNode).first_child;
+//   while (child != StackTable::kNoNode) {
+//     ...
+//     child = table.node(child).next_sibling;
+//   }
+
+#ifndef EVENT_STACK_TABLE_H_
+#define EVENT_STACK_TABLE_H_
+
+#include <vector>
+
+#include "base/base.h"
+#include "flyweight/flyweight_key.h"
+
+namespace event {
+
+struct StackTag {};
+
+// The frames of a call stack. The first frame is the innermost one, as in the
+// payload of the StackWalk events.
+typedef std::vector<uint64> Stack;
+
+// The identifier of a stack interned in a StackTable.
+typedef flyweight::FlyweightKey<Stack, StackTag> StackId;
+
+class StackTable {
+ public:
+  // A node of the calling context tree.
+  struct Node {
+    // The frame added by this node.
+    uint64 frame;
+    // The caller of this node.
+    uint32 parent;
+    // The first callee of this node, or kNoNode.
+    uint32 first_child;
+    // The next callee of the parent of this node, or kNoNode.
+    uint32 next_sibling;
+  };
+
+  // The index of the root of the calling context tree. It has no frame.
+  static const uint32 kRootNode = 0;
+
+  // Marks the absence of a node.
+  static const uint32 kNoNode = 0xFFFFFFFF;
+
+  StackTable();
+
+  // Interns a stack.
+  // @param frames the frames of the stack, innermost first.
+  // @param count the number of frames.
+  // @returns the identifier of the stack. Identical stacks have the same
+  //     identifier.
+  StackId Insert(const uint64* frames, size_t count);
+
+  // Interns a stack.
+  // @param stack the frames of the stack, innermost first.
+  // @returns the identifier of the stack.
+  StackId Insert(const Stack& stack);
+
+  // Retrieves the frames of an interned stack.
+  // @param id the identifier returned by Insert.
+  // @param stack receives the frames of the stack, innermost first.
+  void GetStack(const StackId& id, Stack* stack) const;
+
+  // @param id the identifier returned by Insert.
+  // @returns the node of the innermost frame of the stack |id|.
+  uint32 GetNode(const StackId& id) const;
+
+  // @param index the index of a node.
+  // @returns the node at |index|.
+  const Node& node(uint32 index) const { return nodes_[index]; }
+
+  // @returns the number of distinct stacks.
+  size_t stack_count() const { return stack_nodes_.size(); }
+
+  // @returns the number of nodes of the calling context tree, root included.
+  size_t node_count() const { return nodes_.size(); }
+
+  // @returns an estimate of the memory used by this table, in bytes.
+  size_t MemoryUsage() const;
+
+ private:
+  // @returns true if the stack ending at |index| has the frames |frames|.
+  bool Matches(uint32 index, const uint64* frames, size_t count) const;
+
+  // Finds the callee of |parent| with the frame |frame|, and adds it if it
+  // doesn't exist.
+  // @returns the index of the callee.
+  uint32 FindOrAddChild(uint32 parent, uint64 frame);
+
+  // Doubles the number of slots of the hash table.
+  void Grow();
+
+  // The calling context tree.
+  std::vector<Node> nodes_;
+
+  // The innermost node and the hash of each stack, indexed by StackId.
+  std::vector<uint32> stack_nodes_;
+  std::vector<uint64> stack_hashes_;
+
+  // An open-addressing hash table of the stacks. A slot holds a StackId plus
+  // one, or zero when empty. The number of slots is a power of two.
+  std::vector<uint32> slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(StackTable);
+};
+
+}  // namespace event
+
+#endif  // EVENT_STACK_TABLE_H_
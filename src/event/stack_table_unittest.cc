@@ -0,0 +1,116 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/stack_table.h"
+
+#include "gtest/gtest.h"
+
+namespace event {
+
+TEST(StackTableTest, InsertSameStack) {
+  const uint64 kFrames[] = { 0x1000, 0x2000, 0x3000 };
+  StackTable table;
+  StackId id = table.Insert(&kFrames[0], 3);
+  EXPECT_EQ(id, table.Insert(&kFrames[0], 3));
+  EXPECT_EQ(1U, table.stack_count());
+  EXPECT_EQ(4U, table.node_count());
+
+  Stack stack;
+  table.GetStack(id, &stack);
+  ASSERT_EQ(3U, stack.size());
+  EXPECT_EQ(0x1000U, stack[0]);
+  EXPECT_EQ(0x2000U, stack[1]);
+  EXPECT_EQ(0x3000U, stack[2]);
+}
+
+TEST(StackTableTest, SharedPrefix) {
+  // Both stacks have the same outermost frames.
+  const uint64 kFrames[] = { 0x1000, 0x2000, 0x3000 };
+  const uint64 kOtherFrames[] = { 0x1001, 0x2000, 0x3000 };
+  StackTable table;
+  StackId id = table.Insert(&kFrames[0], 3);
+  StackId other_id = table.Insert(&kOtherFrames[0], 3);
+  EXPECT_FALSE(id == other_id);
+  EXPECT_EQ(2U, table.stack_count());
+  EXPECT_EQ(5U, table.node_count());
+
+  uint32 node = table.GetNode(id);
+  uint32 other_node = table.GetNode(other_id);
+  EXPECT_NE(node, other_node);
+  EXPECT_EQ(table.node(node).parent, table.node(other_node).parent);
+
+  // The root has a single callee.
+  uint32 child = table.node(StackTable::kRootNode).first_child;
+  ASSERT_NE(StackTable::kNoNode, child);
+  EXPECT_EQ(0x3000U, table.node(child).frame);
+  EXPECT_EQ(StackTable::kNoNode, table.node(child).next_sibling);
+}
+
+TEST(StackTableTest, PrefixStack) {
+  // A stack made of the outermost frames of another stack.
+  const uint64 kFrames[] = { 0x1000, 0x2000, 0x3000 };
+  StackTable table;
+  StackId id = table.Insert(&kFrames[0], 3);
+  StackId prefix_id = table.Insert(&kFrames[1], 2);
+  EXPECT_FALSE(id == prefix_id);
+  EXPECT_EQ(4U, table.node_count());
+  EXPECT_EQ(table.node(table.GetNode(id)).parent, table.GetNode(prefix_id));
+
+  Stack stack;
+  table.GetStack(prefix_id, &stack);
+  ASSERT_EQ(2U, stack.size());
+  EXPECT_EQ(0x2000U, stack[0]);
+  EXPECT_EQ(0x3000U, stack[1]);
+}
+
+TEST(StackTableTest, EmptyStack) {
+  StackTable table;
+  Stack empty;
+  StackId id = table.Insert(empty);
+  EXPECT_EQ(id, table.Insert(NULL, 0));
+  EXPECT_EQ(StackTable::kRootNode, table.GetNode(id));
+
+  Stack stack(1, 42);
+  table.GetStack(id, &stack);
+  EXPECT_TRUE(stack.empty());
+}
+
+TEST(StackTableTest, ManyStacks) {
+  StackTable table;
+  const uint64 kCount = 10000;
+  for (uint64 i = 0; i < kCount; ++i) {
+    uint64 frames[] = { i, i / 10, i / 100 };
+    EXPECT_EQ(i, table.Insert(&frames[0], 3).key_value());
+  }
+  EXPECT_EQ(kCount, table.stack_count());
+
+  for (uint64 i = 0; i < kCount; ++i) {
+    uint64 frames[] = { i, i / 10, i / 100 };
+    EXPECT_EQ(i, table.Insert(&frames[0], 3).key_value());
+  }
+  EXPECT_EQ(kCount, table.stack_count());
+}
+
+}  // namespace event
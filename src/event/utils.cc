@@ -28,100 +28,190 @@
 #include <sstream>
 
 #include "base/logging.h"
+#include "base/string_utils.h"
 #include "event/value.h"
 
 namespace event {
 
 namespace {
 
-bool ToString(const Value* value, size_t indent, std::stringstream* result) {
-  DCHECK(value != NULL);
-  DCHECK(result != NULL);
+// Appends the textual representation of the visited values to a stream.
+class ToStringVisitor : public ValueVisitor {
+ public:
+  ToStringVisitor(size_t indent, std::stringstream* result)
+      : indent_(indent), result_(result), success_(true) {
+    DCHECK(result != NULL);
+  }
 
-  if (value->IsScalar()) {
-    int8 char_value = 0;
-    uint8 uchar_value = 0;
-    int16 short_value = 0;
-    uint16 ushort_value = 0;
-    int32 int_value = 0;
-    uint32 uint_value = 0;
-    int64 long_value = 0;
-    uint64 ulong_value = 0;
-    float float_value = 0;
-    double double_value = 0;
-    std::string string_value;
-
-    if (CharValue::GetValue(value, &char_value)) {
-      *result << static_cast<int>(char_value);
-      return true;
-    } else if (UCharValue::GetValue(value, &uchar_value)) {
-      *result << static_cast<unsigned int>(uchar_value);
-      return true;
-    } else if (ShortValue::GetValue(value, &short_value)) {
-      *result << short_value;
-      return true;
-    } else if (UShortValue::GetValue(value, &ushort_value)) {
-      *result << ushort_value;
-      return true;
-    } else if (IntValue::GetValue(value, &int_value)) {
-      *result << int_value;
-      return true;
-    } else if (UIntValue::GetValue(value, &uint_value)) {
-      *result << uint_value;
-      return true;
-    } else if (LongValue::GetValue(value, &long_value)) {
-      *result << long_value;
-      return true;
-    } else if (ULongValue::GetValue(value, &ulong_value)) {
-      *result << ulong_value;
-      return true;
-    } else if (FloatValue::GetValue(value, &float_value)) {
-      *result << float_value;
-      return true;
-    } else if (DoubleValue::GetValue(value, &double_value)) {
-      *result << double_value;
-      return true;
-    } else if (value->GetAsString(&string_value)) {
-      *result << "\"" << string_value << "\"";  // TODO(etienneb): escaping.
-      return true;
+  bool success() const { return success_; }
+
+  virtual void Visit(const BoolValue& value) OVERRIDE {
+    success_ = false;
+  }
+  virtual void Visit(const CharValue& value) OVERRIDE {
+    *result_ << static_cast<int>(value.GetValue());
+  }
+  virtual void Visit(const UCharValue& value) OVERRIDE {
+    *result_ << static_cast<unsigned int>(value.GetValue());
+  }
+  virtual void Visit(const ShortValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const UShortValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const IntValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const UIntValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const LongValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const ULongValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const FloatValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  virtual void Visit(const DoubleValue& value) OVERRIDE {
+    *result_ << value.GetValue();
+  }
+  // TODO(etienneb): escaping.
+  virtual void Visit(const StringValue& value) OVERRIDE {
+    *result_ << "\"" << value.GetValue() << "\"";
+  }
+  virtual void Visit(const WStringValue& value) OVERRIDE {
+    *result_ << "\"" << base::WStringToString(value.GetValue()) << "\"";
+  }
+
+  virtual void Visit(const ArrayValue& value) OVERRIDE {
+    std::string indent_string = std::string(indent_ , ' ');
+    std::string indent_field = std::string(indent_ + 4, ' ');
+
+    *result_ << "[\n";
+    indent_ += 4;
+    ArrayValue::const_iterator it = value.values_begin();
+    for (; success_ && it != value.values_end(); ++it) {
+      *result_ << indent_field;
+      (*it)->Accept(this);
+      *result_ << "\n";
     }
-  } else if (value->IsAggregate()) {
-    if (ArrayValue::InstanceOf(value)) {
-      std::string indent_string = std::string(indent , ' ');
-      std::string indent_field = std::string(indent + 4, ' ');
-      const ArrayValue* array_value = ArrayValue::Cast(value);
-      DCHECK(array_value != NULL);
-
-      *result << "[\n";
-      ArrayValue::const_iterator it = array_value->values_begin();
-      for (; it != array_value->values_end(); ++it) {
-        *result << indent_field;
-        if (!ToString(*it, indent + 4, result))
-          return false;
-        *result << "\n";
-      }
-      *result << indent_string << "]";
-      return true;
-    } else if (StructValue::InstanceOf(value)) {
-      std::string indent_string = std::string(indent , ' ');
-      std::string indent_field = std::string(indent + 4, ' ');
-      const StructValue* struct_value = StructValue::Cast(value);
-      DCHECK(struct_value != NULL);
-
-      *result << "{\n";
-      StructValue::const_iterator it = struct_value->fields_begin();
-      for (; it != struct_value->fields_end(); ++it) {
-        *result << indent_field << it->first << " = ";
-        if (!ToString(it->second, indent + 4, result))
-          return false;
-        *result << "\n";
-      }
-      *result << indent_string << "}";
-      return true;
+    indent_ -= 4;
+    *result_ << indent_string << "]";
+  }
+
+  virtual void Visit(const StructValue& value) OVERRIDE {
+    std::string indent_string = std::string(indent_ , ' ');
+    std::string indent_field = std::string(indent_ + 4, ' ');
+
+    *result_ << "{\n";
+    indent_ += 4;
+    StructValue::const_iterator it = value.fields_begin();
+    for (; success_ && it != value.fields_end(); ++it) {
+      *result_ << indent_field << it->first << " = ";
+      it->second->Accept(this);
+      *result_ << "\n";
     }
+    indent_ -= 4;
+    *result_ << indent_string << "}";
   }
 
-  return false;
+ private:
+  size_t indent_;
+  std::stringstream* result_;
+  bool success_;
+
+  DISALLOW_COPY_AND_ASSIGN(ToStringVisitor);
+};
+
+// Rebuilds the visited values.
+class CopyVisitor : public ValueVisitor {
+ public:
+  CopyVisitor() { }
+
+  // @returns the copy of the last visited value.
+  scoped_ptr<Value> Pass() { return copy_.Pass(); }
+
+  virtual void Visit(const BoolValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const CharValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const UCharValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const ShortValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const UShortValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const IntValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const UIntValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const LongValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const ULongValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const FloatValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const DoubleValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const StringValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+  virtual void Visit(const WStringValue& value) OVERRIDE {
+    CopyScalar(value);
+  }
+
+  virtual void Visit(const ArrayValue& value) OVERRIDE {
+    scoped_ptr<ArrayValue> array(new ArrayValue());
+    ArrayValue::const_iterator it = value.values_begin();
+    for (; it != value.values_end(); ++it) {
+      (*it)->Accept(this);
+      array->Append(copy_.Pass());
+    }
+    copy_.reset(array.release());
+  }
+
+  virtual void Visit(const StructValue& value) OVERRIDE {
+    scoped_ptr<StructValue> fields(new StructValue());
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end(); ++it) {
+      it->second->Accept(this);
+      fields->AddField(it->first.c_str(), copy_.Pass());
+    }
+    copy_.reset(fields.release());
+  }
+
+ private:
+  template <class T>
+  void CopyScalar(const T& value) {
+    copy_.reset(new T(value.GetValue()));
+  }
+
+  scoped_ptr<Value> copy_;
+
+  DISALLOW_COPY_AND_ASSIGN(CopyVisitor);
+};
+
+bool ToString(const Value* value, size_t indent, std::stringstream* result) {
+  DCHECK(value != NULL);
+  DCHECK(result != NULL);
+
+  ToStringVisitor visitor(indent, result);
+  value->Accept(&visitor);
+  return visitor.success();
 }
 
 }  // namespace
@@ -150,4 +240,19 @@ bool ToString(const Value* value, std::string* result) {
   return true;
 }
 
+scoped_ptr<Value> CopyValue(const Value* value) {
+  DCHECK(value != NULL);
+
+  CopyVisitor visitor;
+  value->Accept(&visitor);
+  return visitor.Pass();
+}
+
+scoped_ptr<Event> CopyEvent(const Event& event) {
+  scoped_ptr<const Value> payload;
+  if (event.payload() != NULL)
+    payload.reset(CopyValue(event.payload()).release());
+  return scoped_ptr<Event>(new Event(event.timestamp(), payload.Pass()));
+}
+
 }  // namespace event
@@ -29,6 +29,7 @@
 #include <string>
 
 #include "base/base.h"
+#include "base/scoped_ptr.h"
 #include "event/event.h"
 
 namespace event {
@@ -45,6 +46,16 @@ bool ToString(const Event& event, std::string* result);
 // @returns true if the conversion was successful, false otherwise.
 bool ToString(const Value* value, std::string* result);
 
+// Produce a deep copy of a Value.
+// @param value the value to copy.
+// @returns the copy.
+scoped_ptr<Value> CopyValue(const Value* value);
+
+// Produce a deep copy of an event, e.g. to keep it after it was received.
+// @param event the event to copy.
+// @returns the copy.
+scoped_ptr<Event> CopyEvent(const Event& event);
+
 }  // namespace event
 
 #endif  // EVENT_UTILS_H_
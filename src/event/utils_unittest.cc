@@ -104,4 +104,49 @@ TEST(EventToStringTest, Event) {
   EXPECT_STREQ(expected, event_str.c_str());
 }
 
+TEST(EventCopyTest, Value) {
+  scoped_ptr<ArrayValue> array(new ArrayValue());
+  array->Append<IntValue>(1);
+  array->Append<StringValue>("two");
+
+  StructValue struct_value;
+  struct_value.AddField<BoolValue>("flag", true);
+  struct_value.AddField<DoubleValue>("ratio", 0.5);
+  struct_value.AddField<WStringValue>("name", L"wide");
+  struct_value.AddField("array", array.PassAs<Value>());
+
+  scoped_ptr<Value> copy(CopyValue(&struct_value));
+  ASSERT_TRUE(copy.get() != NULL);
+  EXPECT_NE(&struct_value, copy.get());
+  EXPECT_TRUE(struct_value.Equals(copy.get()));
+
+  // The copy does not share its fields with the original.
+  struct_value.AddField<IntValue>("after", 3);
+  EXPECT_FALSE(struct_value.Equals(copy.get()));
+
+  const StructValue* copied = StructValue::Cast(copy.get());
+  EXPECT_FALSE(copied->HasField("after"));
+  EXPECT_NE(struct_value.GetField("array"), copied->GetField("array"));
+}
+
+TEST(EventCopyTest, Event) {
+  scoped_ptr<StructValue> payload(new StructValue());
+  payload->AddField<IntValue>("field", 12);
+  Event event(42, payload.PassAs<const Value>());
+
+  scoped_ptr<Event> copy(CopyEvent(event));
+  ASSERT_TRUE(copy.get() != NULL);
+  EXPECT_EQ(42U, copy->timestamp());
+  EXPECT_NE(event.payload(), copy->payload());
+
+  std::string event_str;
+  EXPECT_TRUE(ToString(*copy.get(), &event_str));
+  EXPECT_STREQ("[42] event {\n    field = 12\n}", event_str.c_str());
+
+  Event empty(7, scoped_ptr<const Value>());
+  copy = CopyEvent(empty);
+  EXPECT_EQ(7U, copy->timestamp());
+  EXPECT_TRUE(copy->payload() == NULL);
+}
+
 }  // namespace event
@@ -25,13 +25,57 @@
 
 #include "event/value.h"
 
+#include <cstring>
 #include <limits>
 
+#include "base/hash.h"
 #include "base/logging.h"
 #include "base/string_utils.h"
 
 namespace event {
 
+namespace {
+
+// Compares the visited value with |other| using the Equals method of the
+// concrete type.
+class EqualsVisitor : public ValueVisitor {
+ public:
+  explicit EqualsVisitor(const Value* other)
+      : other_(other), result_(false) {
+  }
+
+  bool result() const { return result_; }
+
+  virtual void Visit(const BoolValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const CharValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const UCharValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const ShortValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const UShortValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const IntValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const UIntValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const LongValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const ULongValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const FloatValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const DoubleValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const StringValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const WStringValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const ArrayValue& value) OVERRIDE { Compare(value); }
+  virtual void Visit(const StructValue& value) OVERRIDE { Compare(value); }
+
+ private:
+  template<class T>
+  void Compare(const T& value) {
+    result_ = value.Equals(other_);
+  }
+
+  const Value* other_;
+  bool result_;
+
+  DISALLOW_COPY_AND_ASSIGN(EqualsVisitor);
+};
+
+}  // namespace
+
 bool Value::GetAsInteger(int32* value) const {
   DCHECK(value != NULL);
 
@@ -306,38 +350,64 @@ bool Value::GetAsWString(std::wstring* value) const {
   }
 }
 
-template<class T, int TYPE>
-ValueType ScalarValue<T, TYPE>::GetType() const {
-  return static_cast<ValueType>(TYPE);
+bool Value::Equals(const Value* value) const {
+  EqualsVisitor visitor(value);
+  Accept(&visitor);
+  return visitor.result();
 }
 
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::IsScalar() const {
-  return true;
-}
-
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::IsAggregate() const {
-  return false;
-}
+void Value::Accept(ValueVisitor* visitor) const {
+  DCHECK(visitor != NULL);
 
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::IsInteger() const {
-  return std::numeric_limits<T>::is_specialized &&
-         std::numeric_limits<T>::is_integer;
-}
-
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::IsSigned() const {
-  return std::numeric_limits<T>::is_specialized &&
-         (!std::numeric_limits<T>::is_integer ||
-          std::numeric_limits<T>::is_signed);
-}
+  switch (GetType()) {
+    case VALUE_BOOL:
+      visitor->Visit(*BoolValue::Cast(this));
+      return;
+    case VALUE_CHAR:
+      visitor->Visit(*CharValue::Cast(this));
+      return;
+    case VALUE_UCHAR:
+      visitor->Visit(*UCharValue::Cast(this));
+      return;
+    case VALUE_SHORT:
+      visitor->Visit(*ShortValue::Cast(this));
+      return;
+    case VALUE_USHORT:
+      visitor->Visit(*UShortValue::Cast(this));
+      return;
+    case VALUE_INT:
+      visitor->Visit(*IntValue::Cast(this));
+      return;
+    case VALUE_UINT:
+      visitor->Visit(*UIntValue::Cast(this));
+      return;
+    case VALUE_LONG:
+      visitor->Visit(*LongValue::Cast(this));
+      return;
+    case VALUE_ULONG:
+      visitor->Visit(*ULongValue::Cast(this));
+      return;
+    case VALUE_FLOAT:
+      visitor->Visit(*FloatValue::Cast(this));
+      return;
+    case VALUE_DOUBLE:
+      visitor->Visit(*DoubleValue::Cast(this));
+      return;
+    case VALUE_STRING:
+      visitor->Visit(*StringValue::Cast(this));
+      return;
+    case VALUE_WSTRING:
+      visitor->Visit(*WStringValue::Cast(this));
+      return;
+    case VALUE_ARRAY:
+      visitor->Visit(*ArrayValue::Cast(this));
+      return;
+    case VALUE_STRUCT:
+      visitor->Visit(*StructValue::Cast(this));
+      return;
+  }
 
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::IsFloating() const {
-  return std::numeric_limits<T>::is_specialized &&
-         !std::numeric_limits<T>::is_integer;
+  DCHECK(false);
 }
 
 template<class T, int TYPE>
@@ -352,40 +422,6 @@ bool ScalarValue<T, TYPE>::Equals(const Value* value) const {
   return true;
 }
 
-template<class T, int TYPE>
-const T& ScalarValue<T, TYPE>::GetValue() const {
-  return value_;
-}
-
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::InstanceOf(const Value* value) {
-  DCHECK(value != NULL);
-  return value->GetType() == TYPE;
-}
-
-template<class T, int TYPE>
-const ScalarValue<T, TYPE>* ScalarValue<T, TYPE>::Cast(const Value* value) {
-  DCHECK(value != NULL);
-  DCHECK(value->GetType() == TYPE);
-  return reinterpret_cast<const SelfType*>(value);
-}
-
-template<class T, int TYPE>
-const T& ScalarValue<T, TYPE>::GetValue(const Value* value) {
-  DCHECK(value != NULL);
-  return Cast(value)->GetValue();
-}
-
-template<class T, int TYPE>
-bool ScalarValue<T, TYPE>::GetValue(const Value* value, T* dst) {
-  DCHECK(value != NULL);
-  DCHECK(dst != NULL);
-  if (!InstanceOf(value))
-    return false;
-  *dst = Cast(value)->GetValue();
-  return true;
-}
-
 template<class T, int TYPE>
 T ScalarValue<T, TYPE>::MinValue() {
   return std::numeric_limits<T>::min();
@@ -396,36 +432,6 @@ T ScalarValue<T, TYPE>::MaxValue() {
   return std::numeric_limits<T>::max();
 }
 
-template<int TYPE>
-ValueType AggregateValue<TYPE>::GetType() const {
-  return static_cast<ValueType>(TYPE);
-};
-
-template<int TYPE>
-bool AggregateValue<TYPE>::IsScalar() const {
-  return false;
-}
-
-template<int TYPE>
-bool AggregateValue<TYPE>::IsAggregate() const {
-  return true;
-}
-
-template<int TYPE>
-bool AggregateValue<TYPE>::IsInteger() const {
-  return false;
-}
-
-template<int TYPE>
-bool AggregateValue<TYPE>::IsSigned() const {
-  return false;
-}
-
-template<int TYPE>
-bool AggregateValue<TYPE>::IsFloating() const {
-  return false;
-}
-
 ArrayValue::ArrayValue() {
 }
 
@@ -544,35 +550,34 @@ bool ArrayValue::InstanceOf(const Value* value) {
 const ArrayValue* ArrayValue::Cast(const Value* value) {
   DCHECK(value != NULL);
   DCHECK(value->GetType() == VALUE_ARRAY);
-  return reinterpret_cast<const ArrayValue*>(value);
+  return static_cast<const ArrayValue*>(value);
 }
 
+const size_t StructValue::kMaxLinearFields;
+
 StructValue::StructValue() {
 }
 
 StructValue::~StructValue() {
-  for (ValueList::iterator it = fields_.begin(); it != fields_.end(); ++it)
+  for (Fields::iterator it = fields_.begin(); it != fields_.end(); ++it)
     delete it->second;
 }
 
 bool StructValue::HasField(const std::string& name) const {
-  return fields_map_.find(name) != fields_map_.end();
+  return FindField(name.data(), name.size()) != NULL;
 }
 
 const Value* StructValue::GetField(const std::string& name) const {
-  ValueMap::const_iterator look = fields_map_.find(name);
-  if (look == fields_map_.end())
-    return NULL;
-  return look->second;
+  return FindField(name.data(), name.size());
 }
 
 bool StructValue::GetField(const std::string& name,
                            const Value** value) const {
   DCHECK(value != NULL);
-  ValueMap::const_iterator look = fields_map_.find(name);
-  if (look == fields_map_.end())
+  const Value* field = FindField(name.data(), name.size());
+  if (field == NULL)
     return false;
-  *value = look->second;
+  *value = field;
   return true;
 }
 
@@ -638,16 +643,81 @@ bool StructValue::GetFieldAsWString(
   return field->GetAsWString(value);
 }
 
-bool StructValue::AddField(const std::string& name, scoped_ptr<Value> value) {
+bool StructValue::AddField(const char* name,
+                           size_t length,
+                           scoped_ptr<Value> value) {
+  DCHECK(name != NULL);
   DCHECK(value.get() != NULL);
-  if (HasField(name))
+
+  if (FindField(name, length) != NULL)
     return false;
-  Value* raw_value = value.release();
-  fields_.push_back(std::make_pair(name, raw_value));
-  fields_map_.insert(std::make_pair(name, raw_value));
+  AppendField(name, length, value.Pass());
   return true;
 }
 
+void StructValue::AppendField(const char* name,
+                              size_t length,
+                              scoped_ptr<Value> value) {
+  DCHECK(name != NULL);
+  DCHECK(value.get() != NULL);
+  DCHECK(FindField(name, length) == NULL);
+
+  fields_.push_back(Field(FieldName(name, length), value.release()));
+
+  if (fields_.size() > kMaxLinearFields) {
+    // Keep the load factor of the index under one half.
+    if (2 * fields_.size() > index_.size())
+      RebuildIndex();
+    else
+      IndexField(fields_.size() - 1);
+  }
+}
+
+const Value* StructValue::FindField(const char* name, size_t length) const {
+  if (index_.empty()) {
+    for (const_iterator it = fields_.begin(); it != fields_.end(); ++it) {
+      if (it->first.size() == length &&
+          memcmp(it->first.data(), name, length) == 0) {
+        return it->second;
+      }
+    }
+    return NULL;
+  }
+
+  size_t mask = index_.size() - 1;
+  for (size_t slot = base::Hash64(name, length) & mask;
+       index_[slot] != 0;
+       slot = (slot + 1) & mask) {
+    const Field& field = fields_[index_[slot] - 1];
+    if (field.first.size() == length &&
+        memcmp(field.first.data(), name, length) == 0) {
+      return field.second;
+    }
+  }
+  return NULL;
+}
+
+void StructValue::IndexField(size_t position) {
+  DCHECK_LT(position, fields_.size());
+  const FieldName& name = fields_[position].first;
+  size_t mask = index_.size() - 1;
+  size_t slot = base::Hash64(name.data(), name.size()) & mask;
+  while (index_[slot] != 0)
+    slot = (slot + 1) & mask;
+  index_[slot] = static_cast<uint32>(position + 1);
+}
+
+void StructValue::RebuildIndex() {
+  // A power of two, for a quarter of the slots to be used after a rebuild.
+  size_t size = 4 * kMaxLinearFields;
+  while (size < 4 * fields_.size())
+    size *= 2;
+
+  index_.assign(size, 0);
+  for (size_t position = 0; position < fields_.size(); ++position)
+    IndexField(position);
+}
+
 bool StructValue::Equals(const Value* value) const {
   if (value == NULL)
     return false;
@@ -683,7 +753,7 @@ bool StructValue::InstanceOf(const Value* value) {
 const StructValue* StructValue::Cast(const Value* value) {
   DCHECK(value != NULL);
   DCHECK(value->GetType() == VALUE_STRUCT);
-  return reinterpret_cast<const StructValue*>(value);
+  return static_cast<const StructValue*>(value);
 }
 
 // Force a template instantiation in this compilation unit. This must be at
@@ -62,17 +62,21 @@
 #define EVENT_VALUE_H_
 
 #include <cstdlib>
-#include <list>
-#include <map>
+#include <cstring>
 #include <string>
 #include <vector>
 
 #include "base/base.h"
+#include "base/free_list.h"
 #include "base/logging.h"
 #include "base/scoped_ptr.h"
 
 namespace event {
 
+class ValueVisitor;
+
+// The order of the types matters: the integer types come first, then the
+// other scalar types, then the aggregate types.
 enum ValueType {
   VALUE_BOOL,
   VALUE_CHAR,
@@ -95,21 +99,45 @@ enum ValueType {
 // subclasses of Value. A cast from Value* to Subclass* is needed to access
 // specific methods and fields. Some convenience methods ease the access to
 // common functionalities.
+//
+// The type of a value is stored as a tag in the base class: the type checks
+// and casts are inline and do not require a virtual call. Only the destructor
+// is virtual.
 class Value {
  public:
   // Destructor.
   virtual ~Value() { }
 
   // Returns the type of the value stored by the current Value object.
-  virtual ValueType GetType() const = 0;
+  ValueType GetType() const { return type_; }
 
   // These methods return some properties of the value type.
   // @{
-  virtual bool IsScalar() const = 0;
-  virtual bool IsAggregate() const = 0;
-  virtual bool IsInteger() const = 0;
-  virtual bool IsSigned() const = 0;
-  virtual bool IsFloating() const = 0;
+  bool IsScalar() const {
+    return type_ != VALUE_STRUCT && type_ != VALUE_ARRAY;
+  }
+  bool IsAggregate() const {
+    return !IsScalar();
+  }
+  bool IsInteger() const {
+    return type_ <= VALUE_ULONG;
+  }
+  bool IsSigned() const {
+    switch (type_) {
+      case VALUE_CHAR:
+      case VALUE_SHORT:
+      case VALUE_INT:
+      case VALUE_LONG:
+      case VALUE_FLOAT:
+      case VALUE_DOUBLE:
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool IsFloating() const {
+    return type_ == VALUE_FLOAT || type_ == VALUE_DOUBLE;
+  }
   // @}
 
   // These methods allow the convenient retrieval of a basic value.
@@ -131,7 +159,31 @@ class Value {
   // Compare this value with the given value |value|.
   // @param value the value to compare with.
   // @returns true when both values are equal, false otherwise.
-  virtual bool Equals(const Value* value) const = 0;
+  bool Equals(const Value* value) const;
+
+  // Dispatch this value to the |Visit| overload of its concrete type.
+  // @param visitor the visitor to call.
+  void Accept(ValueVisitor* visitor) const;
+
+  // Values recycle their memory through the free list of the current thread.
+  // @{
+  static void* operator new(size_t size) {
+    return base::FreeList::Current()->Allocate(size);
+  }
+  static void operator delete(void* block, size_t size) {
+    base::FreeList::Current()->Free(block, size);
+  }
+  // @}
+
+ protected:
+  // Constructor.
+  // @param type the type of the concrete value.
+  explicit Value(ValueType type) : type_(type) { }
+
+ private:
+  const ValueType type_;
+
+  DISALLOW_COPY_AND_ASSIGN(Value);
 };
 
 template<class T, int TYPE>
@@ -141,43 +193,54 @@ class ScalarValue : public Value {
   typedef T ScalarType;
 
   explicit ScalarValue(const T& value)
-      : value_(value) {
+      : Value(static_cast<ValueType>(TYPE)),
+        value_(value) {
   }
 
-  // Overridden from Value:
-  // @{
-  virtual ValueType GetType() const OVERRIDE;
-  virtual bool IsScalar() const OVERRIDE;
-  virtual bool IsAggregate() const OVERRIDE;
-  virtual bool IsInteger() const OVERRIDE;
-  virtual bool IsSigned() const OVERRIDE;
-  virtual bool IsFloating() const OVERRIDE;
-
-  virtual bool Equals(const Value* value) const OVERRIDE;
-  // @}
+  // Compare this value with the given value |value|.
+  // @param value the value to compare with.
+  // @returns true when both values are equal, false otherwise.
+  bool Equals(const Value* value) const;
 
   // Retrieve the value holded in this wrapper.
-  const T& GetValue() const;
+  const T& GetValue() const { return value_; }
 
   // Cast and retrieve the value holded in |value|.
   // @param value the value to retrieve (must be of the appropriate type).
   // @returns the value holded in this wrapper.
-  static const T& GetValue(const Value* value);
+  static const T& GetValue(const Value* value) {
+    DCHECK(value != NULL);
+    return Cast(value)->GetValue();
+  }
 
   // Try to retrieve the value holded in |value|.
   // @param value the value to retrieve.
   // @param dst receives the value holded in this wrapper.
   // @returns true is the conversion is valid, false otherwise.
-  static bool GetValue(const Value* value, T* dst);
+  static bool GetValue(const Value* value, T* dst) {
+    DCHECK(value != NULL);
+    DCHECK(dst != NULL);
+    if (!InstanceOf(value))
+      return false;
+    *dst = Cast(value)->GetValue();
+    return true;
+  }
 
   // Determine if |value| is of type |TYPE|.
   // @returns true is |value| has the appropriate type, false otherwise.
-  static bool InstanceOf(const Value* value);
+  static bool InstanceOf(const Value* value) {
+    DCHECK(value != NULL);
+    return value->GetType() == TYPE;
+  }
 
   // Cast |value| to type |TYPE|.
   // @param value the value to cast.
   // @returns the casted value.
-  static const SelfType* Cast(const Value* value);
+  static const SelfType* Cast(const Value* value) {
+    DCHECK(value != NULL);
+    DCHECK(value->GetType() == TYPE);
+    return static_cast<const SelfType*>(value);
+  }
 
   // Returns the minimun value representable by |T|.
   static T MinValue();
@@ -203,24 +266,46 @@ typedef ScalarValue<std::wstring, VALUE_WSTRING> WStringValue;
 typedef ScalarValue<float, VALUE_FLOAT> FloatValue;
 typedef ScalarValue<double, VALUE_DOUBLE> DoubleValue;
 
-template<int TYPE>
-class AggregateValue : public Value {
+class ArrayValue;
+class StructValue;
+
+// A ValueVisitor receives a value with its concrete type. A tree of values is
+// walked with one dispatch per node by calling Accept on the children.
+class ValueVisitor {
  public:
-  // Overridden from Value:
+  virtual ~ValueVisitor() { }
+
+  // Called by Value::Accept with the concrete type of the visited value.
+  // @param value the visited value.
   // @{
-  virtual ValueType GetType() const OVERRIDE;
-  virtual bool IsScalar() const OVERRIDE;
-  virtual bool IsAggregate() const OVERRIDE;
-  virtual bool IsInteger() const OVERRIDE;
-  virtual bool IsSigned() const OVERRIDE;
-  virtual bool IsFloating() const OVERRIDE;
+  virtual void Visit(const BoolValue& value) = 0;
+  virtual void Visit(const CharValue& value) = 0;
+  virtual void Visit(const UCharValue& value) = 0;
+  virtual void Visit(const ShortValue& value) = 0;
+  virtual void Visit(const UShortValue& value) = 0;
+  virtual void Visit(const IntValue& value) = 0;
+  virtual void Visit(const UIntValue& value) = 0;
+  virtual void Visit(const LongValue& value) = 0;
+  virtual void Visit(const ULongValue& value) = 0;
+  virtual void Visit(const FloatValue& value) = 0;
+  virtual void Visit(const DoubleValue& value) = 0;
+  virtual void Visit(const StringValue& value) = 0;
+  virtual void Visit(const WStringValue& value) = 0;
+  virtual void Visit(const ArrayValue& value) = 0;
+  virtual void Visit(const StructValue& value) = 0;
   // @}
 };
 
+template<int TYPE>
+class AggregateValue : public Value {
+ protected:
+  AggregateValue() : Value(static_cast<ValueType>(TYPE)) { }
+};
+
 // An ArrayValue holds a sequence of disparate values.
 class ArrayValue : public AggregateValue<VALUE_ARRAY> {
  public:
-  typedef std::vector<Value*> Values;
+  typedef std::vector<Value*, base::FreeListAllocator<Value*> > Values;
   typedef Values::const_iterator const_iterator;
 
   ArrayValue();
@@ -300,10 +385,10 @@ class ArrayValue : public AggregateValue<VALUE_ARRAY> {
   bool GetElementAsWString(size_t index, std::wstring* value) const;
   // @}
 
-  // Overridden from Value:
-  // @{
-  virtual bool Equals(const Value* value) const OVERRIDE;
-  // @}
+  // Compare this value with the given value |value|.
+  // @param value the value to compare with.
+  // @returns true when both values are equal, false otherwise.
+  bool Equals(const Value* value) const;
 
   // Iteration.
   // @{
@@ -330,9 +415,11 @@ class ArrayValue : public AggregateValue<VALUE_ARRAY> {
 // StructValue provides a key-value dictionary and keeps fields in a sequence.
 class StructValue : public AggregateValue<VALUE_STRUCT> {
  public:
-  typedef std::map<std::string, Value*> ValueMap;
-  typedef std::list<std::pair<std::string, Value*> > ValueList;
-  typedef ValueList::const_iterator const_iterator;
+  typedef std::basic_string<char, std::char_traits<char>,
+                            base::FreeListAllocator<char> > FieldName;
+  typedef std::pair<FieldName, Value*> Field;
+  typedef std::vector<Field, base::FreeListAllocator<Field> > Fields;
+  typedef Fields::const_iterator const_iterator;
 
   StructValue();
   virtual ~StructValue();
@@ -390,24 +477,51 @@ class StructValue : public AggregateValue<VALUE_STRUCT> {
   // @param name the name of the field.
   // @param value the value of the field.
   // @returns true if the field can be added, false otherwise.
-  bool AddField(const std::string& name, scoped_ptr<Value> value);
+  // @{
+  bool AddField(const std::string& name, scoped_ptr<Value> value) {
+    return AddField(name.data(), name.size(), value.Pass());
+  }
+  bool AddField(const char* name, scoped_ptr<Value> value) {
+    return AddField(name, strlen(name), value.Pass());
+  }
+  // @}
+
+  // Adds a field whose name is known not to be in this structure, e.g. from
+  // a schema with unique names, without looking the name up.
+  // @param name the name of the field.
+  // @param value the value of the field.
+  void AddNewField(const char* name, scoped_ptr<Value> value) {
+    AppendField(name, strlen(name), value.Pass());
+  }
+
+  // Reserves room for fields, e.g. before adding the fields of a payload
+  // whose layout is known.
+  // @param count the number of fields to be added.
+  void ReserveFields(size_t count) { fields_.reserve(fields_.size() + count); }
 
   // Add a field with name |name| to this structure.
   // @tparam T the type of the value of the field.
   // @param name the name of the field.
   // @param value the value of the field.
   // @returns true if the field can be added, false otherwise.
+  // @{
   template<class T>
   bool AddField(const std::string& name, const typename T::ScalarType& value) {
     scoped_ptr<Value> ptr(new T(value));
     return AddField(name, ptr.Pass());
   }
-
-  // Overridden from Value:
-  // @{
-  virtual bool Equals(const Value* value) const OVERRIDE;
+  template<class T>
+  bool AddField(const char* name, const typename T::ScalarType& value) {
+    scoped_ptr<Value> ptr(new T(value));
+    return AddField(name, ptr.Pass());
+  }
   // @}
 
+  // Compare this value with the given value |value|.
+  // @param value the value to compare with.
+  // @returns true when both values are equal, false otherwise.
+  bool Equals(const Value* value) const;
+
   // Iteration.
   // @{
   const_iterator fields_begin() const { return fields_.begin(); }
@@ -424,8 +538,44 @@ class StructValue : public AggregateValue<VALUE_STRUCT> {
   static const StructValue* Cast(const Value* value);
 
  private:
-  ValueList fields_;
-  ValueMap fields_map_;
+  // Add a field to this structure.
+  // @param name the name of the field, not null-terminated.
+  // @param length the length of |name|.
+  // @param value the value of the field.
+  // @returns true if the field can be added, false otherwise.
+  bool AddField(const char* name, size_t length, scoped_ptr<Value> value);
+
+  // Appends a field whose name is not in this structure.
+  // @param name the name of the field, not null-terminated.
+  // @param length the length of |name|.
+  // @param value the value of the field.
+  void AppendField(const char* name, size_t length, scoped_ptr<Value> value);
+
+  // Find a field by name.
+  // @param name the name of the field, not null-terminated.
+  // @param length the length of |name|.
+  // @returns the value of the field if the field is found, NULL otherwise.
+  const Value* FindField(const char* name, size_t length) const;
+
+  // Adds the field at |position| of |fields_| to |index_|.
+  void IndexField(size_t position);
+
+  // Rebuilds |index_| with room for the growth of the structure.
+  void RebuildIndex();
+
+  // Structures up to this number of fields are searched linearly.
+  static const size_t kMaxLinearFields = 16;
+
+  // The fields, in insertion order. Structures usually hold a few fields: a
+  // linear lookup is faster than a map and keeps the allocations to the values
+  // and this vector.
+  Fields fields_;
+
+  // Hash table of the positions of the fields plus one, with linear probing.
+  // Empty while the structure holds no more than kMaxLinearFields fields, so
+  // that the lookups in larger structures don't make building them quadratic.
+  typedef std::vector<uint32, base::FreeListAllocator<uint32> > FieldIndex;
+  FieldIndex index_;
 
   DISALLOW_COPY_AND_ASSIGN(StructValue);
 };
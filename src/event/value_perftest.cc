@@ -0,0 +1,136 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "event/value.h"
+
+#include <string>
+
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace event {
+
+namespace {
+
+const size_t kIterations = 2000;
+const size_t kArrayLength = 1024;
+
+// Builds an array holding integers of every width.
+scoped_ptr<ArrayValue> MakeIntegerArray() {
+  scoped_ptr<ArrayValue> array(new ArrayValue());
+  for (size_t i = 0; i < kArrayLength; ++i) {
+    switch (i % 4) {
+      case 0:
+        array->Append<UCharValue>(static_cast<uint8>(i));
+        break;
+      case 1:
+        array->Append<ShortValue>(static_cast<int16>(i));
+        break;
+      case 2:
+        array->Append<UIntValue>(static_cast<uint32>(i));
+        break;
+      default:
+        array->Append<LongValue>(static_cast<int64>(i));
+        break;
+    }
+  }
+  return array.Pass();
+}
+
+}  // namespace
+
+TEST(ValuePerfTest, GetAsLong) {
+  scoped_ptr<ArrayValue> array(MakeIntegerArray());
+
+  int64 sum = 0;
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    for (ArrayValue::const_iterator it = array->values_begin();
+         it != array->values_end(); ++it) {
+      int64 value = 0;
+      ASSERT_TRUE((*it)->GetAsLong(&value));
+      sum += value;
+    }
+  }
+  base::PrintPerfResult("GetAsLong", "convert", timer.ElapsedNanoseconds(),
+                        kIterations * kArrayLength, "ns/value");
+  EXPECT_LT(0, sum);
+}
+
+TEST(ValuePerfTest, InstanceOf) {
+  scoped_ptr<ArrayValue> array(MakeIntegerArray());
+
+  size_t count = 0;
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    for (ArrayValue::const_iterator it = array->values_begin();
+         it != array->values_end(); ++it) {
+      if (UIntValue::InstanceOf(*it) && (*it)->IsInteger())
+        ++count;
+    }
+  }
+  base::PrintPerfResult("InstanceOf", "check", timer.ElapsedNanoseconds(),
+                        kIterations * kArrayLength, "ns/value");
+  EXPECT_EQ(kIterations * kArrayLength / 4, count);
+}
+
+TEST(ValuePerfTest, Equals) {
+  scoped_ptr<ArrayValue> left(MakeIntegerArray());
+  scoped_ptr<ArrayValue> right(MakeIntegerArray());
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(left->Equals(right.get()));
+  base::PrintPerfResult("Equals", "compare", timer.ElapsedNanoseconds(),
+                        kIterations * kArrayLength, "ns/value");
+}
+
+TEST(ValuePerfTest, GetFieldAs) {
+  const std::string kNames[] = {
+      "NewThreadId", "OldThreadId", "NewThreadPriority", "OldThreadPriority",
+      "PreviousCState", "SpareByte", "OldThreadWaitReason",
+      "OldThreadWaitMode", "OldThreadState", "OldThreadWaitIdealProcessor",
+      "NewThreadWaitTime", "Reserved" };
+  const size_t kNamesCount = sizeof(kNames) / sizeof(kNames[0]);
+
+  StructValue fields;
+  for (size_t i = 0; i < kNamesCount; ++i)
+    fields.AddField<UIntValue>(kNames[i], static_cast<uint32>(i));
+
+  uint64 sum = 0;
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations * 10; ++i) {
+    for (size_t j = 0; j < kNamesCount; ++j) {
+      const UIntValue* value = NULL;
+      ASSERT_TRUE(fields.GetFieldAs<UIntValue>(kNames[j], &value));
+      sum += value->GetValue();
+    }
+  }
+  base::PrintPerfResult("GetFieldAs", "access", timer.ElapsedNanoseconds(),
+                        kIterations * 10 * kNamesCount, "ns/field");
+  EXPECT_LT(0U, sum);
+}
+
+}  // namespace event
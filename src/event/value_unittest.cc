@@ -23,6 +23,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <sstream>
 #include <string>
 
 #include "event/value.h"
@@ -42,6 +43,58 @@ class IncrementOnDelete : public IntValue {
   int* ptr_;
 };
 
+// Counts the visited values by category and sums the integers.
+class CountingVisitor : public ValueVisitor {
+ public:
+  CountingVisitor() : scalars_(0), arrays_(0), structs_(0), sum_(0) {
+  }
+
+  virtual void Visit(const BoolValue& value) OVERRIDE { ++scalars_; }
+  virtual void Visit(const CharValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const UCharValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const ShortValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const UShortValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const IntValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const UIntValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const LongValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const ULongValue& value) OVERRIDE { Add(value); }
+  virtual void Visit(const FloatValue& value) OVERRIDE { ++scalars_; }
+  virtual void Visit(const DoubleValue& value) OVERRIDE { ++scalars_; }
+  virtual void Visit(const StringValue& value) OVERRIDE { ++scalars_; }
+  virtual void Visit(const WStringValue& value) OVERRIDE { ++scalars_; }
+
+  virtual void Visit(const ArrayValue& value) OVERRIDE {
+    ++arrays_;
+    ArrayValue::const_iterator it = value.values_begin();
+    for (; it != value.values_end(); ++it)
+      (*it)->Accept(this);
+  }
+
+  virtual void Visit(const StructValue& value) OVERRIDE {
+    ++structs_;
+    StructValue::const_iterator it = value.fields_begin();
+    for (; it != value.fields_end(); ++it)
+      it->second->Accept(this);
+  }
+
+  int scalars() const { return scalars_; }
+  int arrays() const { return arrays_; }
+  int structs() const { return structs_; }
+  int64 sum() const { return sum_; }
+
+ private:
+  template<class T>
+  void Add(const T& value) {
+    ++scalars_;
+    sum_ += static_cast<int64>(value.GetValue());
+  }
+
+  int scalars_;
+  int arrays_;
+  int structs_;
+  int64 sum_;
+};
+
 }  // namespace
 
 TEST(ScalarValueTest, Accessors) {
@@ -883,6 +936,50 @@ TEST(StructValueTest, AddFieldTakesOwnership) {
   EXPECT_EQ(NULL, other.get());
 }
 
+TEST(StructValueTest, ManyFields) {
+  const int kFields = 1000;
+  StructValue value;
+  for (int i = 0; i < kFields; ++i) {
+    std::stringstream name;
+    name << "field" << i;
+    EXPECT_TRUE(value.AddField<IntValue>(name.str(), i));
+    EXPECT_FALSE(value.AddField<IntValue>(name.str(), -i));
+  }
+
+  for (int i = 0; i < kFields; ++i) {
+    std::stringstream name;
+    name << "field" << i;
+    int32 field = 0;
+    EXPECT_TRUE(value.GetFieldAsInteger(name.str(), &field));
+    EXPECT_EQ(i, field);
+  }
+  EXPECT_FALSE(value.HasField("field_dummy"));
+
+  // The fields keep their insertion order.
+  int i = 0;
+  for (StructValue::const_iterator it = value.fields_begin();
+       it != value.fields_end(); ++it, ++i) {
+    std::stringstream name;
+    name << "field" << i;
+    EXPECT_EQ(name.str(), it->first.c_str());
+  }
+  EXPECT_EQ(kFields, i);
+}
+
+TEST(StructValueTest, AddNewField) {
+  StructValue value;
+  value.ReserveFields(2);
+  value.AddNewField("first", scoped_ptr<Value>(new IntValue(1)));
+  value.AddNewField("second", scoped_ptr<Value>(new IntValue(2)));
+  EXPECT_FALSE(value.AddField<IntValue>("second", 3));
+
+  int32 field = 0;
+  EXPECT_TRUE(value.GetFieldAsInteger("second", &field));
+  EXPECT_EQ(2, field);
+  StructValue::const_iterator it = value.fields_begin();
+  EXPECT_EQ("first", it->first);
+}
+
 TEST(StructValueTest, Iterate) {
   scoped_ptr<Value> v1(new IntValue(42));
   scoped_ptr<Value> v2(new IntValue(43));
@@ -1004,4 +1101,25 @@ TEST(StructValueTest, Destructor) {
   EXPECT_EQ(3, count);
 }
 
+TEST(ValueVisitorTest, Accept) {
+  scoped_ptr<ArrayValue> array(new ArrayValue());
+  array->Append<CharValue>(-2);
+  array->Append<UShortValue>(3);
+  array->Append<StringValue>("dummy");
+
+  StructValue value;
+  EXPECT_TRUE(value.AddField<IntValue>("int", 10));
+  EXPECT_TRUE(value.AddField<ULongValue>("ulong", 100));
+  EXPECT_TRUE(value.AddField<DoubleValue>("double", 1.5));
+  EXPECT_TRUE(value.AddField<BoolValue>("bool", true));
+  EXPECT_TRUE(value.AddField("array", array.PassAs<Value>()));
+
+  CountingVisitor visitor;
+  value.Accept(&visitor);
+  EXPECT_EQ(7, visitor.scalars());
+  EXPECT_EQ(1, visitor.arrays());
+  EXPECT_EQ(1, visitor.structs());
+  EXPECT_EQ(111, visitor.sum());
+}
+
 }  // namespace event
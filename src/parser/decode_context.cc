@@ -0,0 +1,67 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/decode_context.h"
+
+#include "base/thread_local.h"
+
+namespace parser {
+
+namespace {
+
+// Leaked: the slot must outlive the threads, which delete their context on
+// exit.
+base::ThreadLocalOwnedPointer<DecodeContext>* CurrentDecodeContextSlot() {
+  static base::ThreadLocalOwnedPointer<DecodeContext>* slot =
+      new base::ThreadLocalOwnedPointer<DecodeContext>;
+  return slot;
+}
+
+}  // namespace
+
+DecodeContext::DecodeContext()
+    : operation_(NULL),
+      category_(NULL),
+      stack_table_(NULL) {
+}
+
+void DecodeContext::Reset() {
+  operation_ = NULL;
+  category_ = NULL;
+  scratch_string_.clear();
+}
+
+DecodeContext* DecodeContext::Current() {
+  base::ThreadLocalOwnedPointer<DecodeContext>* slot =
+      CurrentDecodeContextSlot();
+  DecodeContext* context = slot->Get();
+  if (context == NULL) {
+    context = new DecodeContext();
+    slot->Set(context);
+  }
+  return context;
+}
+
+}  // namespace parser
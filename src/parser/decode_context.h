@@ -0,0 +1,99 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The decode context holds the state that a parser reuses from one decoded
+// event to the next, so that the steady-state decoding of an event does not
+// allocate. Each thread has its own context:
+//
+//   DecodeContext* context = DecodeContext::Current();
+//   context->Reset();
+//   if (decode(provider_id, version, opcode, payload, size, context, &fields))
+//     Use(context->operation(), context->category(), fields);
+//
+// The values created by the decoders recycle their memory through the free
+// list of the thread (see base/free_list.h).
+
+#ifndef PARSER_DECODE_CONTEXT_H_
+#define PARSER_DECODE_CONTEXT_H_
+
+#include <string>
+
+#include "base/base.h"
+
+namespace event {
+class StackTable;
+}  // namespace event
+
+namespace parser {
+
+class DecodeContext {
+ public:
+  DecodeContext();
+
+  // Clears the result of the last decoded event. The buffers keep their
+  // capacity.
+  void Reset();
+
+  // The names of the operation and of the category of the last decoded event.
+  // They point to static strings: two events of the same type have the same
+  // pointers, which makes them usable as identifiers. NULL until set.
+  // @{
+  const char* operation() const { return operation_; }
+  const char* category() const { return category_; }
+  void set_operation(const char* operation) { operation_ = operation; }
+  void set_category(const char* category) { category_ = category; }
+  // @}
+
+  // @returns a string buffer that keeps its capacity between events, e.g. to
+  //     format the provider identifier of an event.
+  std::string* scratch_string() { return &scratch_string_; }
+
+  // The table interning the call stacks of the decoded events. When set, the
+  // stacks are decoded as a stack identifier instead of an array of frames.
+  // The context doesn't own the table. Reset() keeps the table. The parsers
+  // set it for the duration of a parse from Parser::set_stack_table().
+  // @{
+  event::StackTable* stack_table() const { return stack_table_; }
+  void set_stack_table(event::StackTable* stack_table) {
+    stack_table_ = stack_table;
+  }
+  // @}
+
+  // @returns the decode context of the calling thread. It is created on first
+  //     use and deleted when the thread exits.
+  static DecodeContext* Current();
+
+ private:
+  const char* operation_;
+  const char* category_;
+  std::string scratch_string_;
+  event::StackTable* stack_table_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecodeContext);
+};
+
+}  // namespace parser
+
+#endif  // PARSER_DECODE_CONTEXT_H_
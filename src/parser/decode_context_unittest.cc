@@ -0,0 +1,222 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/decode_context.h"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/scoped_ptr.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/etw/etw_raw_kernel_payload_decoder.h"
+
+namespace {
+
+// The number of heap allocations made while |counting_allocations| is set.
+volatile base::subtle::Atomic32 allocation_count = 0;
+volatile base::subtle::Atomic32 counting_allocations = 0;
+
+void* Allocate(size_t size) {
+  if (base::subtle::NoBarrier_Load(&counting_allocations) != 0)
+    base::subtle::NoBarrier_AtomicIncrement(&allocation_count, 1);
+  return malloc(size == 0 ? 1 : size);
+}
+
+// Counts the heap allocations of a scope.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter() {
+    base::subtle::NoBarrier_Store(&allocation_count, 0);
+    base::subtle::NoBarrier_Store(&counting_allocations, 1);
+  }
+
+  ~ScopedAllocationCounter() {
+    base::subtle::NoBarrier_Store(&counting_allocations, 0);
+  }
+
+  base::subtle::Atomic32 count() const {
+    return base::subtle::NoBarrier_Load(&allocation_count);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ScopedAllocationCounter);
+};
+
+}  // namespace
+
+// The replacement operators apply to the whole test binary: every form is
+// replaced, so that each allocation is freed by its matching form, and they
+// only count while a ScopedAllocationCounter is alive.
+void* operator new(size_t size) {
+  void* block = Allocate(size);
+  if (block == NULL)
+    throw std::bad_alloc();
+  return block;
+}
+
+void* operator new[](size_t size) {
+  void* block = Allocate(size);
+  if (block == NULL)
+    throw std::bad_alloc();
+  return block;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+  return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw() {
+  return Allocate(size);
+}
+
+void operator delete(void* block) throw() {
+  free(block);
+}
+
+void operator delete[](void* block) throw() {
+  free(block);
+}
+
+void operator delete(void* block, size_t) throw() {
+  free(block);
+}
+
+void operator delete[](void* block, size_t) throw() {
+  free(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) throw() {
+  free(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) throw() {
+  free(block);
+}
+
+namespace parser {
+
+namespace {
+
+using event::StringValue;
+using event::StructValue;
+using event::UCharValue;
+using event::ULongValue;
+using event::Value;
+
+const std::string kThreadProviderId = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+const unsigned char kThreadCSwitchOpcode = 36;
+
+const unsigned char kThreadCSwitchPayloadV2[] = {
+    0xCC, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x04,
+    0x01, 0x00, 0x00, 0x00, 0x87, 0x6D, 0x88, 0x34
+    };
+
+// Decodes a CSwitch event and wraps it with its header fields, as done by the
+// ETW parser.
+void DecodeCSwitchEvent(etw::RawETWKernelPayloadDecoder decode,
+                        DecodeContext* context) {
+  context->Reset();
+  context->scratch_string()->assign(kThreadProviderId);
+
+  scoped_ptr<Value> payload;
+  ASSERT_TRUE(decode(*context->scratch_string(), 2, kThreadCSwitchOpcode,
+                     reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+                     sizeof(kThreadCSwitchPayloadV2), context, &payload));
+
+  scoped_ptr<StructValue> fields(new StructValue());
+  EXPECT_TRUE(fields->AddField<StringValue>("operation", context->operation()));
+  EXPECT_TRUE(fields->AddField<StringValue>("category", context->category()));
+  EXPECT_TRUE(fields->AddField<ULongValue>("process_id", 42));
+  EXPECT_TRUE(fields->AddField<ULongValue>("thread_id", 43));
+  EXPECT_TRUE(fields->AddField<UCharValue>("processor_number", 1));
+  EXPECT_TRUE(fields->AddField("content", payload.Pass()));
+}
+
+}  // namespace
+
+TEST(DecodeContextTest, Reset) {
+  DecodeContext context;
+  EXPECT_EQ(NULL, context.operation());
+  EXPECT_EQ(NULL, context.category());
+
+  context.set_operation("CSwitch");
+  context.set_category("Thread");
+  context.scratch_string()->assign("dummy");
+  EXPECT_STREQ("CSwitch", context.operation());
+  EXPECT_STREQ("Thread", context.category());
+
+  context.Reset();
+  EXPECT_EQ(NULL, context.operation());
+  EXPECT_EQ(NULL, context.category());
+  EXPECT_TRUE(context.scratch_string()->empty());
+}
+
+TEST(DecodeContextTest, CurrentIsReused) {
+  DecodeContext* context = DecodeContext::Current();
+  ASSERT_TRUE(context != NULL);
+  EXPECT_EQ(context, DecodeContext::Current());
+}
+
+TEST(DecodeContextTest, StaticOperationAndCategory) {
+  etw::RawETWKernelPayloadDecoder decode =
+      etw::GetRawETWKernelPayloadDecoder(false);
+  DecodeContext* context = DecodeContext::Current();
+
+  DecodeCSwitchEvent(decode, context);
+  const char* operation = context->operation();
+  const char* category = context->category();
+  EXPECT_STREQ("CSwitch", operation);
+  EXPECT_STREQ("Thread", category);
+
+  // Events of the same type report the same strings.
+  DecodeCSwitchEvent(decode, context);
+  EXPECT_EQ(operation, context->operation());
+  EXPECT_EQ(category, context->category());
+}
+
+TEST(DecodeContextTest, SteadyStateDecodeDoesNotAllocate) {
+  etw::RawETWKernelPayloadDecoder decode =
+      etw::GetRawETWKernelPayloadDecoder(false);
+  DecodeContext* context = DecodeContext::Current();
+
+  // The first events fill the free lists and the scratch buffers.
+  DecodeCSwitchEvent(decode, context);
+  DecodeCSwitchEvent(decode, context);
+
+  base::subtle::Atomic32 allocations = 0;
+  {
+    ScopedAllocationCounter counter;
+    for (int i = 0; i < 100; ++i)
+      DecodeCSwitchEvent(decode, context);
+    allocations = counter.count();
+  }
+  EXPECT_EQ(0, allocations);
+}
+
+}  // namespace parser
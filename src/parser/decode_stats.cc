@@ -0,0 +1,261 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/decode_stats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+#include <vector>
+
+#include "base/lock.h"
+#include "base/logging.h"
+#include "base/thread_local.h"
+#include "base/time.h"
+#include "parser/decoder.h"
+
+namespace parser {
+
+namespace {
+
+// The counters of a single thread. The lock is only contended while a
+// snapshot is taken.
+struct ThreadDecodeStats {
+  ThreadDecodeStats() : has_last(false) { }
+
+  base::Lock lock;
+  DecodeStatsSnapshot counters;
+
+  // The last updated entry. Events of the same kind tend to come in bursts.
+  bool has_last;
+  DecodeStatsSnapshot::iterator last;
+};
+
+typedef std::vector<ThreadDecodeStats*> ThreadDecodeStatsList;
+
+// The counters of all threads that recorded statistics. The counters are kept
+// until the end of the process so that exited threads remain accounted.
+base::Lock registry_lock;
+ThreadDecodeStatsList registry;
+
+base::ThreadLocalPointer<ThreadDecodeStats> current_thread_stats;
+
+ThreadDecodeStats* GetThreadDecodeStats() {
+  ThreadDecodeStats* stats = current_thread_stats.Get();
+  if (stats != NULL)
+    return stats;
+
+  stats = new ThreadDecodeStats();
+  current_thread_stats.Set(stats);
+
+  base::AutoLock lock(registry_lock);
+  registry.push_back(stats);
+  return stats;
+}
+
+bool CompareByDecreasingTime(
+    const std::pair<DecodeStatsKey, DecodeCounters>& left,
+    const std::pair<DecodeStatsKey, DecodeCounters>& right) {
+  return left.second.nanoseconds > right.second.nanoseconds;
+}
+
+}  // namespace
+
+DecodeStatsKey::DecodeStatsKey(const std::string& provider_id,
+                               unsigned char opcode,
+                               unsigned char version)
+    : provider_id(provider_id),
+      opcode(opcode),
+      version(version) {
+}
+
+bool DecodeStatsKey::operator<(const DecodeStatsKey& other) const {
+  int compare = provider_id.compare(other.provider_id);
+  if (compare != 0)
+    return compare < 0;
+  if (opcode != other.opcode)
+    return opcode < other.opcode;
+  return version < other.version;
+}
+
+DecodeCounters::DecodeCounters()
+    : decoded(0),
+      failed(0),
+      trailing_bytes(0),
+      unsupported(0),
+      bytes(0),
+      nanoseconds(0) {
+}
+
+void DecodeCounters::Add(const DecodeCounters& other) {
+  decoded += other.decoded;
+  failed += other.failed;
+  trailing_bytes += other.trailing_bytes;
+  unsupported += other.unsupported;
+  bytes += other.bytes;
+  nanoseconds += other.nanoseconds;
+}
+
+bool IsDecodeStatsEnabled() {
+#if defined(ENABLE_DECODE_STATS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RecordDecodeStats(const std::string& provider_id,
+                       unsigned char opcode,
+                       unsigned char version,
+                       DecodeOutcome outcome,
+                       size_t bytes,
+                       uint64 nanoseconds) {
+  ThreadDecodeStats* stats = GetThreadDecodeStats();
+  DCHECK(stats != NULL);
+
+  base::AutoLock lock(stats->lock);
+
+  // Find the counters of this kind of event.
+  if (!stats->has_last ||
+      stats->last->first.opcode != opcode ||
+      stats->last->first.version != version ||
+      stats->last->first.provider_id != provider_id) {
+    DecodeStatsKey key(provider_id, opcode, version);
+    DecodeStatsSnapshot::iterator look = stats->counters.find(key);
+    if (look == stats->counters.end()) {
+      look = stats->counters.insert(
+          std::make_pair(key, DecodeCounters())).first;
+    }
+    stats->last = look;
+    stats->has_last = true;
+  }
+  DecodeCounters& counters = stats->last->second;
+
+  switch (outcome) {
+    case DECODE_OK:
+      ++counters.decoded;
+      break;
+    case DECODE_FAILED:
+      ++counters.failed;
+      break;
+    case DECODE_TRAILING_BYTES:
+      ++counters.trailing_bytes;
+      break;
+    case DECODE_UNSUPPORTED:
+      ++counters.unsupported;
+      break;
+  }
+  counters.bytes += bytes;
+  counters.nanoseconds += nanoseconds;
+}
+
+void GetDecodeStatsSnapshot(DecodeStatsSnapshot* snapshot) {
+  DCHECK(snapshot != NULL);
+  snapshot->clear();
+
+  base::AutoLock lock(registry_lock);
+  ThreadDecodeStatsList::iterator stats = registry.begin();
+  for (; stats != registry.end(); ++stats) {
+    base::AutoLock thread_lock((*stats)->lock);
+    DecodeStatsSnapshot::const_iterator it = (*stats)->counters.begin();
+    for (; it != (*stats)->counters.end(); ++it)
+      (*snapshot)[it->first].Add(it->second);
+  }
+}
+
+void ResetDecodeStats() {
+  base::AutoLock lock(registry_lock);
+  ThreadDecodeStatsList::iterator stats = registry.begin();
+  for (; stats != registry.end(); ++stats) {
+    base::AutoLock thread_lock((*stats)->lock);
+    (*stats)->counters.clear();
+    (*stats)->has_last = false;
+  }
+}
+
+void PrintDecodeStatsReport(const DecodeStatsSnapshot& snapshot,
+                            std::ostream* out) {
+  DCHECK(out != NULL);
+
+  std::vector<std::pair<DecodeStatsKey, DecodeCounters> > rows(
+      snapshot.begin(), snapshot.end());
+  std::stable_sort(rows.begin(), rows.end(), CompareByDecreasingTime);
+
+  *out << std::left << std::setw(38) << "provider"
+       << std::right << std::setw(7) << "opcode"
+       << std::setw(8) << "version"
+       << std::setw(12) << "decoded"
+       << std::setw(10) << "failed"
+       << std::setw(10) << "trailing"
+       << std::setw(12) << "unsupported"
+       << std::setw(14) << "bytes"
+       << std::setw(12) << "total(ms)"
+       << std::setw(10) << "ns/event"
+       << std::endl;
+
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const DecodeStatsKey& key = rows[i].first;
+    const DecodeCounters& counters = rows[i].second;
+    uint64 events = counters.decoded + counters.failed +
+                    counters.trailing_bytes + counters.unsupported;
+    uint64 average = events == 0 ? 0 : counters.nanoseconds / events;
+
+    *out << std::left << std::setw(38) << key.provider_id
+         << std::right << std::setw(7) << static_cast<unsigned int>(key.opcode)
+         << std::setw(8) << static_cast<unsigned int>(key.version)
+         << std::setw(12) << counters.decoded
+         << std::setw(10) << counters.failed
+         << std::setw(10) << counters.trailing_bytes
+         << std::setw(12) << counters.unsupported
+         << std::setw(14) << counters.bytes
+         << std::setw(12) << counters.nanoseconds / 1000000
+         << std::setw(10) << average
+         << std::endl;
+  }
+}
+
+ScopedDecodeStats::ScopedDecodeStats(const std::string& provider_id,
+                                     unsigned char opcode,
+                                     unsigned char version,
+                                     const Decoder* decoder,
+                                     size_t payload_size)
+    : provider_id_(provider_id),
+      opcode_(opcode),
+      version_(version),
+      decoder_(decoder),
+      payload_size_(payload_size),
+      outcome_(DECODE_FAILED),
+      start_(base::NowNanoseconds()) {
+  DCHECK(decoder != NULL);
+}
+
+ScopedDecodeStats::~ScopedDecodeStats() {
+  uint64 elapsed = base::NowNanoseconds() - start_;
+  size_t consumed = payload_size_ - decoder_->RemainingBytes();
+  RecordDecodeStats(provider_id_, opcode_, version_, outcome_, consumed,
+                    elapsed);
+}
+
+}  // namespace parser
@@ -0,0 +1,176 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Per event type statistics about payload decoding. The counters are kept per
+// thread, so recording is cheap and uncontended, and are merged on demand into
+// a snapshot.
+//
+// The instrumentation of the decoders is compiled out unless the build defines
+// ENABLE_DECODE_STATS. The snapshot and report functions are always available
+// and produce empty results when the instrumentation is disabled.
+//
+//   parser::DecodeStatsSnapshot snapshot;
+//   parser::GetDecodeStatsSnapshot(&snapshot);
+//   parser::PrintDecodeStatsReport(snapshot, &std::cout);
+
+#ifndef PARSER_DECODE_STATS_H_
+#define PARSER_DECODE_STATS_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "base/base.h"
+
+namespace parser {
+
+// Forward declaration.
+class Decoder;
+
+// Identifies a kind of event by its provider, opcode and version.
+struct DecodeStatsKey {
+  DecodeStatsKey(const std::string& provider_id,
+                 unsigned char opcode,
+                 unsigned char version);
+
+  bool operator<(const DecodeStatsKey& other) const;
+
+  std::string provider_id;
+  unsigned char opcode;
+  unsigned char version;
+};
+
+// Counters for a kind of event.
+struct DecodeCounters {
+  DecodeCounters();
+
+  // Accumulates the counters of |other| into these counters.
+  void Add(const DecodeCounters& other);
+
+  // Number of payloads decoded successfully.
+  uint64 decoded;
+  // Number of payloads for which the decoder failed.
+  uint64 failed;
+  // Number of payloads decoded with unconsumed trailing bytes.
+  uint64 trailing_bytes;
+  // Number of payloads without a decoder for their provider, opcode or
+  // version.
+  uint64 unsupported;
+  // Number of payload bytes consumed by the decoder.
+  uint64 bytes;
+  // Cumulative time spent in the decoder, in nanoseconds.
+  uint64 nanoseconds;
+};
+
+// The outcome of the decoding of a payload.
+enum DecodeOutcome {
+  DECODE_OK,
+  DECODE_FAILED,
+  DECODE_TRAILING_BYTES,
+  DECODE_UNSUPPORTED
+};
+
+typedef std::map<DecodeStatsKey, DecodeCounters> DecodeStatsSnapshot;
+
+// @returns true if the decoders are instrumented in this build.
+bool IsDecodeStatsEnabled();
+
+// Records the decoding of a payload into the counters of the calling thread.
+// @param provider_id the provider of the event.
+// @param opcode the opcode of the event.
+// @param version the version of the event.
+// @param outcome the result of the decoding.
+// @param bytes the number of payload bytes consumed.
+// @param nanoseconds the time spent decoding the payload.
+void RecordDecodeStats(const std::string& provider_id,
+                       unsigned char opcode,
+                       unsigned char version,
+                       DecodeOutcome outcome,
+                       size_t bytes,
+                       uint64 nanoseconds);
+
+// Merges the counters of all threads.
+// @param snapshot receives the merged counters.
+void GetDecodeStatsSnapshot(DecodeStatsSnapshot* snapshot);
+
+// Clears the counters of all threads.
+void ResetDecodeStats();
+
+// Writes a table of the counters, sorted by decreasing decode time.
+// @param snapshot the counters to print.
+// @param out the stream receiving the report.
+void PrintDecodeStatsReport(const DecodeStatsSnapshot& snapshot,
+                            std::ostream* out);
+
+// Measures the decoding of a payload and records it when leaving the scope.
+// The outcome is DECODE_FAILED unless set otherwise.
+class ScopedDecodeStats {
+ public:
+  // @param provider_id the provider of the event.
+  // @param opcode the opcode of the event.
+  // @param version the version of the event.
+  // @param decoder the decoder consuming the payload.
+  // @param payload_size the size of the payload, in bytes.
+  ScopedDecodeStats(const std::string& provider_id,
+                    unsigned char opcode,
+                    unsigned char version,
+                    const Decoder* decoder,
+                    size_t payload_size);
+  ~ScopedDecodeStats();
+
+  void set_outcome(DecodeOutcome outcome) { outcome_ = outcome; }
+
+ private:
+  const std::string& provider_id_;
+  unsigned char opcode_;
+  unsigned char version_;
+  const Decoder* decoder_;
+  size_t payload_size_;
+  DecodeOutcome outcome_;
+  uint64 start_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedDecodeStats);
+};
+
+}  // namespace parser
+
+#if defined(ENABLE_DECODE_STATS)
+#define DECODE_STATS_SCOPE(name, provider_id, opcode, version, decoder, size) \
+    parser::ScopedDecodeStats name(provider_id, opcode, version, decoder, size)
+#define DECODE_STATS_OUTCOME(name, outcome) \
+    name.set_outcome(parser::outcome)
+// The decoders name the operation once the opcode and version are known, so a
+// miss that leaves |operation| unset is an event without a decoder.
+#define DECODE_STATS_MISS(name, operation) \
+    name.set_outcome((operation) == NULL ? parser::DECODE_UNSUPPORTED : \
+                                           parser::DECODE_FAILED)
+#else
+#define DECODE_STATS_SCOPE(name, provider_id, opcode, version, decoder, size)
+#define DECODE_STATS_OUTCOME(name, outcome)
+#define DECODE_STATS_MISS(name, operation)
+#endif
+
+#endif  // PARSER_DECODE_STATS_H_
@@ -0,0 +1,199 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/decode_stats.h"
+
+#include <sstream>
+
+#include "base/scoped_ptr.h"
+#include "base/thread.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/etw/etw_raw_kernel_payload_decoder.h"
+
+namespace parser {
+
+namespace {
+
+const char kProviderId[] = "CE1DBFB4-137E-4DA6-87B0-3F59AA102CBC";
+const char kOtherProviderId[] = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+
+class Recorder : public base::Thread::Delegate {
+ public:
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < 100; ++i)
+      RecordDecodeStats(kProviderId, 46, 2, DECODE_OK, 16, 10);
+  }
+};
+
+}  // namespace
+
+TEST(DecodeStatsTest, RecordAndSnapshot) {
+  ResetDecodeStats();
+
+  RecordDecodeStats(kProviderId, 46, 2, DECODE_OK, 16, 100);
+  RecordDecodeStats(kProviderId, 46, 2, DECODE_OK, 16, 200);
+  RecordDecodeStats(kProviderId, 46, 2, DECODE_FAILED, 4, 50);
+  RecordDecodeStats(kProviderId, 46, 3, DECODE_TRAILING_BYTES, 8, 10);
+  RecordDecodeStats(kOtherProviderId, 36, 2, DECODE_UNSUPPORTED, 0, 5);
+
+  DecodeStatsSnapshot snapshot;
+  GetDecodeStatsSnapshot(&snapshot);
+  ASSERT_EQ(3U, snapshot.size());
+
+  const DecodeCounters& sample =
+      snapshot[DecodeStatsKey(kProviderId, 46, 2)];
+  EXPECT_EQ(2U, sample.decoded);
+  EXPECT_EQ(1U, sample.failed);
+  EXPECT_EQ(0U, sample.trailing_bytes);
+  EXPECT_EQ(0U, sample.unsupported);
+  EXPECT_EQ(36U, sample.bytes);
+  EXPECT_EQ(350U, sample.nanoseconds);
+
+  const DecodeCounters& trailing =
+      snapshot[DecodeStatsKey(kProviderId, 46, 3)];
+  EXPECT_EQ(1U, trailing.trailing_bytes);
+  EXPECT_EQ(8U, trailing.bytes);
+
+  const DecodeCounters& unsupported =
+      snapshot[DecodeStatsKey(kOtherProviderId, 36, 2)];
+  EXPECT_EQ(1U, unsupported.unsupported);
+}
+
+TEST(DecodeStatsTest, MergeThreads) {
+  ResetDecodeStats();
+
+  Recorder recorder;
+  base::Thread thread1(&recorder);
+  base::Thread thread2(&recorder);
+  ASSERT_TRUE(thread1.Start());
+  ASSERT_TRUE(thread2.Start());
+  thread1.Join();
+  thread2.Join();
+  recorder.Run();
+
+  DecodeStatsSnapshot snapshot;
+  GetDecodeStatsSnapshot(&snapshot);
+  ASSERT_EQ(1U, snapshot.size());
+
+  const DecodeCounters& counters = snapshot.begin()->second;
+  EXPECT_EQ(300U, counters.decoded);
+  EXPECT_EQ(4800U, counters.bytes);
+  EXPECT_EQ(3000U, counters.nanoseconds);
+}
+
+TEST(DecodeStatsTest, Reset) {
+  RecordDecodeStats(kProviderId, 46, 2, DECODE_OK, 16, 100);
+  ResetDecodeStats();
+
+  DecodeStatsSnapshot snapshot;
+  GetDecodeStatsSnapshot(&snapshot);
+  EXPECT_TRUE(snapshot.empty());
+
+  RecordDecodeStats(kProviderId, 46, 2, DECODE_OK, 16, 100);
+  GetDecodeStatsSnapshot(&snapshot);
+  ASSERT_EQ(1U, snapshot.size());
+  EXPECT_EQ(1U, snapshot.begin()->second.decoded);
+}
+
+TEST(DecodeStatsTest, PrintReport) {
+  DecodeStatsSnapshot snapshot;
+  snapshot[DecodeStatsKey(kProviderId, 46, 2)].decoded = 10;
+  snapshot[DecodeStatsKey(kProviderId, 46, 2)].nanoseconds = 1000;
+  snapshot[DecodeStatsKey(kOtherProviderId, 36, 2)].decoded = 1;
+  snapshot[DecodeStatsKey(kOtherProviderId, 36, 2)].nanoseconds = 5000000;
+
+  std::stringstream ss;
+  PrintDecodeStatsReport(snapshot, &ss);
+  std::string report = ss.str();
+
+  // The most expensive event type comes first.
+  size_t first = report.find(kOtherProviderId);
+  size_t second = report.find(kProviderId);
+  ASSERT_NE(std::string::npos, first);
+  ASSERT_NE(std::string::npos, second);
+  EXPECT_LT(first, second);
+  EXPECT_NE(std::string::npos, report.find("ns/event"));
+}
+
+#if defined(ENABLE_DECODE_STATS)
+TEST(DecodeStatsTest, InstrumentedDecoder) {
+  ResetDecodeStats();
+
+  // A PerfInfo SysClExit event followed by a trailing byte.
+  const unsigned char kPayload[] = { 0x00, 0x00, 0x00, 0x00, 0xFF };
+  std::string operation;
+  std::string category;
+  scoped_ptr<event::Value> fields;
+
+  EXPECT_TRUE(etw::DecodeRawETWKernelPayload(
+      kProviderId, 2, 52, true, reinterpret_cast<const char*>(&kPayload[0]),
+      4, &operation, &category, &fields));
+  EXPECT_FALSE(etw::DecodeRawETWKernelPayload(
+      kProviderId, 2, 52, true, reinterpret_cast<const char*>(&kPayload[0]),
+      sizeof(kPayload), &operation, &category, &fields));
+  EXPECT_FALSE(etw::DecodeRawETWKernelPayload(
+      kProviderId, 2, 52, true, reinterpret_cast<const char*>(&kPayload[0]),
+      2, &operation, &category, &fields));
+  EXPECT_FALSE(etw::DecodeRawETWKernelPayload(
+      kProviderId, 9, 52, true, reinterpret_cast<const char*>(&kPayload[0]),
+      4, &operation, &category, &fields));
+  EXPECT_FALSE(etw::DecodeRawETWKernelPayload(
+      kProviderId, 2, 0xEE, true, reinterpret_cast<const char*>(&kPayload[0]),
+      4, &operation, &category, &fields));
+  EXPECT_FALSE(etw::DecodeRawETWKernelPayload(
+      "00000000-0000-0000-0000-000000000000", 2, 52, true,
+      reinterpret_cast<const char*>(&kPayload[0]), 4,
+      &operation, &category, &fields));
+
+  DecodeStatsSnapshot snapshot;
+  GetDecodeStatsSnapshot(&snapshot);
+  ASSERT_EQ(4U, snapshot.size());
+
+  const DecodeCounters& exit = snapshot[DecodeStatsKey(kProviderId, 52, 2)];
+  EXPECT_EQ(1U, exit.decoded);
+  EXPECT_EQ(1U, exit.trailing_bytes);
+  EXPECT_EQ(1U, exit.failed);
+  EXPECT_EQ(0U, exit.unsupported);
+
+  // An unknown version or opcode has no decoder.
+  const DecodeCounters& version =
+      snapshot[DecodeStatsKey(kProviderId, 52, 9)];
+  EXPECT_EQ(0U, version.failed);
+  EXPECT_EQ(1U, version.unsupported);
+  EXPECT_EQ(0U, version.bytes);
+
+  const DecodeCounters& opcode =
+      snapshot[DecodeStatsKey(kProviderId, 0xEE, 2)];
+  EXPECT_EQ(0U, opcode.failed);
+  EXPECT_EQ(1U, opcode.unsupported);
+
+  const DecodeCounters& unsupported = snapshot[
+      DecodeStatsKey("00000000-0000-0000-0000-000000000000", 52, 2)];
+  EXPECT_EQ(1U, unsupported.unsupported);
+}
+#endif
+
+}  // namespace parser
@@ -40,6 +40,7 @@
 #ifndef PARSER_DECODER_H_
 #define PARSER_DECODER_H_
 
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <set>
@@ -116,6 +117,32 @@ class Decoder {
     return array.Pass();
   }
 
+  // Consume a block of bytes.
+  // @param size the number of bytes to consume.
+  // @returns a pointer to the consumed bytes, NULL if there is not enough
+  //     remaining bytes.
+  const char* Consume(size_t size) {
+    if (RemainingBytes() < size)
+      return NULL;
+    const char* bytes = &buffer_[position_];
+    position_ += size;
+    return bytes;
+  }
+
+  // Decode a plain structure by copying its bytes.
+  // @tparam T the type of the structure. Must be a POD without padding.
+  // @param value receives the decoded structure.
+  // @returns true if successful, false if there is not enough bytes.
+  template <typename T>
+  bool DecodeRaw(T* value) {
+    DCHECK(value != NULL);
+    const char* bytes = Consume(sizeof(T));
+    if (bytes == NULL)
+      return false;
+    memcpy(value, bytes, sizeof(T));
+    return true;
+  }
+
   // Decode a string.
   // @returns the decoded string.
   scoped_ptr<StringValue> DecodeString();
@@ -167,4 +167,33 @@ TEST(DecoderTest, DecodeFixedW16String) {
   EXPECT_EQ(0, WStringValue::GetValue(value.get()).compare(expected));
 }
 
+TEST(DecoderTest, Consume) {
+  Decoder decoder(&kSmallBuffer[0], kSmallBufferLength);
+  const char* bytes = decoder.Consume(3);
+  ASSERT_TRUE(bytes != NULL);
+  EXPECT_EQ(&kSmallBuffer[0], bytes);
+  EXPECT_EQ(kSmallBufferLength - 3U, decoder.RemainingBytes());
+
+  EXPECT_TRUE(decoder.Consume(kSmallBufferLength) == NULL);
+  EXPECT_EQ(kSmallBufferLength - 3U, decoder.RemainingBytes());
+}
+
+TEST(DecoderTest, DecodeRaw) {
+  struct Pair {
+    uint16 first;
+    uint16 second;
+  };
+
+  Decoder decoder(&kSmallBuffer[0], kSmallBufferLength);
+  Pair pair = {};
+  EXPECT_TRUE(decoder.DecodeRaw(&pair));
+  EXPECT_EQ(0x0201U, pair.first);
+  EXPECT_EQ(0x0403U, pair.second);
+  EXPECT_EQ(kSmallBufferLength - 4U, decoder.RemainingBytes());
+
+  uint64 value = 0;
+  EXPECT_FALSE(decoder.DecodeRaw(&value));
+  EXPECT_EQ(kSmallBufferLength - 4U, decoder.RemainingBytes());
+}
+
 }  // namespace parser
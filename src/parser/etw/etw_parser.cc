@@ -35,7 +35,9 @@
 #include "base/string_utils.h"
 #include "event/event.h"
 #include "event/value.h"
+#include "parser/decode_context.h"
 #include "parser/etw/etw_raw_kernel_payload_decoder.h"
+#include "parser/etw/etw_raw_record.h"
 
 namespace parser {
 namespace etw {
@@ -55,8 +57,22 @@ using event::Value;
 // TODO(fdoray): If threaded, this could be a Thread-Local Storage.
 const base::Observer<Event>* event_observer = NULL;
 
+// The state of a trace, reachable from its events through their user context.
+struct TraceContext {
+  // The kernel payload decoder specialized for the pointer width of the
+  // system that generated the trace.
+  RawETWKernelPayloadDecoder decode_kernel_payload;
+
+  // Indicates whether the trace was generated on a 64-bit OS.
+  bool is_64_bit;
+
+  // The writer capturing the raw events. Not owned. May be NULL.
+  ETWRawRecordWriter* record_writer;
+};
+
 //  Convert a GUID to a string representation.
-std::string GuidToString(const GUID& guid) {
+void GuidToString(const GUID& guid, std::string* result) {
+  DCHECK(result != NULL);
   const int kMaxGuidStringLength = 38;
   char buffer[kMaxGuidStringLength];
   sprintf_s(buffer, kMaxGuidStringLength,
@@ -72,21 +88,43 @@ std::string GuidToString(const GUID& guid) {
       guid.Data4[5],
       guid.Data4[6],
       guid.Data4[7]);
-  return std::string(buffer);
+  result->assign(buffer);
 }
 
-bool DecodeRawETWPayload(const std::string& provider_id,
+// Captures the raw event before decoding.
+void WriteRawRecord(const TraceContext& trace_context,
+                    const EVENT_RECORD& record) {
+  DCHECK(trace_context.record_writer != NULL);
+
+  ETWRawRecordHeader header = {};
+  COMPILE_ASSERT(sizeof(header.provider_id) == sizeof(GUID),
+                 provider_id_must_hold_a_guid);
+  memcpy(header.provider_id, &record.EventHeader.ProviderId,
+         sizeof(header.provider_id));
+  header.timestamp = record.EventHeader.TimeStamp.QuadPart;
+  header.process_id = record.EventHeader.ProcessId;
+  header.thread_id = record.EventHeader.ThreadId;
+  header.payload_size = record.UserDataLength;
+  header.processor_number = record.BufferContext.ProcessorNumber;
+  header.version = record.EventHeader.EventDescriptor.Version;
+  header.opcode = record.EventHeader.EventDescriptor.Opcode;
+  header.flags = trace_context.is_64_bit ? kETWRawRecordFlag64Bit : 0;
+
+  trace_context.record_writer->Write(
+      header, reinterpret_cast<const char*>(record.UserData));
+}
+
+bool DecodeRawETWPayload(const TraceContext& trace_context,
+                         const std::string& provider_id,
                          unsigned char version,
                          unsigned char opcode,
-                         bool is_64_bit,
                          const char* payload,
                          size_t payload_size,
-                         std::string* operation,
-                         std::string* category,
+                         DecodeContext* decode_context,
                          scoped_ptr<event::Value>* decoded_payload) {
-  if (DecodeRawETWKernelPayload(
-          provider_id, version, opcode, is_64_bit, payload, payload_size,
-          operation, category, decoded_payload)) {
+  if (trace_context.decode_kernel_payload(
+          provider_id, version, opcode, payload, payload_size,
+          decode_context, decoded_payload)) {
     return true;
   }
   return false;
@@ -94,30 +132,37 @@ bool DecodeRawETWPayload(const std::string& provider_id,
 
 void WINAPI ProcessEvent(PEVENT_RECORD pevent) {
   DCHECK(pevent != NULL);
+  const TraceContext* trace_context =
+      static_cast<const TraceContext*>(pevent->UserContext);
+  DCHECK(trace_context != NULL);
 
-  // Decode the payload of the event.
-  std::string operation;
-  std::string category;
+  if (trace_context->record_writer != NULL)
+    WriteRawRecord(*trace_context, *pevent);
 
-  std::string provider_guid = GuidToString(pevent->EventHeader.ProviderId);
+  // The decode context is reused from one event to the next.
+  DecodeContext* decode_context = DecodeContext::Current();
+  decode_context->Reset();
+
+  // Decode the payload of the event.
+  std::string* provider_guid = decode_context->scratch_string();
+  GuidToString(pevent->EventHeader.ProviderId, provider_guid);
   scoped_ptr<Value> payload;
   if (!DecodeRawETWPayload(
-          provider_guid,
+          *trace_context,
+          *provider_guid,
           pevent->EventHeader.EventDescriptor.Version,
           pevent->EventHeader.EventDescriptor.Opcode,
-          (pevent->EventHeader.Flags & EVENT_HEADER_FLAG_64_BIT_HEADER) != 0,
           reinterpret_cast<const char*>(pevent->UserData),
           pevent->UserDataLength,
-          &operation,
-          &category,
+          decode_context,
           &payload)) {
     return;
   }
 
   // Generate the event header fields.
   scoped_ptr<StructValue> fields(new StructValue());
-  fields->AddField<StringValue>("operation", operation);
-  fields->AddField<StringValue>("category", category);
+  fields->AddField<StringValue>("operation", decode_context->operation());
+  fields->AddField<StringValue>("category", decode_context->category());
   fields->AddField<ULongValue>("process_id", pevent->EventHeader.ProcessId);
   fields->AddField<ULongValue>("thread_id", pevent->EventHeader.ThreadId);
   fields->AddField<UCharValue>("processor_number",
@@ -149,12 +194,14 @@ void ETWParser::Parse(const base::Observer<Event>& observer) {
   // Open all trace files, and keep handles in a vector.
   bool error = false;
   std::vector<TRACEHANDLE> handles;
+  std::vector<TraceContext> contexts(traces_.size());
   for (size_t i = 0; i < traces_.size(); ++i) {
     EVENT_TRACE_LOGFILE trace;
     ::memset(&trace, 0, sizeof(trace));
     trace.LogFileName = const_cast<LPWSTR>(traces_[i].c_str());
     trace.ProcessTraceMode = PROCESS_TRACE_MODE_EVENT_RECORD;
     trace.EventRecordCallback = &ProcessEvent;
+    trace.Context = &contexts[i];
 
     TRACEHANDLE th = ::OpenTrace(&trace);
     if (th == INVALID_PROCESSTRACE_HANDLE) {
@@ -164,15 +211,29 @@ void ETWParser::Parse(const base::Observer<Event>& observer) {
       break;
     }
 
+    // A trace never mixes pointer widths: select the decoder once.
+    contexts[i].is_64_bit = trace.LogfileHeader.PointerSize == 8;
+    contexts[i].decode_kernel_payload =
+        GetRawETWKernelPayloadDecoder(contexts[i].is_64_bit);
+    contexts[i].record_writer = record_writer_;
+
     handles.push_back(th);
   }
 
   if (!error && !handles.empty()) {
+    // The callbacks run on this thread: its decode context interns the
+    // stacks into the table of the parser.
+    DecodeContext* decode_context = DecodeContext::Current();
+    event::StackTable* previous_stack_table = decode_context->stack_table();
+    decode_context->set_stack_table(stack_table());
+
     // Ask the ETW API to consume all traces and call the registered callbacks.
     ULONG status = ::ProcessTrace(&handles[0], traces_.size(), NULL, NULL);
     if (status != ERROR_SUCCESS) {
       LOG(ERROR) << "ProcessTrace failed with error " << status << ".";
     }
+
+    decode_context->set_stack_table(previous_stack_table);
   }
 
   // Close all trace files.
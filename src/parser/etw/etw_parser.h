@@ -37,12 +37,15 @@
 namespace parser {
 namespace etw {
 
+// Forward declaration.
+class ETWRawRecordWriter;
+
 // Generate Event objects from ETW trace files.
 class ETWParser : public parser::ParserImpl {
  public:
 
   // Constuctor.
-  ETWParser() : parser::ParserImpl() {
+  ETWParser() : parser::ParserImpl(), record_writer_(NULL) {
   }
 
   // Adds a trace file to the list of traces to parse.
@@ -54,10 +57,21 @@ class ETWParser : public parser::ParserImpl {
   // @param observer an observer that will receive the decoded events.
   void Parse(const base::Observer<event::Event>& observer) OVERRIDE;
 
+  // Captures the raw events of the parsed traces, including the events that
+  // fail to decode, so they can be replayed by ETWRawRecordParser.
+  // @param record_writer the writer receiving the raw events, or NULL to stop
+  //     capturing. Not owned.
+  void set_record_writer(ETWRawRecordWriter* record_writer) {
+    record_writer_ = record_writer;
+  }
+
  private:
   // Trace files to consume.
   std::vector<std::wstring> traces_;
 
+  // The writer capturing the raw events. Not owned. May be NULL.
+  ETWRawRecordWriter* record_writer_;
+
   DISALLOW_COPY_AND_ASSIGN(ETWParser);
 };
 
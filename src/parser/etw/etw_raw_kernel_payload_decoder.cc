@@ -25,10 +25,17 @@
 
 #include "parser/etw/etw_raw_kernel_payload_decoder.h"
 
+#include <cstring>
+#include <vector>
+
 #include "base/logging.h"
+#include "event/stack_table.h"
 #include "event/value.h"
+#include "parser/decode_context.h"
+#include "parser/decode_stats.h"
 #include "parser/decoder.h"
 #include "parser/etw/etw_raw_payload_decoder_utils.h"
+#include "parser/fixed_layout.h"
 
 namespace parser {
 namespace etw {
@@ -39,6 +46,7 @@ using event::CharValue;
 using event::IntValue;
 using event::LongValue;
 using event::ShortValue;
+using event::StackId;
 using event::StringValue;
 using event::StructValue;
 using event::UCharValue;
@@ -47,6 +55,9 @@ using event::ULongValue;
 using event::UShortValue;
 using event::Value;
 
+// Only one decoding error out of this period is logged for each provider.
+const int32 kDecodeErrorLogPeriod = 1000;
+
 // Constants for EventTraceEvent events.
 const std::string kEventTraceEventProviderId =
     "68FDD900-4A3E-11D1-84F4-0000F80464E3";
@@ -236,13 +247,163 @@ const unsigned char kPageFaultHRDestroyOpcode = 104;
 const unsigned char kPageFaultImageLoadBackedOpcode = 105;
 const unsigned char kPageFaultUnknown112Opcode = 112;
 const unsigned char kPageFaultVirtualAllocDCStartOpcode = 128;
-const unsigned char kPageFaultVirtualAllocDCEndpcode = 129;
-
+const unsigned char kPageFaultVirtualAllocDCEndOpcode = 129;
+
+// Layouts of the fixed-size payloads. The order of the fields is the order in
+// which they are added to the decoded structure. Pointer-sized fields use the
+// pointer type of the architecture.
+#pragma pack(push, 1)
+
+template <typename Arch>
+struct PerfInfoISRLayout {
+  uint64 initial_time;
+  typename Arch::Pointer routine;
+  uint8 return_value;
+  uint16 vector;
+  uint8 reserved;
+};
+
+template <typename Arch>
+struct PerfInfoISRMSILayout {
+  uint64 initial_time;
+  typename Arch::Pointer routine;
+  uint8 return_value;
+  uint16 vector;
+  uint8 reserved;
+  uint32 message_number;
+};
+
+template <typename Arch>
+struct PerfInfoDPCLayout {
+  uint64 initial_time;
+  typename Arch::Pointer routine;
+};
+
+template <typename Arch>
+struct PerfInfoSampleProfLayout {
+  typename Arch::Pointer instruction_pointer;
+  uint32 thread_id;
+  uint16 count;
+  uint16 reserved;
+};
+
+struct ThreadCSwitchLayout {
+  uint32 new_thread_id;
+  uint32 old_thread_id;
+  int8 new_thread_priority;
+  int8 old_thread_priority;
+  uint8 previous_c_state;
+  int8 spare_byte;
+  int8 old_thread_wait_reason;
+  int8 old_thread_wait_mode;
+  int8 old_thread_state;
+  int8 old_thread_wait_ideal_processor;
+  uint32 new_thread_wait_time;
+  uint32 reserved;
+};
+
+template <typename Arch>
+struct TcplpGroup1IPV4Layout {
+  uint32 pid;
+  uint32 size;
+  uint32 daddr;
+  uint32 saddr;
+  uint16 dport;
+  uint16 sport;
+  uint32 seqnum;
+  typename Arch::Pointer connid;
+};
+
+struct DiskIOReadWriteLayout {
+  uint32 disk_number;
+  uint32 irp_flags;
+  uint32 transfer_size;
+  uint32 reserved;
+  uint64 byte_offset;
+  uint64 file_object;
+  uint64 irp;
+  uint64 high_res_response_time;
+};
+
+struct DiskIOReadWriteV3Layout {
+  uint32 disk_number;
+  uint32 irp_flags;
+  uint32 transfer_size;
+  uint32 reserved;
+  uint64 byte_offset;
+  uint64 file_object;
+  uint64 irp;
+  uint64 high_res_response_time;
+  uint32 issuing_thread_id;
+};
+
+#pragma pack(pop)
+
+COMPILE_ASSERT(sizeof(PerfInfoISRLayout<Arch32>) == 16,
+               invalid_isr_layout_32);
+COMPILE_ASSERT(sizeof(PerfInfoISRLayout<Arch64>) == 20,
+               invalid_isr_layout_64);
+COMPILE_ASSERT(sizeof(TcplpGroup1IPV4Layout<Arch64>) == 32,
+               invalid_tcplp_group1_layout_64);
+COMPILE_ASSERT(sizeof(ThreadCSwitchLayout) == 24, invalid_cswitch_layout);
+COMPILE_ASSERT(sizeof(DiskIOReadWriteLayout) == 48, invalid_diskio_layout);
+
+// The schemas of the layouts that do not depend on the architecture. The
+// other schemas are declared by their decoding function.
+const FixedLayoutField kThreadCSwitchSchema[] = {
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, new_thread_id, UIntValue,
+                     "NewThreadId"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, old_thread_id, UIntValue,
+                     "OldThreadId"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, new_thread_priority, CharValue,
+                     "NewThreadPriority"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, old_thread_priority, CharValue,
+                     "OldThreadPriority"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, previous_c_state, UCharValue,
+                     "PreviousCState"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, spare_byte, CharValue,
+                     "SpareByte"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, old_thread_wait_reason, CharValue,
+                     "OldThreadWaitReason"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, old_thread_wait_mode, CharValue,
+                     "OldThreadWaitMode"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, old_thread_state, CharValue,
+                     "OldThreadState"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, old_thread_wait_ideal_processor,
+                     CharValue, "OldThreadWaitIdealProcessor"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, new_thread_wait_time, UIntValue,
+                     "NewThreadWaitTime"),
+  FIXED_LAYOUT_FIELD(ThreadCSwitchLayout, reserved, UIntValue, "Reserved")
+};
+
+#define DISKIO_READ_WRITE_FIELDS(layout) \
+    FIXED_LAYOUT_FIELD(layout, disk_number, UIntValue, "DiskNumber"), \
+    FIXED_LAYOUT_FIELD(layout, irp_flags, UIntValue, "IrpFlags"), \
+    FIXED_LAYOUT_FIELD(layout, transfer_size, UIntValue, "TransferSize"), \
+    FIXED_LAYOUT_FIELD(layout, reserved, UIntValue, "Reserved"), \
+    FIXED_LAYOUT_FIELD(layout, byte_offset, ULongValue, "ByteOffset"), \
+    FIXED_LAYOUT_FIELD(layout, file_object, ULongValue, "FileObject"), \
+    FIXED_LAYOUT_FIELD(layout, irp, ULongValue, "Irp"), \
+    FIXED_LAYOUT_FIELD(layout, high_res_response_time, ULongValue, \
+                       "HighResResponseTime")
+
+const FixedLayoutField kDiskIOReadWriteSchema[] = {
+  DISKIO_READ_WRITE_FIELDS(DiskIOReadWriteLayout)
+};
+
+const FixedLayoutField kDiskIOReadWriteV3Schema[] = {
+  DISKIO_READ_WRITE_FIELDS(DiskIOReadWriteV3Layout),
+  FIXED_LAYOUT_FIELD(DiskIOReadWriteV3Layout, issuing_thread_id, UIntValue,
+                     "IssuingThreadId")
+};
+
+#undef DISKIO_READ_WRITE_FIELDS
+
+template <typename Arch>
 bool DecodeEventTraceHeaderPayload(Decoder* decoder,
                                    unsigned char version,
                                    unsigned char opcode,
-                                   bool is_64_bit,
-                                   std::string* operation,
+                                   const char** operation,
                                    StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kEventTraceEventHeaderOpcode);
@@ -269,8 +430,8 @@ bool DecodeEventTraceHeaderPayload(Decoder* decoder,
       !Decode<UIntValue>("PointerSize", decoder, fields) ||
       !Decode<UIntValue>("EventsLost", decoder, fields) ||
       !Decode<UIntValue>("CPUSpeed", decoder, fields) ||
-      !DecodeUInteger("LoggerName", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("LogFileName", is_64_bit, decoder, fields) ||
+      !DecodePointer<Arch>("LoggerName", decoder, fields) ||
+      !DecodePointer<Arch>("LogFileName", decoder, fields) ||
       !DecodeTimeZoneInformation("TimeZoneInformation", decoder, fields) ||
       !Decode<UIntValue>("Padding", decoder, fields) ||
       !Decode<ULongValue>("BootTime", decoder, fields) ||
@@ -286,11 +447,11 @@ bool DecodeEventTraceHeaderPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeEventTraceExtensionPayload(Decoder* decoder,
                                       unsigned char version,
                                       unsigned char opcode,
-                                      bool /* is_64_bit */,
-                                      std::string* operation,
+                                      const char** operation,
                                       StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kEventTraceEventExtensionOpcode);
@@ -323,11 +484,11 @@ bool DecodeEventTraceExtensionPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeEventTracePayload(Decoder* decoder,
                              unsigned char version,
                              unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
+                             const char** operation,
                              StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -335,21 +496,21 @@ bool DecodeEventTracePayload(Decoder* decoder,
 
   switch (opcode) {
     case kEventTraceEventHeaderOpcode:
-      return DecodeEventTraceHeaderPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeEventTraceHeaderPayload<Arch>(
+          decoder, version, opcode, operation, fields);
     case kEventTraceEventExtensionOpcode:
-      return DecodeEventTraceExtensionPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeEventTraceExtensionPayload<Arch>(
+          decoder, version, opcode, operation, fields);
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeImagePayload(Decoder* decoder,
                         unsigned char version,
                         unsigned char opcode,
-                        bool is_64_bit,
-                        std::string* operation,
+                        const char** operation,
                         StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -388,7 +549,7 @@ bool DecodeImagePayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("BaseAddress", is_64_bit, decoder, fields))
+  if (!DecodePointer<Arch>("BaseAddress", decoder, fields))
     return false;
 
   if (opcode == kImageKernelBaseOpcode)
@@ -398,7 +559,7 @@ bool DecodeImagePayload(Decoder* decoder,
     if (!Decode<UIntValue>("ModuleSize", decoder, fields))
       return false;
   } else {
-    if (!DecodeUInteger("ModuleSize", is_64_bit, decoder, fields))
+    if (!DecodePointer<Arch>("ModuleSize", decoder, fields))
       return false;
   }
 
@@ -425,7 +586,7 @@ bool DecodeImagePayload(Decoder* decoder,
   }
 
   if (version >= 2 && (
-      !DecodeUInteger("DefaultBase", is_64_bit, decoder, fields) ||
+      !DecodePointer<Arch>("DefaultBase", decoder, fields) ||
       !Decode<UIntValue>("Reserved1", decoder, fields) ||
       !Decode<UIntValue>("Reserved2", decoder, fields) ||
       !Decode<UIntValue>("Reserved3", decoder, fields) ||
@@ -439,11 +600,11 @@ bool DecodeImagePayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePerfInfoCollectionPayload(Decoder* decoder,
                                      unsigned char version,
                                      unsigned char opcode,
-                                     bool /* is_64_bit */,
-                                     std::string* operation,
+                                     const char** operation,
                                      StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -486,11 +647,11 @@ bool DecodePerfInfoCollectionPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePerfInfoCollectionSecondPayload(Decoder* decoder,
                                            unsigned char version,
                                            unsigned char opcode,
-                                           bool /* is_64_bit */,
-                                           std::string* operation,
+                                           const char** operation,
                                            StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -525,11 +686,11 @@ bool DecodePerfInfoCollectionSecondPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePerfInfoISRPayload(Decoder* decoder,
                               unsigned char version,
                               unsigned char opcode,
-                              bool is_64_bit,
-                              std::string* operation,
+                              const char** operation,
                               StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -554,27 +715,36 @@ bool DecodePerfInfoISRPayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!Decode<ULongValue>("InitialTime", decoder, fields) ||
-      !DecodeUInteger("Routine", is_64_bit, decoder, fields) ||
-      !Decode<UCharValue>("ReturnValue", decoder, fields) ||
-      !Decode<UShortValue>("Vector", decoder, fields) ||
-      !Decode<UCharValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  if (opcode == kPerfInfoISRMSIOpcode &&
-      !Decode<UIntValue>("MessageNumber", decoder, fields)) {
-    return false;
-  }
-
-  return true;
+  typedef typename Arch::PointerValue PointerValue;
+  if (opcode == kPerfInfoISRMSIOpcode) {
+    typedef PerfInfoISRMSILayout<Arch> Layout;
+    static const FixedLayoutField kSchema[] = {
+      FIXED_LAYOUT_FIELD(Layout, initial_time, ULongValue, "InitialTime"),
+      FIXED_LAYOUT_FIELD(Layout, routine, PointerValue, "Routine"),
+      FIXED_LAYOUT_FIELD(Layout, return_value, UCharValue, "ReturnValue"),
+      FIXED_LAYOUT_FIELD(Layout, vector, UShortValue, "Vector"),
+      FIXED_LAYOUT_FIELD(Layout, reserved, UCharValue, "Reserved"),
+      FIXED_LAYOUT_FIELD(Layout, message_number, UIntValue, "MessageNumber")
+    };
+    return DecodeFixedLayout<Layout>(kSchema, decoder, fields);
+  }
+
+  typedef PerfInfoISRLayout<Arch> Layout;
+  static const FixedLayoutField kSchema[] = {
+    FIXED_LAYOUT_FIELD(Layout, initial_time, ULongValue, "InitialTime"),
+    FIXED_LAYOUT_FIELD(Layout, routine, PointerValue, "Routine"),
+    FIXED_LAYOUT_FIELD(Layout, return_value, UCharValue, "ReturnValue"),
+    FIXED_LAYOUT_FIELD(Layout, vector, UShortValue, "Vector"),
+    FIXED_LAYOUT_FIELD(Layout, reserved, UCharValue, "Reserved")
+  };
+  return DecodeFixedLayout<Layout>(kSchema, decoder, fields);
 }
 
+template <typename Arch>
 bool DecodePerfInfoDPCPayload(Decoder* decoder,
                               unsigned char version,
                               unsigned char opcode,
-                              bool is_64_bit,
-                              std::string* operation,
+                              const char** operation,
                               StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -603,19 +773,20 @@ bool DecodePerfInfoDPCPayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!Decode<ULongValue>("InitialTime", decoder, fields) ||
-      !DecodeUInteger("Routine", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
+  typedef PerfInfoDPCLayout<Arch> Layout;
+  static const FixedLayoutField kSchema[] = {
+    FIXED_LAYOUT_FIELD(Layout, initial_time, ULongValue, "InitialTime"),
+    FIXED_LAYOUT_FIELD(Layout, routine, typename Arch::PointerValue,
+                       "Routine")
+  };
+  return DecodeFixedLayout<Layout>(kSchema, decoder, fields);
 }
 
+template <typename Arch>
 bool DecodePerfInfoSysClEnterPayload(Decoder* decoder,
                                      unsigned char version,
                                      unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
+                                     const char** operation,
                                      StructValue* fields) {
   DCHECK(opcode == kPerfInfoSysClEnterOpcode);
   DCHECK(decoder != NULL);
@@ -629,17 +800,17 @@ bool DecodePerfInfoSysClEnterPayload(Decoder* decoder,
   *operation = "SysClEnter";
 
   // Decode the payload.
-  if (!DecodeUInteger("SysCallAddress", is_64_bit, decoder, fields))
+  if (!DecodePointer<Arch>("SysCallAddress", decoder, fields))
     return false;
 
   return true;
 }
 
+template <typename Arch>
 bool DecodePerfInfoSysClExitPayload(Decoder* decoder,
                                     unsigned char version,
                                     unsigned char opcode,
-                                    bool /* is_64_bit */,
-                                    std::string* operation,
+                                    const char** operation,
                                     StructValue* fields) {
   DCHECK(opcode == kPerfInfoSysClExitOpcode);
   DCHECK(decoder != NULL);
@@ -659,11 +830,11 @@ bool DecodePerfInfoSysClExitPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePerfInfoSampleProfPayload(Decoder* decoder,
                                      unsigned char version,
                                      unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
+                                     const char** operation,
                                      StructValue* fields) {
   DCHECK(opcode == kPerfInfoSampleProfOpcode);
   DCHECK(decoder != NULL);
@@ -677,21 +848,22 @@ bool DecodePerfInfoSampleProfPayload(Decoder* decoder,
   *operation = "SampleProf";
 
   // Decode the payload.
-  if (!DecodeUInteger("InstructionPointer", is_64_bit, decoder, fields) ||
-      !Decode<UIntValue>("ThreadId", decoder, fields) ||
-      !Decode<UShortValue>("Count", decoder, fields) ||
-      !Decode<UShortValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  return true;
+  typedef PerfInfoSampleProfLayout<Arch> Layout;
+  static const FixedLayoutField kSchema[] = {
+    FIXED_LAYOUT_FIELD(Layout, instruction_pointer,
+                       typename Arch::PointerValue, "InstructionPointer"),
+    FIXED_LAYOUT_FIELD(Layout, thread_id, UIntValue, "ThreadId"),
+    FIXED_LAYOUT_FIELD(Layout, count, UShortValue, "Count"),
+    FIXED_LAYOUT_FIELD(Layout, reserved, UShortValue, "Reserved")
+  };
+  return DecodeFixedLayout<Layout>(kSchema, decoder, fields);
 }
 
+template <typename Arch>
 bool DecodePerfInfoDebuggerEnabledPayload(Decoder* decoder,
                                           unsigned char version,
                                           unsigned char opcode,
-                                          bool /* is_64_bit */,
-                                          std::string* operation,
+                                          const char** operation,
                                           StructValue* fields) {
   DCHECK(opcode == kPerfInfoDebuggerEnabledOpcode);
   DCHECK(decoder != NULL);
@@ -707,11 +879,11 @@ bool DecodePerfInfoDebuggerEnabledPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePerfInfoPayload(Decoder* decoder,
                            unsigned char version,
                            unsigned char opcode,
-                           bool is_64_bit,
-                           std::string* operation,
+                           const char** operation,
                            StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -721,36 +893,36 @@ bool DecodePerfInfoPayload(Decoder* decoder,
     case kPerfInfoCollectionSetIntervalOpcode:
     case kPerfInfoCollectionStartOpcode:
     case kPerfInfoCollectionEndOpcode:
-      return DecodePerfInfoCollectionPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoCollectionPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoCollectionStartSecondOpcode:
     case kPerfInfoCollectionEndSecondOpcode:
-      return DecodePerfInfoCollectionSecondPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoCollectionSecondPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoISROpcode:
     case kPerfInfoISRMSIOpcode:
-      return DecodePerfInfoISRPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoISRPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoThreadedDPCOpcode:
     case kPerfInfoDPCOpcode:
     case kPerfInfoTimerDPCOpcode:
-      return DecodePerfInfoDPCPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoDPCPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoSysClEnterOpcode:
-      return DecodePerfInfoSysClEnterPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoSysClEnterPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoSysClExitOpcode:
-      return DecodePerfInfoSysClExitPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoSysClExitPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoSampleProfOpcode:
-      return DecodePerfInfoSampleProfPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoSampleProfPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPerfInfoUnknown80Opcode:
     case kPerfInfoUnknown81Opcode:
@@ -762,27 +934,27 @@ bool DecodePerfInfoPayload(Decoder* decoder,
       return true;
 
     case kPerfInfoDebuggerEnabledOpcode:
-      return DecodePerfInfoDebuggerEnabledPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePerfInfoDebuggerEnabledPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeThreadAutoBoostPayload(Decoder* decoder,
                                   unsigned char version,
                                   unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
+                                  const char** operation,
                                   StructValue* fields) {
-  DCHECK(is_64_bit);
+  DCHECK(Arch::kIs64Bit);
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event ThreadAutoBoost unsupported in 32 bit.";
+  if (!Arch::kIs64Bit) {
+    LOG_FIRST_N(ERROR, 1) << "Event ThreadAutoBoost unsupported in 32 bit.";
     return false;
   }
 
@@ -824,19 +996,19 @@ bool DecodeThreadAutoBoostPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeThreadAutoBoostSetFloorPayload(Decoder* decoder,
                                           unsigned char version,
                                           unsigned char opcode,
-                                          bool is_64_bit,
-                                          std::string* operation,
+                                          const char** operation,
                                           StructValue* fields) {
   DCHECK(opcode == kThreadAutoBoostSetFloorOpcode);
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event AutoBoostSetFloor unsupported in 32 bit.";
+  if (!Arch::kIs64Bit) {
+    LOG_FIRST_N(ERROR, 1) << "Event AutoBoostSetFloor unsupported in 32 bit.";
     return false;
   }
 
@@ -859,18 +1031,18 @@ bool DecodeThreadAutoBoostSetFloorPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeThreadSetPriorityPayload(Decoder* decoder,
                                     unsigned char version,
                                     unsigned char opcode,
-                                    bool is_64_bit,
-                                    std::string* operation,
+                                    const char** operation,
                                     StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event ThreadSetPriority unsupported in 32 bit.";
+  if (!Arch::kIs64Bit) {
+    LOG_FIRST_N(ERROR, 1) << "Event ThreadSetPriority unsupported in 32 bit.";
     return false;
   }
 
@@ -911,11 +1083,11 @@ bool DecodeThreadSetPriorityPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeThreadCSwitchPayload(Decoder* decoder,
                                 unsigned char version,
                                 unsigned char opcode,
-                                bool /* is_64_bit */,
-                                std::string* operation,
+                                const char** operation,
                                 StructValue* fields) {
   DCHECK(opcode == kThreadCSwitchOpcode);
   DCHECK(decoder != NULL);
@@ -929,29 +1101,15 @@ bool DecodeThreadCSwitchPayload(Decoder* decoder,
   *operation = "CSwitch";
 
   // Decode the payload.
-  if (!Decode<UIntValue>("NewThreadId", decoder, fields) ||
-      !Decode<UIntValue>("OldThreadId", decoder, fields) ||
-      !Decode<CharValue>("NewThreadPriority", decoder, fields) ||
-      !Decode<CharValue>("OldThreadPriority", decoder, fields) ||
-      !Decode<UCharValue>("PreviousCState", decoder, fields) ||
-      !Decode<CharValue>("SpareByte", decoder, fields) ||
-      !Decode<CharValue>("OldThreadWaitReason", decoder, fields) ||
-      !Decode<CharValue>("OldThreadWaitMode", decoder, fields) ||
-      !Decode<CharValue>("OldThreadState", decoder, fields) ||
-      !Decode<CharValue>("OldThreadWaitIdealProcessor", decoder, fields) ||
-      !Decode<UIntValue>("NewThreadWaitTime", decoder, fields) ||
-      !Decode<UIntValue>("Reserved", decoder, fields)) {
-    return false;
-  }
-
-  return true;
+  return DecodeFixedLayout<ThreadCSwitchLayout>(
+      kThreadCSwitchSchema, decoder, fields);
 }
 
+template <typename Arch>
 bool DecodeThreadCompCSPayload(Decoder* decoder,
                                unsigned char version,
                                unsigned char opcode,
-                               bool /* is_64_bit */,
-                               std::string* operation,
+                               const char** operation,
                                StructValue* fields) {
   DCHECK(opcode == kThreadCompCSOpcode);
   DCHECK(decoder != NULL);
@@ -966,15 +1124,16 @@ bool DecodeThreadCompCSPayload(Decoder* decoder,
 
   // This payload is a compressed version of the CSwitch event.
   // TODO(bergeret): Determine a way to decode this event.
-  LOG(ERROR) << "The CompCS Thread event is currently unsupported.";
+  LOG_FIRST_N(ERROR, 1)
+      << "The CompCS Thread event is currently unsupported.";
   return false;
 }
 
+template <typename Arch>
 bool DecodeThreadReadyThreadPayload(Decoder* decoder,
                                     unsigned char version,
                                     unsigned char opcode,
-                                    bool /* is_64_bit */,
-                                    std::string* operation,
+                                    const char** operation,
                                     StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kThreadReadyThreadOpcode);
@@ -999,19 +1158,19 @@ bool DecodeThreadReadyThreadPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeThreadSpinLockPayload(Decoder* decoder,
                                 unsigned char version,
                                 unsigned char opcode,
-                                bool is_64_bit,
-                                std::string* operation,
+                                const char** operation,
                                 StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kThreadSpinLockOpcode);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit) {
-    LOG(ERROR) << "Event ThreadSpinLock unsupported in 32 bit.";
+  if (!Arch::kIs64Bit) {
+    LOG_FIRST_N(ERROR, 1) << "Event ThreadSpinLock unsupported in 32 bit.";
     return false;
   }
 
@@ -1040,11 +1199,11 @@ bool DecodeThreadSpinLockPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeThreadStartEndPayload(Decoder* decoder,
                                  unsigned char version,
                                  unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
+                                 const char** operation,
                                  StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1081,36 +1240,36 @@ bool DecodeThreadStartEndPayload(Decoder* decoder,
 
   if (version == 1) {
     if ((opcode == kThreadStartOpcode || opcode == kThreadDCStartOpcode) && (
-        !DecodeUInteger("StackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Win32StartAddr", is_64_bit, decoder, fields) ||
+        !DecodePointer<Arch>("StackBase", decoder, fields) ||
+        !DecodePointer<Arch>("StackLimit", decoder, fields) ||
+        !DecodePointer<Arch>("UserStackBase", decoder, fields) ||
+        !DecodePointer<Arch>("UserStackLimit", decoder, fields) ||
+        !DecodePointer<Arch>("StartAddr", decoder, fields) ||
+        !DecodePointer<Arch>("Win32StartAddr", decoder, fields) ||
         // This field is a signed char, but is padded to an integer 32-bit.
         !Decode<CharValue>("WaitMode", decoder, fields) ||
         !decoder->Skip(3))) {
       return false;
     }
   } else if (version == 2) {
-    if (!DecodeUInteger("StackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Win32StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("TebBase", is_64_bit, decoder, fields) ||
+    if (!DecodePointer<Arch>("StackBase", decoder, fields) ||
+        !DecodePointer<Arch>("StackLimit", decoder, fields) ||
+        !DecodePointer<Arch>("UserStackBase", decoder, fields) ||
+        !DecodePointer<Arch>("UserStackLimit", decoder, fields) ||
+        !DecodePointer<Arch>("StartAddr", decoder, fields) ||
+        !DecodePointer<Arch>("Win32StartAddr", decoder, fields) ||
+        !DecodePointer<Arch>("TebBase", decoder, fields) ||
         !Decode<UIntValue>("SubProcessTag", decoder, fields)) {
       return false;
     }
   } else if (version == 3) {
-    if (!DecodeUInteger("StackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("StackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackBase", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("UserStackLimit", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Affinity", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("Win32StartAddr", is_64_bit, decoder, fields) ||
-        !DecodeUInteger("TebBase", is_64_bit, decoder, fields) ||
+    if (!DecodePointer<Arch>("StackBase", decoder, fields) ||
+        !DecodePointer<Arch>("StackLimit", decoder, fields) ||
+        !DecodePointer<Arch>("UserStackBase", decoder, fields) ||
+        !DecodePointer<Arch>("UserStackLimit", decoder, fields) ||
+        !DecodePointer<Arch>("Affinity", decoder, fields) ||
+        !DecodePointer<Arch>("Win32StartAddr", decoder, fields) ||
+        !DecodePointer<Arch>("TebBase", decoder, fields) ||
         !Decode<UIntValue>("SubProcessTag", decoder, fields) ||
         !Decode<UCharValue>("BasePriority", decoder, fields) ||
         !Decode<UCharValue>("PagePriority", decoder, fields) ||
@@ -1125,11 +1284,11 @@ bool DecodeThreadStartEndPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeThreadPayload(Decoder* decoder,
                          unsigned char version,
                          unsigned char opcode,
-                         bool is_64_bit,
-                         std::string* operation,
+                         const char** operation,
                          StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1137,54 +1296,54 @@ bool DecodeThreadPayload(Decoder* decoder,
 
   switch (opcode) {
     case kThreadCSwitchOpcode:
-      return DecodeThreadCSwitchPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadCSwitchPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadCompCSOpcode:
-      return DecodeThreadCompCSPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadCompCSPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadReadyThreadOpcode:
-      return DecodeThreadReadyThreadPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadReadyThreadPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadSpinLockOpcode:
-      return DecodeThreadSpinLockPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadSpinLockPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadDCStartOpcode:
     case kThreadStartOpcode:
     case kThreadDCEndOpcode:
     case kThreadEndOpcode:
-      return DecodeThreadStartEndPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadStartEndPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadAutoBoostClearFloorOpcode:
     case kThreadAutoBoostEntryExhaustionOpcode:
-      return DecodeThreadAutoBoostPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadAutoBoostPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadAutoBoostSetFloorOpcode:
-      return DecodeThreadAutoBoostSetFloorPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadAutoBoostSetFloorPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kThreadSetPriorityOpcode:
     case kThreadSetIoPriorityOpcode:
     case kThreadSetBasePriorityOpcode:
     case kThreadSetPagePriorityOpcode:
-      return DecodeThreadSetPriorityPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeThreadSetPriorityPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeProcessStartEndDefunctPayload(Decoder* decoder,
                                          unsigned char version,
                                          unsigned char opcode,
-                                         bool is_64_bit,
-                                         std::string* operation,
+                                         const char** operation,
                                          StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1227,12 +1386,12 @@ bool DecodeProcessStartEndDefunctPayload(Decoder* decoder,
 
   // Decode the payload.
   if (version == 1 &&
-      !DecodeUInteger("PageDirectoryBase", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("PageDirectoryBase", decoder, fields)) {
     return false;
   }
 
   if (version >= 2 &&
-      !DecodeUInteger("UniqueProcessKey", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("UniqueProcessKey", decoder, fields)) {
     return false;
   }
 
@@ -1248,7 +1407,7 @@ bool DecodeProcessStartEndDefunctPayload(Decoder* decoder,
   }
 
   if (version >= 3 &&
-      !DecodeUInteger("DirectoryTableBase", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("DirectoryTableBase", decoder, fields)) {
     return false;
   }
 
@@ -1257,7 +1416,7 @@ bool DecodeProcessStartEndDefunctPayload(Decoder* decoder,
     return false;
   }
 
-  if (!DecodeSID("UserSID", is_64_bit, decoder, fields))
+  if (!DecodeSID<Arch>("UserSID", decoder, fields))
     return false;
 
   if (version >= 1 &&
@@ -1284,14 +1443,14 @@ bool DecodeProcessStartEndDefunctPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeProcessTerminatePayload(Decoder* decoder,
                                    unsigned char version,
                                    unsigned char opcode,
-                                   bool is_64_bit,
-                                   std::string* operation,
+                                   const char** operation,
                                    StructValue* fields) {
   DCHECK(opcode == kProcessTerminateOpcode);
-  DCHECK(is_64_bit);
+  DCHECK(Arch::kIs64Bit);
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
@@ -1309,11 +1468,11 @@ bool DecodeProcessTerminatePayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeProcessPerfCtrPayload(Decoder* decoder,
                                  unsigned char version,
                                  unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
+                                 const char** operation,
                                  StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1342,29 +1501,28 @@ bool DecodeProcessPerfCtrPayload(Decoder* decoder,
       !Decode<UIntValue>("PageFaultCount", decoder, fields) ||
       !Decode<UIntValue>("HandleCount", decoder, fields) ||
       !Decode<UIntValue>("Reserved", decoder, fields) ||
-      !DecodeUInteger("PeakVirtualSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PeakWorkingSetSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PeakPagefileUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("QuotaPeakPagedPoolUsage", is_64_bit,  decoder, fields) ||
-      !DecodeUInteger("QuotaPeakNonPagedPoolUsage", is_64_bit, decoder,
-                      fields) ||
-      !DecodeUInteger("VirtualSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("WorkingSetSize", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PagefileUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("QuotaPagedPoolUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("QuotaNonPagedPoolUsage", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("PrivatePageCount", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("PeakVirtualSize", decoder, fields) ||
+      !DecodePointer<Arch>("PeakWorkingSetSize", decoder, fields) ||
+      !DecodePointer<Arch>("PeakPagefileUsage", decoder, fields) ||
+      !DecodePointer<Arch>("QuotaPeakPagedPoolUsage", decoder, fields) ||
+      !DecodePointer<Arch>("QuotaPeakNonPagedPoolUsage", decoder, fields) ||
+      !DecodePointer<Arch>("VirtualSize", decoder, fields) ||
+      !DecodePointer<Arch>("WorkingSetSize", decoder, fields) ||
+      !DecodePointer<Arch>("PagefileUsage", decoder, fields) ||
+      !DecodePointer<Arch>("QuotaPagedPoolUsage", decoder, fields) ||
+      !DecodePointer<Arch>("QuotaNonPagedPoolUsage", decoder, fields) ||
+      !DecodePointer<Arch>("PrivatePageCount", decoder, fields)) {
     return false;
   }
 
   return true;
 }
 
+template <typename Arch>
 bool DecodeProcessPayload(Decoder* decoder,
                           unsigned char version,
                           unsigned char opcode,
-                          bool is_64_bit,
-                          std::string* operation,
+                          const char** operation,
                           StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1376,28 +1534,28 @@ bool DecodeProcessPayload(Decoder* decoder,
     case kProcessDefunctOpcode:
     case kProcessDCEndOpcode:
     case kProcessEndOpcode:
-      return DecodeProcessStartEndDefunctPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeProcessStartEndDefunctPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kProcessTerminateOpcode:
-      return DecodeProcessTerminatePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeProcessTerminatePayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kProcessPerfCtrOpcode:
     case kProcessPerfCtrRundownOpcode:
-      return DecodeProcessPerfCtrPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeProcessPerfCtrPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeTcplpGroup1IPV4Payload(Decoder* decoder,
                                   unsigned char version,
                                   unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
+                                  const char** operation,
                                   StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1434,26 +1592,26 @@ bool DecodeTcplpGroup1IPV4Payload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!Decode<UIntValue>("PID", decoder, fields) ||
-      !Decode<UIntValue>("size", decoder, fields) ||
-      !Decode<UIntValue>("daddr", decoder, fields) ||
-      !Decode<UIntValue>("saddr", decoder, fields) ||
-      !Decode<UShortValue>("dport", decoder, fields) ||
-      !Decode<UShortValue>("sport", decoder, fields) ||
-      !Decode<UIntValue>("seqnum", decoder, fields) ||
-      !DecodeUInteger("connid", is_64_bit, decoder, fields)) {
-    return false;
-  }
-
-  return true;
+  typedef TcplpGroup1IPV4Layout<Arch> Layout;
+  static const FixedLayoutField kSchema[] = {
+    FIXED_LAYOUT_FIELD(Layout, pid, UIntValue, "PID"),
+    FIXED_LAYOUT_FIELD(Layout, size, UIntValue, "size"),
+    FIXED_LAYOUT_FIELD(Layout, daddr, UIntValue, "daddr"),
+    FIXED_LAYOUT_FIELD(Layout, saddr, UIntValue, "saddr"),
+    FIXED_LAYOUT_FIELD(Layout, dport, UShortValue, "dport"),
+    FIXED_LAYOUT_FIELD(Layout, sport, UShortValue, "sport"),
+    FIXED_LAYOUT_FIELD(Layout, seqnum, UIntValue, "seqnum"),
+    FIXED_LAYOUT_FIELD(Layout, connid, typename Arch::PointerValue, "connid")
+  };
+  return DecodeFixedLayout<Layout>(kSchema, decoder, fields);
 }
 
 
+template <typename Arch>
 bool DecodeTcplpGroup2IPV4Payload(Decoder* decoder,
                                   unsigned char version,
                                   unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
+                                  const char** operation,
                                   StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1490,18 +1648,18 @@ bool DecodeTcplpGroup2IPV4Payload(Decoder* decoder,
       !Decode<ShortValue>("rcvwinscale", decoder, fields) ||
       !Decode<ShortValue>("sndwinscale", decoder, fields) ||
       !Decode<UIntValue>("seqnum", decoder, fields) ||
-      !DecodeUInteger("connid", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("connid", decoder, fields)) {
     return false;
   }
 
   return true;
 }
 
+template <typename Arch>
 bool DecodeTcplpSendIPV4Payload(Decoder* decoder,
                                 unsigned char version,
                                 unsigned char opcode,
-                                bool is_64_bit,
-                                std::string* operation,
+                                const char** operation,
                                 StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kTcplpSendIPV4Opcode);
@@ -1524,18 +1682,18 @@ bool DecodeTcplpSendIPV4Payload(Decoder* decoder,
       !Decode<UIntValue>("startime", decoder, fields) ||
       !Decode<UIntValue>("endtime", decoder, fields) ||
       !Decode<UIntValue>("seqnum", decoder, fields) ||
-      !DecodeUInteger("connid", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("connid", decoder, fields)) {
     return false;
   }
 
   return true;
 }
 
+template <typename Arch>
 bool DecodeTcplpPayload(Decoder* decoder,
                         unsigned char version,
                         unsigned char opcode,
-                        bool is_64_bit,
-                        std::string* operation,
+                        const char** operation,
                         StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1547,28 +1705,28 @@ bool DecodeTcplpPayload(Decoder* decoder,
     case kTcplpRetransmitIPV4Opcode:
     case kTcplpReconnectIPV4Opcode:
     case kTcplpTCPCopyIPV4Opcode:
-      return DecodeTcplpGroup1IPV4Payload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeTcplpGroup1IPV4Payload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kTcplpConnectIPV4Opcode:
     case kTcplpAcceptIPV4Opcode:
-      return DecodeTcplpGroup2IPV4Payload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeTcplpGroup2IPV4Payload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kTcplpSendIPV4Opcode:
-      return DecodeTcplpSendIPV4Payload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeTcplpSendIPV4Payload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeRegistryGenericPayload(Decoder* decoder,
                                   unsigned char version,
                                   unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
+                                  const char** operation,
                                   StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1667,7 +1825,7 @@ bool DecodeRegistryGenericPayload(Decoder* decoder,
   // Decode the payload.
   if (version == 1) {
     if (!Decode<UIntValue>("Status", decoder, fields) ||
-        !DecodeUInteger("KeyHandle", is_64_bit, decoder, fields) ||
+        !DecodePointer<Arch>("KeyHandle", decoder, fields) ||
         !Decode<LongValue>("ElapsedTime", decoder, fields) ||
         !Decode<UIntValue>("Index", decoder, fields) ||
         !DecodeW16String("KeyName", decoder, fields)) {
@@ -1677,7 +1835,7 @@ bool DecodeRegistryGenericPayload(Decoder* decoder,
     if (!Decode<LongValue>("InitialTime", decoder, fields) ||
         !Decode<UIntValue>("Status", decoder, fields) ||
         !Decode<UIntValue>("Index", decoder, fields) ||
-        !DecodeUInteger("KeyHandle", is_64_bit, decoder, fields) ||
+        !DecodePointer<Arch>("KeyHandle", decoder, fields) ||
         !DecodeW16String("KeyName", decoder, fields)) {
       return false;
     }
@@ -1686,11 +1844,11 @@ bool DecodeRegistryGenericPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeRegistryCountersPayload(Decoder* decoder,
                                    unsigned char version,
                                    unsigned char opcode,
-                                   bool /* is_64_bit */,
-                                   std::string* operation,
+                                   const char** operation,
                                    StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kRegistryCountersOpcode);
@@ -1721,11 +1879,11 @@ bool DecodeRegistryCountersPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeRegistryConfigPayload(Decoder* decoder,
                                  unsigned char version,
                                  unsigned char opcode,
-                                 bool /* is_64_bit */,
-                                 std::string* operation,
+                                 const char** operation,
                                  StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kRegistryConfigOpcode);
@@ -1745,11 +1903,11 @@ bool DecodeRegistryConfigPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeRegistryPayload(Decoder* decoder,
                            unsigned char version,
                            unsigned char opcode,
-                           bool is_64_bit,
-                           std::string* operation,
+                           const char** operation,
                            StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1776,27 +1934,27 @@ bool DecodeRegistryPayload(Decoder* decoder,
     case kRegistryCloseOpcode:
     case kRegistrySetSecurityOpcode:
     case kRegistryQuerySecurityOpcode:
-      return DecodeRegistryGenericPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeRegistryGenericPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kRegistryCountersOpcode:
-      return DecodeRegistryCountersPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeRegistryCountersPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kRegistryConfigOpcode:
-      return DecodeRegistryConfigPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeRegistryConfigPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeFileIOFileNamePayload(Decoder* decoder,
                                  unsigned char version,
                                  unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
+                                 const char** operation,
                                  StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1821,7 +1979,7 @@ bool DecodeFileIOFileNamePayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
+  if (!DecodePointer<Arch>("FileObject", decoder, fields) ||
       !DecodeW16String("FileName", decoder, fields)) {
     return false;
   }
@@ -1829,11 +1987,11 @@ bool DecodeFileIOFileNamePayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOCreatePayload(Decoder* decoder,
                                unsigned char version,
                                unsigned char opcode,
-                               bool is_64_bit,
-                               std::string* operation,
+                               const char** operation,
                                StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kFileIOCreateOpcode);
@@ -1847,17 +2005,17 @@ bool DecodeFileIOCreatePayload(Decoder* decoder,
   *operation = "Create";
 
   // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
+  if (!DecodePointer<Arch>("IrpPtr", decoder, fields))
     return false;
 
   if (version == 2 && (
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields))) {
+      !DecodePointer<Arch>("TTID", decoder, fields) ||
+      !DecodePointer<Arch>("FileObject", decoder, fields))) {
     return false;
   }
 
   if (version == 3 && (
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
+      !DecodePointer<Arch>("FileObject", decoder, fields) ||
       !Decode<UIntValue>("TTID", decoder, fields))) {
     return false;
   }
@@ -1872,11 +2030,11 @@ bool DecodeFileIOCreatePayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOSimpleOpPayload(Decoder* decoder,
                                  unsigned char version,
                                  unsigned char opcode,
-                                 bool is_64_bit,
-                                 std::string* operation,
+                                 const char** operation,
                                  StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1901,19 +2059,19 @@ bool DecodeFileIOSimpleOpPayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
+  if (!DecodePointer<Arch>("IrpPtr", decoder, fields))
     return false;
 
   if (version == 2 && (
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields))) {
+      !DecodePointer<Arch>("TTID", decoder, fields) ||
+      !DecodePointer<Arch>("FileObject", decoder, fields) ||
+      !DecodePointer<Arch>("FileKey", decoder, fields))) {
     return false;
   }
 
   if (version == 3 && (
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields) ||
+      !DecodePointer<Arch>("FileObject", decoder, fields) ||
+      !DecodePointer<Arch>("FileKey", decoder, fields) ||
       !Decode<UIntValue>("TTID", decoder, fields))) {
     return false;
   }
@@ -1921,11 +2079,11 @@ bool DecodeFileIOSimpleOpPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOReadWritePayload(Decoder* decoder,
                                   unsigned char version,
                                   unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
+                                  const char** operation,
                                   StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -1948,17 +2106,17 @@ bool DecodeFileIOReadWritePayload(Decoder* decoder,
 
   // Decode the payload.
   if (!Decode<ULongValue>("Offset", decoder, fields) ||
-      !DecodeUInteger("IrpPtr", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("IrpPtr", decoder, fields)) {
     return false;
   }
   
   if (version == 2 &&
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("TTID", decoder, fields)) {
     return false;
   }
   
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields)) {
+  if (!DecodePointer<Arch>("FileObject", decoder, fields) ||
+      !DecodePointer<Arch>("FileKey", decoder, fields)) {
     return false;
   }
   
@@ -1973,23 +2131,23 @@ bool DecodeFileIOReadWritePayload(Decoder* decoder,
   }
 
   // Padding at the end of 64 bit events.
-  if (is_64_bit && version == 3 && !decoder->Skip(4))
+  if (Arch::kIs64Bit && version == 3 && !decoder->Skip(4))
     return false;
 
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOPathPayload(Decoder* decoder,
                              unsigned char version,
                              unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
+                             const char** operation,
                              StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit || version != 3)
+  if (!Arch::kIs64Bit || version != 3)
     return false;
 
   // Set the operation name.
@@ -2018,11 +2176,11 @@ bool DecodeFileIOPathPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOInfoPayload(Decoder* decoder,
                              unsigned char version,
                              unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
+                             const char** operation,
                              StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2053,18 +2211,18 @@ bool DecodeFileIOInfoPayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
+  if (!DecodePointer<Arch>("IrpPtr", decoder, fields))
     return false;
   
   if (version == 2 &&
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("TTID", decoder, fields)) {
     return false;
   }
   
 
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("ExtraInfo", is_64_bit, decoder, fields)) {
+  if (!DecodePointer<Arch>("FileObject", decoder, fields) ||
+      !DecodePointer<Arch>("FileKey", decoder, fields) ||
+      !DecodePointer<Arch>("ExtraInfo", decoder, fields)) {
     return false;
   }
   
@@ -2079,11 +2237,11 @@ bool DecodeFileIOInfoPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIODirPayload(Decoder* decoder,
                             unsigned char version,
                             unsigned char opcode,
-                            bool is_64_bit,
-                            std::string* operation,
+                            const char** operation,
                             StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2105,16 +2263,16 @@ bool DecodeFileIODirPayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields))
+  if (!DecodePointer<Arch>("IrpPtr", decoder, fields))
     return false;
   
   if (version == 2 &&
-      !DecodeUInteger("TTID", is_64_bit, decoder, fields)) {
+      !DecodePointer<Arch>("TTID", decoder, fields)) {
     return false;
   }
 
-  if (!DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileKey", is_64_bit, decoder, fields)) {
+  if (!DecodePointer<Arch>("FileObject", decoder, fields) ||
+      !DecodePointer<Arch>("FileKey", decoder, fields)) {
     return false;
   }
 
@@ -2133,11 +2291,11 @@ bool DecodeFileIODirPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOOperationEndPayload(Decoder* decoder,
                                      unsigned char version,
                                      unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
+                                     const char** operation,
                                      StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kFileIOOperationEndOpcode);
@@ -2151,8 +2309,8 @@ bool DecodeFileIOOperationEndPayload(Decoder* decoder,
   *operation = "OperationEnd";
 
   // Decode the payload.
-  if (!DecodeUInteger("IrpPtr", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("ExtraInfo", is_64_bit, decoder, fields) ||
+  if (!DecodePointer<Arch>("IrpPtr", decoder, fields) ||
+      !DecodePointer<Arch>("ExtraInfo", decoder, fields) ||
       !Decode<UIntValue>("NtStatus", decoder, fields)) {
     return false;
   }
@@ -2160,11 +2318,11 @@ bool DecodeFileIOOperationEndPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeFileIOPayload(Decoder* decoder,
                          unsigned char version,
                          unsigned char opcode,
-                         bool is_64_bit,
-                         std::string* operation,
+                         const char** operation,
                          StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2174,62 +2332,62 @@ bool DecodeFileIOPayload(Decoder* decoder,
     case kFileIOFileCreateOpcode:
     case kFileIOFileDeleteOpcode:
     case kFileIOFileRundownOpcode:
-      return DecodeFileIOFileNamePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOFileNamePayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIOCreateOpcode:
-      return DecodeFileIOCreatePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOCreatePayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIOCleanupOpcode:
     case kFileIOCloseOpcode:
     case kFileIOFlushOpcode:
-      return DecodeFileIOSimpleOpPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOSimpleOpPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIOReadOpcode:
     case kFileIOWriteOpcode:
-      return DecodeFileIOReadWritePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOReadWritePayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIODletePathOpcode:
     case kFileIORenamePathOpcode:
-      return DecodeFileIOPathPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOPathPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIOSetInfoOpcode:
     case kFileIODeleteOpcode:
     case kFileIORenameOpcode:
     case kFileIOQueryInfoOpcode:
     case kFileIOFSControlOpcode:
-      return DecodeFileIOInfoPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOInfoPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIODirEnumOpcode:
     case kFileIODirNotifyOpcode:
-      return DecodeFileIODirPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIODirPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kFileIOOperationEndOpcode:
-      return DecodeFileIOOperationEndPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeFileIOOperationEndPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeDiskIOReadWritePayload(Decoder* decoder,
                                   unsigned char version,
                                   unsigned char opcode,
-                                  bool is_64_bit,
-                                  std::string* operation,
+                                  const char** operation,
                                   StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit || version < 2 || version > 3)
+  if (!Arch::kIs64Bit || version < 2 || version > 3)
     return false;
 
   // Set the operation name.
@@ -2245,36 +2403,25 @@ bool DecodeDiskIOReadWritePayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!Decode<UIntValue>("DiskNumber", decoder, fields) ||
-      !Decode<UIntValue>("IrpFlags", decoder, fields) ||
-      !Decode<UIntValue>("TransferSize", decoder, fields) ||
-      !Decode<UIntValue>("Reserved", decoder, fields) ||
-      !Decode<ULongValue>("ByteOffset", decoder, fields) ||
-      !Decode<ULongValue>("FileObject", decoder, fields) ||
-      !Decode<ULongValue>("Irp", decoder, fields) ||
-      !Decode<ULongValue>("HighResResponseTime", decoder, fields)) {
-    return false;
-  }
-
-  if (version == 3 &&
-      !Decode<UIntValue>("IssuingThreadId", decoder, fields)) {
-    return false;
+  if (version == 3) {
+    return DecodeFixedLayout<DiskIOReadWriteV3Layout>(
+        kDiskIOReadWriteV3Schema, decoder, fields);
   }
-
-  return true;
+  return DecodeFixedLayout<DiskIOReadWriteLayout>(
+      kDiskIOReadWriteSchema, decoder, fields);
 }
 
+template <typename Arch>
 bool DecodeDiskIOInitPayload(Decoder* decoder,
                              unsigned char version,
                              unsigned char opcode,
-                             bool is_64_bit,
-                             std::string* operation,
+                             const char** operation,
                              StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit || version < 2 || version > 3)
+  if (!Arch::kIs64Bit || version < 2 || version > 3)
     return false;
 
   // Set the operation name.
@@ -2304,18 +2451,18 @@ bool DecodeDiskIOInitPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeDiskIOFlushBuffersPayload(Decoder* decoder,
                                      unsigned char version,
                                      unsigned char opcode,
-                                     bool is_64_bit,
-                                     std::string* operation,
+                                     const char** operation,
                                      StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kDiskIOFlushBuffersOpcode);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (!is_64_bit || version < 2 || version > 3)
+  if (!Arch::kIs64Bit || version < 2 || version > 3)
     return false;
 
   // Set the operation name.
@@ -2337,11 +2484,11 @@ bool DecodeDiskIOFlushBuffersPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodeDiskIOPayload(Decoder* decoder,
                          unsigned char version,
                          unsigned char opcode,
-                         bool is_64_bit,
-                         std::string* operation,
+                         const char** operation,
                          StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2350,35 +2497,36 @@ bool DecodeDiskIOPayload(Decoder* decoder,
   switch (opcode) {
     case kDiskIOReadOpcode:
     case kDiskIOWriteOpcode:
-      return DecodeDiskIOReadWritePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeDiskIOReadWritePayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kDiskIOReadInitOpcode:
     case kDiskIOWriteInitOpcode:
     case kDiskIOFlushInitOpcode:
-      return DecodeDiskIOInitPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeDiskIOInitPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kDiskIOFlushBuffersOpcode:
-      return DecodeDiskIOFlushBuffersPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodeDiskIOFlushBuffersPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
+template <typename Arch>
 bool DecodeStackWalkPayload(Decoder* decoder,
                             unsigned char version,
                             unsigned char opcode,
-                            bool is_64_bit,
-                            std::string* operation,
+                            event::StackTable* stack_table,
+                            const char** operation,
                             StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
   DCHECK(fields != NULL);
 
-  if (version != 2 || opcode != kStackWalkStackOpcode || !is_64_bit)
+  if (version != 2 || opcode != kStackWalkStackOpcode || !Arch::kIs64Bit)
     return false;
 
   // Set the operation name.
@@ -2391,19 +2539,41 @@ bool DecodeStackWalkPayload(Decoder* decoder,
   // Decode the payload.
   if (!Decode<ULongValue>("EventTimeStamp", decoder, fields) ||
       !Decode<UIntValue>("StackProcess", decoder, fields) ||
-      !Decode<UIntValue>("StackThread", decoder, fields) ||
-      !DecodeArray<ULongValue>("Stack", num_stack_pointers, decoder, fields)) {
+      !Decode<UIntValue>("StackThread", decoder, fields)) {
     return false;
   }
 
-  return true;
+  if (stack_table == NULL) {
+    return DecodeArray<ULongValue>("Stack", num_stack_pointers, decoder,
+                                   fields);
+  }
+
+  // Intern the stack and emit its identifier instead of its frames. The frames
+  // are copied to be aligned. ETW usually captures at most 192 frames: larger
+  // stacks are copied to the heap.
+  const size_t kMaxInlineFrames = 192;
+  const char* bytes = decoder->Consume(num_stack_pointers * sizeof(uint64));
+  if (bytes == NULL)
+    return false;
+  uint64 inline_frames[kMaxInlineFrames];
+  std::vector<uint64> heap_frames;
+  uint64* frames = &inline_frames[0];
+  if (num_stack_pointers > kMaxInlineFrames) {
+    heap_frames.resize(num_stack_pointers);
+    frames = &heap_frames[0];
+  }
+  memcpy(frames, bytes, num_stack_pointers * sizeof(uint64));
+
+  StackId id = stack_table->Insert(frames, num_stack_pointers);
+  return fields->AddField<UIntValue>(
+      "StackId", static_cast<uint32>(id.key_value()));
 }
 
+template <typename Arch>
 bool DecodePageFaultCommonPageFaultPayload(Decoder* decoder,
                                            unsigned char version,
                                            unsigned char opcode,
-                                           bool is_64_bit,
-                                           std::string* operation,
+                                           const char** operation,
                                            StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2437,19 +2607,19 @@ bool DecodePageFaultCommonPageFaultPayload(Decoder* decoder,
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("VirtualAddress", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("ProgramCounter", is_64_bit, decoder, fields)) {
+  if (!DecodePointer<Arch>("VirtualAddress", decoder, fields) ||
+      !DecodePointer<Arch>("ProgramCounter", decoder, fields)) {
     return false;
   }
 
   return true;
 }
 
+template <typename Arch>
 bool DecodePageFaultHardPageFaultPayload(Decoder* decoder,
                                          unsigned char version,
                                          unsigned char opcode,
-                                         bool is_64_bit,
-                                         std::string* operation,
+                                         const char** operation,
                                          StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(opcode == kPageFaultHardFaultOpcode);
@@ -2465,8 +2635,8 @@ bool DecodePageFaultHardPageFaultPayload(Decoder* decoder,
   // Decode the payload.
   if (!Decode<ULongValue>("InitialTime", decoder, fields) ||
       !Decode<ULongValue>("ReadOffset", decoder, fields) ||
-      !DecodeUInteger("VirtualAddress", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("FileObject", is_64_bit, decoder, fields) ||
+      !DecodePointer<Arch>("VirtualAddress", decoder, fields) ||
+      !DecodePointer<Arch>("FileObject", decoder, fields) ||
       !Decode<UIntValue>("TThreadId", decoder, fields) ||
       !Decode<UIntValue>("ByteCount", decoder, fields)) {
     return false;
@@ -2475,11 +2645,11 @@ bool DecodePageFaultHardPageFaultPayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePageFaultVirtualAllocFreePayload(Decoder* decoder,
                                             unsigned char version,
                                             unsigned char opcode,
-                                            bool is_64_bit,
-                                            std::string* operation,
+                                            const char** operation,
                                             StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2496,13 +2666,21 @@ bool DecodePageFaultVirtualAllocFreePayload(Decoder* decoder,
     case kPageFaultVirtualFreeOpcode:
       *operation = "VirtualFree";
       break;
+    case kPageFaultVirtualAllocDCStartOpcode:
+      // Enumerates the committed regions at the beginning of the trace.
+      *operation = "VirtualAllocDCStart";
+      break;
+    case kPageFaultVirtualAllocDCEndOpcode:
+      // Enumerates the committed regions at the end of the trace.
+      *operation = "VirtualAllocDCEnd";
+      break;
     default:
       return false;
   }
 
   // Decode the payload.
-  if (!DecodeUInteger("BaseAddress", is_64_bit, decoder, fields) ||
-      !DecodeUInteger("RegionSize", is_64_bit, decoder, fields) ||
+  if (!DecodePointer<Arch>("BaseAddress", decoder, fields) ||
+      !DecodePointer<Arch>("RegionSize", decoder, fields) ||
       !Decode<UIntValue>("ProcessId", decoder, fields) ||
       !Decode<UIntValue>("Flags", decoder, fields)) {
     return false;
@@ -2511,11 +2689,11 @@ bool DecodePageFaultVirtualAllocFreePayload(Decoder* decoder,
   return true;
 }
 
+template <typename Arch>
 bool DecodePageFaultPayload(Decoder* decoder,
                             unsigned char version,
                             unsigned char opcode,
-                            bool is_64_bit,
-                            std::string* operation,
+                            const char** operation,
                             StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(operation != NULL);
@@ -2528,147 +2706,214 @@ bool DecodePageFaultPayload(Decoder* decoder,
     case kPageFaultGuardPageFaultOpcode:
     case kPageFaultHardPageFaultOpcode:
     case kPageFaultAccessViolationOpcode:
-      return DecodePageFaultCommonPageFaultPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePageFaultCommonPageFaultPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPageFaultHardFaultOpcode:
-      return DecodePageFaultHardPageFaultPayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+      return DecodePageFaultHardPageFaultPayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     case kPageFaultVirtualAllocOpcode:
     case kPageFaultVirtualFreeOpcode:
-      return DecodePageFaultVirtualAllocFreePayload(
-          decoder, version, opcode, is_64_bit, operation, fields);
+    case kPageFaultVirtualAllocDCStartOpcode:
+    case kPageFaultVirtualAllocDCEndOpcode:
+      return DecodePageFaultVirtualAllocFreePayload<Arch>(
+          decoder, version, opcode, operation, fields);
 
     default:
       return false;
   }
 }
 
-}  // namespace
-
-bool DecodeRawETWKernelPayload(const std::string& provider_id,
-                               unsigned char version,
-                               unsigned char opcode,
-                               bool is_64_bit,
-                               const char* payload,
-                               size_t payload_size,
-                               std::string* operation,
-                               std::string* category,
-                               scoped_ptr<event::Value>* decoded_payload) {
+template <typename Arch>
+bool DecodeRawETWKernelPayloadForArch(
+    const std::string& provider_id,
+    unsigned char version,
+    unsigned char opcode,
+    const char* payload,
+    size_t payload_size,
+    DecodeContext* context,
+    scoped_ptr<event::Value>* decoded_payload) {
   DCHECK(payload != NULL || payload_size == 0);  // note: payload can be NULL.
-  DCHECK(operation != NULL);
-  DCHECK(category != NULL);
+  DCHECK(context != NULL);
   DCHECK(decoded_payload != NULL);
 
+  const char* operation = NULL;
+
   // Create the byte decoder for the encoded payload.
   Decoder decoder(payload, payload_size);
   scoped_ptr<StructValue> fields(new StructValue);
 
+  // Account the decoding of this payload (compiled out unless enabled).
+  DECODE_STATS_SCOPE(stats, provider_id, opcode, version, &decoder,
+                     payload_size);
+
   // Dispatch event by provider (GUID).
   if (provider_id == kEventTraceEventProviderId) {
-    if (DecodeEventTracePayload(&decoder, version, opcode, is_64_bit,
-                                operation, fields.get())) {
-      *category = "EventTraceEvent";
+    if (DecodeEventTracePayload<Arch>(&decoder, version, opcode, &operation,
+                                      fields.get())) {
+      context->set_category("EventTraceEvent");
     } else {
-      LOG(WARNING) << "Error while decoding EventTraceEvent payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding EventTraceEvent payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kImageProviderId) {
-    if (DecodeImagePayload(&decoder, version, opcode, is_64_bit,
-                           operation, fields.get())) {
-      *category = "Image";
+    if (DecodeImagePayload<Arch>(&decoder, version, opcode, &operation,
+                                 fields.get())) {
+      context->set_category("Image");
     } else {
-      LOG(ERROR) << "Error while decoding Image payload.";
+      LOG_EVERY_N(ERROR, kDecodeErrorLogPeriod)
+          << "Error while decoding Image payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kPerfInfoProviderId) {
-    if (DecodePerfInfoPayload(&decoder, version, opcode, is_64_bit,
-                              operation, fields.get())) {
-      *category = "PerfInfo";
+    if (DecodePerfInfoPayload<Arch>(&decoder, version, opcode, &operation,
+                                    fields.get())) {
+      context->set_category("PerfInfo");
     } else {
       // TODO(etienneb): Complete the decoding of these payload.
-      LOG(WARNING) << "Error while decoding PerfInfo payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding PerfInfo payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kThreadProviderId) {
-    if (DecodeThreadPayload(&decoder, version, opcode, is_64_bit,
-                            operation, fields.get())) {
-      *category = "Thread";
+    if (DecodeThreadPayload<Arch>(&decoder, version, opcode, &operation,
+                                  fields.get())) {
+      context->set_category("Thread");
     } else {
       // TODO(etienneb): Complete the decoding of these payload.
-      LOG(WARNING) << "Error while decoding Thread payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding Thread payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kProcessProviderId) {
-    if (DecodeProcessPayload(&decoder, version, opcode, is_64_bit,
-                             operation, fields.get())) {
-      *category = "Process";
+    if (DecodeProcessPayload<Arch>(&decoder, version, opcode, &operation,
+                                   fields.get())) {
+      context->set_category("Process");
     } else {
-      LOG(WARNING) << "Error while decoding Process payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding Process payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kTcplpProviderId) {
-    if (DecodeTcplpPayload(&decoder, version, opcode, is_64_bit,
-                           operation, fields.get())) {
-      *category = "Tcplp";
+    if (DecodeTcplpPayload<Arch>(&decoder, version, opcode, &operation,
+                                 fields.get())) {
+      context->set_category("Tcplp");
     } else {
-      LOG(WARNING) << "Error while decoding Tcplp payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding Tcplp payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kRegistryProviderId) {
-    if (DecodeRegistryPayload(&decoder, version, opcode, is_64_bit,
-                              operation, fields.get())) {
-      *category = "Registry";
+    if (DecodeRegistryPayload<Arch>(&decoder, version, opcode, &operation,
+                                    fields.get())) {
+      context->set_category("Registry");
     } else {
-      LOG(WARNING) << "Error while decoding Registry payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding Registry payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kFileIOProviderId) {
-    if (DecodeFileIOPayload(&decoder, version, opcode, is_64_bit,
-                            operation, fields.get())) {
-      *category = "FileIO";
+    if (DecodeFileIOPayload<Arch>(&decoder, version, opcode, &operation,
+                                  fields.get())) {
+      context->set_category("FileIO");
     } else {
-      LOG(WARNING) << "Error while decoding FileIO payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding FileIO payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kDiskIOProviderId) {
-    if (DecodeDiskIOPayload(&decoder, version, opcode, is_64_bit,
-                            operation, fields.get())) {
-      *category = "DiskIO";
+    if (DecodeDiskIOPayload<Arch>(&decoder, version, opcode, &operation,
+                                  fields.get())) {
+      context->set_category("DiskIO");
     } else {
-      LOG(WARNING) << "Error while decoding DiskIO payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding DiskIO payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kStackWalkProviderId) {
-    if (DecodeStackWalkPayload(&decoder, version, opcode, is_64_bit,
-                               operation, fields.get())) {
-      *category = "StackWalk";
+    if (DecodeStackWalkPayload<Arch>(&decoder, version, opcode,
+                                     context->stack_table(), &operation,
+                                     fields.get())) {
+      context->set_category("StackWalk");
     } else {
-      LOG(WARNING) << "Error while decoding StackWalk payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding StackWalk payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else if (provider_id == kPageFaultProviderId) {
-    if (DecodePageFaultPayload(&decoder, version, opcode, is_64_bit,
-                               operation, fields.get())) {
-      *category = "PageFault";
+    if (DecodePageFaultPayload<Arch>(&decoder, version, opcode, &operation,
+                                     fields.get())) {
+      context->set_category("PageFault");
     } else {
-      LOG(WARNING) << "Error while decoding PageFault payload.";
+      LOG_EVERY_N(WARNING, kDecodeErrorLogPeriod)
+          << "Error while decoding PageFault payload.";
+      DECODE_STATS_MISS(stats, operation);
       return false;
     }
   } else {
     // Unsupported event.
+    DECODE_STATS_OUTCOME(stats, DECODE_UNSUPPORTED);
     return false;
   }
 
   // Make sure that all the payload has been decoded.
-  if (decoder.RemainingBytes() != 0)
+  if (decoder.RemainingBytes() != 0) {
+    DECODE_STATS_OUTCOME(stats, DECODE_TRAILING_BYTES);
     return false;
+  }
 
   // Successful decoding of this event.
+  DECODE_STATS_OUTCOME(stats, DECODE_OK);
+  context->set_operation(operation);
   *decoded_payload = fields.Pass();
   return true;
 }
 
+}  // namespace
+
+RawETWKernelPayloadDecoder GetRawETWKernelPayloadDecoder(bool is_64_bit) {
+  if (is_64_bit)
+    return &DecodeRawETWKernelPayloadForArch<Arch64>;
+  return &DecodeRawETWKernelPayloadForArch<Arch32>;
+}
+
+bool DecodeRawETWKernelPayload(const std::string& provider_id,
+                               unsigned char version,
+                               unsigned char opcode,
+                               bool is_64_bit,
+                               const char* payload,
+                               size_t payload_size,
+                               std::string* operation,
+                               std::string* category,
+                               scoped_ptr<event::Value>* decoded_payload) {
+  DCHECK(operation != NULL);
+  DCHECK(category != NULL);
+
+  DecodeContext* context = DecodeContext::Current();
+  context->Reset();
+
+  RawETWKernelPayloadDecoder decode = GetRawETWKernelPayloadDecoder(is_64_bit);
+  if (!decode(provider_id, version, opcode, payload, payload_size, context,
+              decoded_payload)) {
+    return false;
+  }
+
+  *operation = context->operation();
+  *category = context->category();
+  return true;
+}
+
 }  // namespace etw
 }  // namespace parser
@@ -35,11 +35,36 @@ namespace event {
 class Value;
 }
 
+namespace parser {
+class DecodeContext;
+}
+
 namespace parser {
 namespace etw {
 
+// Decodes the raw payload of an ETW kernel event generated by a system of a
+// given pointer width. See DecodeRawETWKernelPayload for the other parameters.
+// On success, the operation and the category of the event are set in
+// |context| as static strings.
+// @param context the decode context of the calling thread.
+typedef bool (*RawETWKernelPayloadDecoder)(
+    const std::string& provider_id,
+    unsigned char version,
+    unsigned char opcode,
+    const char* payload,
+    size_t payload_size,
+    DecodeContext* context,
+    scoped_ptr<event::Value>* decoded_payload);
+
+// Returns the decoder specialized for a pointer width. A trace never mixes
+// both widths: the decoder should be selected once per trace.
+// @param is_64_bit indicates whether the trace was generated on a 64-bit OS.
+// @returns the specialized decoder.
+RawETWKernelPayloadDecoder GetRawETWKernelPayloadDecoder(bool is_64_bit);
+
 // Decodes the raw payload of an ETW kernel event without relying on external
-// definitions.
+// definitions. Prefer the decoder returned by GetRawETWKernelPayloadDecoder,
+// which reports the operation and the category without copying them.
 // see: http://msdn.microsoft.com/library/windows/desktop/aa364083.aspx
 // @param provider_id the GUID of the provider of the event.
 // @param version the version of the event definition.
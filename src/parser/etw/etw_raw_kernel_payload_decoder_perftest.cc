@@ -0,0 +1,226 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_raw_kernel_payload_decoder.h"
+
+#include <string>
+#include <vector>
+
+#include "base/perf_test.h"
+#include "base/scoped_ptr.h"
+#include "event/stack_table.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/decode_context.h"
+#include "parser/decoder.h"
+#include "parser/etw/etw_raw_payload_decoder_utils.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+using event::CharValue;
+using event::StructValue;
+using event::UCharValue;
+using event::UIntValue;
+using event::Value;
+
+const size_t kIterations = 200000;
+
+const std::string kPerfInfoProviderId = "CE1DBFB4-137E-4DA6-87B0-3F59AA102CBC";
+const unsigned char kPerfInfoSampleProfOpcode = 46;
+const unsigned char kPerfInfoISROpcode = 67;
+const unsigned char kPerfInfoDPCOpcode = 68;
+
+const std::string kThreadProviderId = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+const unsigned char kThreadCSwitchOpcode = 36;
+
+const std::string kTcplpProviderId = "9A280AC0-C8E0-11D1-84E2-00C04FB998A2";
+const unsigned char kTcplpRecvIPV4Opcode = 11;
+
+const std::string kDiskIOProviderId = "3D6FA8D4-FE05-11D0-9DDA-00C04FD7BA7C";
+const unsigned char kDiskIOReadOpcode = 10;
+
+const std::string kStackWalkProviderId = "DEF2FE46-7BD6-4B80-BD94-F57FE20D0CE3";
+const unsigned char kStackWalkStackOpcode = 32;
+
+// The shape of the sampled stacks: a few hundred distinct stacks of 32 frames.
+const size_t kStackEvents = 100000;
+const size_t kDistinctStacks = 500;
+const size_t kStackDepth = 32;
+
+const unsigned char kThreadCSwitchPayloadV2[] = {
+    0xCC, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x04,
+    0x01, 0x00, 0x00, 0x00, 0x87, 0x6D, 0x88, 0x34
+    };
+
+// A zero-filled payload, large enough for every fixed-layout event.
+const char kZeroPayload[64] = {};
+
+// Decodes the same payload repeatedly and reports the time per event.
+void RunDecodeBenchmark(const std::string& name,
+                        const std::string& provider_id,
+                        unsigned char version,
+                        unsigned char opcode,
+                        const char* payload,
+                        size_t payload_size) {
+  // The decoder is selected once, as for a trace.
+  RawETWKernelPayloadDecoder decode = GetRawETWKernelPayloadDecoder(true);
+
+  DecodeContext* context = DecodeContext::Current();
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    context->Reset();
+    scoped_ptr<Value> fields;
+    ASSERT_TRUE(decode(provider_id, version, opcode, payload, payload_size,
+                       context, &fields));
+  }
+  base::PrintPerfResult(name, "decode", timer.ElapsedNanoseconds(),
+                        kIterations, "ns/event");
+}
+
+// The field by field decoding of a CSwitch payload, as done before the
+// fixed-layout schemas.
+bool DecodeCSwitchFieldByField(Decoder* decoder, StructValue* fields) {
+  return Decode<UIntValue>("NewThreadId", decoder, fields) &&
+      Decode<UIntValue>("OldThreadId", decoder, fields) &&
+      Decode<CharValue>("NewThreadPriority", decoder, fields) &&
+      Decode<CharValue>("OldThreadPriority", decoder, fields) &&
+      Decode<UCharValue>("PreviousCState", decoder, fields) &&
+      Decode<CharValue>("SpareByte", decoder, fields) &&
+      Decode<CharValue>("OldThreadWaitReason", decoder, fields) &&
+      Decode<CharValue>("OldThreadWaitMode", decoder, fields) &&
+      Decode<CharValue>("OldThreadState", decoder, fields) &&
+      Decode<CharValue>("OldThreadWaitIdealProcessor", decoder, fields) &&
+      Decode<UIntValue>("NewThreadWaitTime", decoder, fields) &&
+      Decode<UIntValue>("Reserved", decoder, fields);
+}
+
+// Builds the payloads of StackWalk events. Distinct stacks share their
+// outermost frames, like the stacks of a real profile.
+void MakeStackWalkPayloads(std::vector<std::vector<uint64> >* payloads) {
+  payloads->resize(kDistinctStacks);
+  for (size_t i = 0; i < kDistinctStacks; ++i) {
+    std::vector<uint64>& payload = (*payloads)[i];
+    payload.push_back(1234);  // EventTimeStamp.
+    payload.push_back(0);  // StackProcess and StackThread.
+    for (size_t depth = 0; depth < kStackDepth; ++depth)
+      payload.push_back(0x7FF000000000ULL + (i >> (depth / 4)) * 16 + depth);
+  }
+}
+
+// Decodes StackWalk events and reports the time and the memory per event.
+void RunStackWalkBenchmark(const std::string& name, bool intern) {
+  std::vector<std::vector<uint64> > payloads;
+  MakeStackWalkPayloads(&payloads);
+
+  event::StackTable stack_table;
+  DecodeContext* context = DecodeContext::Current();
+  context->set_stack_table(intern ? &stack_table : NULL);
+  RawETWKernelPayloadDecoder decode = GetRawETWKernelPayloadDecoder(true);
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kStackEvents; ++i) {
+    const std::vector<uint64>& payload = payloads[i % kDistinctStacks];
+    context->Reset();
+    scoped_ptr<Value> fields;
+    ASSERT_TRUE(decode(kStackWalkProviderId, 2, kStackWalkStackOpcode,
+                       reinterpret_cast<const char*>(&payload[0]),
+                       payload.size() * sizeof(uint64), context, &fields));
+  }
+  base::PrintPerfResult(name, "decode", timer.ElapsedNanoseconds(),
+                        kStackEvents, "ns/event");
+  context->set_stack_table(NULL);
+
+  // The memory held by the stack of each event, once decoded.
+  size_t bytes = 0;
+  if (intern) {
+    bytes = kStackEvents * sizeof(event::UIntValue) +
+            stack_table.MemoryUsage();
+  } else {
+    bytes = kStackEvents * (sizeof(event::ArrayValue) + kStackDepth *
+        (sizeof(Value*) + sizeof(event::ULongValue)));
+  }
+  base::PrintPerfResult(name, "memory", bytes, kStackEvents, "bytes/event");
+}
+
+}  // namespace
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, CSwitchFieldByField) {
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    Decoder decoder(reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+                    sizeof(kThreadCSwitchPayloadV2));
+    StructValue fields;
+    ASSERT_TRUE(DecodeCSwitchFieldByField(&decoder, &fields));
+  }
+  base::PrintPerfResult("CSwitchFieldByField", "decode",
+                        timer.ElapsedNanoseconds(), kIterations, "ns/event");
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, CSwitch) {
+  RunDecodeBenchmark("CSwitch", kThreadProviderId, 2, kThreadCSwitchOpcode,
+                     reinterpret_cast<const char*>(&kThreadCSwitchPayloadV2[0]),
+                     sizeof(kThreadCSwitchPayloadV2));
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, SampleProf) {
+  RunDecodeBenchmark("SampleProf", kPerfInfoProviderId, 2,
+                     kPerfInfoSampleProfOpcode, kZeroPayload, 16);
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, ISR) {
+  RunDecodeBenchmark("ISR", kPerfInfoProviderId, 2, kPerfInfoISROpcode,
+                     kZeroPayload, 20);
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, DPC) {
+  RunDecodeBenchmark("DPC", kPerfInfoProviderId, 2, kPerfInfoDPCOpcode,
+                     kZeroPayload, 16);
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, DiskIORead) {
+  RunDecodeBenchmark("DiskIORead", kDiskIOProviderId, 2, kDiskIOReadOpcode,
+                     kZeroPayload, 48);
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, TcplpRecvIPV4) {
+  RunDecodeBenchmark("TcplpRecvIPV4", kTcplpProviderId, 2,
+                     kTcplpRecvIPV4Opcode, kZeroPayload, 32);
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, StackWalkArray) {
+  RunStackWalkBenchmark("StackWalkArray", false);
+}
+
+TEST(EtwRawKernelPayloadDecoderPerfTest, StackWalkInterned) {
+  RunStackWalkBenchmark("StackWalkInterned", true);
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -25,11 +25,15 @@
 
 #include "parser/etw/etw_raw_kernel_payload_decoder.h"
 
+#include <vector>
+
 #include "base/logging.h"
 #include "base/scoped_ptr.h"
+#include "event/stack_table.h"
 #include "event/utils.h"
 #include "event/value.h"
 #include "gtest/gtest.h"
+#include "parser/decode_context.h"
 
 namespace parser {
 namespace etw {
@@ -197,6 +201,7 @@ const unsigned char kPageFaultAccessViolationOpcode = 15;
 const unsigned char kPageFaultHardFaultOpcode = 32;
 const unsigned char kPageFaultVirtualAllocOpcode = 98;
 const unsigned char kPageFaultVirtualFreeOpcode = 99;
+const unsigned char kPageFaultVirtualAllocDCStartOpcode = 128;
 
 const unsigned char kEventTraceEventHeaderPayloadV2[] = {
     0x00, 0x00, 0x01, 0x00, 0x06, 0x01, 0x01, 0x05,
@@ -3562,6 +3567,35 @@ TEST(EtwRawDecoderTest, PerfInfoSampleProfV2) {
   EXPECT_TRUE(expected->Equals(fields.get()));
 }
 
+TEST(EtwRawDecoderTest, GetRawETWKernelPayloadDecoder) {
+  RawETWKernelPayloadDecoder decode32 = GetRawETWKernelPayloadDecoder(false);
+  RawETWKernelPayloadDecoder decode64 = GetRawETWKernelPayloadDecoder(true);
+  ASSERT_TRUE(decode32 != NULL);
+  ASSERT_TRUE(decode64 != NULL);
+  EXPECT_NE(decode32, decode64);
+
+  DecodeContext context;
+  scoped_ptr<Value> fields;
+  EXPECT_TRUE(
+      decode32(kPerfInfoProviderId, kVersion2, kPerfInfoSampleProfOpcode,
+          reinterpret_cast<const char*>(
+              &kPerfInfoSampleProfPayload32bitsV2[0]),
+          sizeof(kPerfInfoSampleProfPayload32bitsV2),
+          &context, &fields));
+  EXPECT_STREQ("PerfInfo", context.category());
+  EXPECT_STREQ("SampleProf", context.operation());
+  const StructValue* decoded = StructValue::Cast(fields.get());
+  EXPECT_TRUE(UIntValue::InstanceOf(decoded->GetField("InstructionPointer")));
+
+  // The 32-bit payload is too short for the 64-bit decoder.
+  EXPECT_FALSE(
+      decode64(kPerfInfoProviderId, kVersion2, kPerfInfoSampleProfOpcode,
+          reinterpret_cast<const char*>(
+              &kPerfInfoSampleProfPayload32bitsV2[0]),
+          sizeof(kPerfInfoSampleProfPayload32bitsV2),
+          &context, &fields));
+}
+
 TEST(EtwRawDecoderTest, PerfInfoISRMSI32bitsV2) {
   std::string operation;
   std::string category;
@@ -6801,6 +6835,68 @@ TEST(EtwRawDecoderTest, StackWalkStackV2) {
   EXPECT_TRUE(expected->Equals(fields.get()));
 }
 
+TEST(EtwRawDecoderTest, StackWalkStackInternedV2) {
+  event::StackTable stack_table;
+  DecodeContext context;
+  context.set_stack_table(&stack_table);
+  RawETWKernelPayloadDecoder decode = GetRawETWKernelPayloadDecoder(true);
+
+  // Decoding the same stack twice yields the same identifier.
+  for (int i = 0; i < 2; ++i) {
+    scoped_ptr<Value> fields;
+    EXPECT_TRUE(
+        decode(kStackWalkProviderId, kVersion2, kStackWalkStackOpcode,
+            reinterpret_cast<const char*>(&kStackWalkStackPayloadV2[0]),
+            sizeof(kStackWalkStackPayloadV2),
+            &context, &fields));
+
+    scoped_ptr<StructValue> expected(new StructValue());
+    expected->AddField<ULongValue>("EventTimeStamp", 1198356524732ULL);
+    expected->AddField<UIntValue>("StackProcess", 7828U);
+    expected->AddField<UIntValue>("StackThread", 1404U);
+    expected->AddField<UIntValue>("StackId", 0U);
+
+    EXPECT_STREQ("StackWalk", context.category());
+    EXPECT_STREQ("Stack", context.operation());
+    EXPECT_TRUE(expected->Equals(fields.get()));
+  }
+
+  ASSERT_EQ(1U, stack_table.stack_count());
+  event::Stack stack;
+  stack_table.GetStack(event::StackId(0), &stack);
+  ASSERT_EQ(21U, stack.size());
+  EXPECT_EQ(18446735285893805867ULL, stack.front());
+  EXPECT_EQ(140718076806097ULL, stack.back());
+}
+
+TEST(EtwRawDecoderTest, StackWalkStackInternedLargeV2) {
+  // More frames than ETW usually captures.
+  const size_t kFrames = 300;
+  std::vector<uint64> payload(2 + kFrames);
+  payload[0] = 1198356524732ULL;
+  payload[1] = (1404ULL << 32) | 7828ULL;
+  for (size_t i = 0; i < kFrames; ++i)
+    payload[2 + i] = 0x1000 + i;
+
+  event::StackTable stack_table;
+  DecodeContext context;
+  context.set_stack_table(&stack_table);
+  RawETWKernelPayloadDecoder decode = GetRawETWKernelPayloadDecoder(true);
+
+  scoped_ptr<Value> fields;
+  EXPECT_TRUE(
+      decode(kStackWalkProviderId, kVersion2, kStackWalkStackOpcode,
+          reinterpret_cast<const char*>(&payload[0]),
+          payload.size() * sizeof(uint64), &context, &fields));
+
+  ASSERT_EQ(1U, stack_table.stack_count());
+  event::Stack stack;
+  stack_table.GetStack(event::StackId(0), &stack);
+  ASSERT_EQ(kFrames, stack.size());
+  EXPECT_EQ(0x1000U, stack.front());
+  EXPECT_EQ(0x1000U + kFrames - 1, stack.back());
+}
+
 TEST(EtwRawDecoderTest, PageFaultTransitionFault32bitsV2) {
   std::string operation;
   std::string category;
@@ -6993,6 +7089,28 @@ TEST(EtwRawDecoderTest, PageFaultVirtualAllocV2) {
   EXPECT_TRUE(expected->Equals(fields.get()));
 }
 
+TEST(EtwRawDecoderTest, PageFaultVirtualAllocDCStartV2) {
+  std::string operation;
+  std::string category;
+  scoped_ptr<Value> fields;
+  EXPECT_TRUE(
+      DecodeRawETWKernelPayload(kPageFaultProviderId,
+          kVersion2, kPageFaultVirtualAllocDCStartOpcode, k64bit,
+          reinterpret_cast<const char*>(&kPageFaultVirtualAllocPayloadV2[0]),
+          sizeof(kPageFaultVirtualAllocPayloadV2),
+          &operation, &category, &fields));
+
+  scoped_ptr<StructValue> expected(new StructValue());
+  expected->AddField<ULongValue>("BaseAddress", 0x003B4000ULL);
+  expected->AddField<ULongValue>("RegionSize", 0x6000ULL);
+  expected->AddField<UIntValue>("ProcessId", 0x1804);
+  expected->AddField<UIntValue>("Flags", 0x1000);
+
+  EXPECT_STREQ("PageFault", category.c_str());
+  EXPECT_STREQ("VirtualAllocDCStart", operation.c_str());
+  EXPECT_TRUE(expected->Equals(fields.get()));
+}
+
 TEST(EtwRawDecoderTest, PageFaultVirtualFree32bitsV2) {
   std::string operation;
   std::string category;
@@ -33,7 +33,6 @@ namespace {
 using event::IntValue;
 using event::UCharValue;
 using event::UIntValue;
-using event::ULongValue;
 using event::ShortValue;
 using event::StructValue;
 using event::WStringValue;
@@ -41,16 +40,16 @@ using event::Value;
 
 }  // namespace
 
-bool DecodeUInteger(const std::string& name,
+bool DecodeUInteger(const char* name,
                     bool is_64_bit,
                     Decoder* decoder,
                     StructValue* fields) {
   if (is_64_bit)
-    return Decode<ULongValue>(name, decoder, fields);
-  return Decode<UIntValue>(name, decoder, fields);
+    return DecodePointer<Arch64>(name, decoder, fields);
+  return DecodePointer<Arch32>(name, decoder, fields);
 }
 
-bool DecodeW16String(const std::string& name,
+bool DecodeW16String(const char* name,
                      Decoder* decoder,
                      StructValue* fields) {
   DCHECK(decoder != NULL);
@@ -66,7 +65,7 @@ bool DecodeW16String(const std::string& name,
   return true;
 }
 
-bool DecodeFixedW16String(const std::string& name,
+bool DecodeFixedW16String(const char* name,
                           size_t length,
                           Decoder* decoder,
                           StructValue* fields) {
@@ -83,8 +82,8 @@ bool DecodeFixedW16String(const std::string& name,
   return true;
 }
 
-bool DecodeSID(const std::string& name,
-               bool is_64_bit,
+template <class Arch>
+bool DecodeSID(const char* name,
                Decoder* decoder,
                StructValue* fields) {
   // Check the minimal SID length to avoid out-of-bound accesses.
@@ -93,13 +92,13 @@ bool DecodeSID(const std::string& name,
 
   // Decode the TOKEN_USER structure.
   scoped_ptr<StructValue> sid(new StructValue);
-  if (!DecodeUInteger("PSid", is_64_bit, decoder, sid.get()) ||
+  if (!DecodePointer<Arch>("PSid", decoder, sid.get()) ||
       !Decode<UIntValue>("Attributes", decoder, sid.get())) {
     return false;
   }
 
   // Skip padding.
-  if (is_64_bit) {
+  if (Arch::kIs64Bit) {
     scoped_ptr<UIntValue> padding(decoder->Decode<UIntValue>());
     if (padding.get() == NULL)
       return false;
@@ -121,7 +120,24 @@ bool DecodeSID(const std::string& name,
   return fields->AddField(name, sid.PassAs<Value>());
 }
 
-bool DecodeSystemTime(const std::string& name,
+// Force the instantiation of the supported architectures.
+template bool DecodeSID<Arch32>(const char* name,
+                                Decoder* decoder,
+                                StructValue* fields);
+template bool DecodeSID<Arch64>(const char* name,
+                                Decoder* decoder,
+                                StructValue* fields);
+
+bool DecodeSID(const char* name,
+               bool is_64_bit,
+               Decoder* decoder,
+               StructValue* fields) {
+  if (is_64_bit)
+    return DecodeSID<Arch64>(name, decoder, fields);
+  return DecodeSID<Arch32>(name, decoder, fields);
+}
+
+bool DecodeSystemTime(const char* name,
                       Decoder* decoder,
                       StructValue* fields) {
   // Decode the SystemTime structure.
@@ -141,7 +157,7 @@ bool DecodeSystemTime(const std::string& name,
   return fields->AddField(name, system_time.PassAs<Value>());
 }
 
-bool DecodeTimeZoneInformation(const std::string& name,
+bool DecodeTimeZoneInformation(const char* name,
                                Decoder* decoder,
                                StructValue* fields) {
 
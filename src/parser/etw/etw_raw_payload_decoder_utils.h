@@ -36,6 +36,22 @@
 namespace parser {
 namespace etw {
 
+// Pointer width of the system that generated a trace. The kernel decoders are
+// instantiated once per architecture; a trace never mixes both.
+// @{
+struct Arch32 {
+  typedef uint32 Pointer;
+  typedef event::UIntValue PointerValue;
+  static const bool kIs64Bit = false;
+};
+
+struct Arch64 {
+  typedef uint64 Pointer;
+  typedef event::ULongValue PointerValue;
+  static const bool kIs64Bit = true;
+};
+// @}
+
 // Decode a value and add it as a field into struct.
 // @tparam T the type of the value to decode.
 // @param name the name of the field to be added.
@@ -43,7 +59,7 @@ namespace etw {
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
 template <class T>
-bool Decode(const std::string& name, Decoder* decoder,
+bool Decode(const char* name, Decoder* decoder,
             event::StructValue* fields) {
   DCHECK(decoder != NULL);
   DCHECK(fields != NULL);
@@ -66,7 +82,7 @@ bool Decode(const std::string& name, Decoder* decoder,
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
 template <class T>
-bool DecodeArray(const std::string& name,
+bool DecodeArray(const char* name,
                  size_t length,
                  Decoder* decoder,
                  event::StructValue* fields) {
@@ -83,14 +99,28 @@ bool DecodeArray(const std::string& name,
   return true;
 }
 
+// Decode a pointer-sized unsigned integer and add it as a field into |fields|.
+// @tparam Arch the architecture of the trace.
+// @param name the name of the field to be added.
+// @param decoder the decoder processing the payload.
+// @param fields the structure to receive the field.
+// @returns true on sucess, false otherwise.
+template <class Arch>
+bool DecodePointer(const char* name,
+                   Decoder* decoder,
+                   event::StructValue* fields) {
+  return Decode<typename Arch::PointerValue>(name, decoder, fields);
+}
+
 // Decode an unsigned integer and add it as a field into |fields|.
 // The integer can be 32-bit or 64-bit depending on the flag |is_64_bit|.
+// Prefer DecodePointer when the architecture is known at compile time.
 // @param name the name of the field to be added.
 // @param is_64_bit the flag to enable decoding of 64-bit integer.
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
-bool DecodeUInteger(const std::string& name,
+bool DecodeUInteger(const char* name,
                     bool is_64_bit,
                     Decoder* decoder,
                     event::StructValue* fields);
@@ -100,7 +130,7 @@ bool DecodeUInteger(const std::string& name,
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
-bool DecodeW16String(const std::string& name,
+bool DecodeW16String(const char* name,
                      Decoder* decoder,
                      event::StructValue* fields);
 
@@ -110,18 +140,30 @@ bool DecodeW16String(const std::string& name,
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
-bool DecodeFixedW16String(const std::string& name,
+bool DecodeFixedW16String(const char* name,
                           size_t length,
                           Decoder* decoder,
                           event::StructValue* fields);
 
+// Decode a SID (Secure ID) structure.
+// @tparam Arch the architecture of the trace. Instantiated for Arch32 and
+//     Arch64.
+// @param name the name of the field to be added.
+// @param decoder the decoder processing the payload.
+// @param fields the structure to receive the field.
+// @returns true on sucess, false otherwise.
+template <class Arch>
+bool DecodeSID(const char* name,
+               Decoder* decoder,
+               event::StructValue* fields);
+
 // Decode a SID (Secure ID) structure.
 // @param name the name of the field to be added.
 // @param is_64_bit the flag to enable decoding of 64-bit integer.
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
-bool DecodeSID(const std::string& name,
+bool DecodeSID(const char* name,
                bool is_64_bit,
                Decoder* decoder,
                event::StructValue* fields);
@@ -131,7 +173,7 @@ bool DecodeSID(const std::string& name,
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
-bool DecodeSystemTime(const std::string& name,
+bool DecodeSystemTime(const char* name,
                       Decoder* decoder,
                       event::StructValue* fields);
 
@@ -140,7 +182,7 @@ bool DecodeSystemTime(const std::string& name,
 // @param decoder the decoder processing the payload.
 // @param fields the structure to receive the field.
 // @returns true on sucess, false otherwise.
-bool DecodeTimeZoneInformation(const std::string& name,
+bool DecodeTimeZoneInformation(const char* name,
                                Decoder* decoder,
                                event::StructValue* fields);
 
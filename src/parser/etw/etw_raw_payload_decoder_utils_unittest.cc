@@ -116,6 +116,25 @@ TEST(EtwDecoderUtilsTest, DecodeUInteger64) {
   EXPECT_FALSE(DecodeUInteger("error", true, &decoder, &fields));
 }
 
+TEST(EtwDecoderUtilsTest, DecodePointer) {
+  StructValue fields;
+  Decoder decoder(&kSmallBuffer[0], kSmallBufferLength);
+  EXPECT_TRUE(DecodePointer<Arch32>("test32", &decoder, &fields));
+  EXPECT_EQ(4U, decoder.RemainingBytes());
+  EXPECT_FALSE(DecodePointer<Arch64>("error", &decoder, &fields));
+
+  uint32 test32 = 0;
+  EXPECT_TRUE(fields.GetFieldAsUInteger("test32", &test32));
+  EXPECT_EQ(0x04030201U, test32);
+
+  Decoder decoder64(&kSmallBuffer[0], kSmallBufferLength);
+  EXPECT_TRUE(DecodePointer<Arch64>("test64", &decoder64, &fields));
+
+  uint64 test64 = 0;
+  EXPECT_TRUE(fields.GetFieldAsULong("test64", &test64));
+  EXPECT_EQ(0x0807060504030201ULL, test64);
+}
+
 TEST(EtwDecoderUtilsTest, DecodeString) {
   const char original[] = "This is a test.\0OK";
   StructValue fields;
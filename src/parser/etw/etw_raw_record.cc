@@ -0,0 +1,206 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_raw_record.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+// The length of a formatted provider identifier.
+const size_t kProviderIdLength = 36;
+
+const char kHexDigits[] = "0123456789ABCDEF";
+
+// The bytes of a GUID in the order of its formatted representation: Data1,
+// Data2 and Data3 are little-endian, Data4 is a byte array.
+const size_t kProviderIdByteOrder[16] = {
+  3, 2, 1, 0, 5, 4, 7, 6, 8, 9, 10, 11, 12, 13, 14, 15
+};
+
+size_t PaddingSize(size_t size) {
+  return (kETWRawRecordAlignment - size % kETWRawRecordAlignment) %
+      kETWRawRecordAlignment;
+}
+
+bool HexDigitValue(char c, uint8* value) {
+  if (c >= '0' && c <= '9')
+    *value = static_cast<uint8>(c - '0');
+  else if (c >= 'A' && c <= 'F')
+    *value = static_cast<uint8>(c - 'A' + 10);
+  else if (c >= 'a' && c <= 'f')
+    *value = static_cast<uint8>(c - 'a' + 10);
+  else
+    return false;
+  return true;
+}
+
+// @returns true if a dash precedes the |index|-th byte of a formatted GUID.
+bool IsDashBefore(size_t index) {
+  return index == 4 || index == 6 || index == 8 || index == 10;
+}
+
+}  // namespace
+
+const char kETWRawRecordFileExtension[] = ".etwraw";
+
+void ProviderIdToString(const uint8 (&provider_id)[16], std::string* str) {
+  DCHECK(str != NULL);
+
+  str->clear();
+  str->reserve(kProviderIdLength);
+  for (size_t i = 0; i < 16; ++i) {
+    if (IsDashBefore(i))
+      str->push_back('-');
+    uint8 byte = provider_id[kProviderIdByteOrder[i]];
+    str->push_back(kHexDigits[byte >> 4]);
+    str->push_back(kHexDigits[byte & 0xF]);
+  }
+}
+
+bool StringToProviderId(const std::string& str, uint8 (&provider_id)[16]) {
+  if (str.size() != kProviderIdLength)
+    return false;
+
+  size_t position = 0;
+  for (size_t i = 0; i < 16; ++i) {
+    if (IsDashBefore(i)) {
+      if (str[position] != '-')
+        return false;
+      ++position;
+    }
+    uint8 high = 0;
+    uint8 low = 0;
+    if (!HexDigitValue(str[position], &high) ||
+        !HexDigitValue(str[position + 1], &low)) {
+      return false;
+    }
+    provider_id[kProviderIdByteOrder[i]] = static_cast<uint8>(high << 4 | low);
+    position += 2;
+  }
+
+  return true;
+}
+
+ETWRawRecordWriter::ETWRawRecordWriter(std::ostream* out)
+    : out_(out), record_count_(0) {
+  DCHECK(out != NULL);
+
+  ETWRawRecordFileHeader file_header = {};
+  file_header.magic = kETWRawRecordMagic;
+  file_header.version = kETWRawRecordVersion;
+  out_->write(reinterpret_cast<const char*>(&file_header),
+              sizeof(file_header));
+}
+
+bool ETWRawRecordWriter::Write(const ETWRawRecordHeader& header,
+                               const char* payload) {
+  DCHECK(payload != NULL || header.payload_size == 0);
+
+  static const char kPadding[kETWRawRecordAlignment] = {};
+
+  out_->write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (header.payload_size != 0)
+    out_->write(payload, header.payload_size);
+  out_->write(kPadding, PaddingSize(header.payload_size));
+
+  ++record_count_;
+  return out_->good();
+}
+
+ETWRawRecordReader::ETWRawRecordReader(const char* data, size_t length)
+    : data_(data),
+      length_(length),
+      offset_(sizeof(ETWRawRecordFileHeader)),
+      valid_(false),
+      truncated_(false),
+      at_end_(true) {
+  if (data == NULL || length < sizeof(ETWRawRecordFileHeader))
+    return;
+
+  ETWRawRecordFileHeader file_header;
+  memcpy(&file_header, data, sizeof(file_header));
+  valid_ = file_header.magic == kETWRawRecordMagic &&
+           file_header.version == kETWRawRecordVersion;
+}
+
+bool ETWRawRecordReader::Next(ETWRawRecordHeader* header,
+                              const char** payload) {
+  DCHECK(header != NULL);
+  DCHECK(payload != NULL);
+
+  if (!valid_ || offset_ == length_)
+    return false;
+
+  // The offset is always within the file: the checks below compare sizes
+  // without overflowing.
+  size_t remaining = length_ - offset_;
+  if (remaining < sizeof(ETWRawRecordHeader)) {
+    truncated_ = true;
+    return false;
+  }
+
+  memcpy(header, data_ + offset_, sizeof(*header));
+  remaining -= sizeof(ETWRawRecordHeader);
+  size_t record_size = header->payload_size;
+  if (remaining < record_size) {
+    truncated_ = true;
+    return false;
+  }
+
+  // The padding of the last record of the file may be missing.
+  record_size += PaddingSize(header->payload_size);
+  if (record_size > remaining) {
+    if (!at_end_) {
+      truncated_ = true;
+      return false;
+    }
+    record_size = remaining;
+  }
+
+  *payload = data_ + offset_ + sizeof(ETWRawRecordHeader);
+  offset_ += sizeof(ETWRawRecordHeader) + record_size;
+
+  return true;
+}
+
+void ETWRawRecordReader::Continue(const char* data,
+                                  size_t length,
+                                  bool at_end) {
+  DCHECK(data != NULL || length == 0);
+  data_ = data;
+  length_ = length;
+  offset_ = 0;
+  truncated_ = false;
+  at_end_ = at_end;
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,194 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// The raw record format stores ETW events before decoding: the header fields
+// used to decode and dispatch an event, followed by its raw payload bytes. A
+// trace captured once on Windows can then be replayed on any system through
+// the raw kernel payload decoder, e.g. to benchmark the decoders or to check
+// them for regressions.
+//
+// A file holds an ETWRawRecordFileHeader followed by records. A record is an
+// ETWRawRecordHeader followed by |payload_size| bytes, padded with zeros to a
+// multiple of kETWRawRecordAlignment bytes. All integers are little-endian.
+//
+// Usage example:
+//   std::ofstream out("trace.etwraw", std::ios::binary);
+//   ETWRawRecordWriter writer(&out);
+//   writer.Write(header, payload);
+//
+//   ETWRawRecordReader reader(data, length);
+//   ETWRawRecordHeader header;
+//   const char* payload = NULL;
+//   while (reader.Next(&header, &payload))
+//     Decode(header, payload);
+
+#ifndef PARSER_ETW_ETW_RAW_RECORD_H_
+#define PARSER_ETW_ETW_RAW_RECORD_H_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include "base/base.h"
+
+namespace parser {
+namespace etw {
+
+// The extension of the raw record files.
+extern const char kETWRawRecordFileExtension[];
+
+// The first bytes of a raw record file: "LTRR".
+const uint32 kETWRawRecordMagic = 0x5252544C;
+
+// The version of the format written by ETWRawRecordWriter.
+const uint32 kETWRawRecordVersion = 1;
+
+// The alignment of the records in a file, in bytes.
+const size_t kETWRawRecordAlignment = 8;
+
+// The flags of a record.
+const uint8 kETWRawRecordFlag64Bit = 0x01;
+
+#pragma pack(push, 1)
+
+struct ETWRawRecordFileHeader {
+  uint32 magic;
+  uint32 version;
+  uint64 reserved;
+};
+
+struct ETWRawRecordHeader {
+  // The GUID of the provider, in the memory layout of a Windows GUID.
+  uint8 provider_id[16];
+  uint64 timestamp;
+  uint32 process_id;
+  uint32 thread_id;
+  uint32 payload_size;
+  uint16 processor_number;
+  uint8 version;
+  uint8 opcode;
+  // kETWRawRecordFlag64Bit when the event comes from a 64-bit system.
+  uint8 flags;
+  uint8 reserved[7];
+};
+
+#pragma pack(pop)
+
+COMPILE_ASSERT(sizeof(ETWRawRecordFileHeader) == 16,
+               raw_record_file_header_must_be_16_bytes);
+COMPILE_ASSERT(sizeof(ETWRawRecordHeader) == 48,
+               raw_record_header_must_be_48_bytes);
+
+// Formats a provider identifier the way the ETW decoders expect it, e.g.
+// "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C".
+// @param provider_id the GUID of the provider.
+// @param str receives the formatted identifier.
+void ProviderIdToString(const uint8 (&provider_id)[16], std::string* str);
+
+// Parses a provider identifier formatted by ProviderIdToString.
+// @param str the formatted identifier.
+// @param provider_id receives the GUID of the provider.
+// @returns true on success, false if |str| is malformed.
+bool StringToProviderId(const std::string& str, uint8 (&provider_id)[16]);
+
+// Writes raw records to a binary stream.
+class ETWRawRecordWriter {
+ public:
+  // Writes the file header.
+  // @param out the binary stream to write to. Must outlive the writer.
+  explicit ETWRawRecordWriter(std::ostream* out);
+
+  // Writes a record.
+  // @param header the header of the record.
+  // @param payload the |header.payload_size| bytes of the payload.
+  // @returns true on success, false if the stream failed.
+  bool Write(const ETWRawRecordHeader& header, const char* payload);
+
+  // @returns the number of records written.
+  uint64 record_count() const { return record_count_; }
+
+ private:
+  std::ostream* out_;
+  uint64 record_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ETWRawRecordWriter);
+};
+
+// Reads the records of a raw record file held in memory. The payloads are
+// not copied: they point into the file data.
+class ETWRawRecordReader {
+ public:
+  // @param data the bytes of the file. Must outlive the reader.
+  // @param length the number of bytes of the file.
+  ETWRawRecordReader(const char* data, size_t length);
+
+  // @returns true if the file header is valid.
+  bool IsValid() const { return valid_; }
+
+  // Reads the next record.
+  // @param header receives the header of the record.
+  // @param payload receives a pointer to the payload of the record.
+  // @returns true on success, false at the end of the file or if the record
+  //     is truncated.
+  bool Next(ETWRawRecordHeader* header, const char** payload);
+
+  // @returns true if the reading stopped on a truncated record.
+  bool truncated() const { return truncated_; }
+
+  // @returns the offset of the next record in the data.
+  size_t offset() const { return offset_; }
+
+  // Indicates whether the data ends at the end of the file, which is the
+  // default. The padding of the last record of a file may be missing, but
+  // a record cut in its padding before the end of the file is truncated:
+  // the rest of the padding is in the bytes that follow.
+  // @param at_end true if the data ends at the end of the file.
+  void set_at_end(bool at_end) { at_end_ = at_end; }
+
+  // Continues the reading in another buffer, e.g. a window moved over a
+  // file too large to be held in memory at once.
+  // @param data the bytes following the last record read, i.e. the data
+  //     from offset() on, extended with more bytes of the file. Must outlive
+  //     the reader.
+  // @param length the number of bytes at |data|.
+  // @param at_end true if |data| ends at the end of the file.
+  void Continue(const char* data, size_t length, bool at_end);
+
+ private:
+  const char* data_;
+  size_t length_;
+  size_t offset_;
+  bool valid_;
+  bool truncated_;
+  bool at_end_;
+
+  DISALLOW_COPY_AND_ASSIGN(ETWRawRecordReader);
+};
+
+}  // namespace etw
+}  // namespace parser
+
+#endif  // PARSER_ETW_ETW_RAW_RECORD_H_
@@ -0,0 +1,404 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_raw_record_parser.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/compressed_file.h"
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+#include "base/scoped_ptr.h"
+#include "base/string_utils.h"
+#include "base/thread.h"
+#include "event/value.h"
+#include "parser/decode_context.h"
+#include "parser/etw/etw_raw_kernel_payload_decoder.h"
+#include "parser/etw/etw_raw_record.h"
+#include "parser/trace_stats.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+using event::Event;
+using event::StringValue;
+using event::StructValue;
+using event::Timestamp;
+using event::UCharValue;
+using event::ULongValue;
+using event::Value;
+
+// The EventTrace Header event, version 2, reports the losses of the session.
+const char kEventTraceProviderId[] = "68FDD900-4A3E-11D1-84F4-0000F80464E3";
+const uint8 kEventTraceHeaderOpcode = 0;
+const uint8 kEventTraceHeaderVersion = 2;
+
+// The offsets of the loss counters in the EventTrace Header. BuffersLost
+// follows two pointers, the TimeZoneInformation, a padding, three 64-bit
+// times and ReservedFlags.
+const size_t kEventsLostOffset = 48;
+const size_t kBuffersLostOffset32 = 268;
+const size_t kBuffersLostOffset64 = 276;
+
+// The number of blocks decompressed at once through the window over a
+// compressed raw record file, enough to keep the decompression threads busy.
+const size_t kRecordWindowBlocks = 64;
+
+// Reads the records of a raw record file. The file is mapped; a compressed
+// file is decompressed through a window moved over the file, so that only
+// the window is held in memory.
+class RecordFile {
+ public:
+  // @param decompress_thread_count the number of threads decompressing the
+  //     blocks of a compressed file.
+  explicit RecordFile(size_t decompress_thread_count)
+      : compressed_(false), next_offset_(0), corrupted_(false) {
+    compressed_file_.set_thread_count(decompress_thread_count);
+  }
+
+  // Maps a raw record file, or decompresses the first window of a
+  // compressed one.
+  // @param path the path of the file.
+  // @returns false if the file can't be read.
+  bool Open(const std::string& path);
+
+  // @returns true if the file header is valid.
+  bool IsValid() const { return reader_->IsValid(); }
+
+  // Reads the next record. The payload is valid until the next call.
+  // @param header receives the header of the record.
+  // @param payload receives a pointer to the payload of the record.
+  // @returns true on success, false at the end of the file or if the file is
+  //     malformed.
+  bool Next(ETWRawRecordHeader* header, const char** payload);
+
+  // @returns true if the reading stopped on a truncated record or on a
+  //     corrupted block.
+  bool malformed() const { return corrupted_ || reader_->truncated(); }
+
+ private:
+  // Decompresses the blocks following the window, and appends them to it.
+  // @returns false if a block is corrupted.
+  bool AppendBlocks();
+
+  base::MemoryMappedFile file_;
+  base::CompressedFileReader compressed_file_;
+  bool compressed_;
+
+  // The window over a compressed file, from the first unread byte on, and
+  // the offset of the next block to decompress.
+  std::string window_;
+  std::string blocks_;
+  uint64 next_offset_;
+  bool corrupted_;
+
+  scoped_ptr<ETWRawRecordReader> reader_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordFile);
+};
+
+bool RecordFile::Open(const std::string& path) {
+  if (!file_.Open(path)) {
+    LOG(WARNING) << "Unable to map the raw record file " << path << ".";
+    return false;
+  }
+
+  if (!base::IsCompressedFile(file_.data(), file_.length())) {
+    reader_.reset(new ETWRawRecordReader(file_.data(), file_.length()));
+    return true;
+  }
+
+  file_.Close();
+  compressed_ = true;
+  if (!compressed_file_.Open(path)) {
+    LOG(WARNING) << "The compressed raw record file " << path
+                 << " is malformed.";
+    return false;
+  }
+  while (window_.size() < sizeof(ETWRawRecordFileHeader) &&
+         next_offset_ < compressed_file_.length()) {
+    if (!AppendBlocks()) {
+      LOG(WARNING) << "The compressed raw record file " << path
+                   << " is malformed.";
+      return false;
+    }
+  }
+  reader_.reset(new ETWRawRecordReader(window_.data(), window_.size()));
+  reader_->set_at_end(next_offset_ >= compressed_file_.length());
+  return true;
+}
+
+bool RecordFile::Next(ETWRawRecordHeader* header, const char** payload) {
+  if (reader_->Next(header, payload))
+    return true;
+
+  // Move the window, keeping the unread bytes, e.g. a record or its padding
+  // cut by the end of the window.
+  while (compressed_ && reader_->IsValid() && !corrupted_ &&
+         next_offset_ < compressed_file_.length()) {
+    window_.erase(0, reader_->offset());
+    if (!AppendBlocks()) {
+      corrupted_ = true;
+      return false;
+    }
+    reader_->Continue(window_.data(), window_.size(),
+                      next_offset_ >= compressed_file_.length());
+    if (reader_->Next(header, payload))
+      return true;
+  }
+  return false;
+}
+
+bool RecordFile::AppendBlocks() {
+  uint64 offset = 0;
+  size_t length = kRecordWindowBlocks * compressed_file_.block_size();
+  if (!compressed_file_.ReadBlocks(next_offset_, length, &blocks_, &offset) ||
+      blocks_.empty()) {
+    return false;
+  }
+  DCHECK_EQ(next_offset_, offset);
+  next_offset_ += blocks_.size();
+  window_.append(blocks_);
+  return true;
+}
+
+// Decodes the records of a file and sends them to |observer|. The stacks are
+// interned into |stack_table| unless it is NULL.
+// @returns false if the file is malformed.
+bool ParseRecords(RecordFile* file,
+                  event::StackTable* stack_table,
+                  const base::Observer<Event>& observer) {
+  if (!file->IsValid())
+    return false;
+
+  // A trace never mixes pointer widths, but the flag is per record: select
+  // both decoders once.
+  RawETWKernelPayloadDecoder decoder32 = GetRawETWKernelPayloadDecoder(false);
+  RawETWKernelPayloadDecoder decoder64 = GetRawETWKernelPayloadDecoder(true);
+
+  // The decode context is reused from one event to the next. It is shared
+  // by the parsers of the thread: restore its stack table when done.
+  DecodeContext* decode_context = DecodeContext::Current();
+  event::StackTable* previous_stack_table = decode_context->stack_table();
+  decode_context->set_stack_table(stack_table);
+
+  // The formatted identifier of the last provider: consecutive events often
+  // come from the same provider.
+  std::string provider_id;
+  uint8 last_provider_id[16] = {};
+
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  while (file->Next(&header, &payload)) {
+    decode_context->Reset();
+
+    if (provider_id.empty() ||
+        memcmp(header.provider_id, last_provider_id,
+               sizeof(last_provider_id)) != 0) {
+      memcpy(last_provider_id, header.provider_id, sizeof(last_provider_id));
+      ProviderIdToString(last_provider_id, &provider_id);
+    }
+
+    // Decode the payload of the event.
+    RawETWKernelPayloadDecoder decode =
+        (header.flags & kETWRawRecordFlag64Bit) != 0 ? decoder64 : decoder32;
+    scoped_ptr<Value> decoded_payload;
+    if (!decode(provider_id, header.version, header.opcode, payload,
+                header.payload_size, decode_context, &decoded_payload)) {
+      continue;
+    }
+
+    // Generate the event header fields.
+    scoped_ptr<StructValue> fields(new StructValue());
+    fields->AddField<StringValue>("operation", decode_context->operation());
+    fields->AddField<StringValue>("category", decode_context->category());
+    fields->AddField<ULongValue>("process_id", header.process_id);
+    fields->AddField<ULongValue>("thread_id", header.thread_id);
+    fields->AddField<UCharValue>(
+        "processor_number",
+        static_cast<unsigned char>(header.processor_number));
+    fields->AddField("content", decoded_payload.Pass());
+
+    // Create the event with decoded fields and send it to the observer.
+    Event event(Timestamp(header.timestamp), fields.Pass());
+    observer.Receive(event);
+  }
+
+  decode_context->set_stack_table(previous_stack_table);
+  return !file->malformed();
+}
+
+// Counts the records of a file into |table|, from their headers only.
+// @returns false if the file is malformed.
+bool CollectRecordStats(RecordFile* file, TraceStatsTable* table) {
+  if (!file->IsValid())
+    return false;
+
+  std::string provider_id;
+  uint8 last_provider_id[16] = {};
+  size_t provider = 0;
+  bool is_event_trace = false;
+
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  while (file->Next(&header, &payload)) {
+    if (provider_id.empty() ||
+        memcmp(header.provider_id, last_provider_id,
+               sizeof(last_provider_id)) != 0) {
+      memcpy(last_provider_id, header.provider_id, sizeof(last_provider_id));
+      ProviderIdToString(last_provider_id, &provider_id);
+      provider = table->AddProvider(provider_id);
+      is_event_trace = provider_id == kEventTraceProviderId;
+    }
+
+    table->Record(provider, header.opcode, header.process_id,
+                  header.processor_number, header.timestamp,
+                  header.payload_size);
+
+    if (is_event_trace && header.opcode == kEventTraceHeaderOpcode &&
+        header.version == kEventTraceHeaderVersion) {
+      size_t buffers_lost_offset =
+          (header.flags & kETWRawRecordFlag64Bit) != 0 ?
+              kBuffersLostOffset64 : kBuffersLostOffset32;
+      if (header.payload_size >= buffers_lost_offset + sizeof(uint32)) {
+        uint32 events_lost = 0;
+        uint32 buffers_lost = 0;
+        memcpy(&events_lost, payload + kEventsLostOffset,
+               sizeof(events_lost));
+        memcpy(&buffers_lost, payload + buffers_lost_offset,
+               sizeof(buffers_lost));
+        table->RecordLosses(events_lost, buffers_lost);
+      }
+    }
+  }
+
+  return !file->malformed();
+}
+
+// Counts the records of a share of the trace files, into its own table.
+class StatsWorker : public base::Thread::Delegate {
+ public:
+  // @param traces the trace files.
+  // @param first the index of the first trace file of the worker.
+  // @param step the distance between the trace files of the worker.
+  // @param decompress_thread_count the number of threads decompressing a
+  //     compressed trace file.
+  StatsWorker(const std::vector<std::string>* traces,
+              size_t first,
+              size_t step,
+              size_t decompress_thread_count)
+      : traces_(traces),
+        first_(first),
+        step_(step),
+        decompress_thread_count_(decompress_thread_count) {
+  }
+
+  virtual void Run() OVERRIDE {
+    for (size_t i = first_; i < traces_->size(); i += step_) {
+      const std::string& path = (*traces_)[i];
+      RecordFile file(decompress_thread_count_);
+      if (!file.Open(path))
+        continue;
+      if (!CollectRecordStats(&file, &table_)) {
+        LOG(WARNING) << "The raw record file " << path << " is malformed.";
+      }
+    }
+  }
+
+  const TraceStatsTable& table() const { return table_; }
+
+ private:
+  const std::vector<std::string>* traces_;
+  size_t first_;
+  size_t step_;
+  size_t decompress_thread_count_;
+  TraceStatsTable table_;
+
+  DISALLOW_COPY_AND_ASSIGN(StatsWorker);
+};
+
+}  // namespace
+
+bool ETWRawRecordParser::AddTraceFile(const std::string& path) {
+  if (!base::StringEndsWith(path, kETWRawRecordFileExtension))
+    return false;
+  traces_.push_back(path);
+  return true;
+}
+
+void ETWRawRecordParser::Parse(const base::Observer<Event>& observer) {
+  for (size_t i = 0; i < traces_.size(); ++i) {
+    RecordFile file(base::Thread::NumberOfProcessors());
+    if (!file.Open(traces_[i]))
+      continue;
+
+    if (!ParseRecords(&file, stack_table(), observer)) {
+      LOG(WARNING) << "The raw record file " << traces_[i]
+                   << " is malformed.";
+    }
+  }
+}
+
+bool ETWRawRecordParser::CollectStats(TraceStats* stats) {
+  DCHECK(stats != NULL);
+
+  // The trace files are shared between the threads. The calling thread runs
+  // the first worker. The processors left over decompress the files.
+  size_t processor_count = base::Thread::NumberOfProcessors();
+  size_t thread_count = std::min(processor_count, traces_.size());
+  if (thread_count == 0)
+    thread_count = 1;
+  size_t decompress_thread_count =
+      std::max(static_cast<size_t>(1), processor_count / thread_count);
+  std::vector<StatsWorker*> workers;
+  std::vector<base::Thread*> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers.push_back(new StatsWorker(&traces_, i, thread_count,
+                                      decompress_thread_count));
+    if (i == 0)
+      continue;
+    base::Thread* thread = new base::Thread(workers[i]);
+    threads.push_back(thread);
+    if (!thread->Start())
+      workers[i]->Run();
+  }
+  workers[0]->Run();
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->table().MergeInto(stats);
+    delete workers[i];
+  }
+  return true;
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,206 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_raw_record_parser.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "base/compressed_file.h"
+#include "base/observer.h"
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+#include "parser/etw/etw_raw_record.h"
+#include "parser/trace_stats.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+const char kTempFile[] = "etw_raw_record_parser_perftest.etwraw";
+const size_t kRecords = 500000;
+const size_t kFileRecords = 200000;
+
+const char kThreadProviderId[] = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+const unsigned char kThreadCSwitchOpcode = 36;
+
+const char kFileIOProviderId[] = "90CBDC39-4A3E-11D1-84F4-0000F80464E3";
+const unsigned char kFileIOFileCreateOpcode = 32;
+
+const unsigned char kThreadCSwitchPayloadV2[] = {
+    0xCC, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x04,
+    0x01, 0x00, 0x00, 0x00, 0x87, 0x6D, 0x88, 0x34
+    };
+
+class EventCounter {
+ public:
+  EventCounter() : count_(0) {}
+
+  void Receive(const event::Event& /* event */) { ++count_; }
+
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_;
+};
+
+// Writes FileIO events carrying file paths: their payloads dominate the size
+// of the trace.
+// @param out the stream receiving the raw record file.
+void WriteFileRecords(std::ostream* out) {
+  ETWRawRecordWriter writer(out);
+  ETWRawRecordHeader header = {};
+  ASSERT_TRUE(StringToProviderId(kFileIOProviderId, header.provider_id));
+  header.version = 2;
+  header.opcode = kFileIOFileCreateOpcode;
+  header.flags = kETWRawRecordFlag64Bit;
+
+  std::string payload;
+  for (size_t i = 0; i < kFileRecords; ++i) {
+    char path[128];
+    snprintf(path, sizeof(path),
+             "\\Device\\HarddiskVolume2\\Windows\\System32\\"
+             "drivers\\module%u.sys",
+             static_cast<unsigned>((i * 7919) % 4096));
+
+    // The file object, then the path in UTF-16, null-terminated.
+    uint64 file_object = 0xFFFFC00005570C30ULL + (i % 64) * 0x100;
+    payload.assign(reinterpret_cast<const char*>(&file_object),
+                   sizeof(file_object));
+    for (const char* c = path; ; ++c) {
+      payload.push_back(*c);
+      payload.push_back('\0');
+      if (*c == '\0')
+        break;
+    }
+
+    header.timestamp = i * 100;
+    header.process_id = static_cast<uint32>(1000 + i % 16);
+    header.thread_id = static_cast<uint32>(2000 + i % 64);
+    header.processor_number = static_cast<uint16>(i % 8);
+    header.payload_size = static_cast<uint32>(payload.size());
+    writer.Write(header, payload.data());
+  }
+}
+
+// Parses the temporary file and reports the time per event.
+void ParseFileRecords(const std::string& name) {
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCounter counter;
+
+  base::PerfTimer timer;
+  parser.Parse(base::MakeObserver(&counter, &EventCounter::Receive));
+  base::PrintPerfResult(name, "time", timer.ElapsedNanoseconds(),
+                        kFileRecords, "ns/event");
+  EXPECT_EQ(kFileRecords, counter.count());
+
+  FILE* file = fopen(kTempFile, "rb");
+  ASSERT_TRUE(file != NULL);
+  fseek(file, 0, SEEK_END);
+  base::PrintPerfResult(name, "size", static_cast<uint64>(ftell(file)),
+                        kFileRecords, "bytes/event");
+  fclose(file);
+}
+
+}  // namespace
+
+TEST(ETWRawRecordParserPerfTest, ParsePayloadHeavy) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    WriteFileRecords(&out);
+  }
+  ParseFileRecords("ParseUncompressedFileRecords");
+
+  {
+    std::ofstream file(kTempFile, std::ios::binary);
+    base::CompressingStreamBuffer buffer(
+        &file, base::kDefaultCompressedBlockSize);
+    std::ostream out(&buffer);
+    WriteFileRecords(&out);
+    ASSERT_TRUE(buffer.Finish());
+  }
+  ParseFileRecords("ParseCompressedFileRecords");
+
+  std::remove(kTempFile);
+}
+
+TEST(ETWRawRecordParserPerfTest, CollectStats) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    WriteFileRecords(&out);
+  }
+  ParseFileRecords("ParseFileRecords");
+
+  // The same file, from the headers only.
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  TraceStats stats;
+  base::PerfTimer timer;
+  ASSERT_TRUE(parser.CollectStats(&stats));
+  base::PrintPerfResult("CollectFileRecordStats", "time",
+                        timer.ElapsedNanoseconds(), kFileRecords,
+                        "ns/event");
+  EXPECT_EQ(kFileRecords, stats.event_count);
+
+  std::remove(kTempFile);
+}
+
+TEST(ETWRawRecordParserPerfTest, Parse) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    ETWRawRecordWriter writer(&out);
+    ETWRawRecordHeader header = {};
+    ASSERT_TRUE(StringToProviderId(kThreadProviderId, header.provider_id));
+    header.payload_size = sizeof(kThreadCSwitchPayloadV2);
+    header.version = 2;
+    header.opcode = kThreadCSwitchOpcode;
+    header.flags = kETWRawRecordFlag64Bit;
+    for (size_t i = 0; i < kRecords; ++i) {
+      header.timestamp = i * 100;
+      header.processor_number = static_cast<uint16>(i % 8);
+      writer.Write(header,
+                   reinterpret_cast<const char*>(kThreadCSwitchPayloadV2));
+    }
+  }
+
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCounter counter;
+
+  base::PerfTimer timer;
+  parser.Parse(base::MakeObserver(&counter, &EventCounter::Receive));
+  base::PrintPerfResult("ParseRawRecords", "time",
+                        timer.ElapsedNanoseconds(), kRecords, "ns/event");
+
+  std::remove(kTempFile);
+  EXPECT_EQ(kRecords, counter.count());
+}
+
+}  // namespace etw
+}  // namespace parser
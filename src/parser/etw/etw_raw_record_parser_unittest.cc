@@ -0,0 +1,446 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_raw_record_parser.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/compressed_file.h"
+#include "base/observer.h"
+#include "event/stack_table.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/etw/etw_raw_kernel_payload_decoder.h"
+#include "parser/etw/etw_raw_record.h"
+#include "parser/trace_stats.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+using event::StructValue;
+
+const char kTempFile[] = "etw_raw_record_parser_unittest.etwraw";
+const char kSecondTempFile[] = "etw_raw_record_parser_unittest_2.etwraw";
+
+const char kThreadProviderId[] = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+const char kUnknownProviderId[] = "01234567-89AB-CDEF-0123-456789ABCDEF";
+const char kEventTraceProviderId[] = "68FDD900-4A3E-11D1-84F4-0000F80464E3";
+const char kStackWalkProviderId[] = "DEF2FE46-7BD6-4B80-BD94-F57FE20D0CE3";
+const unsigned char kThreadCSwitchOpcode = 36;
+const unsigned char kStackWalkStackOpcode = 32;
+const unsigned char kEventTraceHeaderOpcode = 0;
+
+const unsigned char kThreadCSwitchPayloadV2[] = {
+    0xCC, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x04,
+    0x01, 0x00, 0x00, 0x00, 0x87, 0x6D, 0x88, 0x34
+    };
+
+const unsigned char kThreadCSwitchPayload32bitsV2[] = {
+    0x00, 0x00, 0x00, 0x00, 0x2C, 0x11, 0x00, 0x00,
+    0x00, 0x09, 0x00, 0x00, 0x17, 0x00, 0x01, 0x00,
+    0x12, 0x00, 0x00, 0x00, 0x26, 0x48, 0x00, 0x00
+    };
+
+// Keeps the header fields of the received events.
+struct ReceivedEvent {
+  uint64 timestamp;
+  std::string operation;
+  std::string category;
+  uint64 process_id;
+  uint64 thread_id;
+  uint32 new_thread_id;
+};
+
+class EventCollector {
+ public:
+  void Receive(const event::Event& event) {
+    const StructValue* fields = StructValue::Cast(event.payload());
+    ASSERT_TRUE(fields != NULL);
+
+    ReceivedEvent received = {};
+    received.timestamp = event.timestamp();
+    const StructValue* content = NULL;
+    ASSERT_TRUE(fields->GetFieldAsString("operation", &received.operation));
+    ASSERT_TRUE(fields->GetFieldAsString("category", &received.category));
+    ASSERT_TRUE(fields->GetFieldAsULong("process_id", &received.process_id));
+    ASSERT_TRUE(fields->GetFieldAsULong("thread_id", &received.thread_id));
+    ASSERT_TRUE(fields->GetFieldAs<StructValue>("content", &content));
+    ASSERT_TRUE(content->GetFieldAsUInteger("NewThreadId",
+                                            &received.new_thread_id));
+    events.push_back(received);
+  }
+
+  std::vector<ReceivedEvent> events;
+};
+
+// Keeps the content of the received StackWalk events.
+class StackCollector {
+ public:
+  void Receive(const event::Event& event) {
+    const StructValue* fields = StructValue::Cast(event.payload());
+    ASSERT_TRUE(fields != NULL);
+    const StructValue* content = NULL;
+    ASSERT_TRUE(fields->GetFieldAs<StructValue>("content", &content));
+    uint32 stack_id = 0;
+    ASSERT_TRUE(content->GetFieldAsUInteger("StackId", &stack_id));
+    EXPECT_FALSE(content->HasField("Stack"));
+    stack_ids.push_back(stack_id);
+  }
+
+  std::vector<uint32> stack_ids;
+};
+
+class ETWRawRecordParserTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+    std::remove(kSecondTempFile);
+  }
+};
+
+void WriteRecord(ETWRawRecordWriter* writer,
+                 const char* provider_id,
+                 uint64 timestamp,
+                 bool is_64_bit,
+                 const unsigned char* payload,
+                 size_t payload_size) {
+  ETWRawRecordHeader header = {};
+  ASSERT_TRUE(StringToProviderId(provider_id, header.provider_id));
+  header.timestamp = timestamp;
+  header.process_id = 12;
+  header.thread_id = 34;
+  header.payload_size = static_cast<uint32>(payload_size);
+  header.version = 2;
+  header.opcode = kThreadCSwitchOpcode;
+  header.flags = is_64_bit ? kETWRawRecordFlag64Bit : 0;
+  writer->Write(header, reinterpret_cast<const char*>(payload));
+}
+
+// Writes a 64-bit StackWalk record with the frames |first_frame| + i.
+void WriteStackRecord(ETWRawRecordWriter* writer,
+                      uint64 first_frame,
+                      size_t frame_count) {
+  std::vector<uint64> payload(2 + frame_count);
+  for (size_t i = 0; i < frame_count; ++i)
+    payload[2 + i] = first_frame + i;
+
+  ETWRawRecordHeader header = {};
+  ASSERT_TRUE(StringToProviderId(kStackWalkProviderId, header.provider_id));
+  header.payload_size = static_cast<uint32>(payload.size() * sizeof(uint64));
+  header.version = 2;
+  header.opcode = kStackWalkStackOpcode;
+  header.flags = kETWRawRecordFlag64Bit;
+  writer->Write(header, reinterpret_cast<const char*>(&payload[0]));
+}
+
+// Makes an EventTrace Header payload, version 2, with zeros except for the
+// loss counters. Checks that the payload decodes to the same counters.
+// @param is_64_bit whether the payload has 64-bit pointers.
+// @param events_lost the EventsLost field.
+// @param buffers_lost the BuffersLost field.
+// @param payload receives the payload.
+void MakeHeaderPayload(bool is_64_bit,
+                       uint32 events_lost,
+                       uint32 buffers_lost,
+                       std::string* payload) {
+  // The fixed fields, then two empty strings.
+  size_t buffers_lost_offset = is_64_bit ? 276 : 268;
+  payload->assign(buffers_lost_offset + sizeof(uint32) + 4, '\0');
+  memcpy(&(*payload)[48], &events_lost, sizeof(events_lost));
+  memcpy(&(*payload)[buffers_lost_offset], &buffers_lost,
+         sizeof(buffers_lost));
+
+  std::string operation;
+  std::string category;
+  scoped_ptr<event::Value> decoded;
+  ASSERT_TRUE(DecodeRawETWKernelPayload(
+      kEventTraceProviderId, 2, kEventTraceHeaderOpcode, is_64_bit,
+      payload->data(), payload->size(), &operation, &category, &decoded));
+  const StructValue* fields = StructValue::Cast(decoded.get());
+  ASSERT_TRUE(fields != NULL);
+  uint32 decoded_events_lost = 0;
+  uint32 decoded_buffers_lost = 0;
+  ASSERT_TRUE(fields->GetFieldAsUInteger("EventsLost",
+                                         &decoded_events_lost));
+  ASSERT_TRUE(fields->GetFieldAsUInteger("BuffersLost",
+                                         &decoded_buffers_lost));
+  EXPECT_EQ(events_lost, decoded_events_lost);
+  EXPECT_EQ(buffers_lost, decoded_buffers_lost);
+}
+
+// Writes an EventTrace Header record.
+void WriteHeaderRecord(ETWRawRecordWriter* writer,
+                       bool is_64_bit,
+                       uint32 events_lost,
+                       uint32 buffers_lost) {
+  std::string payload;
+  MakeHeaderPayload(is_64_bit, events_lost, buffers_lost, &payload);
+
+  ETWRawRecordHeader header = {};
+  ASSERT_TRUE(StringToProviderId(kEventTraceProviderId, header.provider_id));
+  header.payload_size = static_cast<uint32>(payload.size());
+  header.version = 2;
+  header.opcode = kEventTraceHeaderOpcode;
+  header.flags = is_64_bit ? kETWRawRecordFlag64Bit : 0;
+  writer->Write(header, payload.data());
+}
+
+}  // namespace
+
+TEST_F(ETWRawRecordParserTest, AddTraceFile) {
+  ETWRawRecordParser parser;
+  EXPECT_TRUE(parser.AddTraceFile("trace.etwraw"));
+  EXPECT_FALSE(parser.AddTraceFile("trace.etl"));
+}
+
+TEST_F(ETWRawRecordParserTest, Parse) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    ETWRawRecordWriter writer(&out);
+    WriteRecord(&writer, kThreadProviderId, 100, true,
+                kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2));
+    // Undecodable events are skipped.
+    WriteRecord(&writer, kUnknownProviderId, 150, true,
+                kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2));
+    WriteRecord(&writer, kThreadProviderId, 200, false,
+                kThreadCSwitchPayload32bitsV2,
+                sizeof(kThreadCSwitchPayload32bitsV2));
+  }
+
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCollector collector;
+  parser.Parse(base::MakeObserver(&collector, &EventCollector::Receive));
+
+  ASSERT_EQ(2U, collector.events.size());
+  EXPECT_EQ(100U, collector.events[0].timestamp);
+  EXPECT_EQ("CSwitch", collector.events[0].operation);
+  EXPECT_EQ("Thread", collector.events[0].category);
+  EXPECT_EQ(12U, collector.events[0].process_id);
+  EXPECT_EQ(34U, collector.events[0].thread_id);
+  EXPECT_EQ(2252U, collector.events[0].new_thread_id);
+  EXPECT_EQ(200U, collector.events[1].timestamp);
+  EXPECT_EQ(0U, collector.events[1].new_thread_id);
+}
+
+TEST_F(ETWRawRecordParserTest, ParseInternsStacks) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    ETWRawRecordWriter writer(&out);
+    WriteStackRecord(&writer, 0x1000, 8);
+    WriteStackRecord(&writer, 0x2000, 400);
+    WriteStackRecord(&writer, 0x1000, 8);
+  }
+
+  event::StackTable stack_table;
+  Parser parser;
+  parser.set_stack_table(&stack_table);
+  parser.RegisterParser(scoped_ptr<ParserImpl>(new ETWRawRecordParser()));
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  StackCollector collector;
+  parser.Parse(base::MakeObserver(&collector, &StackCollector::Receive));
+
+  ASSERT_EQ(3U, collector.stack_ids.size());
+  EXPECT_NE(collector.stack_ids[0], collector.stack_ids[1]);
+  EXPECT_EQ(collector.stack_ids[0], collector.stack_ids[2]);
+  ASSERT_EQ(2U, stack_table.stack_count());
+
+  event::Stack stack;
+  stack_table.GetStack(event::StackId(collector.stack_ids[1]), &stack);
+  ASSERT_EQ(400U, stack.size());
+  EXPECT_EQ(0x2000U, stack.front());
+}
+
+TEST_F(ETWRawRecordParserTest, ParseCompressed) {
+  {
+    std::ofstream file(kTempFile, std::ios::binary);
+    // Small blocks, so that the records span several blocks, and the file
+    // several windows.
+    base::CompressingStreamBuffer buffer(&file, 100);
+    std::ostream out(&buffer);
+    ETWRawRecordWriter writer(&out);
+    for (uint64 i = 0; i < 1000; ++i) {
+      WriteRecord(&writer, kThreadProviderId, i, true,
+                  kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2));
+    }
+    ASSERT_TRUE(buffer.Finish());
+  }
+
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCollector collector;
+  parser.Parse(base::MakeObserver(&collector, &EventCollector::Receive));
+
+  ASSERT_EQ(1000U, collector.events.size());
+  for (uint64 i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i, collector.events[i].timestamp);
+    EXPECT_EQ(2252U, collector.events[i].new_thread_id);
+  }
+}
+
+TEST_F(ETWRawRecordParserTest, ParseCompressedFlushedInPadding) {
+  // Records with padding, each CSwitch record preceded by a record of an
+  // unknown provider with a 3-byte payload and 5 bytes of padding.
+  const unsigned char kShortPayload[] = { 1, 2, 3 };
+  const size_t kPairSize = 2 * sizeof(ETWRawRecordHeader) + 8 +
+                           sizeof(kThreadCSwitchPayloadV2);
+  std::ostringstream records;
+  ETWRawRecordWriter writer(&records);
+  for (uint64 i = 0; i < 200; ++i) {
+    WriteRecord(&writer, kUnknownProviderId, i, true,
+                kShortPayload, sizeof(kShortPayload));
+    WriteRecord(&writer, kThreadProviderId, i, true,
+                kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2));
+  }
+  std::string data = records.str();
+  ASSERT_EQ(sizeof(ETWRawRecordFileHeader) + 200 * kPairSize, data.size());
+
+  {
+    std::ofstream file(kTempFile, std::ios::binary);
+    // Odd blocks larger than a pair of records: each flush ends a block in
+    // the padding of a record, and so does each window.
+    base::CompressingStreamBuffer buffer(&file, 131);
+    std::ostream out(&buffer);
+    size_t offset = 0;
+    for (size_t i = 0; i < 200; ++i) {
+      size_t cut = sizeof(ETWRawRecordFileHeader) + i * kPairSize +
+                   sizeof(ETWRawRecordHeader) + sizeof(kShortPayload) + 2;
+      out.write(data.data() + offset, cut - offset);
+      out.flush();
+      offset = cut;
+    }
+    out.write(data.data() + offset, data.size() - offset);
+    ASSERT_TRUE(buffer.Finish());
+  }
+
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCollector collector;
+  parser.Parse(base::MakeObserver(&collector, &EventCollector::Receive));
+
+  ASSERT_EQ(200U, collector.events.size());
+  for (uint64 i = 0; i < 200; ++i)
+    EXPECT_EQ(i, collector.events[i].timestamp);
+}
+
+TEST_F(ETWRawRecordParserTest, ParseCompressedRecordLargerThanWindow) {
+  {
+    std::ofstream file(kTempFile, std::ios::binary);
+    base::CompressingStreamBuffer buffer(&file, 16);
+    std::ostream out(&buffer);
+    ETWRawRecordWriter writer(&out);
+    WriteStackRecord(&writer, 0x1000, 8);
+    WriteStackRecord(&writer, 0x2000, 400);
+    WriteStackRecord(&writer, 0x3000, 8);
+    ASSERT_TRUE(buffer.Finish());
+  }
+
+  event::StackTable stack_table;
+  Parser parser;
+  parser.set_stack_table(&stack_table);
+  parser.RegisterParser(scoped_ptr<ParserImpl>(new ETWRawRecordParser()));
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  StackCollector collector;
+  parser.Parse(base::MakeObserver(&collector, &StackCollector::Receive));
+
+  ASSERT_EQ(3U, collector.stack_ids.size());
+  event::Stack stack;
+  stack_table.GetStack(event::StackId(collector.stack_ids[1]), &stack);
+  ASSERT_EQ(400U, stack.size());
+  EXPECT_EQ(0x2000U + 399, stack.back());
+  stack_table.GetStack(event::StackId(collector.stack_ids[2]), &stack);
+  ASSERT_EQ(8U, stack.size());
+  EXPECT_EQ(0x3000U, stack.front());
+}
+
+TEST_F(ETWRawRecordParserTest, CollectStats) {
+  {
+    std::ofstream out(kTempFile, std::ios::binary);
+    ETWRawRecordWriter writer(&out);
+    WriteHeaderRecord(&writer, true, 31, 2);
+    WriteRecord(&writer, kThreadProviderId, 100, true,
+                kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2));
+    // The payloads are not decoded: unknown providers are counted too.
+    WriteRecord(&writer, kUnknownProviderId, 150, true,
+                kThreadCSwitchPayloadV2, sizeof(kThreadCSwitchPayloadV2));
+  }
+  {
+    std::ofstream file(kSecondTempFile, std::ios::binary);
+    base::CompressingStreamBuffer buffer(&file, 64);
+    std::ostream out(&buffer);
+    ETWRawRecordWriter writer(&out);
+    WriteHeaderRecord(&writer, false, 5, 1);
+    WriteRecord(&writer, kThreadProviderId, 50, false,
+                kThreadCSwitchPayload32bitsV2,
+                sizeof(kThreadCSwitchPayload32bitsV2));
+    ASSERT_TRUE(buffer.Finish());
+  }
+
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  ASSERT_TRUE(parser.AddTraceFile(kSecondTempFile));
+  TraceStats stats;
+  ASSERT_TRUE(parser.CollectStats(&stats));
+
+  EXPECT_EQ(5U, stats.event_count);
+  EXPECT_EQ(0U, stats.first_timestamp);
+  EXPECT_EQ(150U, stats.last_timestamp);
+  ASSERT_TRUE(stats.has_lost_counts);
+  EXPECT_EQ(36U, stats.events_lost);
+  EXPECT_EQ(3U, stats.buffers_lost);
+
+  ASSERT_EQ(3U, stats.events_per_type.size());
+  EXPECT_EQ(2U, stats.events_per_type[TraceStatsEventType(
+      kEventTraceProviderId, kEventTraceHeaderOpcode)]);
+  EXPECT_EQ(2U, stats.events_per_type[TraceStatsEventType(
+      kThreadProviderId, kThreadCSwitchOpcode)]);
+  EXPECT_EQ(1U, stats.events_per_type[TraceStatsEventType(
+      kUnknownProviderId, kThreadCSwitchOpcode)]);
+
+  ASSERT_EQ(2U, stats.events_per_process.size());
+  EXPECT_EQ(3U, stats.events_per_process[12]);
+  EXPECT_EQ(2U, stats.events_per_process[0]);
+  ASSERT_EQ(1U, stats.events_per_processor.size());
+  EXPECT_EQ(5U, stats.events_per_processor[0]);
+}
+
+TEST_F(ETWRawRecordParserTest, ParseMissingFile) {
+  ETWRawRecordParser parser;
+  ASSERT_TRUE(parser.AddTraceFile("missing.etwraw"));
+  EventCollector collector;
+  parser.Parse(base::MakeObserver(&collector, &EventCollector::Receive));
+  EXPECT_TRUE(collector.events.empty());
+}
+
+}  // namespace etw
+}  // namespace parser
@@ -0,0 +1,226 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/etw/etw_raw_record.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace etw {
+
+namespace {
+
+const char kThreadProviderId[] = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+
+// The memory layout of the GUID of the Thread provider.
+const uint8 kThreadProviderGuid[16] = {
+    0xD1, 0xA8, 0x6F, 0x3D, 0x05, 0xFE, 0xD0, 0x11,
+    0x9D, 0xDA, 0x00, 0xC0, 0x4F, 0xD7, 0xBA, 0x7C
+    };
+
+ETWRawRecordHeader MakeHeader(uint64 timestamp, uint32 payload_size) {
+  ETWRawRecordHeader header = {};
+  memcpy(header.provider_id, kThreadProviderGuid, sizeof(header.provider_id));
+  header.timestamp = timestamp;
+  header.process_id = 12;
+  header.thread_id = 34;
+  header.payload_size = payload_size;
+  header.processor_number = 3;
+  header.version = 2;
+  header.opcode = 36;
+  header.flags = kETWRawRecordFlag64Bit;
+  return header;
+}
+
+}  // namespace
+
+TEST(ETWRawRecordTest, ProviderIdToString) {
+  std::string str;
+  ProviderIdToString(kThreadProviderGuid, &str);
+  EXPECT_EQ(kThreadProviderId, str);
+}
+
+TEST(ETWRawRecordTest, StringToProviderId) {
+  uint8 provider_id[16] = {};
+  EXPECT_TRUE(StringToProviderId(kThreadProviderId, provider_id));
+  EXPECT_EQ(0, memcmp(kThreadProviderGuid, provider_id, sizeof(provider_id)));
+
+  EXPECT_TRUE(StringToProviderId("3d6fa8d1-fe05-11d0-9dda-00c04fd7ba7c",
+                                 provider_id));
+  EXPECT_EQ(0, memcmp(kThreadProviderGuid, provider_id, sizeof(provider_id)));
+
+  EXPECT_FALSE(StringToProviderId("", provider_id));
+  EXPECT_FALSE(StringToProviderId("3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7",
+                                  provider_id));
+  EXPECT_FALSE(StringToProviderId("3D6FA8D1+FE05-11D0-9DDA-00C04FD7BA7C",
+                                  provider_id));
+  EXPECT_FALSE(StringToProviderId("3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7G",
+                                  provider_id));
+}
+
+TEST(ETWRawRecordTest, WriteRead) {
+  const char kPayload[] = "0123456789";
+  std::ostringstream out;
+  ETWRawRecordWriter writer(&out);
+  EXPECT_TRUE(writer.Write(MakeHeader(100, 10), kPayload));
+  EXPECT_TRUE(writer.Write(MakeHeader(200, 0), NULL));
+  EXPECT_TRUE(writer.Write(MakeHeader(300, 8), kPayload));
+  EXPECT_EQ(3U, writer.record_count());
+
+  // Each record is padded to the alignment.
+  std::string data = out.str();
+  EXPECT_EQ(sizeof(ETWRawRecordFileHeader) + 3 * sizeof(ETWRawRecordHeader) +
+                16 + 8,
+            data.size());
+
+  ETWRawRecordReader reader(data.data(), data.size());
+  ASSERT_TRUE(reader.IsValid());
+
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  EXPECT_EQ(100U, header.timestamp);
+  EXPECT_EQ(12U, header.process_id);
+  EXPECT_EQ(34U, header.thread_id);
+  EXPECT_EQ(3U, header.processor_number);
+  EXPECT_EQ(2U, header.version);
+  EXPECT_EQ(36U, header.opcode);
+  EXPECT_EQ(kETWRawRecordFlag64Bit, header.flags);
+  EXPECT_EQ(0, memcmp(kThreadProviderGuid, header.provider_id, 16));
+  EXPECT_EQ("0123456789", std::string(payload, header.payload_size));
+
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  EXPECT_EQ(200U, header.timestamp);
+  EXPECT_EQ(0U, header.payload_size);
+
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  EXPECT_EQ(300U, header.timestamp);
+  EXPECT_EQ("01234567", std::string(payload, header.payload_size));
+
+  EXPECT_FALSE(reader.Next(&header, &payload));
+  EXPECT_FALSE(reader.truncated());
+}
+
+TEST(ETWRawRecordTest, Truncated) {
+  const char kPayload[] = "0123456789";
+  std::ostringstream out;
+  ETWRawRecordWriter writer(&out);
+  writer.Write(MakeHeader(100, 10), kPayload);
+  writer.Write(MakeHeader(200, 10), kPayload);
+
+  // Cut the payload of the second record.
+  std::string data = out.str();
+  data.resize(data.size() - 12);
+
+  ETWRawRecordReader reader(data.data(), data.size());
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  EXPECT_TRUE(reader.Next(&header, &payload));
+  EXPECT_FALSE(reader.Next(&header, &payload));
+  EXPECT_TRUE(reader.truncated());
+}
+
+TEST(ETWRawRecordTest, Continue) {
+  const char kPayload[] = "0123456789";
+  std::ostringstream out;
+  ETWRawRecordWriter writer(&out);
+  writer.Write(MakeHeader(100, 10), kPayload);
+  writer.Write(MakeHeader(200, 10), kPayload);
+  std::string data = out.str();
+
+  // The second record is cut, then continued in a buffer holding the rest
+  // of the file.
+  std::string first = data.substr(0, data.size() - 12);
+  ETWRawRecordReader reader(first.data(), first.size());
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  EXPECT_FALSE(reader.Next(&header, &payload));
+  EXPECT_TRUE(reader.truncated());
+
+  std::string rest = data.substr(reader.offset());
+  reader.Continue(rest.data(), rest.size(), true);
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  EXPECT_EQ(200U, header.timestamp);
+  EXPECT_EQ("0123456789", std::string(payload, header.payload_size));
+  EXPECT_FALSE(reader.Next(&header, &payload));
+  EXPECT_FALSE(reader.truncated());
+}
+
+TEST(ETWRawRecordTest, CutPadding) {
+  const char kPayload[] = "0123456789";
+  std::ostringstream out;
+  ETWRawRecordWriter writer(&out);
+  writer.Write(MakeHeader(100, 10), kPayload);
+  writer.Write(MakeHeader(200, 10), kPayload);
+  std::string data = out.str();
+
+  // The padding of the last record may be missing at the end of the file.
+  std::string first = data.substr(0, data.size() - 3);
+  ETWRawRecordReader reader(first.data(), first.size());
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  ASSERT_TRUE(reader.Next(&header, &payload));
+  EXPECT_EQ(200U, header.timestamp);
+  EXPECT_FALSE(reader.Next(&header, &payload));
+  EXPECT_FALSE(reader.truncated());
+
+  // Before the end of the file, the record is truncated: the rest of its
+  // padding follows.
+  ETWRawRecordReader window_reader(first.data(), first.size());
+  window_reader.set_at_end(false);
+  ASSERT_TRUE(window_reader.Next(&header, &payload));
+  EXPECT_FALSE(window_reader.Next(&header, &payload));
+  EXPECT_TRUE(window_reader.truncated());
+
+  std::string rest = data.substr(window_reader.offset());
+  window_reader.Continue(rest.data(), rest.size(), true);
+  ASSERT_TRUE(window_reader.Next(&header, &payload));
+  EXPECT_EQ(200U, header.timestamp);
+  EXPECT_EQ("0123456789", std::string(payload, header.payload_size));
+  EXPECT_FALSE(window_reader.Next(&header, &payload));
+  EXPECT_FALSE(window_reader.truncated());
+}
+
+TEST(ETWRawRecordTest, InvalidFileHeader) {
+  std::string data(sizeof(ETWRawRecordFileHeader), 'x');
+  ETWRawRecordReader reader(data.data(), data.size());
+  EXPECT_FALSE(reader.IsValid());
+
+  ETWRawRecordHeader header;
+  const char* payload = NULL;
+  EXPECT_FALSE(reader.Next(&header, &payload));
+
+  ETWRawRecordReader empty_reader(data.data(), 4);
+  EXPECT_FALSE(empty_reader.IsValid());
+}
+
+}  // namespace etw
+}  // namespace parser
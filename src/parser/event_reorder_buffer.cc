@@ -0,0 +1,146 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/event_reorder_buffer.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "event/utils.h"
+#include "event/value.h"
+
+namespace parser {
+
+namespace {
+
+const event::Timestamp kDefaultMaxLateness = 1000000;
+const size_t kDefaultMaxBufferedEvents = 1 << 20;
+
+}  // namespace
+
+EventReorderBuffer::Options::Options()
+    : max_lateness(kDefaultMaxLateness),
+      max_buffered_events(kDefaultMaxBufferedEvents) {
+}
+
+EventReorderBuffer::EventReorderBuffer(
+    const Options& options,
+    const base::Observer<event::Event>* observer)
+    : options_(options),
+      observer_(observer),
+      late_observer_(NULL),
+      newest_(0),
+      has_newest_(false),
+      last_released_(0),
+      has_released_(false),
+      next_sequence_(0),
+      peak_buffered_events_(0),
+      received_events_(0),
+      released_events_(0),
+      late_events_(0),
+      forced_releases_(0) {
+  DCHECK(observer != NULL);
+  DCHECK_LT(0U, options.max_buffered_events);
+}
+
+EventReorderBuffer::~EventReorderBuffer() {
+  for (size_t i = 0; i < heap_.size(); ++i)
+    delete heap_[i].event;
+}
+
+void EventReorderBuffer::Receive(const event::Event& event) {
+  event::Timestamp timestamp = event.timestamp();
+  ++received_events_;
+
+  // A later event was already released: this one cannot be placed in order.
+  if (has_released_ && timestamp < last_released_) {
+    ++late_events_;
+    if (late_observer_ != NULL)
+      late_observer_->Receive(event);
+    return;
+  }
+
+  if (!has_newest_ || timestamp > newest_) {
+    newest_ = timestamp;
+    has_newest_ = true;
+  }
+
+  if (IsReleasable(timestamp)) {
+    // No event on time can precede this one: release the buffered events
+    // preceding it and forward it without copying it.
+    ReleaseUpTo(timestamp);
+    Release(event);
+  } else if (heap_.size() >= options_.max_buffered_events &&
+             timestamp < heap_.front().timestamp) {
+    // The buffer is full and the event is the earliest one: release it early.
+    ++forced_releases_;
+    Release(event);
+  } else {
+    if (heap_.size() >= options_.max_buffered_events) {
+      ++forced_releases_;
+      ReleaseTop();
+    }
+
+    Entry entry;
+    entry.timestamp = timestamp;
+    entry.sequence = next_sequence_++;
+    entry.event = event::CopyEvent(event).release();
+    heap_.push_back(entry);
+    std::push_heap(heap_.begin(), heap_.end(), EntryAfter());
+    peak_buffered_events_ = std::max(peak_buffered_events_, heap_.size());
+  }
+
+  if (newest_ >= options_.max_lateness)
+    ReleaseUpTo(newest_ - options_.max_lateness);
+}
+
+void EventReorderBuffer::Flush() {
+  while (!heap_.empty())
+    ReleaseTop();
+}
+
+void EventReorderBuffer::ReleaseTop() {
+  DCHECK(!heap_.empty());
+
+  std::pop_heap(heap_.begin(), heap_.end(), EntryAfter());
+  scoped_ptr<const event::Event> event(heap_.back().event);
+  heap_.pop_back();
+  Release(*event.get());
+}
+
+void EventReorderBuffer::ReleaseUpTo(event::Timestamp timestamp) {
+  while (!heap_.empty() && heap_.front().timestamp <= timestamp)
+    ReleaseTop();
+}
+
+void EventReorderBuffer::Release(const event::Event& event) {
+  DCHECK(!has_released_ || event.timestamp() >= last_released_);
+
+  last_released_ = event.timestamp();
+  has_released_ = true;
+  ++released_events_;
+  observer_->Receive(event);
+}
+
+}  // namespace parser
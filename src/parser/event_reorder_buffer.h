@@ -0,0 +1,177 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Reorders a nearly-sorted stream of events by timestamp. Trace formats
+// written per processor or per buffer produce events slightly out of order;
+// the buffer holds them until no earlier event is expected and releases them
+// sorted to the next observer:
+//
+//   parser::EventReorderBuffer::Options options;
+//   options.max_lateness = 1000000;  // In timestamp units.
+//   parser::EventReorderBuffer reorder(options, &observer);
+//   parser.Parse(base::MakeObserver(&reorder,
+//                                   &parser::EventReorderBuffer::Receive));
+//   reorder.Flush();
+//
+// An event is released once an event newer by at least |max_lateness| has
+// been received. The events are copied into the buffer, which holds at most
+// |max_buffered_events| of them: beyond that, the earliest one is released
+// early. Even an event received in order is copied, since a later event may
+// still precede it; only an event that is already past the lateness window
+// when it arrives, e.g. with a zero |max_lateness|, is forwarded without
+// being copied.
+//
+// An event that arrives after a later event was released cannot be
+// delivered in order; it is counted as late and sent to the late observer,
+// if any, instead of being silently misplaced.
+
+#ifndef PARSER_EVENT_REORDER_BUFFER_H_
+#define PARSER_EVENT_REORDER_BUFFER_H_
+
+#include <vector>
+
+#include "base/base.h"
+#include "base/observer.h"
+#include "event/event.h"
+
+namespace parser {
+
+class EventReorderBuffer {
+ public:
+  struct Options {
+    Options();
+
+    // How far behind the newest received event an event may arrive, in
+    // timestamp units. Larger values tolerate more disorder and buffer more.
+    event::Timestamp max_lateness;
+
+    // The maximum number of events held by the buffer.
+    size_t max_buffered_events;
+  };
+
+  // @param options the lateness and memory bounds of the buffer.
+  // @param observer the observer receiving the sorted events. Must outlive
+  //     the buffer.
+  EventReorderBuffer(const Options& options,
+                     const base::Observer<event::Event>* observer);
+
+  // Deletes the events not flushed yet, without releasing them.
+  ~EventReorderBuffer();
+
+  // Buffers an event and releases the events that are now in order.
+  // @param event the received event.
+  void Receive(const event::Event& event);
+
+  // Releases all the buffered events, e.g. at the end of the stream.
+  void Flush();
+
+  // Sets the observer receiving the late events. They are dropped otherwise.
+  // @param observer the observer. Must outlive the buffer.
+  void set_late_observer(const base::Observer<event::Event>* observer) {
+    late_observer_ = observer;
+  }
+
+  // Accessors.
+  // @{
+  // @returns the number of events currently held.
+  size_t buffered_events() const { return heap_.size(); }
+  // @returns the largest number of events held at once.
+  size_t peak_buffered_events() const { return peak_buffered_events_; }
+  // @returns the number of events received.
+  uint64 received_events() const { return received_events_; }
+  // @returns the number of events released in order.
+  uint64 released_events() const { return released_events_; }
+  // @returns the number of events that arrived after a later event was
+  //     released.
+  uint64 late_events() const { return late_events_; }
+  // @returns the number of events released early to respect the memory bound.
+  uint64 forced_releases() const { return forced_releases_; }
+  // @}
+
+ private:
+  // A buffered event. Events with equal timestamps keep their arrival order.
+  struct Entry {
+    event::Timestamp timestamp;
+    uint64 sequence;
+    const event::Event* event;
+  };
+
+  // Orders the heap with the earliest entry on top.
+  struct EntryAfter {
+    bool operator()(const Entry& left, const Entry& right) const {
+      if (left.timestamp != right.timestamp)
+        return left.timestamp > right.timestamp;
+      return left.sequence > right.sequence;
+    }
+  };
+
+  // Releases the earliest buffered event.
+  void ReleaseTop();
+
+  // Releases the buffered events with a timestamp up to |timestamp|.
+  // @param timestamp the last timestamp to release.
+  void ReleaseUpTo(event::Timestamp timestamp);
+
+  // Sends an event to the observer.
+  // @param event the event to release.
+  void Release(const event::Event& event);
+
+  // @returns true if an event at |timestamp| can no longer be preceded by an
+  //     event on time.
+  bool IsReleasable(event::Timestamp timestamp) const {
+    return has_newest_ && newest_ >= options_.max_lateness &&
+        timestamp <= newest_ - options_.max_lateness;
+  }
+
+  Options options_;
+  const base::Observer<event::Event>* observer_;
+  const base::Observer<event::Event>* late_observer_;
+
+  // The buffered events, as a binary heap.
+  std::vector<Entry> heap_;
+
+  // The latest timestamp received.
+  event::Timestamp newest_;
+  bool has_newest_;
+
+  // The timestamp of the last released event.
+  event::Timestamp last_released_;
+  bool has_released_;
+
+  uint64 next_sequence_;
+
+  // Counters.
+  size_t peak_buffered_events_;
+  uint64 received_events_;
+  uint64 released_events_;
+  uint64 late_events_;
+  uint64 forced_releases_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventReorderBuffer);
+};
+
+}  // namespace parser
+
+#endif  // PARSER_EVENT_REORDER_BUFFER_H_
@@ -0,0 +1,223 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/event_reorder_buffer.h"
+
+#include <vector>
+
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+
+namespace {
+
+using event::Event;
+using event::IntValue;
+using event::Timestamp;
+using event::Value;
+
+// Records the timestamps and the payloads of the received events.
+class EventRecorder {
+ public:
+  void Receive(const Event& event) {
+    timestamps.push_back(event.timestamp());
+    payloads.push_back(event.payload() == NULL ? -1 :
+        IntValue::GetValue(event.payload()));
+  }
+
+  std::vector<Timestamp> timestamps;
+  std::vector<int32> payloads;
+};
+
+void Send(Timestamp timestamp, int32 payload, EventReorderBuffer* buffer) {
+  scoped_ptr<const Value> value(new IntValue(payload));
+  Event event(timestamp, value.Pass());
+  buffer->Receive(event);
+}
+
+EventReorderBuffer::Options MakeOptions(Timestamp max_lateness,
+                                        size_t max_buffered_events) {
+  EventReorderBuffer::Options options;
+  options.max_lateness = max_lateness;
+  options.max_buffered_events = max_buffered_events;
+  return options;
+}
+
+}  // namespace
+
+TEST(EventReorderBufferTest, SortedStream) {
+  EventRecorder recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  EventReorderBuffer buffer(MakeOptions(10, 100), &observer);
+
+  for (int32 i = 0; i < 50; ++i)
+    Send(i * 5, i, &buffer);
+
+  // Only the events within the lateness of the newest one are held.
+  EXPECT_EQ(2U, buffer.buffered_events());
+  EXPECT_EQ(48U, recorder.timestamps.size());
+
+  buffer.Flush();
+  EXPECT_EQ(0U, buffer.buffered_events());
+  ASSERT_EQ(50U, recorder.timestamps.size());
+  for (int32 i = 0; i < 50; ++i) {
+    EXPECT_EQ(static_cast<Timestamp>(i * 5), recorder.timestamps[i]);
+    EXPECT_EQ(i, recorder.payloads[i]);
+  }
+  EXPECT_EQ(50U, buffer.received_events());
+  EXPECT_EQ(50U, buffer.released_events());
+  EXPECT_EQ(0U, buffer.late_events());
+  EXPECT_EQ(0U, buffer.forced_releases());
+}
+
+TEST(EventReorderBufferTest, ReordersWithinLateness) {
+  EventRecorder recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  EventReorderBuffer buffer(MakeOptions(10, 100), &observer);
+
+  const Timestamp kTimestamps[] = { 5, 2, 9, 1, 12, 8, 20, 15, 30, 25 };
+  const size_t kCount = sizeof(kTimestamps) / sizeof(kTimestamps[0]);
+  for (size_t i = 0; i < kCount; ++i)
+    Send(kTimestamps[i], static_cast<int32>(i), &buffer);
+  buffer.Flush();
+
+  const Timestamp kExpected[] = { 1, 2, 5, 8, 9, 12, 15, 20, 25, 30 };
+  ASSERT_EQ(kCount, recorder.timestamps.size());
+  for (size_t i = 0; i < kCount; ++i)
+    EXPECT_EQ(kExpected[i], recorder.timestamps[i]);
+  EXPECT_EQ(0U, buffer.late_events());
+}
+
+TEST(EventReorderBufferTest, EqualTimestampsKeepArrivalOrder) {
+  EventRecorder recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  EventReorderBuffer buffer(MakeOptions(100, 100), &observer);
+
+  for (int32 i = 0; i < 20; ++i)
+    Send(i % 2 == 0 ? 7 : 3, i, &buffer);
+  buffer.Flush();
+
+  ASSERT_EQ(20U, recorder.payloads.size());
+  for (int32 i = 0; i < 10; ++i) {
+    EXPECT_EQ(2 * i + 1, recorder.payloads[i]);
+    EXPECT_EQ(2 * i, recorder.payloads[10 + i]);
+  }
+}
+
+TEST(EventReorderBufferTest, LateEvents) {
+  EventRecorder recorder;
+  EventRecorder late_recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  base::CallbackObserver<EventRecorder, Event> late_observer =
+      base::MakeObserver(&late_recorder, &EventRecorder::Receive);
+  EventReorderBuffer buffer(MakeOptions(10, 100), &observer);
+  buffer.set_late_observer(&late_observer);
+
+  Send(100, 0, &buffer);
+  Send(120, 1, &buffer);
+  // 100 is released: an earlier event can no longer be placed in order.
+  ASSERT_EQ(1U, recorder.timestamps.size());
+  Send(99, 2, &buffer);
+  // Later than the last released event, but beyond the lateness: it is still
+  // delivered in order.
+  Send(100, 3, &buffer);
+  Send(105, 4, &buffer);
+  buffer.Flush();
+
+  ASSERT_EQ(4U, recorder.timestamps.size());
+  EXPECT_EQ(100U, recorder.timestamps[0]);
+  EXPECT_EQ(100U, recorder.timestamps[1]);
+  EXPECT_EQ(105U, recorder.timestamps[2]);
+  EXPECT_EQ(120U, recorder.timestamps[3]);
+
+  EXPECT_EQ(1U, buffer.late_events());
+  ASSERT_EQ(1U, late_recorder.timestamps.size());
+  EXPECT_EQ(99U, late_recorder.timestamps[0]);
+  EXPECT_EQ(2, late_recorder.payloads[0]);
+}
+
+TEST(EventReorderBufferTest, LateEventsDroppedWithoutObserver) {
+  EventRecorder recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  EventReorderBuffer buffer(MakeOptions(0, 100), &observer);
+
+  Send(10, 0, &buffer);
+  Send(5, 1, &buffer);
+  Send(10, 2, &buffer);
+  buffer.Flush();
+
+  ASSERT_EQ(2U, recorder.timestamps.size());
+  EXPECT_EQ(0, recorder.payloads[0]);
+  EXPECT_EQ(2, recorder.payloads[1]);
+  EXPECT_EQ(1U, buffer.late_events());
+  EXPECT_EQ(0U, buffer.peak_buffered_events());
+}
+
+TEST(EventReorderBufferTest, MemoryBound) {
+  EventRecorder recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  EventReorderBuffer buffer(MakeOptions(1000, 4), &observer);
+
+  for (int32 i = 0; i < 10; ++i)
+    Send(i * 2, i, &buffer);
+
+  // The earliest events are released before reaching their lateness.
+  EXPECT_EQ(4U, buffer.buffered_events());
+  EXPECT_EQ(4U, buffer.peak_buffered_events());
+  EXPECT_EQ(6U, buffer.forced_releases());
+  EXPECT_EQ(0U, buffer.late_events());
+
+  // 10 was released early: 9 is late, 11 can still be placed in order.
+  Send(9, 10, &buffer);
+  Send(11, 11, &buffer);
+  EXPECT_EQ(1U, buffer.late_events());
+  buffer.Flush();
+
+  ASSERT_EQ(11U, recorder.timestamps.size());
+  for (size_t i = 1; i < recorder.timestamps.size(); ++i)
+    EXPECT_LE(recorder.timestamps[i - 1], recorder.timestamps[i]);
+  EXPECT_EQ(11U, recorder.timestamps[6]);
+}
+
+TEST(EventReorderBufferTest, DestructorDeletesBufferedEvents) {
+  EventRecorder recorder;
+  base::CallbackObserver<EventRecorder, Event> observer =
+      base::MakeObserver(&recorder, &EventRecorder::Receive);
+  {
+    EventReorderBuffer buffer(MakeOptions(1000, 100), &observer);
+    Send(1, 0, &buffer);
+    Send(2, 1, &buffer);
+    EXPECT_EQ(2U, buffer.buffered_events());
+  }
+  EXPECT_TRUE(recorder.timestamps.empty());
+}
+
+}  // namespace parser
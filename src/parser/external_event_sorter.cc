@@ -0,0 +1,743 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/external_event_sorter.h"
+
+#if defined(_WIN32)
+// Restrict the import to the windows basic includes.
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>  // NOLINT
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include "base/logging.h"
+#include "base/scoped_ptr.h"
+#include "base/thread.h"
+#include "event/serialization.h"
+#include "event/value.h"
+
+namespace parser {
+
+namespace {
+
+const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+const size_t kDefaultMergeBufferSize = 256 * 1024;
+const size_t kMinChunkCapacity = 64 * 1024;
+
+// The size of the writes of a run.
+const size_t kWriteBufferSize = 1024 * 1024;
+
+// The digits of the radix sort. The counters of a digit fit in the L1 cache.
+const size_t kRadixDigitBits = 11;
+const size_t kRadixDigitValues = 1 << kRadixDigitBits;
+const event::Timestamp kRadixDigitMask = kRadixDigitValues - 1;
+
+// The largest size of a record header: two variable-length integers.
+const size_t kMaxRecordHeaderSize = 20;
+
+// @returns the directory of the temporary files of the system.
+std::string GetTempDirectory() {
+#if defined(_WIN32)
+  char path[MAX_PATH + 1];
+  DWORD length = ::GetTempPathA(sizeof(path), path);
+  if (length != 0 && length < sizeof(path))
+    return std::string(path, length);
+  return ".";
+#else
+  const char* path = std::getenv("TMPDIR");
+  if (path != NULL && path[0] != '\0')
+    return path;
+  return "/tmp";
+#endif
+}
+
+// Writes the records of a sorted run. Each record holds the delta from the
+// previous timestamp and the size of the payload, both as variable-length
+// integers, followed by the serialized payload.
+class RunWriter {
+ public:
+  RunWriter() : file_(NULL), previous_(0), bytes_(0), success_(true) {
+    buffer_.reserve(kWriteBufferSize + kMaxRecordHeaderSize);
+  }
+
+  ~RunWriter() {
+    if (file_ != NULL)
+      std::fclose(file_);
+  }
+
+  // @param path the path of the run.
+  // @returns true on success, false otherwise.
+  bool Open(const std::string& path) {
+    DCHECK(file_ == NULL);
+    file_ = std::fopen(path.c_str(), "wb");
+    return file_ != NULL;
+  }
+
+  // Appends a record. The records must be appended in order.
+  // @param timestamp the timestamp of the record.
+  // @param payload the serialized payload.
+  // @param size the size of the payload, in bytes.
+  void Append(event::Timestamp timestamp, const char* payload, size_t size) {
+    DCHECK_LE(previous_, timestamp);
+    event::AppendVarint(timestamp - previous_, &buffer_);
+    event::AppendVarint(size, &buffer_);
+    buffer_.append(payload, size);
+    previous_ = timestamp;
+    if (buffer_.size() >= kWriteBufferSize)
+      Flush();
+  }
+
+  // Writes the buffered records and closes the run.
+  // @returns true on success, false if the run cannot be written.
+  bool Close() {
+    if (file_ == NULL)
+      return false;
+    Flush();
+    if (std::fclose(file_) != 0)
+      success_ = false;
+    file_ = NULL;
+    return success_;
+  }
+
+  // @returns the number of bytes written.
+  uint64 bytes() const { return bytes_; }
+
+ private:
+  void Flush() {
+    if (success_ &&
+        std::fwrite(buffer_.data(), 1, buffer_.size(), file_) !=
+            buffer_.size()) {
+      success_ = false;
+    }
+    bytes_ += buffer_.size();
+    buffer_.clear();
+  }
+
+  FILE* file_;
+  std::string buffer_;
+  event::Timestamp previous_;
+  uint64 bytes_;
+  bool success_;
+
+  DISALLOW_COPY_AND_ASSIGN(RunWriter);
+};
+
+// Writes the records of a sorted chunk to a run.
+// @param data the serialized payloads of the chunk.
+// @param records the sorted records of the chunk.
+// @param path the path of the run.
+// @param bytes receives the number of bytes written.
+// @returns true on success, false otherwise.
+bool WriteRun(const std::string& data,
+              const std::vector<SortRecord>& records,
+              const std::string& path,
+              uint64* bytes) {
+  DCHECK(bytes != NULL);
+
+  RunWriter writer;
+  if (!writer.Open(path))
+    return false;
+  for (size_t i = 0; i < records.size(); ++i) {
+    const SortRecord& record = records[i];
+    writer.Append(record.timestamp, data.data() + record.offset,
+                  record.size);
+  }
+  bool success = writer.Close();
+  *bytes += writer.bytes();
+  return success;
+}
+
+// Reads the records of a sorted run, in order.
+class RunCursor {
+ public:
+  RunCursor() : timestamp_(0), payload_(NULL), payload_size_(0) {
+  }
+  virtual ~RunCursor() { }
+
+  // Moves to the next record.
+  // @returns true on success, false at the end of the run or on error.
+  virtual bool Next() = 0;
+
+  // @returns true if the run cannot be read.
+  virtual bool error() const { return false; }
+
+  event::Timestamp timestamp() const { return timestamp_; }
+  // @returns the serialized payload. Valid until the next call to Next.
+  const char* payload() const { return payload_; }
+  size_t payload_size() const { return payload_size_; }
+
+ protected:
+  event::Timestamp timestamp_;
+  const char* payload_;
+  size_t payload_size_;
+};
+
+// Reads a sorted chunk kept in memory.
+class MemoryRunCursor : public RunCursor {
+ public:
+  MemoryRunCursor(const std::string& data,
+                  const std::vector<SortRecord>& records)
+      : data_(data), records_(records), index_(0) {
+  }
+
+  virtual bool Next() OVERRIDE {
+    if (index_ == records_.size())
+      return false;
+    const SortRecord& record = records_[index_++];
+    timestamp_ = record.timestamp;
+    payload_ = data_.data() + record.offset;
+    payload_size_ = record.size;
+    return true;
+  }
+
+ private:
+  const std::string& data_;
+  const std::vector<SortRecord>& records_;
+  size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryRunCursor);
+};
+
+// Reads a run spilled to disk through a buffer.
+class FileRunCursor : public RunCursor {
+ public:
+  explicit FileRunCursor(size_t buffer_size)
+      : file_(NULL), buffer_(buffer_size), begin_(0), end_(0), eof_(false),
+        error_(false) {
+  }
+
+  virtual ~FileRunCursor() {
+    if (file_ != NULL)
+      std::fclose(file_);
+  }
+
+  // @param path the path of the run.
+  // @returns true on success, false otherwise.
+  bool Open(const std::string& path) {
+    DCHECK(file_ == NULL);
+    file_ = std::fopen(path.c_str(), "rb");
+    return file_ != NULL;
+  }
+
+  virtual bool Next() OVERRIDE {
+    if (!Fill(kMaxRecordHeaderSize) && begin_ == end_)
+      return false;
+
+    const char* data = &buffer_[begin_];
+    const char* end = &buffer_[0] + end_;
+    uint64 delta = 0;
+    uint64 size = 0;
+    if (!event::ReadVarint(&data, end, &delta) ||
+        !event::ReadVarint(&data, end, &size) ||
+        size > std::numeric_limits<uint32>::max()) {
+      error_ = true;
+      return false;
+    }
+    begin_ = data - &buffer_[0];
+
+    if (!Fill(static_cast<size_t>(size))) {
+      error_ = true;
+      return false;
+    }
+    timestamp_ += delta;
+    payload_ = &buffer_[begin_];
+    payload_size_ = static_cast<size_t>(size);
+    begin_ += payload_size_;
+    return true;
+  }
+
+  virtual bool error() const OVERRIDE { return error_; }
+
+ private:
+  // Makes at least |size| bytes available, unless the run ends before.
+  // @param size the number of bytes needed.
+  // @returns true if the bytes are available.
+  bool Fill(size_t size) {
+    if (end_ - begin_ >= size)
+      return true;
+
+    memmove(&buffer_[0], &buffer_[begin_], end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+    if (buffer_.size() < size)
+      buffer_.resize(size);
+
+    while (!eof_ && end_ < buffer_.size()) {
+      size_t read = std::fread(&buffer_[end_], 1, buffer_.size() - end_,
+                               file_);
+      end_ += read;
+      if (read == 0) {
+        eof_ = true;
+        error_ = std::ferror(file_) != 0;
+      }
+    }
+    return end_ >= size;
+  }
+
+  FILE* file_;
+  std::vector<char> buffer_;
+  size_t begin_;
+  size_t end_;
+  bool eof_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileRunCursor);
+};
+
+// The next record of a run during the merge. The runs are numbered in arrival
+// order, which breaks the ties between equal timestamps.
+struct MergeEntry {
+  event::Timestamp timestamp;
+  size_t run;
+};
+
+// Orders the heap with the earliest entry on top.
+struct MergeEntryAfter {
+  bool operator()(const MergeEntry& left, const MergeEntry& right) const {
+    if (left.timestamp != right.timestamp)
+      return left.timestamp > right.timestamp;
+    return left.run > right.run;
+  }
+};
+
+// Merges sorted runs, into a longer run or into events.
+// @param cursors the runs, in arrival order of their events.
+// @param writer receives the merged records, unless it is NULL.
+// @param observer receives the merged events when |writer| is NULL.
+// @returns true on success, false if a run cannot be read.
+bool MergeRuns(const std::vector<RunCursor*>& cursors,
+               RunWriter* writer,
+               const base::Observer<event::Event>* observer) {
+  DCHECK(writer != NULL || observer != NULL);
+
+  bool success = true;
+  std::vector<MergeEntry> heap;
+  for (size_t i = 0; i < cursors.size() && success; ++i) {
+    if (cursors[i]->Next()) {
+      MergeEntry entry;
+      entry.timestamp = cursors[i]->timestamp();
+      entry.run = i;
+      heap.push_back(entry);
+    }
+    success = !cursors[i]->error();
+  }
+  std::make_heap(heap.begin(), heap.end(), MergeEntryAfter());
+
+  while (!heap.empty() && success) {
+    std::pop_heap(heap.begin(), heap.end(), MergeEntryAfter());
+    MergeEntry& entry = heap.back();
+    RunCursor* cursor = cursors[entry.run];
+
+    if (writer != NULL) {
+      writer->Append(entry.timestamp, cursor->payload(),
+                     cursor->payload_size());
+    } else {
+      const char* data = cursor->payload();
+      const char* end = data + cursor->payload_size();
+      scoped_ptr<event::Value> payload;
+      if (!event::DeserializeValue(&data, end, &payload) || data != end) {
+        success = false;
+        break;
+      }
+      event::Event event(entry.timestamp,
+                         payload.PassAs<const event::Value>());
+      observer->Receive(event);
+    }
+
+    if (cursor->Next()) {
+      entry.timestamp = cursor->timestamp();
+      std::push_heap(heap.begin(), heap.end(), MergeEntryAfter());
+    } else {
+      heap.pop_back();
+      success = !cursor->error();
+    }
+  }
+  return success;
+}
+
+// Opens spilled runs.
+// @param paths the paths of the runs.
+// @param buffer_size the size of the read buffer of each run.
+// @param cursors receives the cursors, owned by the caller, even on failure.
+// @returns true on success, false if a run cannot be opened.
+bool OpenRuns(const std::vector<std::string>& paths,
+              size_t buffer_size,
+              std::vector<RunCursor*>* cursors) {
+  DCHECK(cursors != NULL);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    FileRunCursor* cursor = new FileRunCursor(buffer_size);
+    cursors->push_back(cursor);
+    if (!cursor->Open(paths[i]))
+      return false;
+  }
+  return true;
+}
+
+void DeleteCursors(std::vector<RunCursor*>* cursors) {
+  for (size_t i = 0; i < cursors->size(); ++i)
+    delete (*cursors)[i];
+  cursors->clear();
+}
+
+}  // namespace
+
+// Sorts a chunk and optionally spills it to a run.
+class ExternalEventSorter::SortWorker : public base::Thread::Delegate {
+ public:
+  // @param chunk the chunk to sort.
+  // @param path the path of the run, empty to keep the chunk in memory.
+  SortWorker(Chunk* chunk, const std::string& path)
+      : chunk_(chunk), path_(path), bytes_(0), success_(false) {
+  }
+
+  virtual void Run() OVERRIDE {
+    std::vector<SortRecord> scratch;
+    RadixSortByTimestamp(&chunk_->records, &scratch);
+
+    success_ = true;
+    if (path_.empty())
+      return;
+
+    success_ = WriteRun(chunk_->data, chunk_->records, path_, &bytes_);
+    chunk_->data.clear();
+    chunk_->records.clear();
+  }
+
+  uint64 bytes() const { return bytes_; }
+  bool success() const { return success_; }
+
+ private:
+  Chunk* chunk_;
+  std::string path_;
+  uint64 bytes_;
+  bool success_;
+
+  DISALLOW_COPY_AND_ASSIGN(SortWorker);
+};
+
+void RadixSortByTimestamp(std::vector<SortRecord>* records,
+                          std::vector<SortRecord>* scratch) {
+  DCHECK(records != NULL);
+  DCHECK(scratch != NULL);
+
+  size_t count = records->size();
+  if (count < 2)
+    return;
+
+  // Traces are often already sorted: avoid the passes altogether.
+  bool sorted = true;
+  event::Timestamp min = (*records)[0].timestamp;
+  event::Timestamp max = min;
+  for (size_t i = 1; i < count; ++i) {
+    event::Timestamp timestamp = (*records)[i].timestamp;
+    sorted = sorted && (*records)[i - 1].timestamp <= timestamp;
+    min = std::min(min, timestamp);
+    max = std::max(max, timestamp);
+  }
+  if (sorted)
+    return;
+
+  // Sort the offsets from the minimum: only the digits spanned by the range
+  // of the timestamps need a pass.
+  size_t passes = 0;
+  for (event::Timestamp range = max - min; range != 0;
+       range >>= kRadixDigitBits) {
+    ++passes;
+  }
+
+  // Count the values of all the digits in a single read.
+  std::vector<size_t> histograms(passes * kRadixDigitValues);
+  for (size_t i = 0; i < count; ++i) {
+    event::Timestamp key = (*records)[i].timestamp - min;
+    for (size_t pass = 0; pass < passes; ++pass) {
+      ++histograms[pass * kRadixDigitValues + (key & kRadixDigitMask)];
+      key >>= kRadixDigitBits;
+    }
+  }
+
+  scratch->resize(count);
+  SortRecord* source = &(*records)[0];
+  SortRecord* destination = &(*scratch)[0];
+  for (size_t pass = 0; pass < passes; ++pass) {
+    size_t shift = kRadixDigitBits * pass;
+    size_t* histogram = &histograms[pass * kRadixDigitValues];
+
+    // All the records share this digit: the pass would not move them.
+    if (histogram[((source[0].timestamp - min) >> shift) & kRadixDigitMask] ==
+        count) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (size_t value = 0; value < kRadixDigitValues; ++value) {
+      size_t values = histogram[value];
+      histogram[value] = offset;
+      offset += values;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      const SortRecord& record = source[i];
+      size_t digit = ((record.timestamp - min) >> shift) & kRadixDigitMask;
+      destination[histogram[digit]++] = record;
+    }
+    std::swap(source, destination);
+  }
+
+  if (source != &(*records)[0])
+    records->swap(*scratch);
+}
+
+ExternalEventSorter::Options::Options()
+    : memory_budget(kDefaultMemoryBudget),
+      thread_count(base::Thread::NumberOfProcessors()),
+      merge_buffer_size(kDefaultMergeBufferSize) {
+  if (thread_count == 0)
+    thread_count = 1;
+}
+
+ExternalEventSorter::ExternalEventSorter(const Options& options)
+    : options_(options),
+      current_chunk_(0),
+      next_run_(0),
+      run_count_(0),
+      merge_pass_count_(0),
+      received_events_(0),
+      spilled_bytes_(0),
+      failed_(false),
+      finished_(false) {
+  if (options_.run_directory.empty())
+    options_.run_directory = GetTempDirectory();
+  options_.thread_count = std::max(static_cast<size_t>(1),
+                                   options_.thread_count);
+  options_.merge_buffer_size = std::max(kMaxRecordHeaderSize,
+                                        options_.merge_buffer_size);
+  chunk_capacity_ = std::max(
+      kMinChunkCapacity, options_.memory_budget / (2 * options_.thread_count));
+  chunk_capacity_ = std::min(
+      chunk_capacity_,
+      static_cast<size_t>(std::numeric_limits<uint32>::max() / 2));
+  chunks_.resize(2 * options_.thread_count);
+}
+
+ExternalEventSorter::~ExternalEventSorter() {
+  WaitForSort();
+  RemoveRuns();
+}
+
+void ExternalEventSorter::Receive(const event::Event& event) {
+  DCHECK(!finished_);
+
+  ++received_events_;
+  if (failed_)
+    return;
+
+  Chunk* chunk = &chunks_[current_chunk_];
+  SortRecord record;
+  record.timestamp = event.timestamp();
+  record.offset = static_cast<uint32>(chunk->data.size());
+  event::SerializeValue(event.payload(), &chunk->data);
+  record.size = static_cast<uint32>(chunk->data.size() - record.offset);
+  chunk->records.push_back(record);
+
+  if (ChunkUsage(*chunk) < chunk_capacity_)
+    return;
+
+  // Move to the next chunk. When the chunks of a half are full, they are
+  // spilled in the background, once the spill of the other half is done.
+  size_t half_size = options_.thread_count;
+  ++current_chunk_;
+  if (current_chunk_ % half_size != 0)
+    return;
+  size_t full_half = current_chunk_ - half_size;
+  if (current_chunk_ == chunks_.size())
+    current_chunk_ = 0;
+  if (!WaitForSort()) {
+    failed_ = true;
+    return;
+  }
+  StartSort(full_half, full_half + half_size, true);
+}
+
+bool ExternalEventSorter::Finish(const base::Observer<event::Event>& observer) {
+  DCHECK(!finished_);
+  finished_ = true;
+
+  // Keep the last chunks in memory if nothing was spilled.
+  bool success = WaitForSort() && !failed_;
+  if (success) {
+    StartSort(0, chunks_.size(), !run_paths_.empty());
+    success = WaitForSort() && Merge(observer);
+  }
+
+  RemoveRuns();
+  std::vector<Chunk>().swap(chunks_);
+  return success;
+}
+
+size_t ExternalEventSorter::ChunkUsage(const Chunk& chunk) {
+  return chunk.data.size() + 2 * sizeof(SortRecord) * chunk.records.size();
+}
+
+void ExternalEventSorter::StartSort(size_t first, size_t last, bool spill) {
+  DCHECK(sort_workers_.empty());
+
+  for (size_t i = first; i < last; ++i) {
+    Chunk* chunk = &chunks_[i];
+    if (chunk->records.empty())
+      continue;
+
+    // The run paths are recorded first, so that a partial run is removed.
+    std::string path;
+    if (spill) {
+      path = NewRunPath();
+      run_paths_.push_back(path);
+      ++run_count_;
+    }
+
+    SortWorker* worker = new SortWorker(chunk, path);
+    sort_workers_.push_back(worker);
+    base::Thread* thread = new base::Thread(worker);
+    if (thread->Start()) {
+      sort_threads_.push_back(thread);
+    } else {
+      delete thread;
+      worker->Run();
+    }
+  }
+}
+
+bool ExternalEventSorter::WaitForSort() {
+  for (size_t i = 0; i < sort_threads_.size(); ++i) {
+    sort_threads_[i]->Join();
+    delete sort_threads_[i];
+  }
+  sort_threads_.clear();
+
+  bool success = true;
+  for (size_t i = 0; i < sort_workers_.size(); ++i) {
+    success = success && sort_workers_[i]->success();
+    spilled_bytes_ += sort_workers_[i]->bytes();
+    delete sort_workers_[i];
+  }
+  sort_workers_.clear();
+  return success;
+}
+
+bool ExternalEventSorter::Merge(const base::Observer<event::Event>& observer) {
+  std::vector<RunCursor*> cursors;
+  bool success = true;
+  if (run_paths_.empty()) {
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      cursors.push_back(new MemoryRunCursor(chunks_[i].data,
+                                            chunks_[i].records));
+    }
+  } else {
+    // The chunks are spilled: free them for the read buffers of the runs.
+    std::vector<Chunk>().swap(chunks_);
+
+    // Each run being merged holds a read buffer: merge the runs by groups
+    // until they can all be read at once within the memory budget.
+    size_t max_fan_in = std::max(
+        static_cast<size_t>(2),
+        options_.memory_budget / options_.merge_buffer_size);
+    while (run_paths_.size() > max_fan_in && success) {
+      success = MergePass(max_fan_in);
+      ++merge_pass_count_;
+    }
+    success = success &&
+        OpenRuns(run_paths_, options_.merge_buffer_size, &cursors);
+  }
+
+  success = success && MergeRuns(cursors, NULL, &observer);
+  DeleteCursors(&cursors);
+  return success;
+}
+
+bool ExternalEventSorter::MergePass(size_t max_fan_in) {
+  DCHECK_LE(2U, max_fan_in);
+
+  // The groups are consecutive runs, so that the merged runs keep the
+  // arrival order of the events.
+  std::vector<std::string> merged_paths;
+  bool success = true;
+  for (size_t first = 0; first < run_paths_.size() && success;
+       first += max_fan_in) {
+    size_t last = std::min(first + max_fan_in, run_paths_.size());
+    if (last - first == 1) {
+      merged_paths.push_back(run_paths_[first]);
+      continue;
+    }
+
+    std::vector<std::string> paths(run_paths_.begin() + first,
+                                   run_paths_.begin() + last);
+    std::string path = NewRunPath();
+    merged_paths.push_back(path);
+
+    std::vector<RunCursor*> cursors;
+    RunWriter writer;
+    success = OpenRuns(paths, options_.merge_buffer_size, &cursors) &&
+        writer.Open(path) && MergeRuns(cursors, &writer, NULL);
+    success = writer.Close() && success;
+    spilled_bytes_ += writer.bytes();
+    DeleteCursors(&cursors);
+
+    if (success) {
+      for (size_t i = 0; i < paths.size(); ++i)
+        std::remove(paths[i].c_str());
+    }
+  }
+
+  if (!success) {
+    // Keep every path, merged or not, to remove them.
+    run_paths_.insert(run_paths_.end(), merged_paths.begin(),
+                      merged_paths.end());
+    return false;
+  }
+  run_paths_.swap(merged_paths);
+  return true;
+}
+
+std::string ExternalEventSorter::NewRunPath() {
+  const std::string& directory = options_.run_directory;
+  std::stringstream path;
+  path << directory;
+  char last = directory[directory.size() - 1];
+  if (last != '/' && last != '\\')
+    path << "/";
+  path << "libtrace-sort-" << this << "-" << next_run_++ << ".run";
+  return path.str();
+}
+
+void ExternalEventSorter::RemoveRuns() {
+  for (size_t i = 0; i < run_paths_.size(); ++i)
+    std::remove(run_paths_[i].c_str());
+  run_paths_.clear();
+}
+
+}  // namespace parser
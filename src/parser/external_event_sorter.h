@@ -0,0 +1,200 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Sorts a stream of events by timestamp, whatever its disorder and size. The
+// events are serialized into memory chunks. The chunks form two halves: when
+// the chunks of a half are full, they are sorted in parallel and spilled to
+// disk as sorted runs in the background, while the other half receives the
+// events. At the end, the runs are merged and the events are sent in order to
+// an observer. When there are too many runs to read them all at once within
+// the memory budget, they are first merged by groups into longer runs:
+//
+//   parser::ExternalEventSorter::Options options;
+//   options.run_directory = "/var/tmp";
+//   parser::ExternalEventSorter sorter(options);
+//   parser.Parse(base::MakeObserver(&sorter,
+//                                   &parser::ExternalEventSorter::Receive));
+//   sorter.Finish(observer);
+//
+// Events with equal timestamps keep their arrival order. When the events fit
+// into half the memory budget, nothing is written to disk. Prefer
+// EventReorderBuffer for streams that are only slightly out of order.
+
+#ifndef PARSER_EXTERNAL_EVENT_SORTER_H_
+#define PARSER_EXTERNAL_EVENT_SORTER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/observer.h"
+#include "event/event.h"
+
+namespace base {
+class Thread;
+}  // namespace base
+
+namespace parser {
+
+// A serialized event of a memory chunk.
+struct SortRecord {
+  event::Timestamp timestamp;
+  // The position of the serialized payload in the chunk.
+  uint32 offset;
+  uint32 size;
+};
+
+// Sorts records by timestamp with a stable least-significant-digit radix sort.
+// Only the digits spanned by the range of the timestamps are sorted, so
+// timestamps within a narrow range take few passes.
+// @param records the records to sort.
+// @param scratch a buffer used by the sort. Its content is overwritten.
+void RadixSortByTimestamp(std::vector<SortRecord>* records,
+                          std::vector<SortRecord>* scratch);
+
+class ExternalEventSorter {
+ public:
+  struct Options {
+    Options();
+
+    // The directory receiving the sorted runs. The temporary directory of
+    // the system if empty. The runs are removed once merged.
+    std::string run_directory;
+
+    // The memory held by the events, in bytes. Half of it receives the
+    // events while the other half is spilled.
+    size_t memory_budget;
+
+    // The number of threads sorting and spilling the chunks of a half. The
+    // memory budget is shared evenly between the chunks.
+    size_t thread_count;
+
+    // The size of the read buffer of each run during the merge, in bytes.
+    // The runs are merged by groups of at most |memory_budget| /
+    // |merge_buffer_size| runs.
+    size_t merge_buffer_size;
+  };
+
+  // @param options the memory and disk settings of the sort.
+  explicit ExternalEventSorter(const Options& options);
+
+  // Waits for the spill in progress, then removes the runs not merged yet.
+  ~ExternalEventSorter();
+
+  // Adds an event to the sort.
+  // @param event the received event.
+  void Receive(const event::Event& event);
+
+  // Sends all the received events sorted by timestamp. Must be called once,
+  // after the last event has been received.
+  // @param observer the observer receiving the sorted events.
+  // @returns true on success, false if a run cannot be written or read back.
+  bool Finish(const base::Observer<event::Event>& observer);
+
+  // Accessors.
+  // @{
+  // @returns the number of events received.
+  uint64 received_events() const { return received_events_; }
+  // @returns the number of runs spilled to disk.
+  size_t run_count() const { return run_count_; }
+  // @returns the number of merges of the runs by groups, before the last
+  //     merge.
+  size_t merge_pass_count() const { return merge_pass_count_; }
+  // @returns the number of bytes written to disk, merged runs included.
+  uint64 spilled_bytes() const { return spilled_bytes_; }
+  // @returns true if a run could not be written. The failure of the spill
+  //     in progress is only known when the next spill starts.
+  bool failed() const { return failed_; }
+  // @}
+
+ private:
+  // Events held in memory, in arrival order until sorted.
+  struct Chunk {
+    std::string data;
+    std::vector<SortRecord> records;
+  };
+
+  class SortWorker;
+
+  // @returns the memory used by a chunk, including its sort buffer.
+  static size_t ChunkUsage(const Chunk& chunk);
+
+  // Starts sorting the non-empty chunks of a range in the background, one
+  // thread per chunk.
+  // @param first the index of the first chunk.
+  // @param last the index past the last chunk.
+  // @param spill true to write each sorted chunk to a new run and clear it.
+  void StartSort(size_t first, size_t last, bool spill);
+
+  // Waits for the sort in progress, if any.
+  // @returns true on success, false if a run cannot be written.
+  bool WaitForSort();
+
+  // Merges the runs, or the sorted chunks if nothing was spilled.
+  // @param observer the observer receiving the sorted events.
+  // @returns true on success, false otherwise.
+  bool Merge(const base::Observer<event::Event>& observer);
+
+  // Merges the runs by groups into fewer, longer runs.
+  // @param max_fan_in the largest number of runs merged at once.
+  // @returns true on success, false if a run cannot be read or written.
+  bool MergePass(size_t max_fan_in);
+
+  // @returns the path of a new run.
+  std::string NewRunPath();
+
+  // Removes the runs from the disk.
+  void RemoveRuns();
+
+  Options options_;
+
+  // The memory available to each chunk.
+  size_t chunk_capacity_;
+
+  // Two halves of one chunk per thread. The chunks are filled in order.
+  std::vector<Chunk> chunks_;
+  size_t current_chunk_;
+
+  // The sort in progress.
+  std::vector<SortWorker*> sort_workers_;
+  std::vector<base::Thread*> sort_threads_;
+
+  // The paths of the runs, in arrival order of their events.
+  std::vector<std::string> run_paths_;
+  size_t next_run_;
+  size_t run_count_;
+  size_t merge_pass_count_;
+
+  uint64 received_events_;
+  uint64 spilled_bytes_;
+  bool failed_;
+  bool finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExternalEventSorter);
+};
+
+}  // namespace parser
+
+#endif  // PARSER_EXTERNAL_EVENT_SORTER_H_
@@ -0,0 +1,147 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/external_event_sorter.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/perf_test.h"
+#include "base/thread.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+
+namespace {
+
+const size_t kEventCount = 1000000;
+
+// Counts the received events.
+class EventCounter {
+ public:
+  EventCounter() : count(0) { }
+
+  void Receive(const event::Event& event) { ++count; }
+
+  size_t count;
+};
+
+// @returns timestamps of events read from per-processor buffers: each buffer
+// is sorted, the buffers overlap.
+std::vector<event::Timestamp> MakeTimestamps(size_t count) {
+  const size_t kBufferEvents = 4096;
+  std::vector<event::Timestamp> timestamps(count);
+  uint32 seed = 1;
+  for (size_t i = 0; i < count; ++i) {
+    seed = seed * 1103515245 + 12345;
+    size_t buffer = i / kBufferEvents;
+    timestamps[i] = 0x01D0000000000000ULL +
+        (buffer % 8) * 100000 + (buffer / 8) * kBufferEvents * 100 +
+        (i % kBufferEvents) * 100 + (seed >> 28);
+  }
+  return timestamps;
+}
+
+bool RecordBefore(const SortRecord& left, const SortRecord& right) {
+  return left.timestamp < right.timestamp;
+}
+
+// Sorts events resembling decoded kernel events.
+void SortEvents(const char* name, size_t memory_budget, size_t thread_count) {
+  std::vector<event::Timestamp> timestamps = MakeTimestamps(kEventCount);
+
+  ExternalEventSorter::Options options;
+  options.memory_budget = memory_budget;
+  options.thread_count = thread_count;
+  ExternalEventSorter sorter(options);
+
+  base::PerfTimer timer;
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    scoped_ptr<event::StructValue> payload(new event::StructValue());
+    payload->AddField<event::UIntValue>("ProcessId", 4 + (i % 64) * 4);
+    payload->AddField<event::UIntValue>("ThreadId", 1000 + (i % 512));
+    payload->AddField<event::ULongValue>("Address",
+                                         0xFFFFF80000000000ULL + i * 64);
+    payload->AddField<event::StringValue>("Name", "ntoskrnl.exe");
+    event::Event event(timestamps[i],
+                       payload.PassAs<const event::Value>());
+    sorter.Receive(event);
+  }
+  uint64 receive = timer.ElapsedNanoseconds();
+
+  EventCounter counter;
+  timer.Reset();
+  ASSERT_TRUE(sorter.Finish(
+      base::MakeObserver(&counter, &EventCounter::Receive)));
+  uint64 finish = timer.ElapsedNanoseconds();
+  EXPECT_EQ(kEventCount, counter.count);
+
+  base::PrintPerfResult(name, "receive", receive, kEventCount, "ns/event");
+  base::PrintPerfResult(name, "finish", finish, kEventCount, "ns/event");
+  base::PrintPerfResult(name, "runs", sorter.run_count(), 1, "runs");
+}
+
+}  // namespace
+
+TEST(ExternalEventSorterPerfTest, RadixSort) {
+  std::vector<event::Timestamp> timestamps = MakeTimestamps(kEventCount);
+  std::vector<SortRecord> records(timestamps.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    records[i].timestamp = timestamps[i];
+    records[i].offset = static_cast<uint32>(i);
+    records[i].size = 0;
+  }
+  std::vector<SortRecord> input(records);
+  std::vector<SortRecord> scratch;
+
+  base::PerfTimer timer;
+  RadixSortByTimestamp(&records, &scratch);
+  base::PrintPerfResult("RadixSortByTimestamp", "time",
+                        timer.ElapsedNanoseconds(), records.size(),
+                        "ns/record");
+
+  timer.Reset();
+  std::stable_sort(input.begin(), input.end(), RecordBefore);
+  base::PrintPerfResult("StableSort", "time", timer.ElapsedNanoseconds(),
+                        input.size(), "ns/record");
+
+  for (size_t i = 0; i < records.size(); ++i)
+    ASSERT_EQ(input[i].offset, records[i].offset);
+}
+
+TEST(ExternalEventSorterPerfTest, InMemory) {
+  SortEvents("InMemory", 512 << 20, base::Thread::NumberOfProcessors());
+}
+
+TEST(ExternalEventSorterPerfTest, SpilledOneThread) {
+  SortEvents("SpilledOneThread", 8 << 20, 1);
+}
+
+TEST(ExternalEventSorterPerfTest, SpilledAllThreads) {
+  SortEvents("SpilledAllThreads", 8 << 20,
+             base::Thread::NumberOfProcessors());
+}
+
+}  // namespace parser
@@ -0,0 +1,269 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/external_event_sorter.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+
+namespace {
+
+using event::Event;
+using event::StructValue;
+using event::Timestamp;
+using event::UIntValue;
+using event::Value;
+
+// Records the timestamps and the arrival indexes of the received events.
+class EventRecorder {
+ public:
+  void Receive(const Event& event) {
+    timestamps.push_back(event.timestamp());
+    uint32 index = 0;
+    const StructValue* fields = StructValue::Cast(event.payload());
+    EXPECT_TRUE(fields->GetFieldAsUInteger("index", &index));
+    std::string name;
+    EXPECT_TRUE(fields->GetFieldAsString("name", &name));
+    EXPECT_EQ("event", name);
+    indexes.push_back(index);
+  }
+
+  std::vector<Timestamp> timestamps;
+  std::vector<uint32> indexes;
+};
+
+// Counts the events without payload.
+class PayloadRecorder {
+ public:
+  PayloadRecorder() : null_payloads(0) { }
+
+  void Receive(const Event& event) {
+    if (event.payload() == NULL)
+      ++null_payloads;
+  }
+
+  size_t null_payloads;
+};
+
+void Send(Timestamp timestamp, uint32 index, ExternalEventSorter* sorter) {
+  scoped_ptr<StructValue> payload(new StructValue());
+  payload->AddField<UIntValue>("index", index);
+  payload->AddField<event::StringValue>("name", "event");
+  Event event(timestamp, payload.PassAs<const Value>());
+  sorter->Receive(event);
+}
+
+// @returns |count| pseudo-random timestamps, lower than |range|.
+std::vector<Timestamp> RandomTimestamps(size_t count, uint32 range,
+                                        uint32 seed) {
+  std::vector<Timestamp> timestamps(count);
+  for (size_t i = 0; i < count; ++i) {
+    seed = seed * 1103515245 + 12345;
+    timestamps[i] = (seed >> 8) % range;
+  }
+  return timestamps;
+}
+
+bool RecordBefore(const SortRecord& left, const SortRecord& right) {
+  return left.timestamp < right.timestamp;
+}
+
+// Sorts the timestamps with their arrival indexes, as expected from the
+// sorter, and compares them to the received events.
+void ExpectSorted(const std::vector<Timestamp>& timestamps,
+                  const EventRecorder& recorder) {
+  std::vector<SortRecord> expected(timestamps.size());
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    expected[i].timestamp = timestamps[i];
+    expected[i].offset = static_cast<uint32>(i);
+  }
+  std::stable_sort(expected.begin(), expected.end(), RecordBefore);
+
+  ASSERT_EQ(expected.size(), recorder.timestamps.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(expected[i].timestamp, recorder.timestamps[i]);
+    ASSERT_EQ(expected[i].offset, recorder.indexes[i]);
+  }
+}
+
+ExternalEventSorter::Options MakeOptions(size_t memory_budget,
+                                         size_t thread_count) {
+  ExternalEventSorter::Options options;
+  options.memory_budget = memory_budget;
+  options.thread_count = thread_count;
+  options.merge_buffer_size = 64;
+  return options;
+}
+
+}  // namespace
+
+TEST(RadixSortByTimestampTest, StableSort) {
+  const Timestamp kBase = 0x0123456700000000ULL;
+  std::vector<Timestamp> timestamps = RandomTimestamps(5000, 1 << 20, 7);
+  timestamps.push_back(0);
+  timestamps.push_back(0xFFFFFFFFFFFFFFFFULL);
+
+  std::vector<SortRecord> records(timestamps.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    records[i].timestamp = kBase + timestamps[i];
+    records[i].offset = static_cast<uint32>(i);
+    records[i].size = 0;
+  }
+  std::vector<SortRecord> expected(records);
+  std::stable_sort(expected.begin(), expected.end(), RecordBefore);
+
+  std::vector<SortRecord> scratch;
+  RadixSortByTimestamp(&records, &scratch);
+  ASSERT_EQ(expected.size(), records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    EXPECT_EQ(expected[i].timestamp, records[i].timestamp);
+    EXPECT_EQ(expected[i].offset, records[i].offset);
+  }
+}
+
+TEST(RadixSortByTimestampTest, SmallInputs) {
+  std::vector<SortRecord> records;
+  std::vector<SortRecord> scratch;
+  RadixSortByTimestamp(&records, &scratch);
+  EXPECT_TRUE(records.empty());
+
+  SortRecord record = { 42, 0, 0 };
+  records.push_back(record);
+  RadixSortByTimestamp(&records, &scratch);
+  ASSERT_EQ(1U, records.size());
+  EXPECT_EQ(42U, records[0].timestamp);
+
+  record.timestamp = 41;
+  records.push_back(record);
+  RadixSortByTimestamp(&records, &scratch);
+  ASSERT_EQ(2U, records.size());
+  EXPECT_EQ(41U, records[0].timestamp);
+  EXPECT_EQ(42U, records[1].timestamp);
+}
+
+TEST(ExternalEventSorterTest, Empty) {
+  EventRecorder recorder;
+  ExternalEventSorter sorter(MakeOptions(1024 * 1024, 2));
+  EXPECT_TRUE(sorter.Finish(
+      base::MakeObserver(&recorder, &EventRecorder::Receive)));
+  EXPECT_TRUE(recorder.timestamps.empty());
+  EXPECT_EQ(0U, sorter.run_count());
+}
+
+TEST(ExternalEventSorterTest, InMemory) {
+  std::vector<Timestamp> timestamps = RandomTimestamps(1000, 100, 3);
+  ExternalEventSorter sorter(MakeOptions(16 * 1024 * 1024, 3));
+  for (size_t i = 0; i < timestamps.size(); ++i)
+    Send(timestamps[i], static_cast<uint32>(i), &sorter);
+
+  EventRecorder recorder;
+  EXPECT_TRUE(sorter.Finish(
+      base::MakeObserver(&recorder, &EventRecorder::Receive)));
+  ExpectSorted(timestamps, recorder);
+  EXPECT_EQ(1000U, sorter.received_events());
+  EXPECT_EQ(0U, sorter.run_count());
+  EXPECT_EQ(0U, sorter.spilled_bytes());
+}
+
+TEST(ExternalEventSorterTest, Spilled) {
+  // Several runs, the last chunks partially filled.
+  std::vector<Timestamp> timestamps = RandomTimestamps(20000, 5000, 11);
+  ExternalEventSorter sorter(MakeOptions(128 * 1024, 2));
+  for (size_t i = 0; i < timestamps.size(); ++i)
+    Send(timestamps[i], static_cast<uint32>(i), &sorter);
+
+  EventRecorder recorder;
+  EXPECT_TRUE(sorter.Finish(
+      base::MakeObserver(&recorder, &EventRecorder::Receive)));
+  ExpectSorted(timestamps, recorder);
+  EXPECT_LT(4U, sorter.run_count());
+  EXPECT_EQ(0U, sorter.merge_pass_count());
+  EXPECT_LT(0U, sorter.spilled_bytes());
+  EXPECT_FALSE(sorter.failed());
+}
+
+TEST(ExternalEventSorterTest, SpilledSingleThread) {
+  std::vector<Timestamp> timestamps = RandomTimestamps(10000, 1 << 30, 5);
+  ExternalEventSorter sorter(MakeOptions(64 * 1024, 1));
+  for (size_t i = 0; i < timestamps.size(); ++i)
+    Send(timestamps[i], static_cast<uint32>(i), &sorter);
+
+  EventRecorder recorder;
+  EXPECT_TRUE(sorter.Finish(
+      base::MakeObserver(&recorder, &EventRecorder::Receive)));
+  ExpectSorted(timestamps, recorder);
+  EXPECT_LT(1U, sorter.run_count());
+}
+
+TEST(ExternalEventSorterTest, MultiPassMerge) {
+  // At most 4 runs are merged at once.
+  std::vector<Timestamp> timestamps = RandomTimestamps(20000, 3000, 13);
+  ExternalEventSorter::Options options = MakeOptions(64 * 1024, 1);
+  options.merge_buffer_size = 16 * 1024;
+  ExternalEventSorter sorter(options);
+  for (size_t i = 0; i < timestamps.size(); ++i)
+    Send(timestamps[i], static_cast<uint32>(i), &sorter);
+
+  EventRecorder recorder;
+  EXPECT_TRUE(sorter.Finish(
+      base::MakeObserver(&recorder, &EventRecorder::Receive)));
+  ExpectSorted(timestamps, recorder);
+  EXPECT_LT(16U, sorter.run_count());
+  EXPECT_LE(2U, sorter.merge_pass_count());
+  EXPECT_FALSE(sorter.failed());
+}
+
+TEST(ExternalEventSorterTest, NullPayload) {
+  ExternalEventSorter sorter(MakeOptions(1024 * 1024, 1));
+  Event event(5, scoped_ptr<const Value>());
+  sorter.Receive(event);
+  sorter.Receive(event);
+
+  PayloadRecorder recorder;
+  EXPECT_TRUE(sorter.Finish(
+      base::MakeObserver(&recorder, &PayloadRecorder::Receive)));
+  EXPECT_EQ(2U, recorder.null_payloads);
+}
+
+TEST(ExternalEventSorterTest, UnwritableRuns) {
+  ExternalEventSorter::Options options = MakeOptions(64 * 1024, 1);
+  options.run_directory = "external_event_sorter_unittest_missing";
+  ExternalEventSorter sorter(options);
+  for (uint32 i = 0; i < 10000; ++i)
+    Send(10000 - i, i, &sorter);
+  EXPECT_TRUE(sorter.failed());
+
+  EventRecorder recorder;
+  EXPECT_FALSE(sorter.Finish(
+      base::MakeObserver(&recorder, &EventRecorder::Receive)));
+  EXPECT_TRUE(recorder.timestamps.empty());
+}
+
+}  // namespace parser
@@ -0,0 +1,77 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/fixed_layout.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace parser {
+
+bool DecodeFixedLayout(const FixedLayoutField* schema,
+                       size_t schema_size,
+                       size_t layout_size,
+                       Decoder* decoder,
+                       event::StructValue* fields) {
+  DCHECK(schema != NULL);
+  DCHECK(decoder != NULL);
+  DCHECK(fields != NULL);
+
+  // A single bounds check for the whole payload.
+  const char* bytes = decoder->Consume(layout_size);
+  if (bytes == NULL)
+    return false;
+
+#ifndef NDEBUG
+  // The schema must describe every byte of the layout, in order, with unique
+  // names.
+  size_t expected_offset = 0;
+  for (size_t i = 0; i < schema_size; ++i) {
+    DCHECK_EQ(expected_offset, schema[i].offset);
+    expected_offset = schema[i].offset + schema[i].size;
+    for (size_t j = 0; j < i; ++j)
+      DCHECK_NE(0, strcmp(schema[i].name, schema[j].name));
+  }
+  DCHECK_EQ(expected_offset, layout_size);
+#endif
+
+  // Build the structure in one pass: the fields are reserved at once, and
+  // the names of the schema are not looked up when it starts empty.
+  bool is_empty = fields->fields_begin() == fields->fields_end();
+  fields->ReserveFields(schema_size);
+  for (size_t i = 0; i < schema_size; ++i) {
+    const FixedLayoutField& field = schema[i];
+    scoped_ptr<event::Value> value(field.create(bytes + field.offset));
+    if (is_empty)
+      fields->AddNewField(field.name, value.Pass());
+    else if (!fields->AddField(field.name, value.Pass()))
+      return false;
+  }
+
+  return true;
+}
+
+}  // namespace parser
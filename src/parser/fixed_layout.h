@@ -0,0 +1,157 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Fixed-layout payload schemas. Many payloads are plain structures whose
+// fields are at fixed offsets. Instead of decoding them field by field, a
+// payload is described once by a packed structure and a static schema:
+//
+//   #pragma pack(push, 1)
+//   struct ContextSwitchLayout {
+//     uint32 new_thread_id;
+//     uint32 old_thread_id;
+//   };
+//   #pragma pack(pop)
+//
+//   const FixedLayoutField kContextSwitchSchema[] = {
+//     FIXED_LAYOUT_FIELD(ContextSwitchLayout, new_thread_id, UIntValue,
+//                        "NewThreadId"),
+//     FIXED_LAYOUT_FIELD(ContextSwitchLayout, old_thread_id, UIntValue,
+//                        "OldThreadId"),
+//   };
+//
+//   DecodeFixedLayout<ContextSwitchLayout>(kContextSwitchSchema, &decoder,
+//                                          fields);
+//
+// The decoding performs a single bounds check for the whole payload, then
+// creates the fields in schema order, in one pass: the fields are reserved at
+// once and, in an empty structure, added without looking up their names. A
+// mismatch between the size of a member and the size of its value type is a
+// compile error. Consumers needing the raw values can skip the Values
+// altogether with Decoder::DecodeRaw.
+
+#ifndef PARSER_FIXED_LAYOUT_H_
+#define PARSER_FIXED_LAYOUT_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "base/base.h"
+#include "event/value.h"
+#include "parser/decoder.h"
+
+namespace parser {
+
+// Creates the value of a field from its bytes.
+typedef event::Value* (*FixedLayoutValueFactory)(const char* bytes);
+
+// Describes a field of a fixed-layout payload.
+struct FixedLayoutField {
+  // The name of the field in the decoded structure.
+  const char* name;
+  // The offset of the field from the beginning of the payload.
+  size_t offset;
+  // The size in bytes of the field.
+  size_t size;
+  // Creates the value of the field.
+  FixedLayoutValueFactory create;
+};
+
+// Creates a scalar value from unaligned bytes.
+// @tparam T the type of value to create.
+// @param bytes the bytes of the scalar.
+// @returns the created value.
+template <typename T>
+event::Value* CreateFixedLayoutValue(const char* bytes) {
+  typename T::ScalarType value;
+  memcpy(&value, bytes, sizeof(value));
+  return new T(value);
+}
+
+namespace internal {
+
+// Only defined when the size of a member matches the size of its value type.
+template <bool>
+struct FixedLayoutSizeMatches;
+
+template <>
+struct FixedLayoutSizeMatches<true> {
+  enum { value = 0 };
+};
+
+// The size of the scalar held by a value type. Also usable with dependent
+// value types.
+template <typename T>
+struct FixedLayoutScalarSize {
+  enum { value = sizeof(typename T::ScalarType) };
+};
+
+}  // namespace internal
+
+// Declares a schema entry.
+// @param layout the packed structure describing the payload.
+// @param member the member of |layout| holding the field.
+// @param value_type the scalar Value type of the field.
+// @param name the name of the decoded field.
+#define FIXED_LAYOUT_FIELD(layout, member, value_type, name) \
+    { name, \
+      offsetof(layout, member), \
+      sizeof(reinterpret_cast<layout*>(0)->member) + \
+          parser::internal::FixedLayoutSizeMatches< \
+              sizeof(reinterpret_cast<layout*>(0)->member) == \
+              parser::internal::FixedLayoutScalarSize<value_type>::value \
+          >::value, \
+      &parser::CreateFixedLayoutValue<value_type> }
+
+// Decodes a fixed-layout payload and adds its fields to a structure.
+// @param schema the fields of the layout, in order.
+// @param schema_size the number of entries in |schema|.
+// @param layout_size the size in bytes of the layout.
+// @param decoder the decoder processing the payload.
+// @param fields the structure to receive the fields.
+// @returns true on success, false if there is not enough bytes or a field
+//     cannot be added.
+bool DecodeFixedLayout(const FixedLayoutField* schema,
+                       size_t schema_size,
+                       size_t layout_size,
+                       Decoder* decoder,
+                       event::StructValue* fields);
+
+// Decodes a fixed-layout payload and adds its fields to a structure.
+// @tparam Layout the packed structure describing the payload.
+// @param schema the fields of the layout, in order.
+// @param decoder the decoder processing the payload.
+// @param fields the structure to receive the fields.
+// @returns true on success, false otherwise.
+template <typename Layout, size_t N>
+bool DecodeFixedLayout(const FixedLayoutField (&schema)[N],
+                       Decoder* decoder,
+                       event::StructValue* fields) {
+  return DecodeFixedLayout(&schema[0], N, sizeof(Layout), decoder, fields);
+}
+
+}  // namespace parser
+
+#endif  // PARSER_FIXED_LAYOUT_H_
@@ -0,0 +1,112 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/fixed_layout.h"
+
+#include "base/perf_test.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/etw/etw_raw_payload_decoder_utils.h"
+
+namespace parser {
+
+namespace {
+
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::UShortValue;
+
+const size_t kIterations = 200000;
+
+#pragma pack(push, 1)
+struct SampleLayout {
+  uint64 instruction_pointer;
+  uint32 thread_id;
+  uint16 count;
+  uint16 reserved;
+};
+#pragma pack(pop)
+
+const FixedLayoutField kSampleSchema[] = {
+  FIXED_LAYOUT_FIELD(SampleLayout, instruction_pointer, ULongValue,
+                     "InstructionPointer"),
+  FIXED_LAYOUT_FIELD(SampleLayout, thread_id, UIntValue, "ThreadId"),
+  FIXED_LAYOUT_FIELD(SampleLayout, count, UShortValue, "Count"),
+  FIXED_LAYOUT_FIELD(SampleLayout, reserved, UShortValue, "Reserved")
+};
+
+const char kSamplePayload[sizeof(SampleLayout)] = {
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x2A, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00 };
+
+}  // namespace
+
+TEST(FixedLayoutPerfTest, FieldByField) {
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    Decoder decoder(&kSamplePayload[0], sizeof(kSamplePayload));
+    StructValue fields;
+    ASSERT_TRUE(
+        etw::Decode<ULongValue>("InstructionPointer", &decoder, &fields) &&
+        etw::Decode<UIntValue>("ThreadId", &decoder, &fields) &&
+        etw::Decode<UShortValue>("Count", &decoder, &fields) &&
+        etw::Decode<UShortValue>("Reserved", &decoder, &fields));
+  }
+  base::PrintPerfResult("FieldByField", "decode", timer.ElapsedNanoseconds(),
+                        kIterations, "ns/payload");
+}
+
+TEST(FixedLayoutPerfTest, DecodeFixedLayout) {
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    Decoder decoder(&kSamplePayload[0], sizeof(kSamplePayload));
+    StructValue fields;
+    ASSERT_TRUE(
+        DecodeFixedLayout<SampleLayout>(kSampleSchema, &decoder, &fields));
+  }
+  base::PrintPerfResult("DecodeFixedLayout", "decode",
+                        timer.ElapsedNanoseconds(), kIterations,
+                        "ns/payload");
+}
+
+TEST(FixedLayoutPerfTest, DecodeRaw) {
+  // Prevent the compiler from folding the decoding of a constant payload.
+  const char* volatile payload = &kSamplePayload[0];
+
+  uint64 checksum = 0;
+  base::PerfTimer timer;
+  for (size_t i = 0; i < kIterations; ++i) {
+    Decoder decoder(payload, sizeof(kSamplePayload));
+    SampleLayout layout;
+    ASSERT_TRUE(decoder.DecodeRaw(&layout));
+    checksum += layout.thread_id;
+  }
+  base::PrintPerfResult("DecodeRaw", "decode", timer.ElapsedNanoseconds(),
+                        kIterations, "ns/payload");
+  EXPECT_EQ(42U * kIterations, checksum);
+}
+
+}  // namespace parser
@@ -0,0 +1,138 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/fixed_layout.h"
+
+#include "gtest/gtest.h"
+
+namespace parser {
+
+namespace {
+
+using event::CharValue;
+using event::StructValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::UShortValue;
+
+#pragma pack(push, 1)
+struct TestLayout {
+  uint32 id;
+  int8 priority;
+  uint64 address;
+  uint16 count;
+};
+#pragma pack(pop)
+
+const FixedLayoutField kTestSchema[] = {
+  FIXED_LAYOUT_FIELD(TestLayout, id, UIntValue, "Id"),
+  FIXED_LAYOUT_FIELD(TestLayout, priority, CharValue, "Priority"),
+  FIXED_LAYOUT_FIELD(TestLayout, address, ULongValue, "Address"),
+  FIXED_LAYOUT_FIELD(TestLayout, count, UShortValue, "Count")
+};
+
+const unsigned char kTestPayload[] = {
+    0x01, 0x02, 0x03, 0x04,  // Id
+    0xFF,  // Priority
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,  // Address
+    0x2A, 0x00,  // Count
+    0x99 };  // Trailing byte.
+
+}  // namespace
+
+TEST(FixedLayoutTest, Schema) {
+  EXPECT_EQ(15U, sizeof(TestLayout));
+  EXPECT_STREQ("Id", kTestSchema[0].name);
+  EXPECT_EQ(0U, kTestSchema[0].offset);
+  EXPECT_EQ(4U, kTestSchema[0].size);
+  EXPECT_EQ(4U, kTestSchema[1].offset);
+  EXPECT_EQ(1U, kTestSchema[1].size);
+  EXPECT_EQ(5U, kTestSchema[2].offset);
+  EXPECT_EQ(8U, kTestSchema[2].size);
+  EXPECT_EQ(13U, kTestSchema[3].offset);
+  EXPECT_EQ(2U, kTestSchema[3].size);
+}
+
+TEST(FixedLayoutTest, DecodeFixedLayout) {
+  Decoder decoder(reinterpret_cast<const char*>(&kTestPayload[0]),
+                  sizeof(kTestPayload));
+  StructValue fields;
+  EXPECT_TRUE(DecodeFixedLayout<TestLayout>(kTestSchema, &decoder, &fields));
+  EXPECT_EQ(1U, decoder.RemainingBytes());
+
+  StructValue expected;
+  expected.AddField<UIntValue>("Id", 0x04030201U);
+  expected.AddField<CharValue>("Priority", -1);
+  expected.AddField<ULongValue>("Address", 0x1716151413121110ULL);
+  expected.AddField<UShortValue>("Count", 42);
+  EXPECT_TRUE(expected.Equals(&fields));
+
+  // Fields are added in schema order.
+  StructValue::const_iterator it = fields.fields_begin();
+  EXPECT_EQ("Id", it->first);
+  ++it;
+  EXPECT_EQ("Priority", it->first);
+}
+
+TEST(FixedLayoutTest, DecodeFixedLayoutAfterOtherFields) {
+  Decoder decoder(reinterpret_cast<const char*>(&kTestPayload[0]),
+                  sizeof(kTestPayload));
+  StructValue fields;
+  fields.AddField<UIntValue>("Header", 7);
+  EXPECT_TRUE(DecodeFixedLayout<TestLayout>(kTestSchema, &decoder, &fields));
+  uint32 id = 0;
+  EXPECT_TRUE(fields.GetFieldAsUInteger("Id", &id));
+  EXPECT_EQ(0x04030201U, id);
+
+  // The names are looked up when the structure already holds fields.
+  Decoder duplicate(reinterpret_cast<const char*>(&kTestPayload[0]),
+                    sizeof(kTestPayload));
+  StructValue duplicate_fields;
+  duplicate_fields.AddField<UIntValue>("Count", 7);
+  EXPECT_FALSE(DecodeFixedLayout<TestLayout>(kTestSchema, &duplicate,
+                                             &duplicate_fields));
+}
+
+TEST(FixedLayoutTest, DecodeFixedLayoutTooShort) {
+  Decoder decoder(reinterpret_cast<const char*>(&kTestPayload[0]),
+                  sizeof(TestLayout) - 1);
+  StructValue fields;
+  EXPECT_FALSE(DecodeFixedLayout<TestLayout>(kTestSchema, &decoder, &fields));
+  EXPECT_EQ(sizeof(TestLayout) - 1, decoder.RemainingBytes());
+  EXPECT_FALSE(fields.HasField("Id"));
+}
+
+TEST(FixedLayoutTest, DecodeRaw) {
+  Decoder decoder(reinterpret_cast<const char*>(&kTestPayload[0]),
+                  sizeof(kTestPayload));
+  TestLayout layout;
+  EXPECT_TRUE(decoder.DecodeRaw(&layout));
+  EXPECT_EQ(0x04030201U, layout.id);
+  EXPECT_EQ(-1, layout.priority);
+  EXPECT_EQ(0x1716151413121110ULL, layout.address);
+  EXPECT_EQ(42U, layout.count);
+}
+
+}  // namespace parser
@@ -0,0 +1,229 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/ftrace_event_format.h"
+
+#include <cstdlib>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+const char kWhitespaces[] = " \t\r";
+
+std::string Trim(const std::string& str) {
+  size_t begin = str.find_first_not_of(kWhitespaces);
+  if (begin == std::string::npos)
+    return std::string();
+  size_t end = str.find_last_not_of(kWhitespaces);
+  return str.substr(begin, end - begin + 1);
+}
+
+bool ParseSize(const std::string& str, size_t* value) {
+  DCHECK(value != NULL);
+  std::string trimmed = Trim(str);
+  if (trimmed.empty())
+    return false;
+  char* end = NULL;
+  unsigned long parsed = strtoul(trimmed.c_str(), &end, 10);
+  if (*end != '\0')
+    return false;
+  *value = static_cast<size_t>(parsed);
+  return true;
+}
+
+// Finds the value of an attribute of a field line, e.g. "offset:8;".
+bool FindAttribute(const std::string& line,
+                   const std::string& attribute,
+                   std::string* value) {
+  DCHECK(value != NULL);
+  std::string key = attribute + ":";
+  size_t begin = line.find(key);
+  if (begin == std::string::npos)
+    return false;
+  begin += key.size();
+  size_t end = line.find(';', begin);
+  if (end == std::string::npos)
+    return false;
+  *value = line.substr(begin, end - begin);
+  return true;
+}
+
+bool IsIdentifierChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+bool IsScalarSize(size_t size) {
+  return size == 1 || size == 2 || size == 4 || size == 8;
+}
+
+// Parses the declaration of a field, e.g. "unsigned long args[6]".
+bool ParseDeclaration(const std::string& declaration, FtraceField* field) {
+  DCHECK(field != NULL);
+
+  std::string type = Trim(declaration);
+  size_t count = 0;
+  bool is_array = false;
+
+  // Split the array dimension, if any.
+  size_t bracket = type.find('[');
+  if (bracket != std::string::npos) {
+    size_t close = type.find(']', bracket);
+    if (close == std::string::npos)
+      return false;
+    std::string dimension = type.substr(bracket + 1, close - bracket - 1);
+    is_array = true;
+    if (!dimension.empty() && !ParseSize(dimension, &count))
+      count = 0;
+    type.erase(bracket);
+    type = Trim(type);
+  }
+
+  bool is_dynamic = type.compare(0, 10, "__data_loc") == 0;
+
+  // The name is the last identifier of the declaration. A dynamic field
+  // declares its array dimension after the type: "__data_loc char[] name".
+  size_t name_end = type.size();
+  if (is_dynamic && bracket != std::string::npos) {
+    type = Trim(declaration);
+    name_end = type.size();
+  }
+  size_t name_begin = name_end;
+  while (name_begin > 0 && IsIdentifierChar(type[name_begin - 1]))
+    --name_begin;
+  if (name_begin == name_end)
+    return false;
+  field->name = type.substr(name_begin, name_end - name_begin);
+  std::string base_type = Trim(type.substr(0, name_begin));
+
+  if (is_dynamic) {
+    bool is_char = base_type.find("char") != std::string::npos &&
+                   base_type.find("unsigned") == std::string::npos;
+    field->kind = is_char && field->size == 4 ? FTRACE_FIELD_DYNAMIC_STRING :
+                                                FTRACE_FIELD_UNSUPPORTED;
+    field->element_size = 1;
+    return true;
+  }
+
+  if (is_array) {
+    if (base_type == "char" || base_type == "const char") {
+      field->kind = FTRACE_FIELD_STRING;
+      field->element_size = 1;
+      return true;
+    }
+    if (count == 0 || field->size % count != 0 ||
+        !IsScalarSize(field->size / count)) {
+      field->kind = FTRACE_FIELD_UNSUPPORTED;
+      return true;
+    }
+    field->kind = FTRACE_FIELD_ARRAY;
+    field->element_size = field->size / count;
+    return true;
+  }
+
+  field->kind = IsScalarSize(field->size) ? FTRACE_FIELD_SCALAR :
+                                            FTRACE_FIELD_UNSUPPORTED;
+  field->element_size = field->size;
+  return true;
+}
+
+bool ParseFieldLine(const std::string& line, FtraceField* field) {
+  DCHECK(field != NULL);
+
+  std::string declaration;
+  std::string offset;
+  std::string size;
+  if (!FindAttribute(line, "field", &declaration) ||
+      !FindAttribute(line, "offset", &offset) ||
+      !FindAttribute(line, "size", &size) ||
+      !ParseSize(offset, &field->offset) ||
+      !ParseSize(size, &field->size)) {
+    return false;
+  }
+
+  // Old kernels don't report the signedness.
+  std::string is_signed;
+  field->is_signed = FindAttribute(line, "signed", &is_signed) &&
+                     Trim(is_signed) == "1";
+
+  return ParseDeclaration(declaration, field);
+}
+
+}  // namespace
+
+const FtraceField* FtraceEventFormat::FindField(
+    const std::string& name) const {
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].name == name)
+      return &fields[i];
+  }
+  return NULL;
+}
+
+bool ParseFtraceEventFormat(const char* text,
+                            size_t length,
+                            FtraceEventFormat* format) {
+  DCHECK(text != NULL || length == 0);
+  DCHECK(format != NULL);
+
+  format->fields.clear();
+
+  size_t position = 0;
+  while (position < length) {
+    size_t end = position;
+    while (end < length && text[end] != '\n')
+      ++end;
+    std::string line = Trim(std::string(text + position, end - position));
+    position = end + 1;
+
+    if (line.compare(0, 5, "name:") == 0) {
+      format->name = Trim(line.substr(5));
+    } else if (line.compare(0, 3, "ID:") == 0) {
+      size_t id = 0;
+      if (!ParseSize(line.substr(3), &id))
+        return false;
+      format->id = static_cast<uint32>(id);
+    } else if (line.compare(0, 6, "field:") == 0) {
+      FtraceField field;
+      if (!ParseFieldLine(line, &field))
+        return false;
+      if (field.offset + field.size < field.offset)
+        return false;
+      format->fields.push_back(field);
+    } else if (line.compare(0, 10, "print fmt:") == 0) {
+      // The print format is not needed to decode the records.
+      break;
+    }
+  }
+
+  return !format->fields.empty();
+}
+
+}  // namespace ftrace
+}  // namespace parser
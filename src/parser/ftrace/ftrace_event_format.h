@@ -0,0 +1,115 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Parses the format files of the ftrace events, which describe the layout of
+// the raw event records of the kernel ring buffer:
+//
+//   name: sched_wakeup
+//   ID: 317
+//   format:
+//     field:unsigned short common_type;  offset:0;  size:2;  signed:0;
+//     ...
+//     field:char comm[16];  offset:8;  size:16;  signed:1;
+//     field:pid_t pid;  offset:24;  size:4;  signed:1;
+//
+//   print fmt: "comm=%s pid=%d ...", REC->comm, REC->pid, ...
+//
+// The same syntax describes the header of the ring buffer pages.
+
+#ifndef PARSER_FTRACE_FTRACE_EVENT_FORMAT_H_
+#define PARSER_FTRACE_FTRACE_EVENT_FORMAT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+
+namespace parser {
+namespace ftrace {
+
+enum FtraceFieldKind {
+  // An integer of 1, 2, 4 or 8 bytes.
+  FTRACE_FIELD_SCALAR,
+  // A fixed-size array of chars holding a NUL-terminated string.
+  FTRACE_FIELD_STRING,
+  // A "__data_loc char[]" field: the low 16 bits hold the offset of the
+  // string in the record, the high 16 bits its length.
+  FTRACE_FIELD_DYNAMIC_STRING,
+  // A fixed-size array of integers.
+  FTRACE_FIELD_ARRAY,
+  // A field that is not decoded, e.g. a dynamic array of integers.
+  FTRACE_FIELD_UNSUPPORTED
+};
+
+struct FtraceField {
+  FtraceField()
+      : kind(FTRACE_FIELD_UNSUPPORTED),
+        offset(0),
+        size(0),
+        element_size(0),
+        is_signed(false) {
+  }
+
+  std::string name;
+  FtraceFieldKind kind;
+  // The offset of the field in the record, in bytes.
+  size_t offset;
+  // The size of the field, in bytes.
+  size_t size;
+  // The size of a scalar or of an element of an array, in bytes.
+  size_t element_size;
+  bool is_signed;
+};
+
+struct FtraceEventFormat {
+  FtraceEventFormat() : id(0) {}
+
+  // @param name the name of a field.
+  // @returns the field named |name|, or NULL if there is none.
+  const FtraceField* FindField(const std::string& name) const;
+
+  uint32 id;
+  std::string system;
+  std::string name;
+  // The fields, in declaration order, including the common fields.
+  std::vector<FtraceField> fields;
+};
+
+// Parses a format file.
+// @param text the text of the format file.
+// @param length the length of |text|, in bytes.
+// @param format receives the name, identifier and fields of the event. The
+//     system is left unchanged.
+// @returns true on success, false if the text is malformed.
+bool ParseFtraceEventFormat(const char* text,
+                            size_t length,
+                            FtraceEventFormat* format);
+
+}  // namespace ftrace
+}  // namespace parser
+
+#endif  // PARSER_FTRACE_FTRACE_EVENT_FORMAT_H_
@@ -0,0 +1,147 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/ftrace_event_format.h"
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "parser/ftrace/trace_dat_test_utils.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+bool Parse(const char* text, FtraceEventFormat* format) {
+  return ParseFtraceEventFormat(text, strlen(text), format);
+}
+
+}  // namespace
+
+TEST(FtraceEventFormatTest, ParseSchedSwitch) {
+  FtraceEventFormat format;
+  ASSERT_TRUE(Parse(kTestSchedSwitchFormat, &format));
+
+  EXPECT_EQ(316U, format.id);
+  EXPECT_EQ("sched_switch", format.name);
+  ASSERT_EQ(11U, format.fields.size());
+
+  const FtraceField& common_pid = format.fields[3];
+  EXPECT_EQ("common_pid", common_pid.name);
+  EXPECT_EQ(FTRACE_FIELD_SCALAR, common_pid.kind);
+  EXPECT_EQ(4U, common_pid.offset);
+  EXPECT_EQ(4U, common_pid.size);
+  EXPECT_TRUE(common_pid.is_signed);
+
+  const FtraceField* prev_comm = format.FindField("prev_comm");
+  ASSERT_TRUE(prev_comm != NULL);
+  EXPECT_EQ(FTRACE_FIELD_STRING, prev_comm->kind);
+  EXPECT_EQ(8U, prev_comm->offset);
+  EXPECT_EQ(16U, prev_comm->size);
+
+  const FtraceField* prev_state = format.FindField("prev_state");
+  ASSERT_TRUE(prev_state != NULL);
+  EXPECT_EQ(FTRACE_FIELD_SCALAR, prev_state->kind);
+  EXPECT_EQ(32U, prev_state->offset);
+  EXPECT_EQ(8U, prev_state->element_size);
+
+  const FtraceField* next_pid = format.FindField("next_pid");
+  ASSERT_TRUE(next_pid != NULL);
+  EXPECT_EQ(56U, next_pid->offset);
+
+  EXPECT_TRUE(format.FindField("print") == NULL);
+  EXPECT_TRUE(format.FindField("unknown") == NULL);
+}
+
+TEST(FtraceEventFormatTest, ParseDynamicString) {
+  FtraceEventFormat format;
+  ASSERT_TRUE(Parse(kTestIrqHandlerEntryFormat, &format));
+
+  EXPECT_EQ(141U, format.id);
+  const FtraceField* name = format.FindField("name");
+  ASSERT_TRUE(name != NULL);
+  EXPECT_EQ(FTRACE_FIELD_DYNAMIC_STRING, name->kind);
+  EXPECT_EQ(12U, name->offset);
+  EXPECT_EQ(4U, name->size);
+}
+
+TEST(FtraceEventFormatTest, ParseArray) {
+  FtraceEventFormat format;
+  ASSERT_TRUE(Parse(kTestSysEnterFormat, &format));
+
+  const FtraceField* args = format.FindField("args");
+  ASSERT_TRUE(args != NULL);
+  EXPECT_EQ(FTRACE_FIELD_ARRAY, args->kind);
+  EXPECT_EQ(16U, args->offset);
+  EXPECT_EQ(48U, args->size);
+  EXPECT_EQ(8U, args->element_size);
+  EXPECT_FALSE(args->is_signed);
+}
+
+TEST(FtraceEventFormatTest, ParseHeaderPage) {
+  FtraceEventFormat format;
+  ASSERT_TRUE(Parse(kTestHeaderPageFormat, &format));
+
+  const FtraceField* commit = format.FindField("commit");
+  ASSERT_TRUE(commit != NULL);
+  EXPECT_EQ(8U, commit->offset);
+  EXPECT_EQ(8U, commit->size);
+
+  const FtraceField* data = format.FindField("data");
+  ASSERT_TRUE(data != NULL);
+  EXPECT_EQ(16U, data->offset);
+}
+
+TEST(FtraceEventFormatTest, ParseMalformed) {
+  FtraceEventFormat format;
+  EXPECT_FALSE(Parse(
+      "name: broken\n"
+      "ID: 12\n"
+      "format:\n"
+      "\tfield:int value;\toffset:8;\tsize:\n", &format));
+  EXPECT_FALSE(Parse(
+      "name: broken\n"
+      "ID: twelve\n", &format));
+  EXPECT_FALSE(Parse("name: empty\nID: 12\nformat:\n", &format));
+}
+
+TEST(FtraceEventFormatTest, ParseUnsupported) {
+  FtraceEventFormat format;
+  ASSERT_TRUE(Parse(
+      "name: odd\n"
+      "ID: 12\n"
+      "format:\n"
+      "\tfield:int value;\toffset:8;\tsize:3;\tsigned:1;\n"
+      "\tfield:__data_loc u32[] values;\toffset:12;\tsize:4;\tsigned:0;\n",
+      &format));
+  ASSERT_EQ(2U, format.fields.size());
+  EXPECT_EQ(FTRACE_FIELD_UNSUPPORTED, format.fields[0].kind);
+  EXPECT_EQ("values", format.fields[1].name);
+  EXPECT_EQ(FTRACE_FIELD_UNSUPPORTED, format.fields[1].kind);
+}
+
+}  // namespace ftrace
+}  // namespace parser
@@ -0,0 +1,174 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/ftrace_page_reader.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+const uint32 kTypeLenMaxData = 28;
+const uint32 kTypePadding = 29;
+const uint32 kTypeTimeExtend = 30;
+const uint32 kTypeTimeStamp = 31;
+
+const uint32 kTimeDeltaBits = 27;
+const uint32 kTimeDeltaMask = (1U << kTimeDeltaBits) - 1;
+
+// The commit field holds flags in its high bits.
+const uint64 kCommitMask = (1U << 27) - 1;
+
+uint32 Read32(const char* bytes) {
+  uint32 value;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+uint64 ReadUnsigned(const char* bytes, size_t size) {
+  if (size == 4)
+    return Read32(bytes);
+  uint64 value = 0;
+  memcpy(&value, bytes, size < sizeof(value) ? size : sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+FtracePageReader::FtracePageReader(const char* page,
+                                   size_t page_size,
+                                   const FtracePageLayout& layout)
+    : data_(NULL),
+      data_size_(0),
+      offset_(0),
+      timestamp_(0),
+      corrupted_(false) {
+  DCHECK(page != NULL);
+
+  if (layout.data_offset > page_size ||
+      layout.timestamp_offset + sizeof(uint64) > page_size ||
+      layout.commit_offset + layout.commit_size > page_size) {
+    corrupted_ = true;
+    return;
+  }
+
+  timestamp_ = ReadUnsigned(page + layout.timestamp_offset, sizeof(uint64));
+  data_ = page + layout.data_offset;
+  data_size_ = static_cast<size_t>(
+      ReadUnsigned(page + layout.commit_offset, layout.commit_size) &
+      kCommitMask);
+
+  if (data_size_ > page_size - layout.data_offset) {
+    corrupted_ = true;
+    data_size_ = 0;
+  }
+}
+
+bool FtracePageReader::Next(uint64* timestamp,
+                            const char** data,
+                            size_t* size) {
+  DCHECK(timestamp != NULL);
+  DCHECK(data != NULL);
+  DCHECK(size != NULL);
+
+  while (data_size_ - offset_ >= sizeof(uint32)) {
+    uint32 header = Read32(data_ + offset_);
+    uint32 type_len = header & 0x1F;
+    uint32 time_delta = header >> 5;
+    size_t remaining = data_size_ - offset_ - sizeof(uint32);
+    const char* body = data_ + offset_ + sizeof(uint32);
+
+    if (type_len == kTypePadding) {
+      // A padding without delta fills the rest of the page.
+      if (time_delta == 0 || remaining < sizeof(uint32))
+        return false;
+      size_t length = Read32(body);
+      if (length > remaining) {
+        corrupted_ = true;
+        return false;
+      }
+      offset_ += sizeof(uint32) + length;
+      continue;
+    }
+
+    if (type_len == kTypeTimeExtend || type_len == kTypeTimeStamp) {
+      if (remaining < sizeof(uint32)) {
+        corrupted_ = true;
+        return false;
+      }
+      uint64 extended = (static_cast<uint64>(Read32(body)) << kTimeDeltaBits) |
+                        (time_delta & kTimeDeltaMask);
+      if (type_len == kTypeTimeExtend)
+        timestamp_ += extended;
+      else
+        timestamp_ = extended;
+      offset_ += 2 * sizeof(uint32);
+      continue;
+    }
+
+    // A data event.
+    DCHECK_LE(type_len, kTypeLenMaxData);
+    size_t length = 0;
+    if (type_len == 0) {
+      if (remaining < sizeof(uint32)) {
+        corrupted_ = true;
+        return false;
+      }
+      // The length includes its own 32 bits.
+      length = Read32(body);
+      if (length < sizeof(uint32)) {
+        corrupted_ = true;
+        return false;
+      }
+      length = (length - sizeof(uint32) + 3) & ~static_cast<size_t>(3);
+      body += sizeof(uint32);
+      remaining -= sizeof(uint32);
+      offset_ += sizeof(uint32);
+    } else {
+      length = type_len * sizeof(uint32);
+    }
+
+    if (length > remaining) {
+      corrupted_ = true;
+      return false;
+    }
+
+    timestamp_ += time_delta;
+    offset_ += sizeof(uint32) + length;
+    *timestamp = timestamp_;
+    *data = body;
+    *size = length;
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace ftrace
+}  // namespace parser
@@ -0,0 +1,111 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Reads the events of a page of the ftrace ring buffer. A page starts with a
+// header holding the timestamp of its first event and the size of its data,
+// followed by the events. Each event starts with a 32-bit header:
+//
+//   type_len:5, time_delta:27
+//
+// The timestamp of an event is the timestamp of the previous event plus its
+// delta. The type_len encodes the kind of the event:
+//   0:      a data event whose length is stored in the next 32 bits,
+//   1-28:   a data event of type_len * 4 bytes,
+//   29:     padding,
+//   30:     a time extension of the delta of the next event,
+//   31:     an absolute timestamp.
+//
+// Usage example:
+//   FtracePageReader reader(page, page_size, layout);
+//   uint64 timestamp = 0;
+//   const char* data = NULL;
+//   size_t size = 0;
+//   while (reader.Next(&timestamp, &data, &size))
+//     Decode(timestamp, data, size);
+
+#ifndef PARSER_FTRACE_FTRACE_PAGE_READER_H_
+#define PARSER_FTRACE_FTRACE_PAGE_READER_H_
+
+#include <cstddef>
+
+#include "base/base.h"
+
+namespace parser {
+namespace ftrace {
+
+// The layout of the header of a page, from the "header_page" format.
+struct FtracePageLayout {
+  FtracePageLayout()
+      : timestamp_offset(0),
+        commit_offset(8),
+        commit_size(8),
+        data_offset(16) {
+  }
+
+  size_t timestamp_offset;
+  size_t commit_offset;
+  size_t commit_size;
+  size_t data_offset;
+};
+
+class FtracePageReader {
+ public:
+  // @param page the bytes of the page.
+  // @param page_size the size of the page, in bytes.
+  // @param layout the layout of the header of the page.
+  FtracePageReader(const char* page,
+                   size_t page_size,
+                   const FtracePageLayout& layout);
+
+  // Reads the next data event of the page.
+  // @param timestamp receives the timestamp of the event.
+  // @param data receives a pointer to the record of the event.
+  // @param size receives the size of the record, in bytes. It may include
+  //     some alignment bytes.
+  // @returns true on success, false at the end of the page or if the page
+  //     is corrupted.
+  bool Next(uint64* timestamp, const char** data, size_t* size);
+
+  // @returns true if the page is corrupted.
+  bool corrupted() const { return corrupted_; }
+
+  // @returns the timestamp of the last event read, or of the page.
+  uint64 timestamp() const { return timestamp_; }
+
+ private:
+  const char* data_;
+  size_t data_size_;
+  size_t offset_;
+  uint64 timestamp_;
+  bool corrupted_;
+
+  DISALLOW_COPY_AND_ASSIGN(FtracePageReader);
+};
+
+}  // namespace ftrace
+}  // namespace parser
+
+#endif  // PARSER_FTRACE_FTRACE_PAGE_READER_H_
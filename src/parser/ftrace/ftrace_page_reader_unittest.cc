@@ -0,0 +1,216 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/ftrace_page_reader.h"
+
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+const size_t kPageSize = 128;
+
+// Builds a page with the default layout.
+class PageBuilder {
+ public:
+  explicit PageBuilder(uint64 timestamp) {
+    Append64(timestamp);
+    Append64(0);
+  }
+
+  void AppendHeader(uint32 type_len, uint32 time_delta) {
+    Append32(type_len | time_delta << 5);
+  }
+
+  void Append32(uint32 value) {
+    page_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void Append64(uint64 value) {
+    page_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  // @returns the page, with its commit set to the size of its data.
+  std::string Build() const {
+    std::string page = page_;
+    uint64 commit = page.size() - 16;
+    memcpy(&page[8], &commit, sizeof(commit));
+    page.resize(kPageSize, '\0');
+    return page;
+  }
+
+ private:
+  std::string page_;
+};
+
+uint32 Read32(const char* bytes) {
+  uint32 value;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+TEST(FtracePageReaderTest, EmptyPage) {
+  PageBuilder builder(1000);
+  std::string page = builder.Build();
+  FtracePageReader reader(page.data(), page.size(), FtracePageLayout());
+
+  uint64 timestamp = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  EXPECT_FALSE(reader.Next(&timestamp, &data, &size));
+  EXPECT_FALSE(reader.corrupted());
+  EXPECT_EQ(1000U, reader.timestamp());
+}
+
+TEST(FtracePageReaderTest, DataEvents) {
+  PageBuilder builder(1000);
+  builder.AppendHeader(1, 0);
+  builder.Append32(11);
+  builder.AppendHeader(2, 25);
+  builder.Append32(21);
+  builder.Append32(22);
+  // A data event with an explicit length of 5 bytes, rounded to 8.
+  builder.AppendHeader(0, 5);
+  builder.Append32(5 + 4);
+  builder.Append32(31);
+  builder.Append32(0);
+  std::string page = builder.Build();
+  FtracePageReader reader(page.data(), page.size(), FtracePageLayout());
+
+  uint64 timestamp = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  ASSERT_TRUE(reader.Next(&timestamp, &data, &size));
+  EXPECT_EQ(1000U, timestamp);
+  EXPECT_EQ(4U, size);
+  EXPECT_EQ(11U, Read32(data));
+
+  ASSERT_TRUE(reader.Next(&timestamp, &data, &size));
+  EXPECT_EQ(1025U, timestamp);
+  EXPECT_EQ(8U, size);
+  EXPECT_EQ(21U, Read32(data));
+  EXPECT_EQ(22U, Read32(data + 4));
+
+  ASSERT_TRUE(reader.Next(&timestamp, &data, &size));
+  EXPECT_EQ(1030U, timestamp);
+  EXPECT_EQ(8U, size);
+  EXPECT_EQ(31U, Read32(data));
+
+  EXPECT_FALSE(reader.Next(&timestamp, &data, &size));
+  EXPECT_FALSE(reader.corrupted());
+}
+
+TEST(FtracePageReaderTest, TimeEvents) {
+  PageBuilder builder(1000);
+  // A time extension of (2 << 27) + 3.
+  builder.AppendHeader(30, 3);
+  builder.Append32(2);
+  builder.AppendHeader(1, 7);
+  builder.Append32(11);
+  // An absolute timestamp of (1 << 27) + 5.
+  builder.AppendHeader(31, 5);
+  builder.Append32(1);
+  builder.AppendHeader(1, 0);
+  builder.Append32(12);
+  std::string page = builder.Build();
+  FtracePageReader reader(page.data(), page.size(), FtracePageLayout());
+
+  uint64 timestamp = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  ASSERT_TRUE(reader.Next(&timestamp, &data, &size));
+  EXPECT_EQ(1000U + (2U << 27) + 3U + 7U, timestamp);
+  EXPECT_EQ(11U, Read32(data));
+
+  ASSERT_TRUE(reader.Next(&timestamp, &data, &size));
+  EXPECT_EQ((1U << 27) + 5U, timestamp);
+  EXPECT_EQ(12U, Read32(data));
+
+  EXPECT_FALSE(reader.Next(&timestamp, &data, &size));
+}
+
+TEST(FtracePageReaderTest, Padding) {
+  PageBuilder builder(1000);
+  // A discarded event of 8 bytes.
+  builder.AppendHeader(29, 1);
+  builder.Append32(8);
+  builder.Append32(0);
+  builder.AppendHeader(1, 2);
+  builder.Append32(11);
+  // A padding filling the rest of the page.
+  builder.AppendHeader(29, 0);
+  builder.AppendHeader(1, 2);
+  builder.Append32(12);
+  std::string page = builder.Build();
+  FtracePageReader reader(page.data(), page.size(), FtracePageLayout());
+
+  uint64 timestamp = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  ASSERT_TRUE(reader.Next(&timestamp, &data, &size));
+  EXPECT_EQ(1002U, timestamp);
+  EXPECT_EQ(11U, Read32(data));
+
+  EXPECT_FALSE(reader.Next(&timestamp, &data, &size));
+  EXPECT_FALSE(reader.corrupted());
+}
+
+TEST(FtracePageReaderTest, Truncated) {
+  PageBuilder builder(1000);
+  builder.AppendHeader(4, 0);
+  builder.Append32(11);
+  std::string page = builder.Build();
+  FtracePageReader reader(page.data(), page.size(), FtracePageLayout());
+
+  uint64 timestamp = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  EXPECT_FALSE(reader.Next(&timestamp, &data, &size));
+  EXPECT_TRUE(reader.corrupted());
+}
+
+TEST(FtracePageReaderTest, InvalidCommit) {
+  PageBuilder builder(1000);
+  std::string page = builder.Build();
+  uint64 commit = kPageSize;
+  memcpy(&page[8], &commit, sizeof(commit));
+  FtracePageReader reader(page.data(), page.size(), FtracePageLayout());
+
+  uint64 timestamp = 0;
+  const char* data = NULL;
+  size_t size = 0;
+  EXPECT_TRUE(reader.corrupted());
+  EXPECT_FALSE(reader.Next(&timestamp, &data, &size));
+}
+
+}  // namespace ftrace
+}  // namespace parser
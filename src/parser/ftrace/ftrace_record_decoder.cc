@@ -0,0 +1,192 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/ftrace_record_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+using event::ArrayValue;
+using event::CharValue;
+using event::IntValue;
+using event::LongValue;
+using event::ShortValue;
+using event::StringValue;
+using event::StructValue;
+using event::UCharValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::UShortValue;
+using event::Value;
+
+const char kCommonFieldPrefix[] = "common_";
+
+// @returns the factory of the values of an integer of |size| bytes.
+FixedLayoutValueFactory GetIntegerFactory(size_t size, bool is_signed) {
+  switch (size) {
+    case 1:
+      return is_signed ? &CreateFixedLayoutValue<CharValue> :
+                         &CreateFixedLayoutValue<UCharValue>;
+    case 2:
+      return is_signed ? &CreateFixedLayoutValue<ShortValue> :
+                         &CreateFixedLayoutValue<UShortValue>;
+    case 4:
+      return is_signed ? &CreateFixedLayoutValue<IntValue> :
+                         &CreateFixedLayoutValue<UIntValue>;
+    case 8:
+      return is_signed ? &CreateFixedLayoutValue<LongValue> :
+                         &CreateFixedLayoutValue<ULongValue>;
+    default:
+      return NULL;
+  }
+}
+
+uint64 ReadInteger(const char* bytes, size_t size) {
+  uint64 value = 0;
+  memcpy(&value, bytes, std::min(size, sizeof(value)));
+  return value;
+}
+
+}  // namespace
+
+FtraceRecordDecoder::FtraceRecordDecoder(const TraceDatFile& file)
+    : file_(file),
+      plans_(file.formats().size()),
+      type_offset_(0),
+      type_size_(sizeof(uint16)) {
+  const std::vector<FtraceEventFormat>& formats = file.formats();
+  for (size_t i = 0; i < formats.size(); ++i) {
+    const FtraceEventFormat& format = formats[i];
+    EventPlan& plan = plans_[i];
+
+    plan.pid = format.FindField("common_pid");
+    if (plan.pid != NULL && plan.pid->kind != FTRACE_FIELD_SCALAR)
+      plan.pid = NULL;
+
+    for (size_t j = 0; j < format.fields.size(); ++j) {
+      const FtraceField& field = format.fields[j];
+      plan.min_size = std::max(plan.min_size, field.offset + field.size);
+      if (field.kind == FTRACE_FIELD_UNSUPPORTED ||
+          field.name.compare(0, sizeof(kCommonFieldPrefix) - 1,
+                             kCommonFieldPrefix) == 0) {
+        continue;
+      }
+      FieldPlan field_plan = {
+          &field, GetIntegerFactory(field.element_size, field.is_signed) };
+      plan.fields.push_back(field_plan);
+    }
+  }
+
+  if (!formats.empty()) {
+    const FtraceField* type = formats[0].FindField("common_type");
+    if (type != NULL && type->kind == FTRACE_FIELD_SCALAR) {
+      type_offset_ = type->offset;
+      type_size_ = type->size;
+    }
+  }
+}
+
+bool FtraceRecordDecoder::Decode(const char* data,
+                                 size_t size,
+                                 const FtraceEventFormat** format,
+                                 uint64* pid,
+                                 scoped_ptr<StructValue>* content) const {
+  DCHECK(data != NULL || size == 0);
+  DCHECK(format != NULL);
+  DCHECK(pid != NULL);
+  DCHECK(content != NULL);
+
+  if (size < type_offset_ + type_size_)
+    return false;
+  uint32 type = static_cast<uint32>(
+      ReadInteger(data + type_offset_, type_size_));
+  *format = file_.FindFormat(type);
+  if (*format == NULL)
+    return false;
+
+  const EventPlan& plan = plans_[*format - &file_.formats()[0]];
+  if (size < plan.min_size)
+    return false;
+
+  *pid = 0;
+  if (plan.pid != NULL)
+    *pid = ReadInteger(data + plan.pid->offset, plan.pid->size);
+
+  content->reset(new StructValue());
+  for (size_t i = 0; i < plan.fields.size(); ++i) {
+    const FtraceField& field = *plan.fields[i].field;
+    const char* bytes = data + field.offset;
+
+    switch (field.kind) {
+      case FTRACE_FIELD_SCALAR: {
+        scoped_ptr<Value> value(plan.fields[i].create(bytes));
+        (*content)->AddField(field.name, value.Pass());
+        break;
+      }
+      case FTRACE_FIELD_STRING: {
+        size_t length = strnlen(bytes, field.size);
+        (*content)->AddField<StringValue>(field.name,
+                                          std::string(bytes, length));
+        break;
+      }
+      case FTRACE_FIELD_DYNAMIC_STRING: {
+        uint32 location = static_cast<uint32>(ReadInteger(bytes, 4));
+        size_t offset = location & 0xFFFF;
+        size_t length = location >> 16;
+        if (offset > size || length > size - offset)
+          length = 0;
+        length = strnlen(data + offset, length);
+        (*content)->AddField<StringValue>(
+            field.name, std::string(data + offset, length));
+        break;
+      }
+      case FTRACE_FIELD_ARRAY: {
+        scoped_ptr<ArrayValue> array(new ArrayValue());
+        for (size_t j = 0; j < field.size; j += field.element_size) {
+          scoped_ptr<Value> element(plan.fields[i].create(bytes + j));
+          array->Append(element.Pass());
+        }
+        (*content)->AddField(field.name, array.PassAs<Value>());
+        break;
+      }
+      default:
+        // The unsupported fields are not planned.
+        break;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace ftrace
+}  // namespace parser
@@ -0,0 +1,111 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Decodes the records of ftrace events from the formats of a trace. The
+// fields of each format are planned once; a record is then decoded without
+// looking up its fields by name.
+//
+// Usage example:
+//   FtraceRecordDecoder decoder(file);
+//   const FtraceEventFormat* format = NULL;
+//   uint64 pid = 0;
+//   scoped_ptr<event::StructValue> content;
+//   if (decoder.Decode(data, size, &format, &pid, &content))
+//     Send(format->name, pid, content.Pass());
+
+#ifndef PARSER_FTRACE_FTRACE_RECORD_DECODER_H_
+#define PARSER_FTRACE_FTRACE_RECORD_DECODER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "base/base.h"
+#include "base/scoped_ptr.h"
+#include "event/value.h"
+#include "parser/fixed_layout.h"
+#include "parser/ftrace/ftrace_event_format.h"
+#include "parser/ftrace/trace_dat_file.h"
+
+namespace parser {
+namespace ftrace {
+
+class FtraceRecordDecoder {
+ public:
+  // @param file the formats of the events. Must outlive this object.
+  explicit FtraceRecordDecoder(const TraceDatFile& file);
+
+  // Decodes a record. Fixed-size char arrays and "__data_loc char[]" fields
+  // are decoded as strings, integer arrays as arrays. The common fields are
+  // not decoded.
+  // @param data the bytes of the record.
+  // @param size the size of the record, in bytes.
+  // @param format receives the format of the record.
+  // @param pid receives the common_pid of the record, or 0.
+  // @param content receives the fields of the record.
+  // @returns true on success, false if the format of the record is unknown
+  //     or if the record is too short.
+  bool Decode(const char* data,
+              size_t size,
+              const FtraceEventFormat** format,
+              uint64* pid,
+              scoped_ptr<event::StructValue>* content) const;
+
+ private:
+  // How to decode a field of a record.
+  struct FieldPlan {
+    const FtraceField* field;
+    // Creates the value of a scalar or of an element of an array.
+    FixedLayoutValueFactory create;
+  };
+
+  // How to decode the records of an event.
+  struct EventPlan {
+    EventPlan() : pid(NULL), min_size(0) {}
+
+    const FtraceField* pid;
+    // The fields to decode, i.e. the supported non-common fields.
+    std::vector<FieldPlan> fields;
+    // The minimal size of a record holding all the fields.
+    size_t min_size;
+  };
+
+  const TraceDatFile& file_;
+
+  // The plans, in the order of the formats of |file_|.
+  std::vector<EventPlan> plans_;
+
+  // The type of a record is its common_type field, at the same place for
+  // all events.
+  size_t type_offset_;
+  size_t type_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(FtraceRecordDecoder);
+};
+
+}  // namespace ftrace
+}  // namespace parser
+
+#endif  // PARSER_FTRACE_FTRACE_RECORD_DECODER_H_
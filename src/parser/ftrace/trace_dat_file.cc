@@ -0,0 +1,311 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/trace_dat_file.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+#include "parser/decoder.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+const char* const kTraceDatVersions[] = { "6", NULL };
+// The versions of the tracing data of perf. Since "0.6", the tracing data
+// end with the command lines.
+const char* const kTracingDataVersions[] = { "0.5", "0.6", NULL };
+const char kTracingDataVersionWithoutCmdlines[] = "0.5";
+const char kHeaderPageSection[] = "header_page";
+const char kHeaderEventSection[] = "header_event";
+const char kOptionsSection[] = "options  ";
+const char kLatencySection[] = "latency  ";
+const char kFlyrecordSection[] = "flyrecord";
+
+// The identifiers of the events are small: bound the size of the index.
+const uint32 kMaxEventId = 1 << 16;
+
+// Reads a NUL-terminated string.
+bool ReadString(Decoder* decoder, std::string* str) {
+  DCHECK(decoder != NULL);
+  DCHECK(str != NULL);
+
+  size_t length = 0;
+  while (length < decoder->RemainingBytes() && decoder->Lookup(length) != 0)
+    ++length;
+  if (length == decoder->RemainingBytes())
+    return false;
+  str->assign(decoder->Consume(length + 1), length);
+  return true;
+}
+
+// Reads a NUL-terminated string and checks its value.
+bool ExpectString(Decoder* decoder, const char* expected) {
+  std::string str;
+  return ReadString(decoder, &str) && str == expected;
+}
+
+// Reads a block of bytes preceded by its size.
+template <typename SizeType>
+bool ReadBlock(Decoder* decoder, const char** block, size_t* size) {
+  DCHECK(block != NULL);
+  DCHECK(size != NULL);
+
+  SizeType block_size = 0;
+  if (!decoder->DecodeRaw(&block_size) ||
+      block_size > decoder->RemainingBytes()) {
+    return false;
+  }
+  *size = static_cast<size_t>(block_size);
+  *block = decoder->Consume(*size);
+  return true;
+}
+
+template <typename SizeType>
+bool SkipBlock(Decoder* decoder) {
+  const char* block = NULL;
+  size_t size = 0;
+  return ReadBlock<SizeType>(decoder, &block, &size);
+}
+
+bool ParsePageLayout(const char* text,
+                     size_t length,
+                     FtracePageLayout* layout) {
+  DCHECK(layout != NULL);
+
+  FtraceEventFormat format;
+  if (!ParseFtraceEventFormat(text, length, &format))
+    return false;
+
+  const FtraceField* timestamp = format.FindField("timestamp");
+  const FtraceField* commit = format.FindField("commit");
+  const FtraceField* data = format.FindField("data");
+  if (timestamp == NULL || commit == NULL || data == NULL ||
+      timestamp->size != sizeof(uint64) ||
+      (commit->size != 4 && commit->size != 8)) {
+    return false;
+  }
+
+  layout->timestamp_offset = timestamp->offset;
+  layout->commit_offset = commit->offset;
+  layout->commit_size = commit->size;
+  layout->data_offset = data->offset;
+  return true;
+}
+
+}  // namespace
+
+const char kTraceDatMagic[] = "\x17\x08\x44tracing";
+
+TraceDatFile::TraceDatFile() : page_size_(0), long_size_(0) {
+}
+
+bool TraceDatFile::HasMagic(const char* data, size_t length) {
+  return length >= kTraceDatMagicSize &&
+         memcmp(data, kTraceDatMagic, kTraceDatMagicSize) == 0;
+}
+
+bool TraceDatFile::Parse(const char* data, size_t length) {
+  DCHECK(data != NULL || length == 0);
+
+  Decoder decoder(data, length);
+  if (!ParseHeaders(&decoder, kTraceDatVersions))
+    return false;
+
+  uint32 cpu_count = 0;
+  if (!decoder.DecodeRaw(&cpu_count))
+    return false;
+
+  // The options, which are not needed to decode the records, precede the
+  // data section.
+  std::string section;
+  if (!ReadString(&decoder, &section))
+    return false;
+  if (section == kOptionsSection) {
+    while (true) {
+      uint16 option = 0;
+      if (!decoder.DecodeRaw(&option))
+        return false;
+      if (option == 0)
+        break;
+      if (!SkipBlock<uint32>(&decoder))
+        return false;
+    }
+    if (!ReadString(&decoder, &section))
+      return false;
+  }
+
+  if (section == kLatencySection) {
+    LOG(WARNING) << "Latency trace.dat files are not supported.";
+    return false;
+  }
+  if (section != kFlyrecordSection)
+    return false;
+
+  cpus_.resize(cpu_count);
+  for (uint32 cpu = 0; cpu < cpu_count; ++cpu) {
+    if (!decoder.DecodeRaw(&cpus_[cpu].offset) ||
+        !decoder.DecodeRaw(&cpus_[cpu].size)) {
+      return false;
+    }
+    const TraceDatCpu& buffer = cpus_[cpu];
+    if (buffer.offset > length || buffer.size > length - buffer.offset)
+      return false;
+  }
+
+  IndexFormats();
+  return true;
+}
+
+bool TraceDatFile::ParseTracingData(const char* data, size_t length) {
+  DCHECK(data != NULL || length == 0);
+
+  Decoder decoder(data, length);
+  if (!ParseHeaders(&decoder, kTracingDataVersions))
+    return false;
+
+  cpus_.clear();
+  IndexFormats();
+  return true;
+}
+
+bool TraceDatFile::ParseHeaders(Decoder* decoder,
+                                const char* const* versions) {
+  DCHECK(decoder != NULL);
+  DCHECK(versions != NULL);
+
+  if (decoder->RemainingBytes() < kTraceDatMagicSize ||
+      !HasMagic(decoder->Consume(kTraceDatMagicSize), kTraceDatMagicSize)) {
+    return false;
+  }
+
+  std::string version;
+  if (!ReadString(decoder, &version))
+    return false;
+  while (*versions != NULL && version != *versions)
+    ++versions;
+  if (*versions == NULL) {
+    LOG(WARNING) << "Unsupported trace.dat version " << version << ".";
+    return false;
+  }
+
+  uint8 big_endian = 0;
+  uint8 long_size = 0;
+  uint32 page_size = 0;
+  if (!decoder->DecodeRaw(&big_endian) ||
+      !decoder->DecodeRaw(&long_size) ||
+      !decoder->DecodeRaw(&page_size)) {
+    return false;
+  }
+  if (big_endian != 0) {
+    LOG(WARNING) << "Big-endian trace.dat files are not supported.";
+    return false;
+  }
+  if ((long_size != 4 && long_size != 8) || page_size == 0)
+    return false;
+  long_size_ = long_size;
+  page_size_ = page_size;
+
+  // The format of the page header.
+  const char* block = NULL;
+  size_t block_size = 0;
+  if (!ExpectString(decoder, kHeaderPageSection) ||
+      !ReadBlock<uint64>(decoder, &block, &block_size) ||
+      !ParsePageLayout(block, block_size, &page_layout_)) {
+    return false;
+  }
+
+  // The format of the event header is implied by the version.
+  if (!ExpectString(decoder, kHeaderEventSection) ||
+      !SkipBlock<uint64>(decoder)) {
+    return false;
+  }
+
+  // The formats of the ftrace events, then of the events of each system.
+  formats_.clear();
+  uint32 ftrace_count = 0;
+  if (!decoder->DecodeRaw(&ftrace_count))
+    return false;
+  for (uint32 i = 0; i < ftrace_count; ++i) {
+    FtraceEventFormat format;
+    format.system = "ftrace";
+    if (!ReadBlock<uint64>(decoder, &block, &block_size))
+      return false;
+    if (ParseFtraceEventFormat(block, block_size, &format))
+      formats_.push_back(format);
+  }
+
+  uint32 system_count = 0;
+  if (!decoder->DecodeRaw(&system_count))
+    return false;
+  for (uint32 i = 0; i < system_count; ++i) {
+    std::string system;
+    uint32 event_count = 0;
+    if (!ReadString(decoder, &system) || !decoder->DecodeRaw(&event_count))
+      return false;
+    for (uint32 j = 0; j < event_count; ++j) {
+      FtraceEventFormat format;
+      format.system = system;
+      if (!ReadBlock<uint64>(decoder, &block, &block_size))
+        return false;
+      if (ParseFtraceEventFormat(block, block_size, &format))
+        formats_.push_back(format);
+    }
+  }
+
+  // The kernel symbols, the printk formats and the command lines are not
+  // needed to decode the records.
+  if (!SkipBlock<uint32>(decoder) || !SkipBlock<uint32>(decoder))
+    return false;
+  if (version != kTracingDataVersionWithoutCmdlines &&
+      !SkipBlock<uint64>(decoder)) {
+    return false;
+  }
+
+  return true;
+}
+
+void TraceDatFile::IndexFormats() {
+  format_index_.clear();
+  for (size_t i = 0; i < formats_.size(); ++i) {
+    uint32 id = formats_[i].id;
+    if (id >= kMaxEventId)
+      continue;
+    if (id >= format_index_.size())
+      format_index_.resize(id + 1, 0);
+    format_index_[id] = static_cast<uint32>(i + 1);
+  }
+}
+
+const FtraceEventFormat* TraceDatFile::FindFormat(uint32 id) const {
+  if (id >= format_index_.size() || format_index_[id] == 0)
+    return NULL;
+  return &formats_[format_index_[id] - 1];
+}
+
+}  // namespace ftrace
+}  // namespace parser
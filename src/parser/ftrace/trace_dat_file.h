@@ -0,0 +1,148 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Parses the headers of a trace-cmd "trace.dat" file (version 6). The file
+// holds the formats of the recorded events followed by the raw pages of the
+// ring buffer of each CPU:
+//
+//   "\x17\x08\x44tracing" "6\0" <endianness> <long size> <page size>
+//   "header_page\0" <size:8> <format of the page header>
+//   "header_event\0" <size:8> <format of the event header>
+//   <count:4> { <size:8> <format> }                       ftrace events
+//   <count:4> { <system\0> <count:4> { <size:8> <format> } }  events
+//   <size:4> <kallsyms>  <size:4> <printk formats>  <size:8> <cmdlines>
+//   <cpus:4> ["options  \0" { <id:2> <size:4> <data> } <0:2>]
+//   "flyrecord\0" <cpus> * { <offset:8> <size:8> }
+//
+// The same headers, up to the command lines, are embedded as "tracing data"
+// in the perf.data files with tracepoints (version "0.6"). Only little-endian
+// files are supported.
+//
+// Usage example:
+//   TraceDatFile file;
+//   if (!file.Parse(data, length))
+//     return false;
+//   for (size_t cpu = 0; cpu < file.cpus().size(); ++cpu)
+//     ReadPages(data + file.cpus()[cpu].offset, file.cpus()[cpu].size);
+
+#ifndef PARSER_FTRACE_TRACE_DAT_FILE_H_
+#define PARSER_FTRACE_TRACE_DAT_FILE_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "parser/ftrace/ftrace_event_format.h"
+#include "parser/ftrace/ftrace_page_reader.h"
+
+namespace parser {
+
+class Decoder;
+
+namespace ftrace {
+
+// The first bytes of a trace.dat file.
+extern const char kTraceDatMagic[];
+const size_t kTraceDatMagicSize = 10;
+
+// The ring buffer of a CPU: a sequence of pages.
+struct TraceDatCpu {
+  uint64 offset;
+  uint64 size;
+};
+
+class TraceDatFile {
+ public:
+  TraceDatFile();
+
+  // Parses the headers of a file.
+  // @param data the bytes of the file. Must outlive this object.
+  // @param length the length of the file, in bytes.
+  // @returns true on success, false if the file is malformed or of an
+  //     unsupported version.
+  bool Parse(const char* data, size_t length);
+
+  // Parses the tracing data embedded in a perf.data file. There are no ring
+  // buffers: cpus() is empty.
+  // @param data the bytes of the tracing data.
+  // @param length the length of the tracing data, in bytes.
+  // @returns true on success, false if the data are malformed or of an
+  //     unsupported version.
+  bool ParseTracingData(const char* data, size_t length);
+
+  // @param data the first bytes of a file.
+  // @param length the number of bytes of |data|.
+  // @returns true if |data| starts with the magic of a trace.dat file.
+  static bool HasMagic(const char* data, size_t length);
+
+  // @returns the size of the pages of the ring buffers, in bytes.
+  size_t page_size() const { return page_size_; }
+
+  // @returns the size of a long of the traced kernel, in bytes.
+  size_t long_size() const { return long_size_; }
+
+  // @returns the layout of the header of the pages.
+  const FtracePageLayout& page_layout() const { return page_layout_; }
+
+  // @returns the ring buffers, indexed by CPU. Their offsets and sizes are
+  //     within the file.
+  const std::vector<TraceDatCpu>& cpus() const { return cpus_; }
+
+  // @returns the formats of the events.
+  const std::vector<FtraceEventFormat>& formats() const { return formats_; }
+
+  // @param id the identifier of an event.
+  // @returns the format of the event |id|, or NULL if it is unknown.
+  const FtraceEventFormat* FindFormat(uint32 id) const;
+
+ private:
+  // Parses the headers from the magic up to the command lines.
+  // @param decoder the decoder over the headers.
+  // @param versions the supported versions, NULL-terminated.
+  // @returns true on success, false otherwise.
+  bool ParseHeaders(Decoder* decoder, const char* const* versions);
+
+  // Indexes the formats by identifier.
+  void IndexFormats();
+
+  size_t page_size_;
+  size_t long_size_;
+  FtracePageLayout page_layout_;
+  std::vector<TraceDatCpu> cpus_;
+  std::vector<FtraceEventFormat> formats_;
+
+  // The index in |formats_| of each event identifier, plus one. Zero for
+  // unknown identifiers.
+  std::vector<uint32> format_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceDatFile);
+};
+
+}  // namespace ftrace
+}  // namespace parser
+
+#endif  // PARSER_FTRACE_TRACE_DAT_FILE_H_
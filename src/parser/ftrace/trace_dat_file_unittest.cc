@@ -0,0 +1,129 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/trace_dat_file.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "parser/ftrace/trace_dat_test_utils.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+std::string BuildTestFile() {
+  TraceDatBuilder builder(2);
+  builder.AddFormat("sched", kTestSchedSwitchFormat);
+  builder.AddFormat("irq", kTestIrqHandlerEntryFormat);
+  builder.AddEvent(0, 1000, MakeSchedSwitchRecord(0, "swapper", 0, "a", 1));
+  builder.AddEvent(1, 1100, MakeIrqHandlerEntryRecord(0, 10, "eth0"));
+  return builder.Build();
+}
+
+}  // namespace
+
+TEST(TraceDatFileTest, HasMagic) {
+  std::string data = BuildTestFile();
+  EXPECT_TRUE(TraceDatFile::HasMagic(data.data(), data.size()));
+  EXPECT_FALSE(TraceDatFile::HasMagic(data.data(), kTraceDatMagicSize - 1));
+  EXPECT_FALSE(TraceDatFile::HasMagic("PERFILE2", 8));
+}
+
+TEST(TraceDatFileTest, Parse) {
+  std::string data = BuildTestFile();
+  TraceDatFile file;
+  ASSERT_TRUE(file.Parse(data.data(), data.size()));
+
+  EXPECT_EQ(TraceDatBuilder::kPageSize, file.page_size());
+  EXPECT_EQ(8U, file.long_size());
+  EXPECT_EQ(0U, file.page_layout().timestamp_offset);
+  EXPECT_EQ(8U, file.page_layout().commit_offset);
+  EXPECT_EQ(8U, file.page_layout().commit_size);
+  EXPECT_EQ(16U, file.page_layout().data_offset);
+
+  ASSERT_EQ(2U, file.cpus().size());
+  for (size_t i = 0; i < file.cpus().size(); ++i) {
+    EXPECT_EQ(0U, file.cpus()[i].offset % TraceDatBuilder::kPageSize);
+    EXPECT_EQ(TraceDatBuilder::kPageSize, file.cpus()[i].size);
+  }
+
+  ASSERT_EQ(2U, file.formats().size());
+  const FtraceEventFormat* sched_switch = file.FindFormat(kTestSchedSwitchId);
+  ASSERT_TRUE(sched_switch != NULL);
+  EXPECT_EQ("sched", sched_switch->system);
+  EXPECT_EQ("sched_switch", sched_switch->name);
+  const FtraceEventFormat* irq = file.FindFormat(kTestIrqHandlerEntryId);
+  ASSERT_TRUE(irq != NULL);
+  EXPECT_EQ("irq", irq->system);
+  EXPECT_TRUE(file.FindFormat(kTestSysEnterId) == NULL);
+  EXPECT_TRUE(file.FindFormat(1U << 20) == NULL);
+}
+
+TEST(TraceDatFileTest, ParseTracingData) {
+  TraceDatBuilder builder(1);
+  builder.AddFormat("sched", kTestSchedSwitchFormat);
+  std::string data = builder.BuildTracingData();
+
+  TraceDatFile file;
+  ASSERT_TRUE(file.ParseTracingData(data.data(), data.size()));
+  EXPECT_TRUE(file.cpus().empty());
+  EXPECT_TRUE(file.FindFormat(kTestSchedSwitchId) != NULL);
+
+  // The tracing data are not a trace.dat file, and vice versa.
+  EXPECT_FALSE(file.Parse(data.data(), data.size()));
+  std::string trace_dat = builder.Build();
+  EXPECT_FALSE(file.ParseTracingData(trace_dat.data(), trace_dat.size()));
+}
+
+TEST(TraceDatFileTest, ParseUnsupportedVersion) {
+  std::string data = BuildTestFile();
+  data[kTraceDatMagicSize] = '7';
+  TraceDatFile file;
+  EXPECT_FALSE(file.Parse(data.data(), data.size()));
+}
+
+TEST(TraceDatFileTest, ParseBigEndian) {
+  std::string data = BuildTestFile();
+  data[kTraceDatMagicSize + 2] = 1;
+  TraceDatFile file;
+  EXPECT_FALSE(file.Parse(data.data(), data.size()));
+}
+
+TEST(TraceDatFileTest, ParseTruncated) {
+  std::string data = BuildTestFile();
+  // Truncated headers.
+  for (size_t length = 0; length < 600; length += 7) {
+    TraceDatFile file;
+    EXPECT_FALSE(file.Parse(data.data(), length));
+  }
+  // Truncated pages.
+  TraceDatFile file;
+  EXPECT_FALSE(file.Parse(data.data(), data.size() - 1));
+}
+
+}  // namespace ftrace
+}  // namespace parser
@@ -0,0 +1,218 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/trace_dat_parser.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+#include "base/scoped_ptr.h"
+#include "event/value.h"
+#include "parser/ftrace/ftrace_event_format.h"
+#include "parser/ftrace/ftrace_page_reader.h"
+#include "parser/ftrace/ftrace_record_decoder.h"
+#include "parser/ftrace/trace_dat_file.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+using event::Event;
+using event::StringValue;
+using event::StructValue;
+using event::Timestamp;
+using event::UCharValue;
+using event::ULongValue;
+using event::Value;
+
+// Reads the events of the ring buffer of a CPU, page by page.
+class CpuStream {
+ public:
+  CpuStream(uint32 cpu,
+            const char* begin,
+            const char* end,
+            const TraceDatFile& file)
+      : cpu_(cpu),
+        next_page_(begin),
+        end_(end),
+        file_(file),
+        timestamp_(0),
+        data_(NULL),
+        size_(0),
+        corrupted_pages_(0) {
+  }
+
+  // Reads the next event.
+  // @returns false when the ring buffer has no more events.
+  bool Advance() {
+    while (true) {
+      if (page_.get() != NULL && page_->Next(&timestamp_, &data_, &size_))
+        return true;
+      if (page_.get() != NULL && page_->corrupted())
+        ++corrupted_pages_;
+
+      size_t page_size = file_.page_size();
+      if (static_cast<size_t>(end_ - next_page_) < page_size)
+        return false;
+      page_.reset(new FtracePageReader(next_page_, page_size,
+                                       file_.page_layout()));
+      next_page_ += page_size;
+    }
+  }
+
+  uint32 cpu() const { return cpu_; }
+  Timestamp timestamp() const { return timestamp_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  size_t corrupted_pages() const { return corrupted_pages_; }
+
+ private:
+  uint32 cpu_;
+  const char* next_page_;
+  const char* end_;
+  const TraceDatFile& file_;
+  scoped_ptr<FtracePageReader> page_;
+
+  // The current event.
+  uint64 timestamp_;
+  const char* data_;
+  size_t size_;
+
+  size_t corrupted_pages_;
+
+  DISALLOW_COPY_AND_ASSIGN(CpuStream);
+};
+
+// Orders the streams of a min-heap by timestamp, then by CPU.
+bool StreamIsLater(const CpuStream* left, const CpuStream* right) {
+  if (left->timestamp() != right->timestamp())
+    return left->timestamp() > right->timestamp();
+  return left->cpu() > right->cpu();
+}
+
+void ParseTraceDat(const char* data,
+                   size_t length,
+                   const TraceDatFile& file,
+                   const base::Observer<Event>& observer) {
+  FtraceRecordDecoder decoder(file);
+
+  // Start a stream per CPU, and keep them in a min-heap.
+  std::vector<CpuStream*> streams;
+  std::vector<CpuStream*> heap;
+  for (size_t cpu = 0; cpu < file.cpus().size(); ++cpu) {
+    const TraceDatCpu& buffer = file.cpus()[cpu];
+    const char* begin = data + buffer.offset;
+    CpuStream* stream = new CpuStream(static_cast<uint32>(cpu), begin,
+                                      begin + buffer.size, file);
+    streams.push_back(stream);
+    if (stream->Advance())
+      heap.push_back(stream);
+  }
+  std::make_heap(heap.begin(), heap.end(), StreamIsLater);
+
+  size_t unknown_events = 0;
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), StreamIsLater);
+    CpuStream* stream = heap.back();
+
+    const FtraceEventFormat* format = NULL;
+    uint64 pid = 0;
+    scoped_ptr<StructValue> content;
+    if (!decoder.Decode(stream->data(), stream->size(), &format, &pid,
+                        &content)) {
+      ++unknown_events;
+    } else {
+      // Generate the event header fields.
+      scoped_ptr<StructValue> fields(new StructValue());
+      fields->AddField<StringValue>("operation", format->name);
+      fields->AddField<StringValue>("category", format->system);
+      fields->AddField<ULongValue>("process_id", pid);
+      fields->AddField<ULongValue>("thread_id", pid);
+      fields->AddField<UCharValue>("processor_number",
+                                   static_cast<uint8>(stream->cpu()));
+      fields->AddField("content", content.PassAs<Value>());
+
+      // Create the event with decoded fields and send it to the observer.
+      Event event(stream->timestamp(), fields.Pass());
+      observer.Receive(event);
+    }
+
+    if (stream->Advance())
+      std::push_heap(heap.begin(), heap.end(), StreamIsLater);
+    else
+      heap.pop_back();
+  }
+
+  size_t corrupted_pages = 0;
+  for (size_t i = 0; i < streams.size(); ++i) {
+    corrupted_pages += streams[i]->corrupted_pages();
+    delete streams[i];
+  }
+
+  if (unknown_events != 0)
+    LOG(WARNING) << unknown_events << " events have an unknown format.";
+  if (corrupted_pages != 0)
+    LOG(WARNING) << corrupted_pages << " pages are corrupted.";
+}
+
+}  // namespace
+
+bool TraceDatParser::AddTraceFile(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  char magic[kTraceDatMagicSize];
+  size_t read = fread(magic, 1, sizeof(magic), file);
+  fclose(file);
+
+  if (!TraceDatFile::HasMagic(magic, read))
+    return false;
+  traces_.push_back(path);
+  return true;
+}
+
+void TraceDatParser::Parse(const base::Observer<Event>& observer) {
+  for (size_t i = 0; i < traces_.size(); ++i) {
+    base::MemoryMappedFile mapped_file;
+    if (!mapped_file.Open(traces_[i])) {
+      LOG(WARNING) << "Unable to map the trace file " << traces_[i] << ".";
+      continue;
+    }
+
+    TraceDatFile file;
+    if (!file.Parse(mapped_file.data(), mapped_file.length())) {
+      LOG(WARNING) << "The trace file " << traces_[i] << " is malformed.";
+      continue;
+    }
+
+    ParseTraceDat(mapped_file.data(), mapped_file.length(), file, observer);
+  }
+}
+
+}  // namespace ftrace
+}  // namespace parser
@@ -0,0 +1,81 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PARSER_FTRACE_TRACE_DAT_PARSER_H_
+#define PARSER_FTRACE_TRACE_DAT_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/observer.h"
+#include "event/event.h"
+#include "parser/parser.h"
+
+namespace parser {
+namespace ftrace {
+
+// Generate Event objects from the trace.dat files written by trace-cmd. The
+// files are memory-mapped, and the pages of the ring buffers of all CPUs are
+// merged in timestamp order.
+//
+// Every event with a known format is decoded: sched_switch, sched_wakeup,
+// irq_handler_entry, softirq_entry, sys_enter, etc. The header fields of an
+// event are the same as for the ETW events:
+//   operation:         the name of the event, e.g. "sched_switch".
+//   category:          the system of the event, e.g. "sched".
+//   process_id:        the common_pid of the record. The kernel identifies
+//   thread_id:         tasks by pid: both fields hold the same value.
+//   processor_number:  the CPU of the ring buffer.
+//   content:           the fields of the record, except the common fields.
+// Fixed-size char arrays and "__data_loc char[]" fields are decoded as
+// strings, integer arrays as arrays.
+class TraceDatParser : public parser::ParserImpl {
+ public:
+  // Constuctor.
+  TraceDatParser() : parser::ParserImpl() {
+  }
+
+  // Adds a trace file to the list of traces to parse. The file is recognized
+  // by its magic.
+  // @param path path to the trace file.
+  bool AddTraceFile(const std::string& path) OVERRIDE;
+
+  // Parses the trace files added with AddTraceFile() and sends the resulting
+  // events to the provided observer.
+  // @param observer an observer that will receive the decoded events.
+  void Parse(const base::Observer<event::Event>& observer) OVERRIDE;
+
+ private:
+  // Trace files to consume.
+  std::vector<std::string> traces_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceDatParser);
+};
+
+}  // namespace ftrace
+}  // namespace parser
+
+#endif  // PARSER_FTRACE_TRACE_DAT_PARSER_H_
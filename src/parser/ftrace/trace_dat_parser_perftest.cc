@@ -0,0 +1,83 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/trace_dat_parser.h"
+
+#include <cstdio>
+
+#include "base/observer.h"
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+#include "parser/ftrace/trace_dat_test_utils.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+const char kTempFile[] = "trace_dat_parser_perftest.dat";
+const size_t kEvents = 200000;
+const size_t kCpus = 8;
+
+class EventCounter {
+ public:
+  EventCounter() : count_(0) {}
+
+  void Receive(const event::Event& /* event */) { ++count_; }
+
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_;
+};
+
+}  // namespace
+
+TEST(TraceDatParserPerfTest, Parse) {
+  {
+    TraceDatBuilder builder(kCpus);
+    builder.AddFormat("sched", kTestSchedSwitchFormat);
+    std::string record = MakeSchedSwitchRecord(12, "swapper/0", 0,
+                                               "bash", 1234);
+    for (size_t i = 0; i < kEvents; ++i)
+      builder.AddEvent(i % kCpus, i * 100, record);
+    ASSERT_TRUE(builder.WriteFile(kTempFile));
+  }
+
+  TraceDatParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCounter counter;
+
+  base::PerfTimer timer;
+  parser.Parse(base::MakeObserver(&counter, &EventCounter::Receive));
+  base::PrintPerfResult("ParseTraceDat", "time",
+                        timer.ElapsedNanoseconds(), kEvents, "ns/event");
+
+  std::remove(kTempFile);
+  EXPECT_EQ(kEvents, counter.count());
+}
+
+}  // namespace ftrace
+}  // namespace parser
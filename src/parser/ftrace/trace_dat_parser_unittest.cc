@@ -0,0 +1,228 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/trace_dat_parser.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "base/observer.h"
+#include "event/utils.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/ftrace/trace_dat_test_utils.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+using event::StructValue;
+
+const char kTempFile[] = "trace_dat_parser_unittest.dat";
+
+// Keeps the header fields of the received events.
+struct ReceivedEvent {
+  uint64 timestamp;
+  std::string operation;
+  std::string category;
+  uint64 process_id;
+  uint64 thread_id;
+  uint32 processor_number;
+  std::string content;
+};
+
+class EventCollector {
+ public:
+  void Receive(const event::Event& event) {
+    const StructValue* fields = StructValue::Cast(event.payload());
+    ASSERT_TRUE(fields != NULL);
+
+    ReceivedEvent received = {};
+    received.timestamp = event.timestamp();
+    const StructValue* content = NULL;
+    ASSERT_TRUE(fields->GetFieldAsString("operation", &received.operation));
+    ASSERT_TRUE(fields->GetFieldAsString("category", &received.category));
+    ASSERT_TRUE(fields->GetFieldAsULong("process_id", &received.process_id));
+    ASSERT_TRUE(fields->GetFieldAsULong("thread_id", &received.thread_id));
+    ASSERT_TRUE(fields->GetFieldAsUInteger("processor_number",
+                                           &received.processor_number));
+    ASSERT_TRUE(fields->GetFieldAs<StructValue>("content", &content));
+    ASSERT_TRUE(event::ToString(content, &received.content));
+    events.push_back(received);
+  }
+
+  std::vector<ReceivedEvent> events;
+};
+
+class TraceDatParserTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  void Parse() {
+    TraceDatParser parser;
+    ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+    parser.Parse(base::MakeObserver(&collector_, &EventCollector::Receive));
+  }
+
+  EventCollector collector_;
+};
+
+}  // namespace
+
+TEST_F(TraceDatParserTest, AddTraceFile) {
+  TraceDatBuilder builder(1);
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  TraceDatParser parser;
+  EXPECT_TRUE(parser.AddTraceFile(kTempFile));
+  EXPECT_FALSE(parser.AddTraceFile("missing.dat"));
+
+  FILE* file = fopen(kTempFile, "wb");
+  ASSERT_TRUE(file != NULL);
+  fputs("not a trace", file);
+  fclose(file);
+  EXPECT_FALSE(parser.AddTraceFile(kTempFile));
+}
+
+TEST_F(TraceDatParserTest, Parse) {
+  const uint64 kArgs[6] = { 3, 0x7FFF0000, 64, 0, 0, 0 };
+
+  TraceDatBuilder builder(2);
+  builder.AddFormat("sched", kTestSchedSwitchFormat);
+  builder.AddFormat("irq", kTestIrqHandlerEntryFormat);
+  builder.AddFormat("raw_syscalls", kTestSysEnterFormat);
+  builder.AddEvent(0, 1000, MakeSchedSwitchRecord(0, "swapper/0", 0,
+                                                  "bash", 1234));
+  builder.AddEvent(0, 3000, MakeSysEnterRecord(1234, 3, kArgs));
+  builder.AddEvent(1, 2000, MakeIrqHandlerEntryRecord(0, 24, "eth0"));
+  // A delta that needs a time extension.
+  builder.AddEvent(1, 5000000000ULL,
+                   MakeIrqHandlerEntryRecord(0, 25, "ahci"));
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  Parse();
+
+  const std::vector<ReceivedEvent>& events = collector_.events;
+  ASSERT_EQ(4U, events.size());
+
+  EXPECT_EQ(1000U, events[0].timestamp);
+  EXPECT_EQ("sched_switch", events[0].operation);
+  EXPECT_EQ("sched", events[0].category);
+  EXPECT_EQ(0U, events[0].process_id);
+  EXPECT_EQ(0U, events[0].processor_number);
+  EXPECT_EQ("{\n"
+            "    prev_comm = \"swapper/0\"\n"
+            "    prev_pid = 0\n"
+            "    prev_prio = 120\n"
+            "    prev_state = 1\n"
+            "    next_comm = \"bash\"\n"
+            "    next_pid = 1234\n"
+            "    next_prio = 120\n"
+            "}", events[0].content);
+
+  EXPECT_EQ(2000U, events[1].timestamp);
+  EXPECT_EQ("irq_handler_entry", events[1].operation);
+  EXPECT_EQ("irq", events[1].category);
+  EXPECT_EQ(1U, events[1].processor_number);
+  EXPECT_EQ("{\n    irq = 24\n    name = \"eth0\"\n}", events[1].content);
+
+  EXPECT_EQ(3000U, events[2].timestamp);
+  EXPECT_EQ("sys_enter", events[2].operation);
+  EXPECT_EQ("raw_syscalls", events[2].category);
+  EXPECT_EQ(1234U, events[2].process_id);
+  EXPECT_EQ(1234U, events[2].thread_id);
+  EXPECT_EQ(0U, events[2].processor_number);
+  EXPECT_EQ("{\n"
+            "    id = 3\n"
+            "    args = [\n"
+            "        3\n"
+            "        2147418112\n"
+            "        64\n"
+            "        0\n"
+            "        0\n"
+            "        0\n"
+            "    ]\n"
+            "}", events[2].content);
+
+  EXPECT_EQ(5000000000ULL, events[3].timestamp);
+  EXPECT_EQ("{\n    irq = 25\n    name = \"ahci\"\n}", events[3].content);
+}
+
+TEST_F(TraceDatParserTest, ParseManyPages) {
+  const size_t kEventsPerCpu = 1000;
+  const size_t kCpus = 3;
+
+  TraceDatBuilder builder(kCpus);
+  builder.AddFormat("sched", kTestSchedSwitchFormat);
+  for (size_t cpu = 0; cpu < kCpus; ++cpu) {
+    for (size_t i = 0; i < kEventsPerCpu; ++i) {
+      builder.AddEvent(cpu, (i * kCpus + cpu) * 10,
+                       MakeSchedSwitchRecord(static_cast<int32>(i), "a", 0,
+                                             "b", 1));
+    }
+  }
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  Parse();
+
+  const std::vector<ReceivedEvent>& events = collector_.events;
+  ASSERT_EQ(kEventsPerCpu * kCpus, events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(i * 10, events[i].timestamp);
+    EXPECT_EQ(i % kCpus, events[i].processor_number);
+    EXPECT_EQ(i / kCpus, events[i].process_id);
+  }
+}
+
+TEST_F(TraceDatParserTest, ParseUnknownEvents) {
+  TraceDatBuilder builder(1);
+  builder.AddFormat("sched", kTestSchedSwitchFormat);
+  builder.AddEvent(0, 1000, MakeIrqHandlerEntryRecord(0, 24, "eth0"));
+  builder.AddEvent(0, 2000, MakeSchedSwitchRecord(0, "a", 0, "b", 1));
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  Parse();
+
+  ASSERT_EQ(1U, collector_.events.size());
+  EXPECT_EQ(2000U, collector_.events[0].timestamp);
+}
+
+TEST_F(TraceDatParserTest, ParseMissingFile) {
+  TraceDatBuilder builder(1);
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  TraceDatParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  std::remove(kTempFile);
+  parser.Parse(base::MakeObserver(&collector_, &EventCollector::Receive));
+  EXPECT_TRUE(collector_.events.empty());
+}
+
+}  // namespace ftrace
+}  // namespace parser
@@ -0,0 +1,320 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/ftrace/trace_dat_test_utils.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "base/logging.h"
+
+namespace parser {
+namespace ftrace {
+
+namespace {
+
+const size_t kPageHeaderSize = 16;
+const uint32 kTypeLenMaxData = 28;
+const uint32 kTypeTimeExtend = 30;
+const uint64 kMaxTimeDelta = (1U << 27) - 1;
+
+template <typename T>
+void Append(T value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void AppendString(const std::string& str, std::string* out) {
+  out->append(str.c_str(), str.size() + 1);
+}
+
+void AppendFixedString(const std::string& str, size_t size, std::string* out) {
+  std::string fixed(str, 0, size);
+  fixed.resize(size, '\0');
+  out->append(fixed);
+}
+
+void AppendCommonFields(uint16 type, int32 pid, std::string* out) {
+  Append<uint16>(type, out);
+  Append<uint8>(0, out);
+  Append<uint8>(0, out);
+  Append<int32>(pid, out);
+}
+
+// Encodes a ring buffer event.
+std::string EncodeEvent(uint64 delta, const std::string& record) {
+  std::string event;
+  if (delta > kMaxTimeDelta) {
+    Append<uint32>(kTypeTimeExtend | static_cast<uint32>(delta << 5), &event);
+    Append<uint32>(static_cast<uint32>(delta >> 27), &event);
+    delta = 0;
+  }
+
+  size_t length = (record.size() + 3) & ~static_cast<size_t>(3);
+  if (length / 4 <= kTypeLenMaxData && length != 0) {
+    Append<uint32>(static_cast<uint32>(length / 4 | delta << 5), &event);
+  } else {
+    Append<uint32>(static_cast<uint32>(delta << 5), &event);
+    Append<uint32>(static_cast<uint32>(record.size() + 4), &event);
+  }
+  event.append(record);
+  event.resize(event.size() + length - record.size(), '\0');
+  return event;
+}
+
+}  // namespace
+
+const char kTestHeaderPageFormat[] =
+    "\tfield: u64 timestamp;\toffset:0;\tsize:8;\tsigned:0;\n"
+    "\tfield: local_t commit;\toffset:8;\tsize:8;\tsigned:1;\n"
+    "\tfield: int overwrite;\toffset:8;\tsize:1;\tsigned:1;\n"
+    "\tfield: char data;\toffset:16;\tsize:4080;\tsigned:1;\n";
+
+const char kTestSchedSwitchFormat[] =
+    "name: sched_switch\n"
+    "ID: 316\n"
+    "format:\n"
+    "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+    "\tfield:unsigned char common_flags;\toffset:2;\tsize:1;\tsigned:0;\n"
+    "\tfield:unsigned char common_preempt_count;\toffset:3;\tsize:1;"
+    "\tsigned:0;\n"
+    "\tfield:int common_pid;\toffset:4;\tsize:4;\tsigned:1;\n"
+    "\n"
+    "\tfield:char prev_comm[16];\toffset:8;\tsize:16;\tsigned:1;\n"
+    "\tfield:pid_t prev_pid;\toffset:24;\tsize:4;\tsigned:1;\n"
+    "\tfield:int prev_prio;\toffset:28;\tsize:4;\tsigned:1;\n"
+    "\tfield:long prev_state;\toffset:32;\tsize:8;\tsigned:1;\n"
+    "\tfield:char next_comm[16];\toffset:40;\tsize:16;\tsigned:1;\n"
+    "\tfield:pid_t next_pid;\toffset:56;\tsize:4;\tsigned:1;\n"
+    "\tfield:int next_prio;\toffset:60;\tsize:4;\tsigned:1;\n"
+    "\n"
+    "print fmt: \"prev_comm=%s prev_pid=%d\", REC->prev_comm, REC->prev_pid\n";
+
+const char kTestIrqHandlerEntryFormat[] =
+    "name: irq_handler_entry\n"
+    "ID: 141\n"
+    "format:\n"
+    "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+    "\tfield:unsigned char common_flags;\toffset:2;\tsize:1;\tsigned:0;\n"
+    "\tfield:unsigned char common_preempt_count;\toffset:3;\tsize:1;"
+    "\tsigned:0;\n"
+    "\tfield:int common_pid;\toffset:4;\tsize:4;\tsigned:1;\n"
+    "\n"
+    "\tfield:int irq;\toffset:8;\tsize:4;\tsigned:1;\n"
+    "\tfield:__data_loc char[] name;\toffset:12;\tsize:4;\tsigned:1;\n"
+    "\n"
+    "print fmt: \"irq=%d name=%s\", REC->irq, __get_str(name)\n";
+
+const char kTestSysEnterFormat[] =
+    "name: sys_enter\n"
+    "ID: 21\n"
+    "format:\n"
+    "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+    "\tfield:unsigned char common_flags;\toffset:2;\tsize:1;\tsigned:0;\n"
+    "\tfield:unsigned char common_preempt_count;\toffset:3;\tsize:1;"
+    "\tsigned:0;\n"
+    "\tfield:int common_pid;\toffset:4;\tsize:4;\tsigned:1;\n"
+    "\n"
+    "\tfield:long id;\toffset:8;\tsize:8;\tsigned:1;\n"
+    "\tfield:unsigned long args[6];\toffset:16;\tsize:48;\tsigned:0;\n"
+    "\n"
+    "print fmt: \"NR %ld (%lx, ...)\", REC->id, REC->args[0]\n";
+
+std::string MakeSchedSwitchRecord(int32 pid,
+                                  const std::string& prev_comm,
+                                  int32 prev_pid,
+                                  const std::string& next_comm,
+                                  int32 next_pid) {
+  std::string record;
+  AppendCommonFields(kTestSchedSwitchId, pid, &record);
+  AppendFixedString(prev_comm, 16, &record);
+  Append<int32>(prev_pid, &record);
+  Append<int32>(120, &record);
+  Append<int64>(1, &record);
+  AppendFixedString(next_comm, 16, &record);
+  Append<int32>(next_pid, &record);
+  Append<int32>(120, &record);
+  return record;
+}
+
+std::string MakeIrqHandlerEntryRecord(int32 pid,
+                                      int32 irq,
+                                      const std::string& name) {
+  const uint32 kNameOffset = 16;
+  std::string record;
+  AppendCommonFields(kTestIrqHandlerEntryId, pid, &record);
+  Append<int32>(irq, &record);
+  uint32 name_size = static_cast<uint32>(name.size() + 1);
+  Append<uint32>(name_size << 16 | kNameOffset, &record);
+  AppendString(name, &record);
+  return record;
+}
+
+std::string MakeSysEnterRecord(int32 pid, int64 id, const uint64 (&args)[6]) {
+  std::string record;
+  AppendCommonFields(kTestSysEnterId, pid, &record);
+  Append<int64>(id, &record);
+  for (size_t i = 0; i < 6; ++i)
+    Append<uint64>(args[i], &record);
+  return record;
+}
+
+const size_t TraceDatBuilder::kPageSize;
+
+TraceDatBuilder::TraceDatBuilder(size_t cpu_count) : buffers_(cpu_count) {
+}
+
+void TraceDatBuilder::AddFormat(const std::string& system,
+                                const std::string& format) {
+  formats_.push_back(std::make_pair(system, format));
+}
+
+void TraceDatBuilder::AddEvent(size_t cpu,
+                               uint64 timestamp,
+                               const std::string& record) {
+  DCHECK_LT(cpu, buffers_.size());
+  RingBuffer& buffer = buffers_[cpu];
+  DCHECK_GE(timestamp, buffer.last_timestamp);
+
+  std::string event = EncodeEvent(timestamp - buffer.last_timestamp, record);
+  if (buffer.page_data.empty() ||
+      kPageHeaderSize + buffer.page_data.size() + event.size() > kPageSize) {
+    FlushPage(&buffer);
+    buffer.page_timestamp = timestamp;
+    event = EncodeEvent(0, record);
+  }
+  DCHECK_LE(kPageHeaderSize + event.size(), kPageSize);
+
+  buffer.page_data.append(event);
+  buffer.last_timestamp = timestamp;
+}
+
+std::string TraceDatBuilder::BuildTracingData() const {
+  std::string out;
+  AppendHeaders("0.6", &out);
+  return out;
+}
+
+std::string TraceDatBuilder::Build() const {
+  std::string out;
+  AppendHeaders("6", &out);
+  Append<uint32>(static_cast<uint32>(buffers_.size()), &out);
+
+  // An unknown option.
+  out.append("options  ", 10);
+  Append<uint16>(42, &out);
+  Append<uint32>(3, &out);
+  out.append("abc");
+  Append<uint16>(0, &out);
+
+  out.append("flyrecord", 10);
+
+  // The pages are aligned on the page size.
+  std::vector<std::string> pages(buffers_.size());
+  size_t data_size = 0;
+  for (size_t cpu = 0; cpu < buffers_.size(); ++cpu) {
+    RingBuffer buffer = buffers_[cpu];
+    FlushPage(&buffer);
+    pages[cpu] = buffer.pages;
+    data_size += pages[cpu].size();
+  }
+
+  size_t offset = out.size() + buffers_.size() * 2 * sizeof(uint64);
+  offset = (offset + kPageSize - 1) / kPageSize * kPageSize;
+  for (size_t cpu = 0; cpu < buffers_.size(); ++cpu) {
+    Append<uint64>(offset, &out);
+    Append<uint64>(pages[cpu].size(), &out);
+    offset += pages[cpu].size();
+  }
+
+  out.resize((out.size() + kPageSize - 1) / kPageSize * kPageSize, '\0');
+  for (size_t cpu = 0; cpu < buffers_.size(); ++cpu)
+    out.append(pages[cpu]);
+
+  return out;
+}
+
+bool TraceDatBuilder::WriteFile(const std::string& path) const {
+  std::string data = Build();
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL)
+    return false;
+  bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+  return fclose(file) == 0 && success;
+}
+
+void TraceDatBuilder::AppendHeaders(const char* version,
+                                    std::string* out) const {
+  DCHECK(out != NULL);
+  out->append("\x17\x08\x44tracing", 10);
+  AppendString(version, out);
+  Append<uint8>(0, out);
+  Append<uint8>(8, out);
+  Append<uint32>(kPageSize, out);
+
+  AppendString("header_page", out);
+  Append<uint64>(strlen(kTestHeaderPageFormat), out);
+  out->append(kTestHeaderPageFormat);
+
+  const char kHeaderEventFormat[] = "# compressed entry header\n";
+  AppendString("header_event", out);
+  Append<uint64>(strlen(kHeaderEventFormat), out);
+  out->append(kHeaderEventFormat);
+
+  // No ftrace events.
+  Append<uint32>(0, out);
+
+  // A system per format.
+  Append<uint32>(static_cast<uint32>(formats_.size()), out);
+  for (size_t i = 0; i < formats_.size(); ++i) {
+    AppendString(formats_[i].first, out);
+    Append<uint32>(1, out);
+    Append<uint64>(formats_[i].second.size(), out);
+    out->append(formats_[i].second);
+  }
+
+  // Empty kallsyms and printk formats, a command line.
+  Append<uint32>(0, out);
+  Append<uint32>(0, out);
+  const char kCmdlines[] = "1 init\n";
+  Append<uint64>(strlen(kCmdlines), out);
+  out->append(kCmdlines);
+}
+
+void TraceDatBuilder::FlushPage(RingBuffer* buffer) {
+  DCHECK(buffer != NULL);
+  if (buffer->page_data.empty())
+    return;
+
+  std::string page;
+  Append<uint64>(buffer->page_timestamp, &page);
+  Append<uint64>(buffer->page_data.size(), &page);
+  page.append(buffer->page_data);
+  page.resize(kPageSize, '\0');
+  buffer->pages.append(page);
+  buffer->page_data.clear();
+}
+
+}  // namespace ftrace
+}  // namespace parser
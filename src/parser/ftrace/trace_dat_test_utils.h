@@ -0,0 +1,137 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Builds trace.dat files for the tests of the ftrace parser. The files have
+// the layout written by trace-cmd (version 6, little-endian, 64-bit longs,
+// 4096-byte pages).
+//
+// Usage example:
+//   TraceDatBuilder builder(2);
+//   builder.AddFormat("sched", kSchedSwitchFormat);
+//   builder.AddEvent(0, 1000, record);
+//   std::string data = builder.Build();
+
+#ifndef PARSER_FTRACE_TRACE_DAT_TEST_UTILS_H_
+#define PARSER_FTRACE_TRACE_DAT_TEST_UTILS_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+
+namespace parser {
+namespace ftrace {
+
+// The format of the header of the pages, as written by the kernel.
+extern const char kTestHeaderPageFormat[];
+
+// The formats of a few events, with their kernel layout.
+// @{
+extern const char kTestSchedSwitchFormat[];
+extern const char kTestIrqHandlerEntryFormat[];
+extern const char kTestSysEnterFormat[];
+// @}
+
+// The identifiers of the events of the formats above.
+// @{
+const uint16 kTestSchedSwitchId = 316;
+const uint16 kTestIrqHandlerEntryId = 141;
+const uint16 kTestSysEnterId = 21;
+// @}
+
+// Builds the record of an event of the formats above.
+// @{
+std::string MakeSchedSwitchRecord(int32 pid,
+                                  const std::string& prev_comm,
+                                  int32 prev_pid,
+                                  const std::string& next_comm,
+                                  int32 next_pid);
+std::string MakeIrqHandlerEntryRecord(int32 pid,
+                                      int32 irq,
+                                      const std::string& name);
+std::string MakeSysEnterRecord(int32 pid, int64 id, const uint64 (&args)[6]);
+// @}
+
+class TraceDatBuilder {
+ public:
+  // The size of the pages of the built files.
+  static const size_t kPageSize = 4096;
+
+  // @param cpu_count the number of ring buffers.
+  explicit TraceDatBuilder(size_t cpu_count);
+
+  // Adds the format of an event.
+  // @param system the system of the event, e.g. "sched".
+  // @param format the text of the format.
+  void AddFormat(const std::string& system, const std::string& format);
+
+  // Appends an event to the ring buffer of a CPU. The events of a CPU must be
+  // appended in timestamp order.
+  // @param cpu the CPU of the event.
+  // @param timestamp the timestamp of the event.
+  // @param record the record of the event.
+  void AddEvent(size_t cpu, uint64 timestamp, const std::string& record);
+
+  // @returns the bytes of the file.
+  std::string Build() const;
+
+  // @returns the tracing data of a perf.data file with the formats of this
+  //     builder. The events are ignored.
+  std::string BuildTracingData() const;
+
+  // Writes the file.
+  // @param path the path of the file to write.
+  // @returns true on success, false otherwise.
+  bool WriteFile(const std::string& path) const;
+
+ private:
+  struct RingBuffer {
+    RingBuffer() : last_timestamp(0) {}
+
+    // The complete pages.
+    std::string pages;
+    // The events of the current page.
+    std::string page_data;
+    uint64 page_timestamp;
+    uint64 last_timestamp;
+  };
+
+  // Appends the headers, from the magic up to the command lines.
+  void AppendHeaders(const char* version, std::string* out) const;
+
+  // Appends the current page of |buffer| to its complete pages.
+  static void FlushPage(RingBuffer* buffer);
+
+  std::vector<std::pair<std::string, std::string> > formats_;
+  std::vector<RingBuffer> buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceDatBuilder);
+};
+
+}  // namespace ftrace
+}  // namespace parser
+
+#endif  // PARSER_FTRACE_TRACE_DAT_TEST_UTILS_H_
@@ -0,0 +1,603 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/json/json_tokenizer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "base/logging.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_TOKENIZER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace parser {
+namespace json {
+
+namespace {
+
+// The characters ending the text of a string.
+const char kStringDelimiters[] = "\"\\";
+
+// The number of characters classified at once by a scanner. A mask of the
+// characters of a block fits in 32 bits.
+const size_t kScanBlockSize = 16;
+
+// The longest number parsed without allocating.
+const size_t kMaxInlineNumberSize = 64;
+
+// @returns the index of the lowest bit set in |mask|, which is not zero.
+inline size_t LowestBitIndex(uint32 mask) {
+  DCHECK_NE(0U, mask);
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Finds the first character of a range that is one of |chars|.
+// @param begin the beginning of the range.
+// @param end the end of the range.
+// @param chars the characters to find, as a NUL-terminated literal.
+// @returns the first character found, or |end|.
+template <size_t N>
+const char* FindFirstOf(const char* begin,
+                        const char* end,
+                        const char (&chars)[N]) {
+  const char* current = begin;
+
+#if defined(JSON_TOKENIZER_USE_SSE2)
+  __m128i patterns[N - 1];
+  for (size_t i = 0; i < N - 1; ++i)
+    patterns[i] = _mm_set1_epi8(chars[i]);
+
+  while (end - current >= 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i matches = _mm_cmpeq_epi8(block, patterns[0]);
+    for (size_t i = 1; i < N - 1; ++i)
+      matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, patterns[i]));
+    uint32 mask = static_cast<uint32>(_mm_movemask_epi8(matches));
+    if (mask != 0)
+      return current + LowestBitIndex(mask);
+    current += 16;
+  }
+#endif
+
+  for (; current < end; ++current) {
+    for (size_t i = 0; i < N - 1; ++i) {
+      if (*current == chars[i])
+        return current;
+    }
+  }
+  return end;
+}
+
+// Classifies the characters of a block.
+// @param block the characters to classify.
+// @param size the number of characters, at most kScanBlockSize.
+// @returns a mask with the bit i set if block[i] is a quote, a backslash, or
+//     the opening or the closing of an object or an array.
+uint32 ClassifyBlock(const char* block, size_t size) {
+  DCHECK_LE(size, kScanBlockSize);
+
+#if defined(JSON_TOKENIZER_USE_SSE2)
+  if (size == kScanBlockSize) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    // The brackets and the braces differ by 0x20: '[' is 0x5B and '{' 0x7B.
+    __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i matches = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')),
+                     _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+        _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                     _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))));
+    return static_cast<uint32>(_mm_movemask_epi8(matches));
+  }
+#endif
+
+  uint32 mask = 0;
+  for (size_t i = 0; i < size; ++i) {
+    char c = block[i];
+    if (c == '"' || c == '\\' || c == '{' || c == '}' || c == '[' ||
+        c == ']') {
+      mask |= 1U << i;
+    }
+  }
+  return mask;
+}
+
+// @returns true if |c| ends a number or a literal.
+bool IsScalarDelimiter(char c) {
+  return IsJsonWhitespace(c) || c == ',' || c == ':' || c == ']' ||
+         c == '}';
+}
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Parses 4 hexadecimal digits.
+bool ParseHex4(const char* data, uint32* value) {
+  DCHECK(data != NULL);
+  DCHECK(value != NULL);
+
+  uint32 result = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    char c = data[i];
+    uint32 digit = 0;
+    if (c >= '0' && c <= '9')
+      digit = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      digit = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      digit = c - 'A' + 10;
+    else
+      return false;
+    result = (result << 4) | digit;
+  }
+  *value = result;
+  return true;
+}
+
+// Appends a code point encoded in UTF-8.
+void AppendUTF8(uint32 code_point, std::string* value) {
+  DCHECK(value != NULL);
+
+  if (code_point < 0x80) {
+    value->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    value->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    value->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    value->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    value->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    value->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    value->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    value->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    value->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    value->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+}  // namespace
+
+JsonTokenizer::JsonTokenizer(const char* data, size_t size)
+    : data_(data),
+      size_(size),
+      position_(0),
+      error_(false) {
+  DCHECK(data != NULL || size == 0);
+}
+
+bool JsonTokenizer::Next(JsonToken* token) {
+  DCHECK(token != NULL);
+
+  if (error_)
+    return false;
+
+  // Skip the whitespaces and the separators.
+  while (position_ < size_) {
+    char c = data_[position_];
+    if (!IsJsonWhitespace(c) && c != ',' && c != ':')
+      break;
+    ++position_;
+  }
+  if (position_ >= size_)
+    return false;
+
+  const char* begin = data_ + position_;
+  const char* end = data_ + size_;
+  token->data = begin;
+  token->size = 1;
+  token->escaped = false;
+
+  switch (*begin) {
+    case '{':
+      token->type = JSON_TOKEN_BEGIN_OBJECT;
+      break;
+    case '}':
+      token->type = JSON_TOKEN_END_OBJECT;
+      break;
+    case '[':
+      token->type = JSON_TOKEN_BEGIN_ARRAY;
+      break;
+    case ']':
+      token->type = JSON_TOKEN_END_ARRAY;
+      break;
+
+    case '"': {
+      const char* current = begin + 1;
+      for (;;) {
+        current = FindFirstOf(current, end, kStringDelimiters);
+        if (current == end) {
+          error_ = true;
+          return false;
+        }
+        if (*current == '"')
+          break;
+        // Skip the escaped character.
+        token->escaped = true;
+        current += 2;
+        if (current > end) {
+          error_ = true;
+          return false;
+        }
+      }
+      token->type = JSON_TOKEN_STRING;
+      token->data = begin + 1;
+      token->size = current - begin - 1;
+      position_ = current + 1 - data_;
+      return true;
+    }
+
+    case 't':
+    case 'f':
+    case 'n': {
+      const char* literal = *begin == 't' ? "true" :
+                            *begin == 'f' ? "false" : "null";
+      size_t length = strlen(literal);
+      if (static_cast<size_t>(end - begin) < length ||
+          memcmp(begin, literal, length) != 0) {
+        error_ = true;
+        return false;
+      }
+      token->type = *begin == 't' ? JSON_TOKEN_TRUE :
+                    *begin == 'f' ? JSON_TOKEN_FALSE : JSON_TOKEN_NULL;
+      token->size = length;
+      break;
+    }
+
+    default: {
+      if (*begin != '-' && !IsDigit(*begin)) {
+        error_ = true;
+        return false;
+      }
+      // The number is validated when parsed.
+      const char* current = begin + 1;
+      while (current < end && !IsScalarDelimiter(*current))
+        ++current;
+      token->type = JSON_TOKEN_NUMBER;
+      token->size = current - begin;
+      break;
+    }
+  }
+
+  position_ += token->size;
+  return true;
+}
+
+bool JsonTokenizer::SkipValue(const JsonToken& token) {
+  if (token.type != JSON_TOKEN_BEGIN_OBJECT &&
+      token.type != JSON_TOKEN_BEGIN_ARRAY) {
+    return true;
+  }
+
+  size_t depth = 1;
+  JsonToken nested;
+  while (depth != 0) {
+    if (!Next(&nested))
+      return false;
+    if (nested.type == JSON_TOKEN_BEGIN_OBJECT ||
+        nested.type == JSON_TOKEN_BEGIN_ARRAY) {
+      ++depth;
+    } else if (nested.type == JSON_TOKEN_END_OBJECT ||
+               nested.type == JSON_TOKEN_END_ARRAY) {
+      --depth;
+    }
+  }
+  return true;
+}
+
+JsonValueScanner::JsonValueScanner()
+    : state_(STATE_START),
+      depth_(0) {
+}
+
+size_t JsonValueScanner::Scan(const char* data, size_t size) {
+  DCHECK(data != NULL || size == 0);
+
+  const char* current = data;
+  const char* end = data + size;
+  while (current < end) {
+    switch (state_) {
+      case STATE_START:
+        if (*current == '{' || *current == '[') {
+          depth_ = 1;
+          state_ = STATE_CONTAINER;
+        } else if (*current == '"') {
+          state_ = STATE_STRING;
+        } else if (!IsScalarDelimiter(*current)) {
+          state_ = STATE_SCALAR;
+        } else {
+          state_ = STATE_ERROR;
+          return current - data;
+        }
+        ++current;
+        break;
+
+      case STATE_CONTAINER:
+      case STATE_STRING:
+      case STATE_STRING_ESCAPE:
+        current = ScanNested(current, end);
+        break;
+
+      case STATE_SCALAR:
+        while (current < end && !IsScalarDelimiter(*current))
+          ++current;
+        if (current < end) {
+          // The delimiter is not part of the value.
+          state_ = STATE_COMPLETE;
+          return current - data;
+        }
+        break;
+
+      case STATE_COMPLETE:
+      case STATE_ERROR:
+        return current - data;
+    }
+  }
+  return current - data;
+}
+
+const char* JsonValueScanner::ScanNested(const char* current,
+                                         const char* end) {
+  while (current < end) {
+    if (state_ == STATE_STRING_ESCAPE) {
+      state_ = STATE_STRING;
+      ++current;
+      continue;
+    }
+
+    size_t block_size = std::min<size_t>(kScanBlockSize, end - current);
+    uint32 mask = ClassifyBlock(current, block_size);
+    while (mask != 0) {
+      size_t index = LowestBitIndex(mask);
+      mask &= mask - 1;
+      char c = current[index];
+
+      if (state_ == STATE_STRING) {
+        if (c == '\\') {
+          // The escaped character is not structural.
+          if (index + 1 == block_size)
+            state_ = STATE_STRING_ESCAPE;
+          else
+            mask &= ~(1U << (index + 1));
+        } else if (c == '"') {
+          if (depth_ == 0) {
+            state_ = STATE_COMPLETE;
+            return current + index + 1;
+          }
+          state_ = STATE_CONTAINER;
+        }
+      } else if (c == '"') {
+        state_ = STATE_STRING;
+      } else if (c == '{' || c == '[') {
+        ++depth_;
+      } else if (c == '}' || c == ']') {
+        if (--depth_ == 0) {
+          state_ = STATE_COMPLETE;
+          return current + index + 1;
+        }
+      }
+    }
+    current += block_size;
+  }
+  return current;
+}
+
+void JsonValueScanner::Finish() {
+  if (state_ == STATE_SCALAR)
+    state_ = STATE_COMPLETE;
+  else if (state_ != STATE_COMPLETE)
+    state_ = STATE_ERROR;
+}
+
+bool UnescapeJsonString(const char* data, size_t size, std::string* value) {
+  DCHECK(data != NULL || size == 0);
+  DCHECK(value != NULL);
+
+  value->clear();
+  const char* current = data;
+  const char* end = data + size;
+  while (current < end) {
+    const char* escape = FindFirstOf(current, end, "\\");
+    value->append(current, escape);
+    if (escape == end)
+      break;
+
+    current = escape + 1;
+    if (current == end)
+      return false;
+
+    char c = *current++;
+    switch (c) {
+      case '"':
+      case '\\':
+      case '/':
+        value->push_back(c);
+        break;
+      case 'b':
+        value->push_back('\b');
+        break;
+      case 'f':
+        value->push_back('\f');
+        break;
+      case 'n':
+        value->push_back('\n');
+        break;
+      case 'r':
+        value->push_back('\r');
+        break;
+      case 't':
+        value->push_back('\t');
+        break;
+
+      case 'u': {
+        uint32 code_point = 0;
+        if (end - current < 4 || !ParseHex4(current, &code_point))
+          return false;
+        current += 4;
+
+        // A high surrogate must be followed by a low surrogate.
+        if (code_point >= 0xD800 && code_point < 0xDC00) {
+          uint32 low = 0;
+          if (end - current < 6 || current[0] != '\\' || current[1] != 'u' ||
+              !ParseHex4(current + 2, &low) ||
+              low < 0xDC00 || low >= 0xE000) {
+            return false;
+          }
+          current += 6;
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                       (low - 0xDC00);
+        } else if (code_point >= 0xDC00 && code_point < 0xE000) {
+          return false;
+        }
+        AppendUTF8(code_point, value);
+        break;
+      }
+
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+bool GetJsonString(const JsonToken& token, std::string* value) {
+  DCHECK_EQ(JSON_TOKEN_STRING, token.type);
+  DCHECK(value != NULL);
+
+  if (token.escaped)
+    return UnescapeJsonString(token.data, token.size, value);
+  value->assign(token.data, token.size);
+  return true;
+}
+
+bool ParseJsonNumber(const char* data, size_t size, JsonNumber* number) {
+  DCHECK(data != NULL || size == 0);
+  DCHECK(number != NULL);
+
+  const char* current = data;
+  const char* end = data + size;
+
+  bool negative = false;
+  if (current < end && *current == '-') {
+    negative = true;
+    ++current;
+  }
+
+  // The integer part: a single zero or digits without a leading zero.
+  if (current == end || !IsDigit(*current))
+    return false;
+  bool overflow = false;
+  uint64 magnitude = 0;
+  if (*current == '0') {
+    ++current;
+  } else {
+    for (; current < end && IsDigit(*current); ++current) {
+      uint64 digit = *current - '0';
+      if (magnitude > (std::numeric_limits<uint64>::max() - digit) / 10)
+        overflow = true;
+      magnitude = magnitude * 10 + digit;
+    }
+  }
+
+  bool integral = true;
+  if (current < end && *current == '.') {
+    integral = false;
+    ++current;
+    if (current == end || !IsDigit(*current))
+      return false;
+    while (current < end && IsDigit(*current))
+      ++current;
+  }
+  if (current < end && (*current == 'e' || *current == 'E')) {
+    integral = false;
+    ++current;
+    if (current < end && (*current == '+' || *current == '-'))
+      ++current;
+    if (current == end || !IsDigit(*current))
+      return false;
+    while (current < end && IsDigit(*current))
+      ++current;
+  }
+  if (current != end)
+    return false;
+
+  if (integral && !overflow) {
+    if (!negative) {
+      number->type = JSON_NUMBER_UNSIGNED;
+      number->unsigned_value = magnitude;
+      number->signed_value = 0;
+      number->double_value = static_cast<double>(magnitude);
+      return true;
+    }
+    const uint64 kMaxNegativeMagnitude =
+        static_cast<uint64>(std::numeric_limits<int64>::max()) + 1;
+    if (magnitude <= kMaxNegativeMagnitude) {
+      number->type = JSON_NUMBER_SIGNED;
+      number->unsigned_value = 0;
+      number->signed_value = magnitude == kMaxNegativeMagnitude ?
+          std::numeric_limits<int64>::min() :
+          -static_cast<int64>(magnitude);
+      number->double_value = static_cast<double>(number->signed_value);
+      return true;
+    }
+  }
+
+  // strtod needs a NUL-terminated string.
+  char inline_text[kMaxInlineNumberSize + 1];
+  std::string text;
+  const char* terminated = inline_text;
+  if (size <= kMaxInlineNumberSize) {
+    memcpy(inline_text, data, size);
+    inline_text[size] = '\0';
+  } else {
+    text.assign(data, size);
+    terminated = text.c_str();
+  }
+
+  number->type = JSON_NUMBER_DOUBLE;
+  number->unsigned_value = 0;
+  number->signed_value = 0;
+  number->double_value = strtod(terminated, NULL);
+  return true;
+}
+
+}  // namespace json
+}  // namespace parser
@@ -0,0 +1,207 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// A streaming JSON tokenizer. It reads a buffer in place: the tokens point
+// into the buffer, and the strings are only unescaped on demand, so
+// tokenizing a document does not allocate.
+//
+// The separators (',' and ':') are skipped without being validated: the
+// consumer checks the grammar by expecting the tokens it needs. The strings
+// and the structural characters are found 16 bytes at a time with SSE2 when
+// it is available.
+//
+// Usage example:
+//   JsonTokenizer tokenizer(data, size);
+//   JsonToken token;
+//   while (tokenizer.Next(&token))
+//     Consume(token);
+//   if (tokenizer.error())
+//     return false;
+//
+// A JsonValueScanner finds the end of a value fed in pieces, which lets a
+// parser walk a document larger than the memory one window at a time:
+//
+//   JsonValueScanner scanner;
+//   while (!scanner.complete() && !scanner.error())
+//     offset += scanner.Scan(NextPiece(offset), piece_size);
+
+#ifndef PARSER_JSON_JSON_TOKENIZER_H_
+#define PARSER_JSON_JSON_TOKENIZER_H_
+
+#include <cstddef>
+#include <string>
+
+#include "base/base.h"
+
+namespace parser {
+namespace json {
+
+enum JsonTokenType {
+  JSON_TOKEN_BEGIN_OBJECT,
+  JSON_TOKEN_END_OBJECT,
+  JSON_TOKEN_BEGIN_ARRAY,
+  JSON_TOKEN_END_ARRAY,
+  JSON_TOKEN_STRING,
+  JSON_TOKEN_NUMBER,
+  JSON_TOKEN_TRUE,
+  JSON_TOKEN_FALSE,
+  JSON_TOKEN_NULL
+};
+
+struct JsonToken {
+  JsonToken() : type(JSON_TOKEN_NULL), data(NULL), size(0), escaped(false) {}
+
+  JsonTokenType type;
+  // The text of the token. The text of a string excludes its quotes and is
+  // still escaped.
+  const char* data;
+  size_t size;
+  // Whether the text of a string has escape sequences.
+  bool escaped;
+};
+
+// The types of the numbers, from the most to the least precise.
+enum JsonNumberType {
+  JSON_NUMBER_UNSIGNED,
+  JSON_NUMBER_SIGNED,
+  JSON_NUMBER_DOUBLE
+};
+
+struct JsonNumber {
+  JsonNumberType type;
+  uint64 unsigned_value;
+  int64 signed_value;
+  double double_value;
+};
+
+// @returns true if |c| is a JSON whitespace.
+inline bool IsJsonWhitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+class JsonTokenizer {
+ public:
+  // @param data the buffer to tokenize. Must outlive the tokenizer.
+  // @param size the size of the buffer, in bytes.
+  JsonTokenizer(const char* data, size_t size);
+
+  // Reads the next token.
+  // @param token receives the token.
+  // @returns true on success, false at the end of the buffer or on a
+  //     malformed token.
+  bool Next(JsonToken* token);
+
+  // Skips the tokens of a value.
+  // @param token the first token of the value, already read. The tokens of
+  //     an object or an array are skipped up to its end.
+  // @returns true on success, false if the value is truncated or malformed.
+  bool SkipValue(const JsonToken& token);
+
+  // @returns true if a malformed token was found.
+  bool error() const { return error_; }
+
+  // @returns the offset of the next token, in bytes.
+  size_t position() const { return position_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t position_;
+  bool error_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonTokenizer);
+};
+
+// Finds the end of a JSON value fed in pieces. The scanner only follows the
+// strings and the nesting of the objects and the arrays; it does not validate
+// the value.
+class JsonValueScanner {
+ public:
+  JsonValueScanner();
+
+  // Scans the next piece of a value. The first piece starts with the first
+  // character of the value.
+  // @param data the piece to scan.
+  // @param size the size of the piece, in bytes.
+  // @returns the number of bytes of |data| that belong to the value.
+  size_t Scan(const char* data, size_t size);
+
+  // Ends the input. A number or a literal is complete at the end of the
+  // input, an object, an array or a string is truncated.
+  void Finish();
+
+  // @returns true once the end of the value was found.
+  bool complete() const { return state_ == STATE_COMPLETE; }
+
+  // @returns true if the value cannot be scanned.
+  bool error() const { return state_ == STATE_ERROR; }
+
+ private:
+  enum State {
+    STATE_START,
+    STATE_CONTAINER,
+    STATE_STRING,
+    STATE_STRING_ESCAPE,
+    STATE_SCALAR,
+    STATE_COMPLETE,
+    STATE_ERROR
+  };
+
+  // Scans the characters within an object, an array or a string.
+  // @returns the position after the end of the value, or |end|.
+  const char* ScanNested(const char* current, const char* end);
+
+  State state_;
+  // The number of objects and arrays opened and not closed.
+  size_t depth_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonValueScanner);
+};
+
+// Unescapes the text of a string token. The \u escapes are encoded in UTF-8.
+// @param data the text of the string, without its quotes.
+// @param size the size of the text, in bytes.
+// @param value receives the unescaped string.
+// @returns true on success, false on an invalid escape sequence.
+bool UnescapeJsonString(const char* data, size_t size, std::string* value);
+
+// Gets the value of a string token.
+// @param token a string token.
+// @param value receives the unescaped string.
+// @returns true on success, false on an invalid escape sequence.
+bool GetJsonString(const JsonToken& token, std::string* value);
+
+// Parses the text of a number token. An integer is unsigned if it is not
+// negative, signed if it fits in an int64, and a double otherwise.
+// @param data the text of the number.
+// @param size the size of the text, in bytes.
+// @param number receives the number.
+// @returns true on success, false if the text is not a JSON number.
+bool ParseJsonNumber(const char* data, size_t size, JsonNumber* number);
+
+}  // namespace json
+}  // namespace parser
+
+#endif  // PARSER_JSON_JSON_TOKENIZER_H_
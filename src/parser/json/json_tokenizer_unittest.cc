@@ -0,0 +1,239 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/json/json_tokenizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace json {
+
+namespace {
+
+std::string TokenText(const JsonToken& token) {
+  return std::string(token.data, token.size);
+}
+
+// Scans a value in pieces of |piece_size| bytes.
+// @returns the size of the value, or 0 on error.
+size_t ScanInPieces(const std::string& text, size_t piece_size) {
+  JsonValueScanner scanner;
+  size_t offset = 0;
+  while (!scanner.complete() && !scanner.error()) {
+    if (offset == text.size()) {
+      scanner.Finish();
+      break;
+    }
+    size_t size = std::min(piece_size, text.size() - offset);
+    offset += scanner.Scan(text.data() + offset, size);
+  }
+  return scanner.complete() ? offset : 0;
+}
+
+}  // namespace
+
+TEST(JsonTokenizerTest, Tokens) {
+  const char kText[] =
+      " {\"a\": [1, -2.5e3, true, false, null], \"b\" : {}}\n";
+  JsonTokenizer tokenizer(kText, strlen(kText));
+  JsonToken token;
+
+  const JsonTokenType kExpectedTypes[] = {
+    JSON_TOKEN_BEGIN_OBJECT, JSON_TOKEN_STRING, JSON_TOKEN_BEGIN_ARRAY,
+    JSON_TOKEN_NUMBER, JSON_TOKEN_NUMBER, JSON_TOKEN_TRUE, JSON_TOKEN_FALSE,
+    JSON_TOKEN_NULL, JSON_TOKEN_END_ARRAY, JSON_TOKEN_STRING,
+    JSON_TOKEN_BEGIN_OBJECT, JSON_TOKEN_END_OBJECT, JSON_TOKEN_END_OBJECT
+  };
+  const char* kExpectedTexts[] = {
+    "{", "a", "[", "1", "-2.5e3", "true", "false", "null", "]", "b", "{", "}",
+    "}"
+  };
+  const size_t kTokenCount = sizeof(kExpectedTypes) / sizeof(kExpectedTypes[0]);
+
+  for (size_t i = 0; i < kTokenCount; ++i) {
+    ASSERT_TRUE(tokenizer.Next(&token));
+    EXPECT_EQ(kExpectedTypes[i], token.type);
+    EXPECT_EQ(kExpectedTexts[i], TokenText(token));
+  }
+  EXPECT_FALSE(tokenizer.Next(&token));
+  EXPECT_FALSE(tokenizer.error());
+  EXPECT_EQ(strlen(kText), tokenizer.position());
+}
+
+TEST(JsonTokenizerTest, Strings) {
+  // The strings are longer than a vector block, with delimiters at several
+  // offsets.
+  const char kText[] =
+      "\"0123456789abcdefghij\" "
+      "\"0123456789abcd\\\"ef\\\\\" "
+      "\"\" "
+      "\"0123456789abcdef0123456789abcdef0\"";
+  JsonTokenizer tokenizer(kText, strlen(kText));
+  JsonToken token;
+  std::string value;
+
+  ASSERT_TRUE(tokenizer.Next(&token));
+  EXPECT_EQ(JSON_TOKEN_STRING, token.type);
+  EXPECT_FALSE(token.escaped);
+  EXPECT_EQ("0123456789abcdefghij", TokenText(token));
+
+  ASSERT_TRUE(tokenizer.Next(&token));
+  EXPECT_TRUE(token.escaped);
+  EXPECT_EQ("0123456789abcd\\\"ef\\\\", TokenText(token));
+  ASSERT_TRUE(GetJsonString(token, &value));
+  EXPECT_EQ("0123456789abcd\"ef\\", value);
+
+  ASSERT_TRUE(tokenizer.Next(&token));
+  EXPECT_EQ(0U, token.size);
+
+  ASSERT_TRUE(tokenizer.Next(&token));
+  EXPECT_EQ("0123456789abcdef0123456789abcdef0", TokenText(token));
+  EXPECT_FALSE(tokenizer.Next(&token));
+  EXPECT_FALSE(tokenizer.error());
+}
+
+TEST(JsonTokenizerTest, MalformedTokens) {
+  const char* kTexts[] = {
+    "\"unterminated",
+    "\"escape at the end\\",
+    "tru",
+    "nul",
+    "@",
+  };
+  for (size_t i = 0; i < sizeof(kTexts) / sizeof(kTexts[0]); ++i) {
+    JsonTokenizer tokenizer(kTexts[i], strlen(kTexts[i]));
+    JsonToken token;
+    EXPECT_FALSE(tokenizer.Next(&token)) << kTexts[i];
+    EXPECT_TRUE(tokenizer.error()) << kTexts[i];
+  }
+}
+
+TEST(JsonTokenizerTest, SkipValue) {
+  const char kText[] = "{\"a\": [1, {\"b\": \"]}\"}], \"c\": 2} 3";
+  JsonTokenizer tokenizer(kText, strlen(kText));
+  JsonToken token;
+
+  ASSERT_TRUE(tokenizer.Next(&token));
+  ASSERT_TRUE(tokenizer.SkipValue(token));
+  ASSERT_TRUE(tokenizer.Next(&token));
+  EXPECT_EQ(JSON_TOKEN_NUMBER, token.type);
+  EXPECT_EQ("3", TokenText(token));
+  EXPECT_TRUE(tokenizer.SkipValue(token));
+
+  JsonTokenizer truncated(kText, 10);
+  ASSERT_TRUE(truncated.Next(&token));
+  EXPECT_FALSE(truncated.SkipValue(token));
+}
+
+TEST(JsonTokenizerTest, UnescapeJsonString) {
+  std::string value;
+  const char kEscapes[] = "a\\\"\\\\\\/\\b\\f\\n\\r\\tz";
+  ASSERT_TRUE(UnescapeJsonString(kEscapes, strlen(kEscapes), &value));
+  EXPECT_EQ("a\"\\/\b\f\n\r\tz", value);
+
+  const char kUnicode[] = "\\u0041\\u00e9\\u20AC\\ud83d\\ude00";
+  ASSERT_TRUE(UnescapeJsonString(kUnicode, strlen(kUnicode), &value));
+  EXPECT_EQ("A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80", value);
+
+  const char* kInvalid[] = {
+    "\\x", "\\u12", "\\u12G4", "\\ud83d", "\\ud83d\\u0041", "\\ude00", "\\",
+  };
+  for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); ++i) {
+    EXPECT_FALSE(UnescapeJsonString(kInvalid[i], strlen(kInvalid[i]),
+                                    &value)) << kInvalid[i];
+  }
+}
+
+TEST(JsonTokenizerTest, ParseJsonNumber) {
+  JsonNumber number;
+
+  ASSERT_TRUE(ParseJsonNumber("0", 1, &number));
+  EXPECT_EQ(JSON_NUMBER_UNSIGNED, number.type);
+  EXPECT_EQ(0U, number.unsigned_value);
+
+  ASSERT_TRUE(ParseJsonNumber("18446744073709551615", 20, &number));
+  EXPECT_EQ(JSON_NUMBER_UNSIGNED, number.type);
+  EXPECT_EQ(18446744073709551615ULL, number.unsigned_value);
+
+  ASSERT_TRUE(ParseJsonNumber("18446744073709551616", 20, &number));
+  EXPECT_EQ(JSON_NUMBER_DOUBLE, number.type);
+  EXPECT_DOUBLE_EQ(18446744073709551616.0, number.double_value);
+
+  ASSERT_TRUE(ParseJsonNumber("-42", 3, &number));
+  EXPECT_EQ(JSON_NUMBER_SIGNED, number.type);
+  EXPECT_EQ(-42, number.signed_value);
+
+  ASSERT_TRUE(ParseJsonNumber("-9223372036854775808", 20, &number));
+  EXPECT_EQ(JSON_NUMBER_SIGNED, number.type);
+  EXPECT_EQ(-9223372036854775807LL - 1, number.signed_value);
+
+  ASSERT_TRUE(ParseJsonNumber("12.25", 5, &number));
+  EXPECT_EQ(JSON_NUMBER_DOUBLE, number.type);
+  EXPECT_DOUBLE_EQ(12.25, number.double_value);
+
+  ASSERT_TRUE(ParseJsonNumber("-1.5E+3", 7, &number));
+  EXPECT_EQ(JSON_NUMBER_DOUBLE, number.type);
+  EXPECT_DOUBLE_EQ(-1500.0, number.double_value);
+
+  const char* kInvalid[] = { "", "-", "01", "1.", ".5", "1e", "1e+", "1x" };
+  for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); ++i) {
+    EXPECT_FALSE(ParseJsonNumber(kInvalid[i], strlen(kInvalid[i]), &number))
+        << kInvalid[i];
+  }
+}
+
+TEST(JsonValueScannerTest, ScanInPieces) {
+  const std::string kObject =
+      "{\"name\": \"a } ] \\\" [ {\", \"args\": {\"list\": [1, [2], {}]}}";
+  const std::string kText = kObject + ", {\"next\": 1}";
+
+  for (size_t piece_size = 1; piece_size <= kText.size(); ++piece_size)
+    EXPECT_EQ(kObject.size(), ScanInPieces(kText, piece_size)) << piece_size;
+}
+
+TEST(JsonValueScannerTest, ScanScalars) {
+  EXPECT_EQ(6U, ScanInPieces("\"a\\\"b\", 1", 1));
+  EXPECT_EQ(5U, ScanInPieces("12345]", 2));
+  // A scalar is complete at the end of the input.
+  EXPECT_EQ(4U, ScanInPieces("true", 3));
+  EXPECT_EQ(3U, ScanInPieces("1.5", 16));
+}
+
+TEST(JsonValueScannerTest, Truncated) {
+  EXPECT_EQ(0U, ScanInPieces("{\"a\": [1, 2]", 4));
+  EXPECT_EQ(0U, ScanInPieces("\"abc", 4));
+  EXPECT_EQ(0U, ScanInPieces("", 4));
+
+  JsonValueScanner scanner;
+  EXPECT_EQ(0U, scanner.Scan(",", 1));
+  EXPECT_TRUE(scanner.error());
+}
+
+}  // namespace json
+}  // namespace parser
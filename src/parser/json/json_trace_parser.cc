@@ -0,0 +1,663 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/json/json_trace_parser.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "base/compressed_file.h"
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+#include "base/string_utils.h"
+#include "event/value.h"
+#include "parser/json/json_tokenizer.h"
+
+namespace parser {
+namespace json {
+
+namespace {
+
+using event::ArrayValue;
+using event::BoolValue;
+using event::DoubleValue;
+using event::Event;
+using event::LongValue;
+using event::StringValue;
+using event::StructValue;
+using event::Timestamp;
+using event::UCharValue;
+using event::ULongValue;
+using event::Value;
+
+const char kTraceEventsKey[] = "traceEvents";
+
+// The UTF-8 byte order mark, which some tools write before the document.
+const char kByteOrderMark[] = "\xEF\xBB\xBF";
+const size_t kByteOrderMarkSize = sizeof(kByteOrderMark) - 1;
+
+// The number of bytes read to recognize a trace.
+const size_t kSniffSize = 4096;
+
+// Returned by PeekCharacter at the end of the file.
+const int kEndOfFile = -1;
+
+// The deepest nesting of the members of an event. Bounds the recursion on
+// a malformed event.
+const size_t kMaxDepth = 64;
+
+const size_t kJsonMinWindowSize = JsonTraceParser::kMinWindowSize;
+
+// A window over a file, moved on demand.
+class DocumentWindow {
+ public:
+  // @param path the path of the file.
+  // @param file_length the length of the file.
+  // @param window_size the size of the window.
+  // @param compressed_file the reader of the file when it is compressed,
+  //     NULL otherwise. Must outlive the window.
+  DocumentWindow(const std::string& path,
+                 uint64 file_length,
+                 size_t window_size,
+                 const base::CompressedFileReader* compressed_file)
+      : path_(path),
+        file_length_(file_length),
+        window_size_(std::max(window_size, kJsonMinWindowSize)),
+        compressed_file_(compressed_file),
+        data_(NULL),
+        length_(0),
+        begin_(0) {
+  }
+
+  // @param offset the offset of a block in the file.
+  // @param min_size the minimal size of the block, in bytes.
+  // @param size receives the number of bytes available from |offset|, at
+  //     least |min_size|.
+  // @returns the block, or NULL if it is past the end of the file or cannot
+  //     be mapped.
+  const char* Get(uint64 offset, size_t min_size, size_t* size) {
+    DCHECK(size != NULL);
+
+    if (data_ != NULL && offset >= begin_ && offset - begin_ <= length_ &&
+        min_size <= length_ - (offset - begin_)) {
+      *size = length_ - static_cast<size_t>(offset - begin_);
+      return data_ + (offset - begin_);
+    }
+    if (offset >= file_length_ || min_size > file_length_ - offset)
+      return NULL;
+
+    uint64 remaining = file_length_ - offset;
+    size_t length = std::max(window_size_, min_size);
+    if (remaining < length)
+      length = static_cast<size_t>(remaining);
+    if (!Load(offset, length) || length_ - (offset - begin_) < min_size) {
+      data_ = NULL;
+      length_ = 0;
+      window_.Close();
+      contents_.clear();
+      return NULL;
+    }
+    *size = length_ - static_cast<size_t>(offset - begin_);
+    return data_ + (offset - begin_);
+  }
+
+ private:
+  // Moves the window over a range of the file. A compressed window starts
+  // at the beginning of a block, at or before |offset|.
+  // @returns true on success, false if the range cannot be read.
+  bool Load(uint64 offset, size_t length) {
+    if (compressed_file_ != NULL) {
+      window_.Close();
+      if (!compressed_file_->ReadBlocks(offset, length, &contents_,
+                                        &begin_) ||
+          contents_.empty()) {
+        return false;
+      }
+      data_ = contents_.data();
+      length_ = contents_.size();
+      return true;
+    }
+
+    if (!window_.OpenRegion(path_, offset, length))
+      return false;
+    begin_ = offset;
+    data_ = window_.data();
+    length_ = window_.length();
+    return true;
+  }
+
+  std::string path_;
+  uint64 file_length_;
+  size_t window_size_;
+  const base::CompressedFileReader* compressed_file_;
+
+  // The window, mapped from the file or decompressed in |contents_|.
+  const char* data_;
+  size_t length_;
+  base::MemoryMappedFile window_;
+  std::string contents_;
+  // The offset of the window in the file.
+  uint64 begin_;
+
+  DISALLOW_COPY_AND_ASSIGN(DocumentWindow);
+};
+
+// Skips the whitespaces.
+// @param window the window over the file.
+// @param position the position in the file, moved to the next character.
+// @returns the next character, or kEndOfFile.
+int PeekCharacter(DocumentWindow* window, uint64* position) {
+  DCHECK(window != NULL);
+  DCHECK(position != NULL);
+
+  for (;;) {
+    size_t size = 0;
+    const char* bytes = window->Get(*position, 1, &size);
+    if (bytes == NULL)
+      return kEndOfFile;
+    for (size_t i = 0; i < size; ++i) {
+      if (!IsJsonWhitespace(bytes[i])) {
+        *position += i;
+        return static_cast<unsigned char>(bytes[i]);
+      }
+    }
+    *position += size;
+  }
+}
+
+// Finds the end of the value at a position.
+// @param window the window over the file.
+// @param position the position of the value, moved past its end.
+// @param data receives the text of the value, mapped in the window. May be
+//     NULL to skip the value without mapping it at once.
+// @param size receives the size of the text of the value, in bytes.
+// @returns true on success, false if the value is truncated.
+bool ScanValue(DocumentWindow* window,
+               uint64* position,
+               const char** data,
+               size_t* size) {
+  DCHECK(window != NULL);
+  DCHECK(position != NULL);
+
+  uint64 begin = *position;
+  uint64 end = begin;
+  JsonValueScanner scanner;
+  while (!scanner.complete()) {
+    size_t available = 0;
+    const char* bytes = window->Get(end, 1, &available);
+    if (bytes == NULL)
+      scanner.Finish();
+    else
+      end += scanner.Scan(bytes, available);
+    if (scanner.error())
+      return false;
+  }
+  *position = end;
+
+  if (data == NULL)
+    return true;
+
+  DCHECK(size != NULL);
+  size_t length = static_cast<size_t>(end - begin);
+  size_t available = 0;
+  *data = window->Get(begin, length, &available);
+  *size = length;
+  return *data != NULL;
+}
+
+// @returns true if a token is a string equal to |literal|.
+template <size_t N>
+bool TokenEquals(const JsonToken& token, const char (&literal)[N]) {
+  return token.type == JSON_TOKEN_STRING && !token.escaped &&
+         token.size == N - 1 && memcmp(token.data, literal, N - 1) == 0;
+}
+
+// Converts microseconds to nanoseconds. The negative times are clamped to
+// zero.
+bool ParseMicroseconds(const JsonToken& token, uint64* nanoseconds) {
+  DCHECK(nanoseconds != NULL);
+
+  JsonNumber number;
+  if (token.type != JSON_TOKEN_NUMBER ||
+      !ParseJsonNumber(token.data, token.size, &number)) {
+    return false;
+  }
+  if (number.type == JSON_NUMBER_UNSIGNED)
+    *nanoseconds = number.unsigned_value * 1000;
+  else if (number.double_value > 0)
+    *nanoseconds = static_cast<uint64>(number.double_value * 1000.0 + 0.5);
+  else
+    *nanoseconds = 0;
+  return true;
+}
+
+// Parses an identifier. A string identifier, which Chrome sometimes writes,
+// is not supported and becomes 0.
+bool ParseIdentifier(const JsonToken& token, uint64* identifier) {
+  DCHECK(identifier != NULL);
+
+  JsonNumber number;
+  if (token.type == JSON_TOKEN_NUMBER &&
+      ParseJsonNumber(token.data, token.size, &number)) {
+    *identifier = number.type == JSON_NUMBER_UNSIGNED ?
+        number.unsigned_value : static_cast<uint64>(number.signed_value);
+    return true;
+  }
+  *identifier = 0;
+  return token.type == JSON_TOKEN_STRING;
+}
+
+// Converts the JSON value starting with |token| to a Value.
+// @param tokenizer the tokenizer of the event.
+// @param token the first token of the value.
+// @param depth the nesting of the value in the event.
+// @param value receives the converted value, or NULL for a null value.
+// @returns true on success, false if the value is malformed.
+bool ConvertValue(JsonTokenizer* tokenizer,
+                  const JsonToken& token,
+                  size_t depth,
+                  scoped_ptr<Value>* value) {
+  DCHECK(tokenizer != NULL);
+  DCHECK(value != NULL);
+
+  if (depth > kMaxDepth)
+    return false;
+
+  switch (token.type) {
+    case JSON_TOKEN_BEGIN_OBJECT: {
+      scoped_ptr<StructValue> object(new StructValue());
+      std::string name;
+      JsonToken key;
+      JsonToken member;
+      for (;;) {
+        if (!tokenizer->Next(&key))
+          return false;
+        if (key.type == JSON_TOKEN_END_OBJECT)
+          break;
+        if (key.type != JSON_TOKEN_STRING || !tokenizer->Next(&member))
+          return false;
+        scoped_ptr<Value> converted;
+        if (!ConvertValue(tokenizer, member, depth + 1, &converted))
+          return false;
+        if (converted.get() == NULL)
+          continue;
+        // A duplicated member keeps its first value.
+        if (!GetJsonString(key, &name))
+          return false;
+        object->AddField(name, converted.Pass());
+      }
+      value->reset(object.release());
+      return true;
+    }
+
+    case JSON_TOKEN_BEGIN_ARRAY: {
+      scoped_ptr<ArrayValue> array(new ArrayValue());
+      JsonToken element;
+      for (;;) {
+        if (!tokenizer->Next(&element))
+          return false;
+        if (element.type == JSON_TOKEN_END_ARRAY)
+          break;
+        scoped_ptr<Value> converted;
+        if (!ConvertValue(tokenizer, element, depth + 1, &converted))
+          return false;
+        if (converted.get() != NULL)
+          array->Append(converted.Pass());
+      }
+      value->reset(array.release());
+      return true;
+    }
+
+    case JSON_TOKEN_STRING: {
+      std::string text;
+      if (!GetJsonString(token, &text))
+        return false;
+      value->reset(new StringValue(text));
+      return true;
+    }
+
+    case JSON_TOKEN_NUMBER: {
+      JsonNumber number;
+      if (!ParseJsonNumber(token.data, token.size, &number))
+        return false;
+      if (number.type == JSON_NUMBER_UNSIGNED)
+        value->reset(new ULongValue(number.unsigned_value));
+      else if (number.type == JSON_NUMBER_SIGNED)
+        value->reset(new LongValue(number.signed_value));
+      else
+        value->reset(new DoubleValue(number.double_value));
+      return true;
+    }
+
+    case JSON_TOKEN_TRUE:
+    case JSON_TOKEN_FALSE:
+      value->reset(new BoolValue(token.type == JSON_TOKEN_TRUE));
+      return true;
+
+    case JSON_TOKEN_NULL:
+      value->reset(NULL);
+      return true;
+
+    default:
+      // A closing token where a value is expected.
+      return false;
+  }
+}
+
+// Decodes the events of a file and sends them to an observer.
+class EventDispatcher {
+ public:
+  explicit EventDispatcher(const base::Observer<Event>& observer)
+      : observer_(observer),
+        invalid_events_(0) {
+  }
+
+  // Decodes an event.
+  // @param data the text of the event object.
+  // @param size the size of the text, in bytes.
+  void Dispatch(const char* data, size_t size);
+
+  // Counts a value of the array of events that is not an object.
+  void Skip() { ++invalid_events_; }
+
+  size_t invalid_events() const { return invalid_events_; }
+
+ private:
+  // @returns true if the event is valid.
+  bool Decode(const char* data, size_t size);
+
+  const base::Observer<Event>& observer_;
+  size_t invalid_events_;
+
+  // Reused for each event.
+  std::string operation_;
+  std::string category_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventDispatcher);
+};
+
+void EventDispatcher::Dispatch(const char* data, size_t size) {
+  if (!Decode(data, size))
+    ++invalid_events_;
+}
+
+bool EventDispatcher::Decode(const char* data, size_t size) {
+  JsonTokenizer tokenizer(data, size);
+  JsonToken token;
+  if (!tokenizer.Next(&token) || token.type != JSON_TOKEN_BEGIN_OBJECT)
+    return false;
+
+  operation_.clear();
+  category_.clear();
+  Timestamp timestamp = 0;
+  uint64 process_id = 0;
+  uint64 thread_id = 0;
+  scoped_ptr<StructValue> content(new StructValue());
+
+  std::string name;
+  JsonToken key;
+  for (;;) {
+    if (!tokenizer.Next(&key))
+      return false;
+    if (key.type == JSON_TOKEN_END_OBJECT)
+      break;
+    if (key.type != JSON_TOKEN_STRING || !tokenizer.Next(&token))
+      return false;
+
+    if (TokenEquals(key, "name") && token.type == JSON_TOKEN_STRING) {
+      if (!GetJsonString(token, &operation_))
+        return false;
+    } else if (TokenEquals(key, "cat") && token.type == JSON_TOKEN_STRING) {
+      if (!GetJsonString(token, &category_))
+        return false;
+    } else if (TokenEquals(key, "ts")) {
+      if (!ParseMicroseconds(token, &timestamp))
+        return false;
+    } else if (TokenEquals(key, "pid")) {
+      if (!ParseIdentifier(token, &process_id))
+        return false;
+    } else if (TokenEquals(key, "tid")) {
+      if (!ParseIdentifier(token, &thread_id))
+        return false;
+    } else if (TokenEquals(key, "dur")) {
+      uint64 duration = 0;
+      if (!ParseMicroseconds(token, &duration))
+        return false;
+      content->AddField<ULongValue>("dur", duration);
+    } else {
+      scoped_ptr<Value> value;
+      if (!ConvertValue(&tokenizer, token, 1, &value))
+        return false;
+      if (value.get() == NULL)
+        continue;
+      if (!GetJsonString(key, &name))
+        return false;
+      content->AddField(name, value.Pass());
+    }
+  }
+
+  // Generate the event header fields.
+  scoped_ptr<StructValue> fields(new StructValue());
+  fields->AddField<StringValue>("operation", operation_);
+  fields->AddField<StringValue>("category", category_);
+  fields->AddField<ULongValue>("process_id", process_id);
+  fields->AddField<ULongValue>("thread_id", thread_id);
+  fields->AddField<UCharValue>("processor_number", 0);
+  fields->AddField("content", content.PassAs<Value>());
+
+  // Create the event with decoded fields and send it to the observer.
+  Event event(timestamp, fields.PassAs<const Value>());
+  observer_.Receive(event);
+  return true;
+}
+
+// Walks the array of events whose opening bracket is at |position|.
+// @returns false if the array is malformed. A missing closing bracket is
+//     accepted.
+bool ParseEventArray(DocumentWindow* window,
+                     uint64* position,
+                     EventDispatcher* dispatcher) {
+  DCHECK(window != NULL);
+  DCHECK(position != NULL);
+  DCHECK(dispatcher != NULL);
+
+  // Skip the opening bracket.
+  ++*position;
+
+  for (;;) {
+    int c = PeekCharacter(window, position);
+    if (c == kEndOfFile)
+      return true;
+    if (c == ']') {
+      ++*position;
+      return true;
+    }
+    if (c == ',') {
+      ++*position;
+      continue;
+    }
+
+    const char* data = NULL;
+    size_t size = 0;
+    if (c != '{') {
+      dispatcher->Skip();
+      if (!ScanValue(window, position, NULL, NULL))
+        return false;
+      continue;
+    }
+    // An object is only malformed when cut by the end of the file, which
+    // ends the array.
+    if (!ScanValue(window, position, &data, &size))
+      return true;
+    dispatcher->Dispatch(data, size);
+  }
+}
+
+// Walks the members of the object at |position|, up to its "traceEvents"
+// array.
+// @returns false if the object is malformed.
+bool ParseTraceObject(DocumentWindow* window,
+                      uint64* position,
+                      EventDispatcher* dispatcher) {
+  DCHECK(window != NULL);
+  DCHECK(position != NULL);
+  DCHECK(dispatcher != NULL);
+
+  // Skip the opening brace.
+  ++*position;
+
+  std::string key;
+  for (;;) {
+    // The end of the file is accepted after a truncated array.
+    int c = PeekCharacter(window, position);
+    if (c == '}' || c == kEndOfFile)
+      return true;
+    if (c == ',') {
+      ++*position;
+      continue;
+    }
+    if (c != '"')
+      return false;
+
+    const char* data = NULL;
+    size_t size = 0;
+    if (!ScanValue(window, position, &data, &size) ||
+        !UnescapeJsonString(data + 1, size - 2, &key) ||
+        PeekCharacter(window, position) != ':') {
+      return false;
+    }
+    ++*position;
+
+    c = PeekCharacter(window, position);
+    if (c == kEndOfFile)
+      return false;
+    if (key == kTraceEventsKey && c == '[') {
+      if (!ParseEventArray(window, position, dispatcher))
+        return false;
+    } else if (!ScanValue(window, position, NULL, NULL)) {
+      return false;
+    }
+  }
+}
+
+// Walks the events of a trace.
+// @param compressed_file the reader of the trace when it is compressed, NULL
+//     otherwise.
+void ParseJsonTrace(const std::string& path,
+                    uint64 file_length,
+                    size_t window_size,
+                    const base::CompressedFileReader* compressed_file,
+                    const base::Observer<Event>& observer) {
+  DocumentWindow window(path, file_length, window_size, compressed_file);
+  EventDispatcher dispatcher(observer);
+
+  uint64 position = 0;
+  size_t size = 0;
+  const char* bytes = window.Get(0, kByteOrderMarkSize, &size);
+  if (bytes != NULL &&
+      memcmp(bytes, kByteOrderMark, kByteOrderMarkSize) == 0) {
+    position = kByteOrderMarkSize;
+  }
+
+  bool valid = false;
+  int c = PeekCharacter(&window, &position);
+  if (c == '[')
+    valid = ParseEventArray(&window, &position, &dispatcher);
+  else if (c == '{')
+    valid = ParseTraceObject(&window, &position, &dispatcher);
+
+  if (!valid)
+    LOG(WARNING) << "The JSON trace " << path << " is malformed.";
+  if (dispatcher.invalid_events() != 0) {
+    LOG(WARNING) << dispatcher.invalid_events()
+                 << " events cannot be decoded.";
+  }
+}
+
+}  // namespace
+
+const size_t JsonTraceParser::kDefaultWindowSize;
+const size_t JsonTraceParser::kMinWindowSize;
+
+bool JsonTraceParser::AddTraceFile(const std::string& path) {
+  if (!base::StringEndsWith(path, ".json"))
+    return false;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  char buffer[kSniffSize];
+  size_t read = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+
+  if (base::IsCompressedFile(buffer, read)) {
+    traces_.push_back(path);
+    return true;
+  }
+
+  size_t position = 0;
+  if (read >= kByteOrderMarkSize &&
+      memcmp(buffer, kByteOrderMark, kByteOrderMarkSize) == 0) {
+    position = kByteOrderMarkSize;
+  }
+  while (position < read && IsJsonWhitespace(buffer[position]))
+    ++position;
+  if (position == read ||
+      (buffer[position] != '{' && buffer[position] != '[')) {
+    return false;
+  }
+
+  traces_.push_back(path);
+  return true;
+}
+
+void JsonTraceParser::Parse(const base::Observer<Event>& observer) {
+  for (size_t i = 0; i < traces_.size(); ++i) {
+    base::MemoryMappedFile file;
+    if (!file.OpenRegion(traces_[i], 0, sizeof(base::CompressedFileHeader))) {
+      LOG(WARNING) << "Unable to read the JSON trace " << traces_[i] << ".";
+      continue;
+    }
+    if (!base::IsCompressedFile(file.data(), file.length())) {
+      ParseJsonTrace(traces_[i], file.file_length(), window_size_, NULL,
+                     observer);
+      continue;
+    }
+
+    // The window decompresses the blocks it overlaps, on all the processors.
+    base::CompressedFileReader compressed_file;
+    if (!compressed_file.Open(traces_[i])) {
+      LOG(WARNING) << "The compressed JSON trace " << traces_[i]
+                   << " is malformed.";
+      continue;
+    }
+    ParseJsonTrace(traces_[i], compressed_file.length(), window_size_,
+                   &compressed_file, observer);
+  }
+}
+
+}  // namespace json
+}  // namespace parser
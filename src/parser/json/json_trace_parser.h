@@ -0,0 +1,106 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PARSER_JSON_JSON_TRACE_PARSER_H_
+#define PARSER_JSON_JSON_TRACE_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/observer.h"
+#include "event/event.h"
+#include "parser/parser.h"
+
+namespace parser {
+namespace json {
+
+// Generate Event objects from the JSON traces of Chrome and Perfetto (the
+// "Trace Event Format"). A trace is either an array of events, or an object
+// with a "traceEvents" array; the other members of the object are skipped.
+// As Chrome writes it, the closing bracket of the array may be missing.
+//
+// The file is walked through a memory-mapped window and each event is
+// tokenized in place: a trace may be larger than the memory, and no document
+// tree is built. The events are sent in the order of the file, with their
+// "ts" converted from microseconds to nanoseconds. A compressed trace (see
+// base/compressed_file.h) keeps its ".json" extension; its window holds the
+// decompressed blocks it overlaps.
+//
+// The header fields of an event are the same as for the ETW events:
+//   operation:         the "name" of the event.
+//   category:          the "cat" of the event.
+//   process_id:        the "pid" of the event.
+//   thread_id:         the "tid" of the event.
+//   processor_number:  0, the format has no processor.
+//   content:           the other members of the event: "ph", "id", "args"...
+//                      The "dur" is converted to nanoseconds. The objects
+//                      are StructValues, the arrays ArrayValues, the
+//                      integers ULongValues or LongValues and the other
+//                      numbers DoubleValues. The null members are dropped.
+class JsonTraceParser : public parser::ParserImpl {
+ public:
+  // The default size of the window over the file, in bytes.
+  static const size_t kDefaultWindowSize = 64 << 20;
+
+  // The minimal size of the window. A larger event is mapped at once.
+  static const size_t kMinWindowSize = 1 << 16;
+
+  // Constuctor.
+  JsonTraceParser()
+      : parser::ParserImpl(),
+        window_size_(kDefaultWindowSize) {
+  }
+
+  // Adds a trace file to the list of traces to parse. The file is recognized
+  // by its ".json" extension and its first character.
+  // @param path path to the trace file.
+  bool AddTraceFile(const std::string& path) OVERRIDE;
+
+  // Parses the trace files added with AddTraceFile() and sends the resulting
+  // events to the provided observer.
+  // @param observer an observer that will receive the decoded events.
+  void Parse(const base::Observer<event::Event>& observer) OVERRIDE;
+
+  // @param window_size the size of the window over the file, at least
+  //     kMinWindowSize.
+  void set_window_size(size_t window_size) {
+    window_size_ = window_size < kMinWindowSize ? kMinWindowSize :
+                                                  window_size;
+  }
+
+ private:
+  // Trace files to consume.
+  std::vector<std::string> traces_;
+
+  size_t window_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonTraceParser);
+};
+
+}  // namespace json
+}  // namespace parser
+
+#endif  // PARSER_JSON_JSON_TRACE_PARSER_H_
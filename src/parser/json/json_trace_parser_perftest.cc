@@ -0,0 +1,90 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/json/json_trace_parser.h"
+
+#include <cstdio>
+#include <string>
+
+#include "base/observer.h"
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace json {
+
+namespace {
+
+const char kTempFile[] = "json_trace_parser_perftest.json";
+const size_t kEvents = 200000;
+
+class EventCounter {
+ public:
+  EventCounter() : count_(0) {}
+
+  void Receive(const event::Event& /* event */) { ++count_; }
+
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_;
+};
+
+}  // namespace
+
+TEST(JsonTraceParserPerfTest, ParseEvents) {
+  {
+    FILE* file = fopen(kTempFile, "wb");
+    ASSERT_TRUE(file != NULL);
+    fputs("{\"traceEvents\":[\n", file);
+    for (size_t i = 0; i < kEvents; ++i) {
+      fprintf(file,
+              "%s{\"name\":\"ThreadControllerImpl::RunTask\","
+              "\"cat\":\"toplevel\",\"ph\":\"X\",\"ts\":%u.125,"
+              "\"dur\":%u,\"pid\":%u,\"tid\":%u,\"tts\":%u,"
+              "\"args\":{\"src_file\":\"../../base/task/sequence_manager/"
+              "task_queue_impl.cc\",\"src_func\":\"PostDelayedTask\"}}",
+              i == 0 ? "" : ",\n", static_cast<unsigned>(i * 10),
+              static_cast<unsigned>(i % 97), static_cast<unsigned>(i % 7),
+              static_cast<unsigned>(i % 31), static_cast<unsigned>(i * 3));
+    }
+    fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+    fclose(file);
+  }
+
+  EventCounter counter;
+  base::PerfTimer timer;
+  JsonTraceParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  parser.Parse(base::MakeObserver(&counter, &EventCounter::Receive));
+  base::PrintPerfResult("ParseEvents", "time", timer.ElapsedNanoseconds(),
+                        kEvents, "ns/event");
+
+  std::remove(kTempFile);
+  EXPECT_EQ(kEvents, counter.count());
+}
+
+}  // namespace json
+}  // namespace parser
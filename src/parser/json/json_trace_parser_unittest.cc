@@ -0,0 +1,302 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/json/json_trace_parser.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "base/compressed_file.h"
+#include "base/observer.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+
+namespace parser {
+namespace json {
+
+namespace {
+
+using event::ArrayValue;
+using event::StructValue;
+
+const char kTempFile[] = "json_trace_parser_unittest.json";
+
+// Keeps the header fields of the received events.
+struct ReceivedEvent {
+  uint64 timestamp;
+  std::string operation;
+  std::string category;
+  uint64 process_id;
+  uint64 thread_id;
+  uint32 processor_number;
+  std::string phase;
+};
+
+class EventCollector {
+ public:
+  void Receive(const event::Event& event) {
+    const StructValue* fields = StructValue::Cast(event.payload());
+    ASSERT_TRUE(fields != NULL);
+
+    ReceivedEvent received = {};
+    received.timestamp = event.timestamp();
+    const StructValue* content = NULL;
+    ASSERT_TRUE(fields->GetFieldAsString("operation", &received.operation));
+    ASSERT_TRUE(fields->GetFieldAsString("category", &received.category));
+    ASSERT_TRUE(fields->GetFieldAsULong("process_id", &received.process_id));
+    ASSERT_TRUE(fields->GetFieldAsULong("thread_id", &received.thread_id));
+    ASSERT_TRUE(fields->GetFieldAsUInteger("processor_number",
+                                           &received.processor_number));
+    ASSERT_TRUE(fields->GetFieldAs<StructValue>("content", &content));
+    content->GetFieldAsString("ph", &received.phase);
+    events.push_back(received);
+
+    if (received.operation == "MessageLoop::RunTask")
+      CheckTaskContent(content);
+  }
+
+  std::vector<ReceivedEvent> events;
+
+ private:
+  // Checks the content of the task of the ParseArray test.
+  void CheckTaskContent(const StructValue* content);
+};
+
+void EventCollector::CheckTaskContent(const StructValue* content) {
+  uint64 duration = 0;
+  EXPECT_TRUE(content->GetFieldAsULong("dur", &duration));
+  EXPECT_EQ(12250U, duration);
+  std::string id;
+  EXPECT_TRUE(content->GetFieldAsString("id", &id));
+  EXPECT_EQ("0x10", id);
+
+  const StructValue* args = NULL;
+  ASSERT_TRUE(content->GetFieldAs<StructValue>("args", &args));
+  std::string src;
+  EXPECT_TRUE(args->GetFieldAsString("src", &src));
+  EXPECT_EQ("a\"b\xC3\xA9", src);
+  int64 line = 0;
+  EXPECT_TRUE(args->GetFieldAsLong("line", &line));
+  EXPECT_EQ(-3, line);
+  double ratio = 0;
+  EXPECT_TRUE(args->GetFieldAsFloating("ratio", &ratio));
+  EXPECT_DOUBLE_EQ(0.5, ratio);
+  const event::Value* field = NULL;
+  ASSERT_TRUE(args->GetField("ok", &field));
+  EXPECT_TRUE(event::BoolValue::GetValue(field));
+  EXPECT_FALSE(args->GetField("none", &field));
+  const ArrayValue* list = NULL;
+  ASSERT_TRUE(args->GetFieldAs<ArrayValue>("list", &list));
+  EXPECT_EQ(2U, list->Length());
+  const StructValue* nested = NULL;
+  ASSERT_TRUE(args->GetFieldAs<StructValue>("nested", &nested));
+  uint64 depth = 0;
+  EXPECT_TRUE(nested->GetFieldAsULong("depth", &depth));
+  EXPECT_EQ(2U, depth);
+}
+
+class JsonTraceParserTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  void WriteTrace(const std::string& text) {
+    FILE* file = fopen(kTempFile, "wb");
+    ASSERT_TRUE(file != NULL);
+    ASSERT_EQ(text.size(), fwrite(text.data(), 1, text.size(), file));
+    fclose(file);
+  }
+
+  void Parse(size_t window_size) {
+    JsonTraceParser parser;
+    parser.set_window_size(window_size);
+    ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+    parser.Parse(base::MakeObserver(&collector_, &EventCollector::Receive));
+  }
+
+  EventCollector collector_;
+};
+
+std::string MakeEvent(size_t index) {
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer),
+           "{\"name\":\"Task%u\",\"cat\":\"toplevel\",\"ph\":\"X\","
+           "\"ts\":%u.5,\"dur\":2,\"pid\":7,\"tid\":%u,"
+           "\"args\":{\"src\":\"task_queue.cc\",\"index\":%u}}",
+           static_cast<unsigned>(index), static_cast<unsigned>(index),
+           static_cast<unsigned>(index % 16), static_cast<unsigned>(index));
+  return buffer;
+}
+
+}  // namespace
+
+TEST_F(JsonTraceParserTest, AddTraceFile) {
+  JsonTraceParser parser;
+
+  WriteTrace("  \n[]");
+  EXPECT_TRUE(parser.AddTraceFile(kTempFile));
+  WriteTrace("\xEF\xBB\xBF{\"traceEvents\":[]}");
+  EXPECT_TRUE(parser.AddTraceFile(kTempFile));
+
+  WriteTrace("PERFILE2");
+  EXPECT_FALSE(parser.AddTraceFile(kTempFile));
+  WriteTrace("");
+  EXPECT_FALSE(parser.AddTraceFile(kTempFile));
+
+  // The extension is required.
+  EXPECT_FALSE(parser.AddTraceFile("trace.dat"));
+  EXPECT_FALSE(parser.AddTraceFile("missing.json"));
+}
+
+TEST_F(JsonTraceParserTest, ParseArray) {
+  WriteTrace(
+      "[{\"name\":\"MessageLoop::RunTask\",\"cat\":\"toplevel\",\"ph\":\"X\","
+      "\"ts\":1234.5678,\"dur\":12.25,\"pid\":42,\"tid\":7,\"id\":\"0x10\","
+      "\"args\":{\"src\":\"a\\\"b\\u00e9\",\"line\":-3,\"ratio\":0.5,"
+      "\"ok\":true,\"none\":null,\"list\":[1,null,\"x\"],"
+      "\"nested\":{\"depth\":2}}},\n"
+      " {\"name\":\"process_name\",\"ph\":\"M\",\"pid\":42,"
+      "\"args\":{\"name\":\"Renderer\"}}\n"
+      "]");
+  Parse(JsonTraceParser::kMinWindowSize);
+
+  ASSERT_EQ(2U, collector_.events.size());
+  const ReceivedEvent& task = collector_.events[0];
+  EXPECT_EQ(1234568U, task.timestamp);
+  EXPECT_EQ("MessageLoop::RunTask", task.operation);
+  EXPECT_EQ("toplevel", task.category);
+  EXPECT_EQ(42U, task.process_id);
+  EXPECT_EQ(7U, task.thread_id);
+  EXPECT_EQ(0U, task.processor_number);
+  EXPECT_EQ("X", task.phase);
+
+  const ReceivedEvent& metadata = collector_.events[1];
+  EXPECT_EQ(0U, metadata.timestamp);
+  EXPECT_EQ("process_name", metadata.operation);
+  EXPECT_EQ("", metadata.category);
+  EXPECT_EQ("M", metadata.phase);
+}
+
+TEST_F(JsonTraceParserTest, ParseObject) {
+  // The members other than the events are skipped, before and after them.
+  WriteTrace(
+      "{\"metadata\":{\"trace\":[\"]\",{}]},\"systemTraceEvents\":\"a\\\"[\","
+      "\"traceEvents\":[" + MakeEvent(0) + "," + MakeEvent(1) + "],"
+      "\"displayTimeUnit\":\"ns\",\"samples\":[1,2,3]}");
+  Parse(JsonTraceParser::kMinWindowSize);
+
+  ASSERT_EQ(2U, collector_.events.size());
+  EXPECT_EQ("Task0", collector_.events[0].operation);
+  EXPECT_EQ(500U, collector_.events[0].timestamp);
+  EXPECT_EQ("Task1", collector_.events[1].operation);
+  EXPECT_EQ(1500U, collector_.events[1].timestamp);
+}
+
+TEST_F(JsonTraceParserTest, ParseWindows) {
+  // The events straddle the windows, and one event is larger than a window.
+  const size_t kEvents = 5000;
+  std::string text = "[";
+  for (size_t i = 0; i < kEvents; ++i) {
+    if (i == kEvents / 2) {
+      text += "{\"name\":\"Large\",\"args\":{\"data\":\"" +
+              std::string(3 * JsonTraceParser::kMinWindowSize, 'x') +
+              "\"}},\n";
+    }
+    text += MakeEvent(i) + ",\n";
+  }
+  text += "{}]";
+  WriteTrace(text);
+  Parse(JsonTraceParser::kMinWindowSize);
+
+  ASSERT_EQ(kEvents + 2, collector_.events.size());
+  EXPECT_EQ("Large", collector_.events[kEvents / 2].operation);
+  size_t index = 0;
+  for (size_t i = 0; i < kEvents + 1; ++i) {
+    if (i == kEvents / 2)
+      continue;
+    char name[32];
+    snprintf(name, sizeof(name), "Task%u", static_cast<unsigned>(index));
+    ASSERT_EQ(name, collector_.events[i].operation);
+    EXPECT_EQ(index * 1000 + 500, collector_.events[i].timestamp);
+    EXPECT_EQ(index % 16, collector_.events[i].thread_id);
+    ++index;
+  }
+}
+
+TEST_F(JsonTraceParserTest, ParseCompressed) {
+  // The windows don't start on the blocks, and an event is larger than a
+  // window.
+  const size_t kEvents = 5000;
+  std::string text = "[";
+  for (size_t i = 0; i < kEvents; ++i) {
+    if (i == kEvents / 2) {
+      text += "{\"name\":\"Large\",\"args\":{\"data\":\"" +
+              std::string(3 * JsonTraceParser::kMinWindowSize, 'x') +
+              "\"}},\n";
+    }
+    text += MakeEvent(i) + ",\n";
+  }
+  text += "{}]";
+  {
+    std::ofstream file(kTempFile, std::ios::binary);
+    base::CompressingStreamBuffer buffer(&file, 10000);
+    std::ostream out(&buffer);
+    out << text;
+    ASSERT_TRUE(buffer.Finish());
+  }
+  Parse(JsonTraceParser::kMinWindowSize);
+
+  ASSERT_EQ(kEvents + 2, collector_.events.size());
+  EXPECT_EQ("Large", collector_.events[kEvents / 2].operation);
+  EXPECT_EQ("Task0", collector_.events[0].operation);
+  EXPECT_EQ("Task4999", collector_.events[kEvents].operation);
+  EXPECT_EQ(4999500U, collector_.events[kEvents].timestamp);
+}
+
+TEST_F(JsonTraceParserTest, ParseTruncated) {
+  // Chrome may not close the array: the event cut by the end of the file is
+  // dropped.
+  WriteTrace("[" + MakeEvent(0) + ",\n" + MakeEvent(1) + ",\n{\"name\":\"Cu");
+  Parse(JsonTraceParser::kMinWindowSize);
+
+  ASSERT_EQ(2U, collector_.events.size());
+  EXPECT_EQ("Task1", collector_.events[1].operation);
+}
+
+TEST_F(JsonTraceParserTest, SkipInvalidEvents) {
+  WriteTrace(
+      "[1, \"text\", {\"name\":\"BadTimestamp\",\"ts\":\"now\"},"
+      "{\"name\":\"BadArgs\",\"args\":{\"a\" 01}}," + MakeEvent(3) + "]");
+  Parse(JsonTraceParser::kMinWindowSize);
+
+  ASSERT_EQ(1U, collector_.events.size());
+  EXPECT_EQ("Task3", collector_.events[0].operation);
+}
+
+}  // namespace json
+}  // namespace parser
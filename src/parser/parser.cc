@@ -25,7 +25,10 @@
 
 #include "parser/parser.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
+#include "parser/trace_stats.h"
 
 namespace parser {
 
@@ -35,14 +38,20 @@ Parser::~Parser() {
 }
 
 void Parser::RegisterParser(scoped_ptr<ParserImpl> parser) {
+  parser->set_stack_table(stack_table_);
   parsers_.push_back(parser.release());
 }
 
 bool Parser::AddTraceFile(const std::string& path) {
   ParserList::iterator parser = parsers_.begin();
   for (; parser != parsers_.end(); ++parser) {
-    if ((*parser)->AddTraceFile(path))
+    if ((*parser)->AddTraceFile(path)) {
+      if (std::find(active_parsers_.begin(), active_parsers_.end(),
+                    *parser) == active_parsers_.end()) {
+        active_parsers_.push_back(*parser);
+      }
       return true;
+    }
   }
   return false;
 }
@@ -57,4 +66,22 @@ void Parser::Parse(const base::Observer<event::Event>& observer) {
   }
 }
 
+bool Parser::CollectStats(TraceStats* stats) {
+  DCHECK(stats != NULL);
+
+  ParserList::iterator parser = active_parsers_.begin();
+  for (; parser != active_parsers_.end(); ++parser) {
+    if (!(*parser)->CollectStats(stats))
+      return false;
+  }
+  return true;
+}
+
+void Parser::set_stack_table(event::StackTable* stack_table) {
+  stack_table_ = stack_table;
+  ParserList::iterator parser = parsers_.begin();
+  for (; parser != parsers_.end(); ++parser)
+    (*parser)->set_stack_table(stack_table);
+}
+
 }  // namespace parser
@@ -54,10 +54,15 @@
 #include "base/observer.h"
 #include "event/event.h"
 
+namespace event {
+class StackTable;
+}  // namespace event
+
 namespace parser {
 
-// Forward declaration.
+// Forward declarations.
 class ParserImpl;
+struct TraceStats;
 
 // The trace files parser.
 class Parser {
@@ -65,7 +70,7 @@ class Parser {
   typedef std::list<ParserImpl*> ParserList;
 
   // Constructor.
-  Parser() { }
+  Parser() : stack_table_(NULL) { }
 
   // Destructor.
   ~Parser();
@@ -84,15 +89,36 @@ class Parser {
   // @param observer an observer that will receive the decoded events.
   void Parse(const base::Observer<event::Event>& observer);
 
+  // Summarizes the trace files added with AddTraceFile() from their event
+  // headers, without decoding the payloads.
+  // @param stats receives the statistics of the trace files.
+  // @returns true on success, false if a trace file has a format without a
+  //     header-only pass.
+  bool CollectStats(TraceStats* stats);
+
+  // Interns the call stacks of the decoded events into |stack_table|. The
+  // events then carry a "StackId" field instead of a "Stack" array of frames.
+  // Applies to the registered parsers and to the ones registered later.
+  // @param stack_table the table receiving the stacks, or NULL (the default)
+  //     to decode the frames. Not owned, must outlive the parsing.
+  void set_stack_table(event::StackTable* stack_table);
+
  private:
   ParserList parsers_;
 
+  // The table interning the call stacks. Not owned. May be NULL.
+  event::StackTable* stack_table_;
+
+  // The parsers that accepted a trace file.
+  ParserList active_parsers_;
+
   DISALLOW_COPY_AND_ASSIGN(Parser);
 };
 
 // A parser implementation for a specific file format.
 class ParserImpl {
  public:
+  ParserImpl() : stack_table_(NULL) { }
    virtual ~ParserImpl() { }
 
   // Adds a trace file to the list of traces to parse.
@@ -104,6 +130,25 @@ class ParserImpl {
   // events to the provided observer.
   // @param observer an observer that will receive the decoded events.
   virtual void Parse(const base::Observer<event::Event>& observer) = 0;
+
+  // Summarizes the trace files added with AddTraceFile() from their event
+  // headers, without decoding the payloads. The formats without such a pass
+  // keep the default implementation.
+  // @param stats receives the statistics of the trace files.
+  // @returns true on success, false if the format has no header-only pass.
+  virtual bool CollectStats(TraceStats* /* stats */) { return false; }
+
+  // The table interning the call stacks of the decoded events. The formats
+  // without call stacks ignore it. Not owned. May be NULL.
+  // @{
+  event::StackTable* stack_table() const { return stack_table_; }
+  void set_stack_table(event::StackTable* stack_table) {
+    stack_table_ = stack_table;
+  }
+  // @}
+
+ private:
+  event::StackTable* stack_table_;
 };
 
 }  // namespace parser
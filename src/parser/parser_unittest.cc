@@ -27,6 +27,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "parser/trace_stats.h"
 
 namespace parser {
 
@@ -40,6 +41,7 @@ class MockParser : public parser::ParserImpl {
  public:
   MOCK_METHOD1(AddTraceFile, bool(const std::string&));
   MOCK_METHOD1(Parse, void(const base::Observer<event::Event>& observer));
+  MOCK_METHOD1(CollectStats, bool(TraceStats* stats));
 };
 
 class MockObserver : public base::Observer<event::Event> {
@@ -71,4 +73,31 @@ TEST(ParserTest, Parse) {
   parser.Parse(observer);
 }
 
+TEST(ParserTest, CollectStats) {
+  parser::Parser parser;
+  TraceStats stats;
+
+  scoped_ptr<MockParser> unused(new MockParser());
+  scoped_ptr<MockParser> impl(new MockParser());
+  std::string filename("dummy");
+
+  // Only the parsers with trace files are asked for their statistics.
+  EXPECT_CALL(*unused.get(), AddTraceFile(Ref(filename)))
+     .WillRepeatedly(Return(false));
+  EXPECT_CALL(*unused.get(), CollectStats(_)).Times(0);
+  EXPECT_CALL(*impl.get(), AddTraceFile(Ref(filename)))
+     .WillRepeatedly(Return(true));
+  EXPECT_CALL(*impl.get(), CollectStats(&stats))
+     .WillOnce(Return(true))
+     .WillOnce(Return(false));
+
+  parser.RegisterParser(unused.PassAs<parser::ParserImpl>());
+  parser.RegisterParser(impl.PassAs<parser::ParserImpl>());
+  EXPECT_TRUE(parser.AddTraceFile(filename));
+  EXPECT_TRUE(parser.AddTraceFile(filename));
+
+  EXPECT_TRUE(parser.CollectStats(&stats));
+  EXPECT_FALSE(parser.CollectStats(&stats));
+}
+
 }  // namespace parser
@@ -0,0 +1,224 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+// The magic of the files written by big-endian systems.
+const char kPerfDataSwappedMagic[] = "2ELIFREP";
+
+// The offsets of the fields of a perf_event_attr.
+// @{
+const size_t kAttrTypeOffset = 0;
+const size_t kAttrConfigOffset = 8;
+const size_t kAttrSampleTypeOffset = 24;
+const size_t kAttrReadFormatOffset = 32;
+const size_t kAttrFlagsOffset = 40;
+// The size of the first version of perf_event_attr.
+const size_t kAttrSizeVersion0 = 64;
+// @}
+
+const uint64 kAttrFlagSampleIdAll = 1ULL << 18;
+
+// Bounds the number of identifiers of an event.
+const uint64 kMaxIdsPerEvent = 1 << 20;
+
+template <typename T>
+T ReadAt(const char* data, size_t offset) {
+  T value;
+  memcpy(&value, data + offset, sizeof(value));
+  return value;
+}
+
+// Maps a section of a file.
+// @returns true if the whole section is mapped.
+bool MapSection(const std::string& path,
+                const PerfFileSection& section,
+                base::MemoryMappedFile* file) {
+  DCHECK(file != NULL);
+  if (section.size > static_cast<size_t>(-1))
+    return false;
+  size_t size = static_cast<size_t>(section.size);
+  return file->OpenRegion(path, section.offset, size) &&
+         file->length() == size;
+}
+
+bool HasFeature(const PerfFileHeader& header, size_t feature) {
+  DCHECK_LT(feature, kPerfFeatureCount);
+  return (header.features[feature / 64] & (1ULL << (feature % 64))) != 0;
+}
+
+}  // namespace
+
+const char kPerfDataMagic[] = "PERFILE2";
+
+PerfDataFile::PerfDataFile() {
+  data_section_.offset = 0;
+  data_section_.size = 0;
+}
+
+bool PerfDataFile::HasMagic(const char* data, size_t length) {
+  return length >= kPerfDataMagicSize &&
+         memcmp(data, kPerfDataMagic, kPerfDataMagicSize) == 0;
+}
+
+bool PerfDataFile::Open(const std::string& path) {
+  attrs_.clear();
+  id_index_.clear();
+  tracing_data_.reset(NULL);
+
+  base::MemoryMappedFile file;
+  if (!file.OpenRegion(path, 0, sizeof(PerfFileHeader)))
+    return false;
+  if (file.length() >= kPerfDataMagicSize &&
+      memcmp(file.data(), kPerfDataSwappedMagic, kPerfDataMagicSize) == 0) {
+    LOG(WARNING) << "Big-endian perf.data files are not supported.";
+    return false;
+  }
+  if (!HasMagic(file.data(), file.length()))
+    return false;
+
+  // A file written to a pipe has a short header.
+  PerfFileHeader header;
+  if (file.length() < sizeof(header) ||
+      ReadAt<uint64>(file.data(), kPerfDataMagicSize) != sizeof(header)) {
+    LOG(WARNING) << "Pipe-mode perf.data files are not supported.";
+    return false;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+
+  uint64 file_length = file.file_length();
+  if (header.data.offset > file_length ||
+      header.data.size > file_length - header.data.offset) {
+    return false;
+  }
+  data_section_ = header.data;
+
+  if (!ReadAttrs(path, header))
+    return false;
+  ReadTracingData(path, header);
+  return true;
+}
+
+const PerfEventAttr* PerfDataFile::FindAttr(uint64 id) const {
+  std::vector<std::pair<uint64, size_t> >::const_iterator it =
+      std::lower_bound(id_index_.begin(), id_index_.end(),
+                       std::make_pair(id, static_cast<size_t>(0)));
+  if (it == id_index_.end() || it->first != id)
+    return NULL;
+  return &attrs_[it->second];
+}
+
+bool PerfDataFile::ReadAttrs(const std::string& path,
+                             const PerfFileHeader& header) {
+  // Each entry holds a perf_event_attr followed by the section of its
+  // identifiers.
+  if (header.attr_size < kAttrSizeVersion0 + sizeof(PerfFileSection))
+    return false;
+  uint64 count = header.attrs.size / header.attr_size;
+  if (count == 0)
+    return false;
+
+  base::MemoryMappedFile file;
+  if (!MapSection(path, header.attrs, &file))
+    return false;
+
+  attrs_.resize(static_cast<size_t>(count));
+  size_t entry_size = static_cast<size_t>(header.attr_size);
+  for (size_t i = 0; i < attrs_.size(); ++i) {
+    const char* entry = file.data() + i * entry_size;
+    PerfEventAttr& attr = attrs_[i];
+    attr.type = ReadAt<uint32>(entry, kAttrTypeOffset);
+    attr.config = ReadAt<uint64>(entry, kAttrConfigOffset);
+    attr.sample_type = ReadAt<uint64>(entry, kAttrSampleTypeOffset);
+    attr.read_format = ReadAt<uint64>(entry, kAttrReadFormatOffset);
+    attr.sample_id_all =
+        (ReadAt<uint64>(entry, kAttrFlagsOffset) & kAttrFlagSampleIdAll) != 0;
+
+    PerfFileSection ids = ReadAt<PerfFileSection>(
+        entry, entry_size - sizeof(PerfFileSection));
+    if (ids.size == 0)
+      continue;
+    base::MemoryMappedFile ids_file;
+    if (ids.size % sizeof(uint64) != 0 ||
+        ids.size / sizeof(uint64) > kMaxIdsPerEvent ||
+        !MapSection(path, ids, &ids_file)) {
+      return false;
+    }
+    attr.ids.resize(static_cast<size_t>(ids.size / sizeof(uint64)));
+    if (attr.ids.empty())
+      continue;
+    memcpy(&attr.ids[0], ids_file.data(), attr.ids.size() * sizeof(uint64));
+    for (size_t j = 0; j < attr.ids.size(); ++j)
+      id_index_.push_back(std::make_pair(attr.ids[j], i));
+  }
+
+  std::sort(id_index_.begin(), id_index_.end());
+  return true;
+}
+
+void PerfDataFile::ReadTracingData(const std::string& path,
+                                   const PerfFileHeader& header) {
+  if (!HasFeature(header, kPerfFeatureTracingData))
+    return;
+
+  // The feature sections follow the data, in the order of the bits.
+  uint64 index = 0;
+  for (size_t feature = 0; feature < kPerfFeatureTracingData; ++feature) {
+    if (HasFeature(header, feature))
+      ++index;
+  }
+  PerfFileSection table = {
+      header.data.offset + header.data.size + index * sizeof(PerfFileSection),
+      sizeof(PerfFileSection) };
+
+  base::MemoryMappedFile file;
+  if (!MapSection(path, table, &file)) {
+    LOG(WARNING) << "The perf.data file has no feature sections.";
+    return;
+  }
+  PerfFileSection section = ReadAt<PerfFileSection>(file.data(), 0);
+
+  scoped_ptr<ftrace::TraceDatFile> tracing_data(new ftrace::TraceDatFile());
+  if (!MapSection(path, section, &file) ||
+      !tracing_data->ParseTracingData(file.data(), file.length())) {
+    LOG(WARNING) << "Unable to parse the tracing data of the perf.data file.";
+    return;
+  }
+  tracing_data_.reset(tracing_data.release());
+}
+
+}  // namespace perf
+}  // namespace parser
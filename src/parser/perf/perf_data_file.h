@@ -0,0 +1,167 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Reads the metadata of a perf.data file written by "perf record":
+//
+//   header:    "PERFILE2" <size:8> <attr_size:8> <attrs> <data> <event_types>
+//              <feature bits:32>
+//   attrs:     { <perf_event_attr> <ids> } per event, of attr_size bytes
+//   data:      the records, see perf_record.h
+//   features:  after the data, a section per feature bit set
+//
+// where each section is an <offset:8> <size:8> pair. Only the metadata are
+// read: the data section may be larger than the memory and is left to the
+// caller. Only little-endian files are supported, and not the pipe mode.
+//
+// Usage example:
+//   PerfDataFile file;
+//   if (!file.Open("perf.data"))
+//     return false;
+//   WalkRecords(file.data_section());
+
+#ifndef PARSER_PERF_PERF_DATA_FILE_H_
+#define PARSER_PERF_PERF_DATA_FILE_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/base.h"
+#include "base/scoped_ptr.h"
+#include "parser/ftrace/trace_dat_file.h"
+
+namespace parser {
+namespace perf {
+
+// The first bytes of a perf.data file.
+extern const char kPerfDataMagic[];
+const size_t kPerfDataMagicSize = 8;
+
+#pragma pack(push, 1)
+struct PerfFileSection {
+  uint64 offset;
+  uint64 size;
+};
+
+struct PerfFileHeader {
+  char magic[kPerfDataMagicSize];
+  uint64 size;
+  uint64 attr_size;
+  PerfFileSection attrs;
+  PerfFileSection data;
+  PerfFileSection event_types;
+  uint64 features[4];
+};
+#pragma pack(pop)
+
+COMPILE_ASSERT(sizeof(PerfFileHeader) == 104, perf_file_header_size);
+
+// The types of the events.
+// @{
+const uint32 kPerfTypeHardware = 0;
+const uint32 kPerfTypeSoftware = 1;
+const uint32 kPerfTypeTracepoint = 2;
+// @}
+
+// The feature sections.
+// @{
+const size_t kPerfFeatureTracingData = 1;
+const size_t kPerfFeatureCount = 256;
+// @}
+
+// The attributes of an event, from its perf_event_attr.
+struct PerfEventAttr {
+  PerfEventAttr()
+      : type(0),
+        config(0),
+        sample_type(0),
+        read_format(0),
+        sample_id_all(false) {
+  }
+
+  uint32 type;
+  // The identifier of the tracepoint, for a tracepoint event.
+  uint64 config;
+  uint64 sample_type;
+  uint64 read_format;
+  // Indicates whether the records end with a sample id.
+  bool sample_id_all;
+  // The identifiers of the event, one per CPU or thread.
+  std::vector<uint64> ids;
+};
+
+class PerfDataFile {
+ public:
+  PerfDataFile();
+
+  // Reads the metadata of a file.
+  // @param path the path of the file.
+  // @returns true on success, false if the file is malformed or
+  //     unsupported.
+  bool Open(const std::string& path);
+
+  // @param data the first bytes of a file.
+  // @param length the number of bytes of |data|.
+  // @returns true if |data| starts with the magic of a perf.data file.
+  static bool HasMagic(const char* data, size_t length);
+
+  // @returns the data section, within the file.
+  const PerfFileSection& data_section() const { return data_section_; }
+
+  // @returns the attributes of the events.
+  const std::vector<PerfEventAttr>& attrs() const { return attrs_; }
+
+  // @param id the identifier of an event.
+  // @returns the attributes of the event |id|, or NULL if it is unknown.
+  const PerfEventAttr* FindAttr(uint64 id) const;
+
+  // @returns the formats of the tracepoints, or NULL if the file has no
+  //     tracing data.
+  const ftrace::TraceDatFile* tracing_data() const {
+    return tracing_data_.get();
+  }
+
+ private:
+  // Reads the attributes of the events and their identifiers.
+  bool ReadAttrs(const std::string& path, const PerfFileHeader& header);
+
+  // Reads the tracing data feature, if present.
+  void ReadTracingData(const std::string& path, const PerfFileHeader& header);
+
+  PerfFileSection data_section_;
+  std::vector<PerfEventAttr> attrs_;
+  scoped_ptr<ftrace::TraceDatFile> tracing_data_;
+
+  // The index in |attrs_| of each event identifier, sorted by identifier.
+  std::vector<std::pair<uint64, size_t> > id_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfDataFile);
+};
+
+}  // namespace perf
+}  // namespace parser
+
+#endif  // PARSER_PERF_PERF_DATA_FILE_H_
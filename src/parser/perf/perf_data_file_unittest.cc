@@ -0,0 +1,174 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "parser/ftrace/trace_dat_test_utils.h"
+#include "parser/perf/perf_data_test_utils.h"
+#include "parser/perf/perf_record.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+const char kTempFile[] = "perf_data_file_unittest.data";
+
+const uint64 kSampleType = kPerfSampleIp | kPerfSampleTid | kPerfSampleId;
+
+class PerfDataFileTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  void WriteTempFile(const std::string& content) {
+    FILE* file = fopen(kTempFile, "wb");
+    ASSERT_TRUE(file != NULL);
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+  }
+};
+
+}  // namespace
+
+TEST_F(PerfDataFileTest, HasMagic) {
+  EXPECT_TRUE(PerfDataFile::HasMagic("PERFILE2", 8));
+  EXPECT_FALSE(PerfDataFile::HasMagic("PERFILE2", 7));
+  EXPECT_FALSE(PerfDataFile::HasMagic("2ELIFREP", 8));
+}
+
+TEST_F(PerfDataFileTest, Open) {
+  std::vector<uint64> cycles_ids;
+  cycles_ids.push_back(10);
+  cycles_ids.push_back(11);
+  std::vector<uint64> tracepoint_ids;
+  tracepoint_ids.push_back(20);
+
+  ftrace::TraceDatBuilder tracing_data(1);
+  tracing_data.AddFormat("sched", ftrace::kTestSchedSwitchFormat);
+
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeHardware, 0, kSampleType, cycles_ids);
+  builder.AddAttr(kPerfTypeTracepoint, ftrace::kTestSchedSwitchId,
+                  kSampleType | kPerfSampleRaw, tracepoint_ids);
+  builder.set_tracing_data(tracing_data.BuildTracingData());
+  builder.AddRecord(kPerfRecordComm, 0, "record");
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  PerfDataFile file;
+  ASSERT_TRUE(file.Open(kTempFile));
+
+  EXPECT_EQ(16U, file.data_section().size);
+  ASSERT_EQ(2U, file.attrs().size());
+  const PerfEventAttr& cycles = file.attrs()[0];
+  EXPECT_EQ(kPerfTypeHardware, cycles.type);
+  EXPECT_EQ(kSampleType, cycles.sample_type);
+  EXPECT_TRUE(cycles.sample_id_all);
+  EXPECT_EQ(cycles_ids, cycles.ids);
+  const PerfEventAttr& tracepoint = file.attrs()[1];
+  EXPECT_EQ(kPerfTypeTracepoint, tracepoint.type);
+  EXPECT_EQ(ftrace::kTestSchedSwitchId, tracepoint.config);
+
+  EXPECT_EQ(&cycles, file.FindAttr(10));
+  EXPECT_EQ(&cycles, file.FindAttr(11));
+  EXPECT_EQ(&tracepoint, file.FindAttr(20));
+  EXPECT_TRUE(file.FindAttr(12) == NULL);
+
+  ASSERT_TRUE(file.tracing_data() != NULL);
+  EXPECT_TRUE(
+      file.tracing_data()->FindFormat(ftrace::kTestSchedSwitchId) != NULL);
+}
+
+TEST_F(PerfDataFileTest, OpenWithoutTracingData) {
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeSoftware, 0, kSampleType, std::vector<uint64>());
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  PerfDataFile file;
+  ASSERT_TRUE(file.Open(kTempFile));
+  EXPECT_EQ(1U, file.attrs().size());
+  EXPECT_EQ(0U, file.data_section().size);
+  EXPECT_TRUE(file.tracing_data() == NULL);
+}
+
+TEST_F(PerfDataFileTest, OpenUnsupported) {
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeSoftware, 0, kSampleType, std::vector<uint64>());
+  std::string data = builder.Build();
+
+  PerfDataFile file;
+  EXPECT_FALSE(file.Open("perf_data_file_unittest.missing"));
+
+  // A big-endian file.
+  std::string swapped = data;
+  memcpy(&swapped[0], "2ELIFREP", 8);
+  WriteTempFile(swapped);
+  EXPECT_FALSE(file.Open(kTempFile));
+
+  // A pipe-mode file.
+  std::string pipe = data;
+  pipe[8] = 16;
+  WriteTempFile(pipe);
+  EXPECT_FALSE(file.Open(kTempFile));
+
+  // Truncated files.
+  for (size_t length = 0; length < data.size(); length += 8) {
+    WriteTempFile(data.substr(0, length));
+    EXPECT_FALSE(file.Open(kTempFile));
+  }
+}
+
+TEST_F(PerfDataFileTest, OpenPartialIds) {
+  std::vector<uint64> ids;
+  ids.push_back(10);
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeSoftware, 0, kSampleType, ids);
+  std::string data = builder.Build();
+
+  // Sizes of the section of identifiers that are not a whole number of
+  // identifiers.
+  PerfFileHeader header;
+  memcpy(&header, data.data(), sizeof(header));
+  size_t ids_size_offset = static_cast<size_t>(
+      header.attrs.offset + header.attr_size - sizeof(uint64));
+  for (uint64 size = 1; size < sizeof(uint64); ++size) {
+    std::string partial = data;
+    memcpy(&partial[ids_size_offset], &size, sizeof(size));
+    WriteTempFile(partial);
+
+    PerfDataFile file;
+    EXPECT_FALSE(file.Open(kTempFile));
+  }
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -0,0 +1,514 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_parser.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "base/logging.h"
+#include "base/memory_mapped_file.h"
+#include "base/scoped_ptr.h"
+#include "event/value.h"
+#include "parser/ftrace/ftrace_record_decoder.h"
+#include "parser/perf/perf_data_file.h"
+#include "parser/perf/perf_record.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+using event::ArrayValue;
+using event::Event;
+using event::StringValue;
+using event::StructValue;
+using event::Timestamp;
+using event::UCharValue;
+using event::UIntValue;
+using event::ULongValue;
+using event::Value;
+
+const char kPerfCategory[] = "Perf";
+
+const size_t kPerfDataMinWindowSize = PerfDataParser::kMinWindowSize;
+
+// A window over the data section of a file, moved forward on demand.
+class RecordWindow {
+ public:
+  // @param path the path of the file.
+  // @param end the end of the data section, within the file.
+  // @param window_size the size of the window.
+  RecordWindow(const std::string& path, uint64 end, size_t window_size)
+      : path_(path),
+        end_(end),
+        window_size_(std::max(window_size, kPerfDataMinWindowSize)),
+        begin_(0) {
+  }
+
+  // @param offset the offset of a block in the file.
+  // @param size the size of the block, in bytes.
+  // @returns the block, or NULL if it is past the end of the data section
+  //     or cannot be mapped.
+  const char* Get(uint64 offset, size_t size) {
+    if (window_.IsValid() && offset >= begin_ &&
+        offset - begin_ <= window_.length() &&
+        size <= window_.length() - (offset - begin_)) {
+      return window_.data() + (offset - begin_);
+    }
+    if (offset > end_ || size > end_ - offset)
+      return NULL;
+
+    uint64 remaining = end_ - offset;
+    size_t length = remaining < window_size_ ?
+        static_cast<size_t>(remaining) : window_size_;
+    if (length < size ||
+        !window_.OpenRegion(path_, offset, length) ||
+        window_.length() < size) {
+      window_.Close();
+      return NULL;
+    }
+    begin_ = offset;
+    return window_.data();
+  }
+
+ private:
+  std::string path_;
+  uint64 end_;
+  size_t window_size_;
+
+  base::MemoryMappedFile window_;
+  // The offset of the window in the file.
+  uint64 begin_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordWindow);
+};
+
+uint32 ReadUInt32(const char* bytes) {
+  uint32 value;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+uint64 ReadUInt64(const char* bytes) {
+  uint64 value;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+// Reads a NUL-terminated string from |bytes|, bounded by |end|.
+std::string ReadString(const char* bytes, const char* end) {
+  if (bytes >= end)
+    return std::string();
+  return std::string(bytes, strnlen(bytes, end - bytes));
+}
+
+// Decodes the records of a file and sends the events to an observer.
+class RecordDispatcher {
+ public:
+  RecordDispatcher(const PerfDataFile& file,
+                   const base::Observer<Event>& observer)
+      : file_(file),
+        observer_(observer),
+        lost_records_(0),
+        unknown_records_(0) {
+    if (file.tracing_data() != NULL)
+      tracepoints_.reset(new ftrace::FtraceRecordDecoder(
+          *file.tracing_data()));
+  }
+
+  // Decodes a record.
+  // @param header the header of the record.
+  // @param body the body of the record, after its header.
+  // @param size the size of the body, in bytes.
+  void Dispatch(const PerfRecordHeader& header,
+                const char* body,
+                size_t size);
+
+  size_t lost_records() const { return lost_records_; }
+  size_t unknown_records() const { return unknown_records_; }
+
+ private:
+  // @returns the attributes of the event of a record, or NULL.
+  const PerfEventAttr* FindAttr(uint32 record_type,
+                                const char* body,
+                                size_t size) const;
+
+  void DispatchSample(const PerfEventAttr& attr,
+                      const char* body,
+                      size_t size);
+  void DispatchMmap(const PerfRecordHeader& header,
+                    const PerfSample& sample_id,
+                    const char* body,
+                    size_t size);
+  void DispatchComm(const PerfSample& sample_id,
+                    const char* body,
+                    size_t size);
+  void DispatchTask(const PerfRecordHeader& header,
+                    const PerfSample& sample_id,
+                    const char* body,
+                    size_t size);
+
+  void Send(Timestamp timestamp,
+            const std::string& category,
+            const std::string& operation,
+            uint64 process_id,
+            uint64 thread_id,
+            uint32 processor_number,
+            scoped_ptr<StructValue> content);
+
+  const PerfDataFile& file_;
+  const base::Observer<Event>& observer_;
+  scoped_ptr<ftrace::FtraceRecordDecoder> tracepoints_;
+
+  size_t lost_records_;
+  size_t unknown_records_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordDispatcher);
+};
+
+void RecordDispatcher::Dispatch(const PerfRecordHeader& header,
+                                const char* body,
+                                size_t size) {
+  switch (header.type) {
+    case kPerfRecordSample:
+    case kPerfRecordMmap:
+    case kPerfRecordMmap2:
+    case kPerfRecordComm:
+    case kPerfRecordFork:
+    case kPerfRecordExit:
+      break;
+    case kPerfRecordLost:
+      if (size >= 2 * sizeof(uint64))
+        lost_records_ += static_cast<size_t>(ReadUInt64(body + 8));
+      return;
+    default:
+      // The other records are not needed to analyze the trace.
+      return;
+  }
+
+  const PerfEventAttr* attr = FindAttr(header.type, body, size);
+  if (attr == NULL) {
+    ++unknown_records_;
+    return;
+  }
+
+  if (header.type == kPerfRecordSample) {
+    DispatchSample(*attr, body, size);
+    return;
+  }
+
+  PerfSample sample_id;
+  if (attr->sample_id_all) {
+    if (!DecodePerfSampleId(attr->sample_type, body, size, &sample_id)) {
+      ++unknown_records_;
+      return;
+    }
+    size -= GetPerfSampleIdSize(attr->sample_type);
+  }
+
+  switch (header.type) {
+    case kPerfRecordMmap:
+    case kPerfRecordMmap2:
+      DispatchMmap(header, sample_id, body, size);
+      break;
+    case kPerfRecordComm:
+      DispatchComm(sample_id, body, size);
+      break;
+    default:
+      DispatchTask(header, sample_id, body, size);
+      break;
+  }
+}
+
+const PerfEventAttr* RecordDispatcher::FindAttr(uint32 record_type,
+                                                const char* body,
+                                                size_t size) const {
+  const std::vector<PerfEventAttr>& attrs = file_.attrs();
+  DCHECK(!attrs.empty());
+  if (attrs.size() == 1)
+    return &attrs[0];
+
+  // All events have their identifier at the same position. Without
+  // identifiers, the events cannot be told apart and perf uses the first.
+  const PerfEventAttr& first = attrs[0];
+  if (record_type != kPerfRecordSample && !first.sample_id_all)
+    return &first;
+  uint64 id = 0;
+  if (!FindPerfEventId(first.sample_type, record_type, body, size, &id)) {
+    const uint64 kIdBits = kPerfSampleId | kPerfSampleIdentifier;
+    return (first.sample_type & kIdBits) == 0 ? &first : NULL;
+  }
+  return file_.FindAttr(id);
+}
+
+void RecordDispatcher::DispatchSample(const PerfEventAttr& attr,
+                                      const char* body,
+                                      size_t size) {
+  PerfSample sample;
+  if (!DecodePerfSample(attr.sample_type, attr.read_format, body, size,
+                        &sample)) {
+    ++unknown_records_;
+    return;
+  }
+
+  scoped_ptr<ArrayValue> callchain;
+  if ((attr.sample_type & kPerfSampleCallchain) != 0) {
+    callchain.reset(new ArrayValue());
+    for (size_t i = 0; i < sample.callchain_size; ++i) {
+      callchain->Append<ULongValue>(
+          ReadUInt64(sample.callchain + i * sizeof(uint64)));
+    }
+  }
+
+  // A tracepoint sample is decoded from the formats of the tracing data.
+  if (attr.type == kPerfTypeTracepoint && sample.raw != NULL &&
+      tracepoints_.get() != NULL) {
+    const ftrace::FtraceEventFormat* format = NULL;
+    uint64 pid = 0;
+    scoped_ptr<StructValue> content;
+    if (tracepoints_->Decode(sample.raw, sample.raw_size, &format, &pid,
+                             &content)) {
+      if (callchain.get() != NULL)
+        content->AddField("callchain", callchain.PassAs<Value>());
+      bool has_tid = (attr.sample_type & kPerfSampleTid) != 0;
+      Send(sample.time, format->system, format->name,
+           has_tid ? sample.pid : pid, has_tid ? sample.tid : pid,
+           sample.cpu, content.Pass());
+      return;
+    }
+  }
+
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("type", attr.type);
+  content->AddField<ULongValue>("config", attr.config);
+  if ((attr.sample_type & kPerfSampleIp) != 0)
+    content->AddField<ULongValue>("ip", sample.ip);
+  if ((attr.sample_type & kPerfSampleAddr) != 0)
+    content->AddField<ULongValue>("addr", sample.addr);
+  if ((attr.sample_type & kPerfSamplePeriod) != 0)
+    content->AddField<ULongValue>("period", sample.period);
+  if (callchain.get() != NULL)
+    content->AddField("callchain", callchain.PassAs<Value>());
+
+  Send(sample.time, kPerfCategory, "Sample", sample.pid, sample.tid,
+       sample.cpu, content.Pass());
+}
+
+void RecordDispatcher::DispatchMmap(const PerfRecordHeader& header,
+                                    const PerfSample& sample_id,
+                                    const char* body,
+                                    size_t size) {
+  // pid, tid, addr, len, pgoff.
+  const size_t kMmapSize = 2 * sizeof(uint32) + 3 * sizeof(uint64);
+  // maj, min, ino, ino_generation or a build id, then prot, flags.
+  const size_t kMmap2ExtraSize = 24 + 2 * sizeof(uint32);
+
+  size_t filename_offset = kMmapSize;
+  if (header.type == kPerfRecordMmap2)
+    filename_offset += kMmap2ExtraSize;
+  if (size < filename_offset) {
+    ++unknown_records_;
+    return;
+  }
+
+  uint32 pid = ReadUInt32(body);
+  uint32 tid = ReadUInt32(body + 4);
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("pid", pid);
+  content->AddField<UIntValue>("tid", tid);
+  content->AddField<ULongValue>("addr", ReadUInt64(body + 8));
+  content->AddField<ULongValue>("len", ReadUInt64(body + 16));
+  content->AddField<ULongValue>("pgoff", ReadUInt64(body + 24));
+  if (header.type == kPerfRecordMmap2) {
+    const char* extra = body + kMmapSize;
+    if ((header.misc & kPerfRecordMiscMmapBuildId) == 0) {
+      content->AddField<UIntValue>("maj", ReadUInt32(extra));
+      content->AddField<UIntValue>("min", ReadUInt32(extra + 4));
+      content->AddField<ULongValue>("ino", ReadUInt64(extra + 8));
+    }
+    content->AddField<UIntValue>("prot", ReadUInt32(extra + 24));
+    content->AddField<UIntValue>("flags", ReadUInt32(extra + 28));
+  }
+  content->AddField<StringValue>(
+      "filename", ReadString(body + filename_offset, body + size));
+
+  Send(sample_id.time, kPerfCategory, "Mmap", pid, tid, sample_id.cpu,
+       content.Pass());
+}
+
+void RecordDispatcher::DispatchComm(const PerfSample& sample_id,
+                                    const char* body,
+                                    size_t size) {
+  if (size < 2 * sizeof(uint32)) {
+    ++unknown_records_;
+    return;
+  }
+
+  uint32 pid = ReadUInt32(body);
+  uint32 tid = ReadUInt32(body + 4);
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("pid", pid);
+  content->AddField<UIntValue>("tid", tid);
+  content->AddField<StringValue>("comm", ReadString(body + 8, body + size));
+
+  Send(sample_id.time, kPerfCategory, "Comm", pid, tid, sample_id.cpu,
+       content.Pass());
+}
+
+void RecordDispatcher::DispatchTask(const PerfRecordHeader& header,
+                                    const PerfSample& sample_id,
+                                    const char* body,
+                                    size_t size) {
+  // pid, ppid, tid, ptid, time.
+  if (size < 4 * sizeof(uint32) + sizeof(uint64)) {
+    ++unknown_records_;
+    return;
+  }
+
+  uint32 pid = ReadUInt32(body);
+  uint32 tid = ReadUInt32(body + 8);
+  scoped_ptr<StructValue> content(new StructValue());
+  content->AddField<UIntValue>("pid", pid);
+  content->AddField<UIntValue>("ppid", ReadUInt32(body + 4));
+  content->AddField<UIntValue>("tid", tid);
+  content->AddField<UIntValue>("ptid", ReadUInt32(body + 12));
+
+  Send(ReadUInt64(body + 16), kPerfCategory,
+       header.type == kPerfRecordFork ? "Fork" : "Exit", pid, tid,
+       sample_id.cpu, content.Pass());
+}
+
+void RecordDispatcher::Send(Timestamp timestamp,
+                            const std::string& category,
+                            const std::string& operation,
+                            uint64 process_id,
+                            uint64 thread_id,
+                            uint32 processor_number,
+                            scoped_ptr<StructValue> content) {
+  // Generate the event header fields.
+  scoped_ptr<StructValue> fields(new StructValue());
+  fields->AddField<StringValue>("operation", operation);
+  fields->AddField<StringValue>("category", category);
+  fields->AddField<ULongValue>("process_id", process_id);
+  fields->AddField<ULongValue>("thread_id", thread_id);
+  fields->AddField<UCharValue>("processor_number",
+                               static_cast<uint8>(processor_number));
+  fields->AddField("content", content.PassAs<Value>());
+
+  // Create the event with decoded fields and send it to the observer.
+  Event event(timestamp, fields.Pass());
+  observer_.Receive(event);
+}
+
+// Walks the records of the data section of a file.
+void ParsePerfData(const std::string& path,
+                   const PerfDataFile& file,
+                   size_t window_size,
+                   const base::Observer<Event>& observer) {
+  const PerfFileSection& data = file.data_section();
+  uint64 position = data.offset;
+  uint64 end = data.offset + data.size;
+
+  RecordWindow window(path, end, window_size);
+  RecordDispatcher dispatcher(file, observer);
+  bool truncated = false;
+
+  while (position < end) {
+    const char* bytes = window.Get(position, sizeof(PerfRecordHeader));
+    if (bytes == NULL) {
+      truncated = true;
+      break;
+    }
+    PerfRecordHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.size < sizeof(header)) {
+      truncated = true;
+      break;
+    }
+
+    const char* record = window.Get(position, header.size);
+    if (record == NULL) {
+      truncated = true;
+      break;
+    }
+    dispatcher.Dispatch(header, record + sizeof(header),
+                        header.size - sizeof(header));
+    position += header.size;
+
+    // The auxiliary trace data follow their record.
+    if (header.type == kPerfRecordAuxtrace) {
+      if (header.size < sizeof(header) + sizeof(uint64)) {
+        truncated = true;
+        break;
+      }
+      position += ReadUInt64(record + sizeof(header));
+    }
+  }
+
+  if (truncated)
+    LOG(WARNING) << "The data section of " << path << " is truncated.";
+  if (dispatcher.lost_records() != 0)
+    LOG(WARNING) << dispatcher.lost_records() << " records were lost.";
+  if (dispatcher.unknown_records() != 0) {
+    LOG(WARNING) << dispatcher.unknown_records()
+                 << " records cannot be decoded.";
+  }
+}
+
+}  // namespace
+
+const size_t PerfDataParser::kDefaultWindowSize;
+const size_t PerfDataParser::kMinWindowSize;
+
+bool PerfDataParser::AddTraceFile(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  char magic[kPerfDataMagicSize];
+  size_t read = fread(magic, 1, sizeof(magic), file);
+  fclose(file);
+
+  if (!PerfDataFile::HasMagic(magic, read))
+    return false;
+  traces_.push_back(path);
+  return true;
+}
+
+void PerfDataParser::Parse(const base::Observer<Event>& observer) {
+  for (size_t i = 0; i < traces_.size(); ++i) {
+    PerfDataFile file;
+    if (!file.Open(traces_[i])) {
+      LOG(WARNING) << "Unable to read the perf.data file " << traces_[i]
+                   << ".";
+      continue;
+    }
+    ParsePerfData(traces_[i], file, window_size_, observer);
+  }
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -0,0 +1,100 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef PARSER_PERF_PERF_DATA_PARSER_H_
+#define PARSER_PERF_PERF_DATA_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/observer.h"
+#include "event/event.h"
+#include "parser/parser.h"
+
+namespace parser {
+namespace perf {
+
+// Generate Event objects from the perf.data files written by "perf record".
+// The data section is walked through a memory-mapped window, so a file may
+// be larger than the memory. The records are decoded in place; the events
+// are sent in the order of the file, which perf only sorts between the
+// FINISHED_ROUND records.
+//
+// The header fields of an event are the same as for the ETW events:
+//   operation:         "Sample", "Mmap", "Comm", "Fork" or "Exit", or the
+//                      name of the tracepoint of a tracepoint sample.
+//   category:          "Perf", or the system of the tracepoint.
+//   process_id:        the pid of the record.
+//   thread_id:         the tid of the record.
+//   processor_number:  the CPU of the record, when sampled.
+//   content:           the fields of the record. The fields of a tracepoint
+//                      are decoded from the formats of the tracing data.
+// A sample with a callchain has a "callchain" array of instruction
+// pointers, which includes the PERF_CONTEXT_* markers.
+class PerfDataParser : public parser::ParserImpl {
+ public:
+  // The default size of the window over the data section, in bytes.
+  static const size_t kDefaultWindowSize = 64 << 20;
+
+  // The minimal size of the window: it holds any record.
+  static const size_t kMinWindowSize = 1 << 16;
+
+  // Constuctor.
+  PerfDataParser()
+      : parser::ParserImpl(),
+        window_size_(kDefaultWindowSize) {
+  }
+
+  // Adds a trace file to the list of traces to parse. The file is recognized
+  // by its magic.
+  // @param path path to the trace file.
+  bool AddTraceFile(const std::string& path) OVERRIDE;
+
+  // Parses the trace files added with AddTraceFile() and sends the resulting
+  // events to the provided observer.
+  // @param observer an observer that will receive the decoded events.
+  void Parse(const base::Observer<event::Event>& observer) OVERRIDE;
+
+  // @param window_size the size of the window over the data section, at
+  //     least kMinWindowSize.
+  void set_window_size(size_t window_size) {
+    window_size_ = window_size < kMinWindowSize ? kMinWindowSize :
+                                                  window_size;
+  }
+
+ private:
+  // Trace files to consume.
+  std::vector<std::string> traces_;
+
+  size_t window_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfDataParser);
+};
+
+}  // namespace perf
+}  // namespace parser
+
+#endif  // PARSER_PERF_PERF_DATA_PARSER_H_
@@ -0,0 +1,101 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_parser.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "base/observer.h"
+#include "base/perf_test.h"
+#include "gtest/gtest.h"
+#include "parser/perf/perf_data_file.h"
+#include "parser/perf/perf_data_test_utils.h"
+#include "parser/perf/perf_record.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+const char kTempFile[] = "perf_data_parser_perftest.data";
+const size_t kSamples = 200000;
+
+const uint64 kSampleType = kPerfSampleIp | kPerfSampleTid |
+                           kPerfSampleTime | kPerfSampleId |
+                           kPerfSampleCpu | kPerfSamplePeriod |
+                           kPerfSampleCallchain;
+
+class EventCounter {
+ public:
+  EventCounter() : count_(0) {}
+
+  void Receive(const event::Event& /* event */) { ++count_; }
+
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_;
+};
+
+}  // namespace
+
+TEST(PerfDataParserPerfTest, ParseSamples) {
+  {
+    PerfDataBuilder builder;
+    builder.AddAttr(kPerfTypeHardware, 0, kSampleType,
+                    std::vector<uint64>(1, 1));
+    // Samples with a callchain of 16 frames.
+    std::vector<uint64> callchain(16, 0x401000);
+    PerfSample sample;
+    sample.ip = 0x401000;
+    sample.pid = 12;
+    sample.tid = 34;
+    sample.id = 1;
+    sample.period = 1000;
+    for (size_t i = 0; i < kSamples; ++i) {
+      sample.time = i * 100;
+      sample.cpu = static_cast<uint32>(i % 8);
+      builder.AddRecord(kPerfRecordSample, 0,
+                        MakePerfSample(kSampleType, sample, callchain, ""));
+    }
+    ASSERT_TRUE(builder.WriteFile(kTempFile));
+  }
+
+  PerfDataParser parser;
+  ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+  EventCounter counter;
+
+  base::PerfTimer timer;
+  parser.Parse(base::MakeObserver(&counter, &EventCounter::Receive));
+  base::PrintPerfResult("ParsePerfSamples", "time",
+                        timer.ElapsedNanoseconds(), kSamples, "ns/event");
+
+  std::remove(kTempFile);
+  EXPECT_EQ(kSamples, counter.count());
+}
+
+}  // namespace perf
+}  // namespace parser
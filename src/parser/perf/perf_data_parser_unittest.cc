@@ -0,0 +1,371 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_parser.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "base/observer.h"
+#include "event/utils.h"
+#include "event/value.h"
+#include "gtest/gtest.h"
+#include "parser/ftrace/trace_dat_test_utils.h"
+#include "parser/perf/perf_data_file.h"
+#include "parser/perf/perf_data_test_utils.h"
+#include "parser/perf/perf_record.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+using event::StructValue;
+
+const char kTempFile[] = "perf_data_parser_unittest.data";
+
+const uint64 kSampleType = kPerfSampleIp | kPerfSampleTid |
+                           kPerfSampleTime | kPerfSampleId |
+                           kPerfSampleCpu | kPerfSamplePeriod |
+                           kPerfSampleCallchain;
+const uint64 kTracepointSampleType = kSampleType | kPerfSampleRaw;
+
+const uint64 kCyclesId = 10;
+const uint64 kTracepointId = 20;
+
+// Keeps the header fields of the received events.
+struct ReceivedEvent {
+  uint64 timestamp;
+  std::string operation;
+  std::string category;
+  uint64 process_id;
+  uint64 thread_id;
+  uint32 processor_number;
+  std::string content;
+};
+
+class EventCollector {
+ public:
+  void Receive(const event::Event& event) {
+    const StructValue* fields = StructValue::Cast(event.payload());
+    ASSERT_TRUE(fields != NULL);
+
+    ReceivedEvent received = {};
+    received.timestamp = event.timestamp();
+    const StructValue* content = NULL;
+    ASSERT_TRUE(fields->GetFieldAsString("operation", &received.operation));
+    ASSERT_TRUE(fields->GetFieldAsString("category", &received.category));
+    ASSERT_TRUE(fields->GetFieldAsULong("process_id", &received.process_id));
+    ASSERT_TRUE(fields->GetFieldAsULong("thread_id", &received.thread_id));
+    ASSERT_TRUE(fields->GetFieldAsUInteger("processor_number",
+                                           &received.processor_number));
+    ASSERT_TRUE(fields->GetFieldAs<StructValue>("content", &content));
+    ASSERT_TRUE(event::ToString(content, &received.content));
+    events.push_back(received);
+  }
+
+  std::vector<ReceivedEvent> events;
+};
+
+class PerfDataParserTest : public testing::Test {
+ protected:
+  virtual void TearDown() OVERRIDE {
+    std::remove(kTempFile);
+  }
+
+  void Parse(size_t window_size) {
+    PerfDataParser parser;
+    parser.set_window_size(window_size);
+    ASSERT_TRUE(parser.AddTraceFile(kTempFile));
+    parser.Parse(base::MakeObserver(&collector_, &EventCollector::Receive));
+  }
+
+  EventCollector collector_;
+};
+
+PerfSample MakeSample(uint64 id, uint32 pid, uint32 tid, uint64 time) {
+  PerfSample sample;
+  sample.ip = 0x401000;
+  sample.pid = pid;
+  sample.tid = tid;
+  sample.time = time;
+  sample.id = id;
+  sample.cpu = 2;
+  sample.period = 1000;
+  return sample;
+}
+
+template <typename T>
+void Append(T value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::string MakeMmap2Body(uint32 pid, uint32 tid, const std::string& name) {
+  std::string body;
+  Append<uint32>(pid, &body);
+  Append<uint32>(tid, &body);
+  Append<uint64>(0x400000, &body);
+  Append<uint64>(0x2000, &body);
+  Append<uint64>(0, &body);
+  Append<uint32>(8, &body);
+  Append<uint32>(1, &body);
+  Append<uint64>(4242, &body);
+  Append<uint64>(0, &body);
+  Append<uint32>(5, &body);
+  Append<uint32>(2, &body);
+  body.append(name.c_str(), name.size() + 1);
+  body.resize((body.size() + 7) & ~static_cast<size_t>(7), '\0');
+  return body;
+}
+
+std::string MakeCommBody(uint32 pid, uint32 tid, const std::string& comm) {
+  std::string body;
+  Append<uint32>(pid, &body);
+  Append<uint32>(tid, &body);
+  body.append(comm.c_str(), comm.size() + 1);
+  body.resize((body.size() + 7) & ~static_cast<size_t>(7), '\0');
+  return body;
+}
+
+std::string MakeTaskBody(uint32 pid, uint32 ppid, uint64 time) {
+  std::string body;
+  Append<uint32>(pid, &body);
+  Append<uint32>(ppid, &body);
+  Append<uint32>(pid, &body);
+  Append<uint32>(ppid, &body);
+  Append<uint64>(time, &body);
+  return body;
+}
+
+}  // namespace
+
+TEST_F(PerfDataParserTest, AddTraceFile) {
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeHardware, 0, kSampleType, std::vector<uint64>());
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  PerfDataParser parser;
+  EXPECT_TRUE(parser.AddTraceFile(kTempFile));
+  EXPECT_FALSE(parser.AddTraceFile("missing.data"));
+}
+
+TEST_F(PerfDataParserTest, Parse) {
+  ftrace::TraceDatBuilder tracing_data(1);
+  tracing_data.AddFormat("sched", ftrace::kTestSchedSwitchFormat);
+
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeHardware, 0, kSampleType,
+                  std::vector<uint64>(1, kCyclesId));
+  builder.AddAttr(kPerfTypeTracepoint, ftrace::kTestSchedSwitchId,
+                  kTracepointSampleType,
+                  std::vector<uint64>(1, kTracepointId));
+  builder.set_tracing_data(tracing_data.BuildTracingData());
+
+  PerfSample sample_id = MakeSample(kCyclesId, 100, 100, 1000);
+  std::string sample_id_bytes = MakePerfSampleId(kSampleType, sample_id);
+  builder.AddRecord(kPerfRecordComm, kPerfRecordMiscCommExec,
+                    MakeCommBody(100, 100, "bash") + sample_id_bytes);
+  builder.AddRecord(kPerfRecordMmap2, 0,
+                    MakeMmap2Body(100, 100, "/bin/bash") + sample_id_bytes);
+  builder.AddRecord(kPerfRecordFork, 0,
+                    MakeTaskBody(101, 100, 1500) + sample_id_bytes);
+
+  std::vector<uint64> callchain;
+  callchain.push_back(0x401000);
+  callchain.push_back(0x402000);
+  builder.AddRecord(kPerfRecordSample, 0,
+                    MakePerfSample(kSampleType,
+                                   MakeSample(kCyclesId, 100, 101, 2000),
+                                   callchain, ""));
+  std::string raw = ftrace::MakeSchedSwitchRecord(101, "bash", 101,
+                                                  "swapper/2", 0);
+  builder.AddRecord(kPerfRecordSample, 0,
+                    MakePerfSample(kTracepointSampleType,
+                                   MakeSample(kTracepointId, 100, 101, 3000),
+                                   std::vector<uint64>(), raw));
+  // Records that are not decoded.
+  builder.AddRecord(68, 0, "");
+  builder.AddRecord(kPerfRecordExit, 0,
+                    MakeTaskBody(101, 100, 4000) + sample_id_bytes);
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  Parse(PerfDataParser::kDefaultWindowSize);
+
+  const std::vector<ReceivedEvent>& events = collector_.events;
+  ASSERT_EQ(6U, events.size());
+
+  EXPECT_EQ(1000U, events[0].timestamp);
+  EXPECT_EQ("Comm", events[0].operation);
+  EXPECT_EQ("Perf", events[0].category);
+  EXPECT_EQ(100U, events[0].process_id);
+  EXPECT_EQ(2U, events[0].processor_number);
+  EXPECT_EQ("{\n    pid = 100\n    tid = 100\n    comm = \"bash\"\n}",
+            events[0].content);
+
+  EXPECT_EQ("Mmap", events[1].operation);
+  EXPECT_EQ("{\n"
+            "    pid = 100\n"
+            "    tid = 100\n"
+            "    addr = 4194304\n"
+            "    len = 8192\n"
+            "    pgoff = 0\n"
+            "    maj = 8\n"
+            "    min = 1\n"
+            "    ino = 4242\n"
+            "    prot = 5\n"
+            "    flags = 2\n"
+            "    filename = \"/bin/bash\"\n"
+            "}", events[1].content);
+
+  EXPECT_EQ(1500U, events[2].timestamp);
+  EXPECT_EQ("Fork", events[2].operation);
+  EXPECT_EQ(101U, events[2].process_id);
+  EXPECT_EQ("{\n"
+            "    pid = 101\n"
+            "    ppid = 100\n"
+            "    tid = 101\n"
+            "    ptid = 100\n"
+            "}", events[2].content);
+
+  EXPECT_EQ(2000U, events[3].timestamp);
+  EXPECT_EQ("Sample", events[3].operation);
+  EXPECT_EQ("Perf", events[3].category);
+  EXPECT_EQ(100U, events[3].process_id);
+  EXPECT_EQ(101U, events[3].thread_id);
+  EXPECT_EQ(2U, events[3].processor_number);
+  EXPECT_EQ("{\n"
+            "    type = 0\n"
+            "    config = 0\n"
+            "    ip = 4198400\n"
+            "    period = 1000\n"
+            "    callchain = [\n"
+            "        4198400\n"
+            "        4202496\n"
+            "    ]\n"
+            "}", events[3].content);
+
+  EXPECT_EQ(3000U, events[4].timestamp);
+  EXPECT_EQ("sched_switch", events[4].operation);
+  EXPECT_EQ("sched", events[4].category);
+  EXPECT_EQ(100U, events[4].process_id);
+  EXPECT_EQ(101U, events[4].thread_id);
+  EXPECT_EQ("{\n"
+            "    prev_comm = \"bash\"\n"
+            "    prev_pid = 101\n"
+            "    prev_prio = 120\n"
+            "    prev_state = 1\n"
+            "    next_comm = \"swapper/2\"\n"
+            "    next_pid = 0\n"
+            "    next_prio = 120\n"
+            "    callchain = [\n"
+            "    ]\n"
+            "}", events[4].content);
+
+  EXPECT_EQ(4000U, events[5].timestamp);
+  EXPECT_EQ("Exit", events[5].operation);
+}
+
+TEST_F(PerfDataParserTest, ParseUnknownId) {
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeHardware, 0, kSampleType,
+                  std::vector<uint64>(1, kCyclesId));
+  builder.AddAttr(kPerfTypeSoftware, 0, kSampleType,
+                  std::vector<uint64>(1, kCyclesId + 1));
+  std::vector<uint64> callchain;
+  builder.AddRecord(kPerfRecordSample, 0,
+                    MakePerfSample(kSampleType,
+                                   MakeSample(kCyclesId + 1, 1, 1, 10),
+                                   callchain, ""));
+  builder.AddRecord(kPerfRecordSample, 0,
+                    MakePerfSample(kSampleType,
+                                   MakeSample(kCyclesId + 2, 1, 1, 20),
+                                   callchain, ""));
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  Parse(PerfDataParser::kDefaultWindowSize);
+
+  ASSERT_EQ(1U, collector_.events.size());
+  EXPECT_EQ(10U, collector_.events[0].timestamp);
+  EXPECT_NE(std::string::npos,
+            collector_.events[0].content.find("type = 1"));
+}
+
+TEST_F(PerfDataParserTest, ParseWindows) {
+  const size_t kSamples = 20000;
+
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeHardware, 0, kSampleType,
+                  std::vector<uint64>(1, kCyclesId));
+  // Records of various sizes cross the boundaries of the windows.
+  std::vector<uint64> callchain;
+  for (size_t i = 0; i < kSamples; ++i) {
+    callchain.resize(i % 7);
+    builder.AddRecord(kPerfRecordSample, 0,
+                      MakePerfSample(kSampleType,
+                                     MakeSample(kCyclesId, 1, 1, i),
+                                     callchain, ""));
+  }
+  ASSERT_TRUE(builder.WriteFile(kTempFile));
+
+  Parse(PerfDataParser::kMinWindowSize);
+
+  const std::vector<ReceivedEvent>& events = collector_.events;
+  ASSERT_EQ(kSamples, events.size());
+  for (size_t i = 0; i < events.size(); ++i)
+    EXPECT_EQ(i, events[i].timestamp);
+}
+
+TEST_F(PerfDataParserTest, ParseTruncated) {
+  PerfDataBuilder builder;
+  builder.AddAttr(kPerfTypeHardware, 0, kSampleType,
+                  std::vector<uint64>(1, kCyclesId));
+  std::vector<uint64> callchain;
+  builder.AddRecord(kPerfRecordSample, 0,
+                    MakePerfSample(kSampleType,
+                                   MakeSample(kCyclesId, 1, 1, 10),
+                                   callchain, ""));
+  // A record whose size is past the end of the data section.
+  std::string body = MakePerfSample(kSampleType,
+                                    MakeSample(kCyclesId, 1, 1, 20),
+                                    callchain, "");
+  body.resize(body.size() - 16);
+  builder.AddRecord(kPerfRecordSample, 0, body);
+  std::string data = builder.Build();
+  data[data.size() - body.size() - 2] += 32;
+
+  FILE* file = fopen(kTempFile, "wb");
+  ASSERT_TRUE(file != NULL);
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+
+  Parse(PerfDataParser::kDefaultWindowSize);
+
+  ASSERT_EQ(1U, collector_.events.size());
+  EXPECT_EQ(10U, collector_.events[0].timestamp);
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -0,0 +1,205 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_data_test_utils.h"
+
+#include <cstdio>
+
+#include "base/logging.h"
+#include "parser/perf/perf_data_file.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+// The size of a perf_event_attr, version 5.
+const size_t kAttrSize = 112;
+const uint64 kAttrFlagSampleIdAll = 1ULL << 18;
+
+template <typename T>
+void Append(T value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void AppendSection(uint64 offset, uint64 size, std::string* out) {
+  Append<uint64>(offset, out);
+  Append<uint64>(size, out);
+}
+
+}  // namespace
+
+std::string MakePerfSample(uint64 sample_type,
+                           const PerfSample& sample,
+                           const std::vector<uint64>& callchain,
+                           const std::string& raw) {
+  std::string body;
+  if ((sample_type & kPerfSampleIdentifier) != 0)
+    Append<uint64>(sample.id, &body);
+  if ((sample_type & kPerfSampleIp) != 0)
+    Append<uint64>(sample.ip, &body);
+  if ((sample_type & kPerfSampleTid) != 0) {
+    Append<uint32>(sample.pid, &body);
+    Append<uint32>(sample.tid, &body);
+  }
+  if ((sample_type & kPerfSampleTime) != 0)
+    Append<uint64>(sample.time, &body);
+  if ((sample_type & kPerfSampleAddr) != 0)
+    Append<uint64>(sample.addr, &body);
+  if ((sample_type & kPerfSampleId) != 0)
+    Append<uint64>(sample.id, &body);
+  if ((sample_type & kPerfSampleStreamId) != 0)
+    Append<uint64>(sample.stream_id, &body);
+  if ((sample_type & kPerfSampleCpu) != 0) {
+    Append<uint32>(sample.cpu, &body);
+    Append<uint32>(0, &body);
+  }
+  if ((sample_type & kPerfSamplePeriod) != 0)
+    Append<uint64>(sample.period, &body);
+  DCHECK_EQ(0U, sample_type & kPerfSampleRead);
+  if ((sample_type & kPerfSampleCallchain) != 0) {
+    Append<uint64>(callchain.size(), &body);
+    for (size_t i = 0; i < callchain.size(); ++i)
+      Append<uint64>(callchain[i], &body);
+  }
+  if ((sample_type & kPerfSampleRaw) != 0) {
+    Append<uint32>(static_cast<uint32>(raw.size()), &body);
+    body.append(raw);
+  }
+  return body;
+}
+
+std::string MakePerfSampleId(uint64 sample_type, const PerfSample& sample) {
+  std::string body;
+  if ((sample_type & kPerfSampleTid) != 0) {
+    Append<uint32>(sample.pid, &body);
+    Append<uint32>(sample.tid, &body);
+  }
+  if ((sample_type & kPerfSampleTime) != 0)
+    Append<uint64>(sample.time, &body);
+  if ((sample_type & kPerfSampleId) != 0)
+    Append<uint64>(sample.id, &body);
+  if ((sample_type & kPerfSampleStreamId) != 0)
+    Append<uint64>(sample.stream_id, &body);
+  if ((sample_type & kPerfSampleCpu) != 0) {
+    Append<uint32>(sample.cpu, &body);
+    Append<uint32>(0, &body);
+  }
+  if ((sample_type & kPerfSampleIdentifier) != 0)
+    Append<uint64>(sample.id, &body);
+  return body;
+}
+
+void PerfDataBuilder::AddAttr(uint32 type,
+                              uint64 config,
+                              uint64 sample_type,
+                              const std::vector<uint64>& ids) {
+  Attr attr = { type, config, sample_type, ids };
+  attrs_.push_back(attr);
+}
+
+void PerfDataBuilder::AddRecord(uint32 type,
+                                uint16 misc,
+                                const std::string& body) {
+  size_t padded_size = (body.size() + 7) & ~static_cast<size_t>(7);
+  size_t size = sizeof(PerfRecordHeader) + padded_size;
+  DCHECK_LE(size, 0xFFFFU);
+
+  Append<uint32>(type, &data_);
+  Append<uint16>(misc, &data_);
+  Append<uint16>(static_cast<uint16>(size), &data_);
+  data_.append(body);
+  data_.resize(data_.size() + padded_size - body.size(), '\0');
+}
+
+std::string PerfDataBuilder::Build() const {
+  const size_t kHeaderSize = sizeof(PerfFileHeader);
+  const size_t kAttrEntrySize = kAttrSize + sizeof(PerfFileSection);
+
+  // The attributes, then their identifiers, then the data.
+  uint64 attrs_offset = kHeaderSize;
+  uint64 ids_offset = attrs_offset + attrs_.size() * kAttrEntrySize;
+  uint64 data_offset = ids_offset;
+  for (size_t i = 0; i < attrs_.size(); ++i)
+    data_offset += attrs_[i].ids.size() * sizeof(uint64);
+
+  std::string out;
+  out.append(kPerfDataMagic, kPerfDataMagicSize);
+  Append<uint64>(kHeaderSize, &out);
+  Append<uint64>(kAttrEntrySize, &out);
+  AppendSection(attrs_offset, attrs_.size() * kAttrEntrySize, &out);
+  AppendSection(data_offset, data_.size(), &out);
+  AppendSection(0, 0, &out);
+  Append<uint64>(tracing_data_.empty() ? 0 :
+                     1ULL << kPerfFeatureTracingData, &out);
+  Append<uint64>(0, &out);
+  Append<uint64>(0, &out);
+  Append<uint64>(0, &out);
+
+  uint64 next_ids = ids_offset;
+  for (size_t i = 0; i < attrs_.size(); ++i) {
+    const Attr& attr = attrs_[i];
+    std::string entry;
+    Append<uint32>(attr.type, &entry);
+    Append<uint32>(kAttrSize, &entry);
+    Append<uint64>(attr.config, &entry);
+    Append<uint64>(1, &entry);
+    Append<uint64>(attr.sample_type, &entry);
+    Append<uint64>(0, &entry);
+    Append<uint64>(kAttrFlagSampleIdAll, &entry);
+    entry.resize(kAttrSize, '\0');
+    uint64 ids_size = attr.ids.size() * sizeof(uint64);
+    AppendSection(ids_size == 0 ? 0 : next_ids, ids_size, &entry);
+    next_ids += ids_size;
+    out.append(entry);
+  }
+
+  for (size_t i = 0; i < attrs_.size(); ++i) {
+    for (size_t j = 0; j < attrs_[i].ids.size(); ++j)
+      Append<uint64>(attrs_[i].ids[j], &out);
+  }
+  DCHECK_EQ(data_offset, out.size());
+  out.append(data_);
+
+  if (!tracing_data_.empty()) {
+    uint64 tracing_data_offset = out.size() + sizeof(PerfFileSection);
+    AppendSection(tracing_data_offset, tracing_data_.size(), &out);
+    out.append(tracing_data_);
+  }
+
+  return out;
+}
+
+bool PerfDataBuilder::WriteFile(const std::string& path) const {
+  std::string data = Build();
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL)
+    return false;
+  bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+  return fclose(file) == 0 && success;
+}
+
+}  // namespace perf
+}  // namespace parser
@@ -0,0 +1,118 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Builds perf.data files for the tests of the perf parser. The files have
+// the layout written by "perf record" on a little-endian 64-bit system.
+//
+// Usage example:
+//   PerfDataBuilder builder;
+//   builder.AddAttr(kPerfTypeHardware, 0, kSampleType, ids);
+//   builder.AddRecord(kPerfRecordSample, 0,
+//                     MakePerfSample(kSampleType, sample, callchain, ""));
+//   builder.WriteFile("test.data");
+
+#ifndef PARSER_PERF_PERF_DATA_TEST_UTILS_H_
+#define PARSER_PERF_PERF_DATA_TEST_UTILS_H_
+
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "parser/perf/perf_record.h"
+
+namespace parser {
+namespace perf {
+
+// Builds the body of a sample, with the fields of |sample_type| up to the
+// raw data.
+// @param sample_type the sample_type of the event.
+// @param sample the values of the fields.
+// @param callchain the callchain, when sampled.
+// @param raw the raw data, when sampled.
+// @returns the body of the record.
+std::string MakePerfSample(uint64 sample_type,
+                           const PerfSample& sample,
+                           const std::vector<uint64>& callchain,
+                           const std::string& raw);
+
+// Builds the sample id that ends the records.
+// @param sample_type the sample_type of the event.
+// @param sample the values of the fields.
+// @returns the sample id.
+std::string MakePerfSampleId(uint64 sample_type, const PerfSample& sample);
+
+class PerfDataBuilder {
+ public:
+  PerfDataBuilder() {}
+
+  // Adds an event. Its records end with a sample id.
+  // @param type the type of the event.
+  // @param config the configuration of the event.
+  // @param sample_type the fields of the samples of the event.
+  // @param ids the identifiers of the event.
+  void AddAttr(uint32 type,
+               uint64 config,
+               uint64 sample_type,
+               const std::vector<uint64>& ids);
+
+  // @param tracing_data the tracing data feature, see TraceDatBuilder.
+  void set_tracing_data(const std::string& tracing_data) {
+    tracing_data_ = tracing_data;
+  }
+
+  // Appends a record to the data section. The body is padded to 8 bytes.
+  // @param type the type of the record.
+  // @param misc the misc field of the header of the record.
+  // @param body the body of the record.
+  void AddRecord(uint32 type, uint16 misc, const std::string& body);
+
+  // @returns the bytes of the file.
+  std::string Build() const;
+
+  // Writes the file.
+  // @param path the path of the file to write.
+  // @returns true on success, false otherwise.
+  bool WriteFile(const std::string& path) const;
+
+ private:
+  struct Attr {
+    uint32 type;
+    uint64 config;
+    uint64 sample_type;
+    std::vector<uint64> ids;
+  };
+
+  std::vector<Attr> attrs_;
+  std::string data_;
+  std::string tracing_data_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfDataBuilder);
+};
+
+}  // namespace perf
+}  // namespace parser
+
+#endif  // PARSER_PERF_PERF_DATA_TEST_UTILS_H_
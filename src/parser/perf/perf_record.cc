@@ -0,0 +1,257 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_record.h"
+
+#include "base/logging.h"
+#include "parser/decoder.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+// Skips the values read with a sample.
+bool SkipReadValues(uint64 read_format, Decoder* decoder) {
+  DCHECK(decoder != NULL);
+
+  size_t value_size = sizeof(uint64);
+  if ((read_format & kPerfFormatId) != 0)
+    value_size += sizeof(uint64);
+  if ((read_format & kPerfFormatLost) != 0)
+    value_size += sizeof(uint64);
+
+  uint64 count = 1;
+  if ((read_format & kPerfFormatGroup) != 0 && !decoder->DecodeRaw(&count))
+    return false;
+  if ((read_format & kPerfFormatTotalTimeEnabled) != 0 &&
+      decoder->Consume(sizeof(uint64)) == NULL) {
+    return false;
+  }
+  if ((read_format & kPerfFormatTotalTimeRunning) != 0 &&
+      decoder->Consume(sizeof(uint64)) == NULL) {
+    return false;
+  }
+  if ((read_format & kPerfFormatGroup) == 0) {
+    // The identifier and the lost count follow the times.
+    return decoder->Consume(value_size) != NULL;
+  }
+  if (count > decoder->RemainingBytes() / value_size)
+    return false;
+  decoder->Consume(static_cast<size_t>(count) * value_size);
+  return true;
+}
+
+}  // namespace
+
+PerfSample::PerfSample()
+    : ip(0),
+      pid(0),
+      tid(0),
+      time(0),
+      addr(0),
+      id(0),
+      stream_id(0),
+      cpu(0),
+      period(0),
+      callchain(NULL),
+      callchain_size(0),
+      raw(NULL),
+      raw_size(0) {
+}
+
+size_t GetPerfSampleIdSize(uint64 sample_type) {
+  size_t size = 0;
+  if ((sample_type & kPerfSampleTid) != 0)
+    size += sizeof(uint64);
+  if ((sample_type & kPerfSampleTime) != 0)
+    size += sizeof(uint64);
+  if ((sample_type & kPerfSampleId) != 0)
+    size += sizeof(uint64);
+  if ((sample_type & kPerfSampleStreamId) != 0)
+    size += sizeof(uint64);
+  if ((sample_type & kPerfSampleCpu) != 0)
+    size += sizeof(uint64);
+  if ((sample_type & kPerfSampleIdentifier) != 0)
+    size += sizeof(uint64);
+  return size;
+}
+
+bool DecodePerfSample(uint64 sample_type,
+                      uint64 read_format,
+                      const char* data,
+                      size_t size,
+                      PerfSample* sample) {
+  DCHECK(data != NULL || size == 0);
+  DCHECK(sample != NULL);
+
+  *sample = PerfSample();
+  Decoder decoder(data, size);
+
+  if ((sample_type & kPerfSampleIdentifier) != 0 &&
+      !decoder.DecodeRaw(&sample->id)) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleIp) != 0 && !decoder.DecodeRaw(&sample->ip))
+    return false;
+  if ((sample_type & kPerfSampleTid) != 0 &&
+      (!decoder.DecodeRaw(&sample->pid) || !decoder.DecodeRaw(&sample->tid))) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleTime) != 0 &&
+      !decoder.DecodeRaw(&sample->time)) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleAddr) != 0 &&
+      !decoder.DecodeRaw(&sample->addr)) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleId) != 0 && !decoder.DecodeRaw(&sample->id))
+    return false;
+  if ((sample_type & kPerfSampleStreamId) != 0 &&
+      !decoder.DecodeRaw(&sample->stream_id)) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleCpu) != 0) {
+    uint32 reserved = 0;
+    if (!decoder.DecodeRaw(&sample->cpu) || !decoder.DecodeRaw(&reserved))
+      return false;
+  }
+  if ((sample_type & kPerfSamplePeriod) != 0 &&
+      !decoder.DecodeRaw(&sample->period)) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleRead) != 0 &&
+      !SkipReadValues(read_format, &decoder)) {
+    return false;
+  }
+  if ((sample_type & kPerfSampleCallchain) != 0) {
+    uint64 count = 0;
+    if (!decoder.DecodeRaw(&count) ||
+        count > decoder.RemainingBytes() / sizeof(uint64)) {
+      return false;
+    }
+    sample->callchain_size = static_cast<size_t>(count);
+    sample->callchain = decoder.Consume(sample->callchain_size *
+                                        sizeof(uint64));
+  }
+  if ((sample_type & kPerfSampleRaw) != 0) {
+    uint32 raw_size = 0;
+    if (!decoder.DecodeRaw(&raw_size) ||
+        raw_size > decoder.RemainingBytes()) {
+      return false;
+    }
+    sample->raw_size = raw_size;
+    sample->raw = decoder.Consume(raw_size);
+  }
+
+  return true;
+}
+
+bool DecodePerfSampleId(uint64 sample_type,
+                        const char* data,
+                        size_t size,
+                        PerfSample* sample) {
+  DCHECK(data != NULL || size == 0);
+  DCHECK(sample != NULL);
+
+  *sample = PerfSample();
+  size_t id_size = GetPerfSampleIdSize(sample_type);
+  if (id_size > size)
+    return false;
+  Decoder decoder(data + size - id_size, id_size);
+
+  if ((sample_type & kPerfSampleTid) != 0) {
+    decoder.DecodeRaw(&sample->pid);
+    decoder.DecodeRaw(&sample->tid);
+  }
+  if ((sample_type & kPerfSampleTime) != 0)
+    decoder.DecodeRaw(&sample->time);
+  if ((sample_type & kPerfSampleId) != 0)
+    decoder.DecodeRaw(&sample->id);
+  if ((sample_type & kPerfSampleStreamId) != 0)
+    decoder.DecodeRaw(&sample->stream_id);
+  if ((sample_type & kPerfSampleCpu) != 0) {
+    uint32 reserved = 0;
+    decoder.DecodeRaw(&sample->cpu);
+    decoder.DecodeRaw(&reserved);
+  }
+  if ((sample_type & kPerfSampleIdentifier) != 0)
+    decoder.DecodeRaw(&sample->id);
+
+  DCHECK_EQ(0U, decoder.RemainingBytes());
+  return true;
+}
+
+bool FindPerfEventId(uint64 sample_type,
+                     uint32 record_type,
+                     const char* data,
+                     size_t size,
+                     uint64* id) {
+  DCHECK(data != NULL || size == 0);
+  DCHECK(id != NULL);
+
+  // The position of the identifier, in 64-bit words from the beginning of a
+  // sample, or from the end of the other records.
+  size_t position = 0;
+  if (record_type == kPerfRecordSample) {
+    if ((sample_type & kPerfSampleIdentifier) != 0) {
+      position = 0;
+    } else if ((sample_type & kPerfSampleId) != 0) {
+      if ((sample_type & kPerfSampleIp) != 0)
+        ++position;
+      if ((sample_type & kPerfSampleTid) != 0)
+        ++position;
+      if ((sample_type & kPerfSampleTime) != 0)
+        ++position;
+      if ((sample_type & kPerfSampleAddr) != 0)
+        ++position;
+    } else {
+      return false;
+    }
+  } else {
+    if ((sample_type & kPerfSampleIdentifier) != 0) {
+      position = 1;
+    } else if ((sample_type & kPerfSampleId) != 0) {
+      position = 1;
+      if ((sample_type & kPerfSampleCpu) != 0)
+        ++position;
+      if ((sample_type & kPerfSampleStreamId) != 0)
+        ++position;
+    } else {
+      return false;
+    }
+    if (position * sizeof(uint64) > size)
+      return false;
+    Decoder decoder(data + size - position * sizeof(uint64), sizeof(uint64));
+    return decoder.DecodeRaw(id);
+  }
+
+  Decoder decoder(data, size);
+  return decoder.Skip(position * sizeof(uint64)) && decoder.DecodeRaw(id);
+}
+
+}  // namespace perf
+}  // namespace parser
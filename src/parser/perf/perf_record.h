@@ -0,0 +1,186 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Decodes the records of the data section of a perf.data file. A record
+// starts with a header:
+//
+//   <type:4> <misc:2> <size:2>
+//
+// The fields of a sample depend on the sample_type of its event, in this
+// order:
+//
+//   [identifier] [ip] [pid tid] [time] [addr] [id] [stream_id] [cpu res]
+//   [period] [read values] [nr ips[nr]] [raw_size raw[raw_size]] ...
+//
+// The other kernel records end with a "sample id" when the event has
+// sample_id_all set:
+//
+//   [pid tid] [time] [id] [stream_id] [cpu res] [identifier]
+//
+// Usage example:
+//   PerfSample sample;
+//   if (DecodePerfSample(attr.sample_type, attr.read_format, body, size,
+//                        &sample)) {
+//     UseCallchain(sample.callchain, sample.callchain_size);
+//   }
+
+#ifndef PARSER_PERF_PERF_RECORD_H_
+#define PARSER_PERF_PERF_RECORD_H_
+
+#include <cstddef>
+
+#include "base/base.h"
+
+namespace parser {
+namespace perf {
+
+#pragma pack(push, 1)
+struct PerfRecordHeader {
+  uint32 type;
+  uint16 misc;
+  uint16 size;
+};
+#pragma pack(pop)
+
+// The types of the records.
+// @{
+const uint32 kPerfRecordMmap = 1;
+const uint32 kPerfRecordLost = 2;
+const uint32 kPerfRecordComm = 3;
+const uint32 kPerfRecordExit = 4;
+const uint32 kPerfRecordFork = 7;
+const uint32 kPerfRecordSample = 9;
+const uint32 kPerfRecordMmap2 = 10;
+// The records synthesized by the perf tool have types from 64. The
+// auxiliary trace data follow their record.
+const uint32 kPerfRecordUserTypeStart = 64;
+const uint32 kPerfRecordAuxtrace = 71;
+// @}
+
+// The flags of the misc field of the header.
+// @{
+const uint16 kPerfRecordMiscCommExec = 1 << 13;
+const uint16 kPerfRecordMiscMmapBuildId = 1 << 14;
+// @}
+
+// The bits of the sample_type of an event.
+// @{
+const uint64 kPerfSampleIp = 1ULL << 0;
+const uint64 kPerfSampleTid = 1ULL << 1;
+const uint64 kPerfSampleTime = 1ULL << 2;
+const uint64 kPerfSampleAddr = 1ULL << 3;
+const uint64 kPerfSampleRead = 1ULL << 4;
+const uint64 kPerfSampleCallchain = 1ULL << 5;
+const uint64 kPerfSampleId = 1ULL << 6;
+const uint64 kPerfSampleCpu = 1ULL << 7;
+const uint64 kPerfSamplePeriod = 1ULL << 8;
+const uint64 kPerfSampleStreamId = 1ULL << 9;
+const uint64 kPerfSampleRaw = 1ULL << 10;
+const uint64 kPerfSampleIdentifier = 1ULL << 16;
+// @}
+
+// The bits of the read_format of an event.
+// @{
+const uint64 kPerfFormatTotalTimeEnabled = 1ULL << 0;
+const uint64 kPerfFormatTotalTimeRunning = 1ULL << 1;
+const uint64 kPerfFormatId = 1ULL << 2;
+const uint64 kPerfFormatGroup = 1ULL << 3;
+const uint64 kPerfFormatLost = 1ULL << 4;
+// @}
+
+// The fields of a sample, or of the sample id of a record. The fields that
+// are not in the sample_type are zero.
+struct PerfSample {
+  PerfSample();
+
+  uint64 ip;
+  uint32 pid;
+  uint32 tid;
+  uint64 time;
+  uint64 addr;
+  uint64 id;
+  uint64 stream_id;
+  uint32 cpu;
+  uint64 period;
+
+  // The instruction pointers of the callchain, within the record. They may
+  // be unaligned, and include the PERF_CONTEXT_* markers.
+  const char* callchain;
+  size_t callchain_size;
+
+  // The raw data of a tracepoint, within the record.
+  const char* raw;
+  size_t raw_size;
+};
+
+// @param sample_type the sample_type of an event.
+// @returns the size of the sample id at the end of the records, in bytes.
+size_t GetPerfSampleIdSize(uint64 sample_type);
+
+// Decodes a sample. The fields after the raw data are ignored.
+// @param sample_type the sample_type of the event of the sample.
+// @param read_format the read_format of the event of the sample.
+// @param data the body of the record, after its header.
+// @param size the size of the body, in bytes.
+// @param sample receives the fields of the sample.
+// @returns true on success, false if the record is too short.
+bool DecodePerfSample(uint64 sample_type,
+                      uint64 read_format,
+                      const char* data,
+                      size_t size,
+                      PerfSample* sample);
+
+// Decodes the sample id at the end of a record.
+// @param sample_type the sample_type of the event of the record.
+// @param data the body of the record, after its header.
+// @param size the size of the body, in bytes.
+// @param sample receives the fields of the sample id.
+// @returns true on success, false if the record is too short.
+bool DecodePerfSampleId(uint64 sample_type,
+                        const char* data,
+                        size_t size,
+                        PerfSample* sample);
+
+// Finds the identifier of the event of a record. All the events of a file
+// have their identifier at the same position, given by the sample_type of
+// the first event.
+// @param sample_type the sample_type of the first event of the file.
+// @param record_type the type of the record.
+// @param data the body of the record, after its header.
+// @param size the size of the body, in bytes.
+// @param id receives the identifier.
+// @returns true on success, false if the records have no identifier or if
+//     the record is too short.
+bool FindPerfEventId(uint64 sample_type,
+                     uint32 record_type,
+                     const char* data,
+                     size_t size,
+                     uint64* id);
+
+}  // namespace perf
+}  // namespace parser
+
+#endif  // PARSER_PERF_PERF_RECORD_H_
@@ -0,0 +1,200 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parser/perf/perf_record.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "parser/perf/perf_data_test_utils.h"
+
+namespace parser {
+namespace perf {
+
+namespace {
+
+const uint64 kAllFields =
+    kPerfSampleIp | kPerfSampleTid | kPerfSampleTime | kPerfSampleAddr |
+    kPerfSampleId | kPerfSampleStreamId | kPerfSampleCpu |
+    kPerfSamplePeriod | kPerfSampleCallchain | kPerfSampleRaw;
+
+PerfSample MakeSample() {
+  PerfSample sample;
+  sample.ip = 0xFFFFFFFF81000010ULL;
+  sample.pid = 12;
+  sample.tid = 34;
+  sample.time = 123456789;
+  sample.addr = 0x7F0000001000ULL;
+  sample.id = 77;
+  sample.stream_id = 78;
+  sample.cpu = 3;
+  sample.period = 100000;
+  return sample;
+}
+
+uint64 ReadUInt64(const char* bytes) {
+  uint64 value;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+TEST(PerfRecordTest, DecodePerfSample) {
+  std::vector<uint64> callchain;
+  callchain.push_back(0xFFFFFFFFFFFFFF80ULL);
+  callchain.push_back(0xFFFFFFFF81000010ULL);
+  std::string body = MakePerfSample(kAllFields, MakeSample(), callchain,
+                                    "raw");
+
+  PerfSample sample;
+  ASSERT_TRUE(DecodePerfSample(kAllFields, 0, body.data(), body.size(),
+                               &sample));
+  EXPECT_EQ(0xFFFFFFFF81000010ULL, sample.ip);
+  EXPECT_EQ(12U, sample.pid);
+  EXPECT_EQ(34U, sample.tid);
+  EXPECT_EQ(123456789U, sample.time);
+  EXPECT_EQ(0x7F0000001000ULL, sample.addr);
+  EXPECT_EQ(77U, sample.id);
+  EXPECT_EQ(78U, sample.stream_id);
+  EXPECT_EQ(3U, sample.cpu);
+  EXPECT_EQ(100000U, sample.period);
+  ASSERT_EQ(2U, sample.callchain_size);
+  EXPECT_EQ(callchain[0], ReadUInt64(sample.callchain));
+  EXPECT_EQ(callchain[1], ReadUInt64(sample.callchain + 8));
+  ASSERT_EQ(3U, sample.raw_size);
+  EXPECT_EQ("raw", std::string(sample.raw, sample.raw_size));
+
+  // The fields that are not sampled are zero.
+  const uint64 kSampleType = kPerfSampleTid | kPerfSamplePeriod;
+  body = MakePerfSample(kSampleType, MakeSample(), callchain, "");
+  ASSERT_TRUE(DecodePerfSample(kSampleType, 0, body.data(), body.size(),
+                               &sample));
+  EXPECT_EQ(0U, sample.ip);
+  EXPECT_EQ(12U, sample.pid);
+  EXPECT_EQ(0U, sample.time);
+  EXPECT_EQ(100000U, sample.period);
+  EXPECT_TRUE(sample.callchain == NULL);
+  EXPECT_TRUE(sample.raw == NULL);
+}
+
+TEST(PerfRecordTest, DecodePerfSampleTruncated) {
+  std::vector<uint64> callchain(4, 0x1000);
+  std::string body = MakePerfSample(kAllFields, MakeSample(), callchain,
+                                    "raw");
+
+  PerfSample sample;
+  for (size_t size = 0; size < body.size(); ++size) {
+    EXPECT_FALSE(DecodePerfSample(kAllFields, 0, body.data(), size,
+                                  &sample));
+  }
+}
+
+TEST(PerfRecordTest, DecodePerfSampleReadValues) {
+  const uint64 kSampleType = kPerfSampleRead | kPerfSampleCallchain;
+  const uint64 kReadFormat =
+      kPerfFormatGroup | kPerfFormatTotalTimeEnabled | kPerfFormatId;
+
+  // Two values with their identifiers, then a callchain.
+  const uint64 kBody[] = { 2, 1000, 10, 1, 20, 2, 1, 0x1234 };
+  PerfSample sample;
+  ASSERT_TRUE(DecodePerfSample(kSampleType, kReadFormat,
+                               reinterpret_cast<const char*>(kBody),
+                               sizeof(kBody), &sample));
+  ASSERT_EQ(1U, sample.callchain_size);
+  EXPECT_EQ(0x1234U, ReadUInt64(sample.callchain));
+
+  // A single value with its identifier.
+  ASSERT_TRUE(DecodePerfSample(kSampleType, kPerfFormatId,
+                               reinterpret_cast<const char*>(&kBody[4]),
+                               4 * sizeof(uint64), &sample));
+  ASSERT_EQ(1U, sample.callchain_size);
+  EXPECT_EQ(0x1234U, ReadUInt64(sample.callchain));
+}
+
+TEST(PerfRecordTest, DecodePerfSampleId) {
+  const uint64 kSampleType = kPerfSampleTid | kPerfSampleTime |
+                             kPerfSampleCpu | kPerfSampleIdentifier;
+  EXPECT_EQ(32U, GetPerfSampleIdSize(kSampleType));
+
+  std::string body = "record";
+  body.append(MakePerfSampleId(kSampleType, MakeSample()));
+
+  PerfSample sample;
+  ASSERT_TRUE(DecodePerfSampleId(kSampleType, body.data(), body.size(),
+                                 &sample));
+  EXPECT_EQ(12U, sample.pid);
+  EXPECT_EQ(34U, sample.tid);
+  EXPECT_EQ(123456789U, sample.time);
+  EXPECT_EQ(3U, sample.cpu);
+  EXPECT_EQ(77U, sample.id);
+
+  EXPECT_FALSE(DecodePerfSampleId(kSampleType, body.data(), 31, &sample));
+}
+
+TEST(PerfRecordTest, FindPerfEventId) {
+  PerfSample sample = MakeSample();
+  std::vector<uint64> callchain;
+  uint64 id = 0;
+
+  // The identifier of a sample is after ip, tid, time and addr.
+  const uint64 kSampleType = kPerfSampleIp | kPerfSampleTime |
+                             kPerfSampleId | kPerfSampleCpu;
+  std::string body = MakePerfSample(kSampleType, sample, callchain, "");
+  ASSERT_TRUE(FindPerfEventId(kSampleType, kPerfRecordSample, body.data(),
+                              body.size(), &id));
+  EXPECT_EQ(77U, id);
+
+  // The identifier of the other records is before cpu in the sample id.
+  body = "comm" + MakePerfSampleId(kSampleType, sample);
+  id = 0;
+  ASSERT_TRUE(FindPerfEventId(kSampleType, kPerfRecordComm, body.data(),
+                              body.size(), &id));
+  EXPECT_EQ(77U, id);
+
+  // With an identifier at fixed positions.
+  const uint64 kIdentifierType = kPerfSampleIp | kPerfSampleIdentifier;
+  body = MakePerfSample(kIdentifierType, sample, callchain, "");
+  id = 0;
+  ASSERT_TRUE(FindPerfEventId(kIdentifierType, kPerfRecordSample,
+                              body.data(), body.size(), &id));
+  EXPECT_EQ(77U, id);
+  body = "comm" + MakePerfSampleId(kIdentifierType, sample);
+  id = 0;
+  ASSERT_TRUE(FindPerfEventId(kIdentifierType, kPerfRecordComm,
+                              body.data(), body.size(), &id));
+  EXPECT_EQ(77U, id);
+
+  // Without identifier.
+  EXPECT_FALSE(FindPerfEventId(kPerfSampleIp, kPerfRecordSample,
+                               body.data(), body.size(), &id));
+  EXPECT_FALSE(FindPerfEventId(kSampleType, kPerfRecordSample,
+                               body.data(), 4, &id));
+}
+
+}  // namespace perf
+}  // namespace parser
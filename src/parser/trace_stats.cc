@@ -0,0 +1,249 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/trace_stats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <utility>
+
+namespace parser {
+
+namespace {
+
+// The initial number of slots of the process table. Must be a power of two.
+const size_t kInitialProcessSlots = 64;
+
+size_t HashProcessId(uint32 process_id) {
+  return static_cast<size_t>(process_id * 2654435761U);
+}
+
+template <typename Key>
+bool CompareByDecreasingCount(const std::pair<Key, uint64>& left,
+                              const std::pair<Key, uint64>& right) {
+  return left.second > right.second;
+}
+
+// Prints the rows of a count table, by decreasing count.
+template <typename Map>
+void PrintCounts(const Map& counts,
+                 const std::string& title,
+                 std::ostream* out) {
+  std::vector<std::pair<typename Map::key_type, uint64> > rows(
+      counts.begin(), counts.end());
+  std::stable_sort(rows.begin(), rows.end(),
+                   CompareByDecreasingCount<typename Map::key_type>);
+
+  *out << std::left << std::setw(12) << title
+       << std::right << std::setw(14) << "events" << std::endl;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    *out << std::left << std::setw(12) << rows[i].first
+         << std::right << std::setw(14) << rows[i].second << std::endl;
+  }
+}
+
+}  // namespace
+
+const size_t TraceStatsTable::kOpcodeCount;
+
+TraceStatsEventType::TraceStatsEventType(const std::string& provider_id,
+                                         unsigned char opcode)
+    : provider_id(provider_id),
+      opcode(opcode) {
+}
+
+bool TraceStatsEventType::operator<(const TraceStatsEventType& other) const {
+  if (provider_id != other.provider_id)
+    return provider_id < other.provider_id;
+  return opcode < other.opcode;
+}
+
+TraceStats::TraceStats()
+    : event_count(0),
+      payload_bytes(0),
+      first_timestamp(0),
+      last_timestamp(0),
+      has_lost_counts(false),
+      events_lost(0),
+      buffers_lost(0) {
+}
+
+void TraceStats::Add(const TraceStats& other) {
+  if (other.event_count != 0) {
+    if (event_count == 0 || other.first_timestamp < first_timestamp)
+      first_timestamp = other.first_timestamp;
+    if (event_count == 0 || other.last_timestamp > last_timestamp)
+      last_timestamp = other.last_timestamp;
+  }
+  event_count += other.event_count;
+  payload_bytes += other.payload_bytes;
+
+  EventTypeCounts::const_iterator type = other.events_per_type.begin();
+  for (; type != other.events_per_type.end(); ++type)
+    events_per_type[type->first] += type->second;
+  IdCounts::const_iterator id = other.events_per_process.begin();
+  for (; id != other.events_per_process.end(); ++id)
+    events_per_process[id->first] += id->second;
+  id = other.events_per_processor.begin();
+  for (; id != other.events_per_processor.end(); ++id)
+    events_per_processor[id->first] += id->second;
+
+  if (other.has_lost_counts) {
+    has_lost_counts = true;
+    events_lost += other.events_lost;
+    buffers_lost += other.buffers_lost;
+  }
+}
+
+TraceStatsTable::TraceStatsTable()
+    : process_ids_(kInitialProcessSlots, 0),
+      process_counts_(kInitialProcessSlots, 0),
+      process_count_(0),
+      event_count_(0),
+      payload_bytes_(0),
+      first_timestamp_(std::numeric_limits<uint64>::max()),
+      last_timestamp_(0),
+      has_lost_counts_(false),
+      events_lost_(0),
+      buffers_lost_(0) {
+}
+
+size_t TraceStatsTable::AddProvider(const std::string& provider_id) {
+  for (size_t i = 0; i < providers_.size(); ++i) {
+    if (providers_[i] == provider_id)
+      return i;
+  }
+  providers_.push_back(provider_id);
+  type_counts_.resize(providers_.size() * kOpcodeCount, 0);
+  return providers_.size() - 1;
+}
+
+void TraceStatsTable::RecordLosses(uint64 events_lost, uint64 buffers_lost) {
+  has_lost_counts_ = true;
+  events_lost_ += events_lost;
+  buffers_lost_ += buffers_lost;
+}
+
+void TraceStatsTable::MergeInto(TraceStats* stats) const {
+  DCHECK(stats != NULL);
+
+  TraceStats table;
+  table.event_count = event_count_;
+  table.payload_bytes = payload_bytes_;
+  table.first_timestamp = first_timestamp_;
+  table.last_timestamp = last_timestamp_;
+  table.has_lost_counts = has_lost_counts_;
+  table.events_lost = events_lost_;
+  table.buffers_lost = buffers_lost_;
+
+  for (size_t i = 0; i < type_counts_.size(); ++i) {
+    if (type_counts_[i] == 0)
+      continue;
+    TraceStatsEventType type(providers_[i / kOpcodeCount],
+                             static_cast<unsigned char>(i % kOpcodeCount));
+    table.events_per_type[type] = type_counts_[i];
+  }
+  for (size_t i = 0; i < process_ids_.size(); ++i) {
+    if (process_counts_[i] != 0)
+      table.events_per_process[process_ids_[i]] = process_counts_[i];
+  }
+  for (size_t i = 0; i < processor_counts_.size(); ++i) {
+    if (processor_counts_[i] != 0)
+      table.events_per_processor[static_cast<uint32>(i)] =
+          processor_counts_[i];
+  }
+
+  stats->Add(table);
+}
+
+uint64* TraceStatsTable::GetProcessCount(uint32 process_id) {
+  size_t mask = process_ids_.size() - 1;
+  size_t slot = HashProcessId(process_id) & mask;
+  while (process_counts_[slot] != 0) {
+    if (process_ids_[slot] == process_id)
+      return &process_counts_[slot];
+    slot = (slot + 1) & mask;
+  }
+
+  // Keep the table at most half full.
+  if (2 * (process_count_ + 1) > process_ids_.size()) {
+    GrowProcesses();
+    return GetProcessCount(process_id);
+  }
+  ++process_count_;
+  process_ids_[slot] = process_id;
+  return &process_counts_[slot];
+}
+
+void TraceStatsTable::GrowProcesses() {
+  std::vector<uint32> ids(2 * process_ids_.size(), 0);
+  std::vector<uint64> counts(2 * process_ids_.size(), 0);
+  size_t mask = ids.size() - 1;
+  for (size_t i = 0; i < process_ids_.size(); ++i) {
+    if (process_counts_[i] == 0)
+      continue;
+    size_t slot = HashProcessId(process_ids_[i]) & mask;
+    while (counts[slot] != 0)
+      slot = (slot + 1) & mask;
+    ids[slot] = process_ids_[i];
+    counts[slot] = process_counts_[i];
+  }
+  process_ids_.swap(ids);
+  process_counts_.swap(counts);
+}
+
+void PrintTraceStatsReport(const TraceStats& stats, std::ostream* out) {
+  DCHECK(out != NULL);
+
+  *out << "events: " << stats.event_count << std::endl
+       << "payload bytes: " << stats.payload_bytes << std::endl;
+  if (stats.event_count != 0) {
+    *out << "timestamps: " << stats.first_timestamp << " - "
+         << stats.last_timestamp << std::endl;
+  }
+  if (stats.has_lost_counts) {
+    *out << "events lost: " << stats.events_lost << std::endl
+         << "buffers lost: " << stats.buffers_lost << std::endl;
+  }
+
+  std::vector<std::pair<TraceStatsEventType, uint64> > types(
+      stats.events_per_type.begin(), stats.events_per_type.end());
+  std::stable_sort(types.begin(), types.end(),
+                   CompareByDecreasingCount<TraceStatsEventType>);
+  *out << std::left << std::setw(38) << "provider"
+       << std::right << std::setw(7) << "opcode"
+       << std::setw(14) << "events" << std::endl;
+  for (size_t i = 0; i < types.size(); ++i) {
+    *out << std::left << std::setw(38) << types[i].first.provider_id
+         << std::right << std::setw(7)
+         << static_cast<unsigned int>(types[i].first.opcode)
+         << std::setw(14) << types[i].second << std::endl;
+  }
+
+  PrintCounts(stats.events_per_process, "process", out);
+  PrintCounts(stats.events_per_processor, "processor", out);
+}
+
+}  // namespace parser
@@ -0,0 +1,181 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Statistics about the content of a trace, gathered from the event headers
+// only: the payloads are never decoded, so a trace is summarized at the speed
+// of the disk.
+//
+// Each thread walking a trace counts into its own TraceStatsTable, a set of
+// flat arrays indexed without hashing strings. The tables are merged into a
+// TraceStats at the end.
+//
+//   parser::TraceStats stats;
+//   if (parser.CollectStats(&stats))
+//     parser::PrintTraceStatsReport(stats, &std::cout);
+
+#ifndef PARSER_TRACE_STATS_H_
+#define PARSER_TRACE_STATS_H_
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "base/base.h"
+#include "base/logging.h"
+
+namespace parser {
+
+// Identifies a type of event by its provider and its opcode.
+struct TraceStatsEventType {
+  TraceStatsEventType(const std::string& provider_id, unsigned char opcode);
+
+  bool operator<(const TraceStatsEventType& other) const;
+
+  std::string provider_id;
+  unsigned char opcode;
+};
+
+// The merged statistics of traces.
+struct TraceStats {
+  typedef std::map<TraceStatsEventType, uint64> EventTypeCounts;
+  typedef std::map<uint32, uint64> IdCounts;
+
+  TraceStats();
+
+  // Accumulates the statistics of |other| into these statistics.
+  void Add(const TraceStats& other);
+
+  // The number of events, and of their payload bytes.
+  uint64 event_count;
+  uint64 payload_bytes;
+
+  // The range of the timestamps. Only meaningful when |event_count| is not
+  // zero.
+  uint64 first_timestamp;
+  uint64 last_timestamp;
+
+  // The number of events per type, process and processor.
+  EventTypeCounts events_per_type;
+  IdCounts events_per_process;
+  IdCounts events_per_processor;
+
+  // The losses reported by the traces, e.g. the EventsLost and BuffersLost
+  // fields of the EventTrace Header of an ETW trace. Only meaningful when
+  // |has_lost_counts| is true.
+  bool has_lost_counts;
+  uint64 events_lost;
+  uint64 buffers_lost;
+};
+
+// Counts the events seen by a thread.
+class TraceStatsTable {
+ public:
+  TraceStatsTable();
+
+  // Registers a provider. Callers cache the index while consecutive events
+  // come from the same provider.
+  // @param provider_id the identifier of the provider.
+  // @returns the index of the provider.
+  size_t AddProvider(const std::string& provider_id);
+
+  // Counts an event.
+  // @param provider the index of the provider, from AddProvider.
+  // @param opcode the opcode of the event.
+  // @param process_id the process of the event.
+  // @param processor_number the processor of the event.
+  // @param timestamp the timestamp of the event.
+  // @param payload_size the size of the payload, in bytes.
+  void Record(size_t provider,
+              unsigned char opcode,
+              uint32 process_id,
+              uint32 processor_number,
+              uint64 timestamp,
+              size_t payload_size) {
+    DCHECK_LT(provider, providers_.size());
+    ++type_counts_[provider * kOpcodeCount + opcode];
+    ++*GetProcessCount(process_id);
+    if (processor_number >= processor_counts_.size())
+      processor_counts_.resize(processor_number + 1, 0);
+    ++processor_counts_[processor_number];
+    if (timestamp < first_timestamp_)
+      first_timestamp_ = timestamp;
+    if (timestamp > last_timestamp_)
+      last_timestamp_ = timestamp;
+    ++event_count_;
+    payload_bytes_ += payload_size;
+  }
+
+  // Accumulates the losses reported by a trace.
+  // @param events_lost the number of events lost.
+  // @param buffers_lost the number of buffers lost.
+  void RecordLosses(uint64 events_lost, uint64 buffers_lost);
+
+  // Adds the counts of the table to merged statistics.
+  // @param stats the statistics receiving the counts.
+  void MergeInto(TraceStats* stats) const;
+
+ private:
+  static const size_t kOpcodeCount = 256;
+
+  // @returns the counter of a process, inserted if needed.
+  uint64* GetProcessCount(uint32 process_id);
+
+  // Doubles the capacity of the process table.
+  void GrowProcesses();
+
+  // The providers, and the counts per provider and opcode.
+  std::vector<std::string> providers_;
+  std::vector<uint64> type_counts_;
+
+  // An open-addressing table of the processes. A slot with a zero count is
+  // empty.
+  std::vector<uint32> process_ids_;
+  std::vector<uint64> process_counts_;
+  size_t process_count_;
+
+  std::vector<uint64> processor_counts_;
+
+  uint64 event_count_;
+  uint64 payload_bytes_;
+  uint64 first_timestamp_;
+  uint64 last_timestamp_;
+
+  bool has_lost_counts_;
+  uint64 events_lost_;
+  uint64 buffers_lost_;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceStatsTable);
+};
+
+// Writes a summary of the statistics: the time range, the losses, then the
+// counts per event type, process and processor, by decreasing count.
+// @param stats the statistics to print.
+// @param out the stream receiving the report.
+void PrintTraceStatsReport(const TraceStats& stats, std::ostream* out);
+
+}  // namespace parser
+
+#endif  // PARSER_TRACE_STATS_H_
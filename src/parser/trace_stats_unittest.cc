@@ -0,0 +1,138 @@
+// Copyright (c) 2014 The LibTrace Authors.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//   * Redistributions of source code must retain the above copyright
+//     notice, this list of conditions and the following disclaimer.
+//   * Redistributions in binary form must reproduce the above copyright
+//     notice, this list of conditions and the following disclaimer in the
+//     documentation and/or other materials provided with the distribution.
+//   * Neither the name of the <organization> nor the
+//     names of its contributors may be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "parser/trace_stats.h"
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+namespace parser {
+
+namespace {
+
+const char kThreadProviderId[] = "3D6FA8D1-FE05-11D0-9DDA-00C04FD7BA7C";
+const char kFileIOProviderId[] = "90CBDC39-4A3E-11D1-84F4-0000F80464E3";
+
+}  // namespace
+
+TEST(TraceStatsTest, EmptyTable) {
+  TraceStatsTable table;
+  TraceStats stats;
+  table.MergeInto(&stats);
+  EXPECT_EQ(0U, stats.event_count);
+  EXPECT_EQ(0U, stats.first_timestamp);
+  EXPECT_FALSE(stats.has_lost_counts);
+  EXPECT_TRUE(stats.events_per_type.empty());
+  EXPECT_TRUE(stats.events_per_process.empty());
+  EXPECT_TRUE(stats.events_per_processor.empty());
+}
+
+TEST(TraceStatsTest, Record) {
+  TraceStatsTable table;
+  size_t thread = table.AddProvider(kThreadProviderId);
+  size_t file = table.AddProvider(kFileIOProviderId);
+  EXPECT_NE(thread, file);
+  EXPECT_EQ(thread, table.AddProvider(kThreadProviderId));
+
+  table.Record(thread, 36, 4, 0, 200, 24);
+  table.Record(thread, 36, 4, 1, 100, 24);
+  table.Record(file, 64, 0xFFFFFFFF, 3, 300, 100);
+
+  TraceStats stats;
+  table.MergeInto(&stats);
+  EXPECT_EQ(3U, stats.event_count);
+  EXPECT_EQ(148U, stats.payload_bytes);
+  EXPECT_EQ(100U, stats.first_timestamp);
+  EXPECT_EQ(300U, stats.last_timestamp);
+
+  ASSERT_EQ(2U, stats.events_per_type.size());
+  EXPECT_EQ(2U, stats.events_per_type[TraceStatsEventType(kThreadProviderId,
+                                                          36)]);
+  EXPECT_EQ(1U, stats.events_per_type[TraceStatsEventType(kFileIOProviderId,
+                                                          64)]);
+  ASSERT_EQ(2U, stats.events_per_process.size());
+  EXPECT_EQ(2U, stats.events_per_process[4]);
+  EXPECT_EQ(1U, stats.events_per_process[0xFFFFFFFF]);
+  ASSERT_EQ(3U, stats.events_per_processor.size());
+  EXPECT_EQ(1U, stats.events_per_processor[3]);
+}
+
+TEST(TraceStatsTest, ManyProcesses) {
+  // The process table grows.
+  TraceStatsTable table;
+  size_t provider = table.AddProvider(kThreadProviderId);
+  for (uint32 i = 0; i < 10000; ++i)
+    table.Record(provider, 36, i % 1000 * 4, 0, i, 0);
+
+  TraceStats stats;
+  table.MergeInto(&stats);
+  ASSERT_EQ(1000U, stats.events_per_process.size());
+  for (uint32 i = 0; i < 1000; ++i)
+    EXPECT_EQ(10U, stats.events_per_process[i * 4]);
+}
+
+TEST(TraceStatsTest, Merge) {
+  TraceStatsTable first;
+  first.Record(first.AddProvider(kThreadProviderId), 36, 1, 0, 500, 8);
+  first.RecordLosses(3, 1);
+
+  TraceStatsTable second;
+  second.Record(second.AddProvider(kFileIOProviderId), 64, 1, 2, 700, 8);
+  second.Record(second.AddProvider(kThreadProviderId), 36, 2, 0, 50, 8);
+
+  TraceStats stats;
+  first.MergeInto(&stats);
+  second.MergeInto(&stats);
+  EXPECT_EQ(3U, stats.event_count);
+  EXPECT_EQ(50U, stats.first_timestamp);
+  EXPECT_EQ(700U, stats.last_timestamp);
+  EXPECT_TRUE(stats.has_lost_counts);
+  EXPECT_EQ(3U, stats.events_lost);
+  EXPECT_EQ(1U, stats.buffers_lost);
+  EXPECT_EQ(2U, stats.events_per_type[TraceStatsEventType(kThreadProviderId,
+                                                          36)]);
+  EXPECT_EQ(2U, stats.events_per_process[1]);
+  EXPECT_EQ(2U, stats.events_per_processor[0]);
+}
+
+TEST(TraceStatsTest, PrintReport) {
+  TraceStatsTable table;
+  size_t provider = table.AddProvider(kThreadProviderId);
+  table.Record(provider, 36, 4, 1, 100, 24);
+  table.Record(provider, 36, 4, 1, 200, 24);
+  table.RecordLosses(7, 0);
+  TraceStats stats;
+  table.MergeInto(&stats);
+
+  std::ostringstream out;
+  PrintTraceStatsReport(stats, &out);
+  std::string report = out.str();
+  EXPECT_NE(std::string::npos, report.find("events: 2\n"));
+  EXPECT_NE(std::string::npos, report.find("timestamps: 100 - 200\n"));
+  EXPECT_NE(std::string::npos, report.find("events lost: 7\n"));
+  EXPECT_NE(std::string::npos, report.find(kThreadProviderId));
+}
+
+}  // namespace parser